@@ -244,15 +244,14 @@ void FleetWrapper::PullSparseVarsSync(
   }
 }
 
-void FleetWrapper::PullSparseToTensorSync(const uint64_t table_id, int fea_dim,
-                                          uint64_t padding_id,
-                                          platform::Place place,
-                                          std::vector<const LoDTensor*>* inputs,
-                                          std::vector<LoDTensor*>* outputs) {
-  std::vector<uint64_t> fea_keys;
-  std::vector<float*> pull_result_ptr;
-  fea_keys.reserve(MAX_FEASIGN_NUM / 100);
-  pull_result_ptr.reserve(MAX_FEASIGN_NUM / 100);
+// Collect the keys of the ids in inputs, and the addresses in outputs their
+// values are pulled to. The values of padding_id are filled with zeros.
+static void CollectPullSparseKeys(int fea_dim, uint64_t padding_id,
+                                  platform::Place place,
+                                  std::vector<const LoDTensor*>* inputs,
+                                  std::vector<LoDTensor*>* outputs,
+                                  std::vector<uint64_t>* fea_keys,
+                                  std::vector<float*>* pull_result_ptr) {
   std::vector<float> init_value(fea_dim, 0);
   framework::LoDTensor* output = nullptr;
   float* output_data = nullptr;
@@ -279,10 +278,23 @@ void FleetWrapper::PullSparseToTensorSync(const uint64_t table_id, int fea_dim,
                sizeof(float) * fea_dim);
         continue;
       }
-      fea_keys.push_back(real_id);
-      pull_result_ptr.push_back(output_data + output_len);
+      fea_keys->push_back(real_id);
+      pull_result_ptr->push_back(output_data + output_len);
     }
   }
+}
+
+void FleetWrapper::PullSparseToTensorSync(const uint64_t table_id, int fea_dim,
+                                          uint64_t padding_id,
+                                          platform::Place place,
+                                          std::vector<const LoDTensor*>* inputs,
+                                          std::vector<LoDTensor*>* outputs) {
+  std::vector<uint64_t> fea_keys;
+  std::vector<float*> pull_result_ptr;
+  fea_keys.reserve(MAX_FEASIGN_NUM / 100);
+  pull_result_ptr.reserve(MAX_FEASIGN_NUM / 100);
+  CollectPullSparseKeys(fea_dim, padding_id, place, inputs, outputs, &fea_keys,
+                        &pull_result_ptr);
   auto* communicator = Communicator::GetInstance();
   auto status = communicator->_worker_ptr->pull_sparse(
       pull_result_ptr.data(), table_id, fea_keys.data(), fea_keys.size());
@@ -294,6 +306,36 @@ void FleetWrapper::PullSparseToTensorSync(const uint64_t table_id, int fea_dim,
   }
 }
 
+void FleetWrapper::PullSparseMultiTableToTensorSync(
+    const std::vector<uint64_t>& table_ids, const std::vector<int>& fea_dims,
+    const std::vector<uint64_t>& padding_ids, platform::Place place,
+    std::vector<std::vector<const LoDTensor*>>* inputs,
+    std::vector<std::vector<LoDTensor*>>* outputs) {
+  size_t table_num = table_ids.size();
+  CHECK(fea_dims.size() == table_num);     // NOLINT
+  CHECK(padding_ids.size() == table_num);  // NOLINT
+  CHECK(inputs->size() == table_num);      // NOLINT
+  CHECK(outputs->size() == table_num);     // NOLINT
+  std::vector<std::vector<uint64_t>> fea_keys(table_num);
+  std::vector<std::vector<float*>> pull_result_ptr(table_num);
+  std::vector<TableSparsePullValues> tables(table_num);
+  for (size_t t = 0; t < table_num; ++t) {
+    CollectPullSparseKeys(fea_dims[t], padding_ids[t], place, &inputs->at(t),
+                          &outputs->at(t), &fea_keys[t], &pull_result_ptr[t]);
+    tables[t] = {table_ids[t], fea_keys[t].data(), pull_result_ptr[t].data(),
+                 fea_keys[t].size()};
+  }
+  auto* communicator = Communicator::GetInstance();
+  auto status = communicator->_worker_ptr->pull_sparse_multi_table(tables);
+  status.wait();
+  auto ret = status.get();
+  if (ret != 0) {
+    LOG(ERROR) << "fleet pull sparse multi table failed, status[" << ret
+               << "]";
+    sleep(sleep_seconds_before_fail_exit_);
+  }
+}
+
 void FleetWrapper::PullDenseVarsAsync(
     const Scope& scope, const uint64_t tid,
     const std::vector<std::string>& var_names,
@@ -90,6 +90,17 @@ class FleetWrapper {
                               std::vector<const LoDTensor*>* inputs,  // NOLINT
                               std::vector<LoDTensor*>* outputs);      // NOLINT
 
+  // Pull sparse variables of several tables from server in sync mode, with a
+  // request per server for all the tables instead of one per table.
+  // The inputs and the outputs of the i-th table are inputs[i] and outputs[i]
+  // Param<in>: table_ids, fea_dims, padding_ids, place, inputs
+  // Param<out>: outputs
+  void PullSparseMultiTableToTensorSync(
+      const std::vector<uint64_t>& table_ids, const std::vector<int>& fea_dims,
+      const std::vector<uint64_t>& padding_ids, platform::Place place,
+      std::vector<std::vector<const LoDTensor*>>* inputs,  // NOLINT
+      std::vector<std::vector<LoDTensor*>>* outputs);      // NOLINT
+
   // pull dense variables from server in sync mod
   // Param<in>: scope, table_id, var_names
   // Param<out>: void
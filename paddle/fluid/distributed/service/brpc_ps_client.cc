@@ -21,6 +21,7 @@
 #include "paddle/fluid/distributed/service/brpc_ps_client.h"
 #include "paddle/fluid/distributed/table/table.h"
 #include "paddle/fluid/framework/archive.h"
+#include "paddle/fluid/platform/float16.h"
 
 const static int max_port = 65535;
 
@@ -395,6 +396,11 @@ std::future<int32_t> BrpcPsClient::barrier(size_t table_id,
   return send_cmd(table_id, PS_BARRIER, {std::to_string(barrier_type)});
 }
 
+std::future<int32_t> BrpcPsClient::push_clock(size_t table_id,
+                                              int32_t steps) {
+  return send_cmd(table_id, PS_PUSH_CLOCK, {std::to_string(steps)});
+}
+
 std::future<int32_t> BrpcPsClient::pull_geo_param(size_t table_id,
                                                   std::vector<float> *values,
                                                   std::vector<uint64_t> *keys,
@@ -685,9 +691,97 @@ std::future<int32_t> BrpcPsClient::push_sparse_raw_gradient(
   return fut;
 }
 
+std::future<int32_t> BrpcPsClient::push_sparse_multi_table(
+    const std::vector<TableSparseValues> &tables, void *done) {
+  DownpourBrpcClosure *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
+  auto promise = std::make_shared<std::promise<int32_t>>();
+  closure->add_promise(promise);
+  std::future<int> fut = promise->get_future();
+
+  size_t request_call_num = _server_channels.size();
+  if (tables.empty()) {
+    // Nothing to push, finish the requests of the closure.
+    for (size_t i = 0; i < request_call_num; ++i) {
+      closure->Run();
+    }
+    return fut;
+  }
+  size_t table_num = tables.size();
+  std::vector<std::vector<std::vector<uint64_t>>> ids(
+      request_call_num, std::vector<std::vector<uint64_t>>(table_num));
+  std::vector<std::vector<std::vector<const float *>>> value_ptrs(
+      request_call_num, std::vector<std::vector<const float *>>(table_num));
+  std::vector<size_t> value_sizes(table_num);
+  for (size_t t = 0; t < table_num; ++t) {
+    auto &table = tables[t];
+    value_sizes[t] = table_accessor(table.table_id)->update_size();
+    for (size_t i = 0; i < table.num; ++i) {
+      size_t pserver_idx = table.keys[i] % request_call_num;
+      ids[pserver_idx][t].push_back(table.keys[i]);
+      value_ptrs[pserver_idx][t].push_back(table.values[i]);
+    }
+  }
+
+  for (size_t shard_idx = 0; shard_idx < request_call_num; ++shard_idx) {
+    auto *push_request = closure->request(shard_idx);
+    push_request->set_cmd_id(PS_PUSH_SPARSE_MULTI_TABLE);
+    push_request->set_table_id(tables[0].table_id);
+    push_request->set_client_id(_client_id);
+    size_t data_size = 0;
+    for (size_t t = 0; t < table_num; ++t) {
+      uint32_t table_id = tables[t].table_id;
+      uint32_t kv_size = ids[shard_idx][t].size();
+      push_request->add_params((char *)&table_id, sizeof(uint32_t));
+      push_request->add_params((char *)&kv_size, sizeof(uint32_t));
+      data_size += kv_size * (sizeof(uint64_t) + value_sizes[t]);
+    }
+
+    // The keys and the values of the tables follow each other.
+    auto *push_data = push_request->mutable_data();
+    push_data->resize(data_size);
+    char *push_data_ptr = const_cast<char *>(push_data->data());
+    for (size_t t = 0; t < table_num; ++t) {
+      auto &kvs = ids[shard_idx][t];
+      auto &value_ptr = value_ptrs[shard_idx][t];
+      memcpy(push_data_ptr, kvs.data(), kvs.size() * sizeof(uint64_t));
+      push_data_ptr += kvs.size() * sizeof(uint64_t);
+      for (size_t i = 0; i < kvs.size(); ++i) {
+        memcpy(push_data_ptr, value_ptr[i], value_sizes[t]);
+        push_data_ptr += value_sizes[t];
+      }
+    }
+    PsService_Stub rpc_stub(get_sparse_channel(shard_idx));
+    closure->cntl(shard_idx)->set_request_compress_type(
+        (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
+    rpc_stub.service(closure->cntl(shard_idx), push_request,
+                     closure->response(shard_idx), closure);
+  }
+  return fut;
+}
+
+// The bytes of a pushed value in the encoding of value_type.
+static size_t value_bytes(PsValueType value_type) {
+  return value_type == PS_VALUE_FP16 ? sizeof(uint16_t) : sizeof(float);
+}
+
+// Write num values to buffer in the encoding of value_type, and return the
+// end of them.
+static char *encode_values(const float *values, size_t num,
+                           PsValueType value_type, char *buffer) {
+  if (value_type == PS_VALUE_FP16) {
+    for (size_t i = 0; i < num; ++i) {
+      platform::float16 value(values[i]);
+      memcpy(buffer + i * sizeof(uint16_t), &value.x, sizeof(uint16_t));
+    }
+  } else {
+    memcpy(buffer, values, num * sizeof(float));
+  }
+  return buffer + num * value_bytes(value_type);
+}
+
 std::future<int32_t> BrpcPsClient::push_dense_raw_gradient(
     int table_id, float *total_send_data, size_t total_send_data_size,
-    void *done) {
+    void *done, PsValueType value_type) {
   size_t request_call_num = _server_channels.size();
   DownpourBrpcClosure *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
   auto promise = std::make_shared<std::promise<int32_t>>();
@@ -696,17 +790,20 @@ std::future<int32_t> BrpcPsClient::push_dense_raw_gradient(
   auto *accessor = table_accessor(table_id);
   uint32_t num_per_shard =
       dense_dim_per_shard(accessor->fea_dim(), request_call_num);
+  uint32_t value_type_id = value_type;
   for (size_t i = 0; i < request_call_num; ++i) {
     closure->request(i)->set_cmd_id(PS_PUSH_DENSE_TABLE);
     closure->request(i)->set_table_id(table_id);
     closure->request(i)->set_client_id(_client_id);
+    closure->request(i)->add_params((char *)&value_type_id, sizeof(uint32_t));
     auto *push_data = closure->request(i)->mutable_data();
     push_data->clear();
-    push_data->resize(sizeof(uint32_t) + num_per_shard * sizeof(float));
+    push_data->resize(sizeof(uint32_t) +
+                      num_per_shard * value_bytes(value_type));
     char *push_data_ptr = const_cast<char *>(push_data->data());
     memcpy(push_data_ptr, &num_per_shard, sizeof(uint32_t));
-    memcpy(push_data_ptr + sizeof(uint32_t),
-           total_send_data + i * num_per_shard, num_per_shard * sizeof(float));
+    encode_values(total_send_data + i * num_per_shard, num_per_shard,
+                  value_type, push_data_ptr + sizeof(uint32_t));
     VLOG(1) << "push_dense_raw_gradient finish memcpy";
     // closure->cntl(i)->set_request_compress_type(
     //     (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
@@ -719,6 +816,58 @@ std::future<int32_t> BrpcPsClient::push_dense_raw_gradient(
   return fut;
 }
 
+// Sort the kvs by the keys, and append the unique keys to buffer. Return the
+// number of the unique keys.
+static uint32_t append_sorted_keys(
+    std::vector<std::pair<uint64_t, float *>> *sorted_kvs,
+    butil::IOBuf *buffer) {
+  std::sort(sorted_kvs->begin(), sorted_kvs->end(),
+            [](const std::pair<uint64_t, float *> &k1,
+               const std::pair<uint64_t, float *> &k2) {
+              return k1.first < k2.first;
+            });
+
+  uint64_t last_key = UINT64_MAX;
+  uint32_t kv_request_count = 0;
+  size_t sorted_kv_size = sorted_kvs->size();
+  for (size_t kv_idx = 0; kv_idx < sorted_kv_size; ++kv_idx) {
+    ++kv_request_count;
+    last_key = (*sorted_kvs)[kv_idx].first;
+    buffer->append((void *)&last_key, sizeof(uint64_t));
+    while (kv_idx < sorted_kv_size - 1 &&
+           last_key == (*sorted_kvs)[kv_idx + 1].first) {
+      ++kv_idx;
+    }
+  }
+  return kv_request_count;
+}
+
+// Copy the values of the unique keys of sorted_kvs from the response to the
+// values of all the keys.
+static int32_t copy_sparse_values(
+    const std::vector<std::pair<uint64_t, float *>> &sorted_kvs,
+    size_t value_size, butil::IOBufBytesIterator *io_buffer_itr) {
+  uint64_t last_key = UINT64_MAX;
+  float *last_value_data = NULL;
+
+  for (size_t kv_idx = 0; kv_idx < sorted_kvs.size(); ++kv_idx) {
+    auto *kv_pair = &(sorted_kvs[kv_idx]);
+    if (kv_pair->first == last_key) {
+      memcpy((void *)kv_pair->second, (void *)last_value_data, value_size);
+    } else {
+      last_key = kv_pair->first;
+      last_value_data = kv_pair->second;
+      if (value_size !=
+          io_buffer_itr->copy_and_forward((void *)(last_value_data),
+                                          value_size)) {
+        LOG(WARNING) << "res data is lack or not in format";
+        return -1;
+      }
+    }
+  }
+  return 0;
+}
+
 std::future<int32_t> BrpcPsClient::pull_sparse(float **select_values,
                                                size_t table_id,
                                                const uint64_t *keys,
@@ -747,28 +896,12 @@ std::future<int32_t> BrpcPsClient::pull_sparse(float **select_values,
             break;
           }
 
-          auto &request_kvs = shard_sorted_kvs->at(i);
           auto &res_io_buffer = closure->cntl(i)->response_attachment();
           butil::IOBufBytesIterator io_buffer_itr(res_io_buffer);
-          uint64_t last_key = UINT64_MAX;
-          float *last_value_data = NULL;
-
-          for (size_t kv_idx = 0; kv_idx < request_kvs.size(); ++kv_idx) {
-            auto *kv_pair = &(request_kvs[kv_idx]);
-            if (kv_pair->first == last_key) {
-              memcpy((void *)kv_pair->second, (void *)last_value_data,
-                     value_size);
-            } else {
-              last_key = kv_pair->first;
-              last_value_data = kv_pair->second;
-              if (value_size !=
-                  io_buffer_itr.copy_and_forward((void *)(last_value_data),
-                                                 value_size)) {
-                LOG(WARNING) << "res data is lack or not in format";
-                ret = -1;
-                break;
-              }
-            }
+          if (copy_sparse_values(shard_sorted_kvs->at(i), value_size,
+                                 &io_buffer_itr) != 0) {
+            ret = -1;
+            break;
           }
         }
         closure->set_promise_value(ret);
@@ -779,26 +912,8 @@ std::future<int32_t> BrpcPsClient::pull_sparse(float **select_values,
   std::future<int> fut = promise->get_future();
 
   for (size_t i = 0; i < request_call_num; ++i) {
-    auto &sorted_kvs = shard_sorted_kvs->at(i);
-    std::sort(sorted_kvs.begin(), sorted_kvs.end(),
-              [](const std::pair<uint64_t, float *> &k1,
-                 const std::pair<uint64_t, float *> &k2) {
-                return k1.first < k2.first;
-              });
-
-    uint64_t last_key = UINT64_MAX;
-    uint32_t kv_request_count = 0;
-    size_t sorted_kv_size = sorted_kvs.size();
-    auto &request_buffer = closure->cntl(i)->request_attachment();
-    for (size_t kv_idx = 0; kv_idx < sorted_kv_size; ++kv_idx) {
-      ++kv_request_count;
-      last_key = sorted_kvs[kv_idx].first;
-      request_buffer.append((void *)&last_key, sizeof(uint64_t));
-      while (kv_idx < sorted_kv_size - 1 &&
-             last_key == sorted_kvs[kv_idx + 1].first) {
-        ++kv_idx;
-      }
-    }
+    uint32_t kv_request_count = append_sorted_keys(
+        &shard_sorted_kvs->at(i), &closure->cntl(i)->request_attachment());
 
     if (kv_request_count == 0) {
       closure->Run();
@@ -817,6 +932,86 @@ std::future<int32_t> BrpcPsClient::pull_sparse(float **select_values,
   return fut;
 }
 
+std::future<int32_t> BrpcPsClient::pull_sparse_multi_table(
+    const std::vector<TableSparsePullValues> &tables) {
+  size_t request_call_num = _server_channels.size();
+  size_t table_num = tables.size();
+
+  // The kvs of each table on each server.
+  auto shard_sorted_kvs = std::make_shared<
+      std::vector<std::vector<std::vector<std::pair<uint64_t, float *>>>>>(
+      request_call_num,
+      std::vector<std::vector<std::pair<uint64_t, float *>>>(table_num));
+  auto value_sizes = std::make_shared<std::vector<size_t>>(table_num);
+  for (size_t t = 0; t < table_num; ++t) {
+    auto &table = tables[t];
+    (*value_sizes)[t] = table_accessor(table.table_id)->select_size();
+    for (size_t i = 0; i < table.num; ++i) {
+      size_t shard_id = table.keys[i] % request_call_num;
+      (*shard_sorted_kvs)[shard_id][t].push_back(
+          {table.keys[i], table.values[i]});
+    }
+  }
+
+  DownpourBrpcClosure *closure = new DownpourBrpcClosure(
+      request_call_num, [shard_sorted_kvs, value_sizes](void *done) {
+        int ret = 0;
+        auto *closure = (DownpourBrpcClosure *)done;
+        for (size_t i = 0; i < shard_sorted_kvs->size() && ret == 0; ++i) {
+          if (closure->check_response(i, PS_PULL_SPARSE_MULTI_TABLE) != 0) {
+            ret = -1;
+            break;
+          }
+          // The values of the tables follow each other in the response.
+          auto &res_io_buffer = closure->cntl(i)->response_attachment();
+          butil::IOBufBytesIterator io_buffer_itr(res_io_buffer);
+          auto &table_kvs = shard_sorted_kvs->at(i);
+          for (size_t t = 0; t < table_kvs.size(); ++t) {
+            if (copy_sparse_values(table_kvs[t], value_sizes->at(t),
+                                   &io_buffer_itr) != 0) {
+              ret = -1;
+              break;
+            }
+          }
+        }
+        closure->set_promise_value(ret);
+      });
+
+  auto promise = std::make_shared<std::promise<int32_t>>();
+  closure->add_promise(promise);
+  std::future<int> fut = promise->get_future();
+
+  for (size_t i = 0; i < request_call_num; ++i) {
+    auto *request = closure->request(i);
+    auto &request_buffer = closure->cntl(i)->request_attachment();
+    uint32_t kv_request_count = 0;
+    for (size_t t = 0; t < table_num; ++t) {
+      auto &sorted_kvs = shard_sorted_kvs->at(i)[t];
+      if (sorted_kvs.empty()) {
+        continue;
+      }
+      uint32_t table_id = tables[t].table_id;
+      uint32_t count = append_sorted_keys(&sorted_kvs, &request_buffer);
+      request->add_params((char *)&table_id, sizeof(uint32_t));
+      request->add_params((char *)&count, sizeof(uint32_t));
+      kv_request_count += count;
+    }
+
+    if (kv_request_count == 0) {
+      closure->Run();
+    } else {
+      request->set_cmd_id(PS_PULL_SPARSE_MULTI_TABLE);
+      request->set_table_id(tables[0].table_id);
+      request->set_client_id(_client_id);
+      PsService_Stub rpc_stub(get_cmd_channel(i));
+      closure->cntl(i)->set_log_id(butil::gettimeofday_ms());
+      rpc_stub.service(closure->cntl(i), request, closure->response(i),
+                       closure);
+    }
+  }
+  return fut;
+}
+
 std::future<int32_t> BrpcPsClient::send_client2client_msg(
     int msg_type, int to_client_id, const std::string &msg) {
   auto promise = std::make_shared<std::promise<int32_t>>();
@@ -844,9 +1039,9 @@ std::future<int32_t> BrpcPsClient::send_client2client_msg(
 
 std::future<int32_t> BrpcPsClient::push_sparse_raw_gradient_partial(
     size_t table_id, const uint64_t *keys, const float **update_values,
-    uint32_t num, void *done, int pserver_idx) {
+    uint32_t num, void *done, int pserver_idx, PsValueType value_type) {
   auto *accessor = table_accessor(table_id);
-  size_t value_size = accessor->update_size();
+  size_t value_dim = accessor->update_size() / sizeof(float);
   DownpourBrpcClosure *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
   auto promise = std::make_shared<std::promise<int32_t>>();
   closure->add_promise(promise);
@@ -858,14 +1053,17 @@ std::future<int32_t> BrpcPsClient::push_sparse_raw_gradient_partial(
   push_request->set_table_id(table_id);
   push_request->set_client_id(_client_id);
   push_request->add_params((char *)&num, sizeof(uint32_t));
+  uint32_t value_type_id = value_type;
+  push_request->add_params((char *)&value_type_id, sizeof(uint32_t));
   auto *push_data = push_request->mutable_data();
-  push_data->resize(num * (sizeof(uint64_t) + value_size));
+  push_data->resize(num *
+                    (sizeof(uint64_t) + value_dim * value_bytes(value_type)));
   char *push_data_ptr = const_cast<char *>(push_data->data());
   memcpy(push_data_ptr, keys, num * sizeof(uint64_t));
   push_data_ptr += num * sizeof(uint64_t);
   for (int i = 0; i < num; ++i) {
-    memcpy(push_data_ptr, update_values[i], value_size);
-    push_data_ptr += value_size;
+    push_data_ptr =
+        encode_values(update_values[i], value_dim, value_type, push_data_ptr);
   }
   PsService_Stub rpc_stub(get_sparse_channel(pserver_idx));
   closure->cntl(0)->set_request_compress_type(
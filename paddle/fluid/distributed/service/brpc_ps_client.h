@@ -132,10 +132,15 @@ class BrpcPsClient : public PSClient {
                                            size_t table_id,
                                            const uint64_t *keys, size_t num);
 
+  virtual std::future<int32_t> pull_sparse_multi_table(
+      const std::vector<TableSparsePullValues> &tables) override;
+
   virtual std::future<int32_t> print_table_stat(uint32_t table_id);
 
   virtual std::future<int32_t> barrier(size_t table_id, uint32_t barrier_type);
 
+  virtual std::future<int32_t> push_clock(size_t table_id, int32_t steps);
+
   virtual std::future<int32_t> pull_geo_param(size_t table_id,
                                               std::vector<float> *values,
                                               std::vector<uint64_t> *keys,
@@ -180,7 +185,7 @@ class BrpcPsClient : public PSClient {
       _server_channels;  // client2server
   virtual std::future<int32_t> push_dense_raw_gradient(
       int table_id, float *total_send_data, size_t total_send_data_size,
-      void *done) override;
+      void *done, PsValueType value_type = PS_VALUE_FP32) override;
 
   virtual std::future<int32_t> push_sparse_raw_gradient(
       size_t table_id, const uint64_t *keys, const float **update_values,
@@ -188,7 +193,8 @@ class BrpcPsClient : public PSClient {
 
   virtual std::future<int32_t> push_sparse_raw_gradient_partial(
       size_t table_id, const uint64_t *keys, const float **update_values,
-      uint32_t num, void *done, int pserver_idx) override;
+      uint32_t num, void *done, int pserver_idx,
+      PsValueType value_type = PS_VALUE_FP32) override;
 
   virtual std::future<int32_t> push_sparse_param(size_t table_id,
                                                  const uint64_t *keys,
@@ -196,6 +202,9 @@ class BrpcPsClient : public PSClient {
                                                  size_t num,
                                                  void *done) override;
 
+  virtual std::future<int32_t> push_sparse_multi_table(
+      const std::vector<TableSparseValues> &tables, void *done) override;
+
   virtual size_t get_server_nums() { return _server_channels.size(); }
 
  private:
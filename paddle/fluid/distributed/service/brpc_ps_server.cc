@@ -13,14 +13,23 @@
 // limitations under the License.
 
 #include "paddle/fluid/distributed/service/brpc_ps_server.h"
+#include <algorithm>
 #include <thread>  // NOLINT
 #include "Eigen/Dense"
 #include "butil/endpoint.h"
 #include "iomanip"
 #include "paddle/fluid/distributed/table/table.h"
 #include "paddle/fluid/framework/archive.h"
+#include "paddle/fluid/platform/float16.h"
 #include "paddle/fluid/platform/profiler.h"
 
+DEFINE_bool(pserver_coalesce_pull_sparse, false,
+            "merge the concurrent pull_sparse requests of a table on the "
+            "server into a single pull");
+DEFINE_int32(pserver_pull_sparse_coalesce_window_us, 0,
+             "the time to wait for more pull_sparse requests to merge, 0 to "
+             "merge only the requests arriving during the previous pull");
+
 namespace paddle {
 namespace distributed {
 
@@ -98,8 +107,21 @@ int32_t PsService::initialize() {
   _service_handler_map[PS_PULL_GEO_PARAM] = &PsService::pull_geo_param;
   _service_handler_map[PS_PUSH_SPARSE_PARAM] = &PsService::push_sparse_param;
   _service_handler_map[PS_BARRIER] = &PsService::barrier;
+  _service_handler_map[PS_PUSH_CLOCK] = &PsService::push_clock;
   _service_handler_map[PS_START_PROFILER] = &PsService::start_profiler;
   _service_handler_map[PS_STOP_PROFILER] = &PsService::stop_profiler;
+  _service_handler_map[PS_PULL_SPARSE_MULTI_TABLE] =
+      &PsService::pull_sparse_multi_table;
+  _service_handler_map[PS_PUSH_SPARSE_MULTI_TABLE] =
+      &PsService::push_sparse_multi_table;
+  _table_task_pool.reset(
+      new ::ThreadPool(std::max(1u, std::thread::hardware_concurrency())));
+  if (FLAGS_pserver_coalesce_pull_sparse) {
+    for (auto &itr : *(_server->table())) {
+      _pull_coalescers[itr.first].reset(new SparsePullCoalescer(
+          itr.second.get(), FLAGS_pserver_pull_sparse_coalesce_window_us));
+    }
+  }
 
   // shard初始化,server启动后才可从env获取到server_list的shard信息
   initialize_shard_info();
@@ -182,6 +204,7 @@ int32_t PsService::pull_dense(Table *table, const PsRequestMessage &request,
 
   std::vector<float> res_data;
   res_data.resize(num * table->value_accesor()->select_size() / sizeof(float));
+  table->wait_clock(request.client_id());
   table->pull_dense(res_data.data(), num);
 
   cntl->response_attachment().append((char *)res_data.data(),
@@ -217,6 +240,52 @@ int32_t PsService::push_dense_param(Table *table,
   return 0;
 }
 
+// Read the uint32 in params(index) of the request into value. Return false if
+// the param is not of 4 bytes.
+static bool read_uint32_param(const PsRequestMessage &request, int index,
+                              uint32_t *value) {
+  auto &param = request.params(index);
+  if (param.size() != sizeof(uint32_t)) {
+    return false;
+  }
+  memcpy(value, param.data(), sizeof(uint32_t));
+  return true;
+}
+
+// Read the encoding of the pushed values in params(index) of the request into
+// value_type, FP32 if it is absent. Return false if the param is malformed.
+static bool push_value_type(const PsRequestMessage &request, int index,
+                            PsValueType *value_type) {
+  *value_type = PS_VALUE_FP32;
+  if (request.params_size() <= index) {
+    return true;
+  }
+  uint32_t type = 0;
+  if (!read_uint32_param(request, index, &type) ||
+      !PsValueType_IsValid(static_cast<int>(type))) {
+    return false;
+  }
+  *value_type = static_cast<PsValueType>(type);
+  return true;
+}
+
+// The num pushed values at data in FP32. The values of FP16 are decoded into
+// buffer, and the values of FP32 are used in place.
+static const float *decode_values(const char *data, size_t num,
+                                  PsValueType value_type,
+                                  std::vector<float> *buffer) {
+  if (value_type != PS_VALUE_FP16) {
+    return (const float *)data;
+  }
+  buffer->resize(num);
+  for (size_t i = 0; i < num; ++i) {
+    platform::float16 value;
+    memcpy(&value.x, data + i * sizeof(uint16_t), sizeof(uint16_t));
+    (*buffer)[i] = static_cast<float>(value);
+  }
+  return buffer->data();
+}
+
 int32_t PsService::push_dense(Table *table, const PsRequestMessage &request,
                               PsResponseMessage &response,
                               brpc::Controller *cntl) {
@@ -234,8 +303,16 @@ int32_t PsService::push_dense(Table *table, const PsRequestMessage &request,
   |--4B---|----------------|
   */
   uint32_t num = *(const uint32_t *)(request.data().data());
+  PsValueType value_type;
+  if (!push_value_type(request, 0, &value_type)) {
+    set_response_code(response, -1,
+                      "PsRequestMessage.params(0) is not a PsValueType");
+    return 0;
+  }
+  std::vector<float> decoded;
   const float *values =
-      (const float *)(request.data().data() + sizeof(uint32_t));
+      decode_values(request.data().data() + sizeof(uint32_t), num,
+                    value_type, &decoded);
   if (table->push_dense(values, num) != 0) {
     set_response_code(response, -1, "push_dense failed");
   }
@@ -261,6 +338,24 @@ int32_t PsService::barrier(Table *table, const PsRequestMessage &request,
   return 0;
 }
 
+int32_t PsService::push_clock(Table *table, const PsRequestMessage &request,
+                              PsResponseMessage &response,
+                              brpc::Controller *cntl) {
+  CHECK_TABLE_EXIST(table, request, response)
+
+  if (request.params_size() < 1) {
+    set_response_code(response, -1,
+                      "PsRequestMessage.params is requeired at "
+                      "least 1 for steps of clock");
+    return 0;
+  }
+
+  auto trainer_id = request.client_id();
+  auto steps = std::stoi(request.params(0));
+  table->push_clock(trainer_id, steps);
+  return 0;
+}
+
 int32_t PsService::push_sparse_param(Table *table,
                                      const PsRequestMessage &request,
                                      PsResponseMessage &response,
@@ -346,12 +441,194 @@ int32_t PsService::pull_sparse(Table *table, const PsRequestMessage &request,
   const uint64_t *keys = (const uint64_t *)data;
   std::vector<float> res_data;
   res_data.resize(num * table->value_accesor()->select_size() / sizeof(float));
-  table->pull_sparse(res_data.data(), keys, num);
+  table->wait_clock(request.client_id());
+  pull_sparse_from_table(request.table_id(), table, res_data.data(), keys, num);
   cntl->response_attachment().append((char *)res_data.data(),
                                      res_data.size() * sizeof(float));
   return 0;
 }
 
+int32_t PsService::pull_sparse_from_table(uint32_t table_id, Table *table,
+                                          float *values, const uint64_t *keys,
+                                          size_t num) {
+  auto itr = _pull_coalescers.find(table_id);
+  if (itr == _pull_coalescers.end()) {
+    return table->pull_sparse(values, keys, num);
+  }
+  return itr->second->pull_sparse(values, keys, num);
+}
+
+// The tables and the numbers of the keys of the multi-table request in the
+// params, i.e. |---table_id---|---num---| for each table.
+static bool parse_multi_table_params(
+    const PsRequestMessage &request,
+    std::vector<std::pair<uint32_t, uint32_t>> *table_nums) {
+  if (request.params_size() % 2 != 0) {
+    return false;
+  }
+  for (int i = 0; i < request.params_size(); i += 2) {
+    uint32_t table_id = 0;
+    uint32_t num = 0;
+    if (!read_uint32_param(request, i, &table_id) ||
+        !read_uint32_param(request, i + 1, &num)) {
+      return false;
+    }
+    table_nums->emplace_back(table_id, num);
+  }
+  return true;
+}
+
+int32_t PsService::pull_sparse_multi_table(Table *table,
+                                           const PsRequestMessage &request,
+                                           PsResponseMessage &response,
+                                           brpc::Controller *cntl) {
+  platform::RecordEvent record_event("PsService->pull_sparse_multi_table");
+  std::vector<std::pair<uint32_t, uint32_t>> table_nums;
+  if (!parse_multi_table_params(request, &table_nums)) {
+    set_response_code(response, -1,
+                      "PsRequestMessage.params should be pairs of "
+                      "table_id and num of sparse_key");
+    return 0;
+  }
+  std::vector<Table *> tables(table_nums.size());
+  size_t key_num = 0;
+  for (size_t i = 0; i < table_nums.size(); ++i) {
+    tables[i] = _server->table(table_nums[i].first);
+    if (tables[i] == NULL) {
+      std::string err_msg("table not found with table_id:");
+      err_msg.append(std::to_string(table_nums[i].first));
+      set_response_code(response, -1, err_msg.c_str());
+      return 0;
+    }
+    key_num += table_nums[i].second;
+  }
+  for (auto *table : tables) {
+    table->wait_clock(request.client_id());
+  }
+  /*
+  Attachment Content:
+  |---keysData of table 0---|---keysData of table 1---|...
+  |---8*{num 0}B------------|---8*{num 1}B------------|...
+  */
+  std::string keys_buffer;
+  keys_buffer.resize(key_num * sizeof(uint64_t));
+  if (cntl->request_attachment().copy_to(&keys_buffer[0], keys_buffer.size()) !=
+      keys_buffer.size()) {
+    set_response_code(response, -1, "req attachment is lack of keys");
+    return 0;
+  }
+  const uint64_t *keys = (const uint64_t *)keys_buffer.data();
+
+  // The tables are pulled in parallel, and their values follow each other in
+  // the response in the order of the params.
+  std::vector<std::vector<float>> res_data(tables.size());
+  std::vector<std::future<int32_t>> tasks;
+  tasks.reserve(tables.size());
+  for (size_t i = 0; i < tables.size(); ++i) {
+    uint32_t num = table_nums[i].second;
+    uint32_t table_id = table_nums[i].first;
+    tasks.push_back(_table_task_pool->enqueue(
+        [this, &tables, &res_data, i, table_id, keys, num]() -> int32_t {
+          auto *table = tables[i];
+          res_data[i].resize(num * table->value_accesor()->select_size() /
+                             sizeof(float));
+          return pull_sparse_from_table(table_id, table, res_data[i].data(),
+                                        keys, num);
+        }));
+    keys += num;
+  }
+  bool failed = false;
+  for (auto &task : tasks) {
+    failed |= task.get() != 0;
+  }
+  if (failed) {
+    set_response_code(response, -1, "pull_sparse error");
+    return 0;
+  }
+  for (auto &data : res_data) {
+    cntl->response_attachment().append((char *)data.data(),
+                                       data.size() * sizeof(float));
+  }
+  return 0;
+}
+
+int32_t PsService::push_sparse_multi_table(Table *table,
+                                           const PsRequestMessage &request,
+                                           PsResponseMessage &response,
+                                           brpc::Controller *cntl) {
+  platform::RecordEvent record_event("PsService->push_sparse_multi_table");
+  std::vector<std::pair<uint32_t, uint32_t>> table_nums;
+  if (!parse_multi_table_params(request, &table_nums)) {
+    set_response_code(response, -1,
+                      "PsRequestMessage.params should be pairs of "
+                      "table_id and num of sparse_key");
+    return 0;
+  }
+  /*
+  Push Content:
+  |---keysData 0---|---valuesData 0---|---keysData 1---|---valuesData 1---|...
+  |---8*{num 0}B---|------------------|---8*{num 1}B---|------------------|...
+  */
+  // Validate the whole request before updating any table, so that a
+  // malformed request changes nothing. The tables are then updated
+  // independently: if the push of a table fails, the others are still
+  // applied, and the failure is reported in the response.
+  struct TablePush {
+    Table *table;
+    const uint64_t *keys;
+    const float *values;
+    uint32_t num;
+  };
+  auto &push_data = request.data();
+  std::vector<TablePush> pushes;
+  pushes.reserve(table_nums.size());
+  size_t offset = 0;
+  for (auto &table_num : table_nums) {
+    auto *table = _server->table(table_num.first);
+    if (table == NULL) {
+      std::string err_msg("table not found with table_id:");
+      err_msg.append(std::to_string(table_num.first));
+      set_response_code(response, -1, err_msg.c_str());
+      return 0;
+    }
+    uint32_t num = table_num.second;
+    size_t size =
+        num * (sizeof(uint64_t) + table->value_accesor()->update_size());
+    if (offset + size > push_data.size()) {
+      set_response_code(response, -1, "push data is lack of values");
+      return 0;
+    }
+    if (num > 0) {
+      pushes.push_back(
+          {table, (const uint64_t *)(push_data.data() + offset),
+           (const float *)(push_data.data() + offset + sizeof(uint64_t) * num),
+           num});
+    }
+    offset += size;
+  }
+  if (offset != push_data.size()) {
+    set_response_code(response, -1,
+                      "push data does not match the numbers of the keys");
+    return 0;
+  }
+
+  std::vector<std::future<int32_t>> tasks;
+  tasks.reserve(pushes.size());
+  for (auto &push : pushes) {
+    tasks.push_back(_table_task_pool->enqueue([push]() -> int32_t {
+      return push.table->push_sparse(push.keys, push.values, push.num);
+    }));
+  }
+  bool failed = false;
+  for (auto &task : tasks) {
+    failed |= task.get() != 0;
+  }
+  if (failed) {
+    set_response_code(response, -1, "push_sparse error");
+  }
+  return 0;
+}
+
 int32_t PsService::push_sparse(Table *table, const PsRequestMessage &request,
                                PsResponseMessage &response,
                                brpc::Controller *cntl) {
@@ -375,8 +652,19 @@ int32_t PsService::push_sparse(Table *table, const PsRequestMessage &request,
   |---8*{num}B---|----------------|
   */
   const uint64_t *keys = (const uint64_t *)push_data.data();
+  PsValueType value_type;
+  if (!push_value_type(request, 1, &value_type)) {
+    set_response_code(response, -1,
+                      "PsRequestMessage.params(1) is not a PsValueType");
+    return 0;
+  }
+  size_t value_num = (push_data.size() - sizeof(uint64_t) * num) /
+                     (value_type == PS_VALUE_FP16 ? sizeof(uint16_t)
+                                                  : sizeof(float));
+  std::vector<float> decoded;
   const float *values =
-      (const float *)(push_data.data() + sizeof(uint64_t) * num);
+      decode_values(push_data.data() + sizeof(uint64_t) * num, value_num,
+                    value_type, &decoded);
   if (table->push_sparse(keys, values, num) != 0) {
     set_response_code(response, -1, "push_sparse error");
   }
@@ -18,9 +18,12 @@
 #include "brpc/controller.h"
 #include "brpc/server.h"
 
+#include <ThreadPool.h>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 #include "paddle/fluid/distributed/service/server.h"
+#include "paddle/fluid/distributed/service/sparse_pull_coalescer.h"
 
 namespace paddle {
 namespace distributed {
@@ -80,10 +83,22 @@ class PsService : public PsBaseService {
                             brpc::Controller *cntl);
   int32_t pull_sparse(Table *table, const PsRequestMessage &request,
                       PsResponseMessage &response, brpc::Controller *cntl);
+  // Pull through the coalescer of the table if there is one.
+  int32_t pull_sparse_from_table(uint32_t table_id, Table *table,
+                                 float *values, const uint64_t *keys,
+                                 size_t num);
+  int32_t pull_sparse_multi_table(Table *table, const PsRequestMessage &request,
+                                  PsResponseMessage &response,
+                                  brpc::Controller *cntl);
+  int32_t push_sparse_multi_table(Table *table, const PsRequestMessage &request,
+                                  PsResponseMessage &response,
+                                  brpc::Controller *cntl);
   int32_t pull_geo_param(Table *table, const PsRequestMessage &request,
                          PsResponseMessage &response, brpc::Controller *cntl);
   int32_t barrier(Table *table, const PsRequestMessage &request,
                   PsResponseMessage &response, brpc::Controller *cntl);
+  int32_t push_clock(Table *table, const PsRequestMessage &request,
+                     PsResponseMessage &response, brpc::Controller *cntl);
   int32_t push_sparse(Table *table, const PsRequestMessage &request,
                       PsResponseMessage &response, brpc::Controller *cntl);
   int32_t load_one_table(Table *table, const PsRequestMessage &request,
@@ -115,6 +130,13 @@ class PsService : public PsBaseService {
   std::unordered_map<int32_t, serviceHandlerFunc> _service_handler_map;
   std::unordered_map<int32_t, serviceHandlerFunc> _msg_handler_map;
   std::vector<float> _ori_values;
+  // Run the sub-requests of the multi-table requests on the tables in
+  // parallel.
+  std::shared_ptr<::ThreadPool> _table_task_pool;
+  // The coalescers of the concurrent sparse pulls of the tables, created in
+  // initialize and read only after.
+  std::unordered_map<uint32_t, std::unique_ptr<SparsePullCoalescer>>
+      _pull_coalescers;
 };
 
 class DownpourPServerBrpcClosure : public PServerClosure {
@@ -15,6 +15,9 @@ limitations under the License. */
 #include "paddle/fluid/distributed/service/brpc_utils.h"
 #include <limits>
 #include <memory>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <utility>
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/profiler.h"
 
@@ -31,6 +34,95 @@ class DeviceContext;
 namespace paddle {
 namespace distributed {
 
+// The allocations of the tensors referenced by the attachments being sent.
+// brpc releases the user data of an IOBuf by its address only, so the
+// allocations are looked up by the addresses of the tensors.
+class SendingAllocations {
+ public:
+  static SendingAllocations& Instance() {
+    static SendingAllocations instance;
+    return instance;
+  }
+
+  void Hold(void* data, std::shared_ptr<memory::Allocation> allocation) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    allocations_.emplace(data, std::move(allocation));
+  }
+
+  static void Release(void* data) {
+    auto& instance = Instance();
+    std::shared_ptr<memory::Allocation> allocation;
+    {
+      std::lock_guard<std::mutex> lock(instance.mutex_);
+      auto it = instance.allocations_.find(data);
+      if (it == instance.allocations_.end()) {
+        return;
+      }
+      // Free the allocation out of the lock.
+      allocation = std::move(it->second);
+      instance.allocations_.erase(it);
+    }
+  }
+
+  size_t size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return allocations_.size();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::unordered_multimap<void*, std::shared_ptr<memory::Allocation>>
+      allocations_;
+};
+
+size_t SendingAllocationNum() { return SendingAllocations::Instance().size(); }
+
+// The smaller data is copied, which is cheaper than tracking its allocation.
+constexpr int64_t kZeroCopyMinBytes = 64 << 10;
+
+// Append the data of the tensor in the host memory to iobuf after its length.
+// With zero_copy, the data of kZeroCopyMinBytes or more is not copied, iobuf
+// references the allocation of the tensor until it is released, e.g. after
+// the RPC completes. The data must not be written until then.
+static void AppendTensorData(const framework::Tensor& tensor, bool zero_copy,
+                             butil::IOBuf* iobuf) {
+  auto data_len = tensor.numel() * framework::SizeOfType(tensor.type());
+  iobuf->append(reinterpret_cast<const char*>(&data_len), 8);
+  if (data_len == 0) {
+    return;
+  }
+  void* data = const_cast<void*>(tensor.data<void>());
+  if (!zero_copy || static_cast<int64_t>(data_len) < kZeroCopyMinBytes) {
+    iobuf->append(data, data_len);
+    return;
+  }
+  SendingAllocations::Instance().Hold(data, tensor.Holder());
+  iobuf->append_user_data(data, data_len, &SendingAllocations::Release);
+}
+
+#ifdef PADDLE_WITH_CUDA
+static void DeleteHostBuffer(void* data) { delete[] static_cast<char*>(data); }
+
+// Copy the data of the tensor in the GPU memory to a host buffer owned by
+// iobuf, after its length.
+static void AppendGPUTensorData(const framework::Tensor& tensor,
+                                const platform::DeviceContext& ctx,
+                                butil::IOBuf* iobuf) {
+  auto data_len = tensor.numel() * framework::SizeOfType(tensor.type());
+  iobuf->append(reinterpret_cast<const char*>(&data_len), 8);
+  if (data_len == 0) {
+    return;
+  }
+  char* temp_ptr = new char[data_len];
+  auto stream =
+      reinterpret_cast<const platform::CUDADeviceContext&>(ctx).stream();
+  memory::Copy(platform::CPUPlace(), temp_ptr,
+               BOOST_GET_CONST(platform::CUDAPlace, tensor.place()),
+               tensor.data<void>(), data_len, stream);
+  iobuf->append_user_data(temp_ptr, data_len, &DeleteHostBuffer);
+}
+#endif
+
 framework::proto::VarType::Type VarMessageToVarType(
     VariableMessage::Type type) {
   switch (type) {
@@ -55,7 +147,7 @@ void SerializeToMultiVarMsgAndIOBuf(
     const std::vector<std::string>& send_var_name_val,
     const std::vector<std::string>& recv_var_name_val,
     const platform::DeviceContext& ctx, const framework::Scope* scope,
-    MultiVarMsg* request, butil::IOBuf* iobuf) {
+    MultiVarMsg* request, butil::IOBuf* iobuf, bool zero_copy) {
   // 1. message_name
   request->set_message_name(message_name);
 
@@ -74,11 +166,16 @@ void SerializeToMultiVarMsgAndIOBuf(
     send_var_msg->set_varname(send_var_name);
 
     framework::Variable* var = scope->FindVar(send_var_name);
+    // The variables of the ancestor scopes, e.g. the parameters, may be
+    // written by others during the RPC, so they are always copied.
+    bool var_zero_copy =
+        zero_copy && scope->FindLocalVar(send_var_name) == var;
 
     if (var->IsType<framework::LoDTensor>()) {
-      SerializeLodTensor(var, ctx, send_var_msg, &temp_iobuf);
+      SerializeLodTensor(var, ctx, send_var_msg, &temp_iobuf, var_zero_copy);
     } else if (var->IsType<framework::SelectedRows>()) {
-      SerializeSelectedRows(var, ctx, send_var_msg, &temp_iobuf);
+      SerializeSelectedRows(var, ctx, send_var_msg, &temp_iobuf,
+                            var_zero_copy);
     }
     iobuf->append(temp_iobuf);
   }
@@ -86,7 +183,7 @@ void SerializeToMultiVarMsgAndIOBuf(
 
 void SerializeLodTensor(framework::Variable* var,
                         const platform::DeviceContext& ctx, VarMsg* var_msg,
-                        butil::IOBuf* iobuf) {
+                        butil::IOBuf* iobuf, bool zero_copy) {
   auto* tensor = var->GetMutable<framework::LoDTensor>();
   var_msg->set_type(::paddle::LOD_TENSOR);
   const framework::LoD lod = tensor->lod();
@@ -105,32 +202,17 @@ void SerializeLodTensor(framework::Variable* var,
   }
   // IO Buffer
   if (platform::is_cpu_place(tensor->place())) {
-    auto data_len = tensor->numel() * framework::SizeOfType(tensor->type());
-    iobuf->append(reinterpret_cast<const char*>(&data_len), 8);
-    iobuf->append(reinterpret_cast<const char*>(tensor->data<void>()),
-                  data_len);
+    AppendTensorData(*tensor, zero_copy, iobuf);
   } else {
 #ifdef PADDLE_WITH_CUDA
-    char* temp_ptr =
-        new char[tensor->numel() * framework::SizeOfType(tensor->type())];
-    auto stream =
-        reinterpret_cast<const platform::CUDADeviceContext&>(ctx).stream();
-    memory::Copy(platform::CPUPlace(), temp_ptr,
-                 BOOST_GET_CONST(platform::CUDAPlace, tensor->place()),
-                 tensor->data<void>(),
-                 tensor->numel() * framework::SizeOfType(tensor->type()),
-                 stream);
-    auto data_len = tensor->numel() * framework::SizeOfType(tensor->type());
-    iobuf->append(reinterpret_cast<const char*>(&data_len), 8);
-    iobuf->append(reinterpret_cast<const char*>(temp_ptr), data_len);
-    delete[] temp_ptr;
+    AppendGPUTensorData(*tensor, ctx, iobuf);
 #endif
   }
 }
 
 void SerializeSelectedRows(framework::Variable* var,
                            const platform::DeviceContext& ctx, VarMsg* var_msg,
-                           butil::IOBuf* iobuf) {
+                           butil::IOBuf* iobuf, bool zero_copy) {
   framework::SelectedRows* slr = var->GetMutable<framework::SelectedRows>();
   auto* tensor = slr->mutable_value();
   auto* rows = slr->mutable_rows();
@@ -161,25 +243,10 @@ void SerializeSelectedRows(framework::Variable* var,
 
   // IO Buffer
   if (platform::is_cpu_place(tensor->place())) {
-    auto data_len = tensor->numel() * framework::SizeOfType(tensor->type());
-    iobuf->append(reinterpret_cast<const char*>(&data_len), 8);
-    iobuf->append(reinterpret_cast<const char*>(tensor->data<void>()),
-                  data_len);
+    AppendTensorData(*tensor, zero_copy, iobuf);
   } else {
 #ifdef PADDLE_WITH_CUDA
-    char* temp_ptr =
-        new char[tensor->numel() * framework::SizeOfType(tensor->type())];
-    auto stream =
-        reinterpret_cast<const platform::CUDADeviceContext&>(ctx).stream();
-    memory::Copy(platform::CPUPlace(), temp_ptr,
-                 BOOST_GET_CONST(platform::CUDAPlace, tensor->place()),
-                 tensor->data<void>(),
-                 tensor->numel() * framework::SizeOfType(tensor->type()),
-                 stream);
-    auto data_len = tensor->numel() * framework::SizeOfType(tensor->type());
-    iobuf->append(reinterpret_cast<const char*>(&data_len), 8);
-    iobuf->append(reinterpret_cast<const char*>(temp_ptr), data_len);
-    delete[] temp_ptr;
+    AppendGPUTensorData(*tensor, ctx, iobuf);
 #endif
   }
 }
@@ -277,9 +344,11 @@ void DeserializeSelectedRows(framework::Variable* var, const VarMsg& msg,
   auto* slr = var->GetMutable<framework::SelectedRows>();
   framework::Tensor* tensor = slr->mutable_value();
   slr->set_height(msg.slr_height());
-  std::vector<int64_t> tmp_rows(msg.slr_height());
-  memcpy(&tmp_rows[0], msg.data().data(), msg.slr_height() * sizeof(int64_t));
-  slr->set_rows(tmp_rows);
+  auto* rows = slr->mutable_rows();
+  rows->resize(msg.data().size() / sizeof(int64_t));
+  if (!rows->empty()) {
+    memcpy(&(*rows)[0], msg.data().data(), rows->size() * sizeof(int64_t));
+  }
   std::vector<int> vec_dim;
   for (auto& x : msg.dims()) {
     vec_dim.push_back(x);
@@ -47,20 +47,24 @@ namespace distributed {
 using MultiVarMsg = ::paddle::MultiVariableMessage;
 using VarMsg = ::paddle::VariableMessage;
 
+// With zero_copy, the large CPU tensors of the variables in scope itself,
+// not in its ancestors, are serialized without copy: iobuf references their
+// memory until brpc releases it after the RPC, so the caller must not write
+// them until the RPC completes.
 void SerializeToMultiVarMsgAndIOBuf(
     const std::string& message_name,
     const std::vector<std::string>& send_var_name_val,
     const std::vector<std::string>& recv_var_name_val,
     const platform::DeviceContext& ctx, const framework::Scope* scope,
-    MultiVarMsg* var_msg, butil::IOBuf* iobuf);
+    MultiVarMsg* var_msg, butil::IOBuf* iobuf, bool zero_copy = false);
 
 void SerializeLodTensor(framework::Variable* var,
                         const platform::DeviceContext& ctx, VarMsg* var_msg,
-                        butil::IOBuf* iobuf);
+                        butil::IOBuf* iobuf, bool zero_copy = false);
 
 void SerializeSelectedRows(framework::Variable* var,
                            const platform::DeviceContext& ctx, VarMsg* request,
-                           butil::IOBuf* iobuf);
+                           butil::IOBuf* iobuf, bool zero_copy = false);
 
 // Deserialize for Server
 void DeserializeFromMultiVarMsgAndIOBuf(const MultiVarMsg& multi_msg,
@@ -82,5 +86,9 @@ void DeserializeSelectedRows(framework::Variable* var, const VarMsg& msg,
                              butil::IOBufBytesIterator& iobuf,
                              const platform::DeviceContext& ctx);
 
+// The number of the tensors serialized without copy and still referenced by
+// the attachments.
+size_t SendingAllocationNum();
+
 }  // namespace distributed
 }  // namespace paddle
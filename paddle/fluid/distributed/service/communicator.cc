@@ -14,6 +14,7 @@ limitations under the License. */
 
 #include "paddle/fluid/distributed/service/communicator.h"
 #include <google/protobuf/text_format.h>
+#include "paddle/fluid/distributed/service/geo_delta_compress.h"
 #include "paddle/fluid/distributed/table/table.h"
 
 #include <gflags/gflags.h>
@@ -34,6 +35,13 @@ limitations under the License. */
 #include "paddle/fluid/string/printf.h"
 #include "paddle/fluid/string/split.h"
 
+DEFINE_double(communicator_geo_sparse_topk_ratio, 1.0,
+              "the ratio of the rows with the largest deltas sent by each "
+              "sparse push of GeoCommunicator, the deltas of the others are "
+              "kept to be sent later");
+DEFINE_bool(communicator_geo_fp16_delta, false,
+            "whether GeoCommunicator sends the deltas in FP16");
+
 namespace paddle {
 namespace distributed {
 
@@ -195,7 +203,8 @@ void Communicator::RpcSendDenseParam(const std::vector<std::string> &varnames,
   return;
 }
 
-void Communicator::RpcSendDense(const CommContext &ctx, const Scope &scope) {
+void Communicator::RpcSendDense(const CommContext &ctx, const Scope &scope,
+                                PsValueType value_type) {
   platform::RecordEvent record_event("Communicator->RpcSendDense");
   auto &var_names = ctx.origin_varnames;
   auto &table_id = ctx.table_id;
@@ -233,7 +242,7 @@ void Communicator::RpcSendDense(const CommContext &ctx, const Scope &scope) {
         --_async_call_num;
       });
   auto status = _worker_ptr->push_dense_raw_gradient(
-      table_id, data, dense_data->size(), closure);
+      table_id, data, dense_data->size(), closure, value_type);
   status.wait();
   return;
 }
@@ -287,7 +296,7 @@ void Communicator::RpcSendSparse(const std::string &var_name, int table_id,
   auto dim = tensor->value().dims()[1];
   std::transform(tensor->rows().begin(), tensor->rows().end(),
                  std::back_inserter(sparse_push_keys),
-                 [&](int id) { return static_cast<uint64_t>(id); });
+                 [&](int64_t id) { return static_cast<uint64_t>(id); });
 
   for (auto i = 0; i < static_cast<int>(sparse_push_keys.size()); ++i) {
     push_g_vec.push_back(tensor->mutable_value()->data<float>() + i * dim);
@@ -314,6 +323,51 @@ void Communicator::RpcSendSparse(const std::string &var_name, int table_id,
   return;
 }
 
+void Communicator::RpcSendSparseMultiTable(
+    const std::vector<std::pair<std::string, int>> &var_tables,
+    const Scope &scope) {
+  platform::RecordEvent record_event("Communicator->RpcSendSparseMultiTable");
+  size_t request_call_num = _worker_ptr->get_server_nums();
+  size_t table_num = var_tables.size();
+  std::vector<std::vector<uint64_t>> sparse_push_keys(table_num);
+  std::vector<std::vector<const float *>> push_g_vecs(table_num);
+  std::vector<TableSparseValues> tables(table_num);
+
+  for (size_t t = 0; t < table_num; ++t) {
+    auto *send_var = scope.FindVar(var_tables[t].first);
+    auto *tensor = send_var->GetMutable<SelectedRows>();
+    auto dim = tensor->value().dims()[1];
+    auto &keys = sparse_push_keys[t];
+    std::transform(tensor->rows().begin(), tensor->rows().end(),
+                   std::back_inserter(keys),
+                   [&](int64_t id) { return static_cast<uint64_t>(id); });
+    for (auto i = 0; i < static_cast<int>(keys.size()); ++i) {
+      push_g_vecs[t].push_back(tensor->mutable_value()->data<float>() +
+                               i * dim);
+    }
+    tables[t] = {static_cast<size_t>(var_tables[t].second), keys.data(),
+                 push_g_vecs[t].data(), keys.size()};
+  }
+
+  ++_async_call_num;
+  DownpourBrpcClosure *closure = new DownpourBrpcClosure(
+      request_call_num, [this, request_call_num](void *done) {
+        int ret = 0;
+        auto *closure = (DownpourBrpcClosure *)done;
+        for (size_t i = 0; i < request_call_num; ++i) {
+          if (closure->check_response(i, PS_PUSH_SPARSE_MULTI_TABLE) != 0) {
+            ret = -1;
+            break;
+          }
+        }
+        closure->set_promise_value(ret);
+        --_async_call_num;
+      });
+  auto status = _worker_ptr->push_sparse_multi_table(tables, closure);
+  status.wait();
+  return;
+}
+
 void Communicator::RpcRecvSparse(const std::string &varname, int table_id,
                                  Scope *scope) {
   platform::RecordEvent record_event("Communicator->RpcRecvSparse");
@@ -426,14 +480,48 @@ void AsyncCommunicator::RecvNoBarrier() {
   return;
 }
 
+// The sparse grads merged by the send tasks of a round. They are sent by the
+// last of the sparse tasks, in a single request per server for all the
+// sparse tables, while the dense tasks are still sending.
+class SparseSendRound {
+ public:
+  explicit SparseSendRound(const RpcCtxMap &send_ctx) : task_num_(0) {
+    for (auto &iter : send_ctx) {
+      if (iter.second.is_sparse) {
+        ++task_num_;
+      }
+    }
+  }
+
+  // Called once by each sparse task, with merged false if it has no grads to
+  // send. Return the (varname, table_id)s to send if it is the last one.
+  std::vector<std::pair<std::string, int>> Done(const std::string &varname,
+                                                int table_id, bool merged) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (merged) {
+      var_tables_.emplace_back(varname, table_id);
+    }
+    if (--task_num_ > 0) {
+      return {};
+    }
+    return std::move(var_tables_);
+  }
+
+ private:
+  std::mutex mutex_;
+  int task_num_;
+  std::vector<std::pair<std::string, int>> var_tables_;
+};
+
 void AsyncCommunicator::SendByCommunicator() {
   std::vector<std::future<void>> tasks;
   tasks.reserve(send_varname_to_ctx_.size());
+  SparseSendRound sparse_round(send_varname_to_ctx_);
 
   for (auto &iter : send_varname_to_ctx_) {
     auto &ctx = iter.second;
 
-    auto send_recv_task = [this, &ctx] {
+    auto send_recv_task = [this, &ctx, &sparse_round] {
       auto &varnames = ctx.origin_varnames;
       auto &table_id = ctx.table_id;
       size_t var_nums = varnames.size();
@@ -461,9 +549,11 @@ void AsyncCommunicator::SendByCommunicator() {
           merged_var_num++;
         }
       }
-      if (merged_var_num == 0) return;
+      // A sparse task without grads still takes its part in the round, as
+      // it may be the last one to send the others.
+      if (merged_var_num == 0 && !ctx.is_sparse) return;
 
-      for (size_t i = 0; i < var_nums; i++) {
+      for (size_t i = 0; i < var_nums && merged_var_num > 0; i++) {
         auto &var_name = varnames[i];
         MergeVars<float>(var_name, vars[i], send_scope_.get(), 1);
       }
@@ -473,14 +563,19 @@ void AsyncCommunicator::SendByCommunicator() {
             varnames.size(), 1,
             platform::errors::InvalidArgument(
                 "sparse variables can only be merged by one variables"));
-        RpcSendSparse(varnames[0], table_id, *send_scope_);
-      } else {
-        RpcSendDense(ctx, *send_scope_);
-        if (!independent_recv_ &&
-            recv_varname_to_ctx_.find(table_id) != recv_varname_to_ctx_.end()) {
-          auto recv_varnames = recv_varname_to_ctx_.at(table_id);
-          RpcRecvDense(recv_varnames, table_id, recv_scope_);
+        auto var_tables =
+            sparse_round.Done(varnames[0], table_id, merged_var_num > 0);
+        SendSparseVars(var_tables);
+        if (independent_recv_) {
+          grad_num_.fetch_add(var_tables.size(), std::memory_order_relaxed);
         }
+        return;
+      }
+      RpcSendDense(ctx, *send_scope_, PS_VALUE_FP32);
+      if (!independent_recv_ &&
+          recv_varname_to_ctx_.find(table_id) != recv_varname_to_ctx_.end()) {
+        auto recv_varnames = recv_varname_to_ctx_.at(table_id);
+        RpcRecvDense(recv_varnames, table_id, recv_scope_);
       }
       if (independent_recv_) {
         grad_num_.fetch_add(1, std::memory_order_relaxed);
@@ -494,6 +589,15 @@ void AsyncCommunicator::SendByCommunicator() {
   return;
 }
 
+void AsyncCommunicator::SendSparseVars(
+    const std::vector<std::pair<std::string, int>> &var_tables) {
+  if (var_tables.size() == 1) {
+    RpcSendSparse(var_tables[0].first, var_tables[0].second, *send_scope_);
+  } else if (var_tables.size() > 1) {
+    RpcSendSparseMultiTable(var_tables, *send_scope_);
+  }
+}
+
 void AsyncCommunicator::MainThread() {
   VLOG(3) << "AsyncCommunicator MainThread start and wait";
 
@@ -684,9 +788,11 @@ void HalfAsyncCommunicator::SendByCommunicator() {
   std::vector<std::future<void>> tasks;
   tasks.reserve(send_varname_to_ctx_.size());
 
+  SparseSendRound sparse_round(send_varname_to_ctx_);
+
   for (auto &iter : send_varname_to_ctx_) {
     auto &ctx = iter.second;
-    auto send_recv_task = [this, &ctx, batches] {
+    auto send_recv_task = [this, &ctx, batches, &sparse_round] {
       auto &varnames = ctx.origin_varnames;
       auto &table_id = ctx.table_id;
       size_t var_nums = varnames.size();
@@ -705,9 +811,9 @@ void HalfAsyncCommunicator::SendByCommunicator() {
             varnames.size(), 1,
             platform::errors::InvalidArgument(
                 "sparse variables can only be merged by one variables"));
-        RpcSendSparse(varnames[0], table_id, *send_scope_);
+        SendSparseVars(sparse_round.Done(varnames[0], table_id, true));
       } else {
-        RpcSendDense(ctx, *send_scope_);
+        RpcSendDense(ctx, *send_scope_, PS_VALUE_FP32);
       }
     };
     tasks.emplace_back(send_threadpool_->enqueue(std::move(send_recv_task)));
@@ -736,6 +842,36 @@ void SyncCommunicator::BarrierRecv() {
   VLOG(4) << "BarrierRecv with SyncCommunicator";
 }
 
+void SspCommunicator::BarrierSend() {
+  if (!running_) return;
+  PushClock(1);
+  VLOG(4) << "BarrierSend with SspCommunicator";
+}
+
+void SspCommunicator::Stop() {
+  HalfAsyncCommunicator::Stop();
+  // the trainer no longer holds back the others
+  PushClock(-1);
+}
+
+void SspCommunicator::PushClock(int32_t steps) {
+  if (!_worker_ptr) return;
+  std::set<int> table_ids;
+  for (auto &iter : send_varname_to_ctx_) {
+    table_ids.insert(iter.second.table_id);
+  }
+  for (auto &iter : recv_varname_to_ctx_) {
+    table_ids.insert(iter.first);
+  }
+  std::vector<std::future<int32_t>> rets;
+  for (auto table_id : table_ids) {
+    rets.push_back(_worker_ptr->push_clock(table_id, steps));
+  }
+  for (auto &ret : rets) {
+    ret.wait();
+  }
+}
+
 void GeoCommunicator::Send(const std::vector<std::string> &var_names,
                            const framework::Scope &scope) {
   waiting_ = false;
@@ -809,6 +945,7 @@ void GeoCommunicator::InitImpl(const RpcCtxMap &send_varname_to_ctx,
               std::make_shared<
                   BlockingQueue<std::shared_ptr<std::vector<int64_t>>>>(
                   send_queue_size_)));
+      sparse_residual_ids_.emplace(splited_var, std::vector<int64_t>());
     }
   }
 
@@ -905,11 +1042,16 @@ void GeoCommunicator::SendDense(const CommContext &send_ctx) {
 
     float coefficient = 1.0 / static_cast<float>(trainers_);
     blas.SCAL(t_latest.numel(), coefficient, t_delta->data<float>());
+    if (FLAGS_communicator_geo_fp16_delta) {
+      GeoRoundToFloat16(t_delta->data<float>(), t_latest.numel());
+    }
 
     blas.VADD(t_latest.numel(), t_timestamp->data<float>(),
               t_delta->data<float>(), t_timestamp->data<float>());
   }
-  RpcSendDense(send_ctx, *delta_scope_);
+  auto value_type =
+      FLAGS_communicator_geo_fp16_delta ? PS_VALUE_FP16 : PS_VALUE_FP32;
+  RpcSendDense(send_ctx, *delta_scope_, value_type);
   VLOG(1) << "Finish Send Dense " << var_names[0] << ", table_id: " << table_id;
   return;
 }
@@ -1027,6 +1169,13 @@ void GeoCommunicator::SendSparse(const std::string &varname,
   auto dims1 = t_latest.dims()[1];
   auto cpu_ctx = paddle::platform::CPUDeviceContext();
 
+  auto value_type =
+      FLAGS_communicator_geo_fp16_delta ? PS_VALUE_FP16 : PS_VALUE_FP32;
+  auto &residual_ids = sparse_residual_ids_.at(varname);
+  GeoSelectTopkRows(t_latest.data<float>(), t_old->data<float>(), dims1,
+                    FLAGS_communicator_geo_sparse_topk_ratio, &sparse_ids,
+                    &residual_ids);
+
   auto *var_delta = delta_scope_->Var(varname);
   auto *t_delta = var_delta->GetMutable<framework::SelectedRows>();
   auto *var_t_value = t_delta->mutable_value();
@@ -1047,6 +1196,9 @@ void GeoCommunicator::SendSparse(const std::string &varname,
               t_old->data<float>() + sparse_ids[j] * dims1,
               t_value + j * dims1);
     blas.SCAL(dims1, coefficient, t_value + j * dims1);
+    if (FLAGS_communicator_geo_fp16_delta) {
+      GeoRoundToFloat16(t_value + j * dims1, dims1);
+    }
     blas.VADD(dims1, t_old->data<float>() + sparse_ids[j] * dims1,
               t_value + j * dims1,
               t_old->data<float>() + sparse_ids[j] * dims1);
@@ -1065,11 +1217,14 @@ void GeoCommunicator::SendSparse(const std::string &varname,
   });
   auto status = _worker_ptr->push_sparse_raw_gradient_partial(
       table_id, (const uint64_t *)sparse_ids.data(),
-      (const float **)push_g_vec.data(), sparse_ids.size(), closure, ep_idx);
+      (const float **)push_g_vec.data(), sparse_ids.size(), closure, ep_idx,
+      value_type);
   status.wait();
 
   VLOG(1) << "Finish Send Sparse " << varname
-          << ", ids.size = " << sparse_ids.size() << ", table_id: " << table_id;
+          << ", ids.size = " << sparse_ids.size()
+          << ", residual ids.size = " << residual_ids.size()
+          << ", table_id: " << table_id;
   return;
 }
 
@@ -213,10 +213,15 @@ class Communicator {
   virtual void RpcSendDenseParam(const std::vector<std::string> &varnames,
                                  int table_id, const Scope &scope);
   // 3. send dense grad
-  virtual void RpcSendDense(const CommContext &ctx, const Scope &scope);
+  virtual void RpcSendDense(const CommContext &ctx, const Scope &scope,
+                            PsValueType value_type);
   // 4. send sparse grad
   virtual void RpcSendSparse(const std::string &var_name, int table_id,
                              const Scope &scope);
+  // 4.1 send the sparse grads of several tables, in a request per server
+  virtual void RpcSendSparseMultiTable(
+      const std::vector<std::pair<std::string, int>> &var_tables,
+      const Scope &scope);
   // 5. send sparse param
   virtual void RpcSendSparseParam(const std::string &varname, int table_id,
                                   const Scope &scope);
@@ -376,6 +381,11 @@ class AsyncCommunicator : public Communicator {
 
   virtual void SendByCommunicator();
 
+  // Send the merged sparse grads in send_scope_ of the (varname, table_id)s,
+  // in a single request per server if there are several tables.
+  void SendSparseVars(
+      const std::vector<std::pair<std::string, int>> &var_tables);
+
   virtual void SendGlobalStep(int batches) {}
 
   virtual void RecvByCommunicator();
@@ -486,6 +496,43 @@ class SyncCommunicator : public HalfAsyncCommunicator {
   std::vector<std::string> pserver_endpoints_{};
 };
 
+// The stale synchronous parallel mode: the tables of the trainers are
+// configured with ssp_staleness, and instead of the barriers of
+// SyncCommunicator, every round of send and recv pushes a clock to the
+// tables, so a trainer only waits in the pulls while it is more than
+// ssp_staleness rounds ahead of the slowest trainer.
+class SspCommunicator : public HalfAsyncCommunicator {
+ public:
+  SspCommunicator() : HalfAsyncCommunicator() {}
+
+  explicit SspCommunicator(const std::map<std::string, std::string> &envs)
+      : HalfAsyncCommunicator(envs) {}
+
+  void InitEnvs() {
+    // enfore to recv after send
+    independent_recv_ = false;
+    min_send_grad_num_before_recv_ = 0;
+    max_merge_var_num_ = std::stoi(envs.at("communicator_max_merge_var_num"));
+    send_wait_times_ = std::stoi(envs.at("communicator_send_wait_times"));
+    thread_pool_size_ = std::stoi(envs.at("communicator_thread_pool_size"));
+    send_queue_size_ = std::stoi(envs.at("communicator_send_queue_size"));
+    need_global_step_ =
+        static_cast<bool>(std::stoi(envs.at("need_global_step")));
+
+    VLOG(0) << "SspCommunicator Initialized";
+  }
+
+  void Stop() override;
+
+  void BarrierSend();
+
+  void BarrierRecv() {}
+
+ private:
+  // push the clock of steps to all the tables sent to or received from
+  void PushClock(int32_t steps);
+};
+
 class GeoCommunicator : public AsyncCommunicator {
  public:
   GeoCommunicator() : AsyncCommunicator() {}
@@ -555,6 +602,8 @@ class GeoCommunicator : public AsyncCommunicator {
       std::string,
       std::shared_ptr<BlockingQueue<std::shared_ptr<std::vector<int64_t>>>>>
       sparse_id_queues_;
+  // the rows not selected by the top-k of the last push of each splited var
+  std::unordered_map<std::string, std::vector<int64_t>> sparse_residual_ids_;
 };
 
 }  // namespace distributed
@@ -0,0 +1,73 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/service/geo_delta_compress.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <utility>
+
+#include "paddle/fluid/platform/float16.h"
+
+namespace paddle {
+namespace distributed {
+
+void GeoSelectTopkRows(const float *latest, const float *old, int64_t dim,
+                       float topk_ratio, std::vector<int64_t> *ids,
+                       std::vector<int64_t> *residual_ids) {
+  ids->insert(ids->end(), residual_ids->begin(), residual_ids->end());
+  residual_ids->clear();
+  std::sort(ids->begin(), ids->end());
+  ids->erase(std::unique(ids->begin(), ids->end()), ids->end());
+  if (topk_ratio >= 1.0f || ids->empty()) {
+    return;
+  }
+  size_t k = static_cast<size_t>(std::ceil(topk_ratio * ids->size()));
+  if (k >= ids->size()) {
+    return;
+  }
+
+  // The squared L2 norm of the delta of each row.
+  std::vector<std::pair<float, int64_t>> norms;
+  norms.reserve(ids->size());
+  for (auto id : *ids) {
+    const float *latest_row = latest + id * dim;
+    const float *old_row = old + id * dim;
+    float norm = 0;
+    for (int64_t i = 0; i < dim; ++i) {
+      float delta = latest_row[i] - old_row[i];
+      norm += delta * delta;
+    }
+    norms.emplace_back(norm, id);
+  }
+  std::nth_element(norms.begin(), norms.begin() + k, norms.end(),
+                   std::greater<std::pair<float, int64_t>>());
+
+  ids->clear();
+  for (size_t i = 0; i < norms.size(); ++i) {
+    (i < k ? ids : residual_ids)->push_back(norms[i].second);
+  }
+  std::sort(ids->begin(), ids->end());
+  std::sort(residual_ids->begin(), residual_ids->end());
+}
+
+void GeoRoundToFloat16(float *values, size_t num) {
+  for (size_t i = 0; i < num; ++i) {
+    values[i] = static_cast<float>(platform::float16(values[i]));
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
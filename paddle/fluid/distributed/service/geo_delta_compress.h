@@ -0,0 +1,40 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace paddle {
+namespace distributed {
+
+// Select the rows of a Geo-SGD sparse push. The candidates are the rows in
+// *ids and the rows left by the previous pushes in *residual_ids, and only
+// the ceil(topk_ratio * n) of the n candidates with the largest L2 norm of
+// latest - old are kept in *ids. The others are left in *residual_ids, their
+// deltas keep accumulating in latest - old until a later push selects them.
+// All the candidates are kept if topk_ratio >= 1.
+void GeoSelectTopkRows(const float *latest, const float *old, int64_t dim,
+                       float topk_ratio, std::vector<int64_t> *ids,
+                       std::vector<int64_t> *residual_ids);
+
+// Round the values to FP16, so that the deltas added to the old parameter are
+// the ones decoded by the server, and the rounding error is pushed with the
+// next delta.
+void GeoRoundToFloat16(float *values, size_t num);
+
+}  // namespace distributed
+}  // namespace paddle
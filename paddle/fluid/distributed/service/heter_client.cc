@@ -14,6 +14,7 @@
 
 #include "paddle/fluid/distributed/service/heter_client.h"
 #include <algorithm>
+#include <chrono>  // NOLINT
 #include <utility>
 #include "paddle/fluid/framework/channel.h"
 #include "paddle/fluid/framework/data_feed.h"
@@ -26,6 +27,10 @@
 DECLARE_int32(rpc_deadline);
 DECLARE_int32(pserver_timeout_ms);
 
+DEFINE_int32(heter_client_max_inflight_micro_batches, 0,
+             "the max number of the micro-batches sent by a trainer to the "
+             "heter workers and not responded yet, 0 for no limit");
+
 namespace paddle {
 namespace distributed {
 
@@ -39,6 +44,7 @@ void HeterClient::MainThread() {
 }
 
 void HeterClient::Stop() {
+  WaitMicroBatches();
   running_ = false;
   if (!is_initialized_) {
     VLOG(0) << "HeterClient is not inited, do nothing";
@@ -54,6 +60,7 @@ void HeterClient::Stop() {
 }
 
 void HeterClient::FinalizeWorker() {
+  WaitMicroBatches();
   running_ = false;
   if (!is_initialized_) {
     VLOG(0) << "HeterClient is not inited, do nothing";
@@ -64,6 +71,7 @@ void HeterClient::FinalizeWorker() {
     }
     VLOG(1) << "HeterClient Stop Done";
   }
+  VLOG(1) << "HeterClient latencies:\n" << latency_stats_.ToString();
 }
 
 std::future<int32_t> HeterClient::StopHeterWorker() {
@@ -107,35 +115,121 @@ void HeterClient::SendAndRecvAsync(
     const std::vector<std::string>& send_var_name,
     const std::vector<std::string>& recv_var_name) {
   platform::RecordEvent record_event("HeterClient->SendAndRecvAsync");
+  VLOG(3) << "GRPCClient::SendAndRecv Begin, message_name: " << message_name;
+  // The last call of the scope still owns its send and recv variables.
+  WaitSendAndRecv(scope, message_name);
+  // The calls of the trainer threads share the window of the micro-batches.
+  auto fut = SendAndRecvMicroBatch(ctx, &scope, message_name, send_var_name,
+                                   recv_var_name);
+  std::lock_guard<std::mutex> lock(pending_mutex_);
+  pending_[std::make_pair(&scope, message_name)] = std::move(fut);
+}
+
+void HeterClient::WaitSendAndRecv(const framework::Scope& scope,
+                                  const std::string& message_name) {
+  std::future<int32_t> fut;
+  {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    auto it = pending_.find(std::make_pair(&scope, message_name));
+    if (it == pending_.end()) {
+      return;
+    }
+    fut = std::move(it->second);
+    pending_.erase(it);
+  }
+  platform::RecordEvent record_event("HeterClient->WaitSendAndRecv");
+  auto ret = fut.get();
+  PADDLE_ENFORCE_EQ(
+      ret, 0, platform::errors::External(
+                  "HeterClient::SendAndRecv of %s fails, see the log above.",
+                  message_name));
+  VLOG(4) << "call heter_worker success";
+}
+
+static double ElapsedUS(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+std::future<int32_t> HeterClient::SendAndRecvMicroBatch(
+    const platform::DeviceContext& ctx, const framework::Scope* scope,
+    const std::string& message_name,
+    const std::vector<std::string>& send_var_name,
+    const std::vector<std::string>& recv_var_name) {
+  platform::RecordEvent record_event("HeterClient->SendAndRecvMicroBatch");
+  auto start = std::chrono::steady_clock::now();
+  {
+    std::unique_lock<std::mutex> lock(inflight_mutex_);
+    inflight_cv_.wait(lock, [this] {
+      return FLAGS_heter_client_max_inflight_micro_batches <= 0 ||
+             inflight_num_ < FLAGS_heter_client_max_inflight_micro_batches;
+    });
+    ++inflight_num_;
+  }
+  latency_stats_.Add(message_name + "/window", ElapsedUS(start));
+
+  auto serialize_start = std::chrono::steady_clock::now();
+  distributed::MultiVarMsg request;
+  butil::IOBuf request_io_buffer;
+  // The send variables are not written until the future is ready.
+  distributed::SerializeToMultiVarMsgAndIOBuf(
+      message_name, send_var_name, recv_var_name, ctx, scope, &request,
+      &request_io_buffer, true);
+  latency_stats_.Add(message_name + "/serialize", ElapsedUS(serialize_start));
+
+  auto promise = std::make_shared<std::promise<int32_t>>();
+  auto fut = promise->get_future();
   const platform::DeviceContext* p_ctx = &ctx;
-  const framework::Scope* p_scope = &scope;
-  const std::string message_name_val = message_name;
-  const std::vector<std::string> send_var_name_val = send_var_name;
-  const std::vector<std::string> recv_var_name_val = recv_var_name;
-
-  VLOG(3) << "GRPCClient::SendAndRecv Begin, message_name: "
-          << message_name_val;
-  // Todo: get correct channel
-  int num = trainer_id_ % xpu_channels_.size();
+  auto send_time = std::chrono::steady_clock::now();
+  OnHeterRpcDone* closure = new OnHeterRpcDone(
+      [this, p_ctx, scope, message_name, send_time, promise](void* done) {
+        auto* closure = reinterpret_cast<OnHeterRpcDone*>(done);
+        latency_stats_.Add(message_name + "/rpc", ElapsedUS(send_time));
+        int32_t ret = 0;
+        if (closure->cntl.Failed()) {
+          VLOG(0) << "HeterClient::SendAndRecvMicroBatch meets brpc error, "
+                  << "error message is " << closure->cntl.ErrorText();
+          ret = -1;
+        } else {
+          auto deserialize_start = std::chrono::steady_clock::now();
+          try {
+            distributed::DeserializeFromMultiVarMsgAndIOBuf(
+                closure->response, &closure->cntl.response_attachment(),
+                *p_ctx, scope);
+          } catch (const std::exception& e) {
+            VLOG(0) << "HeterClient::SendAndRecvMicroBatch fails to "
+                    << "deserialize the response of " << message_name << ": "
+                    << e.what();
+            ret = -1;
+          }
+          latency_stats_.Add(message_name + "/deserialize",
+                             ElapsedUS(deserialize_start));
+        }
+        {
+          std::lock_guard<std::mutex> lock(inflight_mutex_);
+          --inflight_num_;
+        }
+        inflight_cv_.notify_all();
+        promise->set_value(ret);
+      });
+  closure->cntl.set_timeout_ms(FLAGS_pserver_timeout_ms);
+  closure->cntl.request_attachment().swap(request_io_buffer);
 
-  brpc::Controller cntl;
-  cntl.set_timeout_ms(FLAGS_pserver_timeout_ms);
-  distributed::MultiVarMsg request, response;
-  auto& request_io_buffer = cntl.request_attachment();
+  int num = trainer_id_ % xpu_channels_.size();
   ::paddle::PsService_Stub stub(xpu_channels_[num].get());
-  distributed::SerializeToMultiVarMsgAndIOBuf(
-      message_name_val, send_var_name_val, recv_var_name_val, *p_ctx, p_scope,
-      &request, &request_io_buffer);
-  stub.SendAndRecvVariable(&cntl, &request, &response, NULL);
-  PADDLE_ENFORCE_NE(
-      cntl.Failed(), true,
-      platform::errors::Unimplemented(
-          "HeterClient::SendAndRecv meets brpc error, error message is %s",
-          cntl.ErrorText()));
-  VLOG(4) << "call heter_worker success";
-  auto& response_io_buffer = cntl.response_attachment();
-  distributed::DeserializeFromMultiVarMsgAndIOBuf(response, &response_io_buffer,
-                                                  ctx, p_scope);
+  stub.SendAndRecvVariable(&closure->cntl, &request, &closure->response,
+                           closure);
+  return fut;
+}
+
+void HeterClient::WaitMicroBatches() {
+  {
+    std::unique_lock<std::mutex> lock(inflight_mutex_);
+    inflight_cv_.wait(lock, [this] { return inflight_num_ == 0; });
+  }
+  std::lock_guard<std::mutex> lock(pending_mutex_);
+  pending_.clear();
 }
 
 std::future<int32_t> HeterClient::SendCmd(
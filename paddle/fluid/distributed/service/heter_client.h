@@ -14,18 +14,23 @@ limitations under the License. */
 
 #pragma once
 #include <atomic>
+#include <condition_variable>  // NOLINT
 #include <ctime>
+#include <future>  // NOLINT
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <random>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 #include "brpc/channel.h"
 #include "brpc/controller.h"
 #include "brpc/server.h"
 #include "paddle/fluid/distributed/service/brpc_ps_client.h"
 #include "paddle/fluid/distributed/service/brpc_utils.h"
+#include "paddle/fluid/distributed/service/heter_latency_stats.h"
 #include "paddle/fluid/distributed/service/sendrecv.pb.h"
 #include "paddle/fluid/framework/scope.h"
 #include "paddle/fluid/framework/tensor.h"
@@ -66,6 +71,10 @@ class HeterClient {
 
   void CreateClient2XpuConnection();
 
+  // Send the variables of scope to the heter worker and return without
+  // waiting for the response, i.e. the send_and_recv op. WaitSendAndRecv of
+  // the same scope and message_name, i.e. the send_and_recv_wait op, joins it
+  // before the recv variables are read or the send variables are written.
   void SendAndRecvAsync(const std::vector<std::string>& ep,
                         const platform::DeviceContext& ctx,
                         const framework::Scope& scope,
@@ -73,6 +82,33 @@ class HeterClient {
                         const std::vector<std::string>& send_var_name,
                         const std::vector<std::string>& recv_var_name);
 
+  // Wait for the response of the SendAndRecvAsync of scope and message_name,
+  // if any, and throw if it fails.
+  void WaitSendAndRecv(const framework::Scope& scope,
+                       const std::string& message_name);
+
+  // Send a micro-batch to the heter worker without waiting for its response,
+  // so that the trainer keeps up to FLAGS_heter_client_max_inflight_micro_
+  // batches of them in flight, overlapping the RPC with its own compute. The
+  // call blocks while the window is full. The responses may arrive in any
+  // order, each is deserialized into the scope of its micro-batch, and the
+  // returned future is ready then, with -1 if the RPC failed. ctx and scope
+  // must outlive the future, and the send variables of scope are sent without
+  // copy, so they must not be written until then.
+  std::future<int32_t> SendAndRecvMicroBatch(
+      const platform::DeviceContext& ctx, const framework::Scope* scope,
+      const std::string& message_name,
+      const std::vector<std::string>& send_var_name,
+      const std::vector<std::string>& recv_var_name);
+
+  // Wait for all the micro-batches in flight, and drop the responses of the
+  // SendAndRecvAsync calls not joined.
+  void WaitMicroBatches();
+
+  // The latencies of the micro-batches: waiting for the window, serializing
+  // the request, the RPC, and deserializing the response.
+  const HeterLatencyStats& GetLatencyStats() const { return latency_stats_; }
+
   // HeterClient singleton
   static std::shared_ptr<HeterClient> GetInstance(
       const std::vector<std::string>& endpoint, const int& trainer_id) {
@@ -122,6 +158,17 @@ class HeterClient {
   bool running_ = false;
   int trainer_id_;
   bool do_server_profiler_ = false;
+
+  // the window of the micro-batches in flight
+  std::mutex inflight_mutex_;
+  std::condition_variable inflight_cv_;
+  int inflight_num_ = 0;
+  // the SendAndRecvAsync calls not joined yet, by scope and message name
+  std::mutex pending_mutex_;
+  std::map<std::pair<const framework::Scope*, std::string>,
+           std::future<int32_t>>
+      pending_;
+  HeterLatencyStats latency_stats_;
 };
 
 }  // end namespace distributed
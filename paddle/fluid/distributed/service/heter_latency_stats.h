@@ -0,0 +1,67 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <map>
+#include <mutex>  // NOLINT
+#include <sstream>
+#include <string>
+
+namespace paddle {
+namespace distributed {
+
+// The latencies of the stages of the heter pipeline, named by the caller as
+// "<message_name>/<stage>".
+class HeterLatencyStats {
+ public:
+  struct Stat {
+    int64_t count = 0;
+    double total_us = 0;
+    double max_us = 0;
+
+    double AvgUS() const { return count == 0 ? 0 : total_us / count; }
+  };
+
+  void Add(const std::string& stage, double us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& stat = stats_[stage];
+    ++stat.count;
+    stat.total_us += us;
+    stat.max_us = std::max(stat.max_us, us);
+  }
+
+  std::map<std::string, Stat> Get() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+  }
+
+  std::string ToString() const {
+    std::ostringstream os;
+    for (auto& iter : Get()) {
+      os << iter.first << ": count " << iter.second.count << ", avg "
+         << iter.second.AvgUS() << " us, max " << iter.second.max_us
+         << " us\n";
+    }
+    return os.str();
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  std::map<std::string, Stat> stats_;
+};
+
+}  // namespace distributed
+}  // namespace paddle
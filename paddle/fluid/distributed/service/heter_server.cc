@@ -31,6 +31,7 @@ void HeterServer::RegisterServiceHandler(std::string message_name,
 }
 
 void HeterServer::StartHeterService() {
+  service_.MarkStarted();
   server_.AddService(&service_, brpc::SERVER_DOESNT_OWN_SERVICE);
   brpc::ServerOptions options;
   if (server_.Start(endpoint_.c_str(), &options) != 0) {
@@ -64,6 +65,31 @@ void HeterServer::WaitServerReady() {
   condition_ready_.wait(lock, [=] { return this->ready_ == 1; });
 }
 
+void HeterService::RunStage(
+    const std::string& message_name, const HeterServiceHandler& handler,
+    const MultiVarMsg* request, MultiVarMsg* response, brpc::Controller* cntl,
+    std::chrono::steady_clock::time_point enqueue_time) {
+  auto start = std::chrono::steady_clock::now();
+  latency_stats_.Add(message_name + "/queue",
+                     std::chrono::duration<double, std::micro>(
+                         start - enqueue_time)
+                         .count());
+  // The exceptions must not escape the threads of a stage, where nobody
+  // catches them, and the client gets the failure instead.
+  try {
+    handler(request, response, cntl);
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "HeterService fails to handle " << message_name << ": "
+               << e.what();
+    cntl->SetFailed(std::string("HeterService fails to handle ") +
+                    message_name + ": " + e.what());
+  }
+  latency_stats_.Add(message_name + "/compute",
+                     std::chrono::duration<double, std::micro>(
+                         std::chrono::steady_clock::now() - start)
+                         .count());
+}
+
 int32_t HeterService::stop_profiler(const PsRequestMessage& request,
                                     PsResponseMessage& response,
                                     brpc::Controller* cntl) {
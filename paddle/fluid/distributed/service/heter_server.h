@@ -13,10 +13,14 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #pragma once
+#include <ThreadPool.h>
 #include <atomic>
+#include <chrono>  // NOLINT
 #include <ctime>
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <random>
 #include <string>
 #include <unordered_map>
@@ -26,6 +30,7 @@ limitations under the License. */
 #include "brpc/controller.h"
 #include "brpc/server.h"
 #include "paddle/fluid/distributed/service/brpc_utils.h"
+#include "paddle/fluid/distributed/service/heter_latency_stats.h"
 #include "paddle/fluid/distributed/service/sendrecv.pb.h"
 #include "paddle/fluid/framework/executor.h"
 #include "paddle/fluid/framework/program_desc.h"
@@ -99,7 +104,21 @@ class HeterService : public ::paddle::PsService {
             "HeterService::SendAndRecvVariable Get illegal message_name: %s "
             "which is not in HeterService::handler_map_",
             message_name));
-    itr->second(request, response, cntl);
+    auto handler = itr->second;
+    auto pool = stage_pools_.find(message_name);
+    if (pool == stage_pools_.end()) {
+      RunStage(message_name, handler, request, response, cntl,
+               std::chrono::steady_clock::now());
+      return;
+    }
+    // Run the stage on its own threads, and respond from there.
+    auto enqueue_time = std::chrono::steady_clock::now();
+    auto* closure = done_guard.release();
+    pool->second->enqueue([this, message_name, handler, request, response,
+                           cntl, enqueue_time, closure] {
+      brpc::ClosureGuard done_guard(closure);
+      RunStage(message_name, handler, request, response, cntl, enqueue_time);
+    });
   }
 
   void RegisterServiceHandler(std::string message_name,
@@ -107,6 +126,28 @@ class HeterService : public ::paddle::PsService {
     handler_map_[message_name] = func;
   }
 
+  // Run the requests of message_name on a pool of thread_num threads, instead
+  // of the brpc workers, so that the stages of a CPU-only pipeline, e.g. the
+  // sparse and the dense ones, use separate CPUs and do not delay each other.
+  // It must be called before the service starts, as the requests read the
+  // pools without a lock.
+  void SetStageThreadNum(const std::string& message_name, int thread_num) {
+    PADDLE_ENFORCE_EQ(
+        started_.load(), false,
+        platform::errors::PreconditionNotMet(
+            "HeterService::SetStageThreadNum of %s should be called before "
+            "the service starts.",
+            message_name));
+    stage_pools_[message_name].reset(new ::ThreadPool(thread_num));
+  }
+
+  // No more stage pools can be set once the service starts.
+  void MarkStarted() { started_ = true; }
+
+  // The latencies of the requests of each message_name: waiting for the
+  // threads of the stage, and running the handler.
+  const HeterLatencyStats& GetLatencyStats() const { return latency_stats_; }
+
   void SetEndpoint(const std::string& end_point) { endpoint_ = end_point; }
   void SetFanin(const int& fan_in) { fan_in_ = fan_in; }
   bool IsExit() { return is_exit_; }
@@ -122,9 +163,17 @@ class HeterService : public ::paddle::PsService {
                             PsResponseMessage& response,
                             brpc::Controller* cntl);
 
+  void RunStage(const std::string& message_name,
+                const HeterServiceHandler& handler, const MultiVarMsg* request,
+                MultiVarMsg* response, brpc::Controller* cntl,
+                std::chrono::steady_clock::time_point enqueue_time);
+
  private:
   std::string endpoint_;
   std::unordered_map<std::string, HeterServiceHandler> handler_map_;
+  std::unordered_map<std::string, std::unique_ptr<::ThreadPool>> stage_pools_;
+  std::atomic<bool> started_{false};
+  HeterLatencyStats latency_stats_;
   std::unordered_map<int32_t, serviceHandlerFunc> _service_handler_map;
   std::unordered_set<int> stop_cpu_worker_set_;
   int fan_in_;
@@ -156,6 +205,14 @@ class HeterServer {
   void SetEndPoint(std::string& endpoint);
   void SetFanin(int& fan_in);
 
+  void SetStageThreadNum(const std::string& message_name, int thread_num) {
+    service_.SetStageThreadNum(message_name, thread_num);
+  }
+
+  const HeterLatencyStats& GetLatencyStats() const {
+    return service_.GetLatencyStats();
+  }
+
   // HeterWrapper singleton
   static std::shared_ptr<HeterServer> GetInstance() {
     if (NULL == s_instance_) {
@@ -226,13 +283,19 @@ class RequestSendAndRecvHandler final : public HeterRequestHandler {
              brpc::Controller* cntl) override {
     platform::RecordEvent record_event("RequestSendAndRecvHandler->Handle");
     FLAGS_eager_delete_tensor_gb = -1;
-    auto& local_scope = scope_->NewScope();
     auto message_name = request->message_name();
+    // The scope is deleted instead of reused if the handling throws.
+    std::unique_ptr<framework::Scope, std::function<void(framework::Scope*)>>
+        local_scope(AcquireRecvScope(message_name),
+                    [this](framework::Scope* scope) {
+                      scope_->DeleteScope(scope);
+                    });
     auto& request_io_buffer = cntl->request_attachment();
     distributed::DeserializeFromMultiVarMsgAndIOBuf(
-        *request, &request_io_buffer, *dev_ctx_, &local_scope);
+        *request, &request_io_buffer, *dev_ctx_, local_scope.get());
     executor_->RunPreparedContext(
-        (*message_to_prepared_ctx_)[message_name].get(), &local_scope, false);
+        (*message_to_prepared_ctx_)[message_name].get(), local_scope.get(),
+        false);
 
     auto response_var_nums = request->recv_var_names_size();
     std::vector<std::string> response_var_names(response_var_nums),
@@ -242,12 +305,64 @@ class RequestSendAndRecvHandler final : public HeterRequestHandler {
       response_var_names[var_idx] = request->recv_var_names(var_idx);
     }
     auto& response_io_buffer = cntl->response_attachment();
+    // The response variables of local_scope are erased right after, so
+    // nobody writes them while they are sent.
     distributed::SerializeToMultiVarMsgAndIOBuf(
         message_name, response_var_names, empty_var_names, *dev_ctx_,
-        &local_scope, response, &response_io_buffer);
-    scope_->DeleteScope(&local_scope);
+        local_scope.get(), response, &response_io_buffer, true);
+    ReleaseRecvScope(message_name, *request, local_scope.release());
     return 0;
   }
+
+ private:
+  // The scope to receive a request of the message into, reused from the
+  // earlier requests if any is idle.
+  framework::Scope* AcquireRecvScope(const std::string& message_name) {
+    {
+      std::lock_guard<std::mutex> lock(recv_scopes_mutex_);
+      auto& idle_scopes = idle_recv_scopes_[message_name];
+      if (!idle_scopes.empty()) {
+        auto* scope = idle_scopes.back();
+        idle_scopes.pop_back();
+        return scope;
+      }
+    }
+    return &scope_->NewScope();
+  }
+
+  // Keep only the received variables in the scope, so that the next request
+  // of the message is deserialized into their tensors without allocating
+  // them again. A tensor still referenced elsewhere, e.g. by the response
+  // being sent without copy, is dropped to be allocated again instead.
+  void ReleaseRecvScope(const std::string& message_name,
+                        const MultiVarMsg& request, framework::Scope* scope) {
+    std::unordered_set<framework::Variable*> recv_vars;
+    for (auto& var_name : request.send_var_names()) {
+      auto* var = scope->FindLocalVar(var_name);
+      if (var != nullptr) {
+        recv_vars.insert(var);
+      }
+    }
+    scope->EraseVarsExcept(recv_vars);
+    for (auto* var : recv_vars) {
+      framework::Tensor* tensor = nullptr;
+      if (var->IsType<framework::LoDTensor>()) {
+        tensor = var->GetMutable<framework::LoDTensor>();
+      } else if (var->IsType<framework::SelectedRows>()) {
+        tensor = var->GetMutable<framework::SelectedRows>()->mutable_value();
+      }
+      if (tensor != nullptr && tensor->Holder().use_count() > 1) {
+        tensor->clear();
+      }
+    }
+    std::lock_guard<std::mutex> lock(recv_scopes_mutex_);
+    idle_recv_scopes_[message_name].push_back(scope);
+  }
+
+  std::mutex recv_scopes_mutex_;
+  // The idle scopes of the requests received, by message name.
+  std::unordered_map<std::string, std::vector<framework::Scope*>>
+      idle_recv_scopes_;
 };
 
 }  // end namespace distributed
@@ -29,6 +29,25 @@ namespace paddle {
 namespace distributed {
 
 typedef std::function<void(void *)> PSClientCallBack;
+
+// The keys of a sparse table and the gradient of each key, in the sparse push
+// of several tables at once.
+struct TableSparseValues {
+  size_t table_id;
+  const uint64_t *keys;
+  const float **values;
+  size_t num;
+};
+
+// The keys of a sparse table and the value of each key, in the sparse pull of
+// several tables at once. The values are filled by the pull.
+struct TableSparsePullValues {
+  size_t table_id;
+  const uint64_t *keys;
+  float **values;
+  size_t num;
+};
+
 class PSClientClosure : public google::protobuf::Closure {
  public:
   PSClientClosure(PSClientCallBack callback) : _callback(callback) {}
@@ -112,6 +131,11 @@ class PSClient {
                                            const uint64_t *keys,
                                            size_t num) = 0;
 
+  // 同pull_sparse，所有table发往同一server的keys合并为一个请求
+  // 即每个server只有一次往返，server端并行拉取各个table
+  virtual std::future<int32_t> pull_sparse_multi_table(
+      const std::vector<TableSparsePullValues> &tables) = 0;
+
   virtual std::future<int32_t> print_table_stat(uint32_t table_id) = 0;
 
   // 确保所有积攒中的请求都发起发送
@@ -126,6 +150,9 @@ class PSClient {
   virtual std::future<int32_t> barrier(size_t table_id,
                                        uint32_t barrier_type) = 0;
 
+  // 推进trainer在table上的clock, steps < 0 时表示trainer结束
+  virtual std::future<int32_t> push_clock(size_t table_id, int32_t steps) = 0;
+
   virtual std::future<int32_t> pull_geo_param(size_t table_id,
                                               std::vector<float> *values,
                                               std::vector<uint64_t> *keys,
@@ -172,7 +199,7 @@ class PSClient {
 
   virtual std::future<int32_t> push_dense_raw_gradient(
       int table_id, float *total_send_data, size_t total_send_data_size,
-      void *done) = 0;
+      void *done, PsValueType value_type = PS_VALUE_FP32) = 0;
 
   virtual std::future<int32_t> push_sparse_raw_gradient(
       size_t table_id, const uint64_t *keys, const float **update_values,
@@ -180,13 +207,21 @@ class PSClient {
 
   virtual std::future<int32_t> push_sparse_raw_gradient_partial(
       size_t table_id, const uint64_t *keys, const float **update_values,
-      uint32_t num, void *done, int pserver_idx) = 0;
+      uint32_t num, void *done, int pserver_idx,
+      PsValueType value_type = PS_VALUE_FP32) = 0;
 
   virtual std::future<int32_t> push_sparse_param(size_t table_id,
                                                  const uint64_t *keys,
                                                  const float **update_values,
                                                  size_t num, void *done) = 0;
 
+  // 同push_sparse_raw_gradient，每个server一个请求，包含所有table的梯度
+  // done须为get_server_nums()个请求的DownpourBrpcClosure，tables为空时直接完成
+  // server端先校验整个请求，格式错误时不更新任何table；之后各table独立更新，
+  // 某个table更新失败时其余table仍会生效，并在response中返回错误
+  virtual std::future<int32_t> push_sparse_multi_table(
+      const std::vector<TableSparseValues> &tables, void *done) = 0;
+
  protected:
   virtual int32_t initialize() = 0;
   size_t _client_id;
@@ -0,0 +1,131 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/service/sparse_pull_coalescer.h"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+#include "bthread/bthread.h"
+#include "paddle/fluid/platform/profiler.h"
+
+namespace paddle {
+namespace distributed {
+
+int32_t SparsePullCoalescer::pull_sparse(float *pull_values,
+                                         const uint64_t *keys, size_t num) {
+  Request request;
+  request.pull_values = pull_values;
+  request.keys = keys;
+  request.num = num;
+
+  std::unique_lock<bthread::Mutex> lock(mutex_);
+  pending_.push_back(&request);
+  while (!request.done && running_) {
+    cv_.wait(lock);
+  }
+  if (request.done) {
+    return request.ret;
+  }
+
+  // The first pull of the batch collects and runs it.
+  running_ = true;
+  if (window_us_ > 0) {
+    lock.unlock();
+    bthread_usleep(window_us_);
+    lock.lock();
+  }
+  std::vector<Request *> batch;
+  batch.swap(pending_);
+  lock.unlock();
+
+  // A throwing table must not leave running_ set, or the next pulls would
+  // wait for this batch forever.
+  try {
+    run_batch(batch);
+  } catch (const std::exception &e) {
+    LOG(ERROR) << "SparsePullCoalescer failed to pull a batch of "
+               << batch.size() << " pulls: " << e.what();
+    for (auto *r : batch) {
+      r->ret = -1;
+    }
+  }
+
+  lock.lock();
+  for (auto *r : batch) {
+    r->done = true;
+  }
+  running_ = false;
+  cv_.notify_all();
+  return request.ret;
+}
+
+void SparsePullCoalescer::run_batch(const std::vector<Request *> &batch) {
+  platform::RecordEvent record_event("SparsePullCoalescer->run_batch");
+  pull_num_ += batch.size();
+  ++batch_num_;
+  if (batch.size() == 1) {
+    auto *request = batch[0];
+    key_num_ += request->num;
+    unique_key_num_ += request->num;
+    request->ret = table_->pull_sparse(request->pull_values, request->keys,
+                                       request->num);
+    return;
+  }
+
+  // The keys of all the pulls, with the row to scatter the value to.
+  std::vector<std::pair<uint64_t, float *>> kvs;
+  size_t dim = table_->value_accesor()->select_size() / sizeof(float);
+  for (auto *request : batch) {
+    for (size_t i = 0; i < request->num; ++i) {
+      kvs.emplace_back(request->keys[i], request->pull_values + i * dim);
+    }
+  }
+  std::sort(kvs.begin(), kvs.end(),
+            [](const std::pair<uint64_t, float *> &k1,
+               const std::pair<uint64_t, float *> &k2) {
+              return k1.first < k2.first;
+            });
+
+  // Each key is pulled once, and its values are copied to every row pulling
+  // it.
+  std::vector<uint64_t> keys;
+  keys.reserve(kvs.size());
+  for (size_t i = 0; i < kvs.size(); ++i) {
+    if (i == 0 || kvs[i].first != kvs[i - 1].first) {
+      keys.push_back(kvs[i].first);
+    }
+  }
+  key_num_ += kvs.size();
+  unique_key_num_ += keys.size();
+
+  std::vector<float> values(keys.size() * dim);
+  int32_t ret = table_->pull_sparse(values.data(), keys.data(), keys.size());
+  const float *value = values.data() - dim;
+  for (size_t i = 0; i < kvs.size(); ++i) {
+    if (i == 0 || kvs[i].first != kvs[i - 1].first) {
+      value += dim;
+    }
+    std::copy_n(value, dim, kvs[i].second);
+  }
+  for (auto *request : batch) {
+    request->ret = ret;
+  }
+  VLOG(4) << "SparsePullCoalescer merged " << batch.size() << " pulls of "
+          << kvs.size() << " keys, " << keys.size() << " of them unique";
+}
+
+}  // namespace distributed
+}  // namespace paddle
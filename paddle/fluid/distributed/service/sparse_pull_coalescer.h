@@ -0,0 +1,81 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "bthread/condition_variable.h"
+#include "bthread/mutex.h"
+#include "paddle/fluid/distributed/table/table.h"
+
+namespace paddle {
+namespace distributed {
+
+// Merge the concurrent sparse pulls of a table into a single pull. The pulls
+// arriving while a merged pull is running, or within window_us after the
+// first of them, are merged into the next one: their keys are sorted and
+// deduplicated, pulled in one pass over the shards of the table, and the
+// values are scattered back to each pull. So a key pulled by several of the
+// merged pulls is counted once by the entry policy and the eviction of the
+// table. The caller of the first pull of a batch runs it, and the others wait
+// for it on a bthread condition, which does not block the worker pthread of
+// the brpc server, so no thread is added.
+class SparsePullCoalescer {
+ public:
+  SparsePullCoalescer(Table *table, int64_t window_us)
+      : table_(table), window_us_(window_us) {}
+
+  // The same as Table::pull_sparse, pull_values is of num rows of
+  // select_size.
+  int32_t pull_sparse(float *pull_values, const uint64_t *keys, size_t num);
+
+  // The number of the pulls, and of the merged pulls run on the table.
+  int64_t pull_num() const { return pull_num_; }
+  int64_t batch_num() const { return batch_num_; }
+  // The number of the keys pulled, and of the keys pulled from the table,
+  // without the duplicates among the merged pulls.
+  int64_t key_num() const { return key_num_; }
+  int64_t unique_key_num() const { return unique_key_num_; }
+
+ private:
+  struct Request {
+    float *pull_values;
+    const uint64_t *keys;
+    size_t num;
+    int32_t ret = 0;
+    bool done = false;
+  };
+
+  void run_batch(const std::vector<Request *> &batch);
+
+  Table *table_;
+  int64_t window_us_;
+
+  bthread::Mutex mutex_;
+  bthread::ConditionVariable cv_;
+  std::vector<Request *> pending_;
+  // Whether a batch is being collected or run.
+  bool running_ = false;
+
+  std::atomic<int64_t> pull_num_{0};
+  std::atomic<int64_t> batch_num_{0};
+  std::atomic<int64_t> key_num_{0};
+  std::atomic<int64_t> unique_key_num_{0};
+};
+
+}  // namespace distributed
+}  // namespace paddle
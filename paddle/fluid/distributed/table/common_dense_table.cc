@@ -13,11 +13,20 @@
 // limitations under the License.
 
 #include "paddle/fluid/distributed/table/common_dense_table.h"
+
+#include <algorithm>
+
 #include "paddle/fluid/distributed/common/utils.h"
 
+DEFINE_int32(pserver_dense_table_thread_num, 8,
+             "The max number of the threads updating a dense table.");
+
 namespace paddle {
 namespace distributed {
 
+// The least numel of the param updated by a thread of a dense table.
+constexpr int kDenseTableMinShardNumel = 16384;
+
 void CommonDenseTable::create_initializer(const std::string& attr,
                                           const std::string& name) {
   auto slices = string::split_string<std::string>(attr, "&");
@@ -35,15 +44,23 @@ void CommonDenseTable::create_initializer(const std::string& attr,
 }
 
 int32_t CommonDenseTable::initialize() {
+  sync = _config.common().sync();
+  VLOG(1) << "table " << _config.common().table_name() << " is sync: " << sync;
+
+  initialize_value();
+
+  task_pool_size_ = std::max(
+      1, std::min(FLAGS_pserver_dense_table_thread_num,
+                  param_dim_ / kDenseTableMinShardNumel));
+  buckets_ = bucket(param_dim_, task_pool_size_);
+  reservoir_mutex_.reset(new std::mutex[task_pool_size_]);
   _shards_task_pool.resize(task_pool_size_);
   for (int i = 0; i < _shards_task_pool.size(); ++i) {
     _shards_task_pool[i].reset(new ::ThreadPool(1));
   }
+  VLOG(1) << "table " << _config.common().table_name() << " is updated by "
+          << task_pool_size_ << " threads";
 
-  sync = _config.common().sync();
-  VLOG(1) << "table " << _config.common().table_name() << " is sync: " << sync;
-
-  initialize_value();
   initialize_optimizer();
   return 0;
 }
@@ -115,12 +132,20 @@ int32_t CommonDenseTable::pour() {
 
 int32_t CommonDenseTable::push_dense(const float* values, size_t num) {
   if (sync) {
-    std::future<int> task =
-        _shards_task_pool[0]->enqueue([this, &values]() -> int {
-          pull_reservoir_.add(values, param_dim_);
-          return 0;
-        });
-    task.wait();
+    // Add the buckets in the calling thread, starting from a different
+    // bucket for each thread to spread the workers over the locks.
+    const int start = reservoir_start_++ % task_pool_size_;
+    for (int i = 0; i < task_pool_size_; ++i) {
+      int shard_id = (start + i) % task_pool_size_;
+      auto begin = buckets_[shard_id];
+      auto end = buckets_[shard_id + 1];
+      std::lock_guard<std::mutex> lock(reservoir_mutex_[shard_id]);
+      SumRowUpdate(end - begin, values + begin,
+                   pull_reservoir_.values.data() + begin);
+      if (shard_id == 0) {
+        pull_reservoir_.counter++;
+      }
+    }
   } else {
     _push_dense(values, num);
   }
@@ -133,14 +158,15 @@ int32_t CommonDenseTable::_push_dense(const float* values, size_t num) {
       paddle::platform::errors::InvalidArgument(
           "update desne numel expected %d, but got %d", param_dim_, num));
 
-  std::vector<int> buckets = bucket(param_dim_, task_pool_size_);
+  std::lock_guard<std::mutex> lock(push_mutex_);
+  optimizer_->begin_update();
   std::vector<std::future<int>> tasks(task_pool_size_);
 
   for (int shard_id = 0; shard_id < task_pool_size_; ++shard_id) {
     tasks[shard_id] = _shards_task_pool[shard_id]->enqueue(
-        [this, shard_id, &buckets, &values]() -> int {
-          auto begin = buckets[shard_id];
-          auto end = buckets[shard_id + 1];
+        [this, shard_id, &values]() -> int {
+          auto begin = buckets_[shard_id];
+          auto end = buckets_[shard_id + 1];
           optimizer_->update(values, param_dim_, begin, end);
           return 0;
         });
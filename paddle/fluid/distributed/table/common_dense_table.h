@@ -17,7 +17,11 @@
 #include <ThreadPool.h>
 #include <assert.h>
 #include <pthread.h>
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <vector>
 #include "Eigen/Dense"
 #include "paddle/fluid/distributed/table/accessor.h"
 #include "paddle/fluid/distributed/table/common_table.h"
@@ -64,7 +68,17 @@ class CommonDenseTable : public DenseTable {
   int32_t _push_dense(const float* values, size_t num);
 
  private:
-  const int task_pool_size_ = 1;
+  // The param is split into task_pool_size_ buckets, which are updated by
+  // the threads of the shards in parallel.
+  int task_pool_size_ = 1;
+  std::vector<int> buckets_;
+  // The pushes are applied one by one, as the optimizers keep the states
+  // shared by all the shards, e.g. the powers of the betas of adam.
+  std::mutex push_mutex_;
+  // The locks of the buckets of pull_reservoir_, so that the pushes of the
+  // workers in sync mode add to different buckets concurrently.
+  std::unique_ptr<std::mutex[]> reservoir_mutex_;
+  std::atomic<uint32_t> reservoir_start_{0};
   bool sync = true;
   std::vector<std::shared_ptr<::ThreadPool>> _shards_task_pool;
   int param_dim_ = 0;
@@ -13,10 +13,12 @@
 // limitations under the License.
 
 #include "paddle/fluid/distributed/table/common_sparse_table.h"
+#include <unistd.h>
 #include <algorithm>
 #include <sstream>
 #include "paddle/fluid/distributed/common/utils.h"
 #include "paddle/fluid/distributed/table/depends/large_scale_kv.h"
+#include "paddle/fluid/distributed/table/ssd_sparse_store.h"
 #include "paddle/fluid/framework/generator.h"
 #include "paddle/fluid/string/printf.h"
 #include "paddle/fluid/string/string_helper.h"
@@ -134,6 +136,23 @@ int64_t SaveToText(std::ostream* os, std::shared_ptr<ValueBlock> block,
   return block->values_.size();
 }
 
+int64_t SaveSpilledToText(std::ostream* os, SpillStore* store) {
+  int64_t count = 0;
+  store->ForEach(
+      [os, &count](uint64_t id, const std::vector<std::vector<float>>& values) {
+        std::stringstream ss;
+        ss << id << "\t";
+        for (auto& value : values) {
+          ss << paddle::string::join_strings(value, ',');
+          ss << "\t";
+        }
+        ss << "\n";
+        os->write(ss.str().c_str(), sizeof(char) * ss.str().size());
+        ++count;
+      });
+  return count;
+}
+
 int64_t LoadFromText(const std::string& valuepath, const std::string& metapath,
                      const int pserver_id, const int pserver_num,
                      const int local_shard_num,
@@ -241,6 +260,7 @@ int32_t CommonSparseTable::initialize_value() {
     auto& dim = common.dims()[x];
     if (varname == "Param") {
       param_dim_ = dim;
+      param_idx_ = x;
     }
     auto& initializer = common.initializers()[x];
     create_initializer(initializer, varname);
@@ -248,9 +268,29 @@ int32_t CommonSparseTable::initialize_value() {
 
   shard_values_.reserve(task_pool_size_);
   for (int x = 0; x < task_pool_size_; ++x) {
-    auto shard = std::make_shared<ValueBlock>(common, &initializers_);
+    auto shard =
+        std::make_shared<ValueBlock>(common, &initializers_, task_pool_size_);
     shard_values_.emplace_back(shard);
   }
+  if (shard_values_[0]->max_rows() > 0) {
+    VLOG(0) << "table " << common.table_name() << " keeps at most "
+            << shard_values_[0]->max_rows() * task_pool_size_
+            << " rows in memory by the eviction " << common.eviction();
+  }
+
+  if (!common.ssd_path().empty()) {
+    PADDLE_ENFORCE_GT(shard_values_[0]->max_rows(), 0,
+                      platform::errors::InvalidArgument(
+                          "The ssd_path of the sparse table %s requires the "
+                          "memory_mb of the eviction, but received %s.",
+                          common.table_name(), common.eviction()));
+    std::vector<int> dims(common.dims().begin(), common.dims().end());
+    // The pservers on the same machine do not share the directories.
+    auto path = string::Sprintf("%s/%s.%d.%d", common.ssd_path(),
+                                common.table_name(), _config.table_id(),
+                                static_cast<int>(getpid()));
+    set_spill_store(std::make_shared<SsdSparseStore>(path, dims));
+  }
 
   auto accessor = _config.accessor();
 
@@ -264,15 +304,24 @@ int32_t CommonSparseTable::initialize_value() {
 
   VLOG(0) << "has " << feasigns.size() << " ids need to be pre inited";
 
-  auto buckets = bucket(feasigns.size(), 10);
-  for (int x = 0; x < 10; ++x) {
-    auto bucket_feasigns = buckets[x + 1] - buckets[x];
-    std::vector<uint64_t> ids(bucket_feasigns);
-    std::copy(feasigns.begin() + buckets[x], feasigns.begin() + buckets[x + 1],
-              ids.begin());
-    std::vector<float> pulls;
-    pulls.resize(bucket_feasigns * param_dim_);
-    pull_sparse(pulls.data(), ids.data(), bucket_feasigns);
+  // The pre inited ids are not subject to the entry policy.
+  std::vector<std::string> value_names(common.params().begin(),
+                                       common.params().end());
+  std::vector<std::future<int>> tasks(task_pool_size_);
+  for (int shard_id = 0; shard_id < task_pool_size_; ++shard_id) {
+    tasks[shard_id] = _shards_task_pool[shard_id]->enqueue(
+        [this, shard_id, &feasigns, &value_names]() -> int {
+          auto& block = shard_values_[shard_id];
+          for (auto id : feasigns) {
+            if (static_cast<int>(id % task_pool_size_) == shard_id) {
+              block->InitFromInitializer(id, value_names);
+            }
+          }
+          return 0;
+        });
+  }
+  for (size_t shard_id = 0; shard_id < tasks.size(); ++shard_id) {
+    tasks[shard_id].wait();
   }
 
   return 0;
@@ -289,6 +338,10 @@ int32_t CommonSparseTable::initialize_optimizer() {
     optimizer_ = std::make_shared<SAdam>(common);
   } else if (name == "sum") {
     optimizer_ = std::make_shared<SSUM>(common);
+  } else if (name == "adagrad") {
+    optimizer_ = std::make_shared<SAdagrad>(common);
+  } else if (name == "ftrl") {
+    optimizer_ = std::make_shared<SFtrl>(common);
   } else {
     VLOG(0) << "init optimizer failed";
   }
@@ -333,6 +386,9 @@ int32_t CommonSparseTable::save(const std::string& dirname,
     total_ins +=
         SaveToText(value_out.get(), shard_values_[shard_id], params, mode);
   }
+  if (spill_store_ != nullptr) {
+    total_ins += SaveSpilledToText(value_out.get(), spill_store_.get());
+  }
   value_out->close();
 
   // save meta
@@ -361,10 +417,34 @@ std::pair<int64_t, int64_t> CommonSparseTable::print_table_stat() {
   for (auto& value : shard_values_) {
     feasign_size += value->values_.size();
   }
+  VLOG(0) << "table " << _config.common().table_name() << " has "
+          << feasign_size << " rows, " << entry_stats().ToString();
 
   return {feasign_size, mf_size};
 }
 
+EntryStats CommonSparseTable::entry_stats() {
+  EntryStats stats;
+  for (auto& value : shard_values_) {
+    stats += value->stats();
+  }
+  stats.expired += spill_expired_;
+  return stats;
+}
+
+void CommonSparseTable::set_spill_store(
+    std::shared_ptr<SpillStore> spill_store) {
+  rwlock_->WRLock();
+  spill_store_ = spill_store;
+  for (auto& value : shard_values_) {
+    value->SetSpillStore(spill_store);
+  }
+  if (_fetch_task_pool == nullptr) {
+    _fetch_task_pool.reset(new ::ThreadPool(task_pool_size_));
+  }
+  rwlock_->UNLock();
+}
+
 int32_t CommonSparseTable::pour() {
   rwlock_->RDLock();
 
@@ -391,11 +471,6 @@ int32_t CommonSparseTable::pour() {
 int32_t CommonSparseTable::pull_sparse(float* pull_values, const uint64_t* keys,
                                        size_t num) {
   rwlock_->RDLock();
-  std::vector<std::string> value_names;
-  for (auto name : _config.common().params()) {
-    value_names.push_back(name);
-  }
-
   std::vector<std::vector<uint64_t>> offset_bucket;
   offset_bucket.resize(task_pool_size_);
 
@@ -408,19 +483,66 @@ int32_t CommonSparseTable::pull_sparse(float* pull_values, const uint64_t* keys,
 
   for (int shard_id = 0; shard_id < task_pool_size_; ++shard_id) {
     tasks[shard_id] = _shards_task_pool[shard_id]->enqueue(
-        [this, shard_id, &keys, &offset_bucket, &value_names,
-         &pull_values]() -> int {
+        [this, shard_id, &keys, &offset_bucket, &pull_values]() -> int {
           auto& block = shard_values_[shard_id];
           auto& offsets = offset_bucket[shard_id];
 
-          for (int i = 0; i < offsets.size(); ++i) {
-            auto offset = offsets[i];
-            auto id = keys[offset];
-            block->InitFromInitializer(id, value_names);
-            auto values = block->Get(id, {"Param"});
-            auto dim = values[0]->size();
-            std::copy(values[0]->begin(), values[0]->end(),
-                      pull_values + dim * offset);
+          auto pull = [&](uint64_t offset) {
+            auto* value = block->InitGet(keys[offset]);
+            float* pull_value = pull_values + param_dim_ * offset;
+            // The keys not admitted are pulled as zeros.
+            if (value == nullptr) {
+              std::fill_n(pull_value, param_dim_, 0.0f);
+              return;
+            }
+            auto& param = value->values_[param_idx_];
+            std::copy(param.begin(), param.end(), pull_value);
+          };
+
+          // The rows in the spill store are fetched in a batch in the
+          // background, while the rows in the memory are pulled.
+          std::vector<uint64_t> cold_keys;
+          std::vector<uint64_t> cold_offsets;
+          if (spill_store_ != nullptr) {
+            for (auto offset : offsets) {
+              auto id = keys[offset];
+              if (block->GetValue(id) == nullptr &&
+                  spill_store_->Contains(id)) {
+                cold_keys.push_back(id);
+                cold_offsets.push_back(offset);
+              }
+            }
+          }
+          std::vector<std::vector<std::vector<float>>> cold_values;
+          std::vector<EntryMeta> cold_metas;
+          std::future<void> fetch;
+          if (!cold_keys.empty()) {
+            fetch = _fetch_task_pool->enqueue([this, &cold_keys, &cold_values,
+                                               &cold_metas]() {
+              spill_store_->LoadBatch(cold_keys, &cold_values, &cold_metas);
+            });
+          }
+
+          size_t cold = 0;
+          for (auto offset : offsets) {
+            if (cold < cold_offsets.size() && cold_offsets[cold] == offset) {
+              ++cold;
+              continue;
+            }
+            pull(offset);
+          }
+
+          // Each row is pulled right after it is restored, since restoring
+          // the following rows may evict it again when there are more cold
+          // keys than the rows the block holds.
+          if (!cold_keys.empty()) {
+            fetch.get();
+            for (size_t i = 0; i < cold_keys.size(); ++i) {
+              if (!cold_values[i].empty()) {
+                block->Restore(cold_keys[i], &cold_values[i], cold_metas[i]);
+              }
+              pull(cold_offsets[i]);
+            }
           }
           return 0;
         });
@@ -536,7 +658,17 @@ int32_t CommonSparseTable::push_sparse_param(const uint64_t* keys,
 int32_t CommonSparseTable::flush() { return 0; }
 
 int32_t CommonSparseTable::shrink() {
-  VLOG(0) << "shrink coming soon";
+  rwlock_->WRLock();
+  for (auto& value : shard_values_) {
+    value->Shrink();
+  }
+  int ttl_days = shard_values_[0]->ttl_days();
+  if (spill_store_ != nullptr && ttl_days > 0) {
+    spill_expired_ += spill_store_->Shrink(ttl_days);
+  }
+  VLOG(0) << "sparse table " << _config.common().table_name()
+          << " shrink done, " << entry_stats().ToString();
+  rwlock_->UNLock();
   return 0;
 }
 void CommonSparseTable::clear() { VLOG(0) << "clear coming soon"; }
@@ -76,6 +76,14 @@ class CommonSparseTable : public SparseTable {
   virtual int32_t shrink();
   virtual void clear();
 
+  // The stats of the entry and the eviction of all the shards.
+  EntryStats entry_stats();
+
+  // The store to write back the evicted rows to, see SpillStore. The rows in
+  // the store are fetched in a batch in the background on pull, and are saved
+  // with the rows in the memory.
+  void set_spill_store(std::shared_ptr<SpillStore> spill_store);
+
  protected:
   virtual int32_t _push_sparse(const uint64_t* keys, const float* values,
                                size_t num);
@@ -83,12 +91,18 @@ class CommonSparseTable : public SparseTable {
  private:
   const int task_pool_size_ = 11;
   std::vector<std::shared_ptr<::ThreadPool>> _shards_task_pool;
+  // Fetch the rows in the spill store for the shards.
+  std::shared_ptr<::ThreadPool> _fetch_task_pool;
 
   bool sync = false;
   int param_dim_ = 0;
+  int param_idx_ = 0;
   std::shared_ptr<SparseOptimizer> optimizer_;
   std::unordered_map<std::string, Initializer*> initializers_;
   std::vector<std::shared_ptr<ValueBlock>> shard_values_;
+  std::shared_ptr<SpillStore> spill_store_;
+  // The rows of the spill store dropped for the ttl
+  int64_t spill_expired_ = 0;
   std::unordered_map<uint64_t, ReservoirValue<float>> pull_reservoir_;
   std::unique_ptr<framework::RWLock> rwlock_{nullptr};
 };
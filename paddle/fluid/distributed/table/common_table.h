@@ -60,7 +60,8 @@ struct ReservoirValue {
   }
 
   void reset() {
-    values.resize(dim, 0);
+    values.resize(dim);
+    std::fill(values.begin(), values.end(), 0);
     counter = 0;
   }
 };
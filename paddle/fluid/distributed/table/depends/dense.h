@@ -23,6 +23,7 @@
 #include <vector>
 
 #include "paddle/fluid/distributed/common/utils.h"
+#include "paddle/fluid/distributed/table/depends/optimizer_kernels.h"
 
 namespace paddle {
 namespace distributed {
@@ -34,6 +35,11 @@ class DenseOptimizer {
   DenseOptimizer() {}
   explicit DenseOptimizer(const CommonAccessorParameter& accessor,
                           std::vector<std::vector<float>>* values) {}
+  // Called once for each push before the updates of its shards, e.g. to
+  // update the states shared by all the shards.
+  virtual void begin_update() {}
+  // Update [begin, end) of the param, which is called by the threads of
+  // different shards concurrently.
   virtual void update(const float* update_values, size_t num, int begin,
                       int end) = 0;
 };
@@ -53,9 +59,7 @@ class DSUM : public DenseOptimizer {
 
   void update(const float* update_values, size_t num, int begin,
               int end) override {
-    auto update_numel = end - begin;
-    GetBlas<float>().VADD(update_numel, update_values + begin, param + begin,
-                          param + begin);
+    SumRowUpdate(end - begin, update_values + begin, param + begin);
   }
 
   float* param;
@@ -79,14 +83,8 @@ class DSGD : public DenseOptimizer {
 
   void update(const float* update_values, size_t num, int begin,
               int end) override {
-    auto update_numel = end - begin;
-    std::vector<float> grads;
-    grads.resize(update_numel);
-
-    auto blas = GetBlas<float>();
-    blas.VCOPY(update_numel, update_values + begin, grads.data());
-    blas.SCAL(update_numel, *learning_rate, grads.data());
-    blas.VSUB(update_numel, param + begin, grads.data(), param + begin);
+    SGDRowUpdate(end - begin, *learning_rate, update_values + begin,
+                 param + begin);
   }
 
   float* learning_rate;
@@ -120,48 +118,24 @@ class DAdam : public DenseOptimizer {
       }
     }
 
-    // add attr later
-    beta1 = 0.9;
-    beta2 = 0.999;
-    epsilon = 1.0e-8;
+    beta1 = GetOptimizerAttr(accessor, "beta1", 0.9);
+    beta2 = GetOptimizerAttr(accessor, "beta2", 0.999);
+    epsilon = GetOptimizerAttr(accessor, "epsilon", 1.0e-8);
   }
 
-  void update(const float* update_values, size_t num, int begin,
-              int end) override {
-    auto update_numel = end - begin;
-    std::vector<float> grad, grad2, tmp;
-    grad.resize(update_numel);
-    grad2.resize(update_numel);
-    tmp.resize(update_numel);
-
-    auto blas = GetBlas<float>();
-    blas.VCOPY(update_numel, update_values + begin, grad.data());
-    blas.VCOPY(update_numel, update_values + begin, grad2.data());
-
-    blas.SCAL(update_numel, 1 - beta1, grad.data());
-    blas.VSQUARE(update_numel, grad2.data(), grad2.data());
-    blas.SCAL(update_numel, 1 - beta2, grad2.data());
-
-    blas.SCAL(update_numel, beta1, moment1 + begin);
-    blas.VADD(update_numel, moment1 + begin, grad.data(), moment1 + begin);
-    blas.SCAL(update_numel, beta2, moment2 + begin);
-    blas.VADD(update_numel, moment2 + begin, grad2.data(), moment2 + begin);
-
+  void begin_update() override {
     beta1_pow[0] = beta1_pow[0] * beta1;
     beta2_pow[0] = beta2_pow[0] * beta2;
 
-    float lr_ = learning_rate[0];
+    lr_ = learning_rate[0];
     lr_ *= sqrt(1 - beta2_pow[0]) / (1 - beta1_pow[0]);
+    eps_ = epsilon * sqrt(1 - beta2_pow[0]);
+  }
 
-    float* tmp_ = tmp.data();
-    float eps_ = epsilon * sqrt(1 - beta2_pow[0]);
-
-    SQRT<float>(update_numel, moment2 + begin, tmp_);
-    ADD<float>(update_numel, tmp_, eps_, tmp_);
-
-    blas.VDIV(update_numel, moment1 + begin, tmp_, tmp_);
-    blas.SCAL(update_numel, lr_, tmp_);
-    blas.VSUB(update_numel, param + begin, tmp_, param + begin);
+  void update(const float* update_values, size_t num, int begin,
+              int end) override {
+    AdamRowUpdate(end - begin, lr_, beta1, beta2, eps_, update_values + begin,
+                  param + begin, moment1 + begin, moment2 + begin);
   }
 
   float* learning_rate;
@@ -176,6 +150,11 @@ class DAdam : public DenseOptimizer {
   float beta1;
   float beta2;
   float epsilon;
+
+  // The learning rate and epsilon of the current push corrected by the
+  // powers of the betas.
+  float lr_;
+  float eps_;
 };
 
 }  // namespace distributed
@@ -0,0 +1,328 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/string/string_helper.h"
+
+namespace paddle {
+namespace distributed {
+
+// The count-min sketch of the frequencies of the keys, in depth rows of width
+// saturated 16-bit counters. All the counters are halved after every
+// 8 * width additions, so that the estimations follow the recent frequencies
+// instead of the whole history.
+class CountMinSketch {
+ public:
+  CountMinSketch(int width, int depth)
+      : width_(width),
+        depth_(depth),
+        decay_period_(8 * static_cast<int64_t>(width)) {
+    PADDLE_ENFORCE_GT(width, 0, platform::errors::InvalidArgument(
+                                    "The width of the count-min sketch "
+                                    "should be positive, but received %d.",
+                                    width));
+    PADDLE_ENFORCE_GT(depth, 0, platform::errors::InvalidArgument(
+                                    "The depth of the count-min sketch "
+                                    "should be positive, but received %d.",
+                                    depth));
+    counters_.resize(static_cast<size_t>(width) * depth, 0);
+  }
+
+  // Add an occurrence of key and return the estimated count of key including
+  // this occurrence. Only the least counters of key are increased, i.e. the
+  // conservative update, which reduces the overestimation.
+  uint32_t Add(uint64_t key) {
+    uint64_t hash = Hash(key);
+    uint32_t count = Estimate(hash);
+    if (count < kMaxCount) {
+      for (int i = 0; i < depth_; ++i) {
+        auto &counter = counters_[Index(i, hash)];
+        if (counter == count) {
+          ++counter;
+        }
+      }
+      ++count;
+    }
+    if (++additions_ >= decay_period_) {
+      Decay();
+    }
+    return count;
+  }
+
+  // The estimated count of key, which is never less than the real count
+  // since the last decay.
+  uint32_t Count(uint64_t key) const { return Estimate(Hash(key)); }
+
+  void Decay() {
+    for (auto &counter : counters_) {
+      counter >>= 1;
+    }
+    additions_ = 0;
+  }
+
+ private:
+  static constexpr uint32_t kMaxCount = 0xffff;
+
+  // The finalizer of splitmix64, whose halves are the two hashes combined
+  // for the rows.
+  static uint64_t Hash(uint64_t key) {
+    key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+    return key ^ (key >> 31);
+  }
+
+  size_t Index(int row, uint64_t hash) const {
+    uint32_t h1 = static_cast<uint32_t>(hash);
+    uint32_t h2 = static_cast<uint32_t>(hash >> 32) | 1;
+    return static_cast<size_t>(row) * width_ + (h1 + row * h2) % width_;
+  }
+
+  uint32_t Estimate(uint64_t hash) const {
+    uint32_t count = kMaxCount;
+    for (int i = 0; i < depth_; ++i) {
+      count = std::min<uint32_t>(count, counters_[Index(i, hash)]);
+    }
+    return count;
+  }
+
+  int width_;
+  int depth_;
+  int64_t decay_period_;
+  int64_t additions_ = 0;
+  std::vector<uint16_t> counters_;
+};
+
+// Whether to create the rows for the keys not in a sparse table yet. The
+// policies are not thread-safe, each ValueBlock owns its own.
+class EntryPolicy {
+ public:
+  virtual ~EntryPolicy() {}
+  // Called on every occurrence of key not in the table.
+  virtual bool Admit(uint64_t key) = 0;
+  // Whether key would be admitted now, without counting another occurrence.
+  // Called for the keys pushed to but no longer in the table, e.g. evicted
+  // since their pulls.
+  virtual bool Admitted(uint64_t key) = 0;
+};
+
+class NoneEntry : public EntryPolicy {
+ public:
+  bool Admit(uint64_t key) override { return true; }
+  bool Admitted(uint64_t key) override { return true; }
+};
+
+// Admit the keys once they occur threshold times, counted by a count-min
+// sketch so that no row is created for the keys occurring only a few times.
+class CountFilterEntry : public EntryPolicy {
+ public:
+  static constexpr int kDefaultSketchWidth = 1 << 16;
+  static constexpr int kSketchDepth = 4;
+
+  explicit CountFilterEntry(int threshold,
+                            int sketch_width = kDefaultSketchWidth)
+      : threshold_(threshold), sketch_(sketch_width, kSketchDepth) {}
+
+  bool Admit(uint64_t key) override {
+    return static_cast<int>(sketch_.Add(key)) >= threshold_;
+  }
+
+  bool Admitted(uint64_t key) override {
+    return static_cast<int>(sketch_.Count(key)) >= threshold_;
+  }
+
+ private:
+  int threshold_;
+  CountMinSketch sketch_;
+};
+
+// Admit every occurrence of the keys with probability.
+class ProbabilityEntry : public EntryPolicy {
+ public:
+  explicit ProbabilityEntry(float probability) : probability_(probability) {}
+
+  bool Admit(uint64_t key) override { return dist_(engine_) < probability_; }
+
+  // The outcome of the pull is not kept, so it is drawn again.
+  bool Admitted(uint64_t key) override { return Admit(key); }
+
+ private:
+  float probability_;
+  std::minstd_rand engine_;
+  std::uniform_real_distribution<float> dist_{0.0f, 1.0f};
+};
+
+// The entry policy of the config "none", "count_filter&<threshold>" with the
+// optional width of the sketch "count_filter&<threshold>&<sketch_width>", or
+// "probability&<p>".
+inline std::unique_ptr<EntryPolicy> CreateEntryPolicy(
+    const std::string &config) {
+  auto slices = string::split_string<std::string>(config, "&");
+  if (slices[0] == "none") {
+    return std::unique_ptr<EntryPolicy>(new NoneEntry());
+  }
+  if (slices[0] == "count_filter" &&
+      (slices.size() == 2 || slices.size() == 3)) {
+    int threshold = std::stoi(slices[1]);
+    int width = CountFilterEntry::kDefaultSketchWidth;
+    if (slices.size() == 3) {
+      width = std::stoi(slices[2]);
+    }
+    return std::unique_ptr<EntryPolicy>(new CountFilterEntry(threshold, width));
+  }
+  if (slices[0] == "probability" && slices.size() == 2) {
+    return std::unique_ptr<EntryPolicy>(
+        new ProbabilityEntry(std::stof(slices[1])));
+  }
+  PADDLE_THROW(platform::errors::InvalidArgument(
+      "The entry %s of the sparse table is not supported.", config));
+}
+
+enum class EvictionType { kNone, kLFU, kLRU };
+
+// The eviction of the rows of a sparse table, in the config "none" or
+// "<lfu|lru>&<memory_mb>&<ttl_days>". Once the estimated memory of the rows
+// exceeds memory_mb, the least frequently (lfu) or the least recently (lru)
+// pulled rows are evicted. The pull counts of lfu are halved on every shrink
+// of the table, so that the rows once hot are evicted after they cool down.
+// The rows not pulled in ttl_days shrinks of the table are dropped. Either
+// limit of 0 is disabled.
+struct EvictionConfig {
+  EvictionType type = EvictionType::kNone;
+  int64_t memory_bytes = 0;
+  int ttl_days = 0;
+};
+
+inline EvictionConfig ParseEvictionConfig(const std::string &config) {
+  EvictionConfig eviction;
+  auto slices = string::split_string<std::string>(config, "&");
+  if (slices[0] == "none") {
+    return eviction;
+  }
+  PADDLE_ENFORCE_EQ((slices[0] == "lfu" || slices[0] == "lru") &&
+                        slices.size() == 3,
+                    true, platform::errors::InvalidArgument(
+                              "The eviction %s of the sparse table is not "
+                              "supported.",
+                              config));
+  eviction.type = slices[0] == "lfu" ? EvictionType::kLFU : EvictionType::kLRU;
+  eviction.memory_bytes = std::stoll(slices[1]) << 20;
+  eviction.ttl_days = std::stoi(slices[2]);
+  return eviction;
+}
+
+// The entry metadata of a row, which is kept with its values in the spill
+// store, so that a row loaded back keeps its pull count and keeps aging for
+// the ttl.
+struct EntryMeta {
+  int count = 1;
+  // The days the row has not been pulled.
+  int unseen_days = 0;
+  bool seen_after_last_save = true;
+};
+
+// The store of the rows evicted from the memory, e.g. on the local disk. A
+// store may be shared by the ValueBlocks of a table, so it must be
+// thread-safe.
+class SpillStore {
+ public:
+  virtual ~SpillStore() {}
+  // Write back the values of the evicted row of key with its metadata.
+  virtual void Spill(uint64_t key,
+                     const std::vector<std::vector<float>> &values,
+                     const EntryMeta &meta) = 0;
+  // Take the values of key with its metadata out of the store, or return
+  // false if key is not in the store. The unseen days of the metadata
+  // include the shrinks of the store since the row was spilled.
+  virtual bool Load(uint64_t key, std::vector<std::vector<float>> *values,
+                    EntryMeta *meta) = 0;
+  virtual bool Contains(uint64_t key) = 0;
+  // Take the values of the keys with their metadata out of the store at
+  // once. The values of the keys not in the store are empty.
+  virtual void LoadBatch(const std::vector<uint64_t> &keys,
+                         std::vector<std::vector<std::vector<float>>> *values,
+                         std::vector<EntryMeta> *metas) {
+    values->resize(keys.size());
+    metas->resize(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+      if (!Load(keys[i], &(*values)[i], &(*metas)[i])) {
+        (*values)[i].clear();
+      }
+    }
+  }
+  // Age the rows in the store by a day, and drop the rows not pulled for
+  // more than ttl_days, the same as the rows in memory. Return the number of
+  // the rows dropped.
+  virtual int64_t Shrink(int ttl_days) = 0;
+  // Call func with every row in the store, e.g. to save the table.
+  virtual void ForEach(
+      const std::function<void(uint64_t,
+                               const std::vector<std::vector<float>> &)>
+          &func) = 0;
+};
+
+struct EntryStats {
+  // The rows created for the new keys admitted by the entry policy.
+  int64_t admitted = 0;
+  // The occurrences of the new keys not admitted.
+  int64_t filtered = 0;
+  // The grads pushed to the keys not admitted, which are dropped.
+  int64_t dropped = 0;
+  // The rows evicted without a spill store since the pull, and created
+  // again by the initializers on push.
+  int64_t readmitted = 0;
+  // The rows evicted for the memory budget, including the spilled ones.
+  int64_t evicted = 0;
+  // The evicted rows written back to the spill store.
+  int64_t spilled = 0;
+  // The rows loaded back from the spill store.
+  int64_t reloaded = 0;
+  // The rows dropped for the ttl.
+  int64_t expired = 0;
+
+  EntryStats &operator+=(const EntryStats &other) {
+    admitted += other.admitted;
+    filtered += other.filtered;
+    dropped += other.dropped;
+    readmitted += other.readmitted;
+    evicted += other.evicted;
+    spilled += other.spilled;
+    reloaded += other.reloaded;
+    expired += other.expired;
+    return *this;
+  }
+
+  std::string ToString() const {
+    std::stringstream ss;
+    ss << "admitted: " << admitted << ", filtered: " << filtered
+       << ", dropped: " << dropped << ", readmitted: " << readmitted
+       << ", evicted: " << evicted
+       << ", spilled: " << spilled
+       << ", reloaded: " << reloaded << ", expired: " << expired;
+    return ss.str();
+  }
+};
+
+}  // namespace distributed
+}  // namespace paddle
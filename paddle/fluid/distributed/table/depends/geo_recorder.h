@@ -15,18 +15,91 @@
 #pragma once
 
 #include <ThreadPool.h>
+#include <algorithm>
 #include <functional>
 #include <future>  // NOLINT
+#include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
 namespace paddle {
 namespace distributed {
 
+// A set of rows, stored as in a roaring bitmap: the rows are grouped by their
+// high 48 bits, and the low 16 bits of the rows of a group are kept in a
+// sorted array while the group is sparse, or in a bitmap of 2^16 bits once it
+// has more than kMaxArraySize rows. A group costs 2 bytes per row at most,
+// instead of a node of an unordered_set per row.
+class RowBitmap {
+ public:
+  void Insert(uint64_t row) {
+    auto& container = containers_[row >> 16];
+    uint16_t low = static_cast<uint16_t>(row & 0xFFFF);
+    if (!container.bits.empty()) {
+      uint64_t mask = 1ULL << (low & 63);
+      if ((container.bits[low >> 6] & mask) == 0) {
+        container.bits[low >> 6] |= mask;
+        ++size_;
+      }
+      return;
+    }
+
+    auto& array = container.array;
+    auto it = std::lower_bound(array.begin(), array.end(), low);
+    if (it != array.end() && *it == low) {
+      return;
+    }
+    array.insert(it, low);
+    ++size_;
+    if (array.size() > kMaxArraySize) {
+      container.bits.assign(kBitmapWords, 0);
+      for (auto value : array) {
+        container.bits[value >> 6] |= 1ULL << (value & 63);
+      }
+      std::vector<uint16_t>().swap(array);
+    }
+  }
+
+  size_t Size() const { return size_; }
+
+  // Append the rows to result in ascending order, and clear the set.
+  void GetAndClear(std::vector<uint64_t>* result) {
+    result->reserve(result->size() + size_);
+    for (auto& iter : containers_) {
+      uint64_t high = iter.first << 16;
+      auto& container = iter.second;
+      for (auto value : container.array) {
+        result->push_back(high | value);
+      }
+      for (size_t i = 0; i < container.bits.size(); ++i) {
+        uint64_t word = container.bits[i];
+        while (word != 0) {
+          result->push_back(high | (i << 6) | __builtin_ctzll(word));
+          word &= word - 1;
+        }
+      }
+    }
+    containers_.clear();
+    size_ = 0;
+  }
+
+ private:
+  static constexpr size_t kMaxArraySize = 4096;
+  static constexpr size_t kBitmapWords = (1 << 16) / 64;
+
+  struct Container {
+    std::vector<uint16_t> array;
+    // Not empty once the container is converted to a bitmap.
+    std::vector<uint64_t> bits;
+  };
+
+  std::map<uint64_t, Container> containers_;
+  size_t size_ = 0;
+};
+
 class ConcurrentSet {
  public:
   ConcurrentSet() : pool_(new ::ThreadPool(1)) {}
@@ -35,7 +108,7 @@ class ConcurrentSet {
   std::future<void> Update(const std::vector<uint64_t>& rows) {
     auto task = [this, rows] {
       for (auto row : rows) {
-        set_.insert(row);
+        set_.Insert(row);
       }
     };
     return pool_->enqueue(std::move(task));
@@ -44,16 +117,13 @@ class ConcurrentSet {
   std::future<void> GetAndClear(std::vector<uint64_t>* result) {
     auto task = [this, &result] {
       result->clear();
-      for (auto& id : set_) {
-        result->push_back(id);
-      }
-      set_.clear();
+      set_.GetAndClear(result);
     };
     return pool_->enqueue(std::move(task));
   }
 
  private:
-  std::unordered_set<uint64_t> set_;
+  RowBitmap set_;
   std::unique_ptr<::ThreadPool> pool_{nullptr};
 };
 
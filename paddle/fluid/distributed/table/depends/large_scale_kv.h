@@ -16,6 +16,7 @@
 
 #include <ThreadPool.h>
 #include <gflags/gflags.h>
+#include <algorithm>
 #include <functional>
 #include <future>  // NOLINT
 #include <memory>
@@ -27,6 +28,8 @@
 #include <vector>
 
 #include "paddle/fluid/distributed/common/utils.h"
+#include "paddle/fluid/distributed/ps.pb.h"
+#include "paddle/fluid/distributed/table/depends/entry_eviction.h"
 #include "paddle/fluid/distributed/table/depends/initializers.h"
 #include "paddle/fluid/framework/generator.h"
 #include "paddle/fluid/framework/lod_tensor.h"
@@ -47,28 +50,13 @@ namespace distributed {
 
 enum Mode { training, infer };
 
-template <typename T>
-inline bool entry(const int count, const T threshold);
-
-template <>
-inline bool entry<std::string>(const int count, const std::string threshold) {
-  return true;
-}
-
-template <>
-inline bool entry<int>(const int count, const int threshold) {
-  return count >= threshold;
-}
-
-template <>
-inline bool entry<float>(const int count, const float threshold) {
-  UniformInitializer uniform = UniformInitializer({"0", "0", "1"});
-  return uniform.GetValue() >= threshold;
-}
-
 struct VALUE {
   explicit VALUE(const std::vector<std::string> &names)
-      : names_(names), count_(1), unseen_days_(0), seen_after_last_save_(true) {
+      : names_(names),
+        count_(1),
+        unseen_days_(0),
+        seen_after_last_save_(true),
+        last_access_(0) {
     values_.resize(names.size());
     for (int i = 0; i < static_cast<int>(names.size()); i++) {
       places[names[i]] = i;
@@ -109,10 +97,6 @@ struct VALUE {
   int fetch_count() { return ++count_; }
   void reset_unseen_days() { unseen_days_ = 0; }
 
-  void set_entry(bool is_entry) { is_entry_ = is_entry; }
-
-  bool get_entry() { return is_entry_; }
-
   std::vector<std::vector<float> *> get(const std::vector<std::string> names) {
     auto pts = std::vector<std::vector<float> *>();
     pts.reserve(values_.size());
@@ -127,16 +111,23 @@ struct VALUE {
   int count_;
   int unseen_days_;
   bool seen_after_last_save_;
-  bool is_entry_;
+  // The pull clock of the ValueBlock at the last pull, for the lru eviction.
+  uint64_t last_access_;
   std::vector<std::vector<float>> values_;
   std::unordered_map<std::string, int> places;
 };
 
+// A shard of the rows of a sparse table. The new keys are admitted by the
+// entry policy of the table, and the rows are evicted by the eviction of the
+// table with the memory budget of the table split evenly among block_num
+// blocks. A ValueBlock is not thread-safe, each is accessed by a single
+// thread of the table at a time.
 class ValueBlock {
  public:
   explicit ValueBlock(
       const CommonAccessorParameter &common,
-      std::unordered_map<std::string, Initializer *> *initializers) {
+      std::unordered_map<std::string, Initializer *> *initializers,
+      int block_num = 1) {
     initializers_ = initializers;
     int size = static_cast<int>(common.params().size());
 
@@ -151,30 +142,19 @@ class ValueBlock {
       initializer_list_.emplace_back(initializers_->at(name));
     }
 
-    // for Entry
-    {
-      // entry will add later
-      std::string entry_attr = "none";
-      if (entry_attr == "none") {
-        has_entry = false;
-        entry_func_ =
-            std::bind(entry<std::string>, std::placeholders::_1, "none");
-      } else {
-        has_entry = true;
-        auto slices = string::split_string<std::string>(entry_attr, "&");
-        if (slices[0] == "count_filter") {
-          int threshold = std::stoi(slices[1]);
-          entry_func_ = std::bind(entry<int>, std::placeholders::_1, threshold);
-        } else if (slices[0] == "probability") {
-          float threshold = std::stof(slices[1]);
-          entry_func_ =
-              std::bind(entry<float>, std::placeholders::_1, threshold);
-        }
-      }
+    entry_ = CreateEntryPolicy(common.entry());
+    eviction_ = ParseEvictionConfig(common.eviction());
+    if (eviction_.type != EvictionType::kNone && eviction_.memory_bytes > 0) {
+      max_rows_ = std::max<int64_t>(
+          eviction_.memory_bytes / block_num / RowBytes(), 1);
     }
   }
 
-  ~ValueBlock() {}
+  ~ValueBlock() {
+    for (auto &item : values_) {
+      delete item.second;
+    }
+  }
 
   void Init(const uint64_t &id, std::vector<std::vector<float>> *values,
             int count) {
@@ -187,11 +167,10 @@ class ValueBlock {
           platform::errors::AlreadyExists("values can not match, error"));
     }
 
-    auto value = new VALUE(value_names_);
+    auto value = Insert(id);
     value->set(values);
     value->seen_after_last_save_ = true;
     value->count_ = count;
-    values_[id] = value;
   }
 
   void Init(const uint64_t &id, const std::vector<Initializer *> &inits,
@@ -205,9 +184,8 @@ class ValueBlock {
           platform::errors::AlreadyExists("values can not match, error"));
     }
 
-    auto value = new VALUE(value_names_);
+    auto value = Insert(id);
     value->set(inits, value_dims_);
-    values_[id] = value;
   }
 
   std::vector<std::vector<float> *> Get(
@@ -221,40 +199,226 @@ class ValueBlock {
     return ret_values;
   }
 
+  // The values of id, whose values_ are in the order of the params of the
+  // table, or nullptr if id is not in the block.
+  VALUE *GetValue(const uint64_t &id) {
+    auto got = values_.find(id);
+    return got == values_.end() ? nullptr : got->second;
+  }
+
+  // The values of id to pull. A new id is loaded back from the spill store,
+  // or created by the initializers if it is admitted by the entry policy.
+  // Return nullptr if id is not admitted.
+  VALUE *InitGet(const uint64_t &id) {
+    auto got = values_.find(id);
+    if (got != values_.end()) {
+      Touch(got->second);
+      return got->second;
+    }
+
+    if (spill_store_ != nullptr) {
+      std::vector<std::vector<float>> spilled;
+      EntryMeta meta;
+      if (spill_store_->Load(id, &spilled, &meta)) {
+        auto *value = Restore(id, &spilled, meta);
+        Touch(value);
+        return value;
+      }
+    }
+
+    if (!entry_->Admit(id)) {
+      ++stats_.filtered;
+      return nullptr;
+    }
+    auto *value = Insert(id);
+    value->set(initializer_list_, value_dims_);
+    ++stats_.admitted;
+    return value;
+  }
+
+  // The values of id to push the grad to. A row evicted since its pull is
+  // loaded back from the spill store, or created again by the initializers
+  // if the entry policy still admits id, so that the grad is not lost. They
+  // are inserted without evicting other rows, since the values of the other
+  // keys of the push are already looked up, so the block may exceed max_rows
+  // until the next pull. Return nullptr if id is not admitted, whose grad is
+  // dropped.
+  VALUE *GetPushValue(const uint64_t &id) {
+    auto *value = GetValue(id);
+    if (value != nullptr) {
+      return value;
+    }
+    if (spill_store_ != nullptr) {
+      std::vector<std::vector<float>> spilled;
+      EntryMeta meta;
+      if (spill_store_->Load(id, &spilled, &meta)) {
+        return Restore(id, &spilled, meta, false);
+      }
+    }
+    // Without eviction the rows are never removed, so id was not admitted.
+    if (eviction_.type != EvictionType::kNone && entry_->Admitted(id)) {
+      value = Insert(id, false);
+      value->set(initializer_list_, value_dims_);
+      ++stats_.readmitted;
+      return value;
+    }
+    ++stats_.dropped;
+    return nullptr;
+  }
+
+  // Put back the values of id taken out of the spill store with its
+  // metadata, so that the row keeps its count and keeps aging. The block
+  // evicts other rows first if it is full and evict is true.
+  VALUE *Restore(const uint64_t &id, std::vector<std::vector<float>> *values,
+                 const EntryMeta &meta, bool evict = true) {
+    auto got = values_.find(id);
+    if (got != values_.end()) {
+      return got->second;
+    }
+    auto *value = Insert(id, evict);
+    value->set(values);
+    value->count_ = meta.count;
+    value->unseen_days_ = meta.unseen_days;
+    value->seen_after_last_save_ = meta.seen_after_last_save;
+    ++stats_.reloaded;
+    return value;
+  }
+
+  // Load the values of id back from the spill store, or create them by the
+  // initializers regardless of the entry policy, if id is not in the block.
   void InitFromInitializer(const uint64_t &id,
                            const std::vector<std::string> &value_names) {
     if (Has(id)) {
-      if (has_entry) {
-        Update(id);
-      }
+      Update(id);
       return;
     }
+    if (spill_store_ != nullptr) {
+      std::vector<std::vector<float>> spilled;
+      EntryMeta meta;
+      if (spill_store_->Load(id, &spilled, &meta)) {
+        Touch(Restore(id, &spilled, meta));
+        return;
+      }
+    }
     Init(id, initializer_list_, 1);
   }
 
-  bool GetEntry(const uint64_t &id) {
-    auto value = values_.at(id);
-    auto entry = value->get_entry();
-    return entry;
-  }
-
   void Set(const uint64_t &id, const std::vector<std::string> &value_names,
            const std::vector<std::vector<float>> &values) {
     auto value = values_.at(id);
     value->set(value_names, values);
   }
 
-  void Update(const uint64_t id) {
-    auto *value = values_.at(id);
-    value->reset_unseen_days();
-    auto count = value->fetch_count();
+  void Update(const uint64_t id) { Touch(values_.at(id)); }
 
-    if (!value->get_entry()) {
-      value->set_entry(entry_func_(count));
+  // Age the rows by a day, and drop the rows not pulled for more than the ttl
+  // days of the eviction. The pull counts of lfu are halved. The rows in the
+  // spill store are aged by the table, as the store is shared by the blocks.
+  void Shrink() {
+    bool is_lfu = eviction_.type == EvictionType::kLFU;
+    if (eviction_.ttl_days <= 0 && !is_lfu) {
+      return;
     }
+    for (auto it = values_.begin(); it != values_.end();) {
+      auto *value = it->second;
+      if (eviction_.ttl_days > 0 &&
+          ++value->unseen_days_ > eviction_.ttl_days) {
+        delete value;
+        it = values_.erase(it);
+        ++stats_.expired;
+        continue;
+      }
+      if (is_lfu) {
+        value->count_ /= 2;
+      }
+      ++it;
+    }
+  }
+
+  // The store to write back the evicted rows to, and to load them back from
+  // on pull.
+  void SetSpillStore(std::shared_ptr<SpillStore> spill_store) {
+    spill_store_ = std::move(spill_store);
+  }
+
+  const EntryStats &stats() const { return stats_; }
+
+  // The max number of the rows in the block, or 0 if not bounded.
+  int64_t max_rows() const { return max_rows_; }
+
+  // The days a row is kept without pulls, or 0 if forever.
+  int ttl_days() const { return eviction_.ttl_days; }
+
+  // The estimated memory of a row, including the values, the VALUE with its
+  // names and places, and the node of values_.
+  int64_t RowBytes() const {
+    int64_t bytes = sizeof(VALUE) + sizeof(std::pair<uint64_t, VALUE *>) +
+                    2 * sizeof(void *);
+    for (size_t i = 0; i < value_names_.size(); ++i) {
+      bytes += value_dims_[i] * sizeof(float) + sizeof(std::vector<float>);
+      // The name in names_ and in places with the node of places.
+      bytes += 2 * (sizeof(std::string) + value_names_[i].capacity()) +
+               sizeof(int) + 2 * sizeof(void *);
+    }
+    return bytes;
   }
 
  private:
+  // The ratio of the max rows evicted at once when the block is full, so that
+  // the cost of choosing the rows to evict is amortized.
+  static constexpr double kEvictRatio = 0.1;
+
+  void Touch(VALUE *value) {
+    value->reset_unseen_days();
+    value->fetch_count();
+    value->last_access_ = ++clock_;
+  }
+
+  // Add an empty row of id, evicting the rows first if the block is full and
+  // evict is true.
+  VALUE *Insert(const uint64_t &id, bool evict = true) {
+    if (evict && max_rows_ > 0 &&
+        static_cast<int64_t>(values_.size()) >= max_rows_) {
+      Evict(std::max<int64_t>(max_rows_ * kEvictRatio, 1));
+    }
+    auto value = new VALUE(value_names_);
+    value->last_access_ = ++clock_;
+    values_[id] = value;
+    return value;
+  }
+
+  // Evict num rows of the least counts (lfu) or the least recent pulls (lru),
+  // which are written back to the spill store if any.
+  void Evict(int64_t num) {
+    std::vector<std::pair<uint64_t, uint64_t>> scores;
+    scores.reserve(values_.size());
+    for (auto &item : values_) {
+      auto *value = item.second;
+      uint64_t score = eviction_.type == EvictionType::kLFU
+                           ? static_cast<uint64_t>(value->count_)
+                           : value->last_access_;
+      scores.emplace_back(score, item.first);
+    }
+    num = std::min<int64_t>(num, scores.size());
+    std::nth_element(scores.begin(), scores.begin() + num, scores.end());
+    for (int64_t i = 0; i < num; ++i) {
+      auto got = values_.find(scores[i].second);
+      if (spill_store_ != nullptr) {
+        auto *value = got->second;
+        EntryMeta meta;
+        meta.count = value->count_;
+        meta.unseen_days = value->unseen_days_;
+        meta.seen_after_last_save = value->seen_after_last_save_;
+        spill_store_->Spill(got->first, value->values_, meta);
+        ++stats_.spilled;
+      }
+      delete got->second;
+      values_.erase(got);
+    }
+    stats_.evicted += num;
+    VLOG(3) << "evict " << num << " rows, " << values_.size() << " left";
+  }
+
   bool Has(const uint64_t id) {
     auto got = values_.find(id);
     if (got == values_.end()) {
@@ -268,12 +432,17 @@ class ValueBlock {
   std::unordered_map<uint64_t, VALUE *> values_;
 
  private:
-  bool has_entry = false;
   std::vector<std::string> value_names_;
   std::vector<int> value_dims_;
-  std::function<bool(uint64_t)> entry_func_;
   std::unordered_map<std::string, Initializer *> *initializers_;
   std::vector<Initializer *> initializer_list_;
+
+  std::unique_ptr<EntryPolicy> entry_;
+  EvictionConfig eviction_;
+  int64_t max_rows_ = 0;
+  uint64_t clock_ = 0;
+  std::shared_ptr<SpillStore> spill_store_;
+  EntryStats stats_;
 };
 
 }  // namespace distributed
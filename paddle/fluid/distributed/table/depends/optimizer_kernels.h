@@ -0,0 +1,168 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <math.h>
+#include <string>
+
+#include "paddle/fluid/distributed/ps.pb.h"
+#include "paddle/fluid/platform/cpu_info.h"
+#include "paddle/fluid/string/string_helper.h"
+
+namespace paddle {
+namespace distributed {
+
+// The float attribute of the optimizer in the format of name&type&value, or
+// default_value if it is not set.
+inline float GetOptimizerAttr(const CommonAccessorParameter& common,
+                              const std::string& name, float default_value) {
+  for (auto& attr : common.attributes()) {
+    auto slices = string::split_string<std::string>(attr, "&");
+    if (slices.size() == 3 && slices[0] == name) {
+      return std::stof(slices[2]);
+    }
+  }
+  return default_value;
+}
+
+// The row update kernels of the optimizers on the parameter server. Each
+// kernel updates a row of the parameter and its slots in place in a single
+// pass over the gradient, without any temporary buffer.
+
+#ifdef __AVX__
+constexpr int kRowUpdateBlock = 8;
+#endif
+
+// param += grad
+inline void SumRowUpdate(int n, const float* grad, float* param) {
+  int i = 0;
+#ifdef __AVX__
+  for (; i + kRowUpdateBlock <= n; i += kRowUpdateBlock) {
+    _mm256_storeu_ps(param + i, _mm256_add_ps(_mm256_loadu_ps(param + i),
+                                              _mm256_loadu_ps(grad + i)));
+  }
+#endif
+  for (; i < n; ++i) {
+    param[i] += grad[i];
+  }
+}
+
+// param -= lr * grad
+inline void SGDRowUpdate(int n, float lr, const float* grad, float* param) {
+  int i = 0;
+#ifdef __AVX__
+  const __m256 lr_v = _mm256_set1_ps(lr);
+  for (; i + kRowUpdateBlock <= n; i += kRowUpdateBlock) {
+    __m256 g = _mm256_mul_ps(lr_v, _mm256_loadu_ps(grad + i));
+    _mm256_storeu_ps(param + i, _mm256_sub_ps(_mm256_loadu_ps(param + i), g));
+  }
+#endif
+  for (; i < n; ++i) {
+    param[i] -= lr * grad[i];
+  }
+}
+
+// moment1 = beta1 * moment1 + (1 - beta1) * grad
+// moment2 = beta2 * moment2 + (1 - beta2) * grad * grad
+// param -= lr * moment1 / (sqrt(moment2) + epsilon)
+// where lr and epsilon are already corrected by the powers of the betas.
+inline void AdamRowUpdate(int n, float lr, float beta1, float beta2,
+                          float epsilon, const float* grad, float* param,
+                          float* moment1, float* moment2) {
+  int i = 0;
+#ifdef __AVX__
+  const __m256 lr_v = _mm256_set1_ps(lr);
+  const __m256 beta1_v = _mm256_set1_ps(beta1);
+  const __m256 beta2_v = _mm256_set1_ps(beta2);
+  const __m256 one_beta1_v = _mm256_set1_ps(1 - beta1);
+  const __m256 one_beta2_v = _mm256_set1_ps(1 - beta2);
+  const __m256 epsilon_v = _mm256_set1_ps(epsilon);
+  for (; i + kRowUpdateBlock <= n; i += kRowUpdateBlock) {
+    __m256 g = _mm256_loadu_ps(grad + i);
+    __m256 m1 = _mm256_add_ps(
+        _mm256_mul_ps(beta1_v, _mm256_loadu_ps(moment1 + i)),
+        _mm256_mul_ps(one_beta1_v, g));
+    __m256 m2 = _mm256_add_ps(
+        _mm256_mul_ps(beta2_v, _mm256_loadu_ps(moment2 + i)),
+        _mm256_mul_ps(one_beta2_v, _mm256_mul_ps(g, g)));
+    __m256 delta = _mm256_div_ps(
+        _mm256_mul_ps(lr_v, m1), _mm256_add_ps(_mm256_sqrt_ps(m2), epsilon_v));
+    _mm256_storeu_ps(moment1 + i, m1);
+    _mm256_storeu_ps(moment2 + i, m2);
+    _mm256_storeu_ps(param + i,
+                     _mm256_sub_ps(_mm256_loadu_ps(param + i), delta));
+  }
+#endif
+  for (; i < n; ++i) {
+    const float g = grad[i];
+    moment1[i] = beta1 * moment1[i] + (1 - beta1) * g;
+    moment2[i] = beta2 * moment2[i] + (1 - beta2) * g * g;
+    param[i] -= lr * moment1[i] / (sqrtf(moment2[i]) + epsilon);
+  }
+}
+
+// moment += grad * grad
+// param -= lr * grad / (sqrt(moment) + epsilon)
+inline void AdagradRowUpdate(int n, float lr, float epsilon, const float* grad,
+                             float* param, float* moment) {
+  int i = 0;
+#ifdef __AVX__
+  const __m256 lr_v = _mm256_set1_ps(lr);
+  const __m256 epsilon_v = _mm256_set1_ps(epsilon);
+  for (; i + kRowUpdateBlock <= n; i += kRowUpdateBlock) {
+    __m256 g = _mm256_loadu_ps(grad + i);
+    __m256 m = _mm256_add_ps(_mm256_loadu_ps(moment + i), _mm256_mul_ps(g, g));
+    __m256 delta = _mm256_div_ps(_mm256_mul_ps(lr_v, g),
+                                 _mm256_add_ps(_mm256_sqrt_ps(m), epsilon_v));
+    _mm256_storeu_ps(moment + i, m);
+    _mm256_storeu_ps(param + i,
+                     _mm256_sub_ps(_mm256_loadu_ps(param + i), delta));
+  }
+#endif
+  for (; i < n; ++i) {
+    const float g = grad[i];
+    moment[i] += g * g;
+    param[i] -= lr * g / (sqrtf(moment[i]) + epsilon);
+  }
+}
+
+// The FTRL-Proximal update, the same as ftrl_op:
+// new_squared = squared + grad * grad
+// linear += grad - (new_squared^-lr_power - squared^-lr_power) / lr * param
+// param = |linear| > l1 ?
+//     (sign(linear) * l1 - linear) / (new_squared^-lr_power / lr + 2 * l2) : 0
+// squared = new_squared
+inline void FtrlRowUpdate(int n, float lr, float l1, float l2, float lr_power,
+                          const float* grad, float* param, float* squared,
+                          float* linear) {
+  // The common lr_power of -0.5 takes sqrt instead of pow.
+  const bool use_sqrt = lr_power == -0.5f;
+  for (int i = 0; i < n; ++i) {
+    const float g = grad[i];
+    const float s = squared[i];
+    const float new_s = s + g * g;
+    const float new_pow = use_sqrt ? sqrtf(new_s) : powf(new_s, -lr_power);
+    const float old_pow = use_sqrt ? sqrtf(s) : powf(s, -lr_power);
+    const float l = linear[i] + g - (new_pow - old_pow) / lr * param[i];
+    const float x = (l >= 0 ? l1 : -l1) - l;
+    const float y = new_pow / lr + 2 * l2;
+    param[i] = fabsf(l) > l1 ? x / y : 0.0f;
+    linear[i] = l;
+    squared[i] = new_s;
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
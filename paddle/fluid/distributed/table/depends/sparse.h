@@ -24,6 +24,7 @@
 
 #include "paddle/fluid/distributed/common/utils.h"
 #include "paddle/fluid/distributed/table/depends/large_scale_kv.h"
+#include "paddle/fluid/distributed/table/depends/optimizer_kernels.h"
 
 namespace paddle {
 namespace distributed {
@@ -35,6 +36,25 @@ class SparseOptimizer {
   virtual void update(const uint64_t* keys, const float* update_values,
                       size_t num, const std::vector<uint64_t>& offsets,
                       ValueBlock* block) = 0;
+
+ protected:
+  // Look up the values of the keys at offsets of a shard at once before the
+  // row updates, as the pairs of the offset and the values in the order of
+  // the params of the table. The rows evicted since the pull are restored,
+  // and the keys not admitted are skipped and counted as dropped.
+  static const std::vector<std::pair<uint64_t, VALUE*>>& GetValues(
+      const uint64_t* keys, const std::vector<uint64_t>& offsets,
+      ValueBlock* block) {
+    thread_local std::vector<std::pair<uint64_t, VALUE*>> values;
+    values.clear();
+    for (auto offset : offsets) {
+      auto* value = block->GetPushValue(keys[offset]);
+      if (value != nullptr) {
+        values.emplace_back(offset, value);
+      }
+    }
+    return values;
+  }
 };
 
 // sum calc for sparse tensor
@@ -54,16 +74,11 @@ class SSUM : public SparseOptimizer {
   void update(const uint64_t* keys, const float* update_values, size_t num,
               const std::vector<uint64_t>& offsets,
               ValueBlock* block) override {
-    auto blas = GetBlas<float>();
-    for (auto x : offsets) {
-      auto id = keys[x];
-      auto values = block->Get(id);
-      float* param = values[param_idx]->data();
-
-      std::vector<float> delta;
-      delta.resize(update_numel);
-      blas.VCOPY(update_numel, update_values + x * update_numel, delta.data());
-      blas.VADD(update_numel, delta.data(), param, param);
+    auto& values = GetValues(keys, offsets, block);
+    for (auto& row : values) {
+      auto x = row.first;
+      float* param = row.second->values_[param_idx].data();
+      SumRowUpdate(update_numel, update_values + x * update_numel, param);
     }
   }
 
@@ -91,18 +106,14 @@ class SSGD : public SparseOptimizer {
   void update(const uint64_t* keys, const float* update_values, size_t num,
               const std::vector<uint64_t>& offsets,
               ValueBlock* block) override {
-    auto blas = GetBlas<float>();
-    for (auto x : offsets) {
-      auto id = keys[x];
-      auto values = block->Get(id);
-      float* learning_rate = values[learning_rate_idx]->data();
-      float* param = values[param_idx]->data();
-
-      std::vector<float> grads;
-      grads.resize(update_numel);
-      blas.VCOPY(update_numel, update_values + x * update_numel, grads.data());
-      blas.SCAL(update_numel, learning_rate[0], grads.data());
-      blas.VSUB(update_numel, param, grads.data(), param);
+    auto& values = GetValues(keys, offsets, block);
+    for (auto& row : values) {
+      auto x = row.first;
+      auto& value = row.second->values_;
+      float learning_rate = value[learning_rate_idx][0];
+      float* param = value[param_idx].data();
+      SGDRowUpdate(update_numel, learning_rate,
+                   update_values + x * update_numel, param);
     }
   }
 
@@ -139,58 +150,31 @@ class SAdam : public SparseOptimizer {
       }
     }
 
-    // add attr later
-    beta1 = 0.9;
-    beta2 = 0.999;
-    epsilon = 1.0e-8;
+    beta1 = GetOptimizerAttr(common, "beta1", 0.9);
+    beta2 = GetOptimizerAttr(common, "beta2", 0.999);
+    epsilon = GetOptimizerAttr(common, "epsilon", 1.0e-8);
   }
 
   void update(const uint64_t* keys, const float* update_values, size_t num,
               const std::vector<uint64_t>& offsets,
               ValueBlock* block) override {
-    auto blas = GetBlas<float>();
-    for (auto x : offsets) {
-      auto id = keys[x];
-      auto values = block->Get(id);
-      float* learning_rate = values[learning_rate_idx]->data();
-      float* param = values[param_idx]->data();
-      float* moment1 = values[moment1_idx]->data();
-      float* moment2 = values[moment2_idx]->data();
-      float* beta1_pow = values[beta1_pow_idx]->data();
-      float* beta2_pow = values[beta2_pow_idx]->data();
+    auto& values = GetValues(keys, offsets, block);
+    for (auto& row : values) {
+      auto x = row.first;
+      auto& value = row.second->values_;
+      float* beta1_pow = value[beta1_pow_idx].data();
+      float* beta2_pow = value[beta2_pow_idx].data();
 
       beta1_pow[0] = beta1_pow[0] * beta1;
       beta2_pow[0] = beta2_pow[0] * beta2;
 
-      float lr_ = learning_rate[0];
+      float lr_ = value[learning_rate_idx][0];
       lr_ *= sqrt(1 - beta2_pow[0]) / (1 - beta1_pow[0]);
-
-      std::vector<float> grad, grad2, tmp;
-      grad.resize(update_numel);
-      grad2.resize(update_numel);
-      tmp.resize(update_numel);
-
-      blas.VCOPY(update_numel, update_values + x * update_numel, grad.data());
-      blas.VCOPY(update_numel, update_values + x * update_numel, grad2.data());
-
-      blas.SCAL(update_numel, 1 - beta1, grad.data());
-      blas.VSQUARE(update_numel, grad2.data(), grad2.data());
-      blas.SCAL(update_numel, 1 - beta2, grad2.data());
-
-      blas.SCAL(update_numel, beta1, moment1);
-      blas.VADD(update_numel, moment1, grad.data(), moment1);
-      blas.SCAL(update_numel, beta2, moment2);
-      blas.VADD(update_numel, moment2, grad2.data(), moment2);
-
-      float* tmp_ = tmp.data();
       float eps_ = epsilon * sqrt(1 - beta2_pow[0]);
 
-      SQRT<float>(update_numel, moment2, tmp_);
-      ADD<float>(update_numel, tmp_, eps_, tmp_);
-
-      blas.VDIV(update_numel, moment1, tmp_, tmp_);
-      blas.SCAL(update_numel, lr_, tmp_);
-      blas.VSUB(update_numel, param, tmp_, param);
+      AdamRowUpdate(update_numel, lr_, beta1, beta2, eps_,
+                    update_values + x * update_numel, value[param_idx].data(),
+                    value[moment1_idx].data(), value[moment2_idx].data());
     }
   }
 
@@ -206,5 +190,98 @@ class SAdam : public SparseOptimizer {
   int update_numel;
 };
 
+// adagrad optimzer for sparse tensor
+class SAdagrad : public SparseOptimizer {
+ public:
+  SAdagrad() {}
+  explicit SAdagrad(const CommonAccessorParameter& common) {
+    auto& names = common.params();
+    for (int x = 0; x < static_cast<int>(names.size()); ++x) {
+      if (names[x] == "LearningRate") {
+        learning_rate_idx = x;
+      }
+      if (names[x] == "Param") {
+        param_idx = x;
+        update_numel = common.dims()[x];
+      }
+      if (names[x] == "Moment") {
+        moment_idx = x;
+      }
+    }
+
+    epsilon = GetOptimizerAttr(common, "epsilon", 1.0e-6);
+  }
+
+  void update(const uint64_t* keys, const float* update_values, size_t num,
+              const std::vector<uint64_t>& offsets,
+              ValueBlock* block) override {
+    auto& values = GetValues(keys, offsets, block);
+    for (auto& row : values) {
+      auto x = row.first;
+      auto& value = row.second->values_;
+      AdagradRowUpdate(update_numel, value[learning_rate_idx][0], epsilon,
+                       update_values + x * update_numel,
+                       value[param_idx].data(), value[moment_idx].data());
+    }
+  }
+
+  int learning_rate_idx;
+  int param_idx;
+  int moment_idx;
+  float epsilon;
+  int update_numel;
+};
+
+// ftrl optimzer for sparse tensor
+class SFtrl : public SparseOptimizer {
+ public:
+  SFtrl() {}
+  explicit SFtrl(const CommonAccessorParameter& common) {
+    auto& names = common.params();
+    for (int x = 0; x < static_cast<int>(names.size()); ++x) {
+      if (names[x] == "LearningRate") {
+        learning_rate_idx = x;
+      }
+      if (names[x] == "Param") {
+        param_idx = x;
+        update_numel = common.dims()[x];
+      }
+      if (names[x] == "SquaredAccumulator") {
+        squared_accum_idx = x;
+      }
+      if (names[x] == "LinearAccumulator") {
+        linear_accum_idx = x;
+      }
+    }
+
+    l1 = GetOptimizerAttr(common, "l1", 0.0);
+    l2 = GetOptimizerAttr(common, "l2", 0.0);
+    lr_power = GetOptimizerAttr(common, "lr_power", -0.5);
+  }
+
+  void update(const uint64_t* keys, const float* update_values, size_t num,
+              const std::vector<uint64_t>& offsets,
+              ValueBlock* block) override {
+    auto& values = GetValues(keys, offsets, block);
+    for (auto& row : values) {
+      auto x = row.first;
+      auto& value = row.second->values_;
+      FtrlRowUpdate(update_numel, value[learning_rate_idx][0], l1, l2,
+                    lr_power, update_values + x * update_numel,
+                    value[param_idx].data(), value[squared_accum_idx].data(),
+                    value[linear_accum_idx].data());
+    }
+  }
+
+  int learning_rate_idx;
+  int param_idx;
+  int squared_accum_idx;
+  int linear_accum_idx;
+  float l1;
+  float l2;
+  float lr_power;
+  int update_numel;
+};
+
 }  // namespace distributed
 }  // namespace paddle
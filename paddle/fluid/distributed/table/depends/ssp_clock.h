@@ -0,0 +1,108 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "bthread/condition_variable.h"
+#include "bthread/mutex.h"
+
+namespace paddle {
+namespace distributed {
+
+// The clocks of the workers of a table for the stale synchronous parallel
+// mode. A worker ticks its clock once it has pushed the updates of a step,
+// and waits before a pull while its clock is more than staleness steps ahead
+// of the slowest worker, so the values it pulls miss the updates of at most
+// staleness steps of any other worker. A staleness of 0 is the bulk
+// synchronous mode, but the fast workers do not wait at a barrier every step.
+// The finished workers no longer hold back the others. Wait is called by the
+// brpc handlers, so it waits on a bthread condition, which does not block the
+// worker pthread of the server, and the waiting trainers need no more server
+// threads than the others.
+class SspClock {
+ public:
+  SspClock(int worker_num, int staleness)
+      : staleness_(staleness),
+        clocks_(worker_num, 0),
+        finished_(worker_num, false) {}
+
+  // Advance the clock of the worker by steps, or mark it finished if steps is
+  // negative.
+  void Tick(uint32_t worker_id, int steps) {
+    std::lock_guard<bthread::Mutex> lock(mutex_);
+    if (worker_id >= clocks_.size()) {
+      return;
+    }
+    if (steps < 0) {
+      finished_[worker_id] = true;
+    } else {
+      clocks_[worker_id] += steps;
+    }
+    cv_.notify_all();
+  }
+
+  // Block until the worker is at most staleness steps ahead of the slowest
+  // unfinished worker. Return the steps the worker was ahead of it.
+  int64_t Wait(uint32_t worker_id) {
+    std::unique_lock<bthread::Mutex> lock(mutex_);
+    if (worker_id >= clocks_.size()) {
+      return 0;
+    }
+    while (!finished_[worker_id] &&
+           clocks_[worker_id] - MinClock() > staleness_) {
+      cv_.wait(lock);
+    }
+    return std::max<int64_t>(clocks_[worker_id] - MinClock(), 0);
+  }
+
+  int64_t clock(uint32_t worker_id) {
+    std::lock_guard<bthread::Mutex> lock(mutex_);
+    return clocks_[worker_id];
+  }
+
+  int64_t min_clock() {
+    std::lock_guard<bthread::Mutex> lock(mutex_);
+    return MinClock();
+  }
+
+  int staleness() const { return staleness_; }
+
+ private:
+  // The clock of the slowest unfinished worker, or the max of int64_t if all
+  // of them have finished.
+  int64_t MinClock() const {
+    int64_t min_clock = std::numeric_limits<int64_t>::max();
+    for (size_t i = 0; i < clocks_.size(); ++i) {
+      if (!finished_[i]) {
+        min_clock = std::min(min_clock, clocks_[i]);
+      }
+    }
+    return min_clock;
+  }
+
+  const int staleness_;
+  bthread::Mutex mutex_;
+  bthread::ConditionVariable cv_;
+  std::vector<int64_t> clocks_;
+  std::vector<bool> finished_;
+};
+
+}  // namespace distributed
+}  // namespace paddle
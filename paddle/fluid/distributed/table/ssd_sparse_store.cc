@@ -0,0 +1,461 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/table/ssd_sparse_store.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <utility>
+
+#include "glog/logging.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/port.h"
+#include "paddle/fluid/string/printf.h"
+
+namespace paddle {
+namespace distributed {
+
+// The records appended are written to the segment once they exceed this.
+constexpr int64_t kWriteBufferBytes = 1 << 20;
+// The max bytes read at once by a pread of the adjacent records.
+constexpr int64_t kMaxReadBytes = 1 << 20;
+
+// The entry metadata in a record, after the key.
+struct RecordMeta {
+  int32_t count;
+  int32_t unseen_days;
+  int32_t seen_after_last_save;
+};
+constexpr int64_t kRecordHeaderBytes = sizeof(uint64_t) + sizeof(RecordMeta);
+
+// The metadata of the record, with the aged unseen days of the index.
+static EntryMeta ReadRecordMeta(const char* record, int unseen_days) {
+  RecordMeta record_meta;
+  memcpy(&record_meta, record + sizeof(uint64_t), sizeof(RecordMeta));
+  EntryMeta meta;
+  meta.count = record_meta.count;
+  meta.unseen_days = unseen_days;
+  meta.seen_after_last_save = record_meta.seen_after_last_save != 0;
+  return meta;
+}
+
+static void PWriteAll(int fd, const char* data, int64_t bytes, int64_t offset,
+                      const std::string& path) {
+  while (bytes > 0) {
+    ssize_t n = pwrite(fd, data, bytes, offset);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    PADDLE_ENFORCE_GT(n, 0, platform::errors::Unavailable(
+                                "Failed to write the sparse table segment "
+                                "%s: %s.",
+                                path, strerror(errno)));
+    data += n;
+    bytes -= n;
+    offset += n;
+  }
+}
+
+static void PReadAll(int fd, char* data, int64_t bytes, int64_t offset,
+                     const std::string& path) {
+  while (bytes > 0) {
+    ssize_t n = pread(fd, data, bytes, offset);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    PADDLE_ENFORCE_GT(
+        n, 0, platform::errors::Unavailable(
+                  "Failed to read the sparse table segment %s: %s.", path,
+                  n == 0 ? "end of file" : strerror(errno)));
+    data += n;
+    bytes -= n;
+    offset += n;
+  }
+}
+
+SsdSparseStore::Segment::Segment(int id, const std::string& path)
+    : id(id), path(path) {
+  fd = open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+  PADDLE_ENFORCE_GE(fd, 0, platform::errors::Unavailable(
+                               "Failed to open the sparse table segment %s: "
+                               "%s.",
+                               path, strerror(errno)));
+}
+
+SsdSparseStore::Segment::~Segment() {
+  close(fd);
+  unlink(path.c_str());
+}
+
+SsdSparseStore::SsdSparseStore(const std::string& path,
+                               const std::vector<int>& dims,
+                               int64_t segment_bytes)
+    : path_(path), dims_(dims) {
+  for (auto dim : dims_) {
+    row_numel_ += dim;
+  }
+  record_bytes_ = kRecordHeaderBytes + row_numel_ * sizeof(float);
+  segment_bytes_ = std::max(segment_bytes, record_bytes_);
+  MkDirRecursively(path_.c_str());
+  RollSegmentLocked();
+  compact_thread_ = std::thread([this] { CompactLoop(); });
+  VLOG(0) << "sparse table ssd store in " << path_ << " with rows of "
+          << record_bytes_ << " bytes";
+}
+
+SsdSparseStore::~SsdSparseStore() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  compact_cv_.notify_all();
+  compact_thread_.join();
+  index_.clear();
+  segments_.clear();
+  active_.reset();
+  rmdir(path_.c_str());
+}
+
+void SsdSparseStore::RollSegmentLocked() {
+  if (active_ != nullptr) {
+    FlushLocked();
+    active_->sealed = true;
+    if (active_->live_rows == 0) {
+      segments_.erase(active_->id);
+    }
+  }
+  int id = next_segment_id_++;
+  active_ = std::make_shared<Segment>(
+      id, string::Sprintf("%s/segment_%d.log", path_, id));
+  segments_[id] = active_;
+  buffer_offset_ = 0;
+}
+
+void SsdSparseStore::FlushLocked() {
+  if (buffer_.empty()) {
+    return;
+  }
+  PWriteAll(active_->fd, buffer_.data(), buffer_.size(), buffer_offset_,
+            active_->path);
+  buffer_offset_ += buffer_.size();
+  buffer_.clear();
+}
+
+void SsdSparseStore::AppendLocked(uint64_t key, const EntryMeta& meta,
+                                  const float* data) {
+  if (active_->bytes + record_bytes_ > segment_bytes_) {
+    RollSegmentLocked();
+  }
+  auto got = index_.find(key);
+  if (got != index_.end()) {
+    RemoveLocked(got);
+  }
+  int64_t offset = active_->bytes;
+  RecordMeta record_meta = {meta.count, meta.unseen_days,
+                            meta.seen_after_last_save ? 1 : 0};
+  const char* key_bytes = reinterpret_cast<const char*>(&key);
+  const char* meta_bytes = reinterpret_cast<const char*>(&record_meta);
+  const char* data_bytes = reinterpret_cast<const char*>(data);
+  buffer_.insert(buffer_.end(), key_bytes, key_bytes + sizeof(uint64_t));
+  buffer_.insert(buffer_.end(), meta_bytes, meta_bytes + sizeof(RecordMeta));
+  buffer_.insert(buffer_.end(), data_bytes,
+                 data_bytes + row_numel_ * sizeof(float));
+  active_->bytes += record_bytes_;
+  ++active_->live_rows;
+  index_[key] = Location{active_, offset, meta.unseen_days};
+  if (static_cast<int64_t>(buffer_.size()) >= kWriteBufferBytes) {
+    FlushLocked();
+  }
+}
+
+void SsdSparseStore::RemoveLocked(
+    std::unordered_map<uint64_t, Location>::iterator location) {
+  auto segment = location->second.segment;
+  index_.erase(location);
+  --segment->live_rows;
+  if (!segment->sealed) {
+    return;
+  }
+  if (segment->live_rows == 0) {
+    // The file is removed once the readers of it are done.
+    segments_.erase(segment->id);
+  } else if (2 * segment->live_rows * record_bytes_ < segment->bytes) {
+    compact_cv_.notify_one();
+  }
+}
+
+bool SsdSparseStore::ReadBufferLocked(const Location& location,
+                                      char* record) {
+  if (location.segment != active_ || location.offset < buffer_offset_) {
+    return false;
+  }
+  memcpy(record, buffer_.data() + location.offset - buffer_offset_,
+         record_bytes_);
+  return true;
+}
+
+void SsdSparseStore::ReadRecords(const Segment& segment, int64_t offset,
+                                 int64_t num, char* buffer) {
+  PReadAll(segment.fd, buffer, num * record_bytes_, offset, segment.path);
+}
+
+void SsdSparseStore::SplitRow(const float* data,
+                              std::vector<std::vector<float>>* values) const {
+  values->resize(dims_.size());
+  for (size_t i = 0; i < dims_.size(); ++i) {
+    (*values)[i].assign(data, data + dims_[i]);
+    data += dims_[i];
+  }
+}
+
+void SsdSparseStore::ParseRecord(const char* record, int unseen_days,
+                                 std::vector<std::vector<float>>* values,
+                                 EntryMeta* meta) const {
+  *meta = ReadRecordMeta(record, unseen_days);
+  SplitRow(reinterpret_cast<const float*>(record + kRecordHeaderBytes),
+           values);
+}
+
+void SsdSparseStore::Spill(uint64_t key,
+                           const std::vector<std::vector<float>>& values,
+                           const EntryMeta& meta) {
+  thread_local std::vector<float> row;
+  row.clear();
+  for (auto& value : values) {
+    row.insert(row.end(), value.begin(), value.end());
+  }
+  PADDLE_ENFORCE_EQ(static_cast<int64_t>(row.size()), row_numel_,
+                    platform::errors::InvalidArgument(
+                        "The row of %d floats spilled does not match the "
+                        "store of %d floats.",
+                        row.size(), row_numel_));
+  std::lock_guard<std::mutex> lock(mutex_);
+  AppendLocked(key, meta, row.data());
+}
+
+int64_t SsdSparseStore::Shrink(int ttl_days) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  int64_t expired = 0;
+  for (auto it = index_.begin(); it != index_.end();) {
+    if (++it->second.unseen_days > ttl_days) {
+      RemoveLocked(it++);
+      ++expired;
+    } else {
+      ++it;
+    }
+  }
+  VLOG(3) << "shrink the store " << path_ << ", " << expired
+          << " rows expired, " << index_.size() << " left";
+  return expired;
+}
+
+bool SsdSparseStore::Contains(uint64_t key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return index_.count(key) > 0;
+}
+
+bool SsdSparseStore::Load(uint64_t key,
+                          std::vector<std::vector<float>>* values,
+                          EntryMeta* meta) {
+  std::vector<uint64_t> keys = {key};
+  std::vector<std::vector<std::vector<float>>> batch_values;
+  std::vector<EntryMeta> batch_metas;
+  LoadBatch(keys, &batch_values, &batch_metas);
+  if (batch_values[0].empty()) {
+    return false;
+  }
+  *values = std::move(batch_values[0]);
+  *meta = batch_metas[0];
+  return true;
+}
+
+void SsdSparseStore::LoadBatch(
+    const std::vector<uint64_t>& keys,
+    std::vector<std::vector<std::vector<float>>>* values,
+    std::vector<EntryMeta>* metas) {
+  values->clear();
+  values->resize(keys.size());
+  metas->clear();
+  metas->resize(keys.size());
+  std::vector<std::pair<Location, size_t>> reads;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<char> record(record_bytes_);
+    for (size_t i = 0; i < keys.size(); ++i) {
+      auto got = index_.find(keys[i]);
+      if (got == index_.end()) {
+        continue;
+      }
+      if (ReadBufferLocked(got->second, record.data())) {
+        ParseRecord(record.data(), got->second.unseen_days, &(*values)[i],
+                    &(*metas)[i]);
+      } else {
+        reads.emplace_back(got->second, i);
+      }
+      RemoveLocked(got);
+    }
+  }
+  if (reads.empty()) {
+    return;
+  }
+
+  // Read the runs of the adjacent records at once, in the order on the disk.
+  std::sort(reads.begin(), reads.end(),
+            [](const std::pair<Location, size_t>& a,
+               const std::pair<Location, size_t>& b) {
+              if (a.first.segment->id != b.first.segment->id) {
+                return a.first.segment->id < b.first.segment->id;
+              }
+              return a.first.offset < b.first.offset;
+            });
+  const int64_t max_run = std::max<int64_t>(kMaxReadBytes / record_bytes_, 1);
+  std::vector<char> buffer;
+  for (size_t start = 0; start < reads.size();) {
+    auto& first = reads[start].first;
+    size_t end = start + 1;
+    while (end < reads.size() &&
+           static_cast<int64_t>(end - start) < max_run &&
+           reads[end].first.segment == first.segment &&
+           reads[end].first.offset ==
+               first.offset + static_cast<int64_t>(end - start) *
+                                  record_bytes_) {
+      ++end;
+    }
+    buffer.resize((end - start) * record_bytes_);
+    ReadRecords(*first.segment, first.offset, end - start, buffer.data());
+    for (size_t i = start; i < end; ++i) {
+      const char* record = buffer.data() + (i - start) * record_bytes_;
+      ParseRecord(record, reads[i].first.unseen_days,
+                  &(*values)[reads[i].second], &(*metas)[reads[i].second]);
+    }
+    start = end;
+  }
+}
+
+void SsdSparseStore::ForEach(
+    const std::function<void(uint64_t, const std::vector<std::vector<float>>&)>&
+        func) {
+  std::vector<std::pair<uint64_t, Location>> rows;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    FlushLocked();
+    rows.assign(index_.begin(), index_.end());
+  }
+  std::vector<char> record(record_bytes_);
+  std::vector<std::vector<float>> values;
+  for (auto& row : rows) {
+    ReadRecords(*row.second.segment, row.second.offset, 1, record.data());
+    SplitRow(
+        reinterpret_cast<const float*>(record.data() + kRecordHeaderBytes),
+        &values);
+    func(row.first, values);
+  }
+}
+
+std::vector<std::shared_ptr<SsdSparseStore::Segment>>
+SsdSparseStore::SegmentsToCompactLocked() {
+  std::vector<std::shared_ptr<Segment>> segments;
+  for (auto& item : segments_) {
+    auto& segment = item.second;
+    if (segment->sealed &&
+        2 * segment->live_rows * record_bytes_ < segment->bytes) {
+      segments.push_back(segment);
+    }
+  }
+  return segments;
+}
+
+void SsdSparseStore::CompactSegment(std::shared_ptr<Segment> segment) {
+  // The sealed segment is immutable, so it is read without the lock, and the
+  // records the index still points to are appended again.
+  const int64_t num = segment->bytes / record_bytes_;
+  const int64_t chunk = std::max<int64_t>(kMaxReadBytes / record_bytes_, 1);
+  std::vector<char> buffer;
+  int64_t moved = 0;
+  for (int64_t start = 0; start < num; start += chunk) {
+    int64_t count = std::min(chunk, num - start);
+    buffer.resize(count * record_bytes_);
+    ReadRecords(*segment, start * record_bytes_, count, buffer.data());
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (segment->live_rows == 0) {
+      break;
+    }
+    for (int64_t i = 0; i < count; ++i) {
+      const char* record = buffer.data() + i * record_bytes_;
+      uint64_t key;
+      memcpy(&key, record, sizeof(uint64_t));
+      auto got = index_.find(key);
+      if (got != index_.end() && got->second.segment == segment &&
+          got->second.offset == (start + i) * record_bytes_) {
+        AppendLocked(
+            key, ReadRecordMeta(record, got->second.unseen_days),
+            reinterpret_cast<const float*>(record + kRecordHeaderBytes));
+        ++moved;
+      }
+    }
+  }
+  VLOG(3) << "compact segment " << segment->path << ", moved " << moved
+          << " rows of " << num;
+}
+
+void SsdSparseStore::Compact() {
+  std::vector<std::shared_ptr<Segment>> segments;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    segments = SegmentsToCompactLocked();
+  }
+  for (auto& segment : segments) {
+    CompactSegment(segment);
+  }
+}
+
+void SsdSparseStore::CompactLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_) {
+    compact_cv_.wait_for(lock, std::chrono::seconds(1));
+    if (stop_) {
+      break;
+    }
+    auto segments = SegmentsToCompactLocked();
+    if (segments.empty()) {
+      continue;
+    }
+    lock.unlock();
+    for (auto& segment : segments) {
+      CompactSegment(segment);
+    }
+    lock.lock();
+  }
+}
+
+int64_t SsdSparseStore::size() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return index_.size();
+}
+
+int64_t SsdSparseStore::disk_bytes() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  int64_t bytes = 0;
+  for (auto& item : segments_) {
+    bytes += item.second->bytes;
+  }
+  return bytes;
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,141 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/fluid/distributed/table/depends/entry_eviction.h"
+
+namespace paddle {
+namespace distributed {
+
+// A log-structured store of the rows of a sparse table on the local disk,
+// which is the cold tier of CommonSparseTable. The rows are appended to the
+// segment files in the directory path through a write buffer, and located by
+// an in-memory index, so that a row is read with a single pread. A record is
+// the key, the entry metadata of the row and its values. The rows
+// taken out or written again leave garbage in the sealed segments, which are
+// compacted in the background once less than half of the rows in them are
+// alive. The store is not persistent, its files are removed with it.
+class SsdSparseStore : public SpillStore {
+ public:
+  static constexpr int64_t kDefaultSegmentBytes = 64 << 20;
+
+  // The rows are of the values of dims, in the order of the params of the
+  // table.
+  SsdSparseStore(const std::string& path, const std::vector<int>& dims,
+                 int64_t segment_bytes = kDefaultSegmentBytes);
+  ~SsdSparseStore();
+
+  void Spill(uint64_t key, const std::vector<std::vector<float>>& values,
+             const EntryMeta& meta) override;
+  bool Load(uint64_t key, std::vector<std::vector<float>>* values,
+            EntryMeta* meta) override;
+  bool Contains(uint64_t key) override;
+  // The rows adjacent on the disk are read with a single pread.
+  void LoadBatch(const std::vector<uint64_t>& keys,
+                 std::vector<std::vector<std::vector<float>>>* values,
+                 std::vector<EntryMeta>* metas) override;
+  int64_t Shrink(int ttl_days) override;
+  void ForEach(const std::function<
+               void(uint64_t, const std::vector<std::vector<float>>&)>& func)
+      override;
+
+  // Compact the sealed segments with garbage now, instead of waiting for the
+  // background compaction.
+  void Compact();
+
+  // The number of the rows in the store.
+  int64_t size();
+  // The size of the segment files, including the garbage.
+  int64_t disk_bytes();
+
+ private:
+  struct Segment {
+    Segment(int id, const std::string& path);
+    ~Segment();
+
+    int id;
+    std::string path;
+    int fd;
+    // The bytes appended, including the ones still in the write buffer.
+    int64_t bytes = 0;
+    // The number of the rows in the segment the index points to.
+    int64_t live_rows = 0;
+    bool sealed = false;
+  };
+
+  struct Location {
+    std::shared_ptr<Segment> segment;
+    int64_t offset;
+    // The days the row has not been pulled, aged by Shrink. The record keeps
+    // the days at the spill, so the aged ones in the index are used.
+    int unseen_days;
+  };
+
+  // Append a record of key, meta and data of row_numel_ floats to the active
+  // segment, and point key to it.
+  void AppendLocked(uint64_t key, const EntryMeta& meta, const float* data);
+  // Drop key from the index, and the sealed segment without live rows.
+  void RemoveLocked(
+      std::unordered_map<uint64_t, Location>::iterator location);
+  void FlushLocked();
+  void RollSegmentLocked();
+  // Copy the record at location if it is still in the write buffer.
+  bool ReadBufferLocked(const Location& location, char* record);
+  void ReadRecords(const Segment& segment, int64_t offset, int64_t num,
+                   char* buffer);
+  void SplitRow(const float* data,
+                std::vector<std::vector<float>>* values) const;
+  // Split the record into the values and the metadata, whose unseen days
+  // are replaced with the aged ones of the index.
+  void ParseRecord(const char* record, int unseen_days,
+                   std::vector<std::vector<float>>* values,
+                   EntryMeta* meta) const;
+  // Rewrite the live rows of the segment to the active segment.
+  void CompactSegment(std::shared_ptr<Segment> segment);
+  std::vector<std::shared_ptr<Segment>> SegmentsToCompactLocked();
+  void CompactLoop();
+
+  std::string path_;
+  std::vector<int> dims_;
+  int64_t row_numel_ = 0;
+  int64_t record_bytes_ = 0;
+  int64_t segment_bytes_ = 0;
+
+  std::mutex mutex_;
+  std::unordered_map<uint64_t, Location> index_;
+  std::map<int, std::shared_ptr<Segment>> segments_;
+  std::shared_ptr<Segment> active_;
+  int next_segment_id_ = 0;
+  // The records appended to active_ from buffer_offset_ but not written yet.
+  std::vector<char> buffer_;
+  int64_t buffer_offset_ = 0;
+
+  std::condition_variable compact_cv_;
+  bool stop_ = false;
+  std::thread compact_thread_;
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -49,9 +49,32 @@ int32_t Table::initialize(const TableParameter &config,
     LOG(WARNING) << "Table accessor initialize failed";
     return -1;
   }
+  if (_config.common().ssp_staleness() >= 0) {
+    _ssp_clock.reset(new SspClock(_config.common().trainer_num(),
+                                  _config.common().ssp_staleness()));
+    VLOG(1) << "Table " << _config.table_id()
+            << " in stale synchronous parallel mode, staleness: "
+            << _config.common().ssp_staleness();
+  }
   return initialize();
 }
 
+int32_t Table::push_clock(const uint32_t trainer_id, int32_t steps) {
+  if (_ssp_clock) {
+    _ssp_clock->Tick(trainer_id, steps);
+  }
+  return 0;
+}
+
+int32_t Table::wait_clock(const uint32_t trainer_id) {
+  if (_ssp_clock) {
+    int64_t ahead = _ssp_clock->Wait(trainer_id);
+    VLOG(4) << "Table " << _config.table_id() << " trainer " << trainer_id
+            << " is " << ahead << " steps ahead of the slowest";
+  }
+  return 0;
+}
+
 int32_t Table::initialize_accessor() {
   if (!_config.has_accessor() || !_config.accessor().has_accessor_class()) {
     LOG(ERROR) << "missing accessor config in table, table_id:"
@@ -22,6 +22,7 @@
 #include <utility>
 
 #include "paddle/fluid/distributed/table/accessor.h"
+#include "paddle/fluid/distributed/table/depends/ssp_clock.h"
 #include "paddle/fluid/string/string_helper.h"
 
 namespace paddle {
@@ -61,6 +62,13 @@ class Table {
     return 0;
   }
 
+  // only for the stale synchronous parallel mode, i.e. ssp_staleness >= 0
+  // advance the clock of the trainer by steps, finish it if steps < 0
+  virtual int32_t push_clock(const uint32_t trainer_id, int32_t steps);
+  // wait until the trainer is at most ssp_staleness steps ahead of the
+  // slowest trainer, before a pull
+  virtual int32_t wait_clock(const uint32_t trainer_id);
+
   // only for barrier table
   virtual int32_t set_table_map(
       std::unordered_map<uint32_t, std::shared_ptr<Table>> *table_map) {
@@ -102,10 +110,13 @@ class Table {
                                          _config.table_id());
   }
 
-  size_t _shard_idx;  // table 分片编号
-  size_t _shard_num;  // table 分片总数
+  // a table not sharded by set_shard holds all the keys
+  size_t _shard_idx = 0;  // table 分片编号
+  size_t _shard_num = 1;  // table 分片总数
   TableParameter _config;
   std::shared_ptr<ValueAccessor> _value_accesor;
+  // the clocks of the trainers in the stale synchronous parallel mode
+  std::unique_ptr<SspClock> _ssp_clock;
 };
 REGISTER_REGISTERER(Table);
 
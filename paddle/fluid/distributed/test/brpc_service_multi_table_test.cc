@@ -0,0 +1,313 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "paddle/fluid/distributed/ps.pb.h"
+#include "paddle/fluid/distributed/service/brpc_ps_client.h"
+#include "paddle/fluid/distributed/service/brpc_ps_server.h"
+#include "paddle/fluid/distributed/service/env.h"
+#include "paddle/fluid/distributed/service/ps_client.h"
+#include "paddle/fluid/distributed/service/sendrecv.pb.h"
+#include "paddle/fluid/distributed/service/service.h"
+
+namespace distributed = paddle::distributed;
+
+const int kTableNum = 30;
+const int kEmbDim = 8;
+
+void GetSparseTableProto(int table_id,
+                         distributed::TableParameter* sparse_table_proto) {
+  sparse_table_proto->set_table_id(table_id);
+  sparse_table_proto->set_table_class("CommonSparseTable");
+  sparse_table_proto->set_shard_num(256);
+  sparse_table_proto->set_type(distributed::PS_SPARSE_TABLE);
+  distributed::TableAccessorParameter* accessor_proto =
+      sparse_table_proto->mutable_accessor();
+  distributed::CommonAccessorParameter* common_proto =
+      sparse_table_proto->mutable_common();
+
+  accessor_proto->set_accessor_class("CommMergeAccessor");
+  accessor_proto->set_fea_dim(0);
+  accessor_proto->set_embedx_dim(kEmbDim);
+
+  common_proto->set_name("sgd");
+  common_proto->set_table_name("emb_" + std::to_string(table_id));
+  common_proto->set_trainer_num(1);
+  common_proto->set_sync(false);
+  common_proto->add_params("Param");
+  common_proto->add_dims(kEmbDim);
+  common_proto->add_initializers("uniform_random&0&-1.0&1.0");
+  common_proto->add_params("LearningRate");
+  common_proto->add_dims(1);
+  common_proto->add_initializers("fill_constant&1.0");
+}
+
+void GetServiceProto(distributed::ServerParameter* server_proto) {
+  distributed::DownpourServerParameter* downpour_server_proto =
+      server_proto->mutable_downpour_server_param();
+  distributed::ServerServiceParameter* server_service_proto =
+      downpour_server_proto->mutable_service_param();
+  server_service_proto->set_service_class("PsService");
+  server_service_proto->set_server_class("BrpcPsServer");
+  server_service_proto->set_client_class("BrpcPsClient");
+  server_service_proto->set_start_server_port(0);
+  server_service_proto->set_server_thread_num(12);
+  for (int i = 0; i < kTableNum; ++i) {
+    GetSparseTableProto(i, downpour_server_proto->add_downpour_table_param());
+  }
+}
+
+distributed::PSParameter GetServerProto() {
+  distributed::PSParameter server_fleet_desc;
+  GetServiceProto(server_fleet_desc.mutable_server_param());
+  return server_fleet_desc;
+}
+
+distributed::PSParameter GetWorkerProto() {
+  distributed::PSParameter worker_fleet_desc;
+  distributed::DownpourWorkerParameter* downpour_worker_proto =
+      worker_fleet_desc.mutable_worker_param()
+          ->mutable_downpour_worker_param();
+  for (int i = 0; i < kTableNum; ++i) {
+    GetSparseTableProto(i, downpour_worker_proto->add_downpour_table_param());
+  }
+  GetServiceProto(worker_fleet_desc.mutable_server_param());
+  return worker_fleet_desc;
+}
+
+/*-------------------------------------------------------------------------*/
+
+std::string ip_ = "127.0.0.1";
+uint32_t port_ = 4219;
+
+std::vector<std::string> host_sign_list_;
+
+std::shared_ptr<distributed::PSServer> pserver_ptr_;
+
+std::shared_ptr<distributed::PSClient> worker_ptr_;
+
+void RunServer() {
+  distributed::PSParameter server_proto = GetServerProto();
+
+  auto _ps_env = distributed::PaddlePSEnvironment();
+  _ps_env.set_ps_servers(&host_sign_list_, 1);
+  pserver_ptr_ = std::shared_ptr<distributed::PSServer>(
+      distributed::PSServerFactory::create(server_proto));
+  pserver_ptr_->configure(server_proto, _ps_env, 0);
+  pserver_ptr_->start(ip_, port_);
+}
+
+void RunClient() {
+  distributed::PSParameter worker_proto = GetWorkerProto();
+  distributed::PaddlePSEnvironment _ps_env;
+  _ps_env.set_ps_servers(&host_sign_list_, host_sign_list_.size());
+  std::map<uint64_t, std::vector<distributed::Region>> dense_regions;
+  worker_ptr_ = std::shared_ptr<distributed::PSClient>(
+      distributed::PSClientFactory::create(worker_proto));
+  worker_ptr_->configure(worker_proto, dense_regions, _ps_env, 0);
+}
+
+// The keys and the values of every table in a step.
+struct StepData {
+  std::vector<std::vector<uint64_t>> keys;
+  std::vector<std::vector<float>> values;
+  std::vector<std::vector<float*>> value_ptrs;
+  std::vector<std::vector<const float*>> grad_ptrs;
+  std::vector<distributed::TableSparseValues> tables;
+  std::vector<distributed::TableSparsePullValues> pull_tables;
+
+  StepData(int step, int keys_per_table)
+      : keys(kTableNum),
+        values(kTableNum),
+        value_ptrs(kTableNum),
+        grad_ptrs(kTableNum) {
+    for (int t = 0; t < kTableNum; ++t) {
+      values[t].resize(keys_per_table * kEmbDim);
+      for (int i = 0; i < keys_per_table; ++i) {
+        // Every key occurs twice in a table, and in all the tables.
+        keys[t].push_back((step * 131 + i * 7) % (keys_per_table / 2));
+        value_ptrs[t].push_back(values[t].data() + i * kEmbDim);
+        grad_ptrs[t].push_back(values[t].data() + i * kEmbDim);
+      }
+      tables.push_back({static_cast<size_t>(t), keys[t].data(),
+                        grad_ptrs[t].data(), keys[t].size()});
+      pull_tables.push_back({static_cast<size_t>(t), keys[t].data(),
+                             value_ptrs[t].data(), keys[t].size()});
+    }
+  }
+
+  // Pull the values of every table with a request per table.
+  void Pull() {
+    for (int t = 0; t < kTableNum; ++t) {
+      EXPECT_EQ(worker_ptr_
+                    ->pull_sparse(value_ptrs[t].data(), t, keys[t].data(),
+                                  keys[t].size())
+                    .get(),
+                0);
+    }
+  }
+};
+
+distributed::DownpourBrpcClosure* NewPushClosure(int cmd_id) {
+  return new distributed::DownpourBrpcClosure(1, [cmd_id](void* done) {
+    auto* closure = (distributed::DownpourBrpcClosure*)done;
+    closure->set_promise_value(closure->check_response(0, cmd_id));
+  });
+}
+
+double Percentile(std::vector<double> latencies, double p) {
+  std::sort(latencies.begin(), latencies.end());
+  return latencies[static_cast<size_t>(p * (latencies.size() - 1))];
+}
+
+void RunBrpcMultiTable() {
+  setenv("http_proxy", "", 1);
+  setenv("https_proxy", "", 1);
+  auto ph_host = distributed::PSHost(ip_, port_, 0);
+  host_sign_list_.push_back(ph_host.serialize_to_string());
+
+  std::thread server_thread(RunServer);
+  sleep(1);
+  RunClient();
+
+  /*-----------------------Test Multi-Table Pull-----------------------------*/
+  LOG(INFO) << "Run pull_sparse_multi_table";
+  StepData multi(0, 100), single(0, 100);
+  EXPECT_EQ(worker_ptr_->pull_sparse_multi_table(multi.pull_tables).get(), 0);
+  single.Pull();
+  for (int t = 0; t < kTableNum; ++t) {
+    for (size_t i = 0; i < multi.values[t].size(); ++i) {
+      EXPECT_FLOAT_EQ(multi.values[t][i], single.values[t][i]);
+    }
+  }
+  // Nothing is sent for no table.
+  EXPECT_EQ(worker_ptr_->pull_sparse_multi_table({}).get(), 0);
+
+  /*-----------------------Test Multi-Table Push-----------------------------*/
+  LOG(INFO) << "Run push_sparse_multi_table";
+  StepData before(0, 100);
+  before.Pull();
+  StepData grads(0, 100);
+  for (auto& value : grads.values) {
+    std::fill(value.begin(), value.end(), 1.0f);
+  }
+  // The gradient is applied for every occurrence of a key.
+  EXPECT_EQ(worker_ptr_
+                ->push_sparse_multi_table(
+                    grads.tables,
+                    NewPushClosure(paddle::PS_PUSH_SPARSE_MULTI_TABLE))
+                .get(),
+            0);
+  // Nothing is sent for no table.
+  EXPECT_EQ(
+      worker_ptr_
+          ->push_sparse_multi_table(
+              {}, NewPushClosure(paddle::PS_PUSH_SPARSE_MULTI_TABLE))
+          .get(),
+      0);
+  StepData updated(0, 100);
+  updated.Pull();
+  for (int t = 0; t < kTableNum; ++t) {
+    for (size_t i = 0; i < updated.keys[t].size(); ++i) {
+      auto key = updated.keys[t][i];
+      int count = std::count(updated.keys[t].begin(), updated.keys[t].end(),
+                             key);
+      for (int j = 0; j < kEmbDim; ++j) {
+        EXPECT_FLOAT_EQ(updated.values[t][i * kEmbDim + j],
+                        before.values[t][i * kEmbDim + j] - count);
+      }
+    }
+  }
+
+  /*-----------------------Benchmark Pull Latency----------------------------*/
+  const int kSteps = 200;
+  size_t server_num = host_sign_list_.size();
+  std::vector<double> per_table_ms, multi_table_ms;
+  for (int step = 1; step <= kSteps; ++step) {
+    StepData data(step, 1000);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::future<int32_t>> futures;
+    for (auto& table : data.pull_tables) {
+      futures.push_back(worker_ptr_->pull_sparse(table.values, table.table_id,
+                                                 table.keys, table.num));
+    }
+    for (auto& future : futures) {
+      future.wait();
+    }
+    auto mid = std::chrono::steady_clock::now();
+    worker_ptr_->pull_sparse_multi_table(data.pull_tables).wait();
+    auto end = std::chrono::steady_clock::now();
+    per_table_ms.push_back(
+        std::chrono::duration<double, std::milli>(mid - start).count());
+    multi_table_ms.push_back(
+        std::chrono::duration<double, std::milli>(end - mid).count());
+  }
+  LOG(INFO) << kTableNum << " tables, per-table pull: "
+            << kTableNum * server_num << " round trips per step, p50 "
+            << Percentile(per_table_ms, 0.5) << " ms, p99 "
+            << Percentile(per_table_ms, 0.99) << " ms";
+  LOG(INFO) << kTableNum << " tables, multi-table pull: " << server_num
+            << " round trips per step, p50 " << Percentile(multi_table_ms, 0.5)
+            << " ms, p99 " << Percentile(multi_table_ms, 0.99) << " ms";
+
+  /*-----------------------Benchmark Push Latency----------------------------*/
+  per_table_ms.clear();
+  multi_table_ms.clear();
+  for (int step = 1; step <= kSteps; ++step) {
+    StepData data(step, 1000);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::future<int32_t>> futures;
+    for (auto& table : data.tables) {
+      futures.push_back(worker_ptr_->push_sparse_raw_gradient(
+          table.table_id, table.keys, table.values, table.num,
+          NewPushClosure(paddle::PS_PUSH_SPARSE_TABLE)));
+    }
+    for (auto& future : futures) {
+      future.wait();
+    }
+    auto mid = std::chrono::steady_clock::now();
+    worker_ptr_
+        ->push_sparse_multi_table(
+            data.tables, NewPushClosure(paddle::PS_PUSH_SPARSE_MULTI_TABLE))
+        .wait();
+    auto end = std::chrono::steady_clock::now();
+    per_table_ms.push_back(
+        std::chrono::duration<double, std::milli>(mid - start).count());
+    multi_table_ms.push_back(
+        std::chrono::duration<double, std::milli>(end - mid).count());
+  }
+  LOG(INFO) << kTableNum << " tables, per-table push: "
+            << kTableNum * server_num << " round trips per step, p50 "
+            << Percentile(per_table_ms, 0.5) << " ms, p99 "
+            << Percentile(per_table_ms, 0.99) << " ms";
+  LOG(INFO) << kTableNum << " tables, multi-table push: " << server_num
+            << " round trips per step, p50 " << Percentile(multi_table_ms, 0.5)
+            << " ms, p99 " << Percentile(multi_table_ms, 0.99) << " ms";
+
+  LOG(INFO) << "Run stop_server";
+  worker_ptr_->stop_server();
+  LOG(INFO) << "Run finalize_worker";
+  worker_ptr_->finalize_worker();
+  server_thread.join();
+}
+
+TEST(RunBrpcMultiTable, Run) { RunBrpcMultiTable(); }
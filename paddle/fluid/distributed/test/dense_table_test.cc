@@ -15,6 +15,7 @@ limitations under the License. */
 #include <ThreadPool.h>
 
 #include <unistd.h>
+#include <chrono>  // NOLINT
 #include <string>
 #include <thread>  // NOLINT
 
@@ -191,5 +192,76 @@ TEST(CommonDenseTable, SGD) {
   }
 }
 
+// CommonDenseTable + SGD pushed by many workers concurrently, where the
+// param is updated by the threads of several shards.
+TEST(CommonDenseTable, ConcurrentPush) {
+  int fea_dim = 200000;
+  int workers = 32;
+  int pushes = 10;
+
+  for (bool sync : {false, true}) {
+    TableParameter table_config;
+    table_config.set_table_class("CommonDenseTable");
+    FsClientParameter fs_config;
+    Table *table = new CommonDenseTable();
+    TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+    accessor_config->set_accessor_class("CommMergeAccessor");
+    CommonAccessorParameter *common_config = table_config.mutable_common();
+    common_config->set_name("sgd");
+    common_config->set_table_name("sgd_concurrent_test_table");
+    common_config->set_trainer_num(workers);
+    common_config->set_sync(sync);
+    common_config->add_params("Param");
+    common_config->add_dims(fea_dim);
+    common_config->add_initializers("fill_constant&1.0");
+    common_config->add_params("LearningRate");
+    common_config->add_dims(1);
+    common_config->add_initializers("fill_constant&0.5");
+    auto ret = table->initialize(table_config, fs_config);
+    ASSERT_EQ(ret, 0);
+
+    std::vector<std::vector<float>> gradients(workers);
+    for (int i = 0; i < workers; ++i) {
+      gradients[i].resize(fea_dim);
+      for (int k = 0; k < fea_dim; ++k) {
+        gradients[i][k] = 0.001 * ((i + k) % 7);
+      }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < workers; ++i) {
+      threads.emplace_back([table, i, pushes, &gradients] {
+        for (int j = 0; j < pushes; ++j) {
+          table->push_dense(gradients[i].data(), gradients[i].size());
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    if (sync) {
+      table->pour();
+    }
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    LOG(INFO) << "CommonDenseTable of dim " << fea_dim << " sync: " << sync
+              << ", " << workers * pushes / seconds
+              << " push_dense per second from " << workers << " workers";
+
+    std::vector<float> pull_values(fea_dim);
+    table->pull_dense(pull_values.data(), fea_dim);
+    for (int k = 0; k < fea_dim; ++k) {
+      float total = 0.0;
+      for (int i = 0; i < workers; ++i) {
+        total += gradients[i][k];
+      }
+      ASSERT_NEAR(1.0 - 0.5 * pushes * total, pull_values[k], 1e-3);
+    }
+    delete table;
+  }
+}
+
 }  // namespace distributed
 }  // namespace paddle
@@ -0,0 +1,216 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/service/geo_delta_compress.h"
+#include "paddle/fluid/distributed/table/depends/geo_recorder.h"
+
+namespace paddle {
+namespace distributed {
+
+TEST(GeoRecorder, RowBitmap) {
+  GeoRecorder recorder(2);
+  std::vector<uint64_t> rows;
+  // A dense group, converted to a bitmap, and a sparse group.
+  for (uint64_t i = 0; i < 10000; ++i) {
+    rows.push_back(i * 3 % 10000);
+  }
+  rows.push_back(uint64_t(1) << 40);
+  rows.push_back(7);
+  recorder.Update(rows);
+
+  std::vector<uint64_t> result;
+  recorder.GetAndClear(0, &result);
+  ASSERT_EQ(result.size(), 10001);
+  for (uint64_t i = 0; i < 10000; ++i) {
+    ASSERT_EQ(result[i], i);
+  }
+  ASSERT_EQ(result[10000], uint64_t(1) << 40);
+
+  recorder.GetAndClear(0, &result);
+  ASSERT_EQ(result.size(), 0);
+  recorder.GetAndClear(1, &result);
+  ASSERT_EQ(result.size(), 10001);
+}
+
+TEST(GeoSelectTopkRows, Residual) {
+  const int64_t dim = 2;
+  std::vector<float> latest = {1, 1, 5, 5, 0, 3, 2, 0};
+  std::vector<float> old(latest.size(), 0);
+  std::vector<int64_t> ids = {0, 1}, residual_ids = {2, 3};
+
+  GeoSelectTopkRows(latest.data(), old.data(), dim, 0.5, &ids, &residual_ids);
+  EXPECT_EQ(ids, std::vector<int64_t>({1, 2}));
+  EXPECT_EQ(residual_ids, std::vector<int64_t>({0, 3}));
+
+  GeoSelectTopkRows(latest.data(), old.data(), dim, 1.0, &ids, &residual_ids);
+  EXPECT_EQ(ids, std::vector<int64_t>({0, 1, 2, 3}));
+  EXPECT_TRUE(residual_ids.empty());
+}
+
+TEST(GeoRoundToFloat16, Round) {
+  std::vector<float> values = {1.0f, 0.1f, -3.14159f, 1e-3f};
+  GeoRoundToFloat16(values.data(), values.size());
+  EXPECT_EQ(values[0], 1.0f);
+  EXPECT_NEAR(values[1], 0.1f, 1e-4);
+  EXPECT_NEAR(values[2], -3.14159f, 2e-3);
+  EXPECT_NEAR(values[3], 1e-3f, 1e-6);
+  // Rounding again is lossless, as the encoding on the wire.
+  auto rounded = values;
+  GeoRoundToFloat16(rounded.data(), rounded.size());
+  EXPECT_EQ(rounded, values);
+}
+
+// A local simulation of Geo-SGD: every trainer runs SGD on its copy of a
+// sparse parameter, toward the same target with noise, and every push_every
+// steps pushes the deltas of its rows to the server and pulls the rows
+// updated by the others, as GeoCommunicator and SparseGeoTable do.
+struct GeoSimulation {
+  static const int kRows = 5000;
+  static const int kDim = 8;
+  static const int kTrainers = 4;
+
+  float topk_ratio;
+  bool fp16;
+  // The bytes of the pushed and the pulled rows.
+  int64_t push_bytes = 0;
+  int64_t pull_bytes = 0;
+
+  GeoSimulation(float topk_ratio, bool fp16)
+      : topk_ratio(topk_ratio), fp16(fp16) {}
+
+  // The rows of a batch, following the Zipf distribution of exponent 1.
+  static std::vector<int64_t> Batch(std::mt19937 *engine, int batch_size) {
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    std::vector<int64_t> rows(batch_size);
+    for (auto &row : rows) {
+      row = static_cast<int64_t>(std::pow(kRows, dist(*engine))) - 1;
+    }
+    return rows;
+  }
+
+  // Return the mean squared error of the server parameter on the rows of the
+  // data distribution.
+  float Run(int steps, int push_every) {
+    std::mt19937 engine(0);
+    std::uniform_real_distribution<float> uniform(-1.0, 1.0);
+    std::normal_distribution<float> noise(0.0, 0.1);
+    std::vector<float> target(kRows * kDim);
+    for (auto &value : target) {
+      value = uniform(engine);
+    }
+
+    std::vector<float> server(kRows * kDim, 0);
+    std::vector<std::vector<float>> latest(kTrainers, server);
+    std::vector<std::vector<float>> old(kTrainers, server);
+    std::vector<std::vector<int64_t>> touched(kTrainers);
+    std::vector<std::vector<int64_t>> residual_ids(kTrainers);
+    GeoRecorder recorder(kTrainers);
+    const float lr = 0.1;
+    size_t value_bytes = fp16 ? sizeof(uint16_t) : sizeof(float);
+
+    for (int step = 1; step <= steps; ++step) {
+      for (int t = 0; t < kTrainers; ++t) {
+        for (auto row : Batch(&engine, 64)) {
+          for (int i = 0; i < kDim; ++i) {
+            float &w = latest[t][row * kDim + i];
+            w -= lr * (w - target[row * kDim + i] + noise(engine));
+          }
+          touched[t].push_back(row);
+        }
+      }
+      if (step % push_every != 0) {
+        continue;
+      }
+
+      for (int t = 0; t < kTrainers; ++t) {
+        auto &ids = touched[t];
+        GeoSelectTopkRows(latest[t].data(), old[t].data(), kDim, topk_ratio,
+                          &ids, &residual_ids[t]);
+        std::vector<float> delta(kDim);
+        for (auto id : ids) {
+          for (int i = 0; i < kDim; ++i) {
+            delta[i] = (latest[t][id * kDim + i] - old[t][id * kDim + i]) /
+                       kTrainers;
+          }
+          if (fp16) {
+            GeoRoundToFloat16(delta.data(), kDim);
+          }
+          for (int i = 0; i < kDim; ++i) {
+            old[t][id * kDim + i] += delta[i];
+            server[id * kDim + i] += delta[i];
+          }
+        }
+        push_bytes += ids.size() * (sizeof(uint64_t) + kDim * value_bytes);
+        recorder.Update(std::vector<uint64_t>(ids.begin(), ids.end()));
+        ids.clear();
+      }
+
+      for (int t = 0; t < kTrainers; ++t) {
+        std::vector<uint64_t> rows;
+        recorder.GetAndClear(t, &rows);
+        for (auto row : rows) {
+          for (int i = 0; i < kDim; ++i) {
+            latest[t][row * kDim + i] +=
+                server[row * kDim + i] - old[t][row * kDim + i];
+            old[t][row * kDim + i] = server[row * kDim + i];
+          }
+        }
+        pull_bytes += rows.size() * (sizeof(uint64_t) + kDim * sizeof(float));
+      }
+    }
+
+    double error = 0;
+    auto rows = Batch(&engine, 10000);
+    for (auto row : rows) {
+      for (int i = 0; i < kDim; ++i) {
+        float diff = server[row * kDim + i] - target[row * kDim + i];
+        error += diff * diff;
+      }
+    }
+    return error / (rows.size() * kDim);
+  }
+};
+
+TEST(GeoSimulation, BytesAndQuality) {
+  const int steps = 400;
+  const int push_every = 10;
+  GeoSimulation full(1.0, false);
+  float full_error = full.Run(steps, push_every);
+  LOG(INFO) << "full fp32 deltas: " << full.push_bytes << " bytes pushed, "
+            << full.pull_bytes << " bytes pulled, mse " << full_error;
+
+  for (float topk_ratio : {1.0f, 0.25f}) {
+    for (bool fp16 : {false, true}) {
+      if (topk_ratio == 1.0f && !fp16) {
+        continue;
+      }
+      GeoSimulation compressed(topk_ratio, fp16);
+      float error = compressed.Run(steps, push_every);
+      LOG(INFO) << "top-k ratio " << topk_ratio << (fp16 ? ", fp16" : ", fp32")
+                << " deltas: " << compressed.push_bytes << " bytes pushed, "
+                << compressed.pull_bytes << " bytes pulled, mse " << error;
+      EXPECT_LT(compressed.push_bytes, full.push_bytes);
+      EXPECT_LT(error, full_error * 1.5);
+    }
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
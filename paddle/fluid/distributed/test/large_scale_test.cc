@@ -15,8 +15,17 @@ limitations under the License. */
 #include <ThreadPool.h>
 
 #include <unistd.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <random>
 #include <string>
 #include <thread>  // NOLINT
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "google/protobuf/text_format.h"
 #include "gtest/gtest.h"
@@ -67,5 +76,434 @@ TEST(BENCHMARK, LargeScaleKV) {
   ASSERT_EQ(ret, 0);
 }
 
+// The keys drawn from the Zipfian distribution of exponent s over the ranks
+// [0, num_keys).
+static std::vector<uint64_t> ZipfianKeys(int num_keys, double s, int num) {
+  std::vector<double> weights(num_keys);
+  for (int k = 0; k < num_keys; ++k) {
+    weights[k] = 1.0 / std::pow(k + 1, s);
+  }
+  std::discrete_distribution<int> dist(weights.begin(), weights.end());
+  std::mt19937 engine(2020);
+  std::vector<uint64_t> keys(num);
+  for (auto &key : keys) {
+    key = dist(engine);
+  }
+  return keys;
+}
+
+static TableParameter SGDTableConfig(int emb_dim, const std::string &entry,
+                                     const std::string &eviction) {
+  TableParameter table_config;
+  table_config.set_table_class("CommonSparseTable");
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CommMergeAccessor");
+  accessor_config->set_fea_dim(0);
+  CommonAccessorParameter *common_config = table_config.mutable_common();
+  common_config->set_name("sgd");
+  common_config->set_table_name("entry_test_table");
+  common_config->set_trainer_num(1);
+  common_config->add_params("Param");
+  common_config->add_dims(emb_dim);
+  common_config->add_initializers("uniform_random&0&-1.0&1.0");
+  common_config->add_params("LearningRate");
+  common_config->add_dims(1);
+  common_config->add_initializers("fill_constant&1.0");
+  common_config->set_entry(entry);
+  common_config->set_eviction(eviction);
+  return table_config;
+}
+
+// Pull and push the keys in batches, as the trainers do.
+static void PullPushKeys(CommonSparseTable *table, int emb_dim,
+                         const std::vector<uint64_t> &keys) {
+  const size_t batch_size = 1000;
+  std::vector<float> values(batch_size * emb_dim);
+  std::vector<float> grads(batch_size * emb_dim, 0.01);
+  for (size_t start = 0; start < keys.size(); start += batch_size) {
+    size_t num = std::min(batch_size, keys.size() - start);
+    table->pull_sparse(values.data(), keys.data() + start, num);
+    table->push_sparse(keys.data() + start, grads.data(), num);
+  }
+}
+
+TEST(CommonSparseTable, CountFilterEntry) {
+  int emb_dim = 8;
+  CommonSparseTable table;
+  auto table_config = SGDTableConfig(emb_dim, "count_filter&3", "none");
+  auto ret = table.Table::initialize(table_config, FsClientParameter());
+  ASSERT_EQ(ret, 0);
+
+  auto keys = ZipfianKeys(50000, 1.1, 100000);
+  PullPushKeys(&table, emb_dim, keys);
+
+  std::unordered_map<uint64_t, int> counts;
+  for (auto key : keys) {
+    ++counts[key];
+  }
+  int64_t frequent_keys = 0;
+  for (auto &item : counts) {
+    frequent_keys += item.second >= 3;
+  }
+  // The sketch never underestimates, so all the keys occurring at least 3
+  // times are admitted, and the rows of the rare keys are not created.
+  auto rows = table.print_table_stat().first;
+  auto stats = table.entry_stats();
+  LOG(INFO) << "distinct keys: " << counts.size()
+            << ", keys occurring at least 3 times: " << frequent_keys
+            << ", rows: " << rows << ", " << stats.ToString();
+  EXPECT_GE(rows, frequent_keys);
+  EXPECT_LT(rows, static_cast<int64_t>(counts.size()));
+  EXPECT_EQ(stats.admitted, rows);
+  EXPECT_GT(stats.filtered, 0);
+  // The grads of the keys pulled as zeros are dropped.
+  EXPECT_GT(stats.dropped, 0);
+  EXPECT_LE(stats.dropped, stats.filtered);
+
+  // A new key is pulled as zeros before admitted.
+  uint64_t new_key = 1ULL << 40;
+  std::vector<float> value(emb_dim, 1.0);
+  table.pull_sparse(value.data(), &new_key, 1);
+  for (auto v : value) {
+    EXPECT_EQ(v, 0.0);
+  }
+}
+
+class InMemorySpillStore : public SpillStore {
+ public:
+  void Spill(uint64_t key, const std::vector<std::vector<float>> &values,
+             const EntryMeta &meta) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    values_[key] = values;
+    metas_[key] = meta;
+    spilled_keys_.insert(key);
+  }
+
+  bool Load(uint64_t key, std::vector<std::vector<float>> *values,
+            EntryMeta *meta) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto got = values_.find(key);
+    if (got == values_.end()) {
+      return false;
+    }
+    *values = std::move(got->second);
+    *meta = metas_[key];
+    values_.erase(got);
+    metas_.erase(key);
+    return true;
+  }
+
+  bool Contains(uint64_t key) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return values_.count(key) > 0;
+  }
+
+  int64_t Shrink(int ttl_days) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t expired = 0;
+    for (auto it = metas_.begin(); it != metas_.end();) {
+      if (++it->second.unseen_days > ttl_days) {
+        values_.erase(it->first);
+        it = metas_.erase(it);
+        ++expired;
+      } else {
+        ++it;
+      }
+    }
+    return expired;
+  }
+
+  void ForEach(const std::function<
+               void(uint64_t, const std::vector<std::vector<float>> &)> &func)
+      override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &item : values_) {
+      func(item.first, item.second);
+    }
+  }
+
+  void Spill(uint64_t key, const std::vector<std::vector<float>> &values,
+             int unseen_days) {
+    EntryMeta meta;
+    meta.unseen_days = unseen_days;
+    Spill(key, values, meta);
+  }
+
+  std::unordered_map<uint64_t, std::vector<std::vector<float>>> values_;
+  std::unordered_map<uint64_t, EntryMeta> metas_;
+  std::unordered_set<uint64_t> spilled_keys_;
+  std::mutex mutex_;
+};
+
+TEST(CommonSparseTable, LFUEvictionWithSpill) {
+  int emb_dim = 8;
+  CommonSparseTable table;
+  // 1MB for the rows of the table.
+  auto table_config = SGDTableConfig(emb_dim, "none", "lfu&1&0");
+  auto ret = table.Table::initialize(table_config, FsClientParameter());
+  ASSERT_EQ(ret, 0);
+  auto store = std::make_shared<InMemorySpillStore>();
+  table.set_spill_store(store);
+
+  auto keys = ZipfianKeys(50000, 1.1, 100000);
+  PullPushKeys(&table, emb_dim, keys);
+
+  auto rows = table.print_table_stat().first;
+  auto stats = table.entry_stats();
+  LOG(INFO) << "rows: " << rows << ", " << stats.ToString();
+  // The budget is split among the 11 shards of the table.
+  FillConstantInitializer initializer({"fill_constant", "0.0"});
+  std::unordered_map<std::string, Initializer *> initializers = {
+      {"Param", &initializer}, {"LearningRate", &initializer}};
+  ValueBlock block(table_config.common(), &initializers, 11);
+  EXPECT_LE(rows, block.max_rows() * 11);
+  EXPECT_LE(block.max_rows() * 11 * block.RowBytes(), 1 << 20);
+  EXPECT_GT(stats.evicted, 0);
+  EXPECT_EQ(stats.spilled, stats.evicted);
+  // The hottest keys are never evicted.
+  for (uint64_t key = 0; key < 10; ++key) {
+    EXPECT_EQ(store->spilled_keys_.count(key), 0u);
+  }
+
+  // The spilled rows are loaded back on pull.
+  uint64_t cold_key = store->values_.begin()->first;
+  auto spilled = store->values_.begin()->second;
+  std::vector<float> value(emb_dim);
+  table.pull_sparse(value.data(), &cold_key, 1);
+  EXPECT_EQ(value, spilled[0]);
+  EXPECT_EQ(store->values_.count(cold_key), 0u);
+  EXPECT_EQ(table.entry_stats().reloaded, stats.reloaded + 1);
+}
+
+// The grad pushed to a key spilled since its pull updates the spilled row.
+TEST(CommonSparseTable, PushToSpilledKey) {
+  int emb_dim = 8;
+  CommonSparseTable table;
+  auto table_config = SGDTableConfig(emb_dim, "none", "lfu&1&0");
+  auto ret = table.Table::initialize(table_config, FsClientParameter());
+  ASSERT_EQ(ret, 0);
+  auto store = std::make_shared<InMemorySpillStore>();
+  table.set_spill_store(store);
+
+  uint64_t key = 7;
+  store->Spill(key, {std::vector<float>(emb_dim, 1.0), {1.0}}, 0);
+  std::vector<float> grads(emb_dim, 0.25);
+  table.push_sparse(&key, grads.data(), 1);
+  EXPECT_FALSE(store->Contains(key));
+  auto stats = table.entry_stats();
+  EXPECT_EQ(stats.reloaded, 1);
+  EXPECT_EQ(stats.dropped, 0);
+
+  std::vector<float> value(emb_dim);
+  table.pull_sparse(value.data(), &key, 1);
+  for (auto v : value) {
+    EXPECT_FLOAT_EQ(v, 0.75);
+  }
+}
+
+// A single pull restores more cold keys than the rows the block holds.
+TEST(CommonSparseTable, PullMoreColdKeysThanMaxRows) {
+  int emb_dim = 8;
+  CommonSparseTable table;
+  auto table_config = SGDTableConfig(emb_dim, "none", "lru&1&0");
+  auto ret = table.Table::initialize(table_config, FsClientParameter());
+  ASSERT_EQ(ret, 0);
+  auto store = std::make_shared<InMemorySpillStore>();
+  table.set_spill_store(store);
+
+  FillConstantInitializer initializer({"fill_constant", "0.0"});
+  std::unordered_map<std::string, Initializer *> initializers = {
+      {"Param", &initializer}, {"LearningRate", &initializer}};
+  ValueBlock block(table_config.common(), &initializers, 11);
+  const uint64_t num_keys = block.max_rows() * 11 * 3;
+  std::vector<uint64_t> keys(num_keys);
+  for (uint64_t key = 0; key < num_keys; ++key) {
+    keys[key] = key;
+    store->Spill(key, {std::vector<float>(emb_dim, key), {1.0}}, 0);
+  }
+
+  std::vector<float> values(num_keys * emb_dim);
+  table.pull_sparse(values.data(), keys.data(), num_keys);
+  for (uint64_t key = 0; key < num_keys; ++key) {
+    ASSERT_EQ(values[key * emb_dim], static_cast<float>(key));
+    ASSERT_EQ(values[(key + 1) * emb_dim - 1], static_cast<float>(key));
+  }
+  // Each key is loaded from the store once, though most of them are evicted
+  // back by the following keys.
+  auto stats = table.entry_stats();
+  EXPECT_EQ(stats.reloaded, static_cast<int64_t>(num_keys));
+  EXPECT_GT(stats.evicted, 0);
+  EXPECT_LE(table.print_table_stat().first, block.max_rows() * 11);
+}
+
+TEST(CommonSparseTable, LFUCountDecay) {
+  int emb_dim = 8;
+  auto table_config = SGDTableConfig(emb_dim, "none", "lfu&1&0");
+  FillConstantInitializer initializer({"fill_constant", "0.0"});
+  std::unordered_map<std::string, Initializer *> initializers = {
+      {"Param", &initializer}, {"LearningRate", &initializer}};
+  ValueBlock block(table_config.common(), &initializers);
+
+  // The key 0 is hot only before the shrinks, which halve its count to 0.
+  for (int i = 0; i < 100; ++i) {
+    block.InitGet(0);
+  }
+  for (int day = 0; day < 7; ++day) {
+    block.Shrink();
+  }
+  EXPECT_EQ(block.GetValue(0)->count_, 0);
+
+  // Fill the block with the keys pulled twice, and the next new key evicts
+  // the key 0 first.
+  for (uint64_t key = 1; key <= static_cast<uint64_t>(block.max_rows());
+       ++key) {
+    block.InitGet(key);
+    block.InitGet(key);
+  }
+  EXPECT_EQ(block.GetValue(0), nullptr);
+  EXPECT_GT(block.stats().evicted, 0);
+
+  // The grad pushed to the evicted key creates the row again, without
+  // evicting the others.
+  auto rows = block.values_.size();
+  auto *value = block.GetPushValue(0);
+  ASSERT_NE(value, nullptr);
+  EXPECT_EQ(value->values_[0][0], 0.0);
+  EXPECT_EQ(block.stats().readmitted, 1);
+  EXPECT_EQ(block.stats().dropped, 0);
+  EXPECT_EQ(block.values_.size(), rows + 1);
+}
+
+TEST(CommonSparseTable, TTLEviction) {
+  int emb_dim = 8;
+  CommonSparseTable table;
+  auto table_config = SGDTableConfig(emb_dim, "none", "lru&0&2");
+  auto ret = table.Table::initialize(table_config, FsClientParameter());
+  ASSERT_EQ(ret, 0);
+
+  PullPushKeys(&table, emb_dim, {1, 2, 3});
+  table.shrink();
+  PullPushKeys(&table, emb_dim, {1});
+  table.shrink();
+  table.shrink();
+  // The keys 2 and 3 are not pulled in the last 3 shrinks.
+  EXPECT_EQ(table.print_table_stat().first, 1);
+  EXPECT_EQ(table.entry_stats().expired, 2);
+}
+
+TEST(CommonSparseTable, TTLEvictionWithSpill) {
+  int emb_dim = 8;
+  CommonSparseTable table;
+  auto table_config = SGDTableConfig(emb_dim, "none", "lru&0&2");
+  auto ret = table.Table::initialize(table_config, FsClientParameter());
+  ASSERT_EQ(ret, 0);
+  auto store = std::make_shared<InMemorySpillStore>();
+  table.set_spill_store(store);
+
+  // The rows spilled keep aging in the store, and are dropped once not
+  // pulled for more than the ttl, the same as the rows in memory.
+  store->Spill(100, {std::vector<float>(emb_dim, 1.0), {1.0}}, 1);
+  store->Spill(200, {std::vector<float>(emb_dim, 2.0), {1.0}}, 0);
+  table.shrink();
+  table.shrink();
+  EXPECT_FALSE(store->Contains(100));
+  EXPECT_TRUE(store->Contains(200));
+  EXPECT_EQ(table.entry_stats().expired, 1);
+
+  // The spilled row is loaded back by push_sparse_param, instead of being
+  // created again by the initializers.
+  uint64_t key = 200;
+  std::vector<float> param(emb_dim, 3.0);
+  table.push_sparse_param(&key, param.data(), 1);
+  EXPECT_FALSE(store->Contains(key));
+  EXPECT_EQ(table.entry_stats().reloaded, 1);
+  std::vector<float> value(emb_dim);
+  table.pull_sparse(value.data(), &key, 1);
+  EXPECT_EQ(value, param);
+}
+
+TEST(CommonSparseTable, RestoreEntryMeta) {
+  int emb_dim = 8;
+  auto table_config = SGDTableConfig(emb_dim, "none", "lfu&1&2");
+  FillConstantInitializer initializer({"fill_constant", "0.0"});
+  std::unordered_map<std::string, Initializer *> initializers = {
+      {"Param", &initializer}, {"LearningRate", &initializer}};
+  ValueBlock block(table_config.common(), &initializers);
+  auto store = std::make_shared<InMemorySpillStore>();
+  block.SetSpillStore(store);
+
+  // Fill the block with the key 0 pulled once and the others pulled twice,
+  // and the next new key after a shrink spills the key 0 first.
+  for (uint64_t key = 0; key < static_cast<uint64_t>(block.max_rows());
+       ++key) {
+    block.InitGet(key);
+    if (key > 0) {
+      block.InitGet(key);
+    }
+  }
+  block.Shrink();
+  block.InitGet(block.max_rows());
+  ASSERT_TRUE(store->Contains(0));
+  EXPECT_EQ(store->metas_[0].count, 0);
+  EXPECT_EQ(store->metas_[0].unseen_days, 1);
+
+  // The row restored keeps its count and the days it has not been pulled,
+  // so it still expires after the ttl.
+  std::vector<std::vector<float>> values;
+  EntryMeta meta;
+  ASSERT_TRUE(store->Load(0, &values, &meta));
+  auto *value = block.Restore(0, &values, meta);
+  EXPECT_EQ(value->count_, 0);
+  EXPECT_EQ(value->unseen_days_, 1);
+  block.Shrink();
+  block.Shrink();
+  EXPECT_EQ(block.GetValue(0), nullptr);
+  EXPECT_GT(block.stats().expired, 0);
+}
+
+// The latencies of pulling Zipfian keys from a table keeping a tenth of the
+// rows in the memory and the others on the local disk.
+TEST(BENCHMARK, TieredStorage) {
+  int emb_dim = 16;
+  const int num_keys = 1000000;
+  const int batch_size = 512;
+  CommonSparseTable table;
+  auto table_config = SGDTableConfig(emb_dim, "none", "lru&16&0");
+  table_config.mutable_common()->set_ssd_path("./tiered_storage_test");
+  auto ret = table.Table::initialize(table_config, FsClientParameter());
+  ASSERT_EQ(ret, 0);
+
+  // Create all the rows, most of which are evicted to the disk.
+  std::vector<uint64_t> all_keys(num_keys);
+  for (int i = 0; i < num_keys; ++i) {
+    all_keys[i] = i;
+  }
+  PullPushKeys(&table, emb_dim, all_keys);
+  auto rows = table.print_table_stat().first;
+  LOG(INFO) << "rows in memory: " << rows << " of " << num_keys;
+  EXPECT_LT(rows, num_keys / 5);
+
+  auto keys = ZipfianKeys(num_keys, 0.99, 200 * batch_size);
+  std::vector<float> values(batch_size * emb_dim);
+  std::vector<double> latencies;
+  for (size_t start = 0; start < keys.size(); start += batch_size) {
+    auto begin = std::chrono::steady_clock::now();
+    table.pull_sparse(values.data(), keys.data() + start, batch_size);
+    latencies.push_back(std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - begin)
+                            .count());
+  }
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&latencies](double p) {
+    return latencies[static_cast<size_t>(p * (latencies.size() - 1))];
+  };
+  LOG(INFO) << "pull latency of " << batch_size
+            << " keys, p50: " << percentile(0.5)
+            << " ms, p90: " << percentile(0.9)
+            << " ms, p99: " << percentile(0.99) << " ms, "
+            << table.entry_stats().ToString();
+  EXPECT_GT(table.entry_stats().reloaded, 0);
+}
+
 }  // namespace distributed
 }  // namespace paddle
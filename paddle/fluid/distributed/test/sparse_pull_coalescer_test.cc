@@ -0,0 +1,221 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps.pb.h"
+#include "paddle/fluid/distributed/service/sparse_pull_coalescer.h"
+#include "paddle/fluid/distributed/table/common_sparse_table.h"
+
+namespace paddle {
+namespace distributed {
+
+static void InitTable(CommonSparseTable *table, int emb_dim) {
+  TableParameter table_config;
+  table_config.set_table_class("CommonSparseTable");
+  table_config.set_shard_num(10);
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CommMergeAccessor");
+  accessor_config->set_embedx_dim(emb_dim);
+  CommonAccessorParameter *common_config = table_config.mutable_common();
+  common_config->set_name("sgd");
+  common_config->set_table_name("coalescer_test_table");
+  common_config->set_trainer_num(1);
+  common_config->add_params("Param");
+  common_config->add_dims(emb_dim);
+  common_config->add_initializers("uniform_random&0&-1.0&1.0");
+  common_config->add_params("LearningRate");
+  common_config->add_dims(1);
+  common_config->add_initializers("fill_constant&1.0");
+  ASSERT_EQ(table->Table::initialize(table_config, FsClientParameter()), 0);
+}
+
+// The table counts the keys pulled from it, and throws on the pulls of
+// kBadKey.
+class CheckedSparseTable : public CommonSparseTable {
+ public:
+  static constexpr uint64_t kBadKey = static_cast<uint64_t>(-1);
+
+  int32_t pull_sparse(float *values, const uint64_t *keys,
+                      size_t num) override {
+    pulled_key_num_ += num;
+    if (std::find(keys, keys + num, kBadKey) != keys + num) {
+      throw std::runtime_error("bad key");
+    }
+    return CommonSparseTable::pull_sparse(values, keys, num);
+  }
+
+  int64_t pulled_key_num() const { return pulled_key_num_; }
+
+ private:
+  std::atomic<int64_t> pulled_key_num_{0};
+};
+
+constexpr uint64_t CheckedSparseTable::kBadKey;
+
+// The keys of a batch, following the Zipf distribution of exponent 1 over
+// num_keys keys, so that the concurrent workers pull the same hot keys.
+static std::vector<uint64_t> ZipfianBatch(std::mt19937 *engine, int num_keys,
+                                          int batch_size) {
+  std::uniform_real_distribution<double> dist(0.0, 1.0);
+  std::vector<uint64_t> keys(batch_size);
+  for (auto &key : keys) {
+    key = static_cast<uint64_t>(std::pow(num_keys, dist(*engine))) - 1;
+  }
+  return keys;
+}
+
+TEST(SparsePullCoalescer, ConcurrentPulls) {
+  const int emb_dim = 8;
+  CheckedSparseTable table;
+  InitTable(&table, emb_dim);
+  SparsePullCoalescer coalescer(&table, 100);
+
+  std::vector<std::thread> workers;
+  for (int w = 0; w < 8; ++w) {
+    workers.emplace_back([&, w] {
+      std::mt19937 engine(w);
+      for (int i = 0; i < 50; ++i) {
+        auto keys = ZipfianBatch(&engine, 10000, 128);
+        std::vector<float> values(keys.size() * emb_dim);
+        std::vector<float> expected(keys.size() * emb_dim);
+        ASSERT_EQ(
+            coalescer.pull_sparse(values.data(), keys.data(), keys.size()), 0);
+        table.pull_sparse(expected.data(), keys.data(), keys.size());
+        for (size_t j = 0; j < values.size(); ++j) {
+          ASSERT_FLOAT_EQ(values[j], expected[j]);
+        }
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  EXPECT_EQ(coalescer.pull_num(), 8 * 50);
+  EXPECT_LE(coalescer.batch_num(), coalescer.pull_num());
+  EXPECT_LE(coalescer.unique_key_num(), coalescer.key_num());
+  // The duplicated keys of the merged pulls are pulled from the table once,
+  // besides the pulls of the expected values.
+  EXPECT_EQ(table.pulled_key_num(),
+            coalescer.key_num() + coalescer.unique_key_num());
+}
+
+TEST(SparsePullCoalescer, PullAfterException) {
+  const int emb_dim = 8;
+  CheckedSparseTable table;
+  InitTable(&table, emb_dim);
+  SparsePullCoalescer coalescer(&table, 1000);
+
+  std::vector<std::thread> workers;
+  std::atomic<int> failed_num{0};
+  for (int w = 0; w < 8; ++w) {
+    workers.emplace_back([&, w] {
+      std::vector<uint64_t> keys = {1, 2, 3};
+      if (w == 0) {
+        keys.push_back(CheckedSparseTable::kBadKey);
+      }
+      std::vector<float> values(keys.size() * emb_dim);
+      if (coalescer.pull_sparse(values.data(), keys.data(), keys.size()) !=
+          0) {
+        ++failed_num;
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  // The pull of the bad key fails, with the pulls merged with it.
+  EXPECT_GE(failed_num, 1);
+
+  // The failed batch does not block the next pulls.
+  std::vector<uint64_t> keys = {1, 2, 3};
+  std::vector<float> values(keys.size() * emb_dim);
+  EXPECT_EQ(coalescer.pull_sparse(values.data(), keys.data(), keys.size()), 0);
+}
+
+// The throughput of the pulls of the concurrent workers, with and without
+// merging them.
+TEST(SparsePullCoalescer, Benchmark) {
+  const int emb_dim = 16;
+  const int num_keys = 1000000;
+  const int batch_size = 512;
+  const int steps = 200;
+  CommonSparseTable table;
+  InitTable(&table, emb_dim);
+
+  // Create the rows the workers pull first, so that every run pulls from the
+  // same table.
+  for (int w = 0; w < 32; ++w) {
+    std::mt19937 engine(w);
+    std::vector<float> values(batch_size * emb_dim);
+    for (int i = 0; i < steps; ++i) {
+      auto keys = ZipfianBatch(&engine, num_keys, batch_size);
+      table.pull_sparse(values.data(), keys.data(), keys.size());
+    }
+  }
+
+  for (int num_workers : {1, 8, 32}) {
+    for (int window_us : {-1, 0, 200}) {
+      std::unique_ptr<SparsePullCoalescer> coalescer;
+      if (window_us >= 0) {
+        coalescer.reset(new SparsePullCoalescer(&table, window_us));
+      }
+      auto start = std::chrono::steady_clock::now();
+      std::vector<std::thread> workers;
+      for (int w = 0; w < num_workers; ++w) {
+        workers.emplace_back([&, w] {
+          std::mt19937 engine(w);
+          std::vector<float> values(batch_size * emb_dim);
+          for (int i = 0; i < steps; ++i) {
+            auto keys = ZipfianBatch(&engine, num_keys, batch_size);
+            if (coalescer) {
+              coalescer->pull_sparse(values.data(), keys.data(), keys.size());
+            } else {
+              table.pull_sparse(values.data(), keys.data(), keys.size());
+            }
+          }
+        });
+      }
+      for (auto &worker : workers) {
+        worker.join();
+      }
+      double seconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+      if (!coalescer) {
+        LOG(INFO) << num_workers << " workers, no coalescing: "
+                  << num_workers * steps / seconds << " pulls/s";
+        continue;
+      }
+      LOG(INFO) << num_workers << " workers, window " << window_us
+                << "us: " << num_workers * steps / seconds << " pulls/s, "
+                << coalescer->batch_num() << " batches, "
+                << coalescer->unique_key_num() << " of "
+                << coalescer->key_num() << " keys unique";
+    }
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
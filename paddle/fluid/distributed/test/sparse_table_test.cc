@@ -15,6 +15,7 @@ limitations under the License. */
 #include <ThreadPool.h>
 
 #include <unistd.h>
+#include <chrono>  // NOLINT
 #include <string>
 #include <thread>  // NOLINT
 
@@ -209,5 +210,179 @@ TEST(CommonSparseTable, Adam) {
   }
 }
 
+// CommonSparseTable + Adagrad
+TEST(CommonSparseTable, Adagrad) {
+  int emb_dim = 10;
+  float epsilon = 1.0e-6;
+
+  TableParameter table_config;
+  table_config.set_table_class("CommonSparseTable");
+  FsClientParameter fs_config;
+  Table *table = new CommonSparseTable();
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CommMergeAccessor");
+  CommonAccessorParameter *common_config = table_config.mutable_common();
+  common_config->set_name("adagrad");
+  common_config->set_table_name("adagrad_test_table");
+  common_config->set_trainer_num(1);
+  common_config->add_params("Param");
+  common_config->add_dims(emb_dim);
+  common_config->add_initializers("uniform_random&0&-1.0&1.0");
+  common_config->add_params("Moment");
+  common_config->add_dims(emb_dim);
+  common_config->add_initializers("fill_constant&0.0");
+  common_config->add_params("LearningRate");
+  common_config->add_dims(1);
+  common_config->add_initializers("fill_constant&0.5");
+  common_config->add_attributes("epsilon&f&1e-06");
+  auto ret = table->initialize(table_config, fs_config);
+  ASSERT_EQ(ret, 0);
+
+  std::vector<uint64_t> keys = {0, 1, 2, 3, 4};
+  std::vector<float> init_values(keys.size() * emb_dim);
+  table->pull_sparse(init_values.data(), keys.data(), keys.size());
+
+  std::vector<float> grads;
+  float start = 0.0;
+  for (size_t i = 0; i < keys.size() * emb_dim; ++i) {
+    grads.push_back(start);
+    start += 0.1;
+  }
+  // push twice to update the moment
+  table->push_sparse(keys.data(), grads.data(), keys.size());
+  table->push_sparse(keys.data(), grads.data(), keys.size());
+
+  std::vector<float> pull_values(keys.size() * emb_dim);
+  table->pull_sparse(pull_values.data(), keys.data(), keys.size());
+  for (size_t i = 0; i < init_values.size(); ++i) {
+    float param = init_values[i];
+    float moment = 0.0;
+    for (int t = 0; t < 2; ++t) {
+      moment += grads[i] * grads[i];
+      param -= 0.5 * grads[i] / (sqrt(moment) + epsilon);
+    }
+    ASSERT_NEAR(param, pull_values[i], 1e-5);
+  }
+}
+
+// CommonSparseTable + Ftrl
+TEST(CommonSparseTable, Ftrl) {
+  int emb_dim = 10;
+  float l1 = 0.1;
+  float l2 = 0.2;
+  float lr = 0.5;
+
+  TableParameter table_config;
+  table_config.set_table_class("CommonSparseTable");
+  FsClientParameter fs_config;
+  Table *table = new CommonSparseTable();
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CommMergeAccessor");
+  CommonAccessorParameter *common_config = table_config.mutable_common();
+  common_config->set_name("ftrl");
+  common_config->set_table_name("ftrl_test_table");
+  common_config->set_trainer_num(1);
+  common_config->add_params("Param");
+  common_config->add_dims(emb_dim);
+  common_config->add_initializers("uniform_random&0&-1.0&1.0");
+  common_config->add_params("SquaredAccumulator");
+  common_config->add_dims(emb_dim);
+  common_config->add_initializers("fill_constant&0.1");
+  common_config->add_params("LinearAccumulator");
+  common_config->add_dims(emb_dim);
+  common_config->add_initializers("fill_constant&0.0");
+  common_config->add_params("LearningRate");
+  common_config->add_dims(1);
+  common_config->add_initializers("fill_constant&0.5");
+  common_config->add_attributes("l1&f&0.1");
+  common_config->add_attributes("l2&f&0.2");
+  common_config->add_attributes("lr_power&f&-0.5");
+  auto ret = table->initialize(table_config, fs_config);
+  ASSERT_EQ(ret, 0);
+
+  std::vector<uint64_t> keys = {0, 1, 2, 3, 4};
+  std::vector<float> init_values(keys.size() * emb_dim);
+  table->pull_sparse(init_values.data(), keys.data(), keys.size());
+
+  std::vector<float> grads;
+  float start = -1.0;
+  for (size_t i = 0; i < keys.size() * emb_dim; ++i) {
+    grads.push_back(start);
+    start += 0.05;
+  }
+  table->push_sparse(keys.data(), grads.data(), keys.size());
+
+  std::vector<float> pull_values(keys.size() * emb_dim);
+  table->pull_sparse(pull_values.data(), keys.data(), keys.size());
+  for (size_t i = 0; i < init_values.size(); ++i) {
+    float g = grads[i];
+    float squared = 0.1;
+    float new_squared = squared + g * g;
+    float linear =
+        g - (sqrt(new_squared) - sqrt(squared)) / lr * init_values[i];
+    float param = 0.0;
+    if (fabs(linear) > l1) {
+      float x = (linear >= 0 ? l1 : -l1) - linear;
+      param = x / (sqrt(new_squared) / lr + 2 * l2);
+    }
+    ASSERT_NEAR(param, pull_values[i], 1e-5);
+  }
+}
+
+// The pushes per second of CommonSparseTable + Adam
+TEST(CommonSparseTable, AdamBenchmark) {
+  int emb_dim = 64;
+  int num_keys = 100000;
+  int repeat = 10;
+
+  TableParameter table_config;
+  table_config.set_table_class("CommonSparseTable");
+  FsClientParameter fs_config;
+  Table *table = new CommonSparseTable();
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CommMergeAccessor");
+  CommonAccessorParameter *common_config = table_config.mutable_common();
+  common_config->set_name("adam");
+  common_config->set_table_name("adam_benchmark_table");
+  common_config->set_trainer_num(1);
+  common_config->add_params("Param");
+  common_config->add_dims(emb_dim);
+  common_config->add_initializers("uniform_random&0&-1.0&1.0");
+  common_config->add_params("LearningRate");
+  common_config->add_dims(1);
+  common_config->add_initializers("fill_constant&1.0");
+  common_config->add_params("Moment1");
+  common_config->add_dims(emb_dim);
+  common_config->add_initializers("fill_constant&0.0");
+  common_config->add_params("Moment2");
+  common_config->add_dims(emb_dim);
+  common_config->add_initializers("fill_constant&0.0");
+  common_config->add_params("Beta1Pow");
+  common_config->add_dims(1);
+  common_config->add_initializers("fill_constant&1.0");
+  common_config->add_params("Beta2Pow");
+  common_config->add_dims(1);
+  common_config->add_initializers("fill_constant&1.0");
+  auto ret = table->initialize(table_config, fs_config);
+  ASSERT_EQ(ret, 0);
+
+  std::vector<uint64_t> keys(num_keys);
+  for (int i = 0; i < num_keys; ++i) {
+    keys[i] = i;
+  }
+  std::vector<float> values(num_keys * emb_dim, 0.01);
+  table->pull_sparse(values.data(), keys.data(), keys.size());
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < repeat; ++i) {
+    table->push_sparse(keys.data(), values.data(), keys.size());
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  LOG(INFO) << "CommonSparseTable Adam of dim " << emb_dim << ": "
+            << num_keys * repeat / seconds << " keys pushed per second";
+}
+
 }  // namespace distributed
 }  // namespace paddle
@@ -0,0 +1,118 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/table/ssd_sparse_store.h"
+
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace distributed {
+
+using Row = std::vector<std::vector<float>>;
+
+static Row MakeRow(uint64_t key, int version) {
+  return {{static_cast<float>(key), static_cast<float>(version), 1.0f},
+          {static_cast<float>(version % 7)}};
+}
+
+TEST(SsdSparseStore, SpillAndLoad) {
+  // The small segments of 100 rows are sealed and compacted often.
+  SsdSparseStore store("./ssd_sparse_store_test", {3, 1}, 100 * 36);
+  std::unordered_map<uint64_t, Row> rows;
+  std::mt19937 engine(2020);
+  for (int version = 0; version < 20000; ++version) {
+    uint64_t key = engine() % 2000;
+    if (engine() % 3) {
+      rows[key] = MakeRow(key, version);
+      store.Spill(key, rows[key], EntryMeta());
+      continue;
+    }
+    Row row;
+    EntryMeta meta;
+    bool loaded = store.Load(key, &row, &meta);
+    ASSERT_EQ(loaded, rows.count(key) > 0);
+    if (loaded) {
+      EXPECT_EQ(row, rows[key]);
+      rows.erase(key);
+    }
+  }
+  EXPECT_EQ(store.size(), static_cast<int64_t>(rows.size()));
+
+  // At most half of the sealed segments is garbage after the compaction.
+  store.Compact();
+  EXPECT_LE(store.disk_bytes(),
+            2 * static_cast<int64_t>(rows.size()) * 36 + 100 * 36);
+
+  int64_t count = 0;
+  store.ForEach([&](uint64_t key, const Row& row) {
+    ASSERT_EQ(rows.count(key), 1u);
+    EXPECT_EQ(row, rows[key]);
+    ++count;
+  });
+  EXPECT_EQ(count, static_cast<int64_t>(rows.size()));
+
+  // The keys not in the store, or taken out before, are loaded as empty.
+  std::vector<uint64_t> keys;
+  for (auto& item : rows) {
+    keys.push_back(item.first);
+  }
+  keys.push_back(100000);
+  keys.push_back(keys[0]);
+  std::vector<Row> values;
+  std::vector<EntryMeta> metas;
+  store.LoadBatch(keys, &values, &metas);
+  ASSERT_EQ(values.size(), keys.size());
+  for (size_t i = 0; i + 2 < keys.size(); ++i) {
+    EXPECT_EQ(values[i], rows[keys[i]]);
+  }
+  EXPECT_TRUE(values[keys.size() - 2].empty());
+  EXPECT_TRUE(values[keys.size() - 1].empty());
+  EXPECT_EQ(store.size(), 0);
+  EXPECT_FALSE(store.Contains(keys[0]));
+}
+
+TEST(SsdSparseStore, Shrink) {
+  SsdSparseStore store("./ssd_sparse_store_shrink_test", {3, 1}, 100 * 36);
+  for (uint64_t key = 0; key < 10; ++key) {
+    EntryMeta meta;
+    meta.count = static_cast<int>(key) * 2;
+    meta.unseen_days = static_cast<int>(key);
+    meta.seen_after_last_save = key % 2 == 0;
+    store.Spill(key, MakeRow(key, 0), meta);
+  }
+  // The rows not pulled for more than 5 days are dropped, with the days the
+  // rows were not pulled in the memory counted.
+  EXPECT_EQ(store.Shrink(5), 5);
+  EXPECT_EQ(store.size(), 5);
+  EXPECT_EQ(store.Shrink(5), 1);
+  for (uint64_t key = 0; key < 10; ++key) {
+    EXPECT_EQ(store.Contains(key), key < 4);
+  }
+  // The row loaded keeps its metadata, with the days aged by the shrinks.
+  store.Compact();
+  Row row;
+  EntryMeta meta;
+  ASSERT_TRUE(store.Load(3, &row, &meta));
+  EXPECT_EQ(row, MakeRow(3, 0));
+  EXPECT_EQ(meta.count, 6);
+  EXPECT_EQ(meta.unseen_days, 5);
+  EXPECT_FALSE(meta.seen_after_last_save);
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,116 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/table/depends/ssp_clock.h"
+
+namespace paddle {
+namespace distributed {
+
+TEST(SspClock, WaitForSlowest) {
+  SspClock clock(2, 1);
+  clock.Tick(0, 1);
+  EXPECT_EQ(clock.Wait(0), 1);
+
+  std::atomic<bool> done{false};
+  clock.Tick(0, 1);
+  std::thread fast([&] {
+    EXPECT_EQ(clock.Wait(0), 1);
+    done = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(done);
+  clock.Tick(1, 1);
+  fast.join();
+  EXPECT_TRUE(done);
+
+  // The finished worker no longer holds back the others.
+  clock.Tick(0, 5);
+  clock.Tick(1, -1);
+  EXPECT_EQ(clock.Wait(0), 0);
+  EXPECT_EQ(clock.clock(0), 7);
+}
+
+struct SimulationResult {
+  double steps_per_second;
+  int64_t max_ahead;
+};
+
+// The workers run steps of step_ms, but a step is ten times slower with the
+// probability of straggler_prob. A worker waits for the clock before the
+// pull of a step, and ticks it after the push.
+static SimulationResult Simulate(int worker_num, int staleness, int steps,
+                                 int step_ms, double straggler_prob) {
+  SspClock clock(worker_num, staleness);
+  std::atomic<int64_t> max_ahead{0};
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (int w = 0; w < worker_num; ++w) {
+    workers.emplace_back([&, w] {
+      std::mt19937 engine(w);
+      std::bernoulli_distribution straggle(straggler_prob);
+      for (int i = 0; i < steps; ++i) {
+        int64_t ahead = clock.Wait(w);
+        int64_t max = max_ahead.load();
+        while (ahead > max && !max_ahead.compare_exchange_weak(max, ahead)) {
+        }
+        int ms = straggle(engine) ? step_ms * 10 : step_ms;
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+        clock.Tick(w, 1);
+      }
+      clock.Tick(w, -1);
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+  return {worker_num * steps / seconds, max_ahead.load()};
+}
+
+// The throughput of the workers with stragglers, for the staleness from the
+// bulk synchronous mode to the asynchronous mode.
+TEST(SspClock, StragglerSimulation) {
+  const int worker_num = 8;
+  const int steps = 100;
+  const int unbounded = std::numeric_limits<int>::max();
+  std::vector<double> throughputs;
+  for (int staleness : {0, 1, 4, unbounded}) {
+    auto result = Simulate(worker_num, staleness, steps, 1, 0.1);
+    EXPECT_LE(result.max_ahead, staleness);
+    throughputs.push_back(result.steps_per_second);
+    LOG(INFO) << worker_num << " workers, staleness "
+              << (staleness == unbounded ? std::string("unbounded")
+                                         : std::to_string(staleness))
+              << ": " << result.steps_per_second << " steps/s, "
+              << result.max_ahead << " steps ahead of the slowest at most";
+  }
+  // A larger staleness absorbs more of the stragglers.
+  EXPECT_GT(throughputs.back(), throughputs.front());
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -15,6 +15,8 @@ limitations under the License. */
 #include <ThreadPool.h>
 
 #include <unistd.h>
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <string>
 #include <thread>  // NOLINT
 
@@ -38,5 +40,46 @@ TEST(Table, Initialize) {
   auto ret = table->initialize(table_config, fs_config);
   ASSERT_EQ(ret, -1);
 }
+
+// The pull of the fast trainer waits in wait_clock until the slow trainer
+// pushes its clock, in the bulk synchronous mode.
+TEST(Table, SspClock) {
+  TableParameter table_config;
+  table_config.set_table_class("CommonDenseTable");
+  FsClientParameter fs_config;
+  Table *table = new CommonDenseTable();
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CommMergeAccessor");
+  CommonAccessorParameter *common_config = table_config.mutable_common();
+  common_config->set_name("sgd");
+  common_config->set_table_name("ssp_test_table");
+  common_config->set_trainer_num(2);
+  common_config->set_ssp_staleness(0);
+  common_config->add_params("Param");
+  common_config->add_dims(10);
+  common_config->add_initializers("fill_constant&1.0");
+  common_config->add_params("LearningRate");
+  common_config->add_dims(1);
+  common_config->add_initializers("fill_constant&1.0");
+  ASSERT_EQ(table->initialize(table_config, fs_config), 0);
+
+  ASSERT_EQ(table->push_clock(0, 1), 0);
+  std::atomic<bool> pulled{false};
+  std::thread fast([&] {
+    table->wait_clock(0);
+    pulled = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(pulled);
+  ASSERT_EQ(table->push_clock(1, 1), 0);
+  fast.join();
+  EXPECT_TRUE(pulled);
+
+  // The finished trainer no longer holds back the other.
+  table->push_clock(0, 3);
+  table->push_clock(1, -1);
+  EXPECT_EQ(table->wait_clock(0), 0);
+  delete table;
+}
 }  // namespace distributed
 }  // // namespace paddle
@@ -35,6 +35,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/feed_fetch_type.h"
 #include "paddle/fluid/framework/fleet/box_wrapper.h"
 #include "paddle/fluid/framework/fleet/fleet_wrapper.h"
+#include "paddle/fluid/platform/chrome_tracing_recorder.h"
 #include "paddle/fluid/platform/monitor.h"
 #include "paddle/fluid/platform/timer.h"
 
@@ -211,6 +212,8 @@ template <typename T>
 int PrivateQueueDataFeed<T>::Next() {
 #ifdef _LINUX
   CheckStart();
+  platform::RecordTraceEvent trace_event("DataFeedNext",
+                                         platform::kTraceCategoryReader);
   int index = 0;
   T ins_vec;
   while (index < default_batch_size_) {
@@ -268,6 +271,8 @@ template <typename T>
 int InMemoryDataFeed<T>::Next() {
 #ifdef _LINUX
   this->CheckStart();
+  platform::RecordTraceEvent trace_event("DataFeedNext",
+                                         platform::kTraceCategoryReader);
   CHECK(output_channel_ != nullptr);
   CHECK(consume_channel_ != nullptr);
   VLOG(3) << "output_channel_ size=" << output_channel_->Size()
@@ -1211,6 +1216,8 @@ void PrivateInstantDataFeed<T>::PutToFeedVec() {
 
 template <typename T>
 int PrivateInstantDataFeed<T>::Next() {
+  platform::RecordTraceEvent trace_event("DataFeedNext",
+                                         platform::kTraceCategoryReader);
   if (ParseOneMiniBatch()) {
     PutToFeedVec();
     return ins_vec_[0].GetBatchSize();
@@ -1419,6 +1426,9 @@ int PaddleBoxDataFeed::Next() {
   this->CheckStart();
   if (enable_pv_merge_ && phase == 1) {
     // join phase : output_pv_channel to consume_pv_channel
+    // Otherwise InMemoryDataFeed::Next records the event
+    platform::RecordTraceEvent trace_event("DataFeedNext",
+                                           platform::kTraceCategoryReader);
     CHECK(output_pv_channel_ != nullptr);
     CHECK(consume_pv_channel_ != nullptr);
     VLOG(3) << "output_pv_channel_ size=" << output_pv_channel_->Size()
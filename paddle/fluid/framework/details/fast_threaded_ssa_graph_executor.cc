@@ -13,7 +13,10 @@
 // limitations under the License.
 #include "paddle/fluid/framework/details/fast_threaded_ssa_graph_executor.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT
 #include <deque>
+#include <limits>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -26,10 +29,93 @@
 #include "paddle/fluid/framework/ir/graph_helper.h"
 #include "paddle/fluid/platform/profiler.h"
 
+DECLARE_bool(fast_executor_priority_scheduling);
+DECLARE_int32(fast_executor_inline_op_us);
+
 namespace paddle {
 namespace framework {
 namespace details {
 
+// An op transferring data between devices is counted as several computation
+// ops in the critical path, so that the ops producing its inputs run earlier.
+static constexpr int64_t kMultiDeviceTransferWeight = 4;
+// The ops transferring data between devices and the ops of the highest
+// priority are scheduled before all the other ops.
+static constexpr int64_t kFirstPriority =
+    std::numeric_limits<int64_t>::max() / 2;
+
+ReadyOpQueues::ReadyOpQueues(size_t num_shards) {
+  num_shards = std::max<size_t>(num_shards, 1);
+  for (size_t i = 0; i < num_shards; ++i) {
+    shards_.emplace_back(new Shard());
+  }
+}
+
+size_t ReadyOpQueues::LocalShard() const {
+  static std::atomic<size_t> num_threads{0};
+  thread_local size_t thread_id = num_threads++;
+  return thread_id % shards_.size();
+}
+
+void ReadyOpQueues::Push(OpHandleBase *op, int64_t priority) {
+  auto *shard = shards_[LocalShard()].get();
+  std::lock_guard<std::mutex> guard(shard->mutex);
+  shard->heap.emplace_back(priority, op);
+  std::push_heap(shard->heap.begin(), shard->heap.end());
+}
+
+OpHandleBase *ReadyOpQueues::PopLocked(Shard *shard) {
+  if (shard->heap.empty()) {
+    return nullptr;
+  }
+  std::pop_heap(shard->heap.begin(), shard->heap.end());
+  auto *op = shard->heap.back().second;
+  shard->heap.pop_back();
+  return op;
+}
+
+OpHandleBase *ReadyOpQueues::Pop() {
+  size_t local = LocalShard();
+  {
+    auto *shard = shards_[local].get();
+    std::lock_guard<std::mutex> guard(shard->mutex);
+    auto *op = PopLocked(shard);
+    if (op != nullptr) {
+      return op;
+    }
+  }
+  // Steal the op of the highest priority from the other shards. If the shard
+  // is emptied by others after peeking, try again.
+  while (true) {
+    Shard *victim = nullptr;
+    int64_t max_priority = 0;
+    for (size_t i = 1; i < shards_.size(); ++i) {
+      auto *shard = shards_[(local + i) % shards_.size()].get();
+      std::lock_guard<std::mutex> guard(shard->mutex);
+      if (!shard->heap.empty() &&
+          (victim == nullptr || shard->heap.front().first > max_priority)) {
+        victim = shard;
+        max_priority = shard->heap.front().first;
+      }
+    }
+    if (victim == nullptr) {
+      return nullptr;
+    }
+    std::lock_guard<std::mutex> guard(victim->mutex);
+    auto *op = PopLocked(victim);
+    if (op != nullptr) {
+      return op;
+    }
+  }
+}
+
+void ReadyOpQueues::Clear() {
+  for (auto &shard : shards_) {
+    std::lock_guard<std::mutex> guard(shard->mutex);
+    shard->heap.clear();
+  }
+}
+
 FastThreadedSSAGraphExecutor::FastThreadedSSAGraphExecutor(
     const ExecutionStrategy &strategy, const std::vector<Scope *> &local_scopes,
     const std::vector<Scope *> &local_exec_scopes,
@@ -53,6 +139,9 @@ FastThreadedSSAGraphExecutor::FastThreadedSSAGraphExecutor(
   PADDLE_ENFORCE_GT(op_deps_.size(), 0,
                     platform::errors::PreconditionNotMet(
                         "The graph doesn't have operators."));
+  if (FLAGS_fast_executor_priority_scheduling) {
+    PrepareOpPriority();
+  }
   PrepareAtomicOpDeps();
 }
 
@@ -95,11 +184,18 @@ FetchResultType FastThreadedSSAGraphExecutor::Run(
     traced_ops_.clear();
     remaining_ = 0;
     auto complete_q = std::make_shared<BlockingQueue<size_t>>();
-    for (auto op : bootstrap_ops_) {
-      RunOpAsync(op_deps.get(), op, complete_q);
-    }
-    for (auto op : ready_fetch_ops) {
-      RunOpAsync(op_deps.get(), op, complete_q);
+    if (ready_ops_) {
+      std::vector<OpHandleBase *> ready_ops(bootstrap_ops_);
+      ready_ops.insert(ready_ops.end(), ready_fetch_ops.begin(),
+                       ready_fetch_ops.end());
+      PushReadyOps(op_deps.get(), ready_ops, complete_q);
+    } else {
+      for (auto op : bootstrap_ops_) {
+        RunOpAsync(op_deps.get(), op, complete_q);
+      }
+      for (auto op : ready_fetch_ops) {
+        RunOpAsync(op_deps.get(), op, complete_q);
+      }
     }
 
     size_t num_complete = 0;
@@ -117,11 +213,20 @@ FetchResultType FastThreadedSSAGraphExecutor::Run(
           }
         }
         if (exception_.IsCaught()) {
+          // All the workers have exited, but the ops they pushed are left.
+          if (ready_ops_) {
+            ready_ops_->Clear();
+          }
           ExecutionFinal(&fetch_ops);
         }
       }
       num_complete += num_comp;
     }
+    // The workers which find no op to run may still be alive, wait for them
+    // so that they never pop the ops of the next run.
+    while (remaining_ > 0) {
+      complete_q->Pop();
+    }
   }
   // Wait FetchOps.
   ClearFetchOp(graph_, &fetch_ops);
@@ -285,6 +390,173 @@ void FastThreadedSSAGraphExecutor::RunOpAsync(
   });
 }
 
+void FastThreadedSSAGraphExecutor::PushReadyOps(
+    std::unordered_map<OpHandleBase *, std::atomic<int>> *op_deps,
+    const std::vector<OpHandleBase *> &ops,
+    const std::shared_ptr<BlockingQueue<size_t>> &complete_q) {
+  for (auto *op : ops) {
+    ready_ops_->Push(op, OpPriority(op));
+  }
+  // Wake up a worker for each op, but no more than the threads, since a
+  // worker keeps popping the op of the highest priority in the queues until
+  // they are empty.
+  size_t num_workers = std::min(ops.size(), strategy_.num_threads_);
+  for (size_t i = 0; i < num_workers; ++i) {
+    RunOpAsyncByPriority(op_deps, nullptr, complete_q);
+  }
+}
+
+void FastThreadedSSAGraphExecutor::RunOpAsyncByPriority(
+    std::unordered_map<OpHandleBase *, std::atomic<int>> *op_deps,
+    OpHandleBase *op,
+    const std::shared_ptr<BlockingQueue<size_t>> &complete_q) {
+  ++remaining_;
+  this->pool_.enqueue([=] {
+    // The ops to run on this thread without switching, which are the cheap
+    // ops and the ready op of the highest priority, in a heap by priority.
+    std::vector<std::pair<int64_t, OpHandleBase *>> local_ops;
+    auto push_local_op = [this, &local_ops](OpHandleBase *local_op) {
+      local_ops.emplace_back(OpPriority(local_op), local_op);
+      std::push_heap(local_ops.begin(), local_ops.end());
+    };
+    if (op != nullptr) {
+      push_local_op(op);
+    }
+
+    size_t complete = 0;
+    while (true) {
+      // Stop taking ops once an op of this run throws, the ready ops left in
+      // the queues are cleared by Run.
+      if (exception_.IsCaught()) {
+        break;
+      }
+      OpHandleBase *op_to_run = nullptr;
+      if (local_ops.empty()) {
+        op_to_run = ready_ops_->Pop();
+        if (op_to_run == nullptr) {
+          break;
+        }
+      } else {
+        std::pop_heap(local_ops.begin(), local_ops.end());
+        op_to_run = local_ops.back().second;
+        local_ops.pop_back();
+      }
+
+      // The multi device op may block this thread, so let the other threads
+      // run the local ops. See RunOpAsync.
+      if (op_to_run->IsMultiDeviceTransfer() && !local_ops.empty()) {
+        std::vector<OpHandleBase *> ops;
+        ops.reserve(local_ops.size());
+        for (auto &local_op : local_ops) {
+          ops.emplace_back(local_op.second);
+        }
+        PushReadyOps(op_deps, ops, complete_q);
+        local_ops.clear();
+      }
+
+      auto start = std::chrono::steady_clock::now();
+      if (!RunOp(op_to_run, complete_q, &complete)) {
+        return;
+      }
+      auto run_ns_it = op_run_ns_.find(op_to_run);
+      if (run_ns_it != op_run_ns_.end()) {
+        run_ns_it->second =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+      }
+
+      OpHandleBase *next_op = nullptr;
+      for (auto &output : op_to_run->Outputs()) {
+        for (auto &pending_op : output->PendingOps()) {
+          std::atomic<int> &deps = op_deps->at(pending_op);
+          if (deps.fetch_sub(1) != 1) continue;
+
+          if (IsCheapOp(pending_op)) {
+            push_local_op(pending_op);
+          } else if (next_op == nullptr) {
+            next_op = pending_op;
+          } else {
+            OpHandleBase *other_op = pending_op;
+            if (OpPriority(other_op) > OpPriority(next_op)) {
+              std::swap(other_op, next_op);
+            }
+            PushReadyOps(op_deps, {other_op}, complete_q);
+          }
+        }
+      }
+      if (next_op != nullptr) {
+        push_local_op(next_op);
+      }
+    }
+    --remaining_;
+    complete_q->Push(complete);
+  });
+}
+
+void FastThreadedSSAGraphExecutor::PrepareOpPriority() {
+  // Sort the ops topologically in the order they get ready at runtime.
+  std::unordered_map<OpHandleBase *, int> pending_deps(op_deps_.begin(),
+                                                       op_deps_.end());
+  std::vector<OpHandleBase *> sorted_ops(bootstrap_ops_);
+  for (size_t i = 0; i < sorted_ops.size(); ++i) {
+    for (auto &output : sorted_ops[i]->Outputs()) {
+      for (auto &pending_op : output->PendingOps()) {
+        auto it = pending_deps.find(pending_op);
+        if (it != pending_deps.end() && --it->second == 0) {
+          sorted_ops.emplace_back(pending_op);
+        }
+      }
+    }
+  }
+
+  std::unordered_map<OpHandleBase *, int64_t> path_length;
+  for (auto it = sorted_ops.rbegin(); it != sorted_ops.rend(); ++it) {
+    auto *op = *it;
+    int64_t length = 0;
+    for (auto &output : op->Outputs()) {
+      for (auto &pending_op : output->PendingOps()) {
+        auto pending_it = path_length.find(pending_op);
+        if (pending_it != path_length.end()) {
+          length = std::max(length, pending_it->second);
+        }
+      }
+    }
+    path_length[op] =
+        length + (op->IsMultiDeviceTransfer() ? kMultiDeviceTransferWeight : 1);
+  }
+
+  for (auto &pair : path_length) {
+    auto *op = pair.first;
+    bool first = op->IsMultiDeviceTransfer() ||
+                 op->GetPriority() == OpHandleBase::Priority::kHighest;
+    op_priority_[op] = first ? kFirstPriority + pair.second : pair.second;
+    op_run_ns_[op] = -1;
+  }
+  ready_ops_.reset(new ReadyOpQueues(strategy_.num_threads_));
+  VLOG(3) << "Schedule " << op_priority_.size()
+          << " ops by priority, the longest path has "
+          << (sorted_ops.empty() ? 0 : path_length[sorted_ops.front()])
+          << " ops";
+}
+
+int64_t FastThreadedSSAGraphExecutor::OpPriority(OpHandleBase *op) const {
+  auto it = op_priority_.find(op);
+  return it != op_priority_.end() ? it->second : 0;
+}
+
+bool FastThreadedSSAGraphExecutor::IsCheapOp(OpHandleBase *op) const {
+  if (FLAGS_fast_executor_inline_op_us <= 0 || op->IsMultiDeviceTransfer()) {
+    return false;
+  }
+  auto it = op_run_ns_.find(op);
+  if (it == op_run_ns_.end()) {
+    return false;
+  }
+  int64_t run_ns = it->second;
+  return run_ns >= 0 && run_ns < FLAGS_fast_executor_inline_op_us * 1000LL;
+}
+
 void FastThreadedSSAGraphExecutor::PrepareAtomicOpDeps() {
   atomic_op_deps_ = prepare_pool_.enqueue([&] {
     auto *op_deps = new std::unordered_map<OpHandleBase *, std::atomic<int>>;
@@ -15,8 +15,10 @@
 #pragma once
 #include <ThreadPool.h>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 #include "paddle/fluid/framework/blocking_queue.h"
 #include "paddle/fluid/framework/details/exception_holder.h"
@@ -29,6 +31,38 @@ class Scope;
 namespace details {
 
 class OpHandleBase;
+
+// The ready ops ordered by priority, sharded by the worker threads. A worker
+// pushes to and pops from its own shard, and steals the op of the highest
+// priority from the other shards when its own shard is empty.
+class ReadyOpQueues {
+ public:
+  explicit ReadyOpQueues(size_t num_shards);
+
+  void Push(OpHandleBase *op, int64_t priority);
+
+  // Return nullptr if all the shards are empty.
+  OpHandleBase *Pop();
+
+  // Drop the ops left by a run stopped by an exception, which must not be
+  // run by the next run.
+  void Clear();
+
+ private:
+  using Item = std::pair<int64_t, OpHandleBase *>;
+
+  struct Shard {
+    std::mutex mutex;
+    std::vector<Item> heap;
+  };
+
+  size_t LocalShard() const;
+
+  static OpHandleBase *PopLocked(Shard *shard);
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
 class FastThreadedSSAGraphExecutor : public SSAGraphExecutor {
  public:
   FastThreadedSSAGraphExecutor(const ExecutionStrategy &strategy,
@@ -65,6 +99,14 @@ class FastThreadedSSAGraphExecutor : public SSAGraphExecutor {
 
   std::vector<OpHandleBase *> traced_ops_;
 
+  // Used if FLAGS_fast_executor_priority_scheduling is true. The priority of
+  // an op is the length of the longest path from it to the sinks of the
+  // graph, and the ops that transfer data between devices come first.
+  std::unordered_map<OpHandleBase *, int64_t> op_priority_;
+  // The wall time of the last run of each op in nanoseconds, -1 if unknown.
+  std::unordered_map<OpHandleBase *, std::atomic<int64_t>> op_run_ns_;
+  std::unique_ptr<ReadyOpQueues> ready_ops_;
+
   bool RunOp(OpHandleBase *op,
              const std::shared_ptr<BlockingQueue<size_t>> &complete_q,
              size_t *complete);
@@ -73,6 +115,22 @@ class FastThreadedSSAGraphExecutor : public SSAGraphExecutor {
                   OpHandleBase *op,
                   const std::shared_ptr<BlockingQueue<size_t>> &complete_q);
 
+  void RunOpAsyncByPriority(
+      std::unordered_map<OpHandleBase *, std::atomic<int>> *op_deps,
+      OpHandleBase *op,
+      const std::shared_ptr<BlockingQueue<size_t>> &complete_q);
+
+  void PushReadyOps(
+      std::unordered_map<OpHandleBase *, std::atomic<int>> *op_deps,
+      const std::vector<OpHandleBase *> &ops,
+      const std::shared_ptr<BlockingQueue<size_t>> &complete_q);
+
+  void PrepareOpPriority();
+
+  int64_t OpPriority(OpHandleBase *op) const;
+
+  bool IsCheapOp(OpHandleBase *op) const;
+
   void PrepareAtomicOpDeps();
 
   inline void RecordOps(OpHandleBase *op);
@@ -0,0 +1,343 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/details/fast_threaded_ssa_graph_executor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <numeric>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/details/op_handle_base.h"
+#include "paddle/fluid/framework/details/var_handle.h"
+#include "paddle/fluid/framework/ir/graph.h"
+#include "paddle/fluid/framework/program_desc.h"
+
+DECLARE_bool(fast_executor_priority_scheduling);
+
+namespace paddle {
+namespace framework {
+namespace details {
+
+// Busy wait for cost_us to simulate a computation op, or sleep for cost_us to
+// simulate a communication op.
+class SpinOpHandle : public OpHandleBase {
+ public:
+  SpinOpHandle(ir::Node *node, int cost_us, bool is_comm,
+               std::atomic<int> *num_run)
+      : OpHandleBase(node),
+        cost_us_(cost_us),
+        is_comm_(is_comm),
+        num_run_(num_run) {}
+
+  std::string Name() const override { return is_comm_ ? "comm" : "spin"; }
+
+  bool IsMultiDeviceTransfer() override { return is_comm_; }
+
+ protected:
+  void RunImpl() override {
+    if (is_comm_) {
+      std::this_thread::sleep_for(std::chrono::microseconds(cost_us_));
+    } else {
+      auto end = std::chrono::steady_clock::now() +
+                 std::chrono::microseconds(cost_us_);
+      while (std::chrono::steady_clock::now() < end) {
+      }
+    }
+    ++(*num_run_);
+  }
+
+  std::vector<Scope *> GetLocalScopes() override { return {}; }
+
+ private:
+  int cost_us_;
+  bool is_comm_;
+  std::atomic<int> *num_run_;
+};
+
+class TrainingGraph {
+ public:
+  // Build a graph like the one of data parallel training, which has
+  // num_layers forward layers and backward layers of small ops, and the
+  // gradient of each layer is all reduced before updating the parameter.
+  TrainingGraph(int num_layers, int ops_per_layer) : graph_(program_) {
+    VarHandleBase *x = AddOp({}, 1, false);
+    for (int i = 0; i < num_layers; ++i) {
+      for (int j = 0; j < ops_per_layer; ++j) {
+        x = AddOp({x}, 5, false);
+        // Such as the shape or fill_constant op
+        AddOp({x}, 1, false);
+      }
+    }
+    for (int i = 0; i < num_layers; ++i) {
+      VarHandleBase *grad = x;
+      for (int j = 0; j < ops_per_layer; ++j) {
+        grad = AddOp({grad}, 5, false);
+      }
+      // The backward of the next layer does not depend on the all reduce
+      VarHandleBase *reduced = AddOp({grad}, 300, true);
+      AddOp({reduced}, 20, false);
+      x = grad;
+    }
+  }
+
+  ir::Graph *graph() { return &graph_; }
+
+  int num_ops() const { return num_ops_; }
+
+  int num_run() const { return num_run_; }
+
+ private:
+  VarHandleBase *AddOp(const std::vector<VarHandleBase *> &inputs,
+                       int cost_us, bool is_comm) {
+    ir::Node *op_node =
+        graph_.CreateEmptyNode("spin", ir::Node::Type::kOperation);
+    auto *op = new SpinOpHandle(op_node, cost_us, is_comm, &num_run_);
+    for (auto *input : inputs) {
+      op->AddInput(input);
+    }
+    ir::Node *var_node =
+        graph_.CreateEmptyNode("var", ir::Node::Type::kVariable);
+    auto *output = new DummyVarHandle(var_node);
+    op->AddOutput(output);
+    ++num_ops_;
+    return output;
+  }
+
+  ProgramDesc program_;
+  ir::Graph graph_;
+  int num_ops_{0};
+  std::atomic<int> num_run_{0};
+};
+
+// Return the average time of an iteration in milliseconds
+static double RunGraph(bool priority_scheduling, int num_iters) {
+  TrainingGraph graph(/*num_layers=*/20, /*ops_per_layer=*/10);
+  ExecutionStrategy strategy;
+  strategy.num_threads_ = 4;
+  strategy.use_device_ = p::kCPU;
+  FLAGS_fast_executor_priority_scheduling = priority_scheduling;
+  FastThreadedSSAGraphExecutor executor(strategy, {}, {},
+                                        {platform::CPUPlace()}, graph.graph());
+  FLAGS_fast_executor_priority_scheduling = false;
+
+  // Warm up, so that the cost of each op is known
+  executor.Run({}, true);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_iters; ++i) {
+    executor.Run({}, true);
+  }
+  double ms = std::chrono::duration<double, std::milli>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+  EXPECT_EQ(graph.num_run(), graph.num_ops() * (num_iters + 1));
+  return ms / num_iters;
+}
+
+TEST(FastThreadedSSAGraphExecutor, PriorityScheduling) {
+  RunGraph(/*priority_scheduling=*/true, /*num_iters=*/3);
+}
+
+TEST(FastThreadedSSAGraphExecutor, IterationTime) {
+  const int kIters = 20;
+  double default_ms = RunGraph(false, kIters);
+  double priority_ms = RunGraph(true, kIters);
+  LOG(INFO) << "Iteration time of the training graph, default: " << default_ms
+            << " ms, priority scheduling: " << priority_ms << " ms";
+}
+
+// Record the order the ops run in, check that every op runs after the ops
+// producing its inputs in the same run, and throw EOF in the op of fail_id.
+struct RunLog {
+  std::mutex mutex;
+  std::vector<int> order;
+  int run_id{0};
+  int fail_id{-1};
+  std::atomic<int> violations{0};
+};
+
+class RecordOpHandle : public OpHandleBase {
+ public:
+  RecordOpHandle(ir::Node *node, int id, RunLog *log)
+      : OpHandleBase(node), id_(id), log_(log) {}
+
+  std::string Name() const override { return "record"; }
+
+  int last_run() const { return last_run_; }
+
+ protected:
+  void RunImpl() override {
+    for (auto *input : Inputs()) {
+      auto *producer = dynamic_cast<RecordOpHandle *>(input->GeneratedOp());
+      if (producer != nullptr && producer->last_run() != log_->run_id) {
+        ++log_->violations;
+      }
+    }
+    if (log_->fail_id == id_) {
+      PADDLE_THROW_EOF();
+    }
+    // Busy for a while, so that the other ops get ready in the meantime.
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+    {
+      std::lock_guard<std::mutex> guard(log_->mutex);
+      log_->order.push_back(id_);
+    }
+    last_run_ = log_->run_id;
+  }
+
+  std::vector<Scope *> GetLocalScopes() override { return {}; }
+
+ private:
+  int id_;
+  RunLog *log_;
+  std::atomic<int> last_run_{-1};
+};
+
+class RecordGraph {
+ public:
+  RecordGraph() : graph_(program_) {}
+
+  // Add an op of the id num_ops(), and return its output.
+  VarHandleBase *AddOp(const std::vector<VarHandleBase *> &inputs) {
+    ir::Node *op_node =
+        graph_.CreateEmptyNode("record", ir::Node::Type::kOperation);
+    auto *op = new RecordOpHandle(op_node, num_ops_++, &log_);
+    for (auto *input : inputs) {
+      op->AddInput(input);
+    }
+    ir::Node *var_node =
+        graph_.CreateEmptyNode("var", ir::Node::Type::kVariable);
+    auto *output = new DummyVarHandle(var_node);
+    op->AddOutput(output);
+    return output;
+  }
+
+  // Run the graph and return the order of the ops.
+  std::vector<int> Run(FastThreadedSSAGraphExecutor *executor) {
+    log_.order.clear();
+    ++log_.run_id;
+    executor->Run({}, true);
+    return log_.order;
+  }
+
+  ir::Graph *graph() { return &graph_; }
+  RunLog *log() { return &log_; }
+  int num_ops() const { return num_ops_; }
+
+ private:
+  ProgramDesc program_;
+  ir::Graph graph_;
+  RunLog log_;
+  int num_ops_{0};
+};
+
+static std::unique_ptr<FastThreadedSSAGraphExecutor> NewExecutor(
+    ir::Graph *graph, int num_threads) {
+  ExecutionStrategy strategy;
+  strategy.num_threads_ = num_threads;
+  strategy.use_device_ = p::kCPU;
+  FLAGS_fast_executor_priority_scheduling = true;
+  std::unique_ptr<FastThreadedSSAGraphExecutor> executor(
+      new FastThreadedSSAGraphExecutor(strategy, {}, {},
+                                       {platform::CPUPlace()}, graph));
+  FLAGS_fast_executor_priority_scheduling = false;
+  return executor;
+}
+
+TEST(FastThreadedSSAGraphExecutor, CriticalPathFirst) {
+  // 0 -> 1, and 0 -> 2 -> 3 -> 4. The op 2 is on the longest path, so it
+  // runs before the op 1 on a single thread.
+  RecordGraph graph;
+  auto *x = graph.AddOp({});
+  graph.AddOp({x});
+  graph.AddOp({graph.AddOp({graph.AddOp({x})})});
+  auto executor = NewExecutor(graph.graph(), 1);
+  EXPECT_EQ(graph.Run(executor.get()), std::vector<int>({0, 2, 3, 4, 1}));
+  EXPECT_EQ(graph.log()->violations, 0);
+}
+
+TEST(FastThreadedSSAGraphExecutor, RunAfterException) {
+  // The op 0 feeds a long chain starting at the op 1 and 8 leaves. The op 1
+  // of the highest priority throws, while the leaves are left in the ready
+  // queues.
+  RecordGraph graph;
+  auto *x = graph.AddOp({});
+  auto *chain = graph.AddOp({x});
+  for (int i = 0; i < 8; ++i) {
+    graph.AddOp({x});
+  }
+  for (int i = 0; i < 4; ++i) {
+    chain = graph.AddOp({chain});
+  }
+  for (int num_threads : {1, 4}) {
+    auto executor = NewExecutor(graph.graph(), num_threads);
+    graph.log()->fail_id = 1;
+    EXPECT_THROW(graph.Run(executor.get()), platform::EOFException);
+
+    // The next run runs every op once, after its inputs.
+    graph.log()->fail_id = -1;
+    for (int i = 0; i < 2; ++i) {
+      auto order = graph.Run(executor.get());
+      std::sort(order.begin(), order.end());
+      std::vector<int> expected(graph.num_ops());
+      std::iota(expected.begin(), expected.end(), 0);
+      EXPECT_EQ(order, expected);
+    }
+  }
+  EXPECT_EQ(graph.log()->violations, 0);
+}
+
+TEST(ReadyOpQueues, PopByPriority) {
+  ReadyOpQueues queues(1);
+  auto *op1 = reinterpret_cast<OpHandleBase *>(0x10);
+  auto *op2 = reinterpret_cast<OpHandleBase *>(0x20);
+  auto *op3 = reinterpret_cast<OpHandleBase *>(0x30);
+  queues.Push(op1, 1);
+  queues.Push(op2, 3);
+  queues.Push(op3, 2);
+  EXPECT_EQ(queues.Pop(), op2);
+  EXPECT_EQ(queues.Pop(), op3);
+  EXPECT_EQ(queues.Pop(), op1);
+  EXPECT_EQ(queues.Pop(), nullptr);
+}
+
+TEST(ReadyOpQueues, Steal) {
+  ReadyOpQueues queues(4);
+  std::vector<OpHandleBase *> ops;
+  for (int i = 1; i <= 8; ++i) {
+    ops.emplace_back(reinterpret_cast<OpHandleBase *>(i * 0x10));
+  }
+  // Push from another thread, which uses another shard.
+  std::thread pusher([&] {
+    for (int i = 0; i < 8; ++i) {
+      queues.Push(ops[i], i);
+    }
+  });
+  pusher.join();
+  for (int i = 7; i >= 0; --i) {
+    EXPECT_EQ(queues.Pop(), ops[i]);
+  }
+  EXPECT_EQ(queues.Pop(), nullptr);
+}
+
+}  // namespace details
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,216 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "paddle/fluid/framework/ir/embedding_seqpool_cvm_concat_fuse_pass.h"
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "paddle/fluid/framework/ir/graph_helper.h"
+#include "paddle/fluid/framework/ir/graph_pattern_detector.h"
+#include "paddle/fluid/framework/op_proto_maker.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+class Graph;
+class Node;
+
+namespace {
+struct SlotNodes {
+  Node* ids{nullptr};
+  Node* w{nullptr};
+  Node* cvm{nullptr};
+  bool use_cvm{true};
+  int64_t padding_idx{-1};
+  bool is_sparse{false};
+  // The operators and the intermediate variables of the slot to be removed.
+  std::vector<Node*> removed;
+};
+
+// Return the variable of the argument of op, or nullptr if the argument does
+// not hold exactly one variable.
+static Node* GetInputVar(Node* op, const std::string& argument) {
+  auto& inputs = op->Op()->Inputs();
+  auto it = inputs.find(argument);
+  if (it == inputs.end() || it->second.size() != 1) return nullptr;
+  for (auto* var : op->inputs) {
+    if (var->IsVar() && var->Name() == it->second[0]) return var;
+  }
+  return nullptr;
+}
+
+template <typename T>
+static T GetAttrOr(Node* op, const std::string& name, const T& value) {
+  auto* desc = op->Op();
+  return desc->HasAttr(name) ? BOOST_GET_CONST(T, desc->GetAttr(name)) : value;
+}
+
+// Whether var is produced by one operator, and only used by consumer.
+static bool IsIntermediate(Node* var, Node* consumer) {
+  return var->IsVar() && var->Var() && !var->Var()->Persistable() &&
+         var->inputs.size() == 1 && var->inputs[0]->IsOp() &&
+         var->outputs.size() == 1 && var->outputs[0] == consumer;
+}
+
+// Match lookup_table(_v2) -> sequence_pool(SUM) -> cvm, or
+// fused_embedding_seq_pool(sum) -> cvm, whose output is concat_in.
+static bool MatchSlot(Node* concat_in, Node* concat_op, SlotNodes* slot) {
+  if (!IsIntermediate(concat_in, concat_op)) return false;
+  Node* cvm_op = concat_in->inputs[0];
+  if (cvm_op->Op()->Type() != "cvm") return false;
+  Node* cvm_x = GetInputVar(cvm_op, "X");
+  slot->cvm = GetInputVar(cvm_op, "CVM");
+  if (!cvm_x || !slot->cvm || !IsIntermediate(cvm_x, cvm_op)) return false;
+  slot->use_cvm = GetAttrOr<bool>(cvm_op, "use_cvm", true);
+  slot->removed = {concat_in, cvm_op, cvm_x};
+
+  Node* lookup_op = cvm_x->inputs[0];
+  const std::string& type = lookup_op->Op()->Type();
+  if (type == "sequence_pool") {
+    Node* pool_op = lookup_op;
+    if (GetAttrOr<std::string>(pool_op, "pooltype", "") != "SUM") return false;
+    // MaxIndex is not computed with the SUM pooltype.
+    for (auto* out : pool_op->outputs) {
+      if (out == cvm_x) continue;
+      if (!out->outputs.empty()) return false;
+      slot->removed.push_back(out);
+    }
+    Node* pool_x = GetInputVar(pool_op, "X");
+    if (!pool_x || !IsIntermediate(pool_x, pool_op)) return false;
+    slot->removed.push_back(pool_op);
+    slot->removed.push_back(pool_x);
+    lookup_op = pool_x->inputs[0];
+    if (lookup_op->Op()->Type() != "lookup_table" &&
+        lookup_op->Op()->Type() != "lookup_table_v2") {
+      return false;
+    }
+    // The distributed lookup prefetches the rows from the parameter servers.
+    if (GetAttrOr<bool>(lookup_op, "is_distributed", false) ||
+        GetAttrOr<bool>(lookup_op, "remote_prefetch", false)) {
+      return false;
+    }
+  } else if (type == "fused_embedding_seq_pool") {
+    if (GetAttrOr<std::string>(lookup_op, "combiner", "") != "sum") {
+      return false;
+    }
+  } else {
+    return false;
+  }
+  if (lookup_op->outputs.size() != 1) return false;
+  slot->removed.push_back(lookup_op);
+  slot->ids = GetInputVar(lookup_op, "Ids");
+  slot->w = GetInputVar(lookup_op, "W");
+  slot->padding_idx = GetAttrOr<int64_t>(lookup_op, "padding_idx", -1);
+  slot->is_sparse = GetAttrOr<bool>(lookup_op, "is_sparse", false);
+  return slot->ids && slot->w && slot->ids->Var() &&
+         slot->ids->Var()->GetDataType() == proto::VarType::INT64;
+}
+
+// Match all the inputs of concat_op, which must share the same embedding
+// table, CVM input and attributes.
+static bool MatchConcat(Node* concat_op, std::vector<SlotNodes>* slots) {
+  auto* desc = concat_op->Op();
+  if (GetAttrOr<int>(concat_op, "axis", 0) != 1 ||
+      concat_op->outputs.size() != 1) {
+    return false;
+  }
+  auto& names = desc->Input("X");
+  // No AxisTensor input.
+  if (names.empty() || concat_op->inputs.size() != names.size()) {
+    return false;
+  }
+  std::unordered_map<std::string, Node*> inputs;
+  for (auto* var : concat_op->inputs) {
+    inputs[var->Name()] = var;
+  }
+  slots->resize(names.size());
+  for (size_t i = 0; i < names.size(); ++i) {
+    auto it = inputs.find(names[i]);
+    if (it == inputs.end()) return false;
+    auto& slot = slots->at(i);
+    if (!MatchSlot(it->second, concat_op, &slot)) return false;
+    auto& first = slots->at(0);
+    if (slot.w != first.w || slot.cvm != first.cvm ||
+        slot.use_cvm != first.use_cvm ||
+        slot.padding_idx != first.padding_idx ||
+        slot.is_sparse != first.is_sparse) {
+      return false;
+    }
+  }
+  return true;
+}
+}  // anonymous namespace
+
+void EmbeddingSeqPoolCVMConcatFusePass::ApplyImpl(ir::Graph* graph) const {
+  FusePassBase::Init(name_scope_, graph);
+
+  int count = 0;
+  // The nodes removed with a concat op are all before it in the topological
+  // order, so the rest of the operators are still valid.
+  for (auto* concat_op : TopologySortOperations(*graph)) {
+    if (concat_op->Op()->Type() != "concat") continue;
+    std::vector<SlotNodes> slots;
+    if (!MatchConcat(concat_op, &slots)) continue;
+
+    std::vector<std::string> ids_names;
+    std::unordered_set<const Node*> marked_nodes = {concat_op};
+    for (auto& slot : slots) {
+      ids_names.push_back(slot.ids->Name());
+      marked_nodes.insert(slot.removed.begin(), slot.removed.end());
+    }
+    Node* w = slots[0].w;
+    Node* cvm = slots[0].cvm;
+    Node* concat_out = concat_op->outputs[0];
+
+    OpDesc op_desc;
+    op_desc.SetType("fused_embedding_seqpool_cvm_concat");
+    op_desc.SetInput("W", {w->Name()});
+    op_desc.SetInput("Ids", ids_names);
+    op_desc.SetInput("CVM", {cvm->Name()});
+    op_desc.SetOutput("Out", {concat_out->Name()});
+    op_desc.SetAttr("use_cvm", slots[0].use_cvm);
+    op_desc.SetAttr("padding_idx", slots[0].padding_idx);
+    op_desc.SetAttr("is_sparse", slots[0].is_sparse);
+    auto role_attr = OpProtoAndCheckerMaker::OpRoleAttrName();
+    if (concat_op->Op()->HasAttr(role_attr)) {
+      op_desc.SetAttr(role_attr, concat_op->Op()->GetAttr(role_attr));
+    }
+    auto* op = graph->CreateOpNode(&op_desc);
+
+    IR_NODE_LINK_TO(w, op);
+    std::unordered_set<Node*> linked_ids;
+    for (auto& slot : slots) {
+      if (linked_ids.insert(slot.ids).second) {
+        IR_NODE_LINK_TO(slot.ids, op);
+      }
+    }
+    IR_NODE_LINK_TO(cvm, op);
+    IR_NODE_LINK_TO(op, concat_out);
+
+    GraphSafeRemoveNodes(graph, marked_nodes);
+    VLOG(3) << "Fuse the embedding of " << slots.size() << " slots of "
+            << w->Name() << " into " << concat_out->Name();
+    count++;
+  }
+  AddStatis(count);
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+REGISTER_PASS(embedding_seqpool_cvm_concat_fuse_pass,
+              paddle::framework::ir::EmbeddingSeqPoolCVMConcatFusePass);
@@ -0,0 +1,64 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <string>
+
+#include "paddle/fluid/framework/ir/fuse_pass_base.h"
+#include "paddle/fluid/framework/ir/graph.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+/**
+ * Fuse the lookup of all the slots sharing one embedding table, together with
+ * SequencePool(with sum pooltype), CVM and Concat;
+ *
+ * Before fuse:
+ *      |              |                     |
+ * lookup_table, lookup_table, ... fused_embedding_seq_pool
+ *      |              |                     |
+ *   seq_pool       seq_pool                 |
+ *      |              |                     |
+ *     cvm            cvm                   cvm
+ *       \             |        ...         /
+ *                   concat
+ *                     |
+ * After fuse:
+ *       \             |             /
+ *        FusedEmbeddingSeqPoolCVMConcat
+ *                     |
+ *
+ * The intermediate variables must not be used by any other operator, so the
+ * pass does nothing on a graph with backward. To train with the fused
+ * operator, apply the pass to the forward program before appending the
+ * backward, since fused_embedding_seqpool_cvm_concat has its own grad op.
+ */
+class Graph;
+
+class EmbeddingSeqPoolCVMConcatFusePass : public FusePassBase {
+ public:
+  virtual ~EmbeddingSeqPoolCVMConcatFusePass() {}
+
+ protected:
+  void ApplyImpl(ir::Graph* graph) const override;
+
+  const std::string name_scope_{"embedding_seqpool_cvm_concat_fuse"};
+};
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,185 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/ir/embedding_seqpool_cvm_concat_fuse_pass.h"
+#include <gtest/gtest.h>
+#include "paddle/fluid/framework/op_proto_maker.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+class EmbeddingProgram {
+ public:
+  EmbeddingProgram() {
+    NewVar("cvm_in");
+    NewVar("concat_out");
+  }
+
+  // Append lookup_table_v2 -> sequence_pool -> cvm of a slot, or
+  // fused_embedding_seq_pool -> cvm if fused_lookup.
+  void AddSlot(const std::string& table, bool fused_lookup = false) {
+    std::string prefix = "slot_" + std::to_string(concat_inputs_.size());
+    NewVar(prefix + "_ids")->SetDataType(proto::VarType::INT64);
+    if (!prog_.MutableBlock(0)->HasVar(table)) {
+      NewVar(table)->SetPersistable(true);
+    }
+    if (fused_lookup) {
+      auto* lookup = AppendOp("fused_embedding_seq_pool");
+      lookup->SetInput("W", {table});
+      lookup->SetInput("Ids", {prefix + "_ids"});
+      lookup->SetOutput("Out", {NewVar(prefix + "_pool")->Name()});
+      lookup->SetAttr("combiner", std::string("sum"));
+    } else {
+      auto* lookup = AppendOp("lookup_table_v2");
+      lookup->SetInput("W", {table});
+      lookup->SetInput("Ids", {prefix + "_ids"});
+      lookup->SetOutput("Out", {NewVar(prefix + "_emb")->Name()});
+      auto* pool = AppendOp("sequence_pool");
+      pool->SetInput("X", {prefix + "_emb"});
+      pool->SetOutput("Out", {NewVar(prefix + "_pool")->Name()});
+      pool->SetOutput("MaxIndex", {NewVar(prefix + "_max_index")->Name()});
+      pool->SetAttr("pooltype", std::string("SUM"));
+    }
+    auto* cvm = AppendOp("cvm");
+    cvm->SetInput("X", {prefix + "_pool"});
+    cvm->SetInput("CVM", {"cvm_in"});
+    cvm->SetOutput("Y", {NewVar(prefix + "_cvm")->Name()});
+    cvm->SetAttr("use_cvm", true);
+    concat_inputs_.push_back(prefix + "_cvm");
+  }
+
+  // Use the variable by another op, such as the grad op.
+  void AddUser(const std::string& var) {
+    auto* op = AppendOp("scale");
+    op->SetInput("X", {var});
+    op->SetOutput("Out", {NewVar(var + "_user")->Name()});
+  }
+
+  std::unique_ptr<ir::Graph> Build() {
+    auto* concat = AppendOp("concat");
+    concat->SetInput("X", concat_inputs_);
+    concat->SetOutput("Out", {"concat_out"});
+    concat->SetAttr("axis", 1);
+    return std::unique_ptr<ir::Graph>(new ir::Graph(prog_));
+  }
+
+ private:
+  VarDesc* NewVar(const std::string& name) {
+    auto* var = prog_.MutableBlock(0)->Var(name);
+    var->SetType(proto::VarType::LOD_TENSOR);
+    return var;
+  }
+
+  OpDesc* AppendOp(const std::string& type) {
+    auto* op = prog_.MutableBlock(0)->AppendOp();
+    op->SetType(type);
+    op->SetAttr(OpProtoAndCheckerMaker::OpRoleAttrName(),
+                static_cast<int>(OpRole::kForward));
+    return op;
+  }
+
+  ProgramDesc prog_;
+  std::vector<std::string> concat_inputs_;
+};
+
+static int CountOpType(const ir::Graph* graph, const std::string& op_type) {
+  int count = 0;
+  for (auto* node : graph->Nodes()) {
+    if (node->IsOp() && node->Op()->Type() == op_type) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+static std::unique_ptr<ir::Graph> ApplyPass(std::unique_ptr<ir::Graph> graph,
+                                            int* before, int* after) {
+  auto pass =
+      PassRegistry::Instance().Get("embedding_seqpool_cvm_concat_fuse_pass");
+  *before = graph->Nodes().size();
+  graph.reset(pass->Apply(graph.release()));
+  *after = graph->Nodes().size();
+  return graph;
+}
+
+TEST(EmbeddingSeqPoolCVMConcatFusePass, slots) {
+  for (int num : {1, 3, 100}) {
+    EmbeddingProgram program;
+    for (int i = 0; i < num; ++i) {
+      program.AddSlot("table");
+    }
+    int before, after;
+    auto graph = ApplyPass(program.Build(), &before, &after);
+    // Remove Nodes: n * (lookup_op, emb, seqpool_op, pool, max_index, cvm_op,
+    // cvm_out), and concat_op
+    // Add Node: fused_embedding_seqpool_cvm_concat op
+    EXPECT_EQ(after, before - num * 7);
+    EXPECT_EQ(CountOpType(graph.get(), "fused_embedding_seqpool_cvm_concat"),
+              1);
+    EXPECT_EQ(CountOpType(graph.get(), "cvm"), 0);
+    for (auto* node : graph->Nodes()) {
+      if (node->IsOp() &&
+          node->Op()->Type() == "fused_embedding_seqpool_cvm_concat") {
+        EXPECT_EQ(node->Op()->Input("Ids").size(), static_cast<size_t>(num));
+        // W, Ids and CVM
+        EXPECT_EQ(node->inputs.size(), static_cast<size_t>(num + 2));
+      }
+    }
+  }
+}
+
+TEST(EmbeddingSeqPoolCVMConcatFusePass, fused_embedding_seq_pool) {
+  EmbeddingProgram program;
+  program.AddSlot("table");
+  program.AddSlot("table", /*fused_lookup=*/true);
+  int before, after;
+  auto graph = ApplyPass(program.Build(), &before, &after);
+  // Remove Nodes: lookup_op, emb, seqpool_op, pool, max_index, cvm_op,
+  // cvm_out, fused_lookup_op, pool, cvm_op, cvm_out, and concat_op
+  // Add Node: fused_embedding_seqpool_cvm_concat op
+  EXPECT_EQ(after, before - 11);
+  EXPECT_EQ(CountOpType(graph.get(), "fused_embedding_seqpool_cvm_concat"),
+            1);
+}
+
+TEST(EmbeddingSeqPoolCVMConcatFusePass, not_fused) {
+  // The slots of different tables
+  {
+    EmbeddingProgram program;
+    program.AddSlot("table_0");
+    program.AddSlot("table_1");
+    int before, after;
+    auto graph = ApplyPass(program.Build(), &before, &after);
+    EXPECT_EQ(after, before);
+  }
+  // The pooled embedding is used by another op
+  {
+    EmbeddingProgram program;
+    program.AddSlot("table");
+    program.AddSlot("table");
+    program.AddUser("slot_1_pool");
+    int before, after;
+    auto graph = ApplyPass(program.Build(), &before, &after);
+    EXPECT_EQ(after, before);
+    EXPECT_EQ(CountOpType(graph.get(), "fused_embedding_seqpool_cvm_concat"),
+              0);
+  }
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+USE_PASS(embedding_seqpool_cvm_concat_fuse_pass);
@@ -0,0 +1,161 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/ir/fusion_group/code_generator.h"
+#include "paddle/fluid/framework/ir/fusion_group/operation.h"
+#include "paddle/fluid/platform/device_code.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+namespace fusion_group {
+
+static std::vector<OperationExpression> ElementwiseExpressions(
+    const std::string& dtype) {
+  // t2 = t0 * t1
+  // t4 = t2 + t3
+  // t6 = t4 - t5
+  // t7 = relu(t6)
+  // t8 = sigmoid(t7)
+  return {OperationExpression("elementwise_mul", {0, 1}, {2}, dtype, dtype),
+          OperationExpression("elementwise_add", {2, 3}, {4}, dtype, dtype),
+          OperationExpression("elementwise_sub", {4, 5}, {6}, dtype, dtype),
+          OperationExpression("relu", {6}, {7}, dtype, dtype),
+          OperationExpression("sigmoid", {7}, {8}, dtype, dtype)};
+}
+
+// Run the same computation as ElementwiseExpressions, one full pass over the
+// data per operator, which is how the unfused operators run.
+static void RunUnfused(int64_t n, std::vector<std::vector<float>>* vars) {
+  auto& v = *vars;
+  for (int64_t i = 0; i < n; ++i) v[2][i] = v[0][i] * v[1][i];
+  for (int64_t i = 0; i < n; ++i) v[4][i] = v[2][i] + v[3][i];
+  for (int64_t i = 0; i < n; ++i) v[6][i] = v[4][i] - v[5][i];
+  for (int64_t i = 0; i < n; ++i) v[7][i] = v[6][i] > 0 ? v[6][i] : 0;
+  for (int64_t i = 0; i < n; ++i) {
+    v[8][i] = 1.0f / (1.0f + std::exp(-v[7][i]));
+  }
+}
+
+static std::unique_ptr<platform::CPUDeviceCode> CompileCPUCode(
+    const std::string& func_name) {
+  OperationMap::Init();
+  CodeGenerator code_generator(/*is_cpu=*/true);
+  std::string code_str =
+      code_generator.Generate(func_name, ElementwiseExpressions("float"));
+  VLOG(3) << code_str;
+
+  std::unique_ptr<platform::CPUDeviceCode> device_code(
+      new platform::CPUDeviceCode(platform::CPUPlace(), func_name, code_str));
+  EXPECT_TRUE(device_code->Compile());
+  return device_code;
+}
+
+static void Launch(const platform::CPUDeviceCode& device_code, int64_t n,
+                   std::vector<std::vector<float>>* vars) {
+  // The inputs are {0, 1, 3, 5}, and the outputs are {2, 4, 6, 7, 8}.
+  std::vector<float*> ptrs;
+  for (int id : {0, 1, 3, 5, 2, 4, 6, 7, 8}) {
+    ptrs.push_back(vars->at(id).data());
+  }
+  size_t num = n;
+  std::vector<void*> args;
+  args.push_back(&num);
+  for (auto& ptr : ptrs) {
+    args.push_back(&ptr);
+  }
+  device_code.Launch(num, &args);
+}
+
+static std::vector<std::vector<float>> RandomVars(int64_t n) {
+  std::mt19937 rng(100);
+  std::uniform_real_distribution<float> uniform_dist(-0.5, 0.5);
+  std::vector<std::vector<float>> vars(9, std::vector<float>(n, 0));
+  for (int id : {0, 1, 3, 5}) {
+    for (int64_t i = 0; i < n; ++i) {
+      vars[id][i] = uniform_dist(rng);
+    }
+  }
+  return vars;
+}
+
+TEST(cpu_code_generator, elementwise) {
+  if (!platform::CPUDeviceCode::IsAvailable()) {
+    LOG(WARNING) << "Skip the test because no host compiler is found.";
+    return;
+  }
+  auto device_code = CompileCPUCode("cpu_elementwise_kernel_0");
+
+  const int64_t n = 1000;
+  auto actual = RandomVars(n);
+  auto expect = actual;
+  Launch(*device_code, n, &actual);
+  RunUnfused(n, &expect);
+  for (int id : {2, 4, 6, 7, 8}) {
+    for (int64_t i = 0; i < n; ++i) {
+      EXPECT_NEAR(actual[id][i], expect[id][i], 1E-5);
+    }
+  }
+}
+
+TEST(cpu_code_generator, fp16_unsupported) {
+  OperationMap::Init();
+  CodeGenerator code_generator(/*is_cpu=*/true);
+  EXPECT_ANY_THROW(code_generator.Generate("cpu_elementwise_kernel_1",
+                                           ElementwiseExpressions("__half")));
+}
+
+TEST(cpu_code_generator, benchmark) {
+  if (!platform::CPUDeviceCode::IsAvailable()) {
+    LOG(WARNING) << "Skip the test because no host compiler is found.";
+    return;
+  }
+  auto device_code = CompileCPUCode("cpu_elementwise_kernel_2");
+
+  const int64_t n = 1 << 22;
+  const int kRepeat = 10;
+  auto vars = RandomVars(n);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kRepeat; ++i) {
+    RunUnfused(n, &vars);
+  }
+  double unfused_ms = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - start)
+                          .count() /
+                      kRepeat;
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kRepeat; ++i) {
+    Launch(*device_code, n, &vars);
+  }
+  double fused_ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count() /
+                    kRepeat;
+  LOG(INFO) << "Elementwise of " << n << " elements, unfused: " << unfused_ms
+            << " ms, fused: " << fused_ms << " ms";
+}
+
+}  // namespace fusion_group
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,59 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+namespace paddle {
+namespace framework {
+namespace ir {
+namespace fusion_group {
+
+static constexpr char predefined_cpu_functions_common[] = R"(
+#include <cmath>
+#include <cstdint>
+
+)";
+
+static constexpr char predefined_cpu_functions_fp32[] = R"(
+inline float Max(float x, float y) { return x > y ? x : y; }
+inline float Exp(float x) { return std::exp(x); }
+inline float Log(float x) { return std::log(x); }
+inline float Sqrt(float x) { return std::sqrt(x); }
+
+)";
+
+static constexpr char predefined_cpu_functions_fp64[] = R"(
+inline double Max(double x, double y) { return x > y ? x : y; }
+inline double Exp(double x) { return std::exp(x); }
+inline double Log(double x) { return std::log(x); }
+inline double Sqrt(double x) { return std::sqrt(x); }
+
+)";
+
+// The arguments are passed in the same way as CUDA kernels, i.e. args[i]
+// points to the i-th pointer parameter. The loop is a simple counted loop over
+// restrict pointers, so that the host compiler is able to vectorize it.
+static constexpr char cpu_kernel_template_1d[] = R"(
+extern "C" void $func_name(int64_t N, void** args) {
+  $parameters
+  for (int64_t idx = 0; idx < N; ++idx) {
+    $compute_body
+  }
+}
+)";
+
+}  // namespace fusion_group
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
@@ -17,6 +17,7 @@ limitations under the License. */
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -204,6 +205,8 @@ class Graph {
     }
     nodes_.clear();
     node_set_.clear();
+    op_nodes_by_type_.clear();
+    op_node_types_.clear();
     return ret;
   }
 
@@ -215,9 +218,55 @@ class Graph {
     ret.reset(nodes_.at(node).release());
     nodes_.erase(node);
     node_set_.erase(node);
+    RemoveFromOpNodeIndex(node);
     return ret;
   }
 
+  // Return the op nodes of the given type. The index is updated incrementally
+  // when nodes are added or removed, so that the passes needn't scan the whole
+  // graph to find the candidates of a pattern.
+  const std::unordered_set<ir::Node *> &OpNodesOfType(
+      const std::string &type) const {
+    static const std::unordered_set<ir::Node *> empty;
+    auto it = op_nodes_by_type_.find(type);
+    return it == op_nodes_by_type_.end() ? empty : it->second;
+  }
+
+  // The op nodes are indexed by their types when they are added. Call it
+  // after changing the type of an op node in place.
+  void UpdateOpNodeIndex(ir::Node *node) {
+    RemoveFromOpNodeIndex(node);
+    AddToOpNodeIndex(node);
+  }
+
+  // Whether every op node is indexed by its current type. It is false if the
+  // type of an op node is changed in place without UpdateOpNodeIndex.
+  bool IsOpNodeIndexConsistent() const {
+    for (auto *node : node_set_) {
+      if (!node->IsOp() || node->Op() == nullptr) continue;
+      auto it = op_node_types_.find(node);
+      if (it == op_node_types_.end() || it->second != node->Op()->Type()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Re-index the op nodes whose types were changed in place without
+  // UpdateOpNodeIndex, and return how many there were.
+  int RefreshOpNodeIndex() {
+    int refreshed = 0;
+    for (auto *node : node_set_) {
+      if (!node->IsOp() || node->Op() == nullptr) continue;
+      auto it = op_node_types_.find(node);
+      if (it == op_node_types_.end() || it->second != node->Op()->Type()) {
+        UpdateOpNodeIndex(node);
+        ++refreshed;
+      }
+    }
+    return refreshed;
+  }
+
   // NOTE low performance, but simple and secure.
   Node *RetrieveNode(int id) {
     for (auto &node : nodes_) {
@@ -241,6 +290,7 @@ class Graph {
                           "The node to be added already exists."));
     nodes_[node].reset(node);
     node_set_.insert(node);
+    AddToOpNodeIndex(node);
     return node;
   }
 
@@ -255,12 +305,34 @@ class Graph {
   std::map<std::string, std::vector<ir::Node *>> InitFromProgram(
       const ProgramDesc &program);
 
+  void AddToOpNodeIndex(ir::Node *node) {
+    if (!node->IsOp() || node->Op() == nullptr) return;
+    const std::string &type = node->Op()->Type();
+    op_nodes_by_type_[type].insert(node);
+    op_node_types_[node] = type;
+  }
+
+  void RemoveFromOpNodeIndex(ir::Node *node) {
+    auto it = op_node_types_.find(node);
+    if (it == op_node_types_.end()) return;
+    auto type_it = op_nodes_by_type_.find(it->second);
+    type_it->second.erase(node);
+    if (type_it->second.empty()) {
+      op_nodes_by_type_.erase(type_it);
+    }
+    op_node_types_.erase(it);
+  }
+
   // NOTE: program_ shouldn't be exposed to user.
   const ProgramDesc program_;
   std::map<std::string, boost::any> attrs_;
   std::map<std::string, std::function<void(void)>> attr_dels_;
   std::map<ir::Node *, std::unique_ptr<ir::Node>> nodes_;
   std::unordered_set<ir::Node *> node_set_;
+  // op type -> op nodes, and the reverse
+  std::unordered_map<std::string, std::unordered_set<ir::Node *>>
+      op_nodes_by_type_;
+  std::unordered_map<ir::Node *, std::string> op_node_types_;
   size_t num_node_created_{0};  // help to generate a unique node id.
 };
 
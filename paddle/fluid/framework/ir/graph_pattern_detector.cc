@@ -87,11 +87,22 @@ void PDPattern::AddEdge(PDNode *a, PDNode *b) {
 
 void GraphPatternDetector::operator()(Graph *graph,
                                       GraphPatternDetector::handle_t handler) {
-  if (!MarkPDNodesInGraph(*graph)) {
-    return;
+  if (graph->Nodes().empty()) return;
+
+  // A pass may have changed the type of an op node in place without
+  // Graph::UpdateOpNodeIndex, so the index is checked in every build.
+  int refreshed = graph->RefreshOpNodeIndex();
+  if (refreshed > 0) {
+    VLOG(3) << "re-indexed " << refreshed
+            << " op nodes whose types were changed in place";
+  }
+  std::vector<subgraph_t> subgraphs;
+  if (!DetectPatternsByIndex(*graph, &subgraphs)) {
+    if (!MarkPDNodesInGraph(*graph)) {
+      return;
+    }
+    subgraphs = DetectPatterns();
   }
-
-  auto subgraphs = DetectPatterns();
   UniquePatterns(&subgraphs);
   SortSubgraphs(&subgraphs);
   RemoveOverlappedMatch(&subgraphs);
@@ -266,6 +277,136 @@ GraphPatternDetector::DetectPatterns() {
   return result;
 }
 
+namespace {
+
+// A step of the matching by index. The node of pdnode is searched in the
+// outputs (or inputs) of the node matched by the previous PDNode from, and
+// then checked by the other edges to the matched nodes.
+struct MatchStep {
+  PDNode *pdnode;
+  int from;
+  bool from_is_source;
+  // (the index of the matched step, whether it links to pdnode)
+  std::vector<std::pair<int, bool>> checks;
+};
+
+void ExtendMatch(const std::vector<MatchStep> &steps, size_t cur,
+                 std::vector<Node *> *matched, std::unordered_set<Node *> *used,
+                 std::vector<GraphPatternDetector::subgraph_t> *subgraphs) {
+  if (cur == steps.size()) {
+    GraphPatternDetector::subgraph_t subgraph;
+    for (size_t i = 0; i < steps.size(); ++i) {
+      subgraph.emplace(steps[i].pdnode, matched->at(i));
+    }
+    subgraphs->emplace_back(std::move(subgraph));
+    return;
+  }
+
+  const auto &step = steps[cur];
+  Node *from = matched->at(step.from);
+  const auto &candidates = step.from_is_source ? from->outputs : from->inputs;
+  for (Node *node : candidates) {
+    if (used->count(node) || !step.pdnode->Tell(node)) continue;
+    bool linked = true;
+    for (auto &check : step.checks) {
+      Node *other = matched->at(check.first);
+      if (!(check.second ? IsNodesLink(other, node)
+                         : IsNodesLink(node, other))) {
+        linked = false;
+        break;
+      }
+    }
+    if (!linked) continue;
+
+    (*matched)[cur] = node;
+    used->insert(node);
+    ExtendMatch(steps, cur + 1, matched, used, subgraphs);
+    used->erase(node);
+  }
+}
+
+}  // namespace
+
+bool GraphPatternDetector::DetectPatternsByIndex(
+    const Graph &graph, std::vector<subgraph_t> *subgraphs) {
+  // Anchor on the op PDNode with the fewest candidates.
+  PDNode *anchor = nullptr;
+  size_t anchor_size = 0;
+  for (auto &pdnode : pattern_.nodes()) {
+    if (!pdnode->HasOpTypes()) continue;
+    size_t size = 0;
+    for (auto &op_type : pdnode->op_types()) {
+      size += graph.OpNodesOfType(op_type).size();
+    }
+    if (anchor == nullptr || size < anchor_size) {
+      anchor = pdnode.get();
+      anchor_size = size;
+    }
+  }
+  if (anchor == nullptr) return false;
+
+  // Order the PDNodes by BFS from the anchor, so that each PDNode links to a
+  // PDNode ordered before it.
+  std::vector<MatchStep> steps;
+  std::unordered_map<PDNode *, int> step_ids;
+  steps.push_back(MatchStep{anchor, -1, false, {}});
+  step_ids[anchor] = 0;
+  for (size_t i = 0; i < steps.size(); ++i) {
+    PDNode *cur = steps[i].pdnode;
+    for (auto &edge : pattern_.edges()) {
+      PDNode *next = nullptr;
+      bool from_is_source = false;
+      if (edge.first == cur) {
+        next = edge.second;
+        from_is_source = true;
+      } else if (edge.second == cur) {
+        next = edge.first;
+      }
+      if (next == nullptr || step_ids.count(next)) continue;
+      step_ids[next] = steps.size();
+      steps.push_back(
+          MatchStep{next, static_cast<int>(i), from_is_source, {}});
+    }
+  }
+  if (steps.size() != pattern_.nodes().size()) {
+    VLOG(4) << "The pattern is not connected, cannot be detected by index.";
+    return false;
+  }
+  for (auto &edge : pattern_.edges()) {
+    int source = step_ids.at(edge.first);
+    int target = step_ids.at(edge.second);
+    if (source < target) {
+      steps[target].checks.emplace_back(source, true);
+    } else {
+      steps[source].checks.emplace_back(target, false);
+    }
+  }
+
+  std::vector<Node *> candidates;
+  for (auto &op_type : anchor->op_types()) {
+    for (Node *node : graph.OpNodesOfType(op_type)) {
+      if (anchor->Tell(node)) {
+        candidates.push_back(node);
+      }
+    }
+  }
+  // Keep the order of the subgraphs stable.
+  std::sort(candidates.begin(), candidates.end(),
+            [](Node *a, Node *b) { return a->id() < b->id(); });
+  VLOG(3) << "detect patterns from " << candidates.size() << " nodes of "
+          << anchor->name();
+
+  std::vector<Node *> matched(steps.size());
+  std::unordered_set<Node *> used;
+  for (Node *node : candidates) {
+    matched[0] = node;
+    used.insert(node);
+    ExtendMatch(steps, 1, &matched, &used, subgraphs);
+    used.erase(node);
+  }
+  return true;
+}
+
 struct GraphItemLessThan {
   bool operator()(const std::pair<PDNode *, Node *> &a,
                   const std::pair<PDNode *, Node *> &b) {
@@ -415,9 +556,26 @@ PDNode *PDNode::assert_is_op(const std::string &op_type) {
   asserts_.emplace_back([op_type](Node *x) {
     return x && x->IsOp() && x->Op()->Type() == op_type;
   });
+  RestrictOpTypes({op_type});
   return this;
 }
 
+void PDNode::RestrictOpTypes(const std::unordered_set<std::string> &op_types) {
+  if (!has_op_types_) {
+    op_types_ = op_types;
+    has_op_types_ = true;
+    return;
+  }
+  // The asserts are combined, so are the op types.
+  std::unordered_set<std::string> intersection;
+  for (auto &op_type : op_types) {
+    if (op_types_.count(op_type)) {
+      intersection.insert(op_type);
+    }
+  }
+  op_types_ = std::move(intersection);
+}
+
 PDNode *PDNode::assert_is_var() {
   asserts_.emplace_back([](Node *x) { return x && x->IsVar(); });
   return this;
@@ -585,6 +743,7 @@ PDNode *PDNode::assert_is_ops(const std::unordered_set<std::string> &op_types) {
   asserts_.emplace_back([op_types](Node *x) {
     return x && x->IsOp() && op_types.count(x->Op()->Type());
   });
+  RestrictOpTypes(op_types);
   return this;
 }
 
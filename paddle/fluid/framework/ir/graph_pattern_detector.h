@@ -83,6 +83,12 @@ struct PDNode {
 
   const std::string& name() const { return name_; }
 
+  // Whether the node can only match the op nodes of op_types(), which is set
+  // by assert_is_op(op_type) and assert_is_ops(op_types). It is used to find
+  // the candidates from the op type index of the graph.
+  bool HasOpTypes() const { return !teller_ && has_op_types_; }
+  const std::unordered_set<std::string>& op_types() const { return op_types_; }
+
   PDNode& operator=(const PDNode&) = delete;
   PDNode(const PDNode&) = delete;
 
@@ -175,6 +181,8 @@ struct PDNode {
 
   PDNode(PDNode&& other) = default;
 
+  void RestrictOpTypes(const std::unordered_set<std::string>& op_types);
+
   friend class PDPattern;
 
   // Will removed latter.
@@ -184,6 +192,8 @@ struct PDNode {
   std::string name_;
   Type type_;
   Role role_{Role::kUnknown};
+  bool has_op_types_{false};
+  std::unordered_set<std::string> op_types_;
 };
 
 /*
@@ -291,6 +301,14 @@ class GraphPatternDetector {
   // Detect all the pattern and output the hit records.
   std::vector<subgraph_t> DetectPatterns();
 
+  // Detect all the pattern by the op type index of the graph. The matching
+  // starts from the op PDNode with the fewest candidates, and extends to the
+  // neighbors of the matched nodes, so that only a small part of the graph is
+  // visited. Return false if the pattern has no op type to anchor on, or is not
+  // connected, in which case DetectPatterns should be used.
+  bool DetectPatternsByIndex(const Graph& graph,
+                             std::vector<subgraph_t>* subgraphs);
+
   // Remove duplicate patterns.
   void UniquePatterns(std::vector<subgraph_t>* subgraphs);
 
@@ -311,6 +329,8 @@ class GraphPatternDetector {
 #ifdef PADDLE_WITH_TESTING
   FRIEND_TEST(GraphPatternDetecter, MarkPDNodesInGraph);
   FRIEND_TEST(GraphPatternDetecter, DetectPatterns);
+  FRIEND_TEST(GraphPatternDetecter, DetectPatternsByIndex);
+  FRIEND_TEST(GraphPatternDetecter, DetectPatternsByIndexFallback);
 #endif
 
  private:
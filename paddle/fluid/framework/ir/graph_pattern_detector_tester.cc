@@ -13,6 +13,9 @@
 // limitations under the License.
 
 #include <gtest/gtest.h>
+#include <chrono>  // NOLINT
+#include <string>
+#include <unordered_set>
 
 #include "paddle/fluid/framework/ir/graph_pattern_detector.h"
 
@@ -203,6 +206,190 @@ TEST(GraphPatternDetector, IntermediateCheck) {
   ASSERT_EQ(count, 1);
 }
 
+static ir::Node* CreateVar(Graph* g, const std::string& name) {
+  VarDesc desc(name);
+  return g->CreateVarNode(&desc);
+}
+
+// Build num blocks of mul -> elementwise_add, the output of each block is the
+// input of the next one.
+static void BuildMulAddChain(Graph* g, int num) {
+  ir::Node* x = CreateVar(g, "x");
+  for (int i = 0; i < num; ++i) {
+    std::string suffix = std::to_string(i);
+    ir::Node* w = CreateVar(g, "w" + suffix);
+    ir::Node* mul_out = CreateVar(g, "mul_out" + suffix);
+    ir::Node* b = CreateVar(g, "b" + suffix);
+    ir::Node* add_out = CreateVar(g, "add_out" + suffix);
+
+    OpDesc mul_desc;
+    mul_desc.SetType("mul");
+    mul_desc.SetInput("X", {x->Name()});
+    mul_desc.SetInput("Y", {w->Name()});
+    mul_desc.SetOutput("Out", {mul_out->Name()});
+    ir::Node* mul = g->CreateOpNode(&mul_desc);
+
+    OpDesc add_desc;
+    add_desc.SetType("elementwise_add");
+    add_desc.SetInput("X", {mul_out->Name()});
+    add_desc.SetInput("Y", {b->Name()});
+    add_desc.SetOutput("Out", {add_out->Name()});
+    ir::Node* add = g->CreateOpNode(&add_desc);
+
+    IR_NODE_LINK_TO(x, mul);
+    IR_NODE_LINK_TO(w, mul);
+    IR_NODE_LINK_TO(mul, mul_out);
+    IR_NODE_LINK_TO(mul_out, add);
+    IR_NODE_LINK_TO(b, add);
+    IR_NODE_LINK_TO(add, add_out);
+    x = add_out;
+  }
+}
+
+static void BuildMulAddPattern(PDPattern* pattern) {
+  auto* mul = pattern->NewNode("mul")->assert_is_op("mul");
+  auto* mul_out = pattern->NewNode("mul_out")
+                      ->assert_is_op_output("mul", "Out")
+                      ->assert_is_op_input("elementwise_add", "X");
+  auto* add = pattern->NewNode("add")->assert_is_op("elementwise_add");
+  mul_out->LinksFrom({mul}).LinksTo({add});
+}
+
+static std::unordered_set<Node*> MatchedNodes(
+    const std::vector<GraphPatternDetector::subgraph_t>& subgraphs,
+    const std::string& pdnode_name) {
+  std::unordered_set<Node*> nodes;
+  for (auto& subgraph : subgraphs) {
+    for (auto& item : subgraph) {
+      if (item.first->name() == pdnode_name) nodes.insert(item.second);
+    }
+  }
+  return nodes;
+}
+
+TEST(GraphPatternDetecter, DetectPatternsByIndex) {
+  const int kNum = 2000;
+  ProgramDesc program;
+  Graph graph(program);
+  BuildMulAddChain(&graph, kNum);
+  ASSERT_EQ(graph.OpNodesOfType("mul").size(), static_cast<size_t>(kNum));
+  ASSERT_TRUE(graph.OpNodesOfType("not_exist").empty());
+
+  // Change the type of some ops in place, and update the index.
+  int renamed = 0;
+  for (auto* node : graph.Nodes()) {
+    if (node->IsOp() && node->Op()->Type() == "elementwise_add" &&
+        renamed < 10) {
+      node->Op()->SetType("elementwise_sub");
+      graph.UpdateOpNodeIndex(node);
+      ++renamed;
+    }
+  }
+  ASSERT_EQ(graph.OpNodesOfType("elementwise_add").size(),
+            static_cast<size_t>(kNum - 10));
+  ASSERT_EQ(graph.OpNodesOfType("elementwise_sub").size(), 10UL);
+
+  GraphPatternDetector by_index;
+  BuildMulAddPattern(by_index.mutable_pattern());
+  std::vector<GraphPatternDetector::subgraph_t> index_subgraphs;
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_TRUE(by_index.DetectPatternsByIndex(graph, &index_subgraphs));
+  by_index.UniquePatterns(&index_subgraphs);
+  double index_ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+
+  GraphPatternDetector by_scan;
+  BuildMulAddPattern(by_scan.mutable_pattern());
+  start = std::chrono::steady_clock::now();
+  by_scan.MarkPDNodesInGraph(graph);
+  auto scan_subgraphs = by_scan.DetectPatterns();
+  by_scan.UniquePatterns(&scan_subgraphs);
+  double scan_ms = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  LOG(INFO) << "Detect " << kNum << " mul + elementwise_add, by index: "
+            << index_ms << " ms, by scan: " << scan_ms << " ms";
+
+  ASSERT_EQ(index_subgraphs.size(), static_cast<size_t>(kNum - 10));
+  ASSERT_EQ(index_subgraphs.size(), scan_subgraphs.size());
+  ASSERT_EQ(MatchedNodes(index_subgraphs, "add"),
+            MatchedNodes(scan_subgraphs, "add"));
+
+  // The removed nodes are removed from the index too.
+  auto* mul = *graph.OpNodesOfType("mul").begin();
+  graph.RemoveNode(mul);
+  ASSERT_EQ(graph.OpNodesOfType("mul").size(), static_cast<size_t>(kNum - 1));
+}
+
+// The pattern matches the op whose type is changed in place, once the index
+// is updated.
+TEST(GraphPatternDetecter, DetectPatternsAfterTypeChange) {
+  ProgramDesc program;
+  Graph graph(program);
+  BuildMulAddChain(&graph, 3);
+
+  auto count_matches = [&graph]() {
+    GraphPatternDetector detector;
+    auto* pattern = detector.mutable_pattern();
+    auto* mul = pattern->NewNode("mul")->assert_is_op("mul");
+    auto* mul_out = pattern->NewNode("mul_out")
+                        ->assert_is_op_output("mul", "Out")
+                        ->assert_is_op_input("elementwise_sub", "X");
+    auto* sub = pattern->NewNode("sub")->assert_is_op("elementwise_sub");
+    mul_out->LinksFrom({mul}).LinksTo({sub});
+    int count = 0;
+    detector(&graph, [&count](const GraphPatternDetector::subgraph_t&,
+                              Graph*) { ++count; });
+    return count;
+  };
+  ASSERT_EQ(count_matches(), 0);
+
+  auto add_nodes = graph.OpNodesOfType("elementwise_add");
+  auto it = add_nodes.begin();
+  auto* add = *it++;
+  add->Op()->SetType("elementwise_sub");
+  ASSERT_FALSE(graph.IsOpNodeIndexConsistent());
+  graph.UpdateOpNodeIndex(add);
+  ASSERT_TRUE(graph.IsOpNodeIndexConsistent());
+  ASSERT_EQ(graph.OpNodesOfType("elementwise_add").size(), 2UL);
+  ASSERT_EQ(graph.OpNodesOfType("elementwise_sub").size(), 1UL);
+  ASSERT_EQ(count_matches(), 1);
+
+  // The detector re-indexes the op nodes whose types were changed in place
+  // without UpdateOpNodeIndex.
+  (*it)->Op()->SetType("elementwise_sub");
+  ASSERT_FALSE(graph.IsOpNodeIndexConsistent());
+  ASSERT_EQ(count_matches(), 2);
+  ASSERT_TRUE(graph.IsOpNodeIndexConsistent());
+  ASSERT_EQ(graph.OpNodesOfType("elementwise_add").size(), 1UL);
+  ASSERT_EQ(graph.OpNodesOfType("elementwise_sub").size(), 2UL);
+}
+
+// A pattern without any op type is detected by scanning the whole graph.
+TEST(GraphPatternDetecter, DetectPatternsByIndexFallback) {
+  ProgramDesc program;
+  Graph graph(program);
+  BuildGraph(&graph);
+
+  GraphPatternDetector x;
+  auto* op = x.mutable_pattern()->NewNode(
+      [](Node* node) { return node->IsOp() && node->Name() == "op2"; }, "op");
+  auto* var = x.mutable_pattern()->NewNode(
+      [](Node* node) { return node->IsVar() && node->Name() == "var2"; },
+      "var");
+  x.mutable_pattern()->AddEdge(op, var);
+
+  std::vector<GraphPatternDetector::subgraph_t> subgraphs;
+  ASSERT_FALSE(x.DetectPatternsByIndex(graph, &subgraphs));
+
+  int count = 0;
+  x(&graph, [&](const GraphPatternDetector::subgraph_t& s, Graph* g) {
+    ++count;
+  });
+  ASSERT_EQ(count, 1);
+}
+
 }  // namespace ir
 }  // namespace framework
 }  // namespace paddle
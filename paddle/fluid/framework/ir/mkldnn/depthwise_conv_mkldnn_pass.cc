@@ -48,6 +48,7 @@ void DepthwiseConvMKLDNNPass::ApplyImpl(ir::Graph* graph) const {
     VLOG(3) << "handle DepthwiseConvMKLDNN fuse";
     GET_NODE(depthwise_conv, (*pattern));
     depthwise_conv->Op()->SetType("conv2d");
+    g->UpdateOpNodeIndex(depthwise_conv);
     found_depthwise_conv_mkldnn_count++;
   };
 
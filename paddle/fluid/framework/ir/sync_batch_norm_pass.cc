@@ -28,15 +28,17 @@ class SyncBatchNormPass : public Pass {
     return;
 #endif
     VLOG(3) << "Use synchronize batch norm";
-    for (const Node *n : graph->Nodes()) {
+    for (Node *n : graph->Nodes()) {
       if (n->IsOp() && n->Op()) {
         auto *op = n->Op();
         // process synchronize in batch_norm
         if (op->Type() == "batch_norm") {
           op->SetType("sync_batch_norm");
+          graph->UpdateOpNodeIndex(n);
         }
         if (op->Type() == "batch_norm_grad") {
           op->SetType("sync_batch_norm_grad");
+          graph->UpdateOpNodeIndex(n);
         }
         // process synchronize in inplace_abn
         if (op->Type() == "inplace_abn") {
@@ -34,6 +34,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/transfer_scope_cache.h"
 #include "paddle/fluid/framework/unused_var_check.h"
 #include "paddle/fluid/framework/var_type.h"
+#include "paddle/fluid/platform/op_stat.h"
 #include "paddle/fluid/platform/profiler.h"
 #ifdef PADDLE_WITH_XPU
 #include "paddle/fluid/platform/xpu_info.h"
@@ -185,7 +186,13 @@ void OperatorBase::Run(const Scope& scope, const platform::Place& place) {
 #endif
     }
 
+    auto* op_stat = op_stat_.stat.load(std::memory_order_acquire);
+    if (UNLIKELY(op_stat == nullptr)) {
+      op_stat = platform::OpStatRegistry::Instance().Get(Type());
+      op_stat_.stat.store(op_stat, std::memory_order_release);
+    }
     {
+      platform::RecordOpStat record_op_stat(op_stat);
       // TODO(wangchaochaohu) : refine code to use only one RecordEvent)
       // in order to record different op type cost time
       // and different op name cost time,we set two event.
@@ -46,6 +46,9 @@ class OpInfo;
 class Scope;
 class Variable;
 }  // namespace framework
+namespace platform {
+struct OpStat;
+}  // namespace platform
 }  // namespace paddle
 
 DECLARE_int32(inner_op_parallelism);
@@ -235,6 +238,21 @@ class OperatorBase {
   // Whether this operator executes in an Executor.
   bool run_by_executor_{true};
 
+  // The always-on counters of this operator type, looked up at the first run.
+  // An operator may be run by several threads at the same time, and is
+  // copied by Clone.
+  struct OpStatCache {
+    OpStatCache() = default;
+    OpStatCache(const OpStatCache& other) : stat(other.stat.load()) {}
+    OpStatCache& operator=(const OpStatCache& other) {
+      stat = other.stat.load();
+      return *this;
+    }
+
+    std::atomic<platform::OpStat*> stat{nullptr};
+  };
+  OpStatCache op_stat_;
+
  private:
   void GenerateTemporaryNames();
   void CheckAllInputOutputSet() const;
@@ -68,6 +68,17 @@ ThreadPool::~ThreadPool() {
   }
 }
 
+void ThreadPool::RecordQueueWait(uint64_t enqueue_ns) {
+  auto& recorder = platform::ChromeTracingRecorder::Instance();
+  if (!platform::ChromeTracingRecorder::IsEnabled()) return;
+  if (recorder.BeginScope()) {
+    recorder.AddCompleteEvent("ThreadPool::QueueWait",
+                              platform::kTraceCategoryThreadPool, enqueue_ns,
+                              platform::ChromeTracingRecorder::NowInNsec());
+  }
+  recorder.EndScope();
+}
+
 void ThreadPool::TaskLoop() {
   while (true) {
     Task task;
@@ -25,6 +25,7 @@ limitations under the License. */
 #include <vector>
 
 #include "glog/logging.h"
+#include "paddle/fluid/platform/chrome_tracing_recorder.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/macros.h"  // for DISABLE_COPY_AND_ASSIGN
 
@@ -73,7 +74,13 @@ class ThreadPool {
   template <typename Callback>
   std::future<std::unique_ptr<platform::EnforceNotMet>> RunAndGetException(
       Callback fn) {
-    Task task([fn]() -> std::unique_ptr<platform::EnforceNotMet> {
+    uint64_t enqueue_ns = platform::ChromeTracingRecorder::IsEnabled()
+                              ? platform::ChromeTracingRecorder::NowInNsec()
+                              : 0;
+    Task task([fn, enqueue_ns]() -> std::unique_ptr<platform::EnforceNotMet> {
+      if (enqueue_ns != 0) {
+        RecordQueueWait(enqueue_ns);
+      }
       try {
         fn();
       } catch (platform::EnforceNotMet& ex) {
@@ -104,6 +111,9 @@ class ThreadPool {
  private:
   DISABLE_COPY_AND_ASSIGN(ThreadPool);
 
+  // Record the time that a task waits in the queue to Chrome trace timeline
+  static void RecordQueueWait(uint64_t enqueue_ns);
+
   // The constructor starts threads to run TaskLoop, which retrieves
   // and runs tasks from the queue.
   void TaskLoop();
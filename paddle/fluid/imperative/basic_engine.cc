@@ -78,6 +78,13 @@ void BasicEngine::Init(VarBase* var, bool retain_graph) {
   grad_var->Resize(fwd_var.dims());
   grad_var->mutable_data(fwd_var.place(), fwd_var.type());
   operators::math::set_constant(*dev_ctx, grad_var, 1.0);
+
+  auto& tracer = GetCurrentTracer();
+  if (tracer && tracer->IsProgramDescTracingEnabled()) {
+    VLOG(5) << "Trace the grad of loss " << var->Name() << " into ProgramDesc";
+    tracer->GetProgramDescTracer()->SetLossGrad(
+        var->GradVarBase()->SharedVar());
+  }
 }
 
 void BasicEngine::CheckBackwardInputs(const OpBase& op) {
@@ -127,6 +134,7 @@ void BasicEngine::PrepareGradAccumulators(const OpBase& op) {
       }
 
       accumulator->IncreaseRefCnt();
+      accumulator->AddTraceId(op.id());
 
       VLOG(3) << "Prepare to acccumulate variable grad " << var->Name() << "("
               << var.get() << ")  with reference count "
@@ -188,6 +196,13 @@ void BasicEngine::Execute() {
   }
 
   PrepareDeps();
+
+  jit::ProgramDescTracer* program_desc_tracer = nullptr;
+  auto& tracer = GetCurrentTracer();
+  if (tracer && tracer->IsProgramDescTracingEnabled()) {
+    program_desc_tracer = tracer->GetProgramDescTracer();
+  }
+
   // Start execute Computation graph
   std::queue<std::shared_ptr<GradOpNode>> q;
   q.push(std::move(init_node_));
@@ -237,7 +252,8 @@ void BasicEngine::Execute() {
             }
           }
 
-          if (var->OverridedStopGradient() || iter->second->RefCnt() > 1) {
+          if (var->OverridedStopGradient() || iter->second->RefCnt() > 1 ||
+              iter->second->AccumulateInPlace()) {
             auto tmp_var = std::make_shared<VariableWrapper>(var->Name());
             tmp_var->SetType(var->Type());
             tmp_var->SetForwardDataType(var->ForwardDataType());
@@ -274,6 +290,12 @@ void BasicEngine::Execute() {
         }
       }
 
+      if (program_desc_tracer) {
+        VLOG(5) << "Trace grad op " << cur_op.Type() << " into ProgramDesc";
+        program_desc_tracer->InsertGradOp(cur_op.Type(), bwd_ins, bwd_outs,
+                                          cur_op.Attrs());
+      }
+
       {
         VLOG(3) << "Start to execute grad op " << cur_op.Type();
         OpBase::Run(cur_op.InnerOp(), bwd_ins, tmp_outs, cur_op.Attrs(),
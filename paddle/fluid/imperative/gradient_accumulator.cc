@@ -15,6 +15,7 @@
 #include "paddle/fluid/imperative/gradient_accumulator.h"
 
 #include <algorithm>
+#include <functional>
 #include <memory>
 #include <utility>
 
@@ -431,7 +432,7 @@ void EagerGradientAccumulator::SumGrad(std::shared_ptr<VariableWrapper> var,
   auto* dst_var = Var();
   platform::Place place = GetPlaceOfVar(var);
   if (!dst_var->OverridedStopGradient()) {
-    if (CurCnt() == 0) {
+    if (CurCnt() == 0 && !AccumulateInPlace()) {
       MoveOrCopyVar(dst_var->MutableVar(), var->MutableVar(), unchange_input);
     } else {
       VLOG(6) << "Sum Gradient for: " << dst_var->Name()
@@ -478,8 +479,16 @@ void SortedGradientAccumulator::SumGrad(std::shared_ptr<VariableWrapper> var,
   platform::Place place = GetPlaceOfVar(var);
   if (!dst_var->OverridedStopGradient()) {
     if (ref_cnt_ == 1) {
-      MoveOrCopyVar(dst_var->MutableVar(), var->MutableVar(),
-                    unchange_input || var->HasGradNode());
+      if (AccumulateInPlace()) {
+        VariableWrapperAdd(var, dst_var,
+                           unchange_input || var->HasGradNode());
+      } else {
+        MoveOrCopyVar(dst_var->MutableVar(), var->MutableVar(),
+                      unchange_input || var->HasGradNode());
+      }
+    } else if (trace_ids_.size() == ref_cnt_ &&
+               !platform::is_gpu_place(place)) {
+      SumGradInOrder(std::move(var), trace_id, unchange_input);
     } else {
       if (tmp_grad_vars_.empty()) {
         tmp_grad_vars_.reserve(ref_cnt_);
@@ -512,7 +521,7 @@ void SortedGradientAccumulator::SumGrad(std::shared_ptr<VariableWrapper> var,
             continue;
           }
 
-          if (CurCnt() == 0) {
+          if (CurCnt() == 0 && !AccumulateInPlace()) {
             MoveOrCopyVar(dst_var->MutableVar(), var_info.var->MutableVar(),
                           var_info.unchange_input);
           } else {
@@ -532,7 +541,7 @@ void SortedGradientAccumulator::SumGrad(std::shared_ptr<VariableWrapper> var,
           PADDLE_ENFORCE_EQ(var_info.var->Var().IsType<framework::LoDTensor>(),
                             true, platform::errors::PermissionDenied(
                                       "Gradient var must be LoDTensor"));
-          if (CurCnt() == 0) {
+          if (CurCnt() == 0 && !AccumulateInPlace()) {
             MoveOrCopyVar(dst_var->MutableVar(), var_info.var->MutableVar(),
                           var_info.unchange_input);
           } else {
@@ -555,7 +564,7 @@ void SortedGradientAccumulator::SumGrad(std::shared_ptr<VariableWrapper> var,
               true, platform::errors::PermissionDenied("The type of Gradient "
                                                        "var must be LoDTensor "
                                                        "or SelectedRows"));
-          if (CurCnt() == 0) {
+          if (CurCnt() == 0 && !AccumulateInPlace()) {
             MoveOrCopyVar(dst_var->MutableVar(), var_info.var->MutableVar(),
                           var_info.unchange_input);
           } else {
@@ -601,5 +610,55 @@ void SortedGradientAccumulator::SumGrad(std::shared_ptr<VariableWrapper> var,
   }
 }
 
+void SortedGradientAccumulator::SumGradInOrder(
+    std::shared_ptr<VariableWrapper> var, size_t trace_id,
+    bool unchange_input) {
+  if (CurCnt() == 0 && tmp_grad_vars_.empty()) {
+    std::sort(trace_ids_.begin(), trace_ids_.end(), std::greater<size_t>());
+  }
+  tmp_grad_vars_.emplace_back(std::move(var), trace_id, unchange_input);
+
+  // All trace ids are known in advance, so a partial grad can be summed as
+  // soon as the partial grads with larger trace ids have been summed. It is
+  // released right after summing instead of being held until the last
+  // partial grad arrives, while the summation order keeps the same as
+  // summing all of them after sorting.
+  auto* dst_var = Var();
+  bool summed = true;
+  while (summed && CurCnt() < ref_cnt_) {
+    summed = false;
+    auto expected_trace_id = trace_ids_[CurCnt()];
+    for (auto iter = tmp_grad_vars_.begin(); iter != tmp_grad_vars_.end();
+         ++iter) {
+      if (iter->trace_id != expected_trace_id) {
+        continue;
+      }
+
+      if (iter->var->HasGradNode()) {
+        iter->unchange_input = true;
+      }
+      VLOG(6) << "Sum Gradient for: " << dst_var->Name()
+              << " of trace id " << expected_trace_id << " in order";
+      if (CurCnt() == 0 && !AccumulateInPlace()) {
+        MoveOrCopyVar(dst_var->MutableVar(), iter->var->MutableVar(),
+                      iter->unchange_input);
+      } else {
+        VariableWrapperAdd(iter->var, dst_var, iter->unchange_input);
+      }
+      tmp_grad_vars_.erase(iter);
+      IncreaseCurCnt();
+      summed = true;
+      break;
+    }
+  }
+
+  PADDLE_ENFORCE_EQ(
+      CurCnt() + tmp_grad_vars_.size() < ref_cnt_ || tmp_grad_vars_.empty(),
+      true, platform::errors::PreconditionNotMet(
+                "The trace ids of partial gradients of %s do not match the "
+                "recorded ones.",
+                dst_var->Name()));
+}
+
 }  // namespace imperative
 }  // namespace paddle
@@ -26,7 +26,11 @@ namespace imperative {
 
 class GradientAccumulator {
  public:
-  explicit GradientAccumulator(VariableWrapper* var) {
+  // If allow_in_place is false, the partial grads of this graph are always
+  // summed into an inner var before being added to the grad of previous
+  // graph, i.e. leaf + (p1 + p2 + ...), instead of leaf + p1 + p2 + ....
+  explicit GradientAccumulator(VariableWrapper* var,
+                               bool allow_in_place = true) {
     // var may be initialized, so Synchronous VariableWrapper with Variable
     if (var && var->Var().IsInitialized()) {
       if (var->Var().IsType<framework::LoDTensor>()) {
@@ -42,13 +46,22 @@ class GradientAccumulator {
     // inner_var_ record the grad of this auto-grad.
     // Only need to generate inner var for non-empty leaf-tensor.
     if (var->IsLeafGrad() && !var->IsEmpty()) {
-      inner_var_ = std::make_shared<VariableWrapper>(var->Name());
-      inner_var_->SetType(var->Type());
-      inner_var_->SetDataType(var->DataType());
-      inner_var_->InnerSetOverridedStopGradient(
-          var->InnerOverridedStopGradient());
-      VLOG(6) << " Create inner grad var for (" << var->Name()
-              << ") to store result of this Graph";
+      if (allow_in_place && var->Var().IsType<framework::LoDTensor>()) {
+        // The grad of previous graph is held by a dense tensor, so the
+        // partial grads of this graph can be summed into it directly,
+        // which avoids holding another buffer as large as the leaf grad.
+        accumulate_in_place_ = true;
+        VLOG(6) << " Accumulate grad var (" << var->Name()
+                << ") of this Graph in place";
+      } else {
+        inner_var_ = std::make_shared<VariableWrapper>(var->Name());
+        inner_var_->SetType(var->Type());
+        inner_var_->SetDataType(var->DataType());
+        inner_var_->InnerSetOverridedStopGradient(
+            var->InnerOverridedStopGradient());
+        VLOG(6) << " Create inner grad var for (" << var->Name()
+                << ") to store result of this Graph";
+      }
     }
 
     // TODO(zhouwei): fix Tensor.clear_gradient() bug, remove this hard flag
@@ -92,6 +105,14 @@ class GradientAccumulator {
 
   inline bool HasInnerVar() const { return inner_var_ != nullptr; }
 
+  // If true, partial grads must be summed into var_ and can never be moved
+  // into it, because var_ holds the grad of previous graph.
+  inline bool AccumulateInPlace() const { return accumulate_in_place_; }
+
+  // Record the trace id of the grad op which generates a partial grad of
+  // this var. It should be called once for each IncreaseRefCnt().
+  virtual void AddTraceId(size_t trace_id) {}
+
   /* Hook related methods */
   inline bool HasPostHooks() const { return !post_hooks_.expired(); }
 
@@ -136,6 +157,7 @@ class GradientAccumulator {
   std::shared_ptr<VariableWrapper> inner_var_;
   size_t ref_cnt_{0};
   size_t cur_cnt_{0};
+  bool accumulate_in_place_{false};
   std::weak_ptr<LeafVarHookPipeline> post_hooks_;
 };
 
@@ -149,11 +171,23 @@ class EagerGradientAccumulator : public GradientAccumulator {
 
 class SortedGradientAccumulator : public GradientAccumulator {
  public:
-  using GradientAccumulator::GradientAccumulator;
+  // The grad of previous graph is never accumulated in place, so that the
+  // partial grads are summed in the same order as before, and the results
+  // of FLAGS_sort_sum_gradient are reproducible bit for bit.
+  explicit SortedGradientAccumulator(VariableWrapper* var)
+      : GradientAccumulator(var, /*allow_in_place=*/false) {}
 
   void SumGrad(std::shared_ptr<VariableWrapper> var, size_t trace_id,
                bool unchange_input) override;
 
+  void AddTraceId(size_t trace_id) override {
+    trace_ids_.emplace_back(trace_id);
+  }
+
+ private:
+  void SumGradInOrder(std::shared_ptr<VariableWrapper> var, size_t trace_id,
+                      bool unchange_input);
+
  private:
   struct SavedVarInfo {
     SavedVarInfo(std::shared_ptr<VariableWrapper>&& v, size_t id,
@@ -168,6 +202,9 @@ class SortedGradientAccumulator : public GradientAccumulator {
   };
 
   std::vector<SavedVarInfo> tmp_grad_vars_;
+  // trace ids of all partial grads, sorted in descending order once the
+  // first partial grad arrives
+  std::vector<size_t> trace_ids_;
 };
 
 }  // namespace imperative
@@ -0,0 +1,375 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/imperative/jit/program_desc_replayer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/framework/ir/fuse_pass_base.h"
+#include "paddle/fluid/framework/ir/graph.h"
+#include "paddle/fluid/framework/ir/pass.h"
+#include "paddle/fluid/framework/tensor_util.h"
+#include "paddle/fluid/platform/profiler.h"
+
+namespace paddle {
+namespace imperative {
+
+void TensorAdd(const framework::Variable &src, framework::Variable *dst);
+
+namespace jit {
+
+static bool IsSameTensor(const framework::LoDTensor &x,
+                         const framework::LoDTensor &y) {
+  if (x.IsInitialized() != y.IsInitialized()) return false;
+  if (!x.IsInitialized()) return true;
+  if (x.type() != y.type() || x.dims() != y.dims()) return false;
+  framework::LoDTensor cpu_x, cpu_y;
+  framework::TensorCopySync(x, platform::CPUPlace(), &cpu_x);
+  framework::TensorCopySync(y, platform::CPUPlace(), &cpu_y);
+  return std::memcmp(cpu_x.data<void>(), cpu_y.data<void>(),
+                     cpu_x.numel() * framework::SizeOfType(cpu_x.type())) == 0;
+}
+
+ProgramDescReplayer::ProgramDescReplayer(
+    const framework::ProgramDesc &program,
+    const std::vector<std::string> &feed_var_names,
+    const std::vector<std::string> &fetch_var_names,
+    const std::vector<std::shared_ptr<VarBase>> &persistable_vars,
+    const platform::Place &place, const std::vector<std::string> &passes,
+    bool enable_memory_reuse)
+    : program_(new framework::ProgramDesc(program)),
+      feed_var_names_(feed_var_names),
+      fetch_var_names_(fetch_var_names),
+      persistable_vars_(persistable_vars),
+      place_(place),
+      executor_(place) {
+  PADDLE_ENFORCE_EQ(program_->Size(), 1UL,
+                    platform::errors::InvalidArgument(
+                        "The traced program should only contain 1 block, but "
+                        "received %d blocks.",
+                        program_->Size()));
+  if (!passes.empty()) {
+    ApplyPasses(passes);
+  }
+  ShareParameters();
+
+  auto &block = program_->Block(0);
+  for (auto &var : persistable_vars_) {
+    auto grad_name = framework::GradVarName(var->Name());
+    if (block.FindVar(grad_name) == nullptr) continue;
+    for (auto *op : block.AllOps()) {
+      auto out_names = op->OutputArgumentNames();
+      if (std::find(out_names.begin(), out_names.end(), grad_name) !=
+          out_names.end()) {
+        param_grads_.emplace_back(var, grad_name);
+        break;
+      }
+    }
+  }
+
+  if (enable_memory_reuse) {
+    ReuseMemory();
+  }
+
+  // The fetch vars and the grads of parameters are held by VarBases after
+  // each run, so they must not be released by the garbage collector.
+  std::vector<std::string> keep_vars(fetch_var_names_);
+  for (auto &pair : param_grads_) {
+    keep_vars.emplace_back(pair.second);
+  }
+  prepared_ctx_ = framework::Executor::Prepare(*program_, 0, keep_vars);
+  executor_.CreateVariables(*program_, &scope_, 0);
+  VLOG(3) << "Prepare program with " << prepared_ctx_->ops_.size()
+          << " ops for replaying, " << param_grads_.size()
+          << " parameter grads are generated and " << reused_var_count_
+          << " vars reuse the memory of others";
+}
+
+void ProgramDescReplayer::ShareParameters() {
+  // NOTE: The holder of a parameter may be changed by the optimizer in
+  // dygraph mode, so share it again before each run.
+  for (auto &var : persistable_vars_) {
+    if (rewritten_params_.count(var->Name()) > 0) continue;
+    auto *dst = scope_.Var(var->Name())->GetMutable<framework::LoDTensor>();
+    dst->ShareDataWith(var->Var().Get<framework::LoDTensor>());
+  }
+}
+
+void ProgramDescReplayer::ApplyPasses(const std::vector<std::string> &passes) {
+  // The passes may rewrite the parameters in the param scope, so they run on
+  // copies instead of the tensors of the dygraph model.
+  for (auto &var : persistable_vars_) {
+    auto &src = var->Var().Get<framework::LoDTensor>();
+    if (!src.IsInitialized()) continue;
+    auto *dst = scope_.Var(var->Name())->GetMutable<framework::LoDTensor>();
+    framework::TensorCopySync(src, place_, dst);
+  }
+
+  std::unique_ptr<framework::ir::Graph> graph(
+      new framework::ir::Graph(*program_));
+  graph->SetNotOwned(framework::ir::kParamScopeAttr, &scope_);
+
+  auto &registry = framework::ir::PassRegistry::Instance();
+  for (auto &pass_type : passes) {
+    PADDLE_ENFORCE_EQ(
+        registry.Has(pass_type), true,
+        platform::errors::NotFound("Pass %s is not registered.", pass_type));
+    VLOG(3) << "Apply " << pass_type << " on traced program";
+    graph.reset(registry.Get(pass_type)->Apply(graph.release()));
+  }
+
+  framework::ProgramDesc optimized_program;
+  auto to_program_pass = registry.Get("graph_to_program_pass");
+  to_program_pass->SetNotOwned("program", &optimized_program);
+  graph.reset(to_program_pass->Apply(graph.release()));
+  program_.reset(new framework::ProgramDesc(optimized_program));
+
+  // Keep the copies rewritten by the passes, and share the others with the
+  // dygraph model again.
+  for (auto &var : persistable_vars_) {
+    auto *copy = scope_.FindVar(var->Name());
+    if (copy == nullptr || !copy->IsType<framework::LoDTensor>()) continue;
+    if (!IsSameTensor(var->Var().Get<framework::LoDTensor>(),
+                      copy->Get<framework::LoDTensor>())) {
+      VLOG(3) << "Parameter " << var->Name() << " is rewritten by the passes";
+      rewritten_params_.insert(var->Name());
+    }
+  }
+}
+
+// Rename the outputs of ops to the vars which are no longer used, so that
+// the program reuses their memory, which is what
+// buffer_shared_cross_op_memory_reuse_pass and buffer_shared_inplace_pass do
+// on the graph of ParallelExecutor. An output reuses an input of its own op
+// only when the op declares them as an inplace pair.
+void ProgramDescReplayer::ReuseMemory() {
+  auto *block = program_->MutableBlock(0);
+  std::unordered_set<std::string> skip_vars(feed_var_names_.begin(),
+                                            feed_var_names_.end());
+  skip_vars.insert(fetch_var_names_.begin(), fetch_var_names_.end());
+  for (auto &pair : param_grads_) {
+    skip_vars.insert(pair.second);
+  }
+
+  auto ops = block->AllOps();
+  // The index of the last op using each var, and the number of ops writing it
+  std::unordered_map<std::string, size_t> last_used;
+  std::unordered_map<std::string, size_t> write_cnt;
+  for (size_t i = 0; i < ops.size(); ++i) {
+    for (auto &name : ops[i]->InputArgumentNames()) {
+      last_used[name] = i;
+    }
+    for (auto &name : ops[i]->OutputArgumentNames()) {
+      last_used[name] = i;
+      ++write_cnt[name];
+    }
+  }
+
+  auto memory_size = [block](const std::string &name) {
+    auto *var_desc = block->FindVar(name);
+    int64_t numel = 1;
+    for (auto dim : var_desc->GetShape()) {
+      if (dim < 0) return static_cast<int64_t>(-1);
+      numel *= dim;
+    }
+    return numel *
+           static_cast<int64_t>(framework::SizeOfType(var_desc->GetDataType()));
+  };
+  // Only the dense tensors without LoD, whose sizes are known, are reused,
+  // since an op may leave the LoD of a reused var as it is.
+  auto is_reusable = [&](const std::string &name) {
+    if (name == framework::kEmptyVarName || skip_vars.count(name) > 0) {
+      return false;
+    }
+    auto *var_desc = block->FindVar(name);
+    return var_desc != nullptr && !var_desc->Persistable() &&
+           var_desc->GetType() == framework::proto::VarType::LOD_TENSOR &&
+           var_desc->GetLoDLevel() == 0 && memory_size(name) > 0;
+  };
+  auto same_dtype = [block](const std::string &x, const std::string &y) {
+    return block->FindVar(x)->GetDataType() == block->FindVar(y)->GetDataType();
+  };
+
+  std::unordered_map<std::string, std::string> renamed_vars;
+  // The vars which are no longer used, ordered by their memory sizes
+  std::multimap<int64_t, std::string> free_vars;
+  for (size_t i = 0; i < ops.size(); ++i) {
+    auto *op = ops[i];
+    for (auto &name : op->InputArgumentNames()) {
+      auto iter = renamed_vars.find(name);
+      if (iter != renamed_vars.end()) {
+        op->RenameInput(name, iter->second);
+      }
+    }
+
+    auto in_names = op->InputArgumentNames();
+    auto out_names = op->OutputArgumentNames();
+    auto count = [](const std::vector<std::string> &names,
+                    const std::string &name) {
+      return std::count(names.begin(), names.end(), name);
+    };
+
+    // An output only reuses a var freed by the previous ops, but not the
+    // inputs of the op itself. Renaming an output to its input makes both
+    // the same tensor, while the kernels which support inplace, e.g. the
+    // broadcast of elementwise_add_grad, expect two tensors sharing buffer.
+    for (auto &name : out_names) {
+      if (!is_reusable(name) || write_cnt[name] != 1 ||
+          count(out_names, name) != 1 || count(in_names, name) != 0) {
+        continue;
+      }
+
+      std::string target;
+      for (auto iter = free_vars.lower_bound(memory_size(name));
+           iter != free_vars.end(); ++iter) {
+        if (same_dtype(iter->second, name)) {
+          target = iter->second;
+          free_vars.erase(iter);
+          break;
+        }
+      }
+      if (target.empty()) continue;
+      VLOG(4) << "Reuse " << target << " as " << name << " in op "
+              << op->Type();
+
+      op->RenameOutput(name, target);
+      renamed_vars[name] = target;
+      last_used[target] = last_used[name];
+      block->RemoveVar(name);
+      ++reused_var_count_;
+    }
+
+    std::unordered_set<std::string> used_names(in_names.begin(),
+                                               in_names.end());
+    for (auto &name : op->OutputArgumentNames()) {
+      used_names.insert(name);
+    }
+    for (auto &name : used_names) {
+      if (last_used[name] == i && write_cnt[name] > 0 && is_reusable(name)) {
+        free_vars.emplace(memory_size(name), name);
+      }
+    }
+  }
+  program_->Flush();
+}
+
+void ProgramDescReplayer::AccumulateParameterGrads() {
+  for (auto &pair : param_grads_) {
+    auto *src = scope_.FindVar(pair.second);
+    PADDLE_ENFORCE_EQ(
+        src->IsType<framework::LoDTensor>(), true,
+        platform::errors::Unimplemented(
+            "Only LoDTensor grads of parameters are supported in replaying, "
+            "but the grad of %s is %s.",
+            pair.first->Name(), framework::ToTypeName(src->Type())));
+    auto &grad_var = pair.first->MutableGradVarBase();
+    if (grad_var->SharedVar()->IsEmpty()) {
+      auto *dst = grad_var->MutableVar()->GetMutable<framework::LoDTensor>();
+      dst->ShareDataWith(src->Get<framework::LoDTensor>());
+      grad_var->SharedVar()->SetIsEmpty(false);
+    } else {
+      TensorAdd(*src, grad_var->MutableVar());
+    }
+    // The grad is held by the grad var of the parameter now
+    src->GetMutable<framework::LoDTensor>()->clear();
+  }
+}
+
+bool ProgramDescReplayer::IsCompatible(
+    const std::vector<std::shared_ptr<VarBase>> &feed_vars) const {
+  if (feed_vars.size() != feed_var_names_.size()) {
+    VLOG(3) << "Feed number changes from " << feed_var_names_.size() << " to "
+            << feed_vars.size();
+    return false;
+  }
+
+  auto &block = program_->Block(0);
+  for (size_t i = 0; i < feed_vars.size(); ++i) {
+    auto &var = feed_vars[i]->Var();
+    if (!var.IsType<framework::LoDTensor>() ||
+        !var.Get<framework::LoDTensor>().IsInitialized()) {
+      return false;
+    }
+    auto &tensor = var.Get<framework::LoDTensor>();
+    auto *var_desc = block.FindVar(feed_var_names_[i]);
+    if (var_desc == nullptr || var_desc->GetDataType() != tensor.type() ||
+        var_desc->GetShape() != framework::vectorize<int64_t>(tensor.dims())) {
+      VLOG(3) << "Signature of feed var " << feed_var_names_[i]
+              << " changes, current dims: " << tensor.dims();
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ProgramDescReplayer::Run(
+    const std::vector<std::shared_ptr<VarBase>> &feed_vars,
+    std::vector<std::shared_ptr<VarBase>> *fetch_vars) {
+  PADDLE_ENFORCE_NOT_NULL(
+      fetch_vars, platform::errors::InvalidArgument(
+                      "The fetch vars of ProgramDescReplayer is NULL."));
+  if (!IsCompatible(feed_vars)) {
+    ++fallback_count_;
+    return false;
+  }
+
+  platform::RecordEvent record_event("ProgramDescReplayer::Run");
+  ShareParameters();
+  for (size_t i = 0; i < feed_vars.size(); ++i) {
+    auto *dst =
+        scope_.FindVar(feed_var_names_[i])->GetMutable<framework::LoDTensor>();
+    auto &src = feed_vars[i]->Var().Get<framework::LoDTensor>();
+    dst->ShareDataWith(src);
+    dst->set_lod(src.lod());
+  }
+
+  executor_.RunPreparedContext(prepared_ctx_.get(), &scope_,
+                               /*create_local_scope=*/false,
+                               /*create_vars=*/false);
+  AccumulateParameterGrads();
+
+  fetch_vars->clear();
+  fetch_vars->reserve(fetch_var_names_.size());
+  for (auto &name : fetch_var_names_) {
+    auto *src = scope_.FindVar(name)->GetMutable<framework::LoDTensor>();
+    std::shared_ptr<VarBase> out(new VarBase(false, name));
+    out->SetOverridedStopGradient(true);
+    auto *dst = out->MutableVar()->GetMutable<framework::LoDTensor>();
+    dst->ShareDataWith(*src);
+    dst->set_lod(src->lod());
+    // Release the holder from the scope, otherwise the next run may write
+    // into the memory which is still referenced by the returned VarBase.
+    src->clear();
+    fetch_vars->emplace_back(std::move(out));
+  }
+
+  // Do not hold the feed vars after running
+  for (auto &name : feed_var_names_) {
+    scope_.FindVar(name)->GetMutable<framework::LoDTensor>()->clear();
+  }
+
+  ++replay_count_;
+  return true;
+}
+
+}  // namespace jit
+}  // namespace imperative
+}  // namespace paddle
+
+USE_PASS(graph_to_program_pass);
@@ -0,0 +1,120 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "paddle/fluid/framework/executor.h"
+#include "paddle/fluid/framework/program_desc.h"
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/imperative/layer.h"
+#include "paddle/fluid/platform/macros.h"
+#include "paddle/fluid/platform/place.h"
+
+namespace paddle {
+namespace imperative {
+namespace jit {
+
+/*
+ * ProgramDescReplayer runs a program captured by ProgramDescTracer again and
+ * again without re-entering Tracer::TraceOp. The captured program is
+ * optimized by the given IR passes once, prepared once, and then executed
+ * inside a private scope which shares the persistable vars (parameters) with
+ * the dygraph model.
+ *
+ * The passes run on copies of the parameters, so the passes which rewrite
+ * weights, e.g. conv_bn_fuse_pass, never touch the dygraph model. The
+ * rewritten parameters are owned by the private scope and are not updated
+ * when the dygraph model changes them later, so such passes are meant for
+ * replaying inference.
+ *
+ * When the traced iteration runs backward, the program contains the grad ops
+ * recorded from BasicEngine as well, and each run accumulates the grads of
+ * the parameters into their grad vars, like BasicEngine does. If
+ * enable_memory_reuse is true, the outputs of ops reuse the memory of the vars
+ * which are no longer used by the following ops.
+ *
+ * The captured program is only valid for the input signature (shape and
+ * data type of each feed var) it was traced with. Run returns false when the
+ * given inputs do not match that signature, and the caller should fall back
+ * to eager mode.
+ */
+class ProgramDescReplayer {
+  DISABLE_COPY_AND_ASSIGN(ProgramDescReplayer);
+
+ public:
+  ProgramDescReplayer(
+      const framework::ProgramDesc &program,
+      const std::vector<std::string> &feed_var_names,
+      const std::vector<std::string> &fetch_var_names,
+      const std::vector<std::shared_ptr<VarBase>> &persistable_vars,
+      const platform::Place &place,
+      const std::vector<std::string> &passes = std::vector<std::string>(),
+      bool enable_memory_reuse = true);
+
+  bool IsCompatible(
+      const std::vector<std::shared_ptr<VarBase>> &feed_vars) const;
+
+  bool Run(const std::vector<std::shared_ptr<VarBase>> &feed_vars,
+           std::vector<std::shared_ptr<VarBase>> *fetch_vars);
+
+  const framework::ProgramDesc &Program() const { return *program_; }
+
+  size_t ReplayCount() const { return replay_count_; }
+
+  size_t FallbackCount() const { return fallback_count_; }
+
+  size_t ReusedVarCount() const { return reused_var_count_; }
+
+  size_t RewrittenParamCount() const { return rewritten_params_.size(); }
+
+ private:
+  void ApplyPasses(const std::vector<std::string> &passes);
+
+  void ReuseMemory();
+
+  void ShareParameters();
+
+  void AccumulateParameterGrads();
+
+ private:
+  std::unique_ptr<framework::ProgramDesc> program_;
+  std::vector<std::string> feed_var_names_;
+  std::vector<std::string> fetch_var_names_;
+  std::vector<std::shared_ptr<VarBase>> persistable_vars_;
+  // The parameters rewritten by the passes, whose copies in scope_ are used
+  // instead of the dygraph parameters
+  std::unordered_set<std::string> rewritten_params_;
+  // The parameters whose grads are generated by the program, and the names
+  // of the grads
+  std::vector<std::pair<std::shared_ptr<VarBase>, std::string>> param_grads_;
+  platform::Place place_;
+
+  framework::Scope scope_;
+  framework::Executor executor_;
+  std::unique_ptr<framework::ExecutorPrepareContext> prepared_ctx_;
+
+  size_t replay_count_{0};
+  size_t fallback_count_{0};
+  size_t reused_var_count_{0};
+};
+
+}  // namespace jit
+}  // namespace imperative
+}  // namespace paddle
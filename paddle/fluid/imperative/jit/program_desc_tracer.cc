@@ -14,9 +14,12 @@
 
 #include "paddle/fluid/imperative/jit/program_desc_tracer.h"
 
+#include <iterator>
 #include <unordered_map>
 #include <unordered_set>
 
+#include "paddle/fluid/framework/operator.h"
+
 namespace paddle {
 namespace imperative {
 class VarBase;
@@ -184,6 +187,27 @@ TracedProgramTuple ProgramDescTracer::CreateProgramDesc(
     }
   }
 
+  if (!grad_ops_.empty()) {
+    auto name_of = [&](const GradOpVar &var) -> std::string {
+      if (vars_.count(var.var) == 0) {
+        return framework::kEmptyVarName;
+      }
+      auto name = generator.NameOf(var.var, tmp_prefix);
+      if (!var.is_grad) {
+        return name;
+      }
+      auto grad_name = framework::GradVarName(name);
+      if (!block->HasVar(grad_name)) {
+        auto *grad_var_desc = block->Var(grad_name);
+        *grad_var_desc = *block->FindVar(name);
+        grad_var_desc->SetName(grad_name);
+        grad_var_desc->SetPersistable(false);
+      }
+      return grad_name;
+    };
+    AppendGradOps(block, name_of);
+  }
+
   prog->Flush();
 
   std::vector<std::shared_ptr<VarBase>> persistable_vars(
@@ -202,6 +226,165 @@ TracedProgramTuple ProgramDescTracer::CreateProgramDesc(
                          std::move(persistable_vars));
 }
 
+void ProgramDescTracer::SetLossGrad(
+    const std::shared_ptr<VariableWrapper> &loss_grad) {
+  auto var = FindGradOpVar(loss_grad);
+  PADDLE_ENFORCE_EQ(var.is_grad, true,
+                    platform::errors::InvalidArgument(
+                        "Variable %s is not the grad var of the loss.",
+                        loss_grad->Name()));
+  loss_ = var.var;
+}
+
+void ProgramDescTracer::InsertGradOp(const std::string &type,
+                                     const NameVarMap<VariableWrapper> &inputs,
+                                     const NameVarMap<VariableWrapper> &outputs,
+                                     const framework::AttributeMap &attrs) {
+  PADDLE_ENFORCE_GT(
+      vars_.count(loss_), 0,
+      platform::errors::PreconditionNotMet(
+          "The loss of grad op %s is not set by SetLossGrad.", type));
+  GradOpDescMeta op;
+  op.type = type;
+  op.attrs = attrs;
+  for (auto &pair : inputs) {
+    auto &vars = op.inputs[pair.first];
+    for (auto &var : pair.second) {
+      vars.emplace_back(FindGradOpVar(var));
+    }
+  }
+  for (auto &pair : outputs) {
+    auto &vars = op.outputs[pair.first];
+    for (auto &var : pair.second) {
+      vars.emplace_back(FindGradOpVar(var));
+    }
+  }
+  grad_ops_.emplace_back(std::move(op));
+}
+
+GradOpVar ProgramDescTracer::FindGradOpVar(
+    const std::shared_ptr<VariableWrapper> &var) {
+  if (var == nullptr) {
+    return GradOpVar{std::weak_ptr<VarBase>(), true};
+  }
+
+  auto iter = var_wrappers_.find(var.get());
+  if (iter == var_wrappers_.end() || iter->second.first.lock() != var) {
+    // The grad vars may be created after the forward ops are traced, so
+    // collect them again.
+    var_wrappers_.clear();
+    for (auto &pair : traced_var_wrappers_) {
+      auto fwd_var = pair.second.lock();
+      if (fwd_var == nullptr) continue;
+      var_wrappers_[fwd_var.get()] =
+          std::make_pair(fwd_var, GradOpVar{pair.first, false});
+      if (auto grad_var = fwd_var->GetGradVar()) {
+        var_wrappers_[grad_var.get()] =
+            std::make_pair(grad_var, GradOpVar{pair.first, true});
+      }
+    }
+    iter = var_wrappers_.find(var.get());
+  }
+
+  if (iter == var_wrappers_.end()) {
+    // The grad op holds a copy without data of each input whose buffer is
+    // not needed, see ClearNoNeedBufferInputs, and the forward wrapper of a
+    // grad var may be freed with its VarBase, so find them by their names.
+    const auto &name = var->Name();
+    auto fwd_name = framework::GradOriginalVarName(name);
+    bool is_grad = fwd_name != name;
+    auto range = traced_names_.equal_range(fwd_name);
+    if (range.first != range.second && std::next(range.first) == range.second) {
+      VLOG(5) << "Find variable " << name << " of grad op by name";
+      return GradOpVar{range.first->second, is_grad};
+    }
+  }
+
+  PADDLE_ENFORCE_EQ(
+      iter != var_wrappers_.end() && iter->second.first.lock() == var, true,
+      platform::errors::Unimplemented(
+          "Variable %s of the grad op is neither a traced variable nor the "
+          "grad variable of one. The backward of the ops run before tracing, "
+          "and of the inplace ops, can not be traced.",
+          var->Name()));
+  return iter->second.second;
+}
+
+void ProgramDescTracer::AppendGradOps(
+    framework::BlockDesc *block,
+    const std::function<std::string(const GradOpVar &)> &name_of) const {
+  auto append_fill_constant = [block](const std::string &name, float value) {
+    auto *var_desc = block->FindVar(name);
+    auto *op_desc = block->AppendOp();
+    op_desc->SetType("fill_constant");
+    op_desc->SetOutput("Out", {name});
+    op_desc->SetAttr("shape", var_desc->GetShape());
+    op_desc->SetAttr("dtype", static_cast<int>(var_desc->GetDataType()));
+    op_desc->SetAttr("value", value);
+  };
+
+  // BasicEngine::Init fills the grad of the loss with 1
+  std::unordered_set<std::string> generated_grads;
+  auto loss_grad_name = name_of(GradOpVar{loss_, true});
+  append_fill_constant(loss_grad_name, 1.0f);
+  generated_grads.insert(loss_grad_name);
+
+  size_t rename_cnt = 0;
+  for (auto &op : grad_ops_) {
+    framework::VariableNameMap inputs;
+    for (auto &pair : op.inputs) {
+      auto &names = inputs[pair.first];
+      for (auto &var : pair.second) {
+        names.emplace_back(name_of(var));
+        // BasicEngine::CheckBackwardInputs fills the grads which are not
+        // generated with 0
+        if (var.is_grad && names.back() != framework::kEmptyVarName &&
+            generated_grads.insert(names.back()).second) {
+          append_fill_constant(names.back(), 0.0f);
+        }
+      }
+    }
+
+    // The grad generated by several grad ops is summed up, like what
+    // GradientAccumulator does.
+    std::vector<std::pair<std::string, std::string>> renamed_grads;
+    framework::VariableNameMap outputs;
+    for (auto &pair : op.outputs) {
+      auto &names = outputs[pair.first];
+      for (auto &var : pair.second) {
+        auto name = name_of(var);
+        if (var.is_grad && name != framework::kEmptyVarName &&
+            !generated_grads.insert(name).second) {
+          auto new_name = name + "@RENAME@" + std::to_string(rename_cnt++);
+          auto *new_var_desc = block->Var(new_name);
+          *new_var_desc = *block->FindVar(name);
+          new_var_desc->SetName(new_name);
+          renamed_grads.emplace_back(name, new_name);
+          name = new_name;
+        }
+        names.emplace_back(std::move(name));
+      }
+    }
+
+    auto *op_desc = block->AppendOp();
+    op_desc->SetType(op.type);
+    op_desc->SetAttrMap(op.attrs);
+    for (auto &pair : inputs) {
+      op_desc->SetInput(pair.first, std::move(pair.second));
+    }
+    for (auto &pair : outputs) {
+      op_desc->SetOutput(pair.first, std::move(pair.second));
+    }
+
+    for (auto &pair : renamed_grads) {
+      auto *sum_op_desc = block->AppendOp();
+      sum_op_desc->SetType("sum");
+      sum_op_desc->SetInput("X", {pair.first, pair.second});
+      sum_op_desc->SetOutput("Out", {pair.first});
+    }
+  }
+}
+
 void ProgramDescTracer::InsertVarIfNotExist(
     const std::shared_ptr<VarBase> &new_var, bool is_input) {
   PADDLE_ENFORCE_NOT_NULL(new_var, platform::errors::InvalidArgument(
@@ -210,6 +393,8 @@ void ProgramDescTracer::InsertVarIfNotExist(
 
   auto new_var_desc = new framework::VarDesc("");
   vars_[new_var].reset(new_var_desc);
+  traced_var_wrappers_.emplace_back(new_var, new_var->SharedVar());
+  traced_names_.emplace(new_var->Name(), new_var);
 
   if (new_var->Persistable() || is_input) {
     new_var_desc->SetName(new_var->Name());
@@ -246,6 +431,11 @@ void ProgramDescTracer::Reset() {
   ops_.clear();
   vars_.clear();
   non_exist_input_vars_.clear();
+  grad_ops_.clear();
+  loss_.reset();
+  traced_var_wrappers_.clear();
+  traced_names_.clear();
+  var_wrappers_.clear();
 }
 
 }  // namespace jit
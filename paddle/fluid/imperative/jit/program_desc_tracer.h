@@ -14,11 +14,13 @@
 
 #pragma once
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
 #include <tuple>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -45,6 +47,20 @@ using VarDescMetaMap =
 using VarBaseSet = std::set<std::shared_ptr<VarBase>,
                             std::owner_less<std::shared_ptr<VarBase>>>;
 
+// A var of a grad op recorded from BasicEngine, which is a traced forward var
+// or the grad var of it. An empty var has no forward var.
+struct GradOpVar {
+  std::weak_ptr<VarBase> var;
+  bool is_grad;
+};
+
+struct GradOpDescMeta {
+  std::string type;
+  std::map<std::string, std::vector<GradOpVar>> inputs;
+  std::map<std::string, std::vector<GradOpVar>> outputs;
+  framework::AttributeMap attrs;
+};
+
 using TracedProgramTuple =
     std::tuple<std::unique_ptr<framework::ProgramDesc> /*program*/,
                std::vector<std::string> /*feed_var_names*/,
@@ -61,6 +77,17 @@ class ProgramDescTracer {
                 const NameVarBaseMap &outputs,
                 const framework::AttributeMap &attrs);
 
+  // Record the loss whose grad var BasicEngine fills with 1 before running
+  // the grad ops.
+  void SetLossGrad(const std::shared_ptr<VariableWrapper> &loss_grad);
+
+  // Record a grad op run by BasicEngine. The vars of the grad op must be the
+  // vars of the traced forward ops or their grad vars.
+  void InsertGradOp(const std::string &type,
+                    const NameVarMap<VariableWrapper> &inputs,
+                    const NameVarMap<VariableWrapper> &outputs,
+                    const framework::AttributeMap &attrs);
+
   TracedProgramTuple CreateProgramDesc(
       const std::vector<std::shared_ptr<VarBase>> &feed_vars,
       const std::string &feed_prefix,
@@ -73,10 +100,29 @@ class ProgramDescTracer {
   void InsertVarIfNotExist(const std::shared_ptr<VarBase> &new_var,
                            bool is_input);
 
+  GradOpVar FindGradOpVar(const std::shared_ptr<VariableWrapper> &var);
+
+  void AppendGradOps(framework::BlockDesc *block,
+                     const std::function<std::string(const GradOpVar &)>
+                         &name_of) const;
+
  private:
   std::vector<std::unique_ptr<OpDescMeta>> ops_;
   VarDescMetaMap vars_;
   VarBaseSet non_exist_input_vars_;
+
+  std::vector<GradOpDescMeta> grad_ops_;
+  std::weak_ptr<VarBase> loss_;
+  // The VariableWrappers of the traced vars, which outlive the VarBases when
+  // they are held by the grad ops
+  std::vector<std::pair<std::weak_ptr<VarBase>, std::weak_ptr<VariableWrapper>>>
+      traced_var_wrappers_;
+  std::unordered_multimap<std::string, std::weak_ptr<VarBase>> traced_names_;
+  // The traced vars and their grad vars, keyed by their VariableWrapper. It
+  // is rebuilt when a var of a grad op is not found.
+  std::unordered_map<const VariableWrapper *,
+                     std::pair<std::weak_ptr<VariableWrapper>, GradOpVar>>
+      var_wrappers_;
 };
 
 }  // namespace jit
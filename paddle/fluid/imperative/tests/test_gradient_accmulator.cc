@@ -12,8 +12,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <memory>
+#include <random>
 #include <type_traits>
+#include <unordered_set>
 #include <vector>
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/variable.h"
@@ -365,5 +370,265 @@ TEST(test_gradient_accumulator, test_unchange_input) {
   }
 }
 
+static framework::Variable ConstantTensor(const framework::DDim& dims,
+                                          float value) {
+  framework::Variable ret;
+  auto* tensor = ret.GetMutable<framework::LoDTensor>();
+  tensor->Resize(dims);
+  auto* data = tensor->mutable_data<float>(platform::CPUPlace());
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = value;
+  }
+  return ret;
+}
+
+TEST(test_gradient_accumulator, test_sorted_sum_release_early) {
+  framework::DDim dim{10, 20};
+  const size_t kPartialGradNum = 8;
+
+  auto g_var = std::make_shared<VariableWrapper>("g_var");
+  g_var->SetOverridedStopGradient(false);
+  SortedGradientAccumulator accumulator(g_var.get());
+  for (size_t i = 0; i < kPartialGradNum; ++i) {
+    accumulator.IncreaseRefCnt();
+    accumulator.AddTraceId(i);
+  }
+
+  // Partial grads arrive in descending order of trace ids, which is the
+  // order of a weight-shared model, each one should be released right
+  // after it is summed.
+  for (size_t i = 0; i < kPartialGradNum; ++i) {
+    auto partial_grad = std::make_shared<VariableWrapper>("partial_grad");
+    CopyVar(ConstantTensor(dim, 1.0f), partial_grad->MutableVar());
+    std::weak_ptr<VariableWrapper> weak_partial_grad = partial_grad;
+    accumulator.SumGrad(std::move(partial_grad), kPartialGradNum - 1 - i,
+                        false);
+    ASSERT_TRUE(weak_partial_grad.expired());
+    ASSERT_EQ(accumulator.CurCnt(), i + 1);
+  }
+  ASSERT_TRUE(accumulator.SumGradCompleted());
+  ASSERT_TRUE(IsEqualVar(g_var->Var(),
+                         ConstantTensor(dim, static_cast<float>(
+                                                 kPartialGradNum))));
+
+  // Partial grads arrive out of order, only the ones which can not be summed
+  // yet are held.
+  auto g_var2 = std::make_shared<VariableWrapper>("g_var2");
+  g_var2->SetOverridedStopGradient(false);
+  SortedGradientAccumulator accumulator2(g_var2.get());
+  for (size_t i = 0; i < 3; ++i) {
+    accumulator2.IncreaseRefCnt();
+    accumulator2.AddTraceId(i);
+  }
+  std::vector<size_t> trace_ids = {1, 2, 0};
+  for (size_t i = 0; i < trace_ids.size(); ++i) {
+    auto partial_grad = std::make_shared<VariableWrapper>("partial_grad");
+    CopyVar(ConstantTensor(dim, 1.0f), partial_grad->MutableVar());
+    accumulator2.SumGrad(std::move(partial_grad), trace_ids[i], false);
+  }
+  ASSERT_EQ(accumulator2.CurCnt(), 3UL);
+  ASSERT_TRUE(IsEqualVar(g_var2->Var(), ConstantTensor(dim, 3.0f)));
+}
+
+TEST(test_gradient_accumulator, test_accumulate_in_place) {
+  framework::DDim dim{10, 20};
+  for (auto sort_gradient : {false, true}) {
+    // The leaf grad has been calculated by previous graph
+    auto leaf_grad = std::make_shared<VariableWrapper>("leaf_grad");
+    leaf_grad->SetOverridedStopGradient(false);
+    CopyVar(ConstantTensor(dim, 2.0f), leaf_grad->MutableVar());
+    const void* holder_ptr =
+        leaf_grad->Var().Get<framework::LoDTensor>().data<float>();
+
+    // The sorted accumulator keeps summing into an inner var, so that the
+    // summation order does not change
+    auto accumulator = CreateAccumulator(leaf_grad, sort_gradient);
+    ASSERT_EQ(accumulator->AccumulateInPlace(), !sort_gradient);
+    ASSERT_EQ(accumulator->HasInnerVar(), sort_gradient);
+    for (size_t i = 0; i < 2; ++i) {
+      accumulator->IncreaseRefCnt();
+      accumulator->AddTraceId(i);
+    }
+
+    for (size_t i = 0; i < 2; ++i) {
+      auto partial_grad = std::make_shared<VariableWrapper>("partial_grad");
+      CopyVar(ConstantTensor(dim, 1.0f), partial_grad->MutableVar());
+      accumulator->SumGrad(std::move(partial_grad), 1 - i, false);
+    }
+    ASSERT_TRUE(accumulator->SumGradCompleted());
+    accumulator->AccumulateGrad();
+
+    ASSERT_TRUE(IsEqualVar(leaf_grad->Var(), ConstantTensor(dim, 4.0f)));
+    // No new buffer is allocated for the leaf grad
+    ASSERT_EQ(leaf_grad->Var().Get<framework::LoDTensor>().data<float>(),
+              holder_ptr);
+  }
+}
+
+static framework::Variable RandomTensor(const framework::DDim& dims,
+                                        std::mt19937* engine) {
+  // Values of very different magnitudes, so that the rounding depends on
+  // the summation order
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::uniform_int_distribution<int> exp_dist(-20, 20);
+  framework::Variable ret;
+  auto* tensor = ret.GetMutable<framework::LoDTensor>();
+  tensor->Resize(dims);
+  auto* data = tensor->mutable_data<float>(platform::CPUPlace());
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = std::ldexp(dist(*engine), exp_dist(*engine));
+  }
+  return ret;
+}
+
+TEST(test_gradient_accumulator, test_sorted_sum_order_of_leaf_grad) {
+  framework::DDim dim{16, 32};
+  const size_t kPartialGradNum = 4;
+  std::mt19937 engine(2020);
+  auto leaf = RandomTensor(dim, &engine);
+  std::vector<framework::Variable> partials;
+  for (size_t i = 0; i < kPartialGradNum; ++i) {
+    partials.emplace_back(RandomTensor(dim, &engine));
+  }
+
+  // The result of summing the partial grads in descending order of trace
+  // ids first, and then adding the sum to the leaf grad of previous graph
+  auto expected = ConstantTensor(dim, 0.0f);
+  auto* expected_data =
+      expected.GetMutable<framework::LoDTensor>()->mutable_data<float>(
+          platform::CPUPlace());
+  const auto& leaf_tensor = leaf.Get<framework::LoDTensor>();
+  for (int64_t j = 0; j < leaf_tensor.numel(); ++j) {
+    float sum = partials[kPartialGradNum - 1].Get<framework::LoDTensor>()
+                    .data<float>()[j];
+    for (size_t i = kPartialGradNum - 1; i-- > 0;) {
+      sum += partials[i].Get<framework::LoDTensor>().data<float>()[j];
+    }
+    expected_data[j] = leaf_tensor.data<float>()[j] + sum;
+  }
+
+  // Partial grads arriving in and out of order of trace ids, summed in order
+  // as they arrive or held until the last one arrives
+  std::vector<std::vector<size_t>> arrivals = {{3, 2, 1, 0}, {1, 3, 0, 2}};
+  for (auto& arrival : arrivals) {
+    for (auto with_trace_ids : {false, true}) {
+      auto leaf_grad = std::make_shared<VariableWrapper>("leaf_grad");
+      leaf_grad->SetOverridedStopGradient(false);
+      CopyVar(leaf, leaf_grad->MutableVar());
+
+      auto accumulator = CreateAccumulator(leaf_grad, true);
+      for (size_t i = 0; i < kPartialGradNum; ++i) {
+        accumulator->IncreaseRefCnt();
+        if (with_trace_ids) {
+          accumulator->AddTraceId(i);
+        }
+      }
+      for (auto trace_id : arrival) {
+        auto partial_grad = std::make_shared<VariableWrapper>("partial_grad");
+        CopyVar(partials[trace_id], partial_grad->MutableVar());
+        accumulator->SumGrad(std::move(partial_grad), trace_id, false);
+      }
+      ASSERT_TRUE(accumulator->SumGradCompleted());
+      accumulator->AccumulateGrad();
+
+      const auto& result = leaf_grad->Var().Get<framework::LoDTensor>();
+      ASSERT_EQ(std::memcmp(result.data<float>(), expected_data,
+                            result.numel() * sizeof(float)),
+                0);
+    }
+  }
+}
+
+// The bytes of the distinct buffers held by the grad var, the inner var of
+// the accumulator and the partial grads still alive.
+static size_t HeldBytes(
+    const VariableWrapper& grad, GradientAccumulator* accumulator,
+    const std::vector<std::weak_ptr<VariableWrapper>>& partial_grads) {
+  std::vector<std::shared_ptr<VariableWrapper>> alive_grads;
+  std::vector<const VariableWrapper*> vars = {&grad};
+  if (accumulator->HasInnerVar()) {
+    vars.push_back(accumulator->InnerVar().get());
+  }
+  for (auto& weak_grad : partial_grads) {
+    if (auto partial_grad = weak_grad.lock()) {
+      vars.push_back(partial_grad.get());
+      alive_grads.emplace_back(std::move(partial_grad));
+    }
+  }
+
+  std::unordered_set<const void*> holders;
+  size_t bytes = 0;
+  for (auto* var : vars) {
+    if (!var->Var().IsType<framework::LoDTensor>()) {
+      continue;
+    }
+    auto& holder = var->Var().Get<framework::LoDTensor>().Holder();
+    if (holder && holders.insert(holder.get()).second) {
+      bytes += holder->size();
+    }
+  }
+  return bytes;
+}
+
+// A weight shared by many ops, such as the unrolled steps of an RNN, gets a
+// partial grad from each of them, in descending order of trace ids as
+// BasicEngine runs the grad ops. Log the peak bytes held for the grad of the
+// weight over two backward passes, the second of which accumulates into the
+// grad of the first.
+TEST(test_gradient_accumulator, test_shared_weight_peak_memory) {
+  framework::DDim dim{512, 512};
+  const size_t kShareNum = 32;
+  const size_t weight_bytes = framework::product(dim) * sizeof(float);
+  enum { kEager, kSortedHoldAll, kSortedInOrder, kModeNum };
+  const char* mode_names[] = {"eager", "sorted, holding all partial grads",
+                              "sorted in order of trace ids"};
+
+  std::vector<size_t> peaks;
+  for (int mode = kEager; mode < kModeNum; ++mode) {
+    auto weight_grad = std::make_shared<VariableWrapper>("weight@GRAD");
+    weight_grad->SetOverridedStopGradient(false);
+    size_t peak = 0;
+    for (int pass = 0; pass < 2; ++pass) {
+      auto accumulator = CreateAccumulator(weight_grad, mode != kEager);
+      for (size_t i = 0; i < kShareNum; ++i) {
+        accumulator->IncreaseRefCnt();
+        // Without the trace ids, the sorted accumulator holds all the
+        // partial grads until the last one arrives.
+        if (mode == kSortedInOrder) {
+          accumulator->AddTraceId(i);
+        }
+      }
+
+      std::vector<std::weak_ptr<VariableWrapper>> partial_grads;
+      for (size_t i = 0; i < kShareNum; ++i) {
+        auto partial_grad = std::make_shared<VariableWrapper>("partial_grad");
+        CopyVar(ConstantTensor(dim, 1.0f), partial_grad->MutableVar());
+        partial_grads.emplace_back(partial_grad);
+        peak = std::max(
+            peak, HeldBytes(*weight_grad, accumulator.get(), partial_grads));
+        accumulator->SumGrad(std::move(partial_grad), kShareNum - 1 - i,
+                             false);
+        peak = std::max(
+            peak, HeldBytes(*weight_grad, accumulator.get(), partial_grads));
+      }
+      ASSERT_TRUE(accumulator->SumGradCompleted());
+      accumulator->AccumulateGrad();
+    }
+    ASSERT_TRUE(IsEqualVar(weight_grad->Var(),
+                           ConstantTensor(dim, 2.0f * kShareNum)));
+    LOG(INFO) << "Weight of " << weight_bytes << " bytes shared by "
+              << kShareNum << " ops, " << mode_names[mode]
+              << ": peak of " << peak << " bytes, "
+              << static_cast<double>(peak) / weight_bytes
+              << " times of the weight";
+    peaks.push_back(peak);
+  }
+
+  // The grad of the weight, the inner var of the second pass and the partial
+  // grad being summed.
+  ASSERT_EQ(peaks[kSortedInOrder], 3 * weight_bytes);
+  ASSERT_EQ(peaks[kSortedHoldAll], (kShareNum + 1) * weight_bytes);
+}
+
 }  // namespace imperative
 }  // namespace paddle
@@ -0,0 +1,355 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>  // NOLINT
+#include <memory>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/ir/fuse_pass_base.h"
+#include "paddle/fluid/framework/ir/pass.h"
+#include "paddle/fluid/imperative/basic_engine.h"
+#include "paddle/fluid/imperative/jit/program_desc_replayer.h"
+#include "paddle/fluid/imperative/tracer.h"
+
+namespace imperative = paddle::imperative;
+namespace platform = paddle::platform;
+namespace framework = paddle::framework;
+
+namespace paddle {
+namespace imperative {
+
+using vb_vector = std::vector<std::shared_ptr<imperative::VarBase>>;
+
+using var_pair = std::pair<std::string, vb_vector>;
+
+static std::shared_ptr<VarBase> CreateVar(const std::string& name,
+                                          const std::vector<int64_t>& dims,
+                                          float value) {
+  std::shared_ptr<VarBase> var(new VarBase(true, name));
+  auto* tensor = var->MutableVar()->GetMutable<framework::LoDTensor>();
+  tensor->Resize(framework::make_ddim(dims));
+  auto* data = tensor->mutable_data<float>(platform::CPUPlace());
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = value;
+  }
+  return var;
+}
+
+static void TraceMulAdd(Tracer* tracer, const std::shared_ptr<VarBase>& x,
+                        const std::shared_ptr<VarBase>& w,
+                        const std::shared_ptr<VarBase>& b,
+                        const std::shared_ptr<VarBase>& out) {
+  platform::CPUPlace place;
+  std::shared_ptr<VarBase> mul_out(new VarBase(true, "mul_out"));
+  framework::AttributeMap attrs;
+  attrs["use_mkldnn"] = false;
+
+  NameVarBaseMap mul_ins = {var_pair("X", vb_vector(1, x)),
+                            var_pair("Y", vb_vector(1, w))};
+  NameVarBaseMap mul_outs = {var_pair("Out", vb_vector(1, mul_out))};
+  tracer->TraceOp("mul", mul_ins, mul_outs, attrs, place, false);
+
+  NameVarBaseMap add_ins = {var_pair("X", vb_vector(1, mul_out)),
+                            var_pair("Y", vb_vector(1, b))};
+  NameVarBaseMap add_outs = {var_pair("Out", vb_vector(1, out))};
+  tracer->TraceOp("elementwise_add", add_ins, add_outs, attrs, place, false);
+}
+
+TEST(test_program_desc_replayer, test_replay_and_fallback) {
+  Tracer tracer;
+  tracer.SetEnableProgramDescTracing(true);
+
+  auto x = CreateVar("x", {2, 5}, 2.0f);
+  auto w = CreateVar("w", {5, 2}, 2.0f);
+  auto b = CreateVar("b", {2}, 1.0f);
+  w->SetPersistable(true);
+  b->SetPersistable(true);
+  std::shared_ptr<VarBase> out(new VarBase(true, "out"));
+  TraceMulAdd(&tracer, x, w, b, out);
+
+  auto traced = tracer.GetProgramDescTracer()->CreateProgramDesc(
+      {x}, "feed_", {out}, "fetch_", "t_");
+  tracer.GetProgramDescTracer()->Reset();
+  tracer.SetEnableProgramDescTracing(false);
+
+  jit::ProgramDescReplayer replayer(*std::get<0>(traced), std::get<1>(traced),
+                                    std::get<2>(traced), std::get<3>(traced),
+                                    platform::CPUPlace());
+
+  auto new_x = CreateVar("new_x", {2, 5}, 1.0f);
+  vb_vector fetch_vars;
+  ASSERT_TRUE(replayer.Run({new_x}, &fetch_vars));
+  ASSERT_EQ(fetch_vars.size(), 1UL);
+  const auto& fetch_tensor = fetch_vars[0]->Var().Get<framework::LoDTensor>();
+  ASSERT_EQ(fetch_tensor.numel(), 4);
+  for (int64_t i = 0; i < fetch_tensor.numel(); ++i) {
+    ASSERT_EQ(fetch_tensor.data<float>()[i], 11.0f);
+  }
+
+  // The result of the previous run should not be overwritten
+  auto another_x = CreateVar("another_x", {2, 5}, 3.0f);
+  vb_vector another_fetch_vars;
+  ASSERT_TRUE(replayer.Run({another_x}, &another_fetch_vars));
+  ASSERT_EQ(fetch_tensor.data<float>()[0], 11.0f);
+  ASSERT_EQ(
+      another_fetch_vars[0]->Var().Get<framework::LoDTensor>().data<float>()[0],
+      31.0f);
+
+  // Changed input shape should fall back to eager mode
+  auto bigger_x = CreateVar("bigger_x", {3, 5}, 1.0f);
+  vb_vector unused_fetch_vars;
+  ASSERT_FALSE(replayer.Run({bigger_x}, &unused_fetch_vars));
+  ASSERT_EQ(replayer.ReplayCount(), 2UL);
+  ASSERT_EQ(replayer.FallbackCount(), 1UL);
+}
+
+// Doubles the weights of mul ops in the param scope, like the fuse passes
+// which fold the following ops into the weights.
+class ScaleMulWeightPass : public framework::ir::Pass {
+ protected:
+  void ApplyImpl(framework::ir::Graph* graph) const override {
+    auto& scope = graph->Get<framework::Scope>(framework::ir::kParamScopeAttr);
+    for (auto* node : graph->Nodes()) {
+      if (!node->IsOp() || node->Op()->Type() != "mul") continue;
+      auto* weight = scope.FindVar(node->Op()->Input("Y")[0])
+                         ->GetMutable<framework::LoDTensor>();
+      auto* data = weight->data<float>();
+      for (int64_t i = 0; i < weight->numel(); ++i) {
+        data[i] *= 2.0f;
+      }
+    }
+  }
+};
+
+TEST(test_program_desc_replayer, test_replay_with_weight_rewriting_pass) {
+  Tracer tracer;
+  tracer.SetEnableProgramDescTracing(true);
+
+  auto x = CreateVar("x", {2, 5}, 2.0f);
+  auto w = CreateVar("w", {5, 2}, 2.0f);
+  auto b = CreateVar("b", {2}, 1.0f);
+  w->SetPersistable(true);
+  b->SetPersistable(true);
+  std::shared_ptr<VarBase> out(new VarBase(true, "out"));
+  TraceMulAdd(&tracer, x, w, b, out);
+
+  auto traced = tracer.GetProgramDescTracer()->CreateProgramDesc(
+      {x}, "feed_", {out}, "fetch_", "t_");
+  tracer.GetProgramDescTracer()->Reset();
+  tracer.SetEnableProgramDescTracing(false);
+
+  jit::ProgramDescReplayer replayer(
+      *std::get<0>(traced), std::get<1>(traced), std::get<2>(traced),
+      std::get<3>(traced), platform::CPUPlace(),
+      {"test_replayer_scale_mul_weight_pass"});
+  ASSERT_EQ(replayer.RewrittenParamCount(), 1UL);
+
+  // The pass rewrites a copy, not the weight of the dygraph model
+  auto& w_tensor = w->Var().Get<framework::LoDTensor>();
+  for (int64_t i = 0; i < w_tensor.numel(); ++i) {
+    ASSERT_EQ(w_tensor.data<float>()[i], 2.0f);
+  }
+
+  auto new_x = CreateVar("new_x", {2, 5}, 1.0f);
+  vb_vector fetch_vars;
+  ASSERT_TRUE(replayer.Run({new_x}, &fetch_vars));
+  ASSERT_EQ(
+      fetch_vars[0]->Var().Get<framework::LoDTensor>().data<float>()[0],
+      21.0f);
+
+  // The rewritten weight is kept across runs, while the parameters which are
+  // not rewritten are still shared with the dygraph model.
+  b->MutableVar()->GetMutable<framework::LoDTensor>()->data<float>()[0] = 2.0f;
+  ASSERT_TRUE(replayer.Run({new_x}, &fetch_vars));
+  auto& fetch_tensor = fetch_vars[0]->Var().Get<framework::LoDTensor>();
+  ASSERT_EQ(fetch_tensor.data<float>()[0], 22.0f);
+  ASSERT_EQ(fetch_tensor.data<float>()[1], 21.0f);
+}
+
+// h = x * w1 + b1, y = relu(h) + h, loss = mean(y * w2 + b2), where the grad
+// of h is summed up from two grad ops.
+static std::shared_ptr<VarBase> TraceMLP(
+    Tracer* tracer, const std::shared_ptr<VarBase>& x,
+    const std::vector<std::shared_ptr<VarBase>>& params) {
+  platform::CPUPlace place;
+  framework::AttributeMap attrs;
+  attrs["use_mkldnn"] = false;
+  auto trace = [&](const std::string& type, const NameVarBaseMap& ins) {
+    std::shared_ptr<VarBase> out(
+        new VarBase(true, tracer->GenerateUniqueName(type + "_out")));
+    NameVarBaseMap outs = {var_pair("Out", vb_vector(1, out))};
+    tracer->TraceOp(type, ins, outs, attrs, place, true);
+    return out;
+  };
+
+  auto h = trace("mul", {var_pair("X", {x}), var_pair("Y", {params[0]})});
+  h = trace("elementwise_add",
+            {var_pair("X", {h}), var_pair("Y", {params[1]})});
+  auto y = trace("relu", {var_pair("X", {h})});
+  y = trace("elementwise_add", {var_pair("X", {y}), var_pair("Y", {h})});
+  auto z = trace("mul", {var_pair("X", {y}), var_pair("Y", {params[2]})});
+  z = trace("elementwise_add",
+            {var_pair("X", {z}), var_pair("Y", {params[3]})});
+  return trace("mean", {var_pair("X", {z})});
+}
+
+static std::vector<std::shared_ptr<VarBase>> CreateMLPParams(
+    int64_t in_dim, int64_t hidden_dim, int64_t out_dim) {
+  std::vector<std::shared_ptr<VarBase>> params = {
+      CreateVar("w1", {in_dim, hidden_dim}, 0.01f),
+      CreateVar("b1", {hidden_dim}, -0.02f),
+      CreateVar("w2", {hidden_dim, out_dim}, 0.03f),
+      CreateVar("b2", {out_dim}, 0.04f)};
+  for (auto& param : params) {
+    param->SetPersistable(true);
+    param->SetOverridedStopGradient(false);
+    // Vary the values in each row of the parameter
+    auto* tensor = param->MutableVar()->GetMutable<framework::LoDTensor>();
+    auto* data = tensor->data<float>();
+    for (int64_t i = 0; i < tensor->numel(); ++i) {
+      data[i] *= static_cast<float>(i % 7) - 3.0f;
+    }
+  }
+  return params;
+}
+
+static std::vector<float> GradOf(const std::shared_ptr<VarBase>& var) {
+  auto& tensor = var->GradVar().Get<framework::LoDTensor>();
+  return std::vector<float>(tensor.data<float>(),
+                            tensor.data<float>() + tensor.numel());
+}
+
+static void RunBackward(const std::shared_ptr<VarBase>& loss) {
+  BasicEngine engine;
+  engine.Init(loss.get());
+  engine.Execute();
+}
+
+static std::unique_ptr<jit::ProgramDescReplayer> CaptureMLP(
+    const std::shared_ptr<Tracer>& tracer, const std::shared_ptr<VarBase>& x,
+    const std::vector<std::shared_ptr<VarBase>>& params,
+    bool enable_memory_reuse, std::shared_ptr<VarBase>* loss) {
+  tracer->SetEnableProgramDescTracing(true);
+  *loss = TraceMLP(tracer.get(), x, params);
+  RunBackward(*loss);
+  auto traced = tracer->GetProgramDescTracer()->CreateProgramDesc(
+      {x}, "feed_", {*loss}, "fetch_", "t_");
+  tracer->GetProgramDescTracer()->Reset();
+  tracer->SetEnableProgramDescTracing(false);
+  return std::unique_ptr<jit::ProgramDescReplayer>(
+      new jit::ProgramDescReplayer(*std::get<0>(traced), std::get<1>(traced),
+                                   std::get<2>(traced), std::get<3>(traced),
+                                   platform::CPUPlace(), {},
+                                   enable_memory_reuse));
+}
+
+TEST(test_program_desc_replayer, test_replay_backward) {
+  std::shared_ptr<Tracer> tracer(new Tracer());
+  SetCurrentTracer(tracer);
+
+  for (bool enable_memory_reuse : {false, true}) {
+    auto params = CreateMLPParams(6, 8, 3);
+    auto x = CreateVar("x", {4, 6}, 0.5f);
+    std::shared_ptr<VarBase> loss;
+    auto replayer =
+        CaptureMLP(tracer, x, params, enable_memory_reuse, &loss);
+    float eager_loss = loss->Var().Get<framework::LoDTensor>().data<float>()[0];
+    std::vector<std::vector<float>> eager_grads;
+    for (auto& param : params) {
+      eager_grads.emplace_back(GradOf(param));
+      param->ClearGradient();
+    }
+
+    // The grad of the loss, the grads summed up, and the grads of all the
+    // parameters are in the program.
+    std::set<std::string> op_types;
+    for (auto* op : replayer->Program().Block(0).AllOps()) {
+      op_types.insert(op->Type());
+    }
+    ASSERT_EQ(op_types.count("fill_constant"), 1UL);
+    ASSERT_EQ(op_types.count("sum"), 1UL);
+    ASSERT_EQ(op_types.count("mul_grad"), 1UL);
+    ASSERT_EQ(op_types.count("relu_grad"), 1UL);
+    ASSERT_EQ(replayer->ReusedVarCount() > 0, enable_memory_reuse);
+
+    // Each run accumulates the grads of parameters like eager mode
+    for (int step = 1; step <= 2; ++step) {
+      vb_vector fetch_vars;
+      ASSERT_TRUE(replayer->Run({x}, &fetch_vars));
+      ASSERT_NEAR(
+          fetch_vars[0]->Var().Get<framework::LoDTensor>().data<float>()[0],
+          eager_loss, 1e-6);
+      for (size_t i = 0; i < params.size(); ++i) {
+        auto grad = GradOf(params[i]);
+        ASSERT_EQ(grad.size(), eager_grads[i].size());
+        for (size_t j = 0; j < grad.size(); ++j) {
+          ASSERT_NEAR(grad[j], step * eager_grads[i][j], 1e-5)
+              << params[i]->Name() << " at step " << step;
+        }
+      }
+    }
+  }
+  SetCurrentTracer(nullptr);
+}
+
+TEST(test_program_desc_replayer, test_replay_step_time) {
+  std::shared_ptr<Tracer> tracer(new Tracer());
+  SetCurrentTracer(tracer);
+
+  auto params = CreateMLPParams(256, 256, 10);
+  auto x = CreateVar("x", {32, 256}, 0.5f);
+  std::shared_ptr<VarBase> loss;
+  auto replayer = CaptureMLP(tracer, x, params, true, &loss);
+
+  const int kRepeat = 200;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kRepeat; ++i) {
+    RunBackward(TraceMLP(tracer.get(), x, params));
+  }
+  auto eager_time = std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kRepeat; ++i) {
+    vb_vector fetch_vars;
+    ASSERT_TRUE(replayer->Run({x}, &fetch_vars));
+  }
+  auto replay_time = std::chrono::duration<double, std::micro>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+  LOG(INFO) << "Average step time (forward and backward) of eager mode: "
+            << eager_time / kRepeat
+            << " us, replay mode: " << replay_time / kRepeat << " us, "
+            << replayer->ReusedVarCount() << " vars reuse memory";
+  SetCurrentTracer(nullptr);
+}
+
+}  // namespace imperative
+}  // namespace paddle
+
+USE_OP(mul);
+USE_OP(elementwise_add);
+USE_OP(relu);
+USE_OP(mean);
+USE_OP(fill_constant);
+USE_OP(sum);
+
+REGISTER_PASS(test_replayer_scale_mul_weight_pass,
+              paddle::imperative::ScaleMulWeightPass);
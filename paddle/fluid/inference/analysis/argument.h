@@ -187,6 +187,7 @@ struct Argument {
   // Passed from config.
   DECL_ARGUMENT_FIELD(use_gpu, UseGPU, bool);
   DECL_ARGUMENT_FIELD(use_fc_padding, UseFcPadding, bool);
+  DECL_ARGUMENT_FIELD(use_cpu_int8_gemm, UseCpuInt8Gemm, bool);
   DECL_ARGUMENT_FIELD(gpu_device_id, GPUDeviceId, int);
 
   // Usually use for trt dynamic shape.
@@ -232,6 +233,11 @@ struct Argument {
 
   DECL_ARGUMENT_FIELD(fusion_statis, FusionStatis, fusion_statis_t);
 
+  // The float embedding tables replaced with the quantized copies by the
+  // embedding_quant_pass, which the optimized program does not use.
+  DECL_ARGUMENT_FIELD(quantized_embedding_tables, QuantizedEmbeddingTables,
+                      std::vector<std::string>);
+
   // Only used in paddle-lite subgraph.
   DECL_ARGUMENT_FIELD(cpu_math_library_num_threads, CpuMathLibraryNumThreads,
                       int);
@@ -0,0 +1,314 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/analysis/passes/embedding_quant_pass.h"
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "paddle/fluid/framework/ir/graph_helper.h"
+#include "paddle/fluid/framework/ir/graph_pattern_detector.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/op_proto_maker.h"
+#include "paddle/fluid/operators/math/embedding_quant.h"
+
+namespace paddle {
+namespace inference {
+namespace analysis {
+
+namespace {
+using framework::ir::Node;
+
+struct TableUser {
+  Node* op{nullptr};
+  // The sequence_pool after lookup_table(_v2) to be fused with it.
+  Node* pool_op{nullptr};
+};
+
+static Node* GetVar(const std::vector<Node*>& nodes,
+                    const framework::VariableNameMap& args,
+                    const std::string& argument) {
+  auto it = args.find(argument);
+  if (it == args.end() || it->second.size() != 1) return nullptr;
+  for (auto* var : nodes) {
+    if (var->IsVar() && var->Name() == it->second[0]) return var;
+  }
+  return nullptr;
+}
+
+static Node* GetInputVar(Node* op, const std::string& argument) {
+  return GetVar(op->inputs, op->Op()->Inputs(), argument);
+}
+
+static Node* GetOutputVar(Node* op, const std::string& argument) {
+  return GetVar(op->outputs, op->Op()->Outputs(), argument);
+}
+
+template <typename T>
+static T GetAttrOr(Node* op, const std::string& name, const T& value) {
+  auto* desc = op->Op();
+  return desc->HasAttr(name) ? BOOST_GET_CONST(T, desc->GetAttr(name)) : value;
+}
+
+// Return the sequence_pool(SUM) which is the only user of the output of
+// lookup_op, or nullptr.
+static Node* GetSumPool(Node* lookup_op) {
+  Node* out = GetOutputVar(lookup_op, "Out");
+  if (!out || !out->Var() || out->Var()->Persistable() ||
+      out->outputs.size() != 1) {
+    return nullptr;
+  }
+  Node* pool_op = out->outputs[0];
+  if (!pool_op->IsOp() || pool_op->Op()->Type() != "sequence_pool" ||
+      GetAttrOr<std::string>(pool_op, "pooltype", "") != "SUM" ||
+      GetInputVar(pool_op, "X") != out || !GetOutputVar(pool_op, "Out")) {
+    return nullptr;
+  }
+  // MaxIndex is not computed with the SUM pooltype.
+  for (auto* var : pool_op->outputs) {
+    if (var != GetOutputVar(pool_op, "Out") && !var->outputs.empty()) {
+      return nullptr;
+    }
+  }
+  return pool_op;
+}
+
+static std::vector<int64_t> IdsShape(Node* op) {
+  Node* ids = GetInputVar(op, "Ids");
+  if (!ids || !ids->Var()) return {};
+  return ids->Var()->GetShape();
+}
+
+// Whether op reads the table only by its input W, and can be replaced with an
+// operator reading the quantized table.
+static bool MatchTableUser(Node* op, const std::string& table,
+                           TableUser* user) {
+  user->op = op;
+  Node* w = GetInputVar(op, "W");
+  if (!w || w->Name() != table) return false;
+  for (auto& input : op->Op()->Inputs()) {
+    if (input.first == "W") continue;
+    for (auto& name : input.second) {
+      if (name == table) return false;
+    }
+  }
+
+  const std::string& type = op->Op()->Type();
+  if (type == "lookup_table" || type == "lookup_table_v2") {
+    // The distributed lookup prefetches the rows from the parameter servers.
+    if (GetAttrOr<bool>(op, "is_distributed", false) ||
+        GetAttrOr<bool>(op, "remote_prefetch", false)) {
+      return false;
+    }
+    user->pool_op = GetSumPool(op);
+    if (type == "lookup_table") {
+      // Otherwise, replaced with lookup_table_dequant.
+      return true;
+    }
+    // The output of lookup_table_v2 has one more dim than the one of
+    // sequence_pool, unless Ids is 1-D.
+    return user->pool_op && IdsShape(op).size() == 1;
+  }
+  if (type == "fused_embedding_seq_pool") {
+    auto ids_shape = IdsShape(op);
+    return GetAttrOr<std::string>(op, "combiner", "") == "sum" &&
+           ids_shape.size() == 2 && ids_shape[1] == 1;
+  }
+  if (type == "fused_embedding_seqpool_cvm_concat") {
+    return !GetAttrOr<bool>(op, "is_quantized", false);
+  }
+  return false;
+}
+
+// Replace lookup_op and pool_op with fused_embedding_seq_pool_dequant.
+static void FuseLookupPool(framework::ir::Graph* graph, Node* lookup_op,
+                           Node* pool_op) {
+  Node* w = GetInputVar(lookup_op, "W");
+  Node* ids = GetInputVar(lookup_op, "Ids");
+  Node* out = GetOutputVar(pool_op, "Out");
+
+  framework::OpDesc op_desc;
+  op_desc.SetType("fused_embedding_seq_pool_dequant");
+  op_desc.SetInput("W", {w->Name()});
+  op_desc.SetInput("Ids", {ids->Name()});
+  op_desc.SetOutput("Out", {out->Name()});
+  op_desc.SetAttr("combiner", std::string("sum"));
+  op_desc.SetAttr("padding_idx",
+                  GetAttrOr<int64_t>(lookup_op, "padding_idx", -1));
+  auto role_attr = framework::OpProtoAndCheckerMaker::OpRoleAttrName();
+  if (lookup_op->Op()->HasAttr(role_attr)) {
+    op_desc.SetAttr(role_attr, lookup_op->Op()->GetAttr(role_attr));
+  }
+  auto* op = graph->CreateOpNode(&op_desc);
+  IR_NODE_LINK_TO(w, op);
+  IR_NODE_LINK_TO(ids, op);
+  IR_NODE_LINK_TO(op, out);
+
+  std::unordered_set<const Node*> marked_nodes = {lookup_op, pool_op};
+  for (auto* var : pool_op->outputs) {
+    if (var != out) marked_nodes.insert(var);
+  }
+  marked_nodes.insert(lookup_op->outputs.begin(), lookup_op->outputs.end());
+  framework::ir::GraphSafeRemoveNodes(graph, marked_nodes);
+}
+
+// Make op read the quantized table quant_node instead of the float table of
+// the nodes table_nodes.
+static void RelinkTableInput(Node* op, const std::vector<Node*>& table_nodes,
+                             Node* quant_node) {
+  op->Op()->RenameInput(table_nodes[0]->Name(), quant_node->Name());
+  for (auto* var : table_nodes) {
+    auto& users = var->outputs;
+    users.erase(std::remove(users.begin(), users.end(), op), users.end());
+    auto& inputs = op->inputs;
+    inputs.erase(std::remove(inputs.begin(), inputs.end(), var), inputs.end());
+  }
+  IR_NODE_LINK_TO(quant_node, op);
+}
+
+static void ReplaceTableUser(framework::ir::Graph* graph,
+                             const TableUser& user) {
+  auto* desc = user.op->Op();
+  const std::string type = desc->Type();
+  if (user.pool_op) {
+    FuseLookupPool(graph, user.op, user.pool_op);
+    return;
+  }
+  if (type == "fused_embedding_seqpool_cvm_concat") {
+    desc->SetAttr("is_quantized", true);
+  } else if (type == "lookup_table") {
+    desc->SetType("lookup_table_dequant");
+  } else if (type == "fused_embedding_seq_pool") {
+    desc->SetType("fused_embedding_seq_pool_dequant");
+  }
+  desc->Flush();
+  graph->UpdateOpNodeIndex(user.op);
+}
+}  // namespace
+
+void EmbeddingQuantPass::RunImpl(Argument* argument) {
+  PADDLE_ENFORCE_EQ(
+      argument->scope_valid(), true,
+      platform::errors::PreconditionNotMet("The scope field should be valid"));
+  PADDLE_ENFORCE_EQ(argument->use_gpu_valid(), true,
+                    platform::errors::PreconditionNotMet(
+                        "The use_gpu field should be valid"));
+  // The operators reading the quantized tables run on CPU only.
+  if (argument->use_gpu()) return;
+
+  auto& graph = argument->main_graph();
+  auto* scope = argument->scope_ptr();
+
+  // The users and the nodes of each parameter, sorted by name to quantize the
+  // tables in a fixed order.
+  std::map<std::string, std::vector<Node*>> param_users;
+  std::unordered_map<std::string, std::vector<Node*>> param_nodes;
+  for (auto* node : graph.Nodes()) {
+    if (!node->IsVar() || !node->Var() || !node->Var()->Persistable()) {
+      continue;
+    }
+    param_nodes[node->Name()].push_back(node);
+    auto& users = param_users[node->Name()];
+    for (auto* op : node->outputs) {
+      if (std::find(users.begin(), users.end(), op) == users.end()) {
+        users.push_back(op);
+      }
+    }
+  }
+
+  std::vector<std::string> quantized_tables;
+  int64_t saved_bytes = 0;
+  for (auto& item : param_users) {
+    const std::string& name = item.first;
+    if (item.second.empty()) continue;
+    std::vector<TableUser> users(item.second.size());
+    bool matched = true;
+    for (size_t i = 0; i < users.size() && matched; ++i) {
+      matched = MatchTableUser(item.second[i], name, &users[i]);
+    }
+    if (!matched) continue;
+
+    auto* var = scope->FindVar(name);
+    if (!var || !var->IsType<framework::LoDTensor>()) continue;
+    const auto& table = var->Get<framework::LoDTensor>();
+    auto dims = table.dims();
+    if (table.type() != framework::proto::VarType::FP32 ||
+        !platform::is_cpu_place(table.place()) || dims.size() != 2 ||
+        dims[0] == 0 || dims[1] == 0 ||
+        dims[1] % operators::math::kQuantEmbeddingCodesPerFloat != 0) {
+      VLOG(3) << "Skip quantizing the embedding table " << name;
+      continue;
+    }
+
+    // The table is quantized into a new variable, and the float one is left
+    // as it is for the other programs sharing the scope. The variable
+    // quantized for another predictor sharing the scope is reused.
+    const std::string quant_name = name + "@QUANT";
+    framework::DDim quant_dims = framework::make_ddim(
+        {dims[0], operators::math::QuantEmbeddingWidth(dims[1])});
+    auto* quant_var = scope->FindVar(quant_name);
+    if (quant_var == nullptr) {
+      auto* quant_table =
+          scope->Var(quant_name)->GetMutable<framework::LoDTensor>();
+      quant_table->Resize(quant_dims);
+      operators::math::QuantizeEmbedding(
+          table.data<float>(), dims[0], dims[1],
+          quant_table->mutable_data<float>(platform::CPUPlace()));
+    } else if (!quant_var->IsType<framework::LoDTensor>() ||
+               quant_var->Get<framework::LoDTensor>().dims() != quant_dims) {
+      VLOG(3) << "Skip quantizing the embedding table " << name
+              << ", as the variable " << quant_name << " exists";
+      continue;
+    }
+    saved_bytes +=
+        (table.numel() - framework::product(quant_dims)) * sizeof(float);
+
+    framework::VarDesc quant_desc(quant_name);
+    quant_desc.SetType(framework::proto::VarType::LOD_TENSOR);
+    quant_desc.SetDataType(framework::proto::VarType::FP32);
+    quant_desc.SetShape(framework::vectorize(quant_dims));
+    quant_desc.SetPersistable(true);
+    auto* quant_node = graph.CreateVarNode(&quant_desc);
+    auto& table_nodes = param_nodes[name];
+    for (auto& user : users) {
+      RelinkTableInput(user.op, table_nodes, quant_node);
+      ReplaceTableUser(&graph, user);
+    }
+    // The float table is not used by the graph any more.
+    std::unordered_set<const Node*> unused_nodes;
+    for (auto* node : table_nodes) {
+      if (node->inputs.empty() && node->outputs.empty()) {
+        unused_nodes.insert(node);
+      }
+    }
+    framework::ir::GraphSafeRemoveNodes(&graph, unused_nodes);
+    quantized_tables.push_back(name);
+    VLOG(3) << "Quantize the embedding table " << name << " of shape ["
+            << dims << "] used by " << users.size() << " operators";
+  }
+  argument->SetQuantizedEmbeddingTables(quantized_tables);
+  if (!quantized_tables.empty()) {
+    LOG(INFO) << "Quantize " << quantized_tables.size()
+              << " embedding tables to 8 bits, saving "
+              << saved_bytes / 1024 / 1024
+              << " MB once the float tables are released";
+  }
+}
+
+std::string EmbeddingQuantPass::repr() const { return "embedding-quant-pass"; }
+
+}  // namespace analysis
+}  // namespace inference
+}  // namespace paddle
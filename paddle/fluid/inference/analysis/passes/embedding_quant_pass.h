@@ -0,0 +1,53 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+
+#include "paddle/fluid/inference/analysis/analysis_pass.h"
+
+namespace paddle {
+namespace inference {
+namespace analysis {
+
+struct Argument;
+
+/*
+ * Quantize the embedding tables to 8 bits per element with a scale and an
+ * offset per row, which saves about 3/4 of the memory of the tables. The
+ * lookups of a table are replaced with the operators reading the quantized
+ * table:
+ *   - lookup_table followed by sequence_pool(SUM), lookup_table_v2 followed
+ *     by sequence_pool(SUM), and fused_embedding_seq_pool are replaced with
+ *     fused_embedding_seq_pool_dequant, which dequantizes and pools in one
+ *     step.
+ *   - fused_embedding_seqpool_cvm_concat reads the quantized table directly.
+ *   - The other lookup_table are replaced with lookup_table_dequant.
+ * A table is left as it is if any of its users can not be replaced.
+ *
+ * The quantized table is a new variable named <table>@QUANT in the scope, and
+ * the float table is not changed, as the scope may be shared by the other
+ * programs. The names of the float tables replaced are set to the argument,
+ * for the owner of the scope to release them.
+ */
+class EmbeddingQuantPass : public AnalysisPass {
+ public:
+  void RunImpl(Argument *argument) override;
+  std::string repr() const override;
+};
+
+}  // namespace analysis
+}  // namespace inference
+}  // namespace paddle
@@ -0,0 +1,223 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/analysis/passes/embedding_quant_pass.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/ir/graph.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/program_desc.h"
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/inference/analysis/argument.h"
+#include "paddle/fluid/operators/math/embedding_quant.h"
+
+namespace paddle {
+namespace inference {
+namespace analysis {
+
+using framework::ir::Node;
+
+static void AddVar(framework::BlockDesc* block, const std::string& name,
+                   const std::vector<int64_t>& shape, bool persistable) {
+  auto* var = block->Var(name);
+  var->SetType(framework::proto::VarType::LOD_TENSOR);
+  var->SetDataType(name == "ids" ? framework::proto::VarType::INT64
+                                 : framework::proto::VarType::FP32);
+  var->SetShape(shape);
+  var->SetPersistable(persistable);
+}
+
+static void AddOp(framework::BlockDesc* block, const std::string& type,
+                  const framework::VariableNameMap& inputs,
+                  const framework::VariableNameMap& outputs,
+                  const framework::AttributeMap& attrs = {}) {
+  auto* op = block->AppendOp();
+  op->SetType(type);
+  for (auto& input : inputs) {
+    op->SetInput(input.first, input.second);
+  }
+  for (auto& output : outputs) {
+    op->SetOutput(output.first, output.second);
+  }
+  op->SetAttrMap(attrs);
+}
+
+// emb is looked up and pooled, emb2 is looked up only, and fc_w is not an
+// embedding table.
+static framework::ProgramDesc BuildProgram() {
+  framework::ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  AddVar(block, "emb", {100, 16}, true);
+  AddVar(block, "emb2", {50, 8}, true);
+  AddVar(block, "fc_w", {16, 4}, true);
+  AddVar(block, "ids", {-1, 1}, false);
+  for (auto* name : {"emb_out", "pool_out", "max_index", "emb2_out",
+                     "fc_out"}) {
+    AddVar(block, name, {}, false);
+  }
+  AddOp(block, "lookup_table", {{"W", {"emb"}}, {"Ids", {"ids"}}},
+        {{"Out", {"emb_out"}}});
+  AddOp(block, "sequence_pool", {{"X", {"emb_out"}}},
+        {{"Out", {"pool_out"}}, {"MaxIndex", {"max_index"}}},
+        {{"pooltype", std::string("SUM")}});
+  AddOp(block, "lookup_table", {{"W", {"emb2"}}, {"Ids", {"ids"}}},
+        {{"Out", {"emb2_out"}}});
+  AddOp(block, "mul", {{"X", {"pool_out"}}, {"Y", {"fc_w"}}},
+        {{"Out", {"fc_out"}}});
+  return program;
+}
+
+static void InitTable(framework::Scope* scope, const std::string& name,
+                      int64_t height, int64_t width) {
+  std::mt19937 rng(2020);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  auto* tensor = scope->Var(name)->GetMutable<framework::LoDTensor>();
+  float* data =
+      tensor->mutable_data<float>({height, width}, platform::CPUPlace());
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = dist(rng);
+  }
+}
+
+static std::vector<float> TableData(const framework::Scope& scope,
+                                    const std::string& name) {
+  const auto& tensor = scope.FindVar(name)->Get<framework::LoDTensor>();
+  return std::vector<float>(tensor.data<float>(),
+                            tensor.data<float>() + tensor.numel());
+}
+
+// Run the pass on a new graph of program, and return the ops of the graph by
+// their types.
+static std::map<std::string, Node*> RunPass(
+    const framework::ProgramDesc& program, framework::Scope* scope,
+    Argument* argument, std::vector<std::string>* var_names) {
+  argument->SetScopeNotOwned(scope);
+  argument->SetUseGPU(false);
+  argument->SetMainGraph(new framework::ir::Graph(program));
+  EmbeddingQuantPass pass;
+  pass.Run(argument);
+
+  std::map<std::string, Node*> ops;
+  for (auto* node : argument->main_graph().Nodes()) {
+    if (node->IsOp()) {
+      ops[node->Op()->Type()] = node;
+    } else if (node->IsVar()) {
+      var_names->push_back(node->Name());
+    }
+  }
+  return ops;
+}
+
+TEST(EmbeddingQuantPass, NewVariables) {
+  framework::Scope scope;
+  InitTable(&scope, "emb", 100, 16);
+  InitTable(&scope, "emb2", 50, 8);
+  InitTable(&scope, "fc_w", 16, 4);
+  auto emb = TableData(scope, "emb");
+  auto emb2 = TableData(scope, "emb2");
+
+  auto program = BuildProgram();
+  Argument argument;
+  std::vector<std::string> var_names;
+  auto ops = RunPass(program, &scope, &argument, &var_names);
+
+  // lookup_table + sequence_pool are fused, and the other lookup_table reads
+  // the quantized table. mul is left as it is.
+  ASSERT_EQ(ops.size(), 3u);
+  ASSERT_EQ(ops.count("fused_embedding_seq_pool_dequant"), 1u);
+  ASSERT_EQ(ops.count("lookup_table_dequant"), 1u);
+  ASSERT_EQ(ops.count("mul"), 1u);
+  EXPECT_EQ(ops["fused_embedding_seq_pool_dequant"]->Op()->Input("W"),
+            std::vector<std::string>({"emb@QUANT"}));
+  EXPECT_EQ(ops["fused_embedding_seq_pool_dequant"]->Op()->Output("Out"),
+            std::vector<std::string>({"pool_out"}));
+  EXPECT_EQ(ops["lookup_table_dequant"]->Op()->Input("W"),
+            std::vector<std::string>({"emb2@QUANT"}));
+  EXPECT_EQ(ops["mul"]->Op()->Input("Y"), std::vector<std::string>({"fc_w"}));
+  EXPECT_EQ(argument.quantized_embedding_tables(),
+            std::vector<std::string>({"emb", "emb2"}));
+
+  // The float tables are not used by the graph, but left as they are in the
+  // scope.
+  auto has_var = [&var_names](const std::string& name) {
+    return std::count(var_names.begin(), var_names.end(), name) > 0;
+  };
+  EXPECT_FALSE(has_var("emb"));
+  EXPECT_FALSE(has_var("emb2"));
+  EXPECT_TRUE(has_var("emb@QUANT"));
+  EXPECT_TRUE(has_var("fc_w"));
+  EXPECT_EQ(TableData(scope, "emb"), emb);
+  EXPECT_EQ(TableData(scope, "emb2"), emb2);
+
+  // Each element of the quantized table is off by at most half a step of
+  // its row, where a step is 2 / 255 at most.
+  const auto& quant_table =
+      scope.FindVar("emb@QUANT")->Get<framework::LoDTensor>();
+  ASSERT_EQ(quant_table.dims(),
+            framework::make_ddim({100, operators::math::QuantEmbeddingWidth(
+                                           16)}));
+  for (int64_t i = 0; i < 100; ++i) {
+    std::vector<float> row(16, 0.0f);
+    operators::math::DequantAddRow(
+        quant_table.data<float>() + i * quant_table.dims()[1], 0, 16,
+        row.data());
+    for (int64_t j = 0; j < 16; ++j) {
+      EXPECT_NEAR(row[j], emb[i * 16 + j], 1.0f / 255.0f + 1e-5f);
+    }
+  }
+
+  // Another predictor sharing the scope still reads the float tables, or
+  // reuses the quantized ones.
+  Argument another_argument;
+  var_names.clear();
+  const float* quant_data = quant_table.data<float>();
+  ops = RunPass(program, &scope, &another_argument, &var_names);
+  EXPECT_EQ(ops.count("fused_embedding_seq_pool_dequant"), 1u);
+  const auto& reused_table =
+      scope.FindVar("emb@QUANT")->Get<framework::LoDTensor>();
+  EXPECT_EQ(reused_table.data<float>(), quant_data);
+  EXPECT_EQ(TableData(scope, "emb"), emb);
+}
+
+TEST(EmbeddingQuantPass, SkipTableWithOtherUsers) {
+  framework::Scope scope;
+  InitTable(&scope, "emb", 100, 16);
+  InitTable(&scope, "emb2", 50, 8);
+  InitTable(&scope, "fc_w", 16, 4);
+
+  // emb is also read by a mul, so it is kept in float.
+  auto program = BuildProgram();
+  AddVar(program.MutableBlock(0), "emb_mul_out", {}, false);
+  AddOp(program.MutableBlock(0), "mul", {{"X", {"pool_out"}}, {"Y", {"emb"}}},
+        {{"Out", {"emb_mul_out"}}});
+  Argument argument;
+  std::vector<std::string> var_names;
+  auto ops = RunPass(program, &scope, &argument, &var_names);
+  EXPECT_EQ(ops.count("lookup_table"), 1u);
+  EXPECT_EQ(ops.count("sequence_pool"), 1u);
+  EXPECT_EQ(ops.count("lookup_table_dequant"), 1u);
+  EXPECT_EQ(argument.quantized_embedding_tables(),
+            std::vector<std::string>({"emb2"}));
+  EXPECT_EQ(scope.FindVar("emb@QUANT"), nullptr);
+}
+
+}  // namespace analysis
+}  // namespace inference
+}  // namespace paddle
@@ -0,0 +1,139 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/analysis/passes/gemm_weight_prepack_pass.h"
+#include <string>
+#include <vector>
+#include "paddle/fluid/framework/ir/graph_helper.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/operators/math/packed_weights_cache.h"
+
+namespace paddle {
+namespace inference {
+namespace analysis {
+
+namespace {
+using framework::ir::Node;
+
+template <typename T>
+static T GetAttrOr(Node* op, const std::string& name, const T& value) {
+  auto* desc = op->Op();
+  return desc->HasAttr(name) ? BOOST_GET_CONST(T, desc->GetAttr(name)) : value;
+}
+
+// The argument of the weight of op, or an empty string if op is not computed
+// by the kernels reading the prepacked weights.
+static std::string WeightArgument(Node* op) {
+  const std::string& type = op->Op()->Type();
+  if (GetAttrOr<bool>(op, "use_mkldnn", false)) return "";
+  if (type == "fc") {
+    return GetAttrOr<bool>(op, "padding_weights", false) ? "" : "W";
+  }
+  if (type == "mul") return "Y";
+  return "";
+}
+
+// Whether op has the int8 attributes set by quant_conv2d_dequant_fuse_pass,
+// which fc_op.h and mul_op.h read once it is marked with use_int8_gemm.
+static bool IsInt8(Node* op) {
+  auto* desc = op->Op();
+  const char* input_scale = desc->Type() == "fc" ? "Input_scale" : "X_scale";
+  return GetAttrOr<bool>(op, "enable_int8", false) &&
+         desc->HasAttr(input_scale) && desc->HasAttr("weight_scale") &&
+         GetAttrOr<int>(op, "bit_length", 8) == 8;
+}
+
+// The weight of op in scope as the kernel reads it, or nullptr.
+static const framework::LoDTensor* GetWeight(Node* op,
+                                             const std::string& argument,
+                                             framework::Scope* scope) {
+  auto& names = op->Op()->Input(argument);
+  if (names.size() != 1) return nullptr;
+  bool persistable = false;
+  for (auto* var : op->inputs) {
+    if (var->IsVar() && var->Name() == names[0]) {
+      persistable = var->Var() && var->Var()->Persistable();
+    }
+  }
+  if (!persistable) return nullptr;
+  auto* var = scope->FindVar(names[0]);
+  if (!var || !var->IsType<framework::LoDTensor>()) return nullptr;
+  auto* w = &var->Get<framework::LoDTensor>();
+  if (!w->IsInitialized() || w->type() != framework::proto::VarType::FP32 ||
+      !platform::is_cpu_place(w->place()) || w->numel() == 0) {
+    return nullptr;
+  }
+  return w;
+}
+}  // namespace
+
+void GemmWeightPrepackPass::RunImpl(Argument* argument) {
+  PADDLE_ENFORCE_EQ(
+      argument->scope_valid(), true,
+      platform::errors::PreconditionNotMet("The scope field should be valid"));
+  PADDLE_ENFORCE_EQ(argument->use_gpu_valid(), true,
+                    platform::errors::PreconditionNotMet(
+                        "The use_gpu field should be valid"));
+  // The packed weights are read by the kernels on CPU only.
+  if (argument->use_gpu()) return;
+
+  auto& graph = argument->main_graph();
+  auto* scope = argument->scope_ptr();
+  auto& cache = operators::math::PackedWeightsCache::Instance();
+  const bool use_int8_gemm =
+      argument->use_cpu_int8_gemm_valid() && argument->use_cpu_int8_gemm();
+
+  int num_ops = 0;
+  for (auto* op : framework::ir::TopologySortOperations(graph)) {
+    const std::string w_argument = WeightArgument(op);
+    if (w_argument.empty()) continue;
+    auto* w = GetWeight(op, w_argument, scope);
+    if (!w) continue;
+
+    // The weight of mul is flattened to 2-D by y_num_col_dims.
+    framework::Tensor w_matrix = *w;
+    if (op->Op()->Type() == "mul" && w->dims().size() > 2) {
+      w_matrix = framework::ReshapeToMatrix(
+          *w, GetAttrOr<int>(op, "y_num_col_dims", 1));
+    }
+    if (w_matrix.dims().size() != 2) continue;
+
+    if (use_int8_gemm && IsInt8(op)) {
+      cache.GetInt8(w_matrix, GetAttrOr<std::vector<float>>(
+                                  op, "weight_scale", std::vector<float>()));
+      op->Op()->SetAttr("use_int8_gemm", true);
+    } else {
+      cache.GetFloat(w_matrix);
+    }
+    op->Op()->SetAttr("use_prepacked_weight", true);
+    op->Op()->Flush();
+    VLOG(3) << "Prepack the weights " << op->Op()->Input(w_argument)[0]
+            << " of shape [" << w_matrix.dims() << "] of "
+            << op->Op()->Type();
+    ++num_ops;
+  }
+  if (num_ops > 0) {
+    LOG(INFO) << "Prepack the weights of " << num_ops
+              << " fc and mul operators, and the packed weights take "
+              << cache.bytes() / 1024 / 1024 << " MB";
+  }
+}
+
+std::string GemmWeightPrepackPass::repr() const {
+  return "gemm-weight-prepack-pass";
+}
+
+}  // namespace analysis
+}  // namespace inference
+}  // namespace paddle
@@ -0,0 +1,44 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+
+#include "paddle/fluid/inference/analysis/analysis_pass.h"
+
+namespace paddle {
+namespace inference {
+namespace analysis {
+
+struct Argument;
+
+/*
+ * Pack the persistable weights of fc and mul on CPU once at the creation of
+ * the predictor, instead of on every GEMM of the runs, which dominates the
+ * latency of the small batches. The operators are marked with the attribute
+ * use_prepacked_weight, and the packed weights are kept in
+ * operators::math::PackedWeightsCache. With AnalysisConfig::EnableCpuInt8Gemm,
+ * the weights of the int8 fc and mul set by quant_conv2d_dequant_fuse_pass are
+ * packed in int8, and the operators are marked with use_int8_gemm.
+ */
+class GemmWeightPrepackPass : public AnalysisPass {
+ public:
+  void RunImpl(Argument *argument) override;
+  std::string repr() const override;
+};
+
+}  // namespace analysis
+}  // namespace inference
+}  // namespace paddle
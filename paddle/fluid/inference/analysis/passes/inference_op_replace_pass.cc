@@ -35,6 +35,7 @@ void InferenceOpReplacePass::RunImpl(Argument* argument) {
     if (!replaced_map.count(op_type)) continue;
     op_desc->SetType(replaced_map[op_type]);
     op_desc->Flush();
+    graph.UpdateOpNodeIndex(node);
   }
 }
 
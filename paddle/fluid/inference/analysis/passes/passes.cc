@@ -14,6 +14,8 @@
 
 #include "paddle/fluid/inference/analysis/passes/passes.h"
 #include "paddle/fluid/inference/analysis/passes/adjust_cudnn_workspace_size_pass.h"
+#include "paddle/fluid/inference/analysis/passes/embedding_quant_pass.h"
+#include "paddle/fluid/inference/analysis/passes/gemm_weight_prepack_pass.h"
 #include "paddle/fluid/inference/analysis/passes/inference_op_replace_pass.h"
 #include "paddle/fluid/inference/analysis/passes/ir_analysis_pass.h"
 #include "paddle/fluid/inference/analysis/passes/ir_graph_build_pass.h"
@@ -44,6 +46,10 @@ PassRegistry::PassRegistry() {
                   std::unique_ptr<AnalysisPass>(new AdjustCudnnWorkSpacePass));
   passes_.emplace("inference_op_replace_pass",
                   std::unique_ptr<AnalysisPass>(new InferenceOpReplacePass));
+  passes_.emplace("embedding_quant_pass",
+                  std::unique_ptr<AnalysisPass>(new EmbeddingQuantPass));
+  passes_.emplace("gemm_weight_prepack_pass",
+                  std::unique_ptr<AnalysisPass>(new GemmWeightPrepackPass));
   passes_.emplace(
       "ir_graph_to_program_pass",
       std::unique_ptr<IrGraphToProgramPass>(new IrGraphToProgramPass));
@@ -119,6 +119,9 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(memory_pool_init_size_mb_);
 
   CP_MEMBER(enable_memory_optim_);
+  CP_MEMBER(use_embedding_quant_);
+  CP_MEMBER(use_weight_prepacking_);
+  CP_MEMBER(use_cpu_int8_gemm_);
   // TensorRT related.
   CP_MEMBER(use_tensorrt_);
   CP_MEMBER(tensorrt_workspace_size_);
@@ -165,6 +168,7 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(specify_input_name_);
 
   CP_MEMBER(cpu_math_library_num_threads_);
+  CP_MEMBER(cpu_intra_op_num_threads_);
 
   CP_MEMBER(serialized_info_cache_);
 
@@ -383,6 +387,22 @@ void AnalysisConfig::Update() {
 #endif
   }
 
+  // The quantized tables and the fused lookups change the variables, so run
+  // before the memory optimization.
+  if (use_embedding_quant_) {
+    if (use_gpu()) {
+      LOG(WARNING) << "EnableEmbeddingQuantization() only works on CPU.";
+    }
+    pass_builder()->AppendAnalysisPass("embedding_quant_pass");
+  }
+
+  if (use_weight_prepacking_) {
+    if (use_gpu()) {
+      LOG(WARNING) << "EnableWeightPrepacking() only works on CPU.";
+    }
+    pass_builder()->AppendAnalysisPass("gemm_weight_prepack_pass");
+  }
+
 #ifdef PADDLE_WITH_MKLDNN
   // Do not optimize when mkldnn is on
   if (enable_memory_optim_ && !use_mkldnn_) {
@@ -444,6 +464,9 @@ std::string AnalysisConfig::SerializeInfoCache() {
   ss << tensorrt_min_subgraph_size_;
 
   ss << enable_memory_optim_;
+  ss << use_embedding_quant_;
+  ss << use_weight_prepacking_;
+  ss << use_cpu_int8_gemm_;
 
   ss << use_mkldnn_;
   ss << mkldnn_cache_capacity_;
@@ -466,6 +489,7 @@ std::string AnalysisConfig::SerializeInfoCache() {
 
   ss << specify_input_name_;
   ss << cpu_math_library_num_threads_;
+  ss << cpu_intra_op_num_threads_;
 
   ss << use_lite_;
   ss << use_xpu_;
@@ -483,6 +507,17 @@ void AnalysisConfig::SetCpuMathLibraryNumThreads(
   Update();
 }
 
+void AnalysisConfig::SetCpuIntraOpNumThreads(int cpu_intra_op_num_threads) {
+  PADDLE_ENFORCE_GE(cpu_intra_op_num_threads, 0,
+                    platform::errors::InvalidArgument(
+                        "The number of the intra-op threads should not be "
+                        "negative, but received %d.",
+                        cpu_intra_op_num_threads));
+  cpu_intra_op_num_threads_ = cpu_intra_op_num_threads;
+
+  Update();
+}
+
 float AnalysisConfig::fraction_of_gpu_memory_for_pool() const {
 #ifdef PADDLE_WITH_CUDA
   // Get the GPU memory details and calculate the fraction of memory for the
@@ -512,6 +547,35 @@ bool AnalysisConfig::enable_memory_optim() const {
   return enable_memory_optim_;
 }
 
+void AnalysisConfig::EnableEmbeddingQuantization() {
+  use_embedding_quant_ = true;
+  Update();
+}
+
+bool AnalysisConfig::embedding_quantization_enabled() const {
+  return use_embedding_quant_;
+}
+
+void AnalysisConfig::EnableWeightPrepacking() {
+  use_weight_prepacking_ = true;
+  Update();
+}
+
+bool AnalysisConfig::weight_prepacking_enabled() const {
+  return use_weight_prepacking_;
+}
+
+void AnalysisConfig::EnableCpuInt8Gemm() {
+  // The int8 weights are only read from the prepacked ones.
+  use_weight_prepacking_ = true;
+  use_cpu_int8_gemm_ = true;
+  Update();
+}
+
+bool AnalysisConfig::cpu_int8_gemm_enabled() const {
+  return use_cpu_int8_gemm_;
+}
+
 void AnalysisConfig::SetModelBuffer(const char *prog_buffer,
                                     size_t prog_buffer_size,
                                     const char *param_buffer,
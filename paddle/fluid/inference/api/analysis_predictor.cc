@@ -142,6 +142,7 @@ bool AnalysisPredictor::Init(
 
   // no matter with or without MKLDNN
   paddle::platform::SetNumThreads(config_.cpu_math_library_num_threads());
+  paddle::platform::SetIntraOpNumThreads(config_.cpu_intra_op_num_threads());
 
   if (!PrepareScope(parent_scope)) {
     return false;
@@ -307,6 +308,7 @@ bool AnalysisPredictor::Run(const std::vector<PaddleTensor> &inputs,
                             std::vector<PaddleTensor> *output_data,
                             int batch_size) {
   paddle::platform::SetNumThreads(config_.cpu_math_library_num_threads());
+  paddle::platform::SetIntraOpNumThreads(config_.cpu_intra_op_num_threads());
 #ifdef PADDLE_WITH_MKLDNN
   if (config_.use_mkldnn_) MkldnnPreSet(inputs);
 #endif
@@ -347,6 +349,7 @@ bool AnalysisPredictor::Run(const std::vector<PaddleTensor> &inputs,
   // recover the cpu_math_library_num_threads to 1, in order to avoid thread
   // conflict when integrating it into deployment service.
   paddle::platform::SetNumThreads(1);
+  paddle::platform::SetIntraOpNumThreads(0);
 #ifdef PADDLE_WITH_MKLDNN
   if (config_.use_mkldnn_) MkldnnPostReset();
 #endif
@@ -448,6 +451,7 @@ bool AnalysisPredictor::GetFetch(std::vector<PaddleTensor> *outputs,
 void AnalysisPredictor::PrepareArgument() {
   argument_.SetUseGPU(config_.use_gpu());
   argument_.SetUseFcPadding(config_.use_fc_padding());
+  argument_.SetUseCpuInt8Gemm(config_.cpu_int8_gemm_enabled());
   argument_.SetGPUDeviceId(config_.gpu_device_id());
   argument_.SetEnableAnalysisOptim(config_.enable_ir_optim_);
   argument_.SetEnableMemoryOptim(config_.enable_memory_optim());
@@ -530,8 +534,17 @@ void AnalysisPredictor::PrepareArgument() {
 
 // NOTE All the members in AnalysisConfig should be copied to Argument.
 void AnalysisPredictor::OptimizeInferenceProgram() {
+  inference::Timer timer;
+  timer.tic();
   PrepareArgument();
   Analyzer().Run(&argument_);
+  VLOG(3) << "Analysis of the inference program takes " << timer.toc()
+          << " ms";
+  // The predictor owns the scope until it is cloned, and the clones run the
+  // optimized program, so the float tables replaced are released.
+  if (argument_.quantized_embedding_tables_valid()) {
+    scope_->EraseVars(argument_.quantized_embedding_tables());
+  }
 
   PADDLE_ENFORCE_EQ(
       argument_.scope_valid(), true,
@@ -761,6 +774,7 @@ std::unique_ptr<ZeroCopyTensor> AnalysisPredictor::GetOutputTensor(
 
 bool AnalysisPredictor::ZeroCopyRun() {
   paddle::platform::SetNumThreads(config_.cpu_math_library_num_threads());
+  paddle::platform::SetIntraOpNumThreads(config_.cpu_intra_op_num_threads());
 #ifdef PADDLE_WITH_MKLDNN
   if (config_.use_mkldnn_) {
     std::vector<std::vector<int>> shape_vector;
@@ -781,6 +795,7 @@ bool AnalysisPredictor::ZeroCopyRun() {
   // recover the cpu_math_library_num_threads to 1, in order to avoid thread
   // conflict when integrating it into deployment service.
   paddle::platform::SetNumThreads(1);
+  paddle::platform::SetIntraOpNumThreads(0);
 #ifdef PADDLE_WITH_MKLDNN
   if (config_.use_mkldnn_) MkldnnPostReset();
 #endif
@@ -394,6 +394,22 @@ struct PD_INFER_DECL AnalysisConfig {
     return cpu_math_library_num_threads_;
   }
 
+  ///
+  /// \brief Set the number of threads of the intra-op parallelism of the
+  /// CPU kernels of this predictor, e.g. elementwise, reduce and softmax.
+  ///
+  /// \param cpu_intra_op_num_threads The number of threads, and 0, the
+  /// default, uses FLAGS_intra_op_num_threads (default 1).
+  ///
+  void SetCpuIntraOpNumThreads(int cpu_intra_op_num_threads);
+  ///
+  /// \brief An int state telling how many threads are used by a CPU kernel.
+  ///
+  /// \return int The number of threads used by a CPU kernel, or 0 if
+  /// FLAGS_intra_op_num_threads (default 1) is used.
+  ///
+  int cpu_intra_op_num_threads() const { return cpu_intra_op_num_threads_; }
+
   ///
   /// \brief Transform the AnalysisConfig to NativeConfig.
   ///
@@ -490,6 +506,49 @@ struct PD_INFER_DECL AnalysisConfig {
   ///
   bool enable_memory_optim() const;
 
+  ///
+  /// \brief Quantize the embedding tables to 8 bits per element, which saves
+  /// about 3/4 of their memory. The lookups of the tables are replaced with
+  /// the operators dequantizing the rows on the fly. It works on CPU only.
+  ///
+  void EnableEmbeddingQuantization();
+  ///
+  /// \brief A boolean state telling whether the embedding tables are
+  /// quantized.
+  ///
+  /// \return bool Whether the embedding tables are quantized.
+  ///
+  bool embedding_quantization_enabled() const;
+
+  ///
+  /// \brief Pack the weights of fc and mul once at the creation of the
+  /// predictor instead of on every run, which lowers the latency of the
+  /// small batches at the cost of a packed copy of the weights. It works on
+  /// CPU only.
+  ///
+  void EnableWeightPrepacking();
+  ///
+  /// \brief A boolean state telling whether the weights of fc and mul are
+  /// packed ahead.
+  ///
+  /// \return bool Whether the weights are packed ahead.
+  ///
+  bool weight_prepacking_enabled() const;
+
+  ///
+  /// \brief Run fc and mul in int8 with the native int8 GEMM on CPU, if
+  /// quant_conv2d_dequant_fuse_pass has set their scales. It enables the
+  /// weight prepacking too, and the operators whose weights cannot be
+  /// prepacked still run in float.
+  ///
+  void EnableCpuInt8Gemm();
+  ///
+  /// \brief A boolean state telling whether fc and mul run in int8 on CPU.
+  ///
+  /// \return bool Whether fc and mul run in int8 on CPU.
+  ///
+  bool cpu_int8_gemm_enabled() const;
+
   ///
   /// \brief Turn on profiling report.
   /// If not turned on, no profiling report will be generated.
@@ -592,6 +651,10 @@ struct PD_INFER_DECL AnalysisConfig {
   // memory reuse related.
   bool enable_memory_optim_{false};
 
+  bool use_embedding_quant_{false};
+  bool use_weight_prepacking_{false};
+  bool use_cpu_int8_gemm_{false};
+
   bool use_mkldnn_{false};
   std::unordered_set<std::string> mkldnn_enabled_op_types_;
 
@@ -604,6 +667,7 @@ struct PD_INFER_DECL AnalysisConfig {
   bool specify_input_name_{false};
 
   int cpu_math_library_num_threads_{1};
+  int cpu_intra_op_num_threads_{0};
 
   bool with_profile_{false};
 
@@ -154,7 +154,10 @@ CpuPassStrategy::CpuPassStrategy() : PassStrategy({}) {
                   "attention_lstm_fuse_pass",       //
                   "seqconv_eltadd_relu_fuse_pass",  //
                   // "seqpool_concat_fuse_pass",    //
-                  "seqpool_cvm_concat_fuse_pass",  //
+                  // Opt-in until measured on real CTR models, insert it
+                  // before seqpool_cvm_concat_fuse_pass to enable it.
+                  // "embedding_seqpool_cvm_concat_fuse_pass",  //
+                  "seqpool_cvm_concat_fuse_pass",            //
                   // "embedding_fc_lstm_fuse_pass", //
                   // TODO(wilber): fix correctness problem.
                   // "fc_lstm_fuse_pass",                       //
@@ -465,6 +465,37 @@ size_t Usage::operator()(const platform::CUDAPinnedPlace &cuda_pinned) const {
       "'CUDAPinnedPlace' is not supported in CPU only device."));
 #endif
 }
+
+// The bytes in use for the memory counters of Chrome tracing, or -1 for the
+// places without the stats.
+struct TracingUsageVisitor : public boost::static_visitor<int64_t> {
+  template <typename Place>
+  int64_t operator()(const Place &place) const {
+    return -1;
+  }
+
+  int64_t operator()(const platform::CPUPlace &cpu) const {
+    return static_cast<int64_t>(Used(cpu));
+  }
+
+#ifdef PADDLE_WITH_CUDA
+  int64_t operator()(const platform::CUDAPlace &gpu) const {
+    return static_cast<int64_t>(Used(gpu));
+  }
+
+  int64_t operator()(const platform::CUDAPinnedPlace &cuda_pinned) const {
+    return static_cast<int64_t>(Used(cuda_pinned));
+  }
+#endif
+};
+
+static bool tracing_usage_registered = [] {
+  platform::ChromeTracingRecorder::Instance().SetMemoryUsageFunc(
+      [](const platform::Place &place) {
+        return boost::apply_visitor(TracingUsageVisitor(), place);
+      });
+  return true;
+}();
 }  // namespace legacy
 
 namespace allocation {
@@ -482,7 +513,7 @@ void NaiveBestFitAllocator::FreeImpl(Allocation *allocation) {
       legacy::FreeVisitor(allocation->ptr(), allocation->size()),
       allocation->place());
   platform::MemEvenRecorder::Instance().PopMemRecord(
-      static_cast<void *>(allocation), place_);
+      static_cast<void *>(allocation), place_, allocation->size());
   delete allocation;
 }
 
@@ -17,6 +17,7 @@ limitations under the License. */
 #include <vector>
 #include "paddle/fluid/memory/allocation/allocator_facade.h"
 #include "paddle/fluid/memory/allocation/allocator_strategy.h"
+#include "paddle/fluid/platform/op_stat.h"
 #include "paddle/fluid/platform/place.h"
 
 namespace paddle {
@@ -24,10 +25,12 @@ namespace memory {
 
 std::shared_ptr<Allocation> AllocShared(const platform::Place &place,
                                         size_t size) {
+  platform::AddThreadAllocatedBytes(size);
   return allocation::AllocatorFacade::Instance().AllocShared(place, size);
 }
 
 AllocationPtr Alloc(const platform::Place &place, size_t size) {
+  platform::AddThreadAllocatedBytes(size);
   return allocation::AllocatorFacade::Instance().Alloc(place, size);
 }
 
@@ -14,16 +14,20 @@ limitations under the License. */
 
 #include "paddle/fluid/operators/benchmark/op_tester.h"
 #include <fstream>
+#include <sstream>
 #include "gflags/gflags.h"
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/op_info.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/variable_helper.h"
+#include "paddle/fluid/platform/cpu_helper.h"
 #include "paddle/fluid/platform/init.h"
 #include "paddle/fluid/platform/profiler.h"
 #include "paddle/fluid/platform/timer.h"
 #include "paddle/fluid/pybind/pybind.h"
 
+DECLARE_int32(intra_op_num_threads);
+
 namespace paddle {
 namespace operators {
 namespace benchmark {
@@ -69,6 +73,8 @@ void OpTester::Run() {
     LOG(INFO) << DebugString();
   }
 
+  platform::SetIntraOpNumThreads(FLAGS_intra_op_num_threads);
+
   // Warm up
   RunImpl();
 
@@ -117,6 +123,11 @@ std::vector<std::string> OpTester::GetOpProtoInputNames() {
       framework::OpInfoMap::Instance().Get(type_).Proto();
   for (int i = 0; i != proto.inputs_size(); ++i) {
     const auto &input = proto.inputs(i);
+    // Dispensable inputs, such as the Axis of gather, are only fed when the
+    // config provides them.
+    if (input.dispensable() && config_.GetInput(input.name()) == nullptr) {
+      continue;
+    }
     input_names.push_back(input.name());
   }
   return input_names;
@@ -231,8 +242,17 @@ void OpTester::CreateOpDesc() {
       case framework::proto::AttrType::STRING: {
         op_desc_.SetAttr(name, {value_str});
       } break;
+      case framework::proto::AttrType::INTS: {
+        // The values are separated by commas, e.g. 1,2
+        std::vector<int> values;
+        std::istringstream is(value_str);
+        std::string item;
+        while (std::getline(is, item, ',')) {
+          values.push_back(StringTo<int>(item));
+        }
+        op_desc_.SetAttr(name, values);
+      } break;
       case framework::proto::AttrType::BOOLEANS:
-      case framework::proto::AttrType::INTS:
       case framework::proto::AttrType::FLOATS:
       case framework::proto::AttrType::STRINGS:
         PADDLE_THROW(platform::errors::Unimplemented(
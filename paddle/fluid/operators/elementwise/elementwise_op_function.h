@@ -167,6 +167,102 @@ inline void GetBroadcastDimsArrays(const framework::DDim &x_dims,
   }
 }
 
+// The dims of X, Y and Out are collapsed for CPU broadcast: dims of size 1 in
+// Out are dropped, and adjacent dims in which X and Y are broadcast in the
+// same way are merged into one. The last collapsed dim is the largest
+// contiguous run, which is processed by the inner loops, and the others are
+// iterated by the outer loops in parallel.
+// For example, X = [2, 3, 4, 5] and Y = [1, 3, 1, 1] are collapsed to
+// X = [2, 3, 20] and Y = [1, 3, 1].
+struct CPUBroadcastDims {
+  CPUBroadcastDims(const int *x_dims_array, const int *y_dims_array,
+                   const int *out_dims_array, int max_dim) {
+    // The broadcast pattern of each dim: 0 if no broadcast, 1 if X is
+    // broadcast, and 2 if Y is broadcast.
+    std::vector<int> patterns;
+    out_size = 1;
+    for (int i = 0; i < max_dim; ++i) {
+      out_size *= out_dims_array[i];
+      if (out_dims_array[i] == 1) continue;
+      int pattern = x_dims_array[i] == 1 ? 1 : (y_dims_array[i] == 1 ? 2 : 0);
+      if (!patterns.empty() && patterns.back() == pattern) {
+        out_dims.back() *= out_dims_array[i];
+      } else {
+        patterns.push_back(pattern);
+        out_dims.push_back(out_dims_array[i]);
+      }
+    }
+    if (out_dims.empty()) {
+      patterns.push_back(0);
+      out_dims.push_back(1);
+    }
+
+    int rank = out_dims.size();
+    x_strides.resize(rank);
+    y_strides.resize(rank);
+    out_strides.resize(rank);
+    int64_t x_stride = 1, y_stride = 1, out_stride = 1;
+    for (int i = rank - 1; i >= 0; --i) {
+      x_strides[i] = patterns[i] == 1 ? 0 : x_stride;
+      y_strides[i] = patterns[i] == 2 ? 0 : y_stride;
+      out_strides[i] = out_stride;
+      x_stride *= patterns[i] == 1 ? 1 : out_dims[i];
+      y_stride *= patterns[i] == 2 ? 1 : out_dims[i];
+      out_stride *= out_dims[i];
+    }
+  }
+
+  int Rank() const { return out_dims.size(); }
+  int64_t InnerSize() const { return out_dims.back(); }
+  int64_t Rows() const { return out_size / InnerSize(); }
+
+  // Get the offsets of X and Y of the row-th row.
+  void RowOffsets(int64_t row, int64_t *x_offset, int64_t *y_offset) const {
+    *x_offset = 0;
+    *y_offset = 0;
+    for (int i = Rank() - 2; i >= 0; --i) {
+      int64_t index = row % out_dims[i];
+      row /= out_dims[i];
+      *x_offset += index * x_strides[i];
+      *y_offset += index * y_strides[i];
+    }
+  }
+
+  std::vector<int64_t> out_dims;
+  // The stride is 0 in the broadcast dims.
+  std::vector<int64_t> x_strides;
+  std::vector<int64_t> y_strides;
+  std::vector<int64_t> out_strides;
+  int64_t out_size;
+};
+
+// The contiguous inner loop of broadcast forward. Each case is a unit-stride
+// loop, which is vectorized by the compiler.
+template <typename Functor, typename T, typename OutType>
+inline void CPUBroadcastInnerLoop(const T *a, bool a_contiguous, const T *b,
+                                  bool b_contiguous, int64_t n, OutType *out,
+                                  Functor func) {
+  if (a_contiguous && b_contiguous) {
+    for (int64_t i = 0; i < n; ++i) {
+      out[i] = func(a[i], b[i]);
+    }
+  } else if (a_contiguous) {
+    const T b0 = b[0];
+    for (int64_t i = 0; i < n; ++i) {
+      out[i] = func(a[i], b0);
+    }
+  } else if (b_contiguous) {
+    const T a0 = a[0];
+    for (int64_t i = 0; i < n; ++i) {
+      out[i] = func(a0, b[i]);
+    }
+  } else {
+    for (int64_t i = 0; i < n; ++i) {
+      out[i] = func(a[0], b[0]);
+    }
+  }
+}
+
 template <typename Functor, typename T, typename OutType = T>
 void CommonForwardBroadcastCPU(const framework::Tensor *x,
                                const framework::Tensor *y, framework::Tensor *z,
@@ -175,25 +271,32 @@ void CommonForwardBroadcastCPU(const framework::Tensor *x,
                                const platform::CPUDeviceContext &ctx,
                                Functor func,
                                const bool is_xsize_larger = true) {
-  std::vector<int> index_array(max_dim, 0);
   const T *x_data = x->data<T>();
   const T *y_data = y->data<T>();
   OutType *out_data = z->mutable_data<OutType>(ctx.GetPlace());
 
-  const int out_size = std::accumulate(out_dims_array, out_dims_array + max_dim,
-                                       1, std::multiplies<int>());
-  int x_index, y_index;
-  for (int out_index = 0; out_index < out_size; ++out_index) {
-    x_index = GetElementwiseIndex(x_dims_array, max_dim, index_array.data());
-    y_index = GetElementwiseIndex(y_dims_array, max_dim, index_array.data());
-    if (is_xsize_larger) {
-      out_data[out_index] = func(x_data[x_index], y_data[y_index]);
-    } else {
-      out_data[out_index] = func(y_data[y_index], x_data[x_index]);
+  CPUBroadcastDims dims(x_dims_array, y_dims_array, out_dims_array, max_dim);
+  if (dims.out_size <= 0) return;
+  const int64_t inner = dims.InnerSize();
+  const int64_t rows = dims.Rows();
+  const bool x_contiguous = dims.x_strides.back() != 0;
+  const bool y_contiguous = dims.y_strides.back() != 0;
+  ctx.ParallelFor(0, rows, platform::CPUDeviceContext::GrainSize(inner),
+                  [&](int64_t begin, int64_t end) {
+    for (int64_t row = begin; row < end; ++row) {
+      int64_t x_offset, y_offset;
+      dims.RowOffsets(row, &x_offset, &y_offset);
+      if (is_xsize_larger) {
+        CPUBroadcastInnerLoop(x_data + x_offset, x_contiguous,
+                              y_data + y_offset, y_contiguous, inner,
+                              out_data + row * inner, func);
+      } else {
+        CPUBroadcastInnerLoop(y_data + y_offset, y_contiguous,
+                              x_data + x_offset, x_contiguous, inner,
+                              out_data + row * inner, func);
+      }
     }
-
-    UpdateElementwiseIndexArray(out_dims_array, max_dim, index_array.data());
-  }
+  });
 }
 
 #ifdef __NVCC__
@@ -312,6 +415,107 @@ void CommonForwardBroadcastCUDA(
 
 #endif  // __NVCC__
 
+// The contiguous inner loop of broadcast backward, which accumulates the
+// gradient of one operand. The conditions are loop invariant, so the
+// compiler unswitches the loop and vectorizes each case.
+template <typename T, typename GRAD_OP>
+inline void CPUBroadcastGradInnerLoop(const T *x, bool x_contiguous,
+                                      const T *y, bool y_contiguous,
+                                      const T *out, const T *dout,
+                                      int64_t begin, int64_t end, T *d,
+                                      bool d_contiguous, GRAD_OP grad_op) {
+  if (d_contiguous) {
+    for (int64_t i = begin; i < end; ++i) {
+      d[i] += grad_op(x[x_contiguous ? i : 0], y[y_contiguous ? i : 0], out[i],
+                      dout[i]);
+    }
+  } else {
+    T sum = static_cast<T>(0);
+    for (int64_t i = begin; i < end; ++i) {
+      sum += grad_op(x[x_contiguous ? i : 0], y[y_contiguous ? i : 0], out[i],
+                     dout[i]);
+    }
+    d[0] += sum;
+  }
+}
+
+// Compute the gradient of X if kIsX is true, otherwise the gradient of Y.
+// The gradient is reduced over the dims in which the operand is broadcast.
+// The outer dims are split into the kept dims, which index different elements
+// of the gradient and are iterated in parallel, and the reduced dims, which
+// are accumulated sequentially in each thread, so that no element of the
+// gradient is written by two threads and the result is deterministic.
+template <typename T, bool kIsX, typename GRAD_OP>
+void CPUBroadcastGrad(const platform::CPUDeviceContext &ctx,
+                      const CPUBroadcastDims &dims, const T *x_data,
+                      const T *y_data, const T *out_data, const T *dout_data,
+                      T *d_data, GRAD_OP grad_op) {
+  const std::vector<int64_t> &d_strides =
+      kIsX ? dims.x_strides : dims.y_strides;
+  std::vector<int> kept_dims;
+  std::vector<int> reduced_dims;
+  int64_t kept_size = 1;
+  int64_t reduced_size = 1;
+  for (int i = 0; i < dims.Rank() - 1; ++i) {
+    if (d_strides[i] != 0) {
+      kept_dims.push_back(i);
+      kept_size *= dims.out_dims[i];
+    } else {
+      reduced_dims.push_back(i);
+      reduced_size *= dims.out_dims[i];
+    }
+  }
+
+  const int64_t inner = dims.InnerSize();
+  const bool x_contiguous = dims.x_strides.back() != 0;
+  const bool y_contiguous = dims.y_strides.back() != 0;
+  const bool d_contiguous = d_strides.back() != 0;
+  // The inner dim is also split into blocks if it is not reduced, so that
+  // there is enough parallelism even if the kept dims are small.
+  const int64_t block_size =
+      d_contiguous ? std::min<int64_t>(inner, 4096) : inner;
+  const int64_t num_blocks = (inner + block_size - 1) / block_size;
+  const int64_t num_units = kept_size * num_blocks;
+
+  ctx.ParallelFor(0, num_units, platform::CPUDeviceContext::GrainSize(
+                                    reduced_size * block_size),
+                  [&](int64_t unit_begin, int64_t unit_end) {
+    for (int64_t unit = unit_begin; unit < unit_end; ++unit) {
+      int64_t kept = unit / num_blocks;
+      int64_t begin = (unit % num_blocks) * block_size;
+      int64_t end = std::min(begin + block_size, inner);
+
+      int64_t x_base = 0, y_base = 0, out_base = 0;
+      for (int k = static_cast<int>(kept_dims.size()) - 1; k >= 0; --k) {
+        int dim = kept_dims[k];
+        int64_t index = kept % dims.out_dims[dim];
+        kept /= dims.out_dims[dim];
+        x_base += index * dims.x_strides[dim];
+        y_base += index * dims.y_strides[dim];
+        out_base += index * dims.out_strides[dim];
+      }
+      T *d = d_data + (kIsX ? x_base : y_base);
+
+      for (int64_t reduced = 0; reduced < reduced_size; ++reduced) {
+        int64_t x_offset = x_base, y_offset = y_base, out_offset = out_base;
+        int64_t remain = reduced;
+        for (int k = static_cast<int>(reduced_dims.size()) - 1; k >= 0; --k) {
+          int dim = reduced_dims[k];
+          int64_t index = remain % dims.out_dims[dim];
+          remain /= dims.out_dims[dim];
+          x_offset += index * dims.x_strides[dim];
+          y_offset += index * dims.y_strides[dim];
+          out_offset += index * dims.out_strides[dim];
+        }
+        CPUBroadcastGradInnerLoop(x_data + x_offset, x_contiguous,
+                                  y_data + y_offset, y_contiguous,
+                                  out_data + out_offset, dout_data + out_offset,
+                                  begin, end, d, d_contiguous, grad_op);
+      }
+    }
+  });
+}
+
 template <typename T, typename DX_OP, typename DY_OP>
 void CommonGradBroadcastCPU(
     const framework::Tensor &x, const framework::Tensor &y,
@@ -319,7 +523,6 @@ void CommonGradBroadcastCPU(
     framework::Tensor *dx, framework::Tensor *dy, int *x_dims_array,
     int *y_dims_array, int *out_dims_array, int max_dim,
     const platform::CPUDeviceContext &ctx, DX_OP dx_op, DY_OP dy_op) {
-  std::vector<int> index_array(max_dim, 0);
   const T *x_data = x.data<T>();
   const T *y_data = y.data<T>();
   const T *out_data = out.data<T>();
@@ -332,22 +535,16 @@ void CommonGradBroadcastCPU(
   if (dy_data != nullptr) {
     memset(dy_data, 0, dy->numel() * sizeof(T));
   }
-  const int out_size = std::accumulate(out_dims_array, out_dims_array + max_dim,
-                                       1, std::multiplies<int>());
-  int x_index, y_index;
-  for (int out_index = 0; out_index < out_size; ++out_index) {
-    x_index = GetElementwiseIndex(x_dims_array, max_dim, index_array.data());
-    y_index = GetElementwiseIndex(y_dims_array, max_dim, index_array.data());
-    if (dx_data != nullptr) {
-      dx_data[x_index] += dx_op(x_data[x_index], y_data[y_index],
-                                out_data[out_index], dout_data[out_index]);
-    }
-    if (dy_data != nullptr) {
-      dy_data[y_index] += dy_op(x_data[x_index], y_data[y_index],
-                                out_data[out_index], dout_data[out_index]);
-    }
 
-    UpdateElementwiseIndexArray(out_dims_array, max_dim, index_array.data());
+  CPUBroadcastDims dims(x_dims_array, y_dims_array, out_dims_array, max_dim);
+  if (dims.out_size <= 0) return;
+  if (dx_data != nullptr) {
+    CPUBroadcastGrad<T, true>(ctx, dims, x_data, y_data, out_data, dout_data,
+                              dx_data, dx_op);
+  }
+  if (dy_data != nullptr) {
+    CPUBroadcastGrad<T, false>(ctx, dims, x_data, y_data, out_data,
+                               dout_data, dy_data, dy_op);
   }
 }
 
@@ -1234,153 +1431,27 @@ inline framework::DDim trim_trailing_singular_dims(
   return actual_dims;
 }
 
-template <typename T, typename DeviceContext>
-class RowwiseTransformIterator;
-
-template <typename T, typename DeviceContext>
-class MidWiseTransformIterator;
-
-// NOTE(dzhwinter): ptrdiff_t in iterator is deperecated in c++17
-template <typename T>
-class RowwiseTransformIterator<T, platform::CPUDeviceContext>
-    : public std::iterator<std::random_access_iterator_tag, T, std::ptrdiff_t,
-                           T *, T &> {
- public:
-  RowwiseTransformIterator(const T *ptr, int n) : ptr_(ptr), i_(0), n_(n) {}
-
-  RowwiseTransformIterator<T, platform::CPUDeviceContext> &operator++() {
-    ++i_;
-    if (UNLIKELY(i_ == n_)) {
-      i_ = 0;
-    }
-    return *this;
-  }
-
-  RowwiseTransformIterator<T, platform::CPUDeviceContext> &operator+(int n) {
-    while (n-- > 0) {
-      ++i_;
-      if (UNLIKELY(i_ == n_)) {
-        i_ = 0;
-      }
-    }
-
-    return *this;
-  }
-
-  bool operator==(const RowwiseTransformIterator<T, platform::CPUDeviceContext>
-                      &rhs) const {
-    return (ptr_ + i_) == &(*rhs);
-  }
-
-  bool operator!=(const RowwiseTransformIterator<T, platform::CPUDeviceContext>
-                      &rhs) const {
-    return (ptr_ + i_) != &(*rhs);
-  }
-
-  const T &operator*() { return ptr_[i_]; }
-
- private:
-  const T *ptr_;
-  int i_;
-  int64_t n_;
-};
-
-template <typename T>
-class MidWiseTransformIterator<T, platform::CPUDeviceContext>
-    : public std::iterator<std::random_access_iterator_tag, T, std::ptrdiff_t,
-                           T *, T &> {
- public:
-  MidWiseTransformIterator(const T *ptr, int n, int post)
-      : ptr_(ptr), i_(0), j_(0), n_(n), post_(post) {}
-
-  MidWiseTransformIterator<T, platform::CPUDeviceContext> &operator++() {
-    ++j_;
-    if (UNLIKELY(j_ == post_)) {
-      ++i_;
-      j_ = 0;
-      if (UNLIKELY(i_ == n_)) {
-        i_ = 0;
-      }
-    }
-    return *this;
-  }
-
-  MidWiseTransformIterator<T, platform::CPUDeviceContext> &operator+(int n) {
-    while (n-- > 0) {
-      ++j_;
-      if (UNLIKELY(j_ == post_)) {
-        ++i_;
-        j_ = 0;
-        if (UNLIKELY(i_ == n_)) {
-          i_ = 0;
-        }
-      }
-    }
-    return *this;
-  }
-
-  bool operator==(const MidWiseTransformIterator<T, platform::CPUDeviceContext>
-                      &rhs) const {
-    return (ptr_ + i_) == &(*rhs);
-  }
-
-  bool operator!=(const MidWiseTransformIterator<T, platform::CPUDeviceContext>
-                      &rhs) const {
-    return (ptr_ + i_) != &(*rhs);
-  }
-
-  const T &operator*() { return ptr_[i_]; }
-
- private:
-  const T *ptr_;
-  int64_t i_;
-  int64_t j_;
-  int64_t n_;
-  int64_t post_;
-};
-
-#ifdef __NVCC__
-template <typename T>
-class RowwiseTransformIterator<T, platform::CUDADeviceContext>
-    : public thrust::iterator_adaptor<
-          RowwiseTransformIterator<T, platform::CUDADeviceContext>, const T *> {
- public:
-  typedef thrust::iterator_adaptor<
-      RowwiseTransformIterator<T, platform::CUDADeviceContext>, const T *>
-      super_t;
-  HOSTDEVICE RowwiseTransformIterator(const T *x, int n)
-      : super_t(x), begin_(x), n_(n) {}
-  friend class thrust::iterator_core_access;
-
- private:
-  unsigned int n_;
-  const T *begin_;
-  HOSTDEVICE typename super_t::reference dereference() const {
-    return *(begin_ + (this->base() - begin_) % n_);
-  }
-};
-
-template <typename T>
-class MidWiseTransformIterator<T, platform::CUDADeviceContext>
-    : public thrust::iterator_adaptor<
-          MidWiseTransformIterator<T, platform::CUDADeviceContext>, const T *> {
- public:
-  typedef thrust::iterator_adaptor<
-      MidWiseTransformIterator<T, platform::CUDADeviceContext>, const T *>
-      super_t;
-  HOSTDEVICE MidWiseTransformIterator(const T *x, int n, int post)
-      : super_t(x), begin_(x), n_(n), post_(post) {}
-  friend class thrust::iterator_core_access;
+template <typename DeviceContext, typename Functor, typename T,
+          typename OutType>
+inline void ElementwiseTransform(const DeviceContext &ctx, const T *x,
+                                 const T *y, OutType *z, int64_t n,
+                                 Functor func) {
+  platform::Transform<DeviceContext> trans;
+  trans(ctx, x, x + n, y, z, func);
+}
 
- private:
-  unsigned int post_;
-  unsigned int n_;
-  const T *begin_;
-  HOSTDEVICE typename super_t::reference dereference() const {
-    return *(begin_ + (((this->base() - begin_) / post_) % n_));
-  }
-};
-#endif
+// The elementwise functors are pure, so the range is split across threads on
+// CPU, unlike platform::Transform, which runs any functor.
+template <typename Functor, typename T, typename OutType>
+inline void ElementwiseTransform(const platform::CPUDeviceContext &ctx,
+                                 const T *x, const T *y, OutType *z, int64_t n,
+                                 Functor func) {
+  ctx.ParallelFor(0, n, platform::CPUDeviceContext::kDefaultGrainSize,
+                  [&](int64_t begin, int64_t end) {
+                    std::transform(x + begin, x + end, y + begin, z + begin,
+                                   func);
+                  });
+}
 
 template <typename Functor, typename T, typename DeviceContext,
           typename OutType = T>
@@ -1402,30 +1473,7 @@ class TransformFunctor {
   }
 
   inline void Run() const {
-    platform::Transform<DeviceContext> trans;
-    trans(ctx_, x_, x_ + nx_, y_, z_, func_);
-  }
-
-  inline void RunRowWise(int n, int pre) const {
-    platform::Transform<DeviceContext> trans;
-    if (is_xsize_larger_) {
-      trans(ctx_, x_, x_ + nx_,
-            RowwiseTransformIterator<T, DeviceContext>(y_, n), z_, func_);
-    } else {
-      trans(ctx_, y_, y_ + nx_,
-            RowwiseTransformIterator<T, DeviceContext>(x_, n), z_, func_);
-    }
-  }
-
-  inline void RunMidWise(int n, int pre, int post) const {
-    platform::Transform<DeviceContext> trans;
-    if (is_xsize_larger_) {
-      trans(ctx_, x_, x_ + nx_,
-            MidWiseTransformIterator<T, DeviceContext>(y_, n, post), z_, func_);
-    } else {
-      trans(ctx_, y_, y_ + nx_,
-            MidWiseTransformIterator<T, DeviceContext>(x_, n, post), z_, func_);
-    }
+    ElementwiseTransform(ctx_, x_, y_, z_, nx_, func_);
   }
 
  private:
@@ -1460,50 +1508,6 @@ struct ElemwiseGradNoBroadcast {
   T *dy_;
 };
 
-template <typename T, typename DX_OP, typename DY_OP>
-static void ElemwiseGradBroadcast1CPU(const T *x, const T *y, const T *out,
-                                      const T *dout, int h, int w,
-                                      bool is_xsize_larger, DX_OP dx_op,
-                                      DY_OP dy_op, T *dx, T *dy) {
-  if (is_xsize_larger) {
-    for (int i = 0; i < h; ++i) {
-      for (int j = 0; j < w; ++j) {
-        int x_offset = i * w + j;
-        if (dx != nullptr) {
-          dx[x_offset] =
-              dx_op(x[x_offset], y[j], out[x_offset], dout[x_offset]);
-        }
-        if (dy != nullptr) {
-          T tmp = dy_op(x[x_offset], y[j], out[x_offset], dout[x_offset]);
-          if (i == 0) {
-            dy[j] = tmp;
-          } else {
-            dy[j] += tmp;
-          }
-        }
-      }
-    }
-  } else {  // x.dims < y.dims, broadcast for x.
-    for (int i = 0; i < h; ++i) {
-      for (int j = 0; j < w; ++j) {
-        int y_offset = i * w + j;
-        if (dy != nullptr) {
-          dy[y_offset] =
-              dy_op(x[j], y[y_offset], out[y_offset], dout[y_offset]);
-        }
-        if (dx != nullptr) {
-          T tmp = dx_op(x[j], y[y_offset], out[y_offset], dout[y_offset]);
-          if (i == 0) {
-            dx[j] = tmp;
-          } else {
-            dx[j] += tmp;
-          }
-        }
-      }
-    }
-  }
-}
-
 #ifdef __NVCC__
 
 template <typename T, typename DX_OP, typename DY_OP>
@@ -1529,54 +1533,6 @@ static void ElemwiseGradBroadcast1CUDA(cudaStream_t stream, const T *x,
 
 #endif
 
-template <typename T, typename DX_OP, typename DY_OP>
-static void ElemwiseGradBroadcast2CPU(const T *x, const T *y, const T *out,
-                                      const T *dout, int pre, int n, int post,
-                                      bool is_xsize_larger, DX_OP dx_op,
-                                      DY_OP dy_op, T *dx, T *dy) {
-  if (is_xsize_larger) {
-    for (int i = 0; i < pre; ++i) {
-      for (int j = 0; j < n; ++j) {
-        for (int k = 0; k < post; ++k) {
-          int x_offset = i * n * post + j * post + k;
-          if (dx != nullptr) {
-            dx[x_offset] =
-                dx_op(x[x_offset], y[j], out[x_offset], dout[x_offset]);
-          }
-          if (dy != nullptr) {
-            T tmp = dy_op(x[x_offset], y[j], out[x_offset], dout[x_offset]);
-            if (i == 0 && k == 0) {
-              dy[j] = tmp;
-            } else {
-              dy[j] += tmp;
-            }
-          }
-        }
-      }
-    }
-  } else {  // x.dims < y.dims, broadcast for x.
-    for (int i = 0; i < pre; ++i) {
-      for (int j = 0; j < n; ++j) {
-        for (int k = 0; k < post; ++k) {
-          int y_offset = i * n * post + j * post + k;
-          if (dy != nullptr) {
-            dy[y_offset] =
-                dy_op(x[j], y[y_offset], out[y_offset], dout[y_offset]);
-          }
-          if (dx != nullptr) {
-            T tmp = dx_op(x[j], y[y_offset], out[y_offset], dout[y_offset]);
-            if (i == 0 && k == 0) {
-              dx[j] = tmp;
-            } else {
-              dx[j] += tmp;
-            }
-          }
-        }
-      }
-    }
-  }
-}
-
 #ifdef __NVCC__
 template <typename T, typename DX_OP, typename DY_OP>
 static __global__ void ElemwiseGradBroadcast2CUDAKernel(
@@ -1681,6 +1637,10 @@ void CommonElementwiseBroadcastBackward(
     dx->clear();
     dx->mutable_data<T>(x_dims, ctx.GetPlace());
   }
+  if (dy && dy->IsSharedBufferWith(dout)) {
+    dy->clear();
+    dy->mutable_data<T>(y_dims, ctx.GetPlace());
+  }
 
   VLOG(3) << "CommonElementwiseBroadcastBackward xdims:"
           << framework::make_ddim(x_dims_array)
@@ -1763,47 +1723,30 @@ void ElemwiseGradComputeWithBroadcast(
                  &is_run_common_broadcast);
   }
 
-  // special case for common backward implementation.
-  if (is_run_common_broadcast) {
+  // special case for common backward implementation. All the broadcast cases
+  // on CPU also use it, which is vectorized and parallel.
+  if (is_run_common_broadcast || platform::is_cpu_place(ctx.GetPlace())) {
     CommonElementwiseBroadcastBackward<DeviceContext, T, DX_OP, DY_OP>(
         ctx, x_dims, y_dims, x, y, out, dout, axis, dx, dy, dx_op, dy_op);
     return;
   }
-  if (post == 1) {
-    if (platform::is_gpu_place(ctx.GetPlace())) {
 #ifdef __NVCC__
-      ElemwiseGradBroadcast1CUDA(
-          ctx.template device_context<DeviceContext>().stream(), x.data<T>(),
-          y.data<T>(), out.data<T>(), dout.data<T>(), pre, n, is_xsize_larger,
-          dx_op, dy_op,
-          dx == nullptr ? nullptr : dx->mutable_data<T>(ctx.GetPlace()),
-          dy == nullptr ? nullptr : dy->mutable_data<T>(ctx.GetPlace()));
-#endif
-    } else {
-      ElemwiseGradBroadcast1CPU(
-          x.data<T>(), y.data<T>(), out.data<T>(), dout.data<T>(), pre, n,
-          is_xsize_larger, dx_op, dy_op,
-          dx == nullptr ? nullptr : dx->mutable_data<T>(ctx.GetPlace()),
-          dy == nullptr ? nullptr : dy->mutable_data<T>(ctx.GetPlace()));
-    }
+  if (post == 1) {
+    ElemwiseGradBroadcast1CUDA(
+        ctx.template device_context<DeviceContext>().stream(), x.data<T>(),
+        y.data<T>(), out.data<T>(), dout.data<T>(), pre, n, is_xsize_larger,
+        dx_op, dy_op,
+        dx == nullptr ? nullptr : dx->mutable_data<T>(ctx.GetPlace()),
+        dy == nullptr ? nullptr : dy->mutable_data<T>(ctx.GetPlace()));
   } else {
-    if (platform::is_gpu_place(ctx.GetPlace())) {
-#ifdef __NVCC__
-      ElemwiseGradBroadcast2CUDA(
-          ctx.template device_context<DeviceContext>().stream(), x.data<T>(),
-          y.data<T>(), out.data<T>(), dout.data<T>(), pre, n, post,
-          is_xsize_larger, dx_op, dy_op,
-          dx == nullptr ? nullptr : dx->mutable_data<T>(ctx.GetPlace()),
-          dy == nullptr ? nullptr : dy->mutable_data<T>(ctx.GetPlace()));
-#endif
-    } else {
-      ElemwiseGradBroadcast2CPU(
-          x.data<T>(), y.data<T>(), out.data<T>(), dout.data<T>(), pre, n, post,
-          is_xsize_larger, dx_op, dy_op,
-          dx == nullptr ? nullptr : dx->mutable_data<T>(ctx.GetPlace()),
-          dy == nullptr ? nullptr : dy->mutable_data<T>(ctx.GetPlace()));
-    }
+    ElemwiseGradBroadcast2CUDA(
+        ctx.template device_context<DeviceContext>().stream(), x.data<T>(),
+        y.data<T>(), out.data<T>(), dout.data<T>(), pre, n, post,
+        is_xsize_larger, dx_op, dy_op,
+        dx == nullptr ? nullptr : dx->mutable_data<T>(ctx.GetPlace()),
+        dy == nullptr ? nullptr : dy->mutable_data<T>(ctx.GetPlace()));
   }
+#endif
 }
 
 template <typename Functor, typename DeviceContext, typename T,
@@ -1937,28 +1880,20 @@ void ElementwiseComputeEx(const framework::ExecutionContext &ctx,
   // special case for common implementation.
   // case 1: x=[2,3,1,5], y=[2,1,4,1]
   // case 2: x=[2,3,4], y=[1,1,4]
-  if (is_run_common_broadcast == 1) {
+  // All the broadcast cases on CPU also use it, which is vectorized and
+  // parallel.
+  if (is_run_common_broadcast == 1 || platform::is_cpu_place(ctx.GetPlace())) {
     CommonElementwiseBroadcastForward<Functor, DeviceContext, T, OutType>(
         ctx, x, y, z, x_dims, y_dims, func, axis, is_xsize_larger);
     return;
   }
 
-  if (platform::is_gpu_place(ctx.GetPlace())) {
 #ifdef __NVCC__
-    ComputeElementwiseCUDA<Functor, T, OutType>(
-        x, y, z, pre, n, post,
-        ctx.template device_context<platform::CUDADeviceContext>(), func,
-        is_xsize_larger);
+  ComputeElementwiseCUDA<Functor, T, OutType>(
+      x, y, z, pre, n, post,
+      ctx.template device_context<platform::CUDADeviceContext>(), func,
+      is_xsize_larger);
 #endif
-    return;
-  }
-  if (post == 1) {
-    functor.RunRowWise(n, pre);
-    return;
-  } else {
-    functor.RunMidWise(n, pre, post);
-    return;
-  }
 }
 
 // FusedElemwiseAndAct
@@ -0,0 +1,154 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>  // NOLINT
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/operators/elementwise/elementwise_op_function.h"
+
+namespace paddle {
+namespace operators {
+
+template <typename T>
+struct TestDivFunctor {
+  inline T operator()(T a, T b) const { return a / b; }
+};
+
+template <typename T>
+struct TestDivGradDX {
+  inline T operator()(T x, T y, T out, T dout) const { return dout / y; }
+};
+
+template <typename T>
+struct TestDivGradDY {
+  inline T operator()(T x, T y, T out, T dout) const {
+    return -dout * out / y;
+  }
+};
+
+static void RandomFill(framework::Tensor *tensor, float low) {
+  static std::mt19937 rng(100);
+  std::uniform_real_distribution<float> dist(low, low + 1.0f);
+  float *data = tensor->data<float>();
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = dist(rng);
+  }
+}
+
+// Compare the broadcast results with the element by element reference.
+static void TestBroadcast(const std::vector<int> &x_dims,
+                          const std::vector<int> &y_dims) {
+  platform::CPUPlace place;
+  platform::CPUDeviceContext ctx(place);
+  int max_dim = x_dims.size();
+  std::vector<int> x_dims_array(x_dims), y_dims_array(y_dims);
+  std::vector<int> out_dims_array(max_dim);
+  for (int i = 0; i < max_dim; ++i) {
+    out_dims_array[i] = std::max(x_dims[i], y_dims[i]);
+  }
+
+  framework::Tensor x, y, out, dout, dx, dy;
+  x.mutable_data<float>(framework::make_ddim(x_dims), place);
+  y.mutable_data<float>(framework::make_ddim(y_dims), place);
+  dout.mutable_data<float>(framework::make_ddim(out_dims_array), place);
+  out.Resize(framework::make_ddim(out_dims_array));
+  dx.Resize(x.dims());
+  dy.Resize(y.dims());
+  RandomFill(&x, -0.5f);
+  RandomFill(&y, 1.0f);
+  RandomFill(&dout, -0.5f);
+
+  CommonForwardBroadcastCPU<TestDivFunctor<float>, float>(
+      &x, &y, &out, x_dims_array.data(), y_dims_array.data(),
+      out_dims_array.data(), max_dim, ctx, TestDivFunctor<float>());
+  CommonGradBroadcastCPU<float>(x, y, out, dout, &dx, &dy, x_dims_array.data(),
+                                y_dims_array.data(), out_dims_array.data(),
+                                max_dim, ctx, TestDivGradDX<float>(),
+                                TestDivGradDY<float>());
+
+  std::vector<double> expect_dx(x.numel(), 0), expect_dy(y.numel(), 0);
+  std::vector<int> index_array(max_dim, 0);
+  for (int64_t i = 0; i < out.numel(); ++i) {
+    int x_index =
+        GetElementwiseIndex(x_dims_array.data(), max_dim, index_array.data());
+    int y_index =
+        GetElementwiseIndex(y_dims_array.data(), max_dim, index_array.data());
+    float x_val = x.data<float>()[x_index];
+    float y_val = y.data<float>()[y_index];
+    float out_val = x_val / y_val;
+    float dout_val = dout.data<float>()[i];
+    EXPECT_NEAR(out.data<float>()[i], out_val, 1e-5);
+    expect_dx[x_index] += dout_val / y_val;
+    expect_dy[y_index] += -dout_val * out_val / y_val;
+    UpdateElementwiseIndexArray(out_dims_array.data(), max_dim,
+                                index_array.data());
+  }
+  for (int64_t i = 0; i < dx.numel(); ++i) {
+    EXPECT_NEAR(dx.data<float>()[i], expect_dx[i], 1e-3);
+  }
+  for (int64_t i = 0; i < dy.numel(); ++i) {
+    EXPECT_NEAR(dy.data<float>()[i], expect_dy[i], 1e-3);
+  }
+}
+
+TEST(ElementwiseBroadcastCPU, shapes) {
+  // per-channel
+  TestBroadcast({2, 3, 4, 5}, {1, 3, 1, 1});
+  // the trailing dims
+  TestBroadcast({2, 3, 4, 5}, {1, 1, 4, 5});
+  // the leading dims
+  TestBroadcast({2, 3, 4, 5}, {2, 3, 1, 1});
+  // both X and Y are broadcast
+  TestBroadcast({2, 3, 1, 5}, {2, 1, 4, 1});
+  TestBroadcast({1, 1, 4}, {2, 3, 4});
+  TestBroadcast({8, 1}, {1, 9});
+  // attention mask
+  TestBroadcast({4, 8, 64, 64}, {4, 1, 1, 64});
+  // large enough to run in parallel
+  TestBroadcast({16, 64, 32, 32}, {1, 64, 1, 1});
+  TestBroadcast({1, 1}, {1, 1});
+}
+
+TEST(ElementwiseBroadcastCPU, benchmark) {
+  platform::CPUPlace place;
+  platform::CPUDeviceContext ctx(place);
+  std::vector<int> x_dims_array = {32, 64, 56, 56};
+  std::vector<int> y_dims_array = {1, 64, 1, 1};
+  std::vector<int> out_dims_array = x_dims_array;
+
+  framework::Tensor x, y, out;
+  x.mutable_data<float>(framework::make_ddim(x_dims_array), place);
+  y.mutable_data<float>(framework::make_ddim(y_dims_array), place);
+  out.Resize(x.dims());
+  RandomFill(&x, -0.5f);
+  RandomFill(&y, 1.0f);
+
+  const int kRepeat = 10;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kRepeat; ++i) {
+    CommonForwardBroadcastCPU<TestDivFunctor<float>, float>(
+        &x, &y, &out, x_dims_array.data(), y_dims_array.data(),
+        out_dims_array.data(), 4, ctx, TestDivFunctor<float>());
+  }
+  double ms = std::chrono::duration<double, std::milli>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+  LOG(INFO) << "Broadcast [32, 64, 56, 56] / [1, 64, 1, 1] costs "
+            << ms / kRepeat << " ms";
+}
+
+}  // namespace operators
+}  // namespace paddle
@@ -14,10 +14,12 @@ limitations under the License. */
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/operators/math/fc.h"
+#include "paddle/fluid/operators/math/packed_weights_cache.h"
 
 namespace paddle {
 namespace operators {
@@ -49,6 +51,49 @@ inline void FCOutputSize(const framework::DDim& in_dims,
   out_dims.push_back(w_dims1);
 }
 
+// Compute fc with the weights packed ahead or in int8 on CPU in float, which
+// are set by the inference passes. Return false if it is not computed.
+template <typename DeviceContext, typename T>
+inline bool ComputeFCOnCPU(const framework::ExecutionContext& ctx,
+                           const DeviceContext& dev_ctx, const int M,
+                           const T* X, const Tensor& w, T* Y, const T* B,
+                           bool with_relu) {
+  return false;
+}
+
+template <>
+inline bool ComputeFCOnCPU<platform::CPUDeviceContext, float>(
+    const framework::ExecutionContext& ctx,
+    const platform::CPUDeviceContext& dev_ctx, const int M, const float* X,
+    const Tensor& w, float* Y, const float* B, bool with_relu) {
+  if (ctx.Attr<bool>("padding_weights")) {
+    return false;
+  }
+  // The weights marked by gemm_weight_prepack_pass are packed once.
+  bool prepacked = ctx.HasAttr("use_prepacked_weight") &&
+                   ctx.Attr<bool>("use_prepacked_weight");
+  // Only run in int8 if AnalysisConfig::EnableCpuInt8Gemm is set, where
+  // gemm_weight_prepack_pass has packed the weights in int8 with the scales
+  // set by quant_conv2d_dequant_fuse_pass.
+  bool int8 = prepacked && ctx.HasAttr("use_int8_gemm") &&
+              ctx.Attr<bool>("use_int8_gemm");
+  if (int8) {
+    auto packed_w = math::PackedWeightsCache::Instance().GetInt8(
+        w, ctx.Attr<std::vector<float>>("weight_scale"));
+    math::FCInt8Functor fc;
+    fc(dev_ctx, M, X, ctx.Attr<float>("Input_scale"), *packed_w, Y, B,
+       with_relu);
+    return true;
+  }
+  if (prepacked) {
+    auto packed_w = math::PackedWeightsCache::Instance().GetFloat(w);
+    math::FCPackedFunctor fc;
+    fc(dev_ctx, M, X, *packed_w, Y, B, with_relu);
+    return true;
+  }
+  return false;
+}
+
 template <typename DeviceContext, typename T>
 class FCOpKernel : public framework::OpKernel<T> {
  public:
@@ -80,9 +125,14 @@ class FCOpKernel : public framework::OpKernel<T> {
     T* output_data = output->mutable_data<T>(ctx.GetPlace());
 
     auto& dev_ctx = ctx.template device_context<DeviceContext>();
+    const T* bias_data = bias ? bias->data<T>() : NULL;
+    if (ComputeFCOnCPU(ctx, dev_ctx, M, input_data, *w, output_data,
+                       bias_data, with_relu)) {
+      return;
+    }
     math::FCFunctor<DeviceContext, T> fc;
     fc(dev_ctx, M, w_dims1, w_dims0, input_data, w_data, output_data,
-       bias ? bias->data<T>() : NULL, with_relu, padding_weights);
+       bias_data, with_relu, padding_weights);
   }
 };
 
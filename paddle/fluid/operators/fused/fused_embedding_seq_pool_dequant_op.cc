@@ -0,0 +1,171 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <cstring>
+#include <string>
+
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/math/embedding_gather.h"
+#include "paddle/fluid/operators/math/embedding_quant.h"
+
+namespace paddle {
+namespace operators {
+
+using LoDTensor = framework::LoDTensor;
+
+class FusedEmbeddingSeqPoolDequantOp : public framework::OperatorWithKernel {
+ public:
+  using framework::OperatorWithKernel::OperatorWithKernel;
+
+  void InferShape(framework::InferShapeContext* ctx) const override {
+    OP_INOUT_CHECK(ctx->HasInput("W"), "Input", "W",
+                   "FusedEmbeddingSeqPoolDequant");
+    OP_INOUT_CHECK(ctx->HasInput("Ids"), "Input", "Ids",
+                   "FusedEmbeddingSeqPoolDequant");
+    OP_INOUT_CHECK(ctx->HasOutput("Out"), "Output", "Out",
+                   "FusedEmbeddingSeqPoolDequant");
+    auto table_dims = ctx->GetInputDim("W");
+    PADDLE_ENFORCE_EQ(table_dims.size(), 2,
+                      platform::errors::InvalidArgument(
+                          "The dim size of the input tensor 'W' should be 2. "
+                          "But received W's size = %d.",
+                          table_dims.size()));
+    PADDLE_ENFORCE_GT(table_dims[1], math::kQuantEmbeddingHeadWidth,
+                      platform::errors::InvalidArgument(
+                          "The second dim of the quantized table should be "
+                          "greater than 2, but the actual shape is [%s].",
+                          table_dims));
+    const std::string& combiner = ctx->Attrs().Get<std::string>("combiner");
+    PADDLE_ENFORCE_EQ(combiner, "sum",
+                      platform::errors::Unimplemented(
+                          "The pooling type of sequence_pool only support sum "
+                          "now. So the 'combiner' must be 'sum'."));
+    // The batch size is known from the LoD of Ids at runtime only.
+    ctx->SetOutputDim("Out",
+                      {-1, math::DequantEmbeddingWidth(table_dims[1])});
+  }
+
+ protected:
+  framework::OpKernelType GetExpectedKernelType(
+      const framework::ExecutionContext& ctx) const override {
+    auto data_type = OperatorWithKernel::IndicateVarDataType(ctx, "W");
+    return framework::OpKernelType(data_type, ctx.device_context());
+  }
+};
+
+class FusedEmbeddingSeqPoolDequantOpMaker
+    : public framework::OpProtoAndCheckerMaker {
+ public:
+  void Make() override {
+    AddInput("W",
+             "(Tensor) The embedding table quantized per row, whose layout "
+             "is the same as the one of lookup_table_dequant.");
+    AddInput("Ids",
+             "(LoDTensor) The int64 ids to be looked up in W, whose LoD level "
+             "is 1, and each position holds one id.");
+    AddOutput("Out", "The pooled embeddings of each sequence of Ids.");
+    AddAttr<std::string>("combiner",
+                         "(string, default sum) "
+                         "A string specifying the reduction op. Currently sum "
+                         "are supported.")
+        .SetDefault("sum");
+    AddAttr<int64_t>("padding_idx",
+                     "(int64, default -1) "
+                     "If the value is -1, it makes no effect to lookup. "
+                     "Otherwise the given value indicates padding the output "
+                     "with zeros whenever lookup encounters it in Ids.")
+        .SetDefault(-1);
+    AddComment(R"DOC(
+FusedEmbeddingSeqPoolDequant Operator.
+
+The inference version of fused_embedding_seq_pool, whose parameter W is
+quantized to 8 bits per row for the sake of saving memories. The rows of each
+sequence of Ids are dequantized and summed up in one step, without
+materializing the dequantized embeddings.
+
+)DOC");
+  }
+};
+
+template <typename T>
+class FusedEmbeddingSeqPoolDequantKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext& ctx) const override {
+    auto* ids_t = ctx.Input<LoDTensor>("Ids");
+    auto* table_t = ctx.Input<LoDTensor>("W");
+    auto* output_t = ctx.Output<LoDTensor>("Out");
+    int64_t padding_idx = ctx.Attr<int64_t>("padding_idx");
+
+    PADDLE_ENFORCE_EQ(ids_t->lod().size(), 1UL,
+                      platform::errors::InvalidArgument(
+                          "The LoD level of Input(Ids) should be 1. But "
+                          "received Ids's LoD level = %d.",
+                          ids_t->lod().size()));
+    const auto& lod = ids_t->lod()[0];
+    PADDLE_ENFORCE_EQ(static_cast<size_t>(ids_t->numel()), lod.back(),
+                      platform::errors::InvalidArgument(
+                          "Each position of Input(Ids) should hold only one "
+                          "id, but there are %d ids and %d positions.",
+                          ids_t->numel(), lod.back()));
+    const int64_t height = table_t->dims()[0];
+    const int64_t quant_width = table_t->dims()[1];
+    const int64_t width = math::DequantEmbeddingWidth(quant_width);
+    const int64_t* ids = ids_t->data<int64_t>();
+    for (int64_t i = 0; i < ids_t->numel(); ++i) {
+      if (ids[i] == padding_idx) continue;
+      PADDLE_ENFORCE_EQ(
+          ids[i] >= 0 && ids[i] < height, true,
+          platform::errors::InvalidArgument(
+              "Variable value (input) of OP(fused_embedding_seq_pool_dequant) "
+              "expected >= 0 and < %ld, but got %ld. Please check input "
+              "value.",
+              height, ids[i]));
+    }
+
+    const int64_t batch_size = static_cast<int64_t>(lod.size()) - 1;
+    output_t->Resize({batch_size, width});
+    T* output = output_t->mutable_data<T>(ctx.GetPlace());
+    const float* table = table_t->data<float>();
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (ids_t->numel() * width > \
+                             math::kEmbeddingParallelThreshold)
+#endif
+    for (int64_t i = 0; i < batch_size; ++i) {
+      T* dst = output + i * width;
+      std::memset(dst, 0, width * sizeof(T));
+      int64_t end = static_cast<int64_t>(lod[i + 1]);
+      for (int64_t j = static_cast<int64_t>(lod[i]); j < end; ++j) {
+        int64_t next = j + math::kEmbeddingPrefetchDistance;
+        if (next < ids_t->numel() && ids[next] != padding_idx) {
+          math::PrefetchRow(table + ids[next] * quant_width, quant_width);
+        }
+        if (ids[j] == padding_idx) continue;
+        math::DequantAddRow(table + ids[j] * quant_width, 0, width, dst);
+      }
+    }
+  }
+};
+
+}  // namespace operators
+}  // namespace paddle
+
+namespace ops = paddle::operators;
+REGISTER_OPERATOR(
+    fused_embedding_seq_pool_dequant, ops::FusedEmbeddingSeqPoolDequantOp,
+    ops::FusedEmbeddingSeqPoolDequantOpMaker,
+    paddle::framework::EmptyGradOpMaker<paddle::framework::OpDesc>,
+    paddle::framework::EmptyGradOpMaker<paddle::imperative::OpBase>);
+REGISTER_OP_CPU_KERNEL(fused_embedding_seq_pool_dequant,
+                       ops::FusedEmbeddingSeqPoolDequantKernel<float>);
@@ -0,0 +1,242 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/math/embedding_quant.h"
+
+USE_CPU_ONLY_OP(fused_embedding_seq_pool_dequant);
+USE_CPU_ONLY_OP(lookup_table_dequant);
+USE_CPU_ONLY_OP(fused_embedding_seq_pool);
+USE_OP(lookup_table);
+USE_OP(sequence_pool);
+
+namespace paddle {
+namespace operators {
+
+using OperatorPtr = std::unique_ptr<framework::OperatorBase>;
+
+// Feed the float table W, its quantized version W_quant, and the ids, whose
+// last dim is 1 as lookup_table_dequant requires.
+static void Feed(int64_t batch_size, int64_t height, int64_t width,
+                 framework::Scope* scope) {
+  std::mt19937 rng(100);
+  std::uniform_real_distribution<float> value_dist(-1.0f, 1.0f);
+  std::uniform_int_distribution<int64_t> length_dist(0, 4);
+  std::uniform_real_distribution<double> id_dist(0.0, 1.0);
+
+  auto* table = scope->Var("W")->GetMutable<framework::LoDTensor>();
+  float* table_data =
+      table->mutable_data<float>({height, width}, platform::CPUPlace());
+  for (int64_t i = 0; i < table->numel(); ++i) {
+    table_data[i] = value_dist(rng);
+  }
+  auto* quant_table = scope->Var("W_quant")->GetMutable<framework::LoDTensor>();
+  math::QuantizeEmbedding(
+      table_data, height, width,
+      quant_table->mutable_data<float>(
+          {height, math::QuantEmbeddingWidth(width)}, platform::CPUPlace()));
+
+  framework::LoD lod(1, {0});
+  for (int64_t b = 0; b < batch_size; ++b) {
+    lod[0].push_back(lod[0].back() + length_dist(rng));
+  }
+  auto* ids = scope->Var("ids")->GetMutable<framework::LoDTensor>();
+  ids->set_lod(lod);
+  int64_t* ids_data = ids->mutable_data<int64_t>(
+      {static_cast<int64_t>(lod[0].back()), 1}, platform::CPUPlace());
+  for (int64_t i = 0; i < ids->numel(); ++i) {
+    // The ids of CTR models follow a power law.
+    ids_data[i] =
+        static_cast<int64_t>(std::pow(id_dist(rng), 3.0) * (height - 1));
+  }
+}
+
+static std::vector<OperatorPtr> FusedProgram(int64_t padding_idx) {
+  std::vector<OperatorPtr> ops;
+  ops.emplace_back(framework::OpRegistry::CreateOp(
+      "fused_embedding_seq_pool_dequant",
+      {{"W", {"W_quant"}}, {"Ids", {"ids"}}}, {{"Out", {"fused_out"}}},
+      {{"combiner", std::string("sum")}, {"padding_idx", padding_idx}}));
+  return ops;
+}
+
+static std::vector<OperatorPtr> UnfusedProgram(int64_t padding_idx) {
+  std::vector<OperatorPtr> ops;
+  ops.emplace_back(framework::OpRegistry::CreateOp(
+      "lookup_table_dequant", {{"W", {"W_quant"}}, {"Ids", {"ids"}}},
+      {{"Out", {"emb"}}}, {{"padding_idx", padding_idx}}));
+  ops.emplace_back(framework::OpRegistry::CreateOp(
+      "sequence_pool", {{"X", {"emb"}}},
+      {{"Out", {"unfused_out"}}, {"MaxIndex", {"max_index"}}},
+      {{"pooltype", std::string("SUM")}}));
+  return ops;
+}
+
+// The float programs the quantized ones replace.
+static std::vector<OperatorPtr> FloatFusedProgram(int64_t padding_idx) {
+  std::vector<OperatorPtr> ops;
+  ops.emplace_back(framework::OpRegistry::CreateOp(
+      "fused_embedding_seq_pool", {{"W", {"W"}}, {"Ids", {"ids"}}},
+      {{"Out", {"float_fused_out"}}},
+      {{"combiner", std::string("sum")}, {"padding_idx", padding_idx}}));
+  return ops;
+}
+
+static std::vector<OperatorPtr> FloatUnfusedProgram(int64_t padding_idx) {
+  std::vector<OperatorPtr> ops;
+  ops.emplace_back(framework::OpRegistry::CreateOp(
+      "lookup_table", {{"W", {"W"}}, {"Ids", {"ids"}}},
+      {{"Out", {"float_emb"}}}, {{"padding_idx", padding_idx}}));
+  ops.emplace_back(framework::OpRegistry::CreateOp(
+      "sequence_pool", {{"X", {"float_emb"}}},
+      {{"Out", {"float_unfused_out"}}, {"MaxIndex", {"float_max_index"}}},
+      {{"pooltype", std::string("SUM")}}));
+  return ops;
+}
+
+static void RunOps(const std::vector<OperatorPtr>& ops,
+                   framework::Scope* scope) {
+  for (auto& op : ops) {
+    for (auto& output : op->Outputs()) {
+      for (auto& name : output.second) {
+        scope->Var(name)->GetMutable<framework::LoDTensor>();
+      }
+    }
+    op->Run(*scope, platform::CPUPlace());
+  }
+}
+
+static void TestDequant(int64_t batch_size, int64_t height, int64_t width,
+                        int64_t padding_idx) {
+  framework::Scope scope;
+  Feed(batch_size, height, width, &scope);
+  RunOps(FusedProgram(padding_idx), &scope);
+  RunOps(UnfusedProgram(padding_idx), &scope);
+
+  auto& fused_out = scope.FindVar("fused_out")->Get<framework::LoDTensor>();
+  auto& unfused_out =
+      scope.FindVar("unfused_out")->Get<framework::LoDTensor>();
+  ASSERT_EQ(fused_out.dims(), framework::make_ddim({batch_size, width}));
+  ASSERT_EQ(fused_out.dims(), unfused_out.dims());
+  for (int64_t i = 0; i < fused_out.numel(); ++i) {
+    EXPECT_NEAR(fused_out.data<float>()[i], unfused_out.data<float>()[i],
+                1e-5);
+  }
+
+  // Each element is off by at most one step of its row from the float
+  // table, where a step is 2 / 255 at most.
+  auto& table = scope.FindVar("W")->Get<framework::LoDTensor>();
+  auto& ids = scope.FindVar("ids")->Get<framework::LoDTensor>();
+  const auto& lod = ids.lod()[0];
+  for (int64_t i = 0; i < batch_size; ++i) {
+    std::vector<float> expected(width, 0.0f);
+    for (size_t j = lod[i]; j < lod[i + 1]; ++j) {
+      int64_t id = ids.data<int64_t>()[j];
+      if (id == padding_idx) continue;
+      for (int64_t k = 0; k < width; ++k) {
+        expected[k] += table.data<float>()[id * width + k];
+      }
+    }
+    float tolerance = (lod[i + 1] - lod[i]) * 2.0f / 255.0f + 1e-5f;
+    for (int64_t k = 0; k < width; ++k) {
+      EXPECT_NEAR(fused_out.data<float>()[i * width + k], expected[k],
+                  tolerance);
+    }
+  }
+}
+
+TEST(FusedEmbeddingSeqPoolDequant, CompareWithUnfused) {
+  for (int64_t padding_idx : {-1, 0}) {
+    TestDequant(/*batch_size=*/16, /*height=*/100, /*width=*/12, padding_idx);
+  }
+  // Large enough to run in parallel
+  TestDequant(2048, 10000, 64, -1);
+}
+
+// The kernel picked for the CPU adds the same values as the reference one,
+// for the ranges not aligned to the registers as well.
+TEST(FusedEmbeddingSeqPoolDequant, DequantAddRowKernel) {
+  std::mt19937 rng(100);
+  std::uniform_real_distribution<float> value_dist(-1.0f, 1.0f);
+  const int64_t width = 100;
+  std::vector<float> row(width);
+  for (auto& value : row) {
+    value = value_dist(rng);
+  }
+  std::vector<float> quant_row(math::QuantEmbeddingWidth(width));
+  math::QuantizeEmbeddingRow(row.data(), width, quant_row.data());
+
+  for (int64_t begin : {0, 1, 5}) {
+    for (int64_t end = begin; end <= width; ++end) {
+      std::vector<float> expected(end - begin, 0.5f);
+      std::vector<float> out(end - begin, 0.5f);
+      math::DequantAddRowRef(quant_row.data(), begin, end, expected.data());
+      math::DequantAddRow(quant_row.data(), begin, end, out.data());
+      for (int64_t i = 0; i < end - begin; ++i) {
+        ASSERT_NEAR(out[i], expected[i], 1e-6) << begin << " " << end;
+      }
+    }
+  }
+}
+
+// The latency of the quantized lookups and pooling against the float ones,
+// and the memory of the tables.
+TEST(FusedEmbeddingSeqPoolDequant, Benchmark) {
+  const int kRepeat = 10;
+  for (int64_t width : {16, 64}) {
+    framework::Scope scope;
+    Feed(4096, 1 << 18, width, &scope);
+    auto time_ms = [&scope](const std::vector<OperatorPtr>& ops) {
+      // Warm up
+      RunOps(ops, &scope);
+      auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < kRepeat; ++i) {
+        RunOps(ops, &scope);
+      }
+      return std::chrono::duration<double, std::milli>(
+                 std::chrono::steady_clock::now() - start)
+                 .count() /
+             kRepeat;
+    };
+    double float_unfused_ms = time_ms(FloatUnfusedProgram(-1));
+    double float_fused_ms = time_ms(FloatFusedProgram(-1));
+    double unfused_ms = time_ms(UnfusedProgram(-1));
+    double fused_ms = time_ms(FusedProgram(-1));
+
+    auto table_mb = [&scope](const std::string& name) {
+      const auto& table = scope.FindVar(name)->Get<framework::LoDTensor>();
+      return table.numel() * sizeof(float) / 1024.0 / 1024.0;
+    };
+    LOG(INFO) << "Lookup and pool of width " << width << ", float table "
+              << table_mb("W") << " MB, quantized table "
+              << table_mb("W_quant") << " MB";
+    LOG(INFO) << "  float lookup_table + sequence_pool: " << float_unfused_ms
+              << " ms, fused_embedding_seq_pool: " << float_fused_ms << " ms";
+    LOG(INFO) << "  quantized lookup_table_dequant + sequence_pool: "
+              << unfused_ms
+              << " ms, fused_embedding_seq_pool_dequant: " << fused_ms
+              << " ms";
+  }
+}
+
+}  // namespace operators
+}  // namespace paddle
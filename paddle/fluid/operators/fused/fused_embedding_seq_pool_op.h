@@ -24,6 +24,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/selected_rows.h"
 #include "paddle/fluid/operators/jit/kernels.h"
 #include "paddle/fluid/operators/math/blas.h"
+#include "paddle/fluid/operators/math/embedding_gather.h"
 
 namespace paddle {
 namespace operators {
@@ -102,16 +103,8 @@ struct EmbeddingVSumFunctor {
                           "But received the ids's LoD[0] = %d.",
                           ids_lod.size()));
 
-    jit::emb_seq_pool_attr_t attr(table_height, table_width, 0, idx_width,
-                                  out_width, jit::SeqPoolType::kSum);
-    for (size_t i = 0; i != ids_lod.size() - 1; ++i) {
-      attr.index_height = ids_lod[i + 1] - ids_lod[i];
-      auto emb_seqpool =
-          jit::KernelFuncs<jit::EmbSeqPoolTuple<T>, platform::CPUPlace>::Cache()
-              .At(attr);
-      emb_seqpool(table, ids + ids_lod[i] * idx_width, output + i * out_width,
-                  &attr);
-    }
+    math::EmbeddingSeqPool(table, table_height, table_width, ids, ids_lod,
+                           idx_width, out_width, output);
   }
 };
 #endif
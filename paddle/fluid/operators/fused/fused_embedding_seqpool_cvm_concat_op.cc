@@ -0,0 +1,203 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/fused/fused_embedding_seqpool_cvm_concat_op.h"
+
+#include <memory>
+#include <string>
+
+namespace paddle {
+namespace operators {
+
+class FusedEmbeddingSeqPoolCVMConcatOp
+    : public framework::OperatorWithKernel {
+ public:
+  using framework::OperatorWithKernel::OperatorWithKernel;
+
+  void InferShape(framework::InferShapeContext* ctx) const override {
+    OP_INOUT_CHECK(ctx->HasInput("W"), "Input", "W",
+                   "FusedEmbeddingSeqPoolCVMConcat");
+    OP_INOUT_CHECK(ctx->HasInputs("Ids"), "Input", "Ids",
+                   "FusedEmbeddingSeqPoolCVMConcat");
+    OP_INOUT_CHECK(ctx->HasInput("CVM"), "Input", "CVM",
+                   "FusedEmbeddingSeqPoolCVMConcat");
+    OP_INOUT_CHECK(ctx->HasOutput("Out"), "Output", "Out",
+                   "FusedEmbeddingSeqPoolCVMConcat");
+
+    auto table_dims = ctx->GetInputDim("W");
+    PADDLE_ENFORCE_EQ(table_dims.size(), 2,
+                      platform::errors::InvalidArgument(
+                          "The dim size of the input tensor 'W' should be 2. "
+                          "But received W's size = %d.",
+                          table_dims.size()));
+    bool use_cvm = ctx->Attrs().Get<bool>("use_cvm");
+    int64_t width = ctx->Attrs().Get<bool>("is_quantized")
+                        ? math::DequantEmbeddingWidth(table_dims[1])
+                        : table_dims[1];
+    PADDLE_ENFORCE_GT(
+        width, use_cvm ? kCVMColumns - 1 : kCVMColumns,
+        platform::errors::InvalidArgument(
+            "The width of the embedding should hold the show and click "
+            "columns, but received %d.",
+            width));
+    auto cvm_dims = ctx->GetInputDim("CVM");
+    PADDLE_ENFORCE_EQ(cvm_dims.size(), 2,
+                      platform::errors::InvalidArgument(
+                          "The dim size of the input tensor 'CVM' should be 2. "
+                          "But received CVM's size = %d.",
+                          cvm_dims.size()));
+    PADDLE_ENFORCE_EQ(cvm_dims[1], kCVMColumns,
+                      platform::errors::InvalidArgument(
+                          "The 2nd dimension of Input(CVM) should be 2, but "
+                          "received %d.",
+                          cvm_dims[1]));
+
+    // The batch size is known from the LoD of Ids at runtime only.
+    int64_t num_slots = static_cast<int64_t>(ctx->Inputs("Ids").size());
+    int64_t out_width = use_cvm ? width : width - kCVMColumns;
+    ctx->SetOutputDim("Out", {-1, num_slots * out_width});
+  }
+
+ protected:
+  framework::OpKernelType GetExpectedKernelType(
+      const framework::ExecutionContext& ctx) const override {
+    auto data_type = OperatorWithKernel::IndicateVarDataType(ctx, "W");
+    return framework::OpKernelType(data_type, ctx.device_context());
+  }
+};
+
+class FusedEmbeddingSeqPoolCVMConcatOpMaker
+    : public framework::OpProtoAndCheckerMaker {
+ public:
+  void Make() override {
+    AddInput("W",
+             "(Tensor) The embedding table shared by all the slots, whose "
+             "first two columns are show and click.");
+    AddInput("Ids",
+             "(LoDTensor) The int64 ids of each slot to be looked up in W, "
+             "whose LoD level is 1.")
+        .AsDuplicable();
+    AddInput("CVM",
+             "(Tensor), a 2-D Tensor with shape [N x 2], where N is the batch "
+             "size, 2 is show and click.");
+    AddOutput("Out",
+              "(LoDTensor) The concatenation of the pooled embeddings of all "
+              "the slots, whose shape is [N x (num_slots * K)].");
+    AddAttr<bool>("use_cvm", "bool, use cvm or not").SetDefault(true);
+    AddAttr<int64_t>("padding_idx",
+                     "(int64, default -1) "
+                     "If the value is -1, it makes no effect to lookup. "
+                     "Otherwise the given value indicates padding the output "
+                     "with zeros whenever lookup encounters it in Ids.")
+        .SetDefault(-1);
+    AddAttr<bool>("is_sparse",
+                  "(boolean, default false) "
+                  "Sparse update.")
+        .SetDefault(false);
+    AddAttr<bool>("is_quantized",
+                  "(boolean, default false) "
+                  "Whether W is quantized per row as lookup_table_dequant "
+                  "expects, which is for inference only.")
+        .SetDefault(false);
+    AddComment(R"DOC(
+FusedEmbeddingSeqPoolCVMConcat Operator.
+
+Fuse the lookup_table, sequence_pool(SUM) and cvm operators of all the slots
+which share the embedding table W, and the concat operator of their outputs.
+For the i-th instance of the j-th slot, the embeddings of its ids are summed
+up, transformed as the cvm operator does, and written into the j-th block of
+the i-th row of Out.
+
+)DOC");
+  }
+};
+
+class FusedEmbeddingSeqPoolCVMConcatOpGrad
+    : public framework::OperatorWithKernel {
+ public:
+  using framework::OperatorWithKernel::OperatorWithKernel;
+
+  void InferShape(framework::InferShapeContext* ctx) const override {
+    auto table_dims = ctx->GetInputDim("W");
+    ctx->SetOutputDim(framework::GradVarName("W"), table_dims);
+  }
+
+ protected:
+  framework::OpKernelType GetExpectedKernelType(
+      const framework::ExecutionContext& ctx) const override {
+    auto data_type = OperatorWithKernel::IndicateVarDataType(ctx, "W");
+    return framework::OpKernelType(data_type, ctx.device_context());
+  }
+};
+
+class FusedEmbeddingSeqPoolCVMConcatOpGradVarTypeInference
+    : public framework::VarTypeInference {
+ public:
+  void operator()(framework::InferVarTypeContext* ctx) const override {
+    auto out_var_name = framework::GradVarName("W");
+    auto attr = ctx->GetAttr("is_sparse");
+    bool is_sparse = BOOST_GET(bool, attr);
+    if (is_sparse) {
+      VLOG(3) << "fused_embedding_seqpool_cvm_concat_grad op "
+              << framework::GradVarName("W") << " is set to SelectedRows";
+      ctx->SetOutputType(out_var_name,
+                         framework::proto::VarType::SELECTED_ROWS);
+    } else {
+      VLOG(3) << "fused_embedding_seqpool_cvm_concat_grad op "
+              << framework::GradVarName("W") << " is set to LoDTensor";
+      ctx->SetOutputType(out_var_name, framework::proto::VarType::LOD_TENSOR);
+    }
+    ctx->SetOutputDataType(out_var_name, ctx->GetInputDataType("W"));
+  }
+};
+
+template <typename T>
+class FusedEmbeddingSeqPoolCVMConcatGradOpMaker
+    : public framework::SingleGradOpMaker<T> {
+ public:
+  using framework::SingleGradOpMaker<T>::SingleGradOpMaker;
+
+ protected:
+  void Apply(GradOpPtr<T> op) const override {
+    op->SetType("fused_embedding_seqpool_cvm_concat_grad");
+    op->SetInput("Ids", this->Input("Ids"));
+    op->SetInput("W", this->Input("W"));
+    op->SetInput("CVM", this->Input("CVM"));
+    op->SetInput(framework::GradVarName("Out"), this->OutputGrad("Out"));
+    op->SetOutput(framework::GradVarName("W"), this->InputGrad("W"));
+    op->SetAttrMap(this->Attrs());
+  }
+};
+
+}  // namespace operators
+}  // namespace paddle
+
+namespace ops = paddle::operators;
+
+REGISTER_OPERATOR(
+    fused_embedding_seqpool_cvm_concat, ops::FusedEmbeddingSeqPoolCVMConcatOp,
+    ops::FusedEmbeddingSeqPoolCVMConcatOpMaker,
+    ops::FusedEmbeddingSeqPoolCVMConcatGradOpMaker<paddle::framework::OpDesc>,
+    ops::FusedEmbeddingSeqPoolCVMConcatGradOpMaker<
+        paddle::imperative::OpBase>);
+REGISTER_OPERATOR(fused_embedding_seqpool_cvm_concat_grad,
+                  ops::FusedEmbeddingSeqPoolCVMConcatOpGrad,
+                  ops::FusedEmbeddingSeqPoolCVMConcatOpGradVarTypeInference);
+
+REGISTER_OP_CPU_KERNEL(fused_embedding_seqpool_cvm_concat,
+                       ops::FusedEmbeddingSeqPoolCVMConcatKernel<float>,
+                       ops::FusedEmbeddingSeqPoolCVMConcatKernel<double>);
+REGISTER_OP_CPU_KERNEL(fused_embedding_seqpool_cvm_concat_grad,
+                       ops::FusedEmbeddingSeqPoolCVMConcatGradKernel<float>,
+                       ops::FusedEmbeddingSeqPoolCVMConcatGradKernel<double>);
@@ -0,0 +1,289 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/selected_rows.h"
+#include "paddle/fluid/operators/jit/kernels.h"
+#include "paddle/fluid/operators/math/embedding_gather.h"
+#include "paddle/fluid/operators/math/embedding_quant.h"
+
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
+namespace paddle {
+namespace operators {
+
+using Tensor = framework::Tensor;
+using LoDTensor = framework::LoDTensor;
+using SelectedRows = framework::SelectedRows;
+
+// The columns of each embedding row are [show, click, embedding...]. The
+// first two columns are transformed by log if use_cvm, otherwise dropped.
+constexpr int64_t kCVMColumns = 2;
+
+// Check the ids of all the slots, and return the offsets of the slots in the
+// concatenation of their ids.
+inline std::vector<int64_t> CheckSlotIds(
+    const std::vector<const LoDTensor *> &ids, int64_t table_height,
+    int64_t padding_idx, size_t *batch_size) {
+  PADDLE_ENFORCE_GT(ids.size(), 0UL,
+                    platform::errors::InvalidArgument(
+                        "The number of the Input(Ids) should be greater than "
+                        "0, but received 0."));
+  std::vector<int64_t> slot_offset(ids.size() + 1, 0);
+  for (size_t s = 0; s < ids.size(); ++s) {
+    PADDLE_ENFORCE_EQ(ids[s]->lod().size(), 1UL,
+                      platform::errors::InvalidArgument(
+                          "The LoD level of the %d-th Input(Ids) should be 1, "
+                          "but received %d.",
+                          s, ids[s]->lod().size()));
+    const auto &lod = ids[s]->lod()[0];
+    if (s == 0) {
+      *batch_size = lod.size() - 1;
+    }
+    PADDLE_ENFORCE_EQ(lod.size() - 1, *batch_size,
+                      platform::errors::InvalidArgument(
+                          "The batch size of all the Input(Ids) should be "
+                          "equal, but the %d-th one is %d, and the first one "
+                          "is %d.",
+                          s, lod.size() - 1, *batch_size));
+    PADDLE_ENFORCE_EQ(static_cast<size_t>(ids[s]->numel()), lod.back(),
+                      platform::errors::InvalidArgument(
+                          "Each position of the %d-th Input(Ids) should hold "
+                          "only one id, but there are %d ids and %d "
+                          "positions.",
+                          s, ids[s]->numel(), lod.back()));
+    const int64_t *ids_data = ids[s]->data<int64_t>();
+    for (int64_t i = 0; i < ids[s]->numel(); ++i) {
+      if (ids_data[i] == padding_idx) continue;
+      PADDLE_ENFORCE_EQ(
+          ids_data[i] >= 0 && ids_data[i] < table_height, true,
+          platform::errors::InvalidArgument(
+              "The id should be in [0, %ld), but the %ld-th id of the %d-th "
+              "Input(Ids) is %ld.",
+              table_height, i, s, ids_data[i]));
+    }
+    slot_offset[s + 1] = slot_offset[s] + ids[s]->numel();
+  }
+  return slot_offset;
+}
+
+template <typename T>
+class FusedEmbeddingSeqPoolCVMConcatKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext &ctx) const override {
+    auto ids = ctx.MultiInput<LoDTensor>("Ids");
+    auto *table = ctx.Input<LoDTensor>("W");
+    auto *out = ctx.Output<LoDTensor>("Out");
+    bool use_cvm = ctx.Attr<bool>("use_cvm");
+    int64_t padding_idx = ctx.Attr<int64_t>("padding_idx");
+    bool is_quantized = ctx.Attr<bool>("is_quantized");
+
+    const int64_t table_height = table->dims()[0];
+    // The stride of the rows of the table, which is not the width of the
+    // embedding if the table is quantized.
+    const int64_t row_width = table->dims()[1];
+    const int64_t width =
+        is_quantized ? math::DequantEmbeddingWidth(row_width) : row_width;
+    size_t batch_size = 0;
+    auto slot_offset = CheckSlotIds(ids, table_height, padding_idx,
+                                    &batch_size);
+
+    // Without cvm, the show and click columns are skipped while pooling.
+    const int64_t col_begin = use_cvm ? 0 : kCVMColumns;
+    const int64_t out_width = width - col_begin;
+    const int64_t num_slots = static_cast<int64_t>(ids.size());
+    const int64_t bs = static_cast<int64_t>(batch_size);
+    out->Resize({bs, num_slots * out_width});
+    T *out_data = out->mutable_data<T>(ctx.GetPlace());
+    // The quantized table is always float.
+    const T *table_data = is_quantized ? nullptr : table->data<T>();
+    const float *quant_data = is_quantized ? table->data<float>() : nullptr;
+
+    auto vadd = jit::KernelFuncs<jit::VAddTuple<T>, platform::CPUPlace>::Cache()
+                    .At(out_width);
+    // Each (slot, instance) pair is pooled into its own block of the output,
+    // so that all the slots are processed in one parallel loop.
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (slot_offset.back() * width > \
+                             math::kEmbeddingParallelThreshold)
+#endif
+    for (int64_t k = 0; k < num_slots * bs; ++k) {
+      int64_t s = k / bs;
+      int64_t b = k % bs;
+      const auto &lod = ids[s]->lod()[0];
+      const int64_t *ids_data = ids[s]->data<int64_t>();
+      T *dst = out_data + b * num_slots * out_width + s * out_width;
+      std::memset(dst, 0, out_width * sizeof(T));
+      int64_t end = static_cast<int64_t>(lod[b + 1]);
+      for (int64_t j = static_cast<int64_t>(lod[b]); j < end; ++j) {
+        int64_t next = j + math::kEmbeddingPrefetchDistance;
+        if (next < end && ids_data[next] != padding_idx) {
+          if (is_quantized) {
+            math::PrefetchRow(quant_data + ids_data[next] * row_width,
+                              row_width);
+          } else {
+            math::PrefetchRow(table_data + ids_data[next] * row_width,
+                              row_width);
+          }
+        }
+        if (ids_data[j] == padding_idx) continue;
+        if (is_quantized) {
+          math::DequantAddRow(quant_data + ids_data[j] * row_width, col_begin,
+                              width, dst);
+        } else {
+          vadd(table_data + ids_data[j] * row_width + col_begin, dst, dst,
+               out_width);
+        }
+      }
+      if (use_cvm) {
+        dst[0] = std::log(dst[0] + 1);
+        dst[1] = std::log(dst[1] + 1) - dst[0];
+      }
+    }
+  }
+};
+
+template <typename T>
+class FusedEmbeddingSeqPoolCVMConcatGradKernel
+    : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext &ctx) const override {
+    auto ids = ctx.MultiInput<LoDTensor>("Ids");
+    auto *table = ctx.Input<LoDTensor>("W");
+    auto *cvm = ctx.Input<Tensor>("CVM");
+    auto *d_out = ctx.Input<LoDTensor>(framework::GradVarName("Out"));
+    bool use_cvm = ctx.Attr<bool>("use_cvm");
+    bool is_sparse = ctx.Attr<bool>("is_sparse");
+    int64_t padding_idx = ctx.Attr<int64_t>("padding_idx");
+    PADDLE_ENFORCE_EQ(ctx.Attr<bool>("is_quantized"), false,
+                      platform::errors::Unimplemented(
+                          "The quantized table is for inference only, and "
+                          "has no gradient."));
+
+    const int64_t table_height = table->dims()[0];
+    const int64_t width = table->dims()[1];
+    size_t batch_size = 0;
+    auto slot_offset = CheckSlotIds(ids, table_height, padding_idx,
+                                    &batch_size);
+    const int64_t bs = static_cast<int64_t>(batch_size);
+    PADDLE_ENFORCE_EQ(cvm->dims()[0], bs,
+                      platform::errors::InvalidArgument(
+                          "The height of Input(CVM) should be the batch size "
+                          "%ld, but received %ld.",
+                          bs, cvm->dims()[0]));
+
+    // The gradient of an embedding row is the gradient of its pooled output,
+    // except that the show and click columns take the values of CVM, which is
+    // what cvm_grad does.
+    const int64_t col_begin = use_cvm ? kCVMColumns : 0;
+    const int64_t grad_width = width - kCVMColumns;
+    const int64_t num_slots = static_cast<int64_t>(ids.size());
+    const int64_t out_width = use_cvm ? width : grad_width;
+    const T *d_out_data = d_out->data<T>();
+    const T *cvm_data = cvm->data<T>();
+    const int64_t num_ids = slot_offset.back();
+
+    if (is_sparse) {
+      auto *d_table = ctx.Output<SelectedRows>(framework::GradVarName("W"));
+      d_table->set_height(table_height);
+      auto *rows = d_table->mutable_rows();
+      rows->resize(num_ids);
+      for (int64_t s = 0; s < num_slots; ++s) {
+        std::memcpy(rows->data() + slot_offset[s], ids[s]->data<int64_t>(),
+                    ids[s]->numel() * sizeof(int64_t));
+      }
+      auto *d_table_value = d_table->mutable_value();
+      d_table_value->Resize({num_ids, width});
+      T *d_table_data = d_table_value->mutable_data<T>(ctx.GetPlace());
+
+      auto vbroadcast =
+          jit::KernelFuncs<jit::VBroadcastTuple<T>, platform::CPUPlace>::Cache()
+              .At(width);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (num_ids * width > \
+                             math::kEmbeddingParallelThreshold)
+#endif
+      for (int64_t k = 0; k < num_slots * bs; ++k) {
+        int64_t s = k / bs;
+        int64_t b = k % bs;
+        const auto &lod = ids[s]->lod()[0];
+        int64_t h = static_cast<int64_t>(lod[b + 1] - lod[b]);
+        if (h == 0) continue;
+        T *dst = d_table_data + (slot_offset[s] + lod[b]) * width;
+        const T *src = d_out_data + b * num_slots * out_width + s * out_width;
+        dst[0] = cvm_data[b * kCVMColumns];
+        dst[1] = cvm_data[b * kCVMColumns + 1];
+        std::memcpy(dst + kCVMColumns, src + col_begin,
+                    grad_width * sizeof(T));
+        // The jit code of vbroadcast copies at least one row.
+        if (h > 1) {
+          vbroadcast(dst, dst + width, h - 1, width);
+        }
+      }
+    } else {
+      auto *d_table = ctx.Output<LoDTensor>(framework::GradVarName("W"));
+      d_table->Resize(table->dims());
+      T *d_table_data = d_table->mutable_data<T>(ctx.GetPlace());
+      std::memset(d_table_data, 0, d_table->numel() * sizeof(T));
+
+      auto vadd =
+          jit::KernelFuncs<jit::VAddTuple<T>, platform::CPUPlace>::Cache().At(
+              grad_width);
+      // Each thread owns the rows of the same remainder modulo the number of
+      // threads, as math::ScatterAddRows does, and the paddings are skipped.
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel if (num_ids * width > math::kEmbeddingParallelThreshold)
+#endif
+      {
+        int64_t num_threads = 1;
+        int64_t thread_id = 0;
+#ifdef PADDLE_WITH_MKLML
+        num_threads = omp_get_num_threads();
+        thread_id = omp_get_thread_num();
+#endif
+        for (int64_t s = 0; s < num_slots; ++s) {
+          const auto &lod = ids[s]->lod()[0];
+          const int64_t *ids_data = ids[s]->data<int64_t>();
+          for (int64_t b = 0; b < bs; ++b) {
+            const T *src =
+                d_out_data + b * num_slots * out_width + s * out_width;
+            for (size_t j = lod[b]; j < lod[b + 1]; ++j) {
+              int64_t row = ids_data[j];
+              if (row == padding_idx || row % num_threads != thread_id) {
+                continue;
+              }
+              T *dst = d_table_data + row * width;
+              dst[0] += cvm_data[b * kCVMColumns];
+              dst[1] += cvm_data[b * kCVMColumns + 1];
+              vadd(src + col_begin, dst + kCVMColumns, dst + kCVMColumns,
+                   grad_width);
+            }
+          }
+        }
+      }
+    }
+  }
+};
+
+}  // namespace operators
+}  // namespace paddle
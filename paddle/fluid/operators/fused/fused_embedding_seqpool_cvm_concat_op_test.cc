@@ -0,0 +1,304 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/selected_rows.h"
+
+USE_CPU_ONLY_OP(fused_embedding_seqpool_cvm_concat);
+USE_OP(lookup_table_v2);
+USE_OP(sequence_pool);
+USE_OP(cvm);
+USE_OP(concat);
+USE_OP(sum);
+
+namespace paddle {
+namespace operators {
+
+using OperatorPtr = std::unique_ptr<framework::OperatorBase>;
+
+struct EmbeddingConfig {
+  int64_t num_slots;
+  int64_t batch_size;
+  int64_t height;
+  int64_t width;
+  bool use_cvm;
+  bool is_sparse;
+  int64_t padding_idx;
+};
+
+static std::string SlotVar(const std::string& prefix, int64_t slot) {
+  return prefix + "_" + std::to_string(slot);
+}
+
+static void RandomFill(framework::LoDTensor* tensor,
+                       const framework::DDim& dims, float low, float high) {
+  static std::mt19937 rng(100);
+  std::uniform_real_distribution<float> dist(low, high);
+  float* data = tensor->mutable_data<float>(dims, platform::CPUPlace());
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = dist(rng);
+  }
+}
+
+// Feed the table, CVM, the ids of each slot, and the gradient of the output.
+static void Feed(const EmbeddingConfig& config, framework::Scope* scope) {
+  std::mt19937 rng(200);
+  std::uniform_int_distribution<int64_t> length_dist(0, 3);
+  std::uniform_real_distribution<double> id_dist(0.0, 1.0);
+  RandomFill(scope->Var("W")->GetMutable<framework::LoDTensor>(),
+             {config.height, config.width}, 0.0f, 1.0f);
+  RandomFill(scope->Var("CVM")->GetMutable<framework::LoDTensor>(),
+             {config.batch_size, 2}, 0.0f, 10.0f);
+  int64_t out_width = config.use_cvm ? config.width : config.width - 2;
+  RandomFill(scope->Var("Out@GRAD")->GetMutable<framework::LoDTensor>(),
+             {config.batch_size, config.num_slots * out_width}, -1.0f, 1.0f);
+  if (config.is_sparse) {
+    scope->Var("fused_w_grad")->GetMutable<framework::SelectedRows>();
+  }
+  for (int64_t s = 0; s < config.num_slots; ++s) {
+    framework::LoD lod(1, {0});
+    for (int64_t b = 0; b < config.batch_size; ++b) {
+      lod[0].push_back(lod[0].back() + length_dist(rng));
+    }
+    auto* ids =
+        scope->Var(SlotVar("ids", s))->GetMutable<framework::LoDTensor>();
+    ids->set_lod(lod);
+    int64_t* data = ids->mutable_data<int64_t>(
+        {static_cast<int64_t>(lod[0].back())}, platform::CPUPlace());
+    for (int64_t i = 0; i < ids->numel(); ++i) {
+      // The ids of CTR models follow a power law.
+      data[i] = static_cast<int64_t>(std::pow(id_dist(rng), 3.0) *
+                                     (config.height - 1));
+    }
+  }
+}
+
+static std::vector<OperatorPtr> FusedProgram(const EmbeddingConfig& config) {
+  std::vector<std::string> ids;
+  for (int64_t s = 0; s < config.num_slots; ++s) {
+    ids.push_back(SlotVar("ids", s));
+  }
+  framework::AttributeMap attrs = {{"use_cvm", config.use_cvm},
+                                   {"is_sparse", config.is_sparse},
+                                   {"padding_idx", config.padding_idx}};
+  std::vector<OperatorPtr> ops;
+  ops.emplace_back(framework::OpRegistry::CreateOp(
+      "fused_embedding_seqpool_cvm_concat",
+      {{"W", {"W"}}, {"Ids", ids}, {"CVM", {"CVM"}}},
+      {{"Out", {"fused_out"}}}, attrs));
+  ops.emplace_back(framework::OpRegistry::CreateOp(
+      "fused_embedding_seqpool_cvm_concat_grad",
+      {{"W", {"W"}},
+       {"Ids", ids},
+       {"CVM", {"CVM"}},
+       {"Out@GRAD", {"Out@GRAD"}}},
+      {{"W@GRAD", {"fused_w_grad"}}}, attrs));
+  return ops;
+}
+
+// The forward and backward operators of each slot, as the program before
+// fusion has. The gradient of W is dense.
+static std::vector<OperatorPtr> UnfusedProgram(const EmbeddingConfig& config) {
+  std::vector<OperatorPtr> ops;
+  std::vector<std::string> cvm_outs, cvm_out_grads, w_grads;
+  framework::AttributeMap lookup_attrs = {
+      {"is_sparse", false}, {"padding_idx", config.padding_idx}};
+  framework::AttributeMap pool_attrs = {{"pooltype", std::string("SUM")}};
+  framework::AttributeMap cvm_attrs = {{"use_cvm", config.use_cvm}};
+  framework::AttributeMap concat_attrs = {{"axis", 1}};
+  for (int64_t s = 0; s < config.num_slots; ++s) {
+    ops.emplace_back(framework::OpRegistry::CreateOp(
+        "lookup_table_v2", {{"W", {"W"}}, {"Ids", {SlotVar("ids", s)}}},
+        {{"Out", {SlotVar("emb", s)}}}, lookup_attrs));
+    ops.emplace_back(framework::OpRegistry::CreateOp(
+        "sequence_pool", {{"X", {SlotVar("emb", s)}}},
+        {{"Out", {SlotVar("pool", s)}},
+         {"MaxIndex", {SlotVar("max_index", s)}}},
+        pool_attrs));
+    ops.emplace_back(framework::OpRegistry::CreateOp(
+        "cvm", {{"X", {SlotVar("pool", s)}}, {"CVM", {"CVM"}}},
+        {{"Y", {SlotVar("cvm", s)}}}, cvm_attrs));
+    cvm_outs.push_back(SlotVar("cvm", s));
+    cvm_out_grads.push_back(SlotVar("cvm@GRAD", s));
+    w_grads.push_back(SlotVar("w@GRAD", s));
+  }
+  ops.emplace_back(framework::OpRegistry::CreateOp(
+      "concat", {{"X", cvm_outs}}, {{"Out", {"unfused_out"}}}, concat_attrs));
+
+  ops.emplace_back(framework::OpRegistry::CreateOp(
+      "concat_grad", {{"X", cvm_outs}, {"Out@GRAD", {"Out@GRAD"}}},
+      {{"X@GRAD", cvm_out_grads}}, concat_attrs));
+  for (int64_t s = 0; s < config.num_slots; ++s) {
+    ops.emplace_back(framework::OpRegistry::CreateOp(
+        "cvm_grad",
+        {{"X", {SlotVar("pool", s)}},
+         {"CVM", {"CVM"}},
+         {"Y@GRAD", {SlotVar("cvm@GRAD", s)}}},
+        {{"X@GRAD", {SlotVar("pool@GRAD", s)}}}, cvm_attrs));
+    ops.emplace_back(framework::OpRegistry::CreateOp(
+        "sequence_pool_grad",
+        {{"X", {SlotVar("emb", s)}}, {"Out@GRAD", {SlotVar("pool@GRAD", s)}}},
+        {{"X@GRAD", {SlotVar("emb@GRAD", s)}}}, pool_attrs));
+    ops.emplace_back(framework::OpRegistry::CreateOp(
+        "lookup_table_v2_grad",
+        {{"W", {"W"}},
+         {"Ids", {SlotVar("ids", s)}},
+         {"Out@GRAD", {SlotVar("emb@GRAD", s)}}},
+        {{"W@GRAD", {SlotVar("w@GRAD", s)}}}, lookup_attrs));
+  }
+  ops.emplace_back(framework::OpRegistry::CreateOp(
+      "sum", {{"X", w_grads}}, {{"Out", {"unfused_w_grad"}}}, {}));
+  return ops;
+}
+
+static void CreateOutputVars(const std::vector<OperatorPtr>& ops,
+                             framework::Scope* scope) {
+  for (auto& op : ops) {
+    for (auto& output : op->Outputs()) {
+      for (auto& name : output.second) {
+        auto* var = scope->Var(name);
+        if (!var->IsInitialized()) {
+          var->GetMutable<framework::LoDTensor>();
+        }
+      }
+    }
+  }
+}
+
+static void RunOps(const std::vector<OperatorPtr>& ops,
+                   const framework::Scope& scope) {
+  for (auto& op : ops) {
+    op->Run(scope, platform::CPUPlace());
+  }
+}
+
+// Return the dense gradient of W, which is accumulated from SelectedRows if
+// is_sparse.
+static std::vector<float> DenseGrad(const framework::Scope& scope,
+                                    const std::string& name, int64_t height,
+                                    int64_t width) {
+  auto* var = scope.FindVar(name);
+  if (var->IsType<framework::LoDTensor>()) {
+    auto& tensor = var->Get<framework::LoDTensor>();
+    return std::vector<float>(tensor.data<float>(),
+                              tensor.data<float>() + tensor.numel());
+  }
+  std::vector<float> grad(height * width, 0.0f);
+  auto& selected_rows = var->Get<framework::SelectedRows>();
+  const float* value = selected_rows.value().data<float>();
+  for (size_t i = 0; i < selected_rows.rows().size(); ++i) {
+    for (int64_t j = 0; j < width; ++j) {
+      grad[selected_rows.rows()[i] * width + j] += value[i * width + j];
+    }
+  }
+  return grad;
+}
+
+static void TestFusedEmbedding(const EmbeddingConfig& config) {
+  framework::Scope scope;
+  Feed(config, &scope);
+  auto fused = FusedProgram(config);
+  auto unfused = UnfusedProgram(config);
+  CreateOutputVars(fused, &scope);
+  CreateOutputVars(unfused, &scope);
+  RunOps(fused, scope);
+  RunOps(unfused, scope);
+
+  auto& fused_out = scope.FindVar("fused_out")->Get<framework::LoDTensor>();
+  auto& unfused_out =
+      scope.FindVar("unfused_out")->Get<framework::LoDTensor>();
+  ASSERT_EQ(fused_out.dims(), unfused_out.dims());
+  for (int64_t i = 0; i < fused_out.numel(); ++i) {
+    EXPECT_NEAR(fused_out.data<float>()[i], unfused_out.data<float>()[i],
+                1e-4);
+  }
+
+  auto fused_grad =
+      DenseGrad(scope, "fused_w_grad", config.height, config.width);
+  auto unfused_grad =
+      DenseGrad(scope, "unfused_w_grad", config.height, config.width);
+  ASSERT_EQ(fused_grad.size(), unfused_grad.size());
+  for (size_t i = 0; i < fused_grad.size(); ++i) {
+    // The sparse gradient of the paddings is not skipped, as what the
+    // sparse lookup_table_v2_grad does.
+    if (config.is_sparse &&
+        static_cast<int64_t>(i) / config.width == config.padding_idx) {
+      continue;
+    }
+    EXPECT_NEAR(fused_grad[i], unfused_grad[i], 1e-3);
+  }
+}
+
+TEST(FusedEmbeddingSeqPoolCVMConcat, CompareWithUnfused) {
+  for (bool use_cvm : {true, false}) {
+    for (bool is_sparse : {true, false}) {
+      for (int64_t padding_idx : {-1, 0}) {
+        TestFusedEmbedding({/*num_slots=*/5, /*batch_size=*/16,
+                            /*height=*/100, /*width=*/11, use_cvm, is_sparse,
+                            padding_idx});
+      }
+    }
+  }
+  // Large enough to run in parallel
+  TestFusedEmbedding({100, 128, 10000, 16, true, true, -1});
+}
+
+TEST(FusedEmbeddingSeqPoolCVMConcat, Benchmark) {
+  const int kRepeat = 10;
+  for (int64_t num_slots : {26, 100, 300}) {
+    EmbeddingConfig config{num_slots, 512, 1 << 18, 16, true, false, -1};
+    framework::Scope scope;
+    Feed(config, &scope);
+    auto fused = FusedProgram(config);
+    auto unfused = UnfusedProgram(config);
+    CreateOutputVars(fused, &scope);
+    CreateOutputVars(unfused, &scope);
+    // Warm up
+    RunOps(fused, scope);
+    RunOps(unfused, scope);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRepeat; ++i) {
+      RunOps(unfused, scope);
+    }
+    double unfused_ms = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - start)
+                            .count() /
+                        kRepeat;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRepeat; ++i) {
+      RunOps(fused, scope);
+    }
+    double fused_ms = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - start)
+                          .count() /
+                      kRepeat;
+    LOG(INFO) << "Forward and backward of " << num_slots << " slots of batch "
+              << config.batch_size << ", unfused (" << unfused.size()
+              << " ops): " << unfused_ms << " ms, fused (" << fused.size()
+              << " ops): " << fused_ms << " ms";
+  }
+}
+
+}  // namespace operators
+}  // namespace paddle
@@ -71,8 +71,15 @@ class FusionGroupOp : public framework::OperatorWithKernel {
  protected:
   framework::OpKernelType GetExpectedKernelType(
       const framework::ExecutionContext& ctx) const override {
-    return framework::OpKernelType(framework::proto::VarType::FP32,
-                                   platform::CUDAPlace(0));
+    // The generated code takes the data types of every input and output from
+    // the attributes, and the data type of the first output chooses the
+    // registered kernel.
+    const auto& outs_dtype = ctx.Attr<std::vector<int>>("outs_dtype");
+    auto data_type = outs_dtype.empty()
+                         ? framework::proto::VarType::FP32
+                         : static_cast<framework::proto::VarType::Type>(
+                               outs_dtype[0]);
+    return framework::OpKernelType(data_type, ctx.GetPlace());
   };
 };
 
@@ -97,8 +104,9 @@ class FusionGroupOpMaker : public framework::OpProtoAndCheckerMaker {
     AddComment(R"DOC(
 fusion_group Operator.
 
-It is used to execute a generated CUDA kernel which fuse the computation of
-multiple operators into one. It supports several types:
+It is used to execute a generated CUDA kernel, or a generated C++ function on
+CPU, which fuse the computation of multiple operators into one. It supports
+several types:
 0, fused computation of elementwise operations in which all the dims of inputs
     and outputs should be exactly the same.
 )DOC");
@@ -110,3 +118,7 @@ multiple operators into one. It supports several types:
 
 namespace ops = paddle::operators;
 REGISTER_OPERATOR(fusion_group, ops::FusionGroupOp, ops::FusionGroupOpMaker);
+REGISTER_OP_CPU_KERNEL(
+    fusion_group,
+    ops::FusionGroupKernel<paddle::platform::CPUDeviceContext, float>,
+    ops::FusionGroupKernel<paddle::platform::CPUDeviceContext, double>);
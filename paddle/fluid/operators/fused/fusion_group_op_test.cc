@@ -12,7 +12,13 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "gtest/gtest.h"
+#include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/framework/op_desc.h"
 #include "paddle/fluid/framework/op_proto_maker.h"
 #include "paddle/fluid/framework/op_registry.h"
@@ -25,6 +31,11 @@ namespace operators {
 
 using CPUKernelFunc = std::function<void(size_t n, std::vector<void*> args)>;
 
+template <typename T>
+framework::proto::VarType::Type DataType() {
+  return framework::ToDataType(std::type_index(typeid(T)));
+}
+
 template <typename T>
 framework::Tensor* CreateTensor(framework::Scope* scope,
                                 const platform::Place& place,
@@ -52,6 +63,7 @@ void SetupRandomCPUTensor(framework::Tensor* tensor,
   }
 }
 
+template <typename T>
 framework::OpDesc* CreateFusionGroupOp(
     framework::ProgramDesc* program,
     const std::vector<std::string>& input_names,
@@ -60,21 +72,19 @@ framework::OpDesc* CreateFusionGroupOp(
     std::string func_name) {
   EXPECT_EQ(input_names.size(), input_shapes.size());
 
-  std::vector<int> input_dtypes(input_names.size(),
-                                framework::proto::VarType::FP32);
-  std::vector<int> output_dtypes(output_names.size(),
-                                 framework::proto::VarType::FP32);
+  std::vector<int> input_dtypes(input_names.size(), DataType<T>());
+  std::vector<int> output_dtypes(output_names.size(), DataType<T>());
 
   for (size_t i = 0; i < input_names.size(); ++i) {
     auto* var = program->MutableBlock(0)->Var(input_names[i]);
     var->SetType(framework::proto::VarType::LOD_TENSOR);
-    var->SetDataType(framework::proto::VarType::FP32);
+    var->SetDataType(DataType<T>());
     var->SetShape(input_shapes[i]);
   }
   for (size_t j = 0; j < output_names.size(); ++j) {
     auto* var = program->MutableBlock(0)->Var(output_names[j]);
     var->SetType(framework::proto::VarType::LOD_TENSOR);
-    var->SetDataType(framework::proto::VarType::FP32);
+    var->SetDataType(DataType<T>());
   }
 
   auto* op = program->MutableBlock(0)->AppendOp();
@@ -91,16 +101,25 @@ framework::OpDesc* CreateFusionGroupOp(
 }
 
 void PrepareDeviceCode(platform::Place place, std::string func_name,
-                       std::string cuda_kernel_str) {
+                       std::string kernel_str) {
   paddle::platform::DeviceCodePool& pool =
       paddle::platform::DeviceCodePool::Init({place});
 
-  std::unique_ptr<paddle::platform::DeviceCode> code(
-      new paddle::platform::CUDADeviceCode(place, func_name, cuda_kernel_str));
-  code->Compile();
+  std::unique_ptr<paddle::platform::DeviceCode> code;
+  if (platform::is_gpu_place(place)) {
+#ifdef PADDLE_WITH_CUDA
+    code.reset(
+        new paddle::platform::CUDADeviceCode(place, func_name, kernel_str));
+#endif
+  } else {
+    code.reset(
+        new paddle::platform::CPUDeviceCode(place, func_name, kernel_str));
+  }
+  EXPECT_TRUE(code->Compile());
   pool.Set(std::move(code));
 }
 
+template <typename T>
 void CheckOutputs(framework::Scope* scope,
                   const std::vector<std::string>& output_names,
                   std::vector<framework::Tensor>* cpu_tensors,
@@ -113,19 +132,19 @@ void CheckOutputs(framework::Scope* scope,
     TensorCopySync(dev_tensor, platform::CPUPlace(), &(cpu_outputs[j]));
 
     cpu_tensors->at(num_inputs + j)
-        .mutable_data<float>(dev_tensor.dims(), platform::CPUPlace());
+        .mutable_data<T>(dev_tensor.dims(), platform::CPUPlace());
   }
 
   size_t n = cpu_tensors->at(0).numel();
   std::vector<void*> args;
   for (size_t i = 0; i < cpu_tensors->size(); ++i) {
-    args.push_back(cpu_tensors->at(i).data<float>());
+    args.push_back(cpu_tensors->at(i).data<T>());
   }
   cpu_kernel_func(n, args);
 
   for (size_t j = 0; j < output_names.size(); ++j) {
-    auto* dev_ptr = cpu_outputs[j].data<float>();
-    auto* cpu_ptr = cpu_tensors->at(num_inputs + j).data<float>();
+    auto* dev_ptr = cpu_outputs[j].data<T>();
+    auto* cpu_ptr = cpu_tensors->at(num_inputs + j).data<T>();
     int64_t length = cpu_outputs[j].numel();
     LOG(INFO) << "Check the " << j << "th output...";
     for (int64_t i = 0; i < length; ++i) {
@@ -134,19 +153,19 @@ void CheckOutputs(framework::Scope* scope,
   }
 }
 
-void TestMain(const std::vector<std::string>& input_names,
+template <typename T>
+void TestMain(const platform::Place& place,
+              const std::vector<std::string>& input_names,
               const std::vector<std::vector<int64_t>>& input_shapes,
               const std::vector<std::string>& output_names, int type,
-              std::string func_name, std::string cuda_kernel_str,
+              std::string func_name, std::string kernel_str,
               CPUKernelFunc cpu_kernel_func) {
   // Compile the device code
-  paddle::framework::InitDevices({0});
-  platform::CUDAPlace place = platform::CUDAPlace(0);
-  PrepareDeviceCode(place, func_name, cuda_kernel_str);
+  PrepareDeviceCode(place, func_name, kernel_str);
 
   // Create a ProgramDesc that has a fusion_group_op.
   framework::ProgramDesc program;
-  framework::OpDesc* op_desc = CreateFusionGroupOp(
+  framework::OpDesc* op_desc = CreateFusionGroupOp<T>(
       &program, input_names, input_shapes, output_names, type, func_name);
   auto fusion_group_op = framework::OpRegistry::CreateOp(*op_desc);
 
@@ -156,15 +175,15 @@ void TestMain(const std::vector<std::string>& input_names,
   std::vector<framework::Tensor> cpu_tensors;
   cpu_tensors.resize(input_names.size() + output_names.size());
   for (size_t i = 0; i < input_names.size(); ++i) {
-    SetupRandomCPUTensor<float>(&(cpu_tensors[i]), input_shapes[i]);
+    SetupRandomCPUTensor<T>(&(cpu_tensors[i]), input_shapes[i]);
     framework::Tensor* dev_tensor =
-        CreateTensor<float>(&scope, place, input_names[i], input_shapes[i]);
+        CreateTensor<T>(&scope, place, input_names[i], input_shapes[i]);
     TensorCopySync(cpu_tensors[i], place, dev_tensor);
   }
   // Create output tensors.
   std::vector<int64_t> empty_shape;
   for (size_t j = 0; j < output_names.size(); ++j) {
-    CreateTensor<float>(&scope, place, output_names[j], empty_shape);
+    CreateTensor<T>(&scope, place, output_names[j], empty_shape);
   }
 
   fusion_group_op->Run(scope, place);
@@ -173,14 +192,16 @@ void TestMain(const std::vector<std::string>& input_names,
   dev_ctx->Wait();
 
   // Check the output.
-  CheckOutputs(&scope, output_names, &cpu_tensors, input_names.size(),
-               cpu_kernel_func);
+  CheckOutputs<T>(&scope, output_names, &cpu_tensors, input_names.size(),
+                  cpu_kernel_func);
 }
 
+#ifdef PADDLE_WITH_CUDA
 TEST(FusionGroupOp, elementwise) {
   if (!platform::dynload::HasNVRTC() || !platform::dynload::HasCUDADriver()) {
     return;
   }
+  paddle::framework::InitDevices({0});
 
   // z = relu(x + y)
   std::vector<std::string> input_names = {"x", "y"};
@@ -217,11 +238,73 @@ void elementwise_cuda_kernel_0(size_t n, float *x, float* y, float* z) {
     }
   };
 
-  TestMain(input_names, input_shapes, output_names, 0,
-           "elementwise_cuda_kernel_0", kernel, elementwise_cpu_kernel_0);
+  TestMain<float>(platform::CUDAPlace(0), input_names, input_shapes,
+                  output_names, 0, "elementwise_cuda_kernel_0", kernel,
+                  elementwise_cpu_kernel_0);
+}
+#endif
+
+// The code in the form of CPUCodeGenerator, for z = relu(x + y) of T.
+static std::string ElementwiseCPUKernel(const std::string& func_name,
+                                        const std::string& dtype) {
+  std::string code = R"(
+#include <cstdint>
+
+extern "C" void $func_name(int64_t N, void** args) {
+  $dtype* __restrict__ x = *reinterpret_cast<$dtype**>(args[0]);
+  $dtype* __restrict__ y = *reinterpret_cast<$dtype**>(args[1]);
+  $dtype* __restrict__ z = *reinterpret_cast<$dtype**>(args[2]);
+  for (int64_t idx = 0; idx < N; ++idx) {
+    $dtype tmp_0 = x[idx] + y[idx];
+    z[idx] = tmp_0 > 0 ? tmp_0 : 0;
+  }
+})";
+  for (auto kv : {std::make_pair(std::string("$func_name"), func_name),
+                  std::make_pair(std::string("$dtype"), dtype)}) {
+    for (size_t pos = code.find(kv.first); pos != std::string::npos;
+         pos = code.find(kv.first, pos)) {
+      code.replace(pos, kv.first.size(), kv.second);
+    }
+  }
+  return code;
+}
+
+template <typename T>
+void TestElementwiseOnCPU(const std::string& dtype) {
+  if (!platform::CPUDeviceCode::IsAvailable()) {
+    return;
+  }
+  paddle::framework::InitDevices({});
+  std::vector<std::string> input_names = {"x", "y"};
+  std::vector<std::string> output_names = {"z"};
+  std::vector<std::vector<int64_t>> input_shapes = {{256, 256}, {256, 256}};
+  std::string func_name = "elementwise_cpu_kernel_" + dtype;
+
+  auto elementwise_cpu_kernel_0 = [](size_t n,
+                                     std::vector<void*> args) -> void {
+    T* x = static_cast<T*>(args[0]);
+    T* y = static_cast<T*>(args[1]);
+    T* z = static_cast<T*>(args[2]);
+    for (size_t i = 0; i < n; ++i) {
+      T tmp = x[i] + y[i];
+      z[i] = tmp > 0 ? tmp : 0;
+    }
+  };
+
+  TestMain<T>(platform::CPUPlace(), input_names, input_shapes, output_names,
+              0, func_name, ElementwiseCPUKernel(func_name, dtype),
+              elementwise_cpu_kernel_0);
+}
+
+TEST(FusionGroupOp, elementwise_cpu_fp32) {
+  TestElementwiseOnCPU<float>("float");
+}
+
+TEST(FusionGroupOp, elementwise_cpu_fp64) {
+  TestElementwiseOnCPU<double>("double");
 }
 
 }  // namespace operators
 }  // namespace paddle
 
-USE_CUDA_ONLY_OP(fusion_group);
+USE_OP(fusion_group);
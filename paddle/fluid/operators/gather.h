@@ -36,7 +36,7 @@ using framework::Tensor;
  * return: output tensor
  */
 template <typename T, typename IndexT = int>
-void CPUGather(const platform::DeviceContext& ctx, const Tensor& src,
+void CPUGather(const platform::CPUDeviceContext& ctx, const Tensor& src,
                const Tensor& index, Tensor* output) {
   PADDLE_ENFORCE_EQ(
       platform::is_cpu_place(ctx.GetPlace()), true,
@@ -70,14 +70,19 @@ void CPUGather(const platform::DeviceContext& ctx, const Tensor& src,
 
   const size_t slice_bytes = slice_size * sizeof(T);
 
-  for (int64_t i = 0; i < index_size; ++i) {
-    IndexT index_ = p_index[i];
-    memcpy(p_output + i * slice_size, p_src + index_ * slice_size, slice_bytes);
-  }
+  ctx.ParallelFor(
+      0, index_size, platform::CPUDeviceContext::GrainSize(slice_size),
+      [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          IndexT index_ = p_index[i];
+          memcpy(p_output + i * slice_size, p_src + index_ * slice_size,
+                 slice_bytes);
+        }
+      });
 }
 
 template <typename T, typename IndexT = int>
-void CPUGatherNd(const platform::DeviceContext& ctx, const Tensor& input,
+void CPUGatherNd(const platform::CPUDeviceContext& ctx, const Tensor& input,
                  const Tensor& index, Tensor* output) {
   PADDLE_ENFORCE_EQ(
       platform::is_cpu_place(ctx.GetPlace()), true,
@@ -104,26 +109,31 @@ void CPUGatherNd(const platform::DeviceContext& ctx, const Tensor& input,
   }
   const size_t slice_bytes = slice_size * sizeof(T);
 
-  for (int64_t i = 0; i < remain_numel; ++i) {
-    int64_t index_ = 0;
-    int64_t temp = 1;
-    for (int64_t j = end_size - 1; j >= 0; --j) {
-      IndexT index_value = p_index[i * end_size + j];
-      PADDLE_ENFORCE_LT(
-          index_value, input_dims[j],
-          platform::errors::InvalidArgument(
-              "Input(index[-1)] has wrong value, it is [%d]", index_value));
-      PADDLE_ENFORCE_GE(
-          index_value, 0UL,
-          platform::errors::InvalidArgument(
-              "The value of Input(index) must be no less than 0"));
-
-      index_ += (index_value * temp);
-      temp *= input_dims[j];
-    }
-    memcpy(p_output + i * slice_size, p_input + index_ * slice_size,
-           slice_bytes);
-  }
+  ctx.ParallelFor(
+      0, remain_numel, platform::CPUDeviceContext::GrainSize(slice_size),
+      [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          int64_t index_ = 0;
+          int64_t temp = 1;
+          for (int64_t j = end_size - 1; j >= 0; --j) {
+            IndexT index_value = p_index[i * end_size + j];
+            PADDLE_ENFORCE_LT(
+                index_value, input_dims[j],
+                platform::errors::InvalidArgument(
+                    "Input(index[-1)] has wrong value, it is [%d]",
+                    index_value));
+            PADDLE_ENFORCE_GE(
+                index_value, 0UL,
+                platform::errors::InvalidArgument(
+                    "The value of Input(index) must be no less than 0"));
+
+            index_ += (index_value * temp);
+            temp *= input_dims[j];
+          }
+          memcpy(p_output + i * slice_size, p_input + index_ * slice_size,
+                 slice_bytes);
+        }
+      });
 }
 
 template <typename T, typename U, typename V>
@@ -50,10 +50,11 @@ class GatherNdOpKernel : public framework::OpKernel<T> {
                               framework::proto::VarType::INT32),
                           paddle::framework::DataTypeToString(
                               framework::proto::VarType::INT64)));
+    auto &dev_ctx = ctx.template device_context<platform::CPUDeviceContext>();
     if (index_type == framework::proto::VarType::INT32) {
-      CPUGatherNd<T, int>(ctx.device_context(), *x, *index, output);
+      CPUGatherNd<T, int>(dev_ctx, *x, *index, output);
     } else if (index_type == framework::proto::VarType::INT64) {
-      CPUGatherNd<T, int64_t>(ctx.device_context(), *x, *index, output);
+      CPUGatherNd<T, int64_t>(dev_ctx, *x, *index, output);
     }
   }
 };
@@ -74,10 +74,11 @@ class GatherOpKernel : public framework::OpKernel<T> {
                               framework::proto::VarType::INT32),
                           paddle::framework::DataTypeToString(
                               framework::proto::VarType::INT64)));
+    auto &dev_ctx = ctx.template device_context<platform::CPUDeviceContext>();
     if (index_type == framework::proto::VarType::INT32) {
-      CPUGather<T, int>(ctx.device_context(), *x, *index, output);
+      CPUGather<T, int>(dev_ctx, *x, *index, output);
     } else if (index_type == framework::proto::VarType::INT64) {
-      CPUGather<T, int64_t>(ctx.device_context(), *x, *index, output);
+      CPUGather<T, int64_t>(dev_ctx, *x, *index, output);
     }
   }
 };
@@ -120,8 +121,8 @@ class GatherGradientOpKernel : public framework::OpKernel<T> {
 
     dX->mutable_data<T>(ctx.GetPlace());
     auto dxt = framework::EigenVector<T>::Flatten(*dX);
-    auto &place = *ctx.template device_context<platform::CPUDeviceContext>()
-                       .eigen_device();
+    auto &dev_ctx = ctx.template device_context<platform::CPUDeviceContext>();
+    auto &place = *dev_ctx.eigen_device();
     dxt.device(place) = dxt.constant(static_cast<T>(0));
     if (dO->numel() == 0) return;
     bool overwrite = ctx.Attr<bool>("overwrite");
@@ -140,13 +141,13 @@ class GatherGradientOpKernel : public framework::OpKernel<T> {
                               framework::proto::VarType::INT64)));
     if (index_type == framework::proto::VarType::INT32) {
       if (overwrite) {
-        ScatterAssign<T, int32_t>(ctx.device_context(), *dO, *index, dX);
+        ScatterAssign<T, int32_t>(dev_ctx, *dO, *index, dX);
       } else {
         ScatterAssignAdd<T, int32_t>(ctx, *dO, *index, dX);
       }
     } else if (index_type == framework::proto::VarType::INT64) {
       if (overwrite) {
-        ScatterAssign<T, int64_t>(ctx.device_context(), *dO, *index, dX);
+        ScatterAssign<T, int64_t>(dev_ctx, *dO, *index, dX);
       } else {
         ScatterAssignAdd<T, int64_t>(ctx, *dO, *index, dX);
       }
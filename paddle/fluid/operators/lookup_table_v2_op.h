@@ -23,6 +23,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/selected_rows.h"
 #include "paddle/fluid/operators/math/blas.h"
+#include "paddle/fluid/operators/math/embedding_gather.h"
 
 namespace paddle {
 namespace operators {
@@ -66,7 +67,7 @@ class LookupTableV2Kernel : public framework::OpKernel<T> {
 
       for (int64_t i = 0; i < ids_numel; ++i) {
         if (padding_idx != kNoPadding && ids[i] == padding_idx) {
-          memset(output + i * row_width, 0, row_width * sizeof(T));
+          ids[i] = -1;
         } else {
           PADDLE_ENFORCE_LT(
               ids[i], row_number,
@@ -82,20 +83,19 @@ class LookupTableV2Kernel : public framework::OpKernel<T> {
                   "expected >= 0 and < %ld, but got %ld. Please check input "
                   "value.",
                   row_number, ids[i]));
-          memcpy(output + i * row_width, table + ids[i] * row_width,
-                 row_width * sizeof(T));
         }
       }
+      math::GatherRows(table, row_width, ids.data(), ids_numel, output);
     } else if (table_var->IsType<SelectedRows>()) {
       const auto &table_t = table_var->Get<SelectedRows>();
       int64_t row_width = table_t.value().dims()[1];
       const auto *table = table_t.value().data<T>();
       auto *output = output_t->mutable_data<T>(context.GetPlace());
 
-      auto blas = math::GetBlas<platform::CPUDeviceContext, T>(context);
+      std::vector<int64_t> index(ids_numel);
       for (int64_t i = 0; i < ids_numel; ++i) {
         if (padding_idx != kNoPadding && ids[i] == padding_idx) {
-          memset(output + i * row_width, 0, row_width * sizeof(T));
+          index[i] = -1;
         } else {
           PADDLE_ENFORCE_GE(
               ids[i], 0,
@@ -103,16 +103,15 @@ class LookupTableV2Kernel : public framework::OpKernel<T> {
                   "Variable value (input) of OP(fluid.layers.embedding) "
                   "expected >= 0. But received %ld",
                   ids[i]));
-          auto id_index = table_t.Index(ids[i]);
+          index[i] = table_t.Index(ids[i]);
           PADDLE_ENFORCE_GE(
-              id_index, 0,
+              index[i], 0,
               platform::errors::InvalidArgument(
                   "the input key should be exists. But received %d.",
-                  id_index));
-          blas.VCOPY(row_width, table + id_index * row_width,
-                     output + i * row_width);
+                  index[i]));
         }
       }
+      math::GatherRows(table, row_width, index.data(), ids_numel, output);
     }
   }
 };
@@ -209,7 +208,8 @@ class LookupTableV2GradKernel : public framework::OpKernel<T> {
       for (int64_t i = 0; i < ids_num; ++i) {
         if (padding_idx != kNoPadding && ids_data[i] == padding_idx) {
           // the gradient of padding_idx should be 0, already done by memset, so
-          // do nothing.
+          // skip it.
+          ids_data[i] = -1;
         } else {
           PADDLE_ENFORCE_LT(
               ids_data[i], N,
@@ -225,11 +225,9 @@ class LookupTableV2GradKernel : public framework::OpKernel<T> {
                   "expected >= 0 and < %ld, but got %ld. Please check input "
                   "value.",
                   N, ids_data[i]));
-          for (int j = 0; j < D; ++j) {
-            d_table_data[ids_data[i] * D + j] += d_output_data[i * D + j];
-          }
         }
       }
+      math::ScatterAddRows(d_output_data, D, ids_data, ids_num, d_table_data);
     }
   }
 };
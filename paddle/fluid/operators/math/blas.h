@@ -16,6 +16,7 @@
 
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/framework/tensor.h"
+#include "paddle/fluid/platform/bfloat16.h"
 
 namespace paddle {
 namespace framework {
@@ -102,6 +103,15 @@ class Blas {
             T alpha, const T* A, int lda, const T* B, int ldb, T beta, T* C,
             int ldc) const;
 
+  // C = A * B of uint8 A, int8 B and int32 C. CPU only, see cpu_lowp_gemm.h.
+  void GEMM_U8S8S32(int M, int N, int K, const uint8_t* A, int lda,
+                    const int8_t* B, int ldb, int32_t* C, int ldc) const;
+
+  // C = alpha * A * B + beta * C of bfloat16 A and B, and float C. CPU only.
+  void GEMM_BF16(int M, int N, int K, float alpha, const platform::bfloat16* A,
+                 int lda, const platform::bfloat16* B, int ldb, float beta,
+                 float* C, int ldc) const;
+
 #ifdef PADDLE_WITH_MKLML
   template <typename T>
   T* GEMM_ALLOC(const CBLAS_IDENTIFIER id, const int M, const int N,
@@ -262,6 +272,9 @@ class BlasT : private Blas<DeviceContext> {
     Base()->template GEMM<T>(args...);
   }
 
+  using Blas<DeviceContext>::GEMM_U8S8S32;
+  using Blas<DeviceContext>::GEMM_BF16;
+
 #ifdef PADDLE_WITH_MKLML
   template <typename... ARGS>
   T* GEMM_ALLOC(ARGS... args) const {
@@ -20,6 +20,7 @@
 #include <limits>
 #include <vector>
 
+#include "paddle/fluid/operators/math/cpu_lowp_gemm.h"
 #include "paddle/fluid/operators/math/math_function.h"
 #include "paddle/fluid/platform/complex128.h"
 #include "paddle/fluid/platform/complex64.h"
@@ -800,6 +801,21 @@ void Blas<platform::CPUDeviceContext>::GEMM(CBLAS_TRANSPOSE transA,
                  beta, C, ldc);
 }
 
+template <>
+inline void Blas<platform::CPUDeviceContext>::GEMM_U8S8S32(
+    int M, int N, int K, const uint8_t *A, int lda, const int8_t *B, int ldb,
+    int32_t *C, int ldc) const {
+  GemmU8S8S32(M, N, K, A, lda, B, ldb, C, ldc);
+}
+
+template <>
+inline void Blas<platform::CPUDeviceContext>::GEMM_BF16(
+    int M, int N, int K, float alpha, const platform::bfloat16 *A, int lda,
+    const platform::bfloat16 *B, int ldb, float beta, float *C,
+    int ldc) const {
+  GemmBF16(M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
 template <typename DeviceContext>
 template <typename T>
 void Blas<DeviceContext>::MatMul(const framework::Tensor &mat_a, bool trans_a,
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/operators/math/concat_and_split.h"
+#include "paddle/fluid/platform/device_context.h"
 
 namespace paddle {
 namespace framework {
@@ -57,18 +58,23 @@ class ConcatFunctor<platform::CPUDeviceContext, T> {
     }
     auto cpu_place = BOOST_GET_CONST(platform::CPUPlace, context.GetPlace());
 
-    // computation
+    // computation, split by the rows across threads
     auto output_data = output->data<T>();
-    int col_idx = 0;
-    for (int j = 0; j < num; ++j) {
-      int col_len = input_cols[j];
-      auto input_data = input[j].data<T>();
-      for (int k = 0; k < out_rows; ++k) {
-        memory::Copy(cpu_place, output_data + k * out_cols + col_idx, cpu_place,
-                     input_data + k * col_len, sizeof(T) * col_len);
-      }
-      col_idx += col_len;
-    }
+    context.ParallelFor(
+        0, out_rows, platform::CPUDeviceContext::GrainSize(out_cols),
+        [&](int64_t row_begin, int64_t row_end) {
+          int col_idx = 0;
+          for (int j = 0; j < num; ++j) {
+            int col_len = input_cols[j];
+            auto input_data = input[j].data<T>();
+            for (int64_t k = row_begin; k < row_end; ++k) {
+              memory::Copy(cpu_place, output_data + k * out_cols + col_idx,
+                           cpu_place, input_data + k * col_len,
+                           sizeof(T) * col_len);
+            }
+            col_idx += col_len;
+          }
+        });
   }
 };
 
@@ -102,21 +108,25 @@ class SplitFunctor<platform::CPUDeviceContext, T> {
     }
     auto cpu_place = BOOST_GET_CONST(platform::CPUPlace, context.GetPlace());
 
-    // computation
-    for (int k = 0; k < input_rows; ++k) {
-      const T* src_ptr = input.data<T>() + k * input_cols;
-      int col_idx = 0;
-      for (size_t j = 0; j < num; ++j) {
-        int col_len = output_cols[j];
-        auto* out_tensor = outputs->at(j);
-        if (out_tensor != nullptr) {
-          T* dst_ptr = out_tensor->data<T>() + k * col_len;
-          memory::Copy(cpu_place, dst_ptr, cpu_place, src_ptr + col_idx,
-                       sizeof(T) * col_len);
-        }
-        col_idx += col_len;
-      }
-    }
+    // computation, split by the rows across threads
+    context.ParallelFor(
+        0, input_rows, platform::CPUDeviceContext::GrainSize(input_cols),
+        [&](int64_t row_begin, int64_t row_end) {
+          for (int64_t k = row_begin; k < row_end; ++k) {
+            const T* src_ptr = input.data<T>() + k * input_cols;
+            int col_idx = 0;
+            for (size_t j = 0; j < num; ++j) {
+              int col_len = output_cols[j];
+              auto* out_tensor = outputs->at(j);
+              if (out_tensor != nullptr) {
+                T* dst_ptr = out_tensor->data<T>() + k * col_len;
+                memory::Copy(cpu_place, dst_ptr, cpu_place, src_ptr + col_idx,
+                             sizeof(T) * col_len);
+              }
+              col_idx += col_len;
+            }
+          }
+        });
   }
 };
 #define DEFINE_FUNCTOR(type)                                      \
@@ -0,0 +1,662 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/cpu_lowp_gemm.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
+#include "paddle/fluid/platform/cpu_info.h"
+#include "paddle/fluid/platform/enforce.h"
+
+// The AVX512 and AVX2 kernels are compiled with the target attributes, and
+// only called when the CPU supports them, so that the binary built without
+// -mavx512f still runs on the CPUs without them.
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(_WIN32) && \
+    (defined(__clang__) || __GNUC__ >= 8)
+#include <immintrin.h>
+#define PADDLE_WITH_LOWP_GEMM_X86
+#endif
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+namespace {
+
+constexpr int kPanel = kLowpGemmPanelWidth;
+// The number of the rows of C computed by a micro kernel.
+constexpr int kRowBlock = 4;
+// The number of the columns of C computed by a bfloat16 micro kernel.
+constexpr int kBF16ColBlock = 32;
+// The GEMM of fewer multiply-adds runs in one thread.
+constexpr int64_t kLowpGemmParallelThreshold = 1 << 20;
+
+inline int UpDiv(int a, int b) { return (a + b - 1) / b; }
+
+inline float BF16ToFloat(uint16_t x) {
+  uint32_t bits = static_cast<uint32_t>(x) << 16;
+  float f;
+  std::memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+// Compute the rows [0, mr) and the columns [0, nr) of C with a panel of the
+// packed B.
+using U8S8MicroKernel = void (*)(int mr, int nr, int K, const uint8_t* A,
+                                 int lda, const int8_t* panel, int32_t* C,
+                                 int ldc);
+
+// Compute the rows [0, mr) and the columns [0, nr) of C, where nr is at most
+// kBF16ColBlock.
+using BF16MicroKernel = void (*)(int mr, int nr, int K, float alpha,
+                                 const uint16_t* A, int lda, const uint16_t* B,
+                                 int ldb, float beta, float* C, int ldc);
+
+void U8S8Ref(int mr, int nr, int K, const uint8_t* A, int lda,
+             const int8_t* panel, int32_t* C, int ldc) {
+  for (int i = 0; i < mr; ++i) {
+    int32_t acc[kPanel] = {0};
+    const uint8_t* a = A + i * lda;
+    for (int k = 0; k < K; ++k) {
+      const int8_t* b = panel + (k / 4) * kPanel * 4 + k % 4;
+      int32_t a_k = a[k];
+      for (int j = 0; j < kPanel; ++j) {
+        acc[j] += a_k * b[j * 4];
+      }
+    }
+    std::memcpy(C + i * ldc, acc, nr * sizeof(int32_t));
+  }
+}
+
+void BF16Ref(int mr, int nr, int K, float alpha, const uint16_t* A, int lda,
+             const uint16_t* B, int ldb, float beta, float* C, int ldc) {
+  for (int i = 0; i < mr; ++i) {
+    float acc[kBF16ColBlock] = {0};
+    for (int k = 0; k < K; ++k) {
+      float a_k = BF16ToFloat(A[i * lda + k]);
+      for (int j = 0; j < nr; ++j) {
+        acc[j] += a_k * BF16ToFloat(B[k * ldb + j]);
+      }
+    }
+    for (int j = 0; j < nr; ++j) {
+      float* c = C + i * ldc + j;
+      *c = alpha * acc[j] + (beta == 0.0f ? 0.0f : beta * *c);
+    }
+  }
+}
+
+#ifdef PADDLE_WITH_LOWP_GEMM_X86
+
+// Load the 4 elements of a row of A from k, where the ones beyond K are 0.
+inline int32_t LoadQuad(const uint8_t* a, int k, int K) {
+  int32_t quad = 0;
+  if (k + 4 <= K) {
+    std::memcpy(&quad, a + k, sizeof(quad));
+  } else {
+    std::memcpy(&quad, a + k, K - k);
+  }
+  return quad;
+}
+
+template <int MR>
+__attribute__((target("avx512f,avx512bw,avx512vl,avx512dq,avx512vnni")))
+void U8S8Avx512VnniBlock(int nr, int K, const uint8_t* A, int lda,
+                         const int8_t* panel, int32_t* C, int ldc) {
+  __m512i acc[MR];
+  for (int i = 0; i < MR; ++i) {
+    acc[i] = _mm512_setzero_si512();
+  }
+  const int full_quads = K / 4;
+  for (int q = 0; q < full_quads; ++q) {
+    __m512i b = _mm512_loadu_si512(panel + q * kPanel * 4);
+    for (int i = 0; i < MR; ++i) {
+      int32_t quad;
+      std::memcpy(&quad, A + i * lda + q * 4, sizeof(quad));
+      acc[i] = _mm512_dpbusd_epi32(acc[i], _mm512_set1_epi32(quad), b);
+    }
+  }
+  if (K % 4 != 0) {
+    __m512i b = _mm512_loadu_si512(panel + full_quads * kPanel * 4);
+    for (int i = 0; i < MR; ++i) {
+      int32_t quad = LoadQuad(A + i * lda, full_quads * 4, K);
+      acc[i] = _mm512_dpbusd_epi32(acc[i], _mm512_set1_epi32(quad), b);
+    }
+  }
+  __mmask16 mask = static_cast<__mmask16>((1u << nr) - 1);
+  for (int i = 0; i < MR; ++i) {
+    _mm512_mask_storeu_epi32(C + i * ldc, mask, acc[i]);
+  }
+}
+
+void U8S8Avx512Vnni(int mr, int nr, int K, const uint8_t* A, int lda,
+                    const int8_t* panel, int32_t* C, int ldc) {
+  switch (mr) {
+    case 4:
+      U8S8Avx512VnniBlock<4>(nr, K, A, lda, panel, C, ldc);
+      break;
+    case 3:
+      U8S8Avx512VnniBlock<3>(nr, K, A, lda, panel, C, ldc);
+      break;
+    case 2:
+      U8S8Avx512VnniBlock<2>(nr, K, A, lda, panel, C, ldc);
+      break;
+    default:
+      U8S8Avx512VnniBlock<1>(nr, K, A, lda, panel, C, ldc);
+  }
+}
+
+// Without VNNI, the 4 uint8 of A and the int8 of B along K are widened to
+// int16, and multiplied and added in pairs by vpmaddwd, which does not
+// saturate as vpmaddubsw does. The two int32 sums of each column are added up
+// at last.
+__attribute__((target("avx512f,avx512bw,avx512vl,avx512dq"))) inline __m512i
+BroadcastQuadEpi16x32(int32_t quad) {
+  return _mm512_broadcastq_epi64(
+      _mm_cvtepu8_epi16(_mm_cvtsi32_si128(quad)));
+}
+
+template <int MR>
+__attribute__((target("avx512f,avx512bw,avx512vl,avx512dq")))
+void U8S8Avx512Block(int nr, int K, const uint8_t* A, int lda,
+                     const int8_t* panel, int32_t* C, int ldc) {
+  __m512i acc[MR][2];
+  for (int i = 0; i < MR; ++i) {
+    acc[i][0] = _mm512_setzero_si512();
+    acc[i][1] = _mm512_setzero_si512();
+  }
+  const int num_quads = UpDiv(K, 4);
+  for (int q = 0; q < num_quads; ++q) {
+    const __m256i* b = reinterpret_cast<const __m256i*>(panel + q * kPanel * 4);
+    __m512i b0 = _mm512_cvtepi8_epi16(_mm256_loadu_si256(b));
+    __m512i b1 = _mm512_cvtepi8_epi16(_mm256_loadu_si256(b + 1));
+    for (int i = 0; i < MR; ++i) {
+      __m512i a = BroadcastQuadEpi16x32(LoadQuad(A + i * lda, q * 4, K));
+      acc[i][0] = _mm512_add_epi32(acc[i][0], _mm512_madd_epi16(a, b0));
+      acc[i][1] = _mm512_add_epi32(acc[i][1], _mm512_madd_epi16(a, b1));
+    }
+  }
+  for (int i = 0; i < MR; ++i) {
+    int32_t sums[kPanel * 2];
+    _mm512_storeu_si512(sums, acc[i][0]);
+    _mm512_storeu_si512(sums + kPanel, acc[i][1]);
+    for (int j = 0; j < nr; ++j) {
+      C[i * ldc + j] = sums[2 * j] + sums[2 * j + 1];
+    }
+  }
+}
+
+void U8S8Avx512(int mr, int nr, int K, const uint8_t* A, int lda,
+                const int8_t* panel, int32_t* C, int ldc) {
+  switch (mr) {
+    case 4:
+      U8S8Avx512Block<4>(nr, K, A, lda, panel, C, ldc);
+      break;
+    case 3:
+      U8S8Avx512Block<3>(nr, K, A, lda, panel, C, ldc);
+      break;
+    case 2:
+      U8S8Avx512Block<2>(nr, K, A, lda, panel, C, ldc);
+      break;
+    default:
+      U8S8Avx512Block<1>(nr, K, A, lda, panel, C, ldc);
+  }
+}
+
+// The same as U8S8Avx512Block with 256 bits registers, which computes 2 rows
+// to hold the accumulators in the 16 registers.
+template <int MR>
+__attribute__((target("avx2"))) void U8S8Avx2Block(int nr, int K,
+                                                   const uint8_t* A, int lda,
+                                                   const int8_t* panel,
+                                                   int32_t* C, int ldc) {
+  __m256i acc[MR][4];
+  for (int i = 0; i < MR; ++i) {
+    for (int h = 0; h < 4; ++h) {
+      acc[i][h] = _mm256_setzero_si256();
+    }
+  }
+  const int num_quads = UpDiv(K, 4);
+  for (int q = 0; q < num_quads; ++q) {
+    const __m128i* b = reinterpret_cast<const __m128i*>(panel + q * kPanel * 4);
+    __m256i bs[4];
+    for (int h = 0; h < 4; ++h) {
+      bs[h] = _mm256_cvtepi8_epi16(_mm_loadu_si128(b + h));
+    }
+    for (int i = 0; i < MR; ++i) {
+      __m256i a = _mm256_broadcastq_epi64(_mm_cvtepu8_epi16(
+          _mm_cvtsi32_si128(LoadQuad(A + i * lda, q * 4, K))));
+      for (int h = 0; h < 4; ++h) {
+        acc[i][h] = _mm256_add_epi32(acc[i][h], _mm256_madd_epi16(a, bs[h]));
+      }
+    }
+  }
+  for (int i = 0; i < MR; ++i) {
+    int32_t sums[kPanel * 2];
+    for (int h = 0; h < 4; ++h) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(sums + h * 8),
+                          acc[i][h]);
+    }
+    for (int j = 0; j < nr; ++j) {
+      C[i * ldc + j] = sums[2 * j] + sums[2 * j + 1];
+    }
+  }
+}
+
+void U8S8Avx2(int mr, int nr, int K, const uint8_t* A, int lda,
+              const int8_t* panel, int32_t* C, int ldc) {
+  for (int i = 0; i < mr; i += 2) {
+    if (mr - i >= 2) {
+      U8S8Avx2Block<2>(nr, K, A + i * lda, lda, panel, C + i * ldc, ldc);
+    } else {
+      U8S8Avx2Block<1>(nr, K, A + i * lda, lda, panel, C + i * ldc, ldc);
+    }
+  }
+}
+
+template <int MR>
+__attribute__((target("avx512f,avx512bw,avx512vl")))
+void BF16Avx512Block(int nr, int K, float alpha, const uint16_t* A, int lda,
+                     const uint16_t* B, int ldb, float beta, float* C,
+                     int ldc) {
+  // The block is 2 registers wide.
+  __mmask16 mask[2];
+  mask[0] = static_cast<__mmask16>((1u << std::min(nr, 16)) - 1);
+  mask[1] = static_cast<__mmask16>((1u << std::max(nr - 16, 0)) - 1);
+  __m512 acc[MR][2];
+  for (int i = 0; i < MR; ++i) {
+    acc[i][0] = _mm512_setzero_ps();
+    acc[i][1] = _mm512_setzero_ps();
+  }
+  for (int k = 0; k < K; ++k) {
+    // bfloat16 is the higher 16 bits of float.
+    __m512 b[2];
+    for (int h = 0; h < 2; ++h) {
+      b[h] = _mm512_castsi512_ps(_mm512_slli_epi32(
+          _mm512_cvtepu16_epi32(
+              _mm256_maskz_loadu_epi16(mask[h], B + k * ldb + h * 16)),
+          16));
+    }
+    for (int i = 0; i < MR; ++i) {
+      __m512 a = _mm512_set1_ps(BF16ToFloat(A[i * lda + k]));
+      acc[i][0] = _mm512_fmadd_ps(a, b[0], acc[i][0]);
+      acc[i][1] = _mm512_fmadd_ps(a, b[1], acc[i][1]);
+    }
+  }
+  __m512 alpha_v = _mm512_set1_ps(alpha);
+  for (int i = 0; i < MR; ++i) {
+    for (int h = 0; h < 2; ++h) {
+      float* c = C + i * ldc + h * 16;
+      __m512 out = _mm512_mul_ps(acc[i][h], alpha_v);
+      if (beta != 0.0f) {
+        out = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask[h], c),
+                              _mm512_set1_ps(beta), out);
+      }
+      _mm512_mask_storeu_ps(c, mask[h], out);
+    }
+  }
+}
+
+void BF16Avx512(int mr, int nr, int K, float alpha, const uint16_t* A,
+                int lda, const uint16_t* B, int ldb, float beta, float* C,
+                int ldc) {
+  switch (mr) {
+    case 4:
+      BF16Avx512Block<4>(nr, K, alpha, A, lda, B, ldb, beta, C, ldc);
+      break;
+    case 3:
+      BF16Avx512Block<3>(nr, K, alpha, A, lda, B, ldb, beta, C, ldc);
+      break;
+    case 2:
+      BF16Avx512Block<2>(nr, K, alpha, A, lda, B, ldb, beta, C, ldc);
+      break;
+    default:
+      BF16Avx512Block<1>(nr, K, alpha, A, lda, B, ldb, beta, C, ldc);
+  }
+}
+
+__attribute__((target("avx2,fma"))) inline __m256 LoadBF16x8(
+    const uint16_t* src) {
+  __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+  return _mm256_castsi256_ps(
+      _mm256_slli_epi32(_mm256_cvtepu16_epi32(x), 16));
+}
+
+// Compute 16 columns of MR rows.
+template <int MR>
+__attribute__((target("avx2,fma")))
+void BF16Avx2Block(int K, float alpha, const uint16_t* A, int lda,
+                   const uint16_t* B, int ldb, float beta, float* C,
+                   int ldc) {
+  __m256 acc[MR][2];
+  for (int i = 0; i < MR; ++i) {
+    acc[i][0] = _mm256_setzero_ps();
+    acc[i][1] = _mm256_setzero_ps();
+  }
+  for (int k = 0; k < K; ++k) {
+    __m256 b0 = LoadBF16x8(B + k * ldb);
+    __m256 b1 = LoadBF16x8(B + k * ldb + 8);
+    for (int i = 0; i < MR; ++i) {
+      __m256 a = _mm256_set1_ps(BF16ToFloat(A[i * lda + k]));
+      acc[i][0] = _mm256_fmadd_ps(a, b0, acc[i][0]);
+      acc[i][1] = _mm256_fmadd_ps(a, b1, acc[i][1]);
+    }
+  }
+  __m256 alpha_v = _mm256_set1_ps(alpha);
+  __m256 beta_v = _mm256_set1_ps(beta);
+  for (int i = 0; i < MR; ++i) {
+    for (int h = 0; h < 2; ++h) {
+      float* c = C + i * ldc + h * 8;
+      __m256 out = _mm256_mul_ps(acc[i][h], alpha_v);
+      if (beta != 0.0f) {
+        out = _mm256_fmadd_ps(_mm256_loadu_ps(c), beta_v, out);
+      }
+      _mm256_storeu_ps(c, out);
+    }
+  }
+}
+
+void BF16Avx2(int mr, int nr, int K, float alpha, const uint16_t* A, int lda,
+              const uint16_t* B, int ldb, float beta, float* C, int ldc) {
+  for (int j = 0; j < nr; j += 16) {
+    // The last columns fewer than 16.
+    if (nr - j < 16) {
+      BF16Ref(mr, nr - j, K, alpha, A, lda, B + j, ldb, beta, C + j, ldc);
+      continue;
+    }
+    switch (mr) {
+      case 4:
+        BF16Avx2Block<4>(K, alpha, A, lda, B + j, ldb, beta, C + j, ldc);
+        break;
+      case 3:
+        BF16Avx2Block<3>(K, alpha, A, lda, B + j, ldb, beta, C + j, ldc);
+        break;
+      case 2:
+        BF16Avx2Block<2>(K, alpha, A, lda, B + j, ldb, beta, C + j, ldc);
+        break;
+      default:
+        BF16Avx2Block<1>(K, alpha, A, lda, B + j, ldb, beta, C + j, ldc);
+    }
+  }
+}
+
+#endif  // PADDLE_WITH_LOWP_GEMM_X86
+
+struct U8S8Impl {
+  U8S8MicroKernel kernel;
+  const char* name;
+  platform::cpu_isa_t isa;
+};
+
+struct BF16Impl {
+  BF16MicroKernel kernel;
+  const char* name;
+  platform::cpu_isa_t isa;
+};
+
+// All the implementations, from the fastest.
+const std::vector<U8S8Impl>& U8S8Impls() {
+  static const std::vector<U8S8Impl> impls = {
+#ifdef PADDLE_WITH_LOWP_GEMM_X86
+      {U8S8Avx512Vnni, "avx512_vnni", platform::avx512_core_vnni},
+      {U8S8Avx512, "avx512", platform::avx512_core},
+      {U8S8Avx2, "avx2", platform::avx2},
+#endif
+      {U8S8Ref, "reference", platform::isa_any},
+  };
+  return impls;
+}
+
+const std::vector<BF16Impl>& BF16Impls() {
+  static const std::vector<BF16Impl> impls = {
+#ifdef PADDLE_WITH_LOWP_GEMM_X86
+      {BF16Avx512, "avx512", platform::avx512_core},
+      {BF16Avx2, "avx2", platform::avx2},
+#endif
+      {BF16Ref, "reference", platform::isa_any},
+  };
+  return impls;
+}
+
+// The fastest implementation the CPU supports, or the one named impl.
+template <typename Impl>
+const Impl& ChooseImpl(const std::vector<Impl>& impls, const char* impl) {
+  for (auto& candidate : impls) {
+    if (impl == nullptr ? platform::MayIUse(candidate.isa)
+                        : std::strcmp(candidate.name, impl) == 0) {
+      PADDLE_ENFORCE_EQ(
+          platform::MayIUse(candidate.isa), true,
+          platform::errors::Unavailable(
+              "The CPU does not support the %s implementation of the low "
+              "precision GEMM.",
+              candidate.name));
+      return candidate;
+    }
+  }
+  PADDLE_THROW(platform::errors::NotFound(
+      "No implementation of the low precision GEMM is named %s.", impl));
+}
+
+const U8S8Impl& GetU8S8Impl() {
+  static const U8S8Impl& impl = ChooseImpl(U8S8Impls(), nullptr);
+  return impl;
+}
+
+const BF16Impl& GetBF16Impl() {
+  static const BF16Impl& impl = ChooseImpl(BF16Impls(), nullptr);
+  return impl;
+}
+
+template <typename Impl>
+std::vector<LowpGemmImplInfo> ListImpls(const std::vector<Impl>& impls) {
+  std::vector<LowpGemmImplInfo> infos;
+  for (auto& impl : impls) {
+    infos.push_back({impl.name, platform::MayIUse(impl.isa)});
+  }
+  return infos;
+}
+
+void GemmU8S8S32PackedWithKernel(U8S8MicroKernel kernel, int M, int N, int K,
+                                 const uint8_t* A, int lda,
+                                 const int8_t* packed_b, int32_t* C,
+                                 int ldc) {
+  const int num_panels = UpDiv(N, kPanel);
+  const int num_row_blocks = UpDiv(M, kRowBlock);
+  const int64_t panel_size = static_cast<int64_t>(UpDiv(K, 4)) * kPanel * 4;
+  // The consecutive blocks share a panel of B.
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (static_cast<int64_t>(M) * N * K > \
+                             kLowpGemmParallelThreshold)
+#endif
+  for (int t = 0; t < num_panels * num_row_blocks; ++t) {
+    int p = t / num_row_blocks;
+    int i = (t % num_row_blocks) * kRowBlock;
+    int j = p * kPanel;
+    kernel(std::min(kRowBlock, M - i), std::min(kPanel, N - j), K,
+           A + i * lda, lda, packed_b + p * panel_size, C + i * ldc + j, ldc);
+  }
+}
+
+void GemmBF16WithKernel(BF16MicroKernel kernel, int M, int N, int K,
+                        float alpha, const platform::bfloat16* A, int lda,
+                        const platform::bfloat16* B, int ldb, float beta,
+                        float* C, int ldc) {
+  const uint16_t* a = reinterpret_cast<const uint16_t*>(A);
+  const uint16_t* b = reinterpret_cast<const uint16_t*>(B);
+  const int num_col_blocks = UpDiv(N, kBF16ColBlock);
+  const int num_row_blocks = UpDiv(M, kRowBlock);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (static_cast<int64_t>(M) * N * K > \
+                             kLowpGemmParallelThreshold)
+#endif
+  for (int t = 0; t < num_col_blocks * num_row_blocks; ++t) {
+    int i = (t % num_row_blocks) * kRowBlock;
+    int j = (t / num_row_blocks) * kBF16ColBlock;
+    kernel(std::min(kRowBlock, M - i), std::min(kBF16ColBlock, N - j), K,
+           alpha, a + i * lda, lda, b + j, ldb, beta, C + i * ldc + j, ldc);
+  }
+}
+
+}  // namespace
+
+int64_t PackedGemmS8BSize(int K, int N) {
+  return static_cast<int64_t>(UpDiv(N, kPanel)) * UpDiv(K, 4) * kPanel * 4;
+}
+
+void PackGemmS8B(int K, int N, const int8_t* B, int ldb, int8_t* packed_b,
+                 int32_t* col_sum) {
+  const int num_quads = UpDiv(K, 4);
+  std::memset(packed_b, 0, PackedGemmS8BSize(K, N));
+  for (int k = 0; k < K; ++k) {
+    for (int n = 0; n < N; ++n) {
+      int64_t offset =
+          ((static_cast<int64_t>(n / kPanel) * num_quads + k / 4) * kPanel +
+           n % kPanel) *
+              4 +
+          k % 4;
+      packed_b[offset] = B[k * ldb + n];
+    }
+  }
+  if (col_sum) {
+    std::fill(col_sum, col_sum + N, 0);
+    for (int k = 0; k < K; ++k) {
+      for (int n = 0; n < N; ++n) {
+        col_sum[n] += B[k * ldb + n];
+      }
+    }
+  }
+}
+
+void GemmU8S8S32Packed(int M, int N, int K, const uint8_t* A, int lda,
+                       const int8_t* packed_b, int32_t* C, int ldc) {
+  GemmU8S8S32PackedWithKernel(GetU8S8Impl().kernel, M, N, K, A, lda, packed_b,
+                              C, ldc);
+}
+
+void GemmU8S8S32PackedWithImpl(const char* impl, int M, int N, int K,
+                               const uint8_t* A, int lda,
+                               const int8_t* packed_b, int32_t* C, int ldc) {
+  GemmU8S8S32PackedWithKernel(ChooseImpl(U8S8Impls(), impl).kernel, M, N, K, A,
+                              lda, packed_b, C, ldc);
+}
+
+void GemmU8S8S32(int M, int N, int K, const uint8_t* A, int lda,
+                 const int8_t* B, int ldb, int32_t* C, int ldc) {
+  std::vector<int8_t> packed_b(PackedGemmS8BSize(K, N));
+  PackGemmS8B(K, N, B, ldb, packed_b.data(), nullptr);
+  GemmU8S8S32Packed(M, N, K, A, lda, packed_b.data(), C, ldc);
+}
+
+void GemmBF16(int M, int N, int K, float alpha, const platform::bfloat16* A,
+              int lda, const platform::bfloat16* B, int ldb, float beta,
+              float* C, int ldc) {
+  GemmBF16WithKernel(GetBF16Impl().kernel, M, N, K, alpha, A, lda, B, ldb,
+                     beta, C, ldc);
+}
+
+void GemmBF16WithImpl(const char* impl, int M, int N, int K, float alpha,
+                      const platform::bfloat16* A, int lda,
+                      const platform::bfloat16* B, int ldb, float beta,
+                      float* C, int ldc) {
+  GemmBF16WithKernel(ChooseImpl(BF16Impls(), impl).kernel, M, N, K, alpha, A,
+                     lda, B, ldb, beta, C, ldc);
+}
+
+const char* GemmU8S8S32ImplType() { return GetU8S8Impl().name; }
+
+const char* GemmBF16ImplType() { return GetBF16Impl().name; }
+
+std::vector<LowpGemmImplInfo> GemmU8S8S32Impls() {
+  return ListImpls(U8S8Impls());
+}
+
+std::vector<LowpGemmImplInfo> GemmBF16Impls() { return ListImpls(BF16Impls()); }
+
+void PackInt8Weights(int K, int N, const float* W, const float* w_scales,
+                     int num_w_scales, PackedInt8Weights* packed) {
+  PADDLE_ENFORCE_EQ(
+      num_w_scales == 1 || num_w_scales == N, true,
+      platform::errors::InvalidArgument(
+          "The number of the scales of the weights should be 1 or the number "
+          "of the columns %d, but received %d.",
+          N, num_w_scales));
+  packed->K = K;
+  packed->N = N;
+  packed->scales.resize(N);
+  for (int n = 0; n < N; ++n) {
+    packed->scales[n] = w_scales[num_w_scales == 1 ? 0 : n];
+  }
+  std::vector<int8_t> weights(static_cast<int64_t>(K) * N);
+  for (int k = 0; k < K; ++k) {
+    for (int n = 0; n < N; ++n) {
+      float scale = packed->scales[n];
+      float q = scale > 0.0f ? std::round(W[k * N + n] / scale) : 0.0f;
+      weights[k * N + n] =
+          static_cast<int8_t>(std::min(std::max(q, -127.0f), 127.0f));
+    }
+  }
+  packed->data.resize(PackedGemmS8BSize(K, N));
+  packed->col_sum.resize(N);
+  PackGemmS8B(K, N, weights.data(), N, packed->data.data(),
+              packed->col_sum.data());
+}
+
+void MatMulInt8(int M, const float* X, float x_scale,
+                const PackedInt8Weights& W, float* Y) {
+  PADDLE_ENFORCE_GT(x_scale, 0.0f,
+                    platform::errors::InvalidArgument(
+                        "The scale of the input should be positive, but "
+                        "received %f.",
+                        x_scale));
+  const int K = W.K;
+  const int N = W.N;
+  // The signed X is shifted by 128 to uint8, and the shift is subtracted
+  // with the sums of the columns of W after the GEMM.
+  std::vector<uint8_t> x_q(static_cast<int64_t>(M) * K);
+  const float inv_scale = 1.0f / x_scale;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (static_cast<int64_t>(M) * K > \
+                             kLowpGemmParallelThreshold)
+#endif
+  for (int i = 0; i < M; ++i) {
+    for (int k = 0; k < K; ++k) {
+      float q = std::round(X[i * K + k] * inv_scale);
+      x_q[i * K + k] =
+          static_cast<uint8_t>(std::min(std::max(q, -127.0f), 127.0f) + 128);
+    }
+  }
+
+  std::vector<int32_t> acc(static_cast<int64_t>(M) * N);
+  GemmU8S8S32Packed(M, N, K, x_q.data(), K, W.data.data(), acc.data(), N);
+
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (static_cast<int64_t>(M) * N > \
+                             kLowpGemmParallelThreshold)
+#endif
+  for (int i = 0; i < M; ++i) {
+    for (int n = 0; n < N; ++n) {
+      Y[i * N + n] = (acc[i * N + n] - 128 * W.col_sum[n]) * x_scale *
+                     W.scales[n];
+    }
+  }
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
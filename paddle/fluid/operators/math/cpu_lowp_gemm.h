@@ -0,0 +1,111 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "paddle/fluid/platform/bfloat16.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+// The GEMM of the reduced precision types on CPU, which does not depend on
+// MKL-DNN. The implementation is chosen at runtime by the instruction sets
+// the CPU supports:
+//   - int8: AVX512 VNNI, AVX512, AVX2, otherwise the reference one.
+//   - bfloat16: AVX512, AVX2, otherwise the reference one.
+// All the matrices are in row major.
+
+// The int8 B is packed into panels of kLowpGemmPanelWidth columns, where the
+// 4 consecutive elements of a column along K are contiguous, as the AVX512
+// VNNI instruction vpdpbusd reads them.
+constexpr int kLowpGemmPanelWidth = 16;
+
+// The size in bytes of the int8 B of shape [K, N] packed by PackGemmS8B.
+int64_t PackedGemmS8BSize(int K, int N);
+
+// Pack the int8 B of shape [K, N] into packed_b. The sum of each column of B
+// is written into col_sum if it is not nullptr, which compensates the shift
+// of the signed A to uint8.
+void PackGemmS8B(int K, int N, const int8_t* B, int ldb, int8_t* packed_b,
+                 int32_t* col_sum);
+
+// C = A * B, where A of shape [M, K] is uint8, B of shape [K, N] is int8
+// packed by PackGemmS8B, and C is int32.
+void GemmU8S8S32Packed(int M, int N, int K, const uint8_t* A, int lda,
+                       const int8_t* packed_b, int32_t* C, int ldc);
+
+// C = A * B, which packs B on every call.
+void GemmU8S8S32(int M, int N, int K, const uint8_t* A, int lda,
+                 const int8_t* B, int ldb, int32_t* C, int ldc);
+
+// C = alpha * A * B + beta * C, where A of shape [M, K] and B of shape
+// [K, N] are bfloat16, and C is float. The products are accumulated in float.
+void GemmBF16(int M, int N, int K, float alpha, const platform::bfloat16* A,
+              int lda, const platform::bfloat16* B, int ldb, float beta,
+              float* C, int ldc);
+
+// The names of the implementations in use, for logging.
+const char* GemmU8S8S32ImplType();
+const char* GemmBF16ImplType();
+
+// An implementation of the GEMM, and whether the CPU supports it.
+struct LowpGemmImplInfo {
+  const char* name;
+  bool supported;
+};
+
+// All the implementations compiled in, from the fastest. The tests run each
+// of them the CPU supports against the reference one.
+std::vector<LowpGemmImplInfo> GemmU8S8S32Impls();
+std::vector<LowpGemmImplInfo> GemmBF16Impls();
+
+// The GEMMs above computed with the implementation named impl, which must be
+// supported by the CPU.
+void GemmU8S8S32PackedWithImpl(const char* impl, int M, int N, int K,
+                               const uint8_t* A, int lda,
+                               const int8_t* packed_b, int32_t* C, int ldc);
+void GemmBF16WithImpl(const char* impl, int M, int N, int K, float alpha,
+                      const platform::bfloat16* A, int lda,
+                      const platform::bfloat16* B, int ldb, float beta,
+                      float* C, int ldc);
+
+// The float weights of shape [K, N] of fc or mul quantized to int8 and
+// packed for GemmU8S8S32Packed.
+struct PackedInt8Weights {
+  int K{0};
+  int N{0};
+  std::vector<int8_t> data;
+  std::vector<int32_t> col_sum;
+  // The scale of each column, the product of which with the int8 weight is
+  // the float weight.
+  std::vector<float> scales;
+};
+
+// Quantize the float W of shape [K, N] with w_scales, which holds either one
+// scale or a scale per column, and pack it into packed.
+void PackInt8Weights(int K, int N, const float* W, const float* w_scales,
+                     int num_w_scales, PackedInt8Weights* packed);
+
+// Y = X * W computed in int8, where the float X of shape [M, K] is quantized
+// with x_scale, which is the float value of an int8 step of X.
+void MatMulInt8(int M, const float* X, float x_scale,
+                const PackedInt8Weights& W, float* Y);
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
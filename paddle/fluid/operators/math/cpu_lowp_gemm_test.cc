@@ -0,0 +1,261 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/cpu_lowp_gemm.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/operators/math/blas.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+template <typename T>
+static std::vector<T> RandomInts(int64_t n, int low, int high) {
+  static std::mt19937 rng(100);
+  std::uniform_int_distribution<int> dist(low, high);
+  std::vector<T> data(n);
+  for (auto& x : data) {
+    x = static_cast<T>(dist(rng));
+  }
+  return data;
+}
+
+static std::vector<float> RandomFloats(int64_t n, float low, float high) {
+  static std::mt19937 rng(200);
+  std::uniform_real_distribution<float> dist(low, high);
+  std::vector<float> data(n);
+  for (auto& x : data) {
+    x = dist(rng);
+  }
+  return data;
+}
+
+static std::vector<platform::bfloat16> ToBF16(const std::vector<float>& x) {
+  std::vector<platform::bfloat16> y(x.size());
+  for (size_t i = 0; i < x.size(); ++i) {
+    y[i] = platform::bfloat16(x[i]);
+  }
+  return y;
+}
+
+// The shapes cover the tails of the micro kernels.
+static const int kMs[] = {1, 3, 4, 5, 17};
+static const int kNs[] = {1, 15, 16, 17, 33, 40};
+static const int kKs[] = {1, 3, 4, 7, 64, 130};
+
+// Check the implementation in use through blas and every implementation the
+// CPU supports, where the unsupported ones are skipped.
+TEST(CpuLowpGemm, U8S8S32) {
+  LOG(INFO) << "int8 GEMM implementation: " << GemmU8S8S32ImplType();
+  platform::CPUDeviceContext context((platform::CPUPlace()));
+  auto blas = GetBlas<platform::CPUDeviceContext, float>(context);
+  auto impls = GemmU8S8S32Impls();
+  for (auto& impl : impls) {
+    if (!impl.supported) {
+      LOG(INFO) << "Skip the unsupported int8 GEMM implementation "
+                << impl.name;
+    }
+  }
+  for (int M : kMs) {
+    for (int N : kNs) {
+      for (int K : kKs) {
+        auto A = RandomInts<uint8_t>(M * K, 0, 255);
+        auto B = RandomInts<int8_t>(K * N, -128, 127);
+        std::vector<int32_t> expected(M * N, 0);
+        for (int i = 0; i < M; ++i) {
+          for (int j = 0; j < N; ++j) {
+            for (int k = 0; k < K; ++k) {
+              expected[i * N + j] += A[i * K + k] * B[k * N + j];
+            }
+          }
+        }
+        std::vector<int32_t> C(M * N);
+        blas.GEMM_U8S8S32(M, N, K, A.data(), K, B.data(), N, C.data(), N);
+        ASSERT_EQ(C, expected) << "M=" << M << " N=" << N << " K=" << K;
+        std::vector<int8_t> packed_b(PackedGemmS8BSize(K, N));
+        PackGemmS8B(K, N, B.data(), N, packed_b.data(), nullptr);
+        for (auto& impl : impls) {
+          if (!impl.supported) continue;
+          std::fill(C.begin(), C.end(), -1);
+          GemmU8S8S32PackedWithImpl(impl.name, M, N, K, A.data(), K,
+                                    packed_b.data(), C.data(), N);
+          ASSERT_EQ(C, expected) << impl.name << " M=" << M << " N=" << N
+                                 << " K=" << K;
+        }
+      }
+    }
+  }
+}
+
+TEST(CpuLowpGemm, BF16) {
+  LOG(INFO) << "bfloat16 GEMM implementation: " << GemmBF16ImplType();
+  platform::CPUDeviceContext context((platform::CPUPlace()));
+  auto blas = GetBlas<platform::CPUDeviceContext, float>(context);
+  auto impls = GemmBF16Impls();
+  for (auto& impl : impls) {
+    if (!impl.supported) {
+      LOG(INFO) << "Skip the unsupported bfloat16 GEMM implementation "
+                << impl.name;
+    }
+  }
+  auto check = [](const char* impl, int M, int N, int K, float beta,
+                  const std::vector<float>& expected,
+                  const std::vector<float>& C) {
+    for (int i = 0; i < M * N; ++i) {
+      ASSERT_NEAR(C[i], expected[i], 1e-3)
+          << impl << " M=" << M << " N=" << N << " K=" << K
+          << " beta=" << beta;
+    }
+  };
+  for (int M : kMs) {
+    for (int N : kNs) {
+      for (int K : kKs) {
+        auto A = ToBF16(RandomFloats(M * K, -1.0f, 1.0f));
+        auto B = ToBF16(RandomFloats(K * N, -1.0f, 1.0f));
+        for (float beta : {0.0f, 2.0f}) {
+          std::vector<float> expected(M * N);
+          for (int i = 0; i < M; ++i) {
+            for (int j = 0; j < N; ++j) {
+              float sum = 0.0f;
+              for (int k = 0; k < K; ++k) {
+                sum += static_cast<float>(A[i * K + k]) *
+                       static_cast<float>(B[k * N + j]);
+              }
+              expected[i * N + j] = 0.5f * sum + beta;
+            }
+          }
+          std::vector<float> C(M * N, 1.0f);
+          blas.GEMM_BF16(M, N, K, 0.5f, A.data(), K, B.data(), N, beta,
+                         C.data(), N);
+          check(GemmBF16ImplType(), M, N, K, beta, expected, C);
+          for (auto& impl : impls) {
+            if (!impl.supported) continue;
+            std::fill(C.begin(), C.end(), 1.0f);
+            GemmBF16WithImpl(impl.name, M, N, K, 0.5f, A.data(), K, B.data(),
+                             N, beta, C.data(), N);
+            check(impl.name, M, N, K, beta, expected, C);
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(CpuLowpGemm, UnsupportedImpl) {
+  std::vector<int32_t> C(1);
+  std::vector<int8_t> packed_b(PackedGemmS8BSize(1, 1));
+  uint8_t a = 1;
+  EXPECT_ANY_THROW(GemmU8S8S32PackedWithImpl("no_such_impl", 1, 1, 1, &a, 1,
+                                             packed_b.data(), C.data(), 1));
+}
+
+TEST(CpuLowpGemm, MatMulInt8) {
+  const int M = 9, N = 40, K = 70;
+  const float x_scale = 1.0f / 127;
+  auto X = RandomFloats(M * K, -1.0f, 1.0f);
+  // The weights restored from int8 with a scale per column.
+  std::vector<float> w_scales = RandomFloats(N, 0.001f, 0.01f);
+  auto W = RandomInts<float>(K * N, -127, 127);
+  for (int k = 0; k < K; ++k) {
+    for (int n = 0; n < N; ++n) {
+      W[k * N + n] *= w_scales[n];
+    }
+  }
+  PackedInt8Weights packed_w;
+  PackInt8Weights(K, N, W.data(), w_scales.data(), N, &packed_w);
+  std::vector<float> Y(M * N);
+  MatMulInt8(M, X.data(), x_scale, packed_w, Y.data());
+  for (int i = 0; i < M; ++i) {
+    for (int n = 0; n < N; ++n) {
+      // Only X is rounded, by half a step at most.
+      float expected = 0.0f, error = 0.0f;
+      for (int k = 0; k < K; ++k) {
+        expected += X[i * K + k] * W[k * N + n];
+        error += 0.5f * x_scale * std::fabs(W[k * N + n]);
+      }
+      EXPECT_NEAR(Y[i * N + n], expected, error + 1e-4);
+    }
+  }
+}
+
+template <typename Func>
+static double BenchmarkMs(Func func) {
+  const int kRepeat = 20;
+  func();  // Warm up
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kRepeat; ++i) {
+    func();
+  }
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+             .count() /
+         kRepeat;
+}
+
+TEST(CpuLowpGemm, Benchmark) {
+  platform::CPUDeviceContext context((platform::CPUPlace()));
+  auto blas = GetBlas<platform::CPUDeviceContext, float>(context);
+  // [M, N, K] of the fc of the typical inference models, e.g. BERT and
+  // the CTR models.
+  const std::vector<std::vector<int>> shapes = {
+      {1, 768, 768},   {16, 768, 768},   {128, 768, 768}, {128, 3072, 768},
+      {128, 768, 3072}, {512, 512, 1024}, {1024, 128, 512}};
+  for (auto& shape : shapes) {
+    const int M = shape[0], N = shape[1], K = shape[2];
+    auto A = RandomFloats(M * K, -1.0f, 1.0f);
+    auto B = RandomFloats(K * N, -1.0f, 1.0f);
+    std::vector<float> C(M * N);
+    double fp32_ms = BenchmarkMs([&] {
+      blas.GEMM(CblasNoTrans, CblasNoTrans, M, N, K, 1.0f, A.data(),
+                B.data(), 0.0f, C.data());
+    });
+
+    auto A_bf16 = ToBF16(A);
+    auto B_bf16 = ToBF16(B);
+    double bf16_ms = BenchmarkMs([&] {
+      blas.GEMM_BF16(M, N, K, 1.0f, A_bf16.data(), K, B_bf16.data(), N, 0.0f,
+                     C.data(), N);
+    });
+
+    auto A_u8 = RandomInts<uint8_t>(M * K, 0, 255);
+    auto B_s8 = RandomInts<int8_t>(K * N, -127, 127);
+    std::vector<int8_t> packed_b(PackedGemmS8BSize(K, N));
+    PackGemmS8B(K, N, B_s8.data(), N, packed_b.data(), nullptr);
+    std::vector<int32_t> C_s32(M * N);
+    double int8_ms = BenchmarkMs([&] {
+      GemmU8S8S32Packed(M, N, K, A_u8.data(), K, packed_b.data(),
+                        C_s32.data(), N);
+    });
+
+    double gops = 2.0 * M * N * K / 1e6;
+    LOG(INFO) << "GEMM [" << M << ", " << N << ", " << K
+              << "] fp32: " << fp32_ms << " ms (" << gops / fp32_ms
+              << " GFLOPS), bf16 (" << GemmBF16ImplType() << "): " << bf16_ms
+              << " ms (" << gops / bf16_ms << " GFLOPS), int8 ("
+              << GemmU8S8S32ImplType() << "): " << int8_ms << " ms ("
+              << gops / int8_ms << " GOPS)";
+  }
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
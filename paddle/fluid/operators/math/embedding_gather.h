@@ -0,0 +1,160 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+
+#include "paddle/fluid/framework/mixed_vector.h"
+#include "paddle/fluid/operators/jit/kernels.h"
+
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+// The rows are processed by multiple threads if the number of elements to
+// copy is larger than this.
+static constexpr int64_t kEmbeddingParallelThreshold = 1 << 15;
+// Prefetch the row which is used kEmbeddingPrefetchDistance rows later.
+static constexpr int64_t kEmbeddingPrefetchDistance = 8;
+// At most so many bytes of a row are prefetched. The embedding rows of CTR
+// models are usually short, and the hardware prefetcher catches up with the
+// rest of a long row.
+static constexpr int64_t kEmbeddingPrefetchBytes = 256;
+
+template <typename T>
+inline void PrefetchRow(const T* row, int64_t width) {
+#if defined(__GNUC__) || defined(__clang__)
+  const char* ptr = reinterpret_cast<const char*>(row);
+  int64_t bytes =
+      std::min<int64_t>(width * sizeof(T), kEmbeddingPrefetchBytes);
+  for (int64_t offset = 0; offset < bytes; offset += 64) {
+    __builtin_prefetch(ptr + offset);
+  }
+#endif
+}
+
+// output[i] = table[index[i]] for each i in [0, num), where the rows of table
+// and output have width elements. A negative index means padding, and results
+// in a row of zeros. The indices must have been checked by the caller.
+template <typename T>
+void GatherRows(const T* table, int64_t width, const int64_t* index,
+                int64_t num, T* output) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (num * width > kEmbeddingParallelThreshold)
+#endif
+  for (int64_t i = 0; i < num; ++i) {
+    if (i + kEmbeddingPrefetchDistance < num &&
+        index[i + kEmbeddingPrefetchDistance] >= 0) {
+      PrefetchRow(table + index[i + kEmbeddingPrefetchDistance] * width,
+                  width);
+    }
+    if (index[i] < 0) {
+      std::memset(output + i * width, 0, width * sizeof(T));
+    } else {
+      std::memcpy(output + i * width, table + index[i] * width,
+                  width * sizeof(T));
+    }
+  }
+}
+
+// output[index[i]] += input[i] for each i in [0, num), where the rows of input
+// and output have width elements, and the negative indices are skipped. Each
+// thread owns the output rows of the same remainder modulo the number of
+// threads, so that no row is accumulated by two threads.
+template <typename T>
+void ScatterAddRows(const T* input, int64_t width, const int64_t* index,
+                    int64_t num, T* output) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel if (num * width > kEmbeddingParallelThreshold)
+#endif
+  {
+    int64_t num_threads = 1;
+    int64_t thread_id = 0;
+#ifdef PADDLE_WITH_MKLML
+    num_threads = omp_get_num_threads();
+    thread_id = omp_get_thread_num();
+#endif
+    for (int64_t i = 0; i < num; ++i) {
+      int64_t row = index[i];
+      if (row < 0 || row % num_threads != thread_id) continue;
+      const T* src = input + i * width;
+      T* dst = output + row * width;
+      for (int64_t j = 0; j < width; ++j) {
+        dst[j] += src[j];
+      }
+    }
+  }
+}
+
+// Pool the rows of table indexed by each sequence of ids by summation, which
+// is jit::EmbSeqPool over the sequences in parallel. The ids of the i-th
+// sequence are ids[lod[i] * idx_width, lod[i + 1] * idx_width), and the
+// result is written to output + i * out_width.
+template <typename T>
+void EmbeddingSeqPool(const T* table, int64_t table_height,
+                      int64_t table_width, const int64_t* ids,
+                      const framework::Vector<size_t>& lod, int64_t idx_width,
+                      int64_t out_width, T* output) {
+  jit::emb_seq_pool_attr_t attr(table_height, table_width, 0, idx_width,
+                                out_width, jit::SeqPoolType::kSum);
+  auto emb_seqpool =
+      jit::KernelFuncs<jit::EmbSeqPoolTuple<T>, platform::CPUPlace>::Cache()
+          .At(attr);
+  int64_t num_seq = static_cast<int64_t>(lod.size()) - 1;
+  const size_t* offset = lod.data();
+  int64_t num_ids = static_cast<int64_t>(offset[num_seq]) * idx_width;
+  // Check the ids here, since the exceptions can not be thrown out of the
+  // parallel region.
+  for (int64_t i = 0; i < num_ids; ++i) {
+    PADDLE_ENFORCE_LT(
+        ids[i], table_height,
+        platform::errors::InvalidArgument(
+            "The id should be less than the height of the table %ld, but the "
+            "%ld-th id is %ld.",
+            table_height, i, ids[i]));
+    PADDLE_ENFORCE_GE(ids[i], 0, platform::errors::InvalidArgument(
+                                     "The id should be greater than or equal "
+                                     "to 0, but the %ld-th id is %ld.",
+                                     i, ids[i]));
+  }
+
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for firstprivate(attr) \
+    if (num_ids * table_width > kEmbeddingParallelThreshold)
+#endif
+  for (int64_t i = 0; i < num_seq; ++i) {
+    // Prefetch the first rows of the next sequence while pooling this one.
+    if (i + 1 < num_seq) {
+      int64_t begin = offset[i + 1] * idx_width;
+      int64_t end = std::min<int64_t>(offset[i + 2] * idx_width,
+                                      begin + kEmbeddingPrefetchDistance);
+      for (int64_t j = begin; j < end; ++j) {
+        PrefetchRow(table + ids[j] * table_width, table_width);
+      }
+    }
+    attr.index_height = offset[i + 1] - offset[i];
+    emb_seqpool(table, ids + offset[i] * idx_width, output + i * out_width,
+                &attr);
+  }
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
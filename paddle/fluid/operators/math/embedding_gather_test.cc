@@ -0,0 +1,154 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/embedding_gather.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+static std::vector<float> RandomTable(int64_t height, int64_t width) {
+  std::mt19937 rng(100);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::vector<float> table(height * width);
+  for (auto& value : table) {
+    value = dist(rng);
+  }
+  return table;
+}
+
+// The ids of CTR models follow a power law, where a few ids are very hot.
+static std::vector<int64_t> PowerLawIds(int64_t num, int64_t height) {
+  std::mt19937 rng(200);
+  std::uniform_real_distribution<double> dist(0.0, 1.0);
+  std::vector<int64_t> ids(num);
+  for (auto& id : ids) {
+    id = static_cast<int64_t>(std::pow(dist(rng), 3.0) * height);
+    id = std::min(id, height - 1);
+  }
+  return ids;
+}
+
+TEST(EmbeddingGather, GatherAndScatterAdd) {
+  const int64_t height = 1000;
+  for (int64_t width : {1, 9, 16, 64}) {
+    for (int64_t num : {0, 7, 50000}) {
+      auto table = RandomTable(height, width);
+      auto index = PowerLawIds(num, height);
+      for (int64_t i = 0; i < num; i += 5) {
+        index[i] = -1;
+      }
+
+      std::vector<float> output(num * width, 1.0f);
+      GatherRows(table.data(), width, index.data(), num, output.data());
+      for (int64_t i = 0; i < num; ++i) {
+        for (int64_t j = 0; j < width; ++j) {
+          float expect = index[i] < 0 ? 0.0f : table[index[i] * width + j];
+          ASSERT_EQ(output[i * width + j], expect);
+        }
+      }
+
+      std::vector<float> grad(height * width, 0.0f);
+      std::vector<float> expect_grad(height * width, 0.0f);
+      ScatterAddRows(output.data(), width, index.data(), num, grad.data());
+      for (int64_t i = 0; i < num; ++i) {
+        if (index[i] < 0) continue;
+        for (int64_t j = 0; j < width; ++j) {
+          expect_grad[index[i] * width + j] += output[i * width + j];
+        }
+      }
+      for (int64_t k = 0; k < height * width; ++k) {
+        ASSERT_NEAR(grad[k], expect_grad[k], 1e-3);
+      }
+    }
+  }
+}
+
+TEST(EmbeddingGather, EmbeddingSeqPool) {
+  const int64_t height = 1000;
+  const int64_t width = 8;
+  const int64_t idx_width = 2;
+  framework::Vector<size_t> lod = {0, 3, 3, 10, 11};
+  auto table = RandomTable(height, width);
+  auto ids = PowerLawIds(lod.back() * idx_width, height);
+  std::vector<float> output((lod.size() - 1) * width * idx_width, 0.0f);
+  EmbeddingSeqPool(table.data(), height, width, ids.data(), lod, idx_width,
+                   width * idx_width, output.data());
+  for (size_t i = 0; i + 1 < lod.size(); ++i) {
+    if (lod[i] == lod[i + 1]) continue;
+    for (int64_t w = 0; w < idx_width; ++w) {
+      for (int64_t j = 0; j < width; ++j) {
+        float expect = 0.0f;
+        for (size_t h = lod[i]; h < lod[i + 1]; ++h) {
+          expect += table[ids[h * idx_width + w] * width + j];
+        }
+        EXPECT_NEAR(output[(i * idx_width + w) * width + j], expect, 1e-5);
+      }
+    }
+  }
+
+  ids[3] = height;
+  EXPECT_ANY_THROW(EmbeddingSeqPool(table.data(), height, width, ids.data(),
+                                    lod, idx_width, width * idx_width,
+                                    output.data()));
+}
+
+TEST(EmbeddingGather, Benchmark) {
+  const int64_t height = 1 << 20;
+  const int64_t width = 16;
+  const int64_t batch_size = 512;
+  const int kRepeat = 10;
+  auto table = RandomTable(height, width);
+  for (int64_t num_slots : {26, 100, 300}) {
+    int64_t num = batch_size * num_slots;
+    auto index = PowerLawIds(num, height);
+    std::vector<float> output(num * width);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < kRepeat; ++r) {
+      for (int64_t i = 0; i < num; ++i) {
+        std::memcpy(output.data() + i * width, table.data() + index[i] * width,
+                    width * sizeof(float));
+      }
+    }
+    double row_by_row_ms = std::chrono::duration<double, std::milli>(
+                               std::chrono::steady_clock::now() - start)
+                               .count() /
+                           kRepeat;
+
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < kRepeat; ++r) {
+      GatherRows(table.data(), width, index.data(), num, output.data());
+    }
+    double gather_ms = std::chrono::duration<double, std::milli>(
+                           std::chrono::steady_clock::now() - start)
+                           .count() /
+                       kRepeat;
+    LOG(INFO) << "Lookup " << num_slots << " slots of batch " << batch_size
+              << ", row by row: " << row_by_row_ms
+              << " ms, GatherRows: " << gather_ms << " ms";
+  }
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,175 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
+#include "paddle/fluid/platform/cpu_info.h"
+
+// The AVX512 and AVX2 kernels of DequantAddRow are compiled with the target
+// attributes, and only called when the CPU supports them, as the ones in
+// packed_gemm.cc.
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(_WIN32) && \
+    (defined(__clang__) || __GNUC__ >= 8)
+#include <immintrin.h>
+#define PADDLE_WITH_EMBEDDING_QUANT_X86
+#endif
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+// A row of a quantized embedding table is laid out as lookup_table_dequant
+// expects, all in float: [min, max, codes...], where 4 uint8 codes are packed
+// into a float, and the value of code q is min + q * (max - min) / 256.
+static constexpr int64_t kQuantEmbeddingHeadWidth = 2;
+static constexpr int64_t kQuantEmbeddingCodesPerFloat = 4;
+
+// The width of the quantized row of an embedding row of width elements,
+// which must be a multiple of kQuantEmbeddingCodesPerFloat.
+inline int64_t QuantEmbeddingWidth(int64_t width) {
+  return kQuantEmbeddingHeadWidth + width / kQuantEmbeddingCodesPerFloat;
+}
+
+// The width of the embedding row of a quantized row of quant_width elements.
+inline int64_t DequantEmbeddingWidth(int64_t quant_width) {
+  return (quant_width - kQuantEmbeddingHeadWidth) *
+         kQuantEmbeddingCodesPerFloat;
+}
+
+// Quantize each element of row to the nearest of the 256 values evenly
+// spaced in [min(row), max(row)]. The stored max is enlarged by 256 / 255,
+// so that the code 255 is decoded to max(row) exactly.
+inline void QuantizeEmbeddingRow(const float* row, int64_t width,
+                                 float* quant_row) {
+  auto min_max = std::minmax_element(row, row + width);
+  float min = *min_max.first;
+  float range = *min_max.second - min;
+  quant_row[0] = min;
+  quant_row[1] = min + range * 256.0f / 255.0f;
+  uint8_t* codes = reinterpret_cast<uint8_t*>(quant_row + 2);
+  float inv_step = range > 0 ? 255.0f / range : 0.0f;
+  for (int64_t i = 0; i < width; ++i) {
+    float code = std::round((row[i] - min) * inv_step);
+    codes[i] = static_cast<uint8_t>(std::min(std::max(code, 0.0f), 255.0f));
+  }
+}
+
+// Quantize all the rows of a table of shape [height, width] into quant_table
+// of shape [height, QuantEmbeddingWidth(width)].
+inline void QuantizeEmbedding(const float* table, int64_t height,
+                              int64_t width, float* quant_table) {
+  int64_t quant_width = QuantEmbeddingWidth(width);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t i = 0; i < height; ++i) {
+    QuantizeEmbeddingRow(table + i * width, width,
+                         quant_table + i * quant_width);
+  }
+}
+
+// The reference kernel of DequantAddRow.
+template <typename T>
+inline void DequantAddRowRef(const float* quant_row, int64_t begin,
+                             int64_t end, T* dst) {
+  const T min = quant_row[0];
+  const T step = (quant_row[1] - quant_row[0]) / 256.0f;
+  const uint8_t* codes = reinterpret_cast<const uint8_t*>(quant_row + 2);
+  for (int64_t i = begin; i < end; ++i) {
+    dst[i - begin] += min + step * static_cast<T>(codes[i]);
+  }
+}
+
+#ifdef PADDLE_WITH_EMBEDDING_QUANT_X86
+
+// Decode 16 codes in a register per step.
+__attribute__((target("avx512f"))) inline void DequantAddRowAvx512(
+    const float* quant_row, int64_t begin, int64_t end, float* dst) {
+  const uint8_t* codes = reinterpret_cast<const uint8_t*>(quant_row + 2);
+  const __m512 min = _mm512_set1_ps(quant_row[0]);
+  const __m512 step = _mm512_set1_ps((quant_row[1] - quant_row[0]) / 256.0f);
+  int64_t i = begin;
+  for (; i + 16 <= end; i += 16) {
+    __m128i q = _mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + i));
+    __m512 value =
+        _mm512_fmadd_ps(_mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(q)), step, min);
+    float* out = dst + (i - begin);
+    _mm512_storeu_ps(out, _mm512_add_ps(_mm512_loadu_ps(out), value));
+  }
+  DequantAddRowRef<float>(quant_row, i, end, dst + (i - begin));
+}
+
+// Decode 8 codes in a register per step.
+__attribute__((target("avx2,fma"))) inline void DequantAddRowAvx2(
+    const float* quant_row, int64_t begin, int64_t end, float* dst) {
+  const uint8_t* codes = reinterpret_cast<const uint8_t*>(quant_row + 2);
+  const __m256 min = _mm256_set1_ps(quant_row[0]);
+  const __m256 step = _mm256_set1_ps((quant_row[1] - quant_row[0]) / 256.0f);
+  int64_t i = begin;
+  for (; i + 8 <= end; i += 8) {
+    __m128i q = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(codes + i));
+    __m256 value =
+        _mm256_fmadd_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(q)), step, min);
+    float* out = dst + (i - begin);
+    _mm256_storeu_ps(out, _mm256_add_ps(_mm256_loadu_ps(out), value));
+  }
+  DequantAddRowRef<float>(quant_row, i, end, dst + (i - begin));
+}
+
+#endif  // PADDLE_WITH_EMBEDDING_QUANT_X86
+
+using DequantAddRowF32Kernel = void (*)(const float*, int64_t, int64_t,
+                                        float*);
+
+// The fastest float kernel of DequantAddRow the CPU supports.
+inline DequantAddRowF32Kernel GetDequantAddRowF32Kernel() {
+  static const DequantAddRowF32Kernel kernel = [] {
+#ifdef PADDLE_WITH_EMBEDDING_QUANT_X86
+    if (platform::MayIUse(platform::avx512f)) {
+      return static_cast<DequantAddRowF32Kernel>(DequantAddRowAvx512);
+    }
+    if (platform::MayIUse(platform::avx2)) {
+      return static_cast<DequantAddRowF32Kernel>(DequantAddRowAvx2);
+    }
+#endif
+    return static_cast<DequantAddRowF32Kernel>(DequantAddRowRef<float>);
+  }();
+  return kernel;
+}
+
+// dst[i - begin] += the value of the i-th element of the quantized row, for
+// each i in [begin, end).
+template <typename T>
+inline void DequantAddRow(const float* quant_row, int64_t begin, int64_t end,
+                          T* dst) {
+  DequantAddRowRef<T>(quant_row, begin, end, dst);
+}
+
+template <>
+inline void DequantAddRow<float>(const float* quant_row, int64_t begin,
+                                 int64_t end, float* dst) {
+  GetDequantAddRowF32Kernel()(quant_row, begin, end, dst);
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
@@ -20,6 +20,24 @@ namespace paddle {
 namespace operators {
 namespace math {
 
+// Y = src + B, where the stride of the rows of src is src_stride.
+template <typename T>
+static void AddBias(const int M, const int N, const T* B, bool relu,
+                    const T* src, const int src_stride, T* Y) {
+  auto compute =
+      relu
+          ? jit::KernelFuncs<jit::VAddReluTuple<T>, platform::CPUPlace>::Cache()
+                .At(N)
+          : jit::KernelFuncs<jit::VAddTuple<T>, platform::CPUPlace>::Cache()
+                .At(N);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int i = 0; i < M; i++) {
+    compute(B, src + i * src_stride, Y + i * N, N);
+  }
+}
+
 template <typename T>
 class FCFunctor<platform::CPUDeviceContext, T> {
  public:
@@ -61,24 +79,39 @@ class FCFunctor<platform::CPUDeviceContext, T> {
                             "When bias is NULL, relu can not be true."));
       return;
     }
-    auto compute =
-        relu
-            ? jit::KernelFuncs<jit::VAddReluTuple<T>,
-                               platform::CPUPlace>::Cache()
-                  .At(N)
-            : jit::KernelFuncs<jit::VAddTuple<T>, platform::CPUPlace>::Cache()
-                  .At(N);
-#ifdef PADDLE_WITH_MKLML
-#pragma omp parallel for
-#endif
-    for (int i = 0; i < M; i++) {
-      T* dst = Y + i * N;
-      T* src = (padding_weights) ? Y1_data + i * (N + 4) : dst;
-      compute(B, src, dst, N);
-    }
+    AddBias(M, N, B, relu, padding_weights ? Y1_data : Y,
+            padding_weights ? N + 4 : N, Y);
   }
 };
 
+void FCInt8Functor::operator()(const platform::CPUDeviceContext& context,
+                               const int M, const float* X, float x_scale,
+                               const PackedInt8Weights& W, float* Y,
+                               const float* B, bool relu) {
+  MatMulInt8(M, X, x_scale, W, Y);
+  if (B == NULL) {
+    PADDLE_ENFORCE_EQ(relu, false,
+                      platform::errors::PermissionDenied(
+                          "When bias is NULL, relu can not be true."));
+    return;
+  }
+  AddBias(M, W.N, B, relu, Y, W.N, Y);
+}
+
+void FCPackedFunctor::operator()(const platform::CPUDeviceContext& context,
+                                 const int M, const float* X,
+                                 const PackedGemmB& W, float* Y,
+                                 const float* B, bool relu) {
+  W.Compute(M, X, W.K(), Y, W.N());
+  if (B == NULL) {
+    PADDLE_ENFORCE_EQ(relu, false,
+                      platform::errors::PermissionDenied(
+                          "When bias is NULL, relu can not be true."));
+    return;
+  }
+  AddBias(M, W.N(), B, relu, Y, W.N(), Y);
+}
+
 template class FCFunctor<platform::CPUDeviceContext, float>;
 template class FCFunctor<platform::CPUDeviceContext, double>;
 
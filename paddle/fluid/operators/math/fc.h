@@ -15,6 +15,8 @@ limitations under the License. */
 #pragma once
 
 #include <string>
+#include "paddle/fluid/operators/math/cpu_lowp_gemm.h"
+#include "paddle/fluid/operators/math/packed_gemm.h"
 #include "paddle/fluid/platform/device_context.h"
 
 namespace paddle {
@@ -30,6 +32,24 @@ class FCFunctor {
                   bool weight_pass = false);
 };
 
+// The FCFunctor on CPU whose GEMM is computed in int8, for the programs
+// quantized by quant_conv2d_dequant_fuse_pass. See MatMulInt8.
+class FCInt8Functor {
+ public:
+  void operator()(const platform::CPUDeviceContext& context, const int M,
+                  const float* X, float x_scale, const PackedInt8Weights& W,
+                  float* Y, const float* B = nullptr, bool relu = false);
+};
+
+// The FCFunctor on CPU with the float weights packed ahead, for the programs
+// whose weights are prepacked by gemm_weight_prepack_pass.
+class FCPackedFunctor {
+ public:
+  void operator()(const platform::CPUDeviceContext& context, const int M,
+                  const float* X, const PackedGemmB& W, float* Y,
+                  const float* B = nullptr, bool relu = false);
+};
+
 }  // namespace math
 }  // namespace operators
 }  // namespace paddle
@@ -107,7 +107,9 @@ struct TransposeNormal<platform::CPUDeviceContext, T> {
         out_ptr[out_idx] = in_ptr[in_idx];
       }
     };
-    transpose_helper(0, out->numel());
+    context.ParallelFor(0, out->numel(),
+                        platform::CPUDeviceContext::GrainSize(rank),
+                        transpose_helper);
   }
 };
 
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #pragma once
+#include <algorithm>
 #include <memory>
 #include <vector>
 #include "paddle/fluid/framework/data_type.h"
@@ -42,6 +43,37 @@ void SetConstant<DeviceContext, T>::operator()(const DeviceContext& context,
   }
 }
 
+template <typename DeviceContext, typename InT, typename OutT, size_t Rank>
+void TransposeShuffle(const DeviceContext& context, const InT& in, OutT* out,
+                      const Eigen::array<int, Rank>& permute) {
+  out->device(*context.eigen_device()) = in.shuffle(permute);
+}
+
+// Shuffle the slices of the first dim of out in parallel on CPU.
+template <typename InT, typename OutT, size_t Rank>
+void TransposeShuffle(const platform::CPUDeviceContext& context,
+                      const InT& in, OutT* out,
+                      const Eigen::array<int, Rank>& permute) {
+  const int64_t rows = out->dimension(0);
+  const int64_t grain_size = platform::CPUDeviceContext::GrainSize(
+      out->size() / std::max<int64_t>(1, rows));
+  if (context.ParallelForNumThreads(rows, grain_size) <= 1) {
+    out->device(*context.eigen_device()) = in.shuffle(permute);
+    return;
+  }
+  context.ParallelFor(0, rows, grain_size, [&](int64_t begin, int64_t end) {
+    Eigen::DSizes<Eigen::DenseIndex, Rank> offsets;
+    Eigen::DSizes<Eigen::DenseIndex, Rank> extents = out->dimensions();
+    for (size_t i = 0; i < Rank; ++i) {
+      offsets[i] = 0;
+    }
+    offsets[0] = begin;
+    extents[0] = end - begin;
+    out->slice(offsets, extents).device(*context.eigen_device()) =
+        in.shuffle(permute).slice(offsets, extents);
+  });
+}
+
 template <typename DeviceContext, typename T, int Rank>
 void Transpose<DeviceContext, T, Rank>::operator()(
     const DeviceContext& context, const framework::Tensor& in,
@@ -60,7 +92,7 @@ void Transpose<DeviceContext, T, Rank>::operator()(
     To32BitIndex(eigen_out).device(*dev) =
         To32BitIndex(eigen_in).shuffle(permute);
   } else {
-    eigen_out.device(*dev) = eigen_in.shuffle(permute);
+    TransposeShuffle(context, eigen_in, &eigen_out, permute);
   }
 }
 
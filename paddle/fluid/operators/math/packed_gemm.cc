@@ -0,0 +1,317 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/packed_gemm.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#include "paddle/fluid/operators/math/blas.h"
+#endif
+
+#include "paddle/fluid/platform/cpu_info.h"
+#include "paddle/fluid/platform/enforce.h"
+
+// The AVX512 and AVX2 kernels are compiled with the target attributes, and
+// only called when the CPU supports them, as the ones in cpu_lowp_gemm.cc.
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(_WIN32) && \
+    (defined(__clang__) || __GNUC__ >= 8)
+#include <immintrin.h>
+#define PADDLE_WITH_PACKED_GEMM_X86
+#endif
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+namespace {
+
+constexpr int kPanel = kPackedGemmPanelWidth;
+// The number of the rows of C computed by a micro kernel.
+constexpr int kRowBlock = 4;
+// The number of the panels computed by a micro kernel, which keeps enough
+// independent accumulators for a single row of A.
+constexpr int kPanelBlock = 4;
+// The GEMM of fewer multiply-adds runs in one thread.
+constexpr int64_t kPackedGemmParallelThreshold = 1 << 20;
+
+inline int UpDiv(int a, int b) { return (a + b - 1) / b; }
+
+// Compute the rows [0, mr) and the columns [0, nr) of C with the consecutive
+// panels of the packed B, where nr is at most kPanelBlock * kPanel.
+using F32MicroKernel = void (*)(int mr, int nr, int K, const float* A,
+                                int lda, const float* panels, float* C,
+                                int ldc);
+
+void F32Ref(int mr, int nr, int K, const float* A, int lda,
+            const float* panels, float* C, int ldc) {
+  const int64_t panel_size = static_cast<int64_t>(K) * kPanel;
+  for (int i = 0; i < mr; ++i) {
+    for (int j0 = 0; j0 < nr; j0 += kPanel) {
+      const float* panel = panels + (j0 / kPanel) * panel_size;
+      float acc[kPanel] = {0};
+      for (int k = 0; k < K; ++k) {
+        float a_k = A[i * lda + k];
+        for (int j = 0; j < kPanel; ++j) {
+          acc[j] += a_k * panel[k * kPanel + j];
+        }
+      }
+      std::memcpy(C + i * ldc + j0, acc,
+                  std::min(kPanel, nr - j0) * sizeof(float));
+    }
+  }
+}
+
+#ifdef PADDLE_WITH_PACKED_GEMM_X86
+
+// Compute NP panels of MR rows, a register of 16 floats per panel.
+template <int MR, int NP>
+__attribute__((target("avx512f"))) void F32Avx512Block(int nr, int K,
+                                                       const float* A,
+                                                       int lda,
+                                                       const float* panels,
+                                                       float* C, int ldc) {
+  const int64_t panel_size = static_cast<int64_t>(K) * kPanel;
+  __m512 acc[MR][NP];
+  for (int i = 0; i < MR; ++i) {
+    for (int p = 0; p < NP; ++p) {
+      acc[i][p] = _mm512_setzero_ps();
+    }
+  }
+  for (int k = 0; k < K; ++k) {
+    __m512 b[NP];
+    for (int p = 0; p < NP; ++p) {
+      b[p] = _mm512_loadu_ps(panels + p * panel_size + k * kPanel);
+    }
+    for (int i = 0; i < MR; ++i) {
+      __m512 a = _mm512_set1_ps(A[i * lda + k]);
+      for (int p = 0; p < NP; ++p) {
+        acc[i][p] = _mm512_fmadd_ps(a, b[p], acc[i][p]);
+      }
+    }
+  }
+  for (int p = 0; p < NP; ++p) {
+    int cols = std::min(kPanel, nr - p * kPanel);
+    __mmask16 mask = static_cast<__mmask16>((1u << cols) - 1);
+    for (int i = 0; i < MR; ++i) {
+      _mm512_mask_storeu_ps(C + i * ldc + p * kPanel, mask, acc[i][p]);
+    }
+  }
+}
+
+template <int MR>
+void F32Avx512Rows(int nr, int K, const float* A, int lda,
+                   const float* panels, float* C, int ldc) {
+  switch (UpDiv(nr, kPanel)) {
+    case 4:
+      F32Avx512Block<MR, 4>(nr, K, A, lda, panels, C, ldc);
+      break;
+    case 3:
+      F32Avx512Block<MR, 3>(nr, K, A, lda, panels, C, ldc);
+      break;
+    case 2:
+      F32Avx512Block<MR, 2>(nr, K, A, lda, panels, C, ldc);
+      break;
+    default:
+      F32Avx512Block<MR, 1>(nr, K, A, lda, panels, C, ldc);
+  }
+}
+
+void F32Avx512(int mr, int nr, int K, const float* A, int lda,
+               const float* panels, float* C, int ldc) {
+  switch (mr) {
+    case 4:
+      F32Avx512Rows<4>(nr, K, A, lda, panels, C, ldc);
+      break;
+    case 3:
+      F32Avx512Rows<3>(nr, K, A, lda, panels, C, ldc);
+      break;
+    case 2:
+      F32Avx512Rows<2>(nr, K, A, lda, panels, C, ldc);
+      break;
+    default:
+      F32Avx512Rows<1>(nr, K, A, lda, panels, C, ldc);
+  }
+}
+
+// Compute a panel of MR rows into acc, in 2 registers of 8 floats.
+template <int MR>
+__attribute__((target("avx2,fma"))) void F32Avx2Block(int K, const float* A,
+                                                      int lda,
+                                                      const float* panel,
+                                                      float* acc) {
+  __m256 c[MR][2];
+  for (int i = 0; i < MR; ++i) {
+    c[i][0] = _mm256_setzero_ps();
+    c[i][1] = _mm256_setzero_ps();
+  }
+  for (int k = 0; k < K; ++k) {
+    __m256 b0 = _mm256_loadu_ps(panel + k * kPanel);
+    __m256 b1 = _mm256_loadu_ps(panel + k * kPanel + 8);
+    for (int i = 0; i < MR; ++i) {
+      __m256 a = _mm256_set1_ps(A[i * lda + k]);
+      c[i][0] = _mm256_fmadd_ps(a, b0, c[i][0]);
+      c[i][1] = _mm256_fmadd_ps(a, b1, c[i][1]);
+    }
+  }
+  for (int i = 0; i < MR; ++i) {
+    _mm256_storeu_ps(acc + i * kPanel, c[i][0]);
+    _mm256_storeu_ps(acc + i * kPanel + 8, c[i][1]);
+  }
+}
+
+void F32Avx2(int mr, int nr, int K, const float* A, int lda,
+             const float* panels, float* C, int ldc) {
+  const int64_t panel_size = static_cast<int64_t>(K) * kPanel;
+  for (int j0 = 0; j0 < nr; j0 += kPanel) {
+    const float* panel = panels + (j0 / kPanel) * panel_size;
+    float acc[kRowBlock * kPanel];
+    switch (mr) {
+      case 4:
+        F32Avx2Block<4>(K, A, lda, panel, acc);
+        break;
+      case 3:
+        F32Avx2Block<3>(K, A, lda, panel, acc);
+        break;
+      case 2:
+        F32Avx2Block<2>(K, A, lda, panel, acc);
+        break;
+      default:
+        F32Avx2Block<1>(K, A, lda, panel, acc);
+    }
+    // The padded columns of the last panel are dropped.
+    const int cols = std::min(kPanel, nr - j0);
+    for (int i = 0; i < mr; ++i) {
+      std::memcpy(C + i * ldc + j0, acc + i * kPanel, cols * sizeof(float));
+    }
+  }
+}
+
+#endif  // PADDLE_WITH_PACKED_GEMM_X86
+
+struct F32Impl {
+  F32MicroKernel kernel;
+  const char* name;
+};
+
+const F32Impl& GetF32Impl() {
+  static const F32Impl impl = [] {
+#ifdef PADDLE_WITH_PACKED_GEMM_X86
+    if (platform::MayIUse(platform::avx512f)) {
+      return F32Impl{F32Avx512, "avx512"};
+    }
+    if (platform::MayIUse(platform::avx2)) {
+      return F32Impl{F32Avx2, "avx2"};
+    }
+#endif
+    return F32Impl{F32Ref, "reference"};
+  }();
+  return impl;
+}
+
+}  // namespace
+
+int64_t PackedGemmF32BSize(int K, int N) {
+  return static_cast<int64_t>(UpDiv(N, kPanel)) * K * kPanel;
+}
+
+void PackGemmF32B(int K, int N, const float* B, int ldb, float* packed_b) {
+  const int num_panels = UpDiv(N, kPanel);
+  for (int p = 0; p < num_panels; ++p) {
+    const int j = p * kPanel;
+    const int cols = std::min(kPanel, N - j);
+    float* panel = packed_b + static_cast<int64_t>(p) * K * kPanel;
+    for (int k = 0; k < K; ++k) {
+      std::memcpy(panel + k * kPanel, B + k * ldb + j, cols * sizeof(float));
+      std::fill(panel + k * kPanel + cols, panel + (k + 1) * kPanel, 0.0f);
+    }
+  }
+}
+
+void GemmF32Packed(int M, int N, int K, const float* A, int lda,
+                   const float* packed_b, float* C, int ldc) {
+  const F32MicroKernel kernel = GetF32Impl().kernel;
+  constexpr int kColBlock = kPanelBlock * kPanel;
+  const int num_col_blocks = UpDiv(N, kColBlock);
+  const int num_row_blocks = UpDiv(M, kRowBlock);
+  const int64_t block_size = static_cast<int64_t>(K) * kColBlock;
+  // The consecutive blocks share the panels of B.
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (static_cast<int64_t>(M) * N * K > \
+                             kPackedGemmParallelThreshold)
+#endif
+  for (int t = 0; t < num_col_blocks * num_row_blocks; ++t) {
+    int b = t / num_row_blocks;
+    int i = (t % num_row_blocks) * kRowBlock;
+    int j = b * kColBlock;
+    kernel(std::min(kRowBlock, M - i), std::min(kColBlock, N - j), K,
+           A + i * lda, lda, packed_b + b * block_size, C + i * ldc + j, ldc);
+  }
+}
+
+const char* GemmF32PackedImplType() { return GetF32Impl().name; }
+
+PackedGemmB::PackedGemmB(int K, int N, const float* B, int ldb)
+    : K_(K), N_(N) {
+  PADDLE_ENFORCE_GT(K, 0, platform::errors::InvalidArgument(
+                              "The height of the packed matrix should be "
+                              "positive, but received %d.",
+                              K));
+  PADDLE_ENFORCE_GT(N, 0, platform::errors::InvalidArgument(
+                              "The width of the packed matrix should be "
+                              "positive, but received %d.",
+                              N));
+#ifdef PADDLE_WITH_MKLML
+  // The packed B is independent of the height of A.
+  mkl_packed_ = CBlas<float>::GEMM_ALLOC(CblasBMatrix, 1, N, K);
+  PADDLE_ENFORCE_NOT_NULL(
+      mkl_packed_,
+      platform::errors::ResourceExhausted(
+          "Failed to allocate the packed matrix of shape [%d, %d] by MKL.", K,
+          N));
+  CBlas<float>::GEMM_PACK(CblasRowMajor, CblasBMatrix, CblasNoTrans, 1, N, K,
+                          1.0f, B, ldb, mkl_packed_);
+  // The size of the packed B by MKL is about the one of B.
+  bytes_ = static_cast<int64_t>(K) * N * sizeof(float);
+#else
+  packed_.resize(PackedGemmF32BSize(K, N));
+  PackGemmF32B(K, N, B, ldb, packed_.data());
+  bytes_ = static_cast<int64_t>(packed_.size()) * sizeof(float);
+#endif
+}
+
+PackedGemmB::~PackedGemmB() {
+#ifdef PADDLE_WITH_MKLML
+  if (mkl_packed_) {
+    CBlas<float>::GEMM_FREE(mkl_packed_);
+  }
+#endif
+}
+
+void PackedGemmB::Compute(int M, const float* A, int lda, float* C,
+                          int ldc) const {
+  if (M <= 0) return;
+#ifdef PADDLE_WITH_MKLML
+  CBlas<float>::GEMM_COMPUTE(CblasRowMajor, CblasNoTrans, CblasPacked, M, N_,
+                             K_, A, lda, mkl_packed_, N_, 0.0f, C, ldc);
+#else
+  GemmF32Packed(M, N_, K_, A, lda, packed_.data(), C, ldc);
+#endif
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
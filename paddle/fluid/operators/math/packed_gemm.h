@@ -0,0 +1,77 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+// The float B of the GEMM packed ahead, which saves the packing of B on every
+// call when B is reused by the GEMMs of different A, e.g. the weights of fc in
+// inference. All the matrices are in row major.
+
+// The native packed B is in panels of kPackedGemmPanelWidth columns, where
+// the columns of a row are contiguous and the last panel is padded with 0.
+constexpr int kPackedGemmPanelWidth = 16;
+
+// The number of the floats of the B of shape [K, N] packed by PackGemmF32B.
+int64_t PackedGemmF32BSize(int K, int N);
+
+// Pack the B of shape [K, N] into packed_b in the native layout.
+void PackGemmF32B(int K, int N, const float* B, int ldb, float* packed_b);
+
+// C = A * B, where A is of shape [M, K] and B of shape [K, N] is packed by
+// PackGemmF32B.
+void GemmF32Packed(int M, int N, int K, const float* A, int lda,
+                   const float* packed_b, float* C, int ldc);
+
+// The name of the native implementation in use, for logging.
+const char* GemmF32PackedImplType();
+
+// The B of shape [K, N] packed by MKL cblas_sgemm_pack with
+// PADDLE_WITH_MKLML, otherwise packed in the native layout.
+class PackedGemmB {
+ public:
+  PackedGemmB(int K, int N, const float* B, int ldb);
+  ~PackedGemmB();
+
+  PackedGemmB(const PackedGemmB&) = delete;
+  PackedGemmB& operator=(const PackedGemmB&) = delete;
+
+  // C = A * B, where A is of shape [M, K].
+  void Compute(int M, const float* A, int lda, float* C, int ldc) const;
+
+  int K() const { return K_; }
+  int N() const { return N_; }
+  // The size in bytes of the packed B.
+  int64_t bytes() const { return bytes_; }
+
+ private:
+  int K_;
+  int N_;
+  int64_t bytes_{0};
+#ifdef PADDLE_WITH_MKLML
+  float* mkl_packed_{nullptr};
+#else
+  std::vector<float> packed_;
+#endif
+};
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
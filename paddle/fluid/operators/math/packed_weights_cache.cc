@@ -0,0 +1,137 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/packed_weights_cache.h"
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+static void CheckWeight(const framework::Tensor& w) {
+  PADDLE_ENFORCE_EQ(platform::is_cpu_place(w.place()), true,
+                    platform::errors::InvalidArgument(
+                        "The packed weights should be on CPU."));
+  PADDLE_ENFORCE_EQ(w.dims().size(), 2,
+                    platform::errors::InvalidArgument(
+                        "The packed weights should be 2-D, but received "
+                        "the shape [%s].",
+                        w.dims()));
+}
+
+PackedWeightsCache& PackedWeightsCache::Instance() {
+  static PackedWeightsCache cache;
+  return cache;
+}
+
+std::shared_ptr<const void> PackedWeightsCache::Find(
+    const Key& key, const framework::Tensor& w,
+    const std::vector<float>& w_scales) const {
+  auto it = entries_.find(key);
+  if (it == entries_.end()) return nullptr;
+  auto& entry = it->second;
+  if (entry.holder.lock() != w.Holder() || entry.dims != w.dims() ||
+      entry.w_scales != w_scales) {
+    return nullptr;
+  }
+  return entry.packed;
+}
+
+void PackedWeightsCache::EraseExpired() {
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    if (it->second.holder.expired()) {
+      it = entries_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+std::shared_ptr<const PackedGemmB> PackedWeightsCache::GetFloat(
+    const framework::Tensor& w) {
+  CheckWeight(w);
+  const float* data = w.data<float>();
+  Key key(data, kFloat);
+  {
+    framework::AutoRDLock lock(&lock_);
+    if (auto packed = Find(key, w, {})) {
+      return std::static_pointer_cast<const PackedGemmB>(packed);
+    }
+  }
+  framework::AutoWRLock lock(&lock_);
+  // Another thread may have packed it meanwhile
+  if (auto packed = Find(key, w, {})) {
+    return std::static_pointer_cast<const PackedGemmB>(packed);
+  }
+  EraseExpired();
+  auto packed = std::make_shared<const PackedGemmB>(
+      static_cast<int>(w.dims()[0]), static_cast<int>(w.dims()[1]), data,
+      static_cast<int>(w.dims()[1]));
+  // Replaces the stale entry of the same memory, if any
+  auto& entry = entries_[key];
+  entry = Entry();
+  entry.holder = w.Holder();
+  entry.dims = w.dims();
+  entry.packed = packed;
+  entry.bytes = packed->bytes();
+  VLOG(3) << "Pack the float weights of shape [" << w.dims() << "]";
+  return packed;
+}
+
+std::shared_ptr<const PackedInt8Weights> PackedWeightsCache::GetInt8(
+    const framework::Tensor& w, const std::vector<float>& w_scales) {
+  CheckWeight(w);
+  const float* data = w.data<float>();
+  Key key(data, kInt8);
+  {
+    framework::AutoRDLock lock(&lock_);
+    if (auto packed = Find(key, w, w_scales)) {
+      return std::static_pointer_cast<const PackedInt8Weights>(packed);
+    }
+  }
+  framework::AutoWRLock lock(&lock_);
+  if (auto packed = Find(key, w, w_scales)) {
+    return std::static_pointer_cast<const PackedInt8Weights>(packed);
+  }
+  EraseExpired();
+  auto packed = std::make_shared<PackedInt8Weights>();
+  PackInt8Weights(static_cast<int>(w.dims()[0]),
+                  static_cast<int>(w.dims()[1]), data, w_scales.data(),
+                  static_cast<int>(w_scales.size()), packed.get());
+  auto& entry = entries_[key];
+  entry = Entry();
+  entry.holder = w.Holder();
+  entry.dims = w.dims();
+  entry.w_scales = w_scales;
+  entry.packed = packed;
+  entry.bytes = static_cast<int64_t>(packed->data.size()) +
+                packed->col_sum.size() * sizeof(int32_t) +
+                packed->scales.size() * sizeof(float);
+  VLOG(3) << "Pack the int8 weights of shape [" << w.dims() << "]";
+  return packed;
+}
+
+int64_t PackedWeightsCache::bytes() {
+  framework::AutoRDLock lock(&lock_);
+  int64_t total = 0;
+  for (auto& item : entries_) {
+    total += item.second.bytes;
+  }
+  return total;
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
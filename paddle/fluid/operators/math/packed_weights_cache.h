@@ -0,0 +1,85 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "paddle/fluid/framework/rw_lock.h"
+#include "paddle/fluid/framework/tensor.h"
+#include "paddle/fluid/operators/math/cpu_lowp_gemm.h"
+#include "paddle/fluid/operators/math/packed_gemm.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+// The weights of fc and mul packed once and shared by all the runs, which is
+// used by the operators marked with the attribute use_prepacked_weight by
+// gemm_weight_prepack_pass in inference. The weights are looked up by the
+// memory of the weight tensors on CPU, so they must not be changed once
+// packed. The packed weights of the freed tensors are dropped. The lookups
+// of the packed weights share a read lock, so the predictor threads do not
+// wait for each other once the weights are packed.
+class PackedWeightsCache {
+ public:
+  static PackedWeightsCache& Instance();
+
+  // The float weight w of shape [K, N].
+  std::shared_ptr<const PackedGemmB> GetFloat(const framework::Tensor& w);
+
+  // The weight w of shape [K, N] quantized to int8 with w_scales, see
+  // PackInt8Weights.
+  std::shared_ptr<const PackedInt8Weights> GetInt8(
+      const framework::Tensor& w, const std::vector<float>& w_scales);
+
+  // The total size in bytes of the packed weights.
+  int64_t bytes();
+
+ private:
+  PackedWeightsCache() = default;
+
+  enum Kind { kFloat = 0, kInt8 = 1 };
+
+  struct Entry {
+    // The memory of the weight tensor, to tell whether it is still alive
+    // when the same address is reused by another tensor.
+    std::weak_ptr<memory::Allocation> holder;
+    framework::DDim dims;
+    std::vector<float> w_scales;
+    std::shared_ptr<const void> packed;
+    int64_t bytes{0};
+  };
+
+  using Key = std::pair<const void*, int>;
+
+  // Return the packed weights of w matching dims and w_scales, or nullptr.
+  // Only reads the entries.
+  std::shared_ptr<const void> Find(const Key& key, const framework::Tensor& w,
+                                   const std::vector<float>& w_scales) const;
+
+  // Drop the entries whose weight tensors are freed.
+  void EraseExpired();
+
+  // Read locked by the lookups, write locked to pack and insert
+  framework::RWLock lock_;
+  std::map<Key, Entry> entries_;
+};
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
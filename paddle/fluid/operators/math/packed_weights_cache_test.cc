@@ -0,0 +1,147 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/packed_weights_cache.h"
+
+#include <chrono>  // NOLINT
+#include <random>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/operators/math/blas.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+static void RandomFill(framework::Tensor* t) {
+  static std::mt19937 rng(100);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  float* data = t->mutable_data<float>(platform::CPUPlace());
+  for (int64_t i = 0; i < t->numel(); ++i) {
+    data[i] = dist(rng);
+  }
+}
+
+TEST(PackedGemm, CompareWithGemm) {
+  LOG(INFO) << "Native packed GEMM implementation: "
+            << GemmF32PackedImplType();
+  platform::CPUDeviceContext context((platform::CPUPlace()));
+  auto blas = GetBlas<platform::CPUDeviceContext, float>(context);
+  // The shapes cover the tails of the panels and the micro kernels.
+  for (int M : {1, 3, 4, 5, 17}) {
+    for (int N : {1, 15, 16, 17, 64, 65, 130}) {
+      for (int K : {1, 3, 64, 130}) {
+        framework::Tensor a, b;
+        a.Resize({M, K});
+        b.Resize({K, N});
+        RandomFill(&a);
+        RandomFill(&b);
+        std::vector<float> expected(M * N), c(M * N);
+        blas.MatMul(M, N, K, a.data<float>(), b.data<float>(),
+                    expected.data());
+        PackedGemmB packed_b(K, N, b.data<float>(), N);
+        packed_b.Compute(M, a.data<float>(), K, c.data(), N);
+        for (int i = 0; i < M * N; ++i) {
+          ASSERT_NEAR(c[i], expected[i], 1e-4)
+              << "M=" << M << " N=" << N << " K=" << K;
+        }
+      }
+    }
+  }
+}
+
+TEST(PackedWeightsCache, PackOnce) {
+  auto& cache = PackedWeightsCache::Instance();
+  framework::Tensor w;
+  w.Resize({30, 20});
+  RandomFill(&w);
+  auto packed = cache.GetFloat(w);
+  EXPECT_EQ(packed->K(), 30);
+  EXPECT_EQ(packed->N(), 20);
+  // The tensors sharing the memory share the packed weights.
+  framework::Tensor shared;
+  shared.ShareDataWith(w);
+  EXPECT_EQ(cache.GetFloat(shared), packed);
+
+  std::vector<float> scales = {0.01f};
+  auto packed_int8 = cache.GetInt8(w, scales);
+  EXPECT_EQ(cache.GetInt8(w, scales), packed_int8);
+  // Repacked with the other scales.
+  EXPECT_NE(cache.GetInt8(w, {0.02f}), packed_int8);
+
+  // Repacked with the other shape.
+  shared.Resize({20, 30});
+  EXPECT_EQ(cache.GetFloat(shared)->K(), 20);
+
+  // Repacked if the memory is freed, even if the address is reused.
+  std::weak_ptr<const PackedGemmB> weak_packed = cache.GetFloat(w);
+  w.clear();
+  shared.clear();
+  packed.reset();
+  framework::Tensor other;
+  other.Resize({30, 20});
+  RandomFill(&other);
+  auto other_packed = cache.GetFloat(other);
+  EXPECT_TRUE(weak_packed.expired());
+  EXPECT_EQ(other_packed->K(), 30);
+}
+
+template <typename Func>
+static double BenchmarkMs(Func func) {
+  const int kRepeat = 50;
+  func();  // Warm up
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kRepeat; ++i) {
+    func();
+  }
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+             .count() /
+         kRepeat;
+}
+
+// The packing of the weights dominates the GEMM of the small batches.
+TEST(PackedWeightsCache, Benchmark) {
+  platform::CPUDeviceContext context((platform::CPUPlace()));
+  auto blas = GetBlas<platform::CPUDeviceContext, float>(context);
+  const int N = 768, K = 768;
+  framework::Tensor w;
+  w.Resize({K, N});
+  RandomFill(&w);
+  auto packed_w = PackedWeightsCache::Instance().GetFloat(w);
+  for (int M : {1, 4, 16, 64}) {
+    framework::Tensor x;
+    x.Resize({M, K});
+    RandomFill(&x);
+    std::vector<float> y(M * N);
+    double gemm_ms = BenchmarkMs([&] {
+      blas.MatMul(M, N, K, x.data<float>(), w.data<float>(), y.data());
+    });
+    double pack_ms = BenchmarkMs([&] {
+      PackedGemmB packed(K, N, w.data<float>(), N);
+      packed.Compute(M, x.data<float>(), K, y.data(), N);
+    });
+    double prepacked_ms = BenchmarkMs(
+        [&] { packed_w->Compute(M, x.data<float>(), K, y.data(), N); });
+    LOG(INFO) << "GEMM [" << M << ", " << N << ", " << K
+              << "] GEMM: " << gemm_ms << " ms, packed on every call: "
+              << pack_ms << " ms, prepacked: " << prepacked_ms << " ms";
+  }
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
@@ -32,6 +32,10 @@ template <typename T, int MajorType = Eigen::RowMajor,
           typename IndexType = Eigen::DenseIndex>
 using EigenMatrix = framework::EigenMatrix<T, MajorType, IndexType>;
 
+// The sequences are pooled by multiple threads if the number of input elements
+// is larger than this.
+static constexpr int64_t kSeqPoolParallelThreshold = 1 << 15;
+
 template <typename T, bool is_test>
 class MaxSeqPoolFunctor {
  public:
@@ -74,6 +78,9 @@ class MaxSeqPoolFunctor {
 
     int64_t num_seq = out_dims[0];
     int64_t dim = output->numel() / num_seq;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (input.numel() > kSeqPoolParallelThreshold)
+#endif
     for (int64_t i = 0; i < num_seq; ++i) {
       if (starts[i] == starts[i + 1]) {
         for (int64_t k = 0; k < dim; ++k) {
@@ -133,6 +140,9 @@ class MaxSeqPoolFunctor<T, true> {
 
     int64_t num_seq = out_dims[0];
     int64_t dim = output->numel() / num_seq;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (input.numel() > kSeqPoolParallelThreshold)
+#endif
     for (int64_t i = 0; i < num_seq; ++i) {
       if (starts[i] == starts[i + 1]) {
         for (int64_t k = 0; k < dim; ++k) {
@@ -195,6 +205,9 @@ class MaxSeqPoolGradFunctor {
     set_zero(context, in_grad, static_cast<T>(0.0));
     int64_t num_seq = og_dims[0];
     int64_t dim = out_grad.numel() / num_seq;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (in_grad->numel() > kSeqPoolParallelThreshold)
+#endif
     for (int64_t i = 0; i < num_seq; ++i) {
       for (int64_t j = 0; j < dim; ++j) {
         int step_id = max_index[i * dim + j];
@@ -290,10 +303,15 @@ class SumSeqPoolGradFunctor {
     const T* out_g_data = out_grad.data<T>();
     T* in_g_data = in_grad->mutable_data<T>(context.GetPlace());
     auto blas = math::GetBlas<platform::CPUDeviceContext, T>(context);
-    for (int i = 0; i < static_cast<int>(lod.size()) - 1; ++i) {
-      int64_t h = static_cast<int64_t>(lod[i + 1] - lod[i]);
+    const size_t* offset = lod.data();
+    int num_seq = static_cast<int>(lod.size()) - 1;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (in_grad->numel() > kSeqPoolParallelThreshold)
+#endif
+    for (int i = 0; i < num_seq; ++i) {
+      int64_t h = static_cast<int64_t>(offset[i + 1] - offset[i]);
       if (h == 0) continue;
-      int64_t in_offset = lod[i] * in_w;
+      int64_t in_offset = offset[i] * in_w;
       const T* out_pos = out_g_data + i * out_w;
       T* in_pos = in_g_data + in_offset;
       for (int r = 0; r != h; ++r) {
@@ -334,59 +352,47 @@ class SequencePoolFunctor<platform::CPUDeviceContext, T> {
     }
     auto lod_level = input.lod().size();
     auto lod = input.lod()[lod_level - 1];
+    jit::SeqPoolType seqpool_type;
     if (pooltype == "SUM") {
-      auto place = context.GetPlace();
-      PADDLE_ENFORCE_EQ(
-          platform::is_cpu_place(place), true,
-          platform::errors::InvalidArgument(
-              "Sequence_pool should run on CPU Device when pooltype is SUM"));
-      const T* src = input.data<T>();
-      T* dst = output->mutable_data<T>(place);
-      jit::seq_pool_attr_t attr(
-          static_cast<int>(input.numel() / input.dims()[0]),
-          jit::SeqPoolType::kSum);
-      auto seqpool =
-          jit::KernelFuncs<jit::SeqPoolTuple<T>, platform::CPUPlace>::Cache()
-              .At(attr);
-      for (int i = 0; i < static_cast<int>(lod.size()) - 1; ++i) {
-        attr.h = static_cast<int>(lod[i + 1] - lod[i]);
-        if (attr.h == 0) {
-          for (int j = 0; j < attr.w; ++j) {
-            dst[j] = pad_value;
-          }
-        } else {
-          seqpool(src, dst, &attr);
-        }
-        dst += attr.w;
-        src += attr.h * attr.w;
-      }
-      return;
+      seqpool_type = jit::SeqPoolType::kSum;
+    } else if (pooltype == "AVERAGE") {
+      seqpool_type = jit::SeqPoolType::kAvg;
+    } else if (pooltype == "SQRT") {
+      seqpool_type = jit::SeqPoolType::kSqrt;
+    } else {
+      PADDLE_THROW(platform::errors::InvalidArgument(
+          "unsupported pooling pooltype: %s. Only support \"MAX\", "
+          "\"LAST\", \"FIRST\", \"SUM\", \"AVERAGE\" and \"SQRT\"",
+          pooltype));
     }
-    auto& place = *context.eigen_device();
-    for (int i = 0; i < static_cast<int>(lod.size()) - 1; ++i) {
-      Tensor out_t = output->Slice(i, i + 1);
-      int64_t w = input.numel() / input.dims()[0];
-      if (lod[i] == lod[i + 1]) {
-        for (int j = 0; j < w; ++j) {
-          out_t.data<T>()[j] = pad_value;
+    auto place = context.GetPlace();
+    PADDLE_ENFORCE_EQ(
+        platform::is_cpu_place(place), true,
+        platform::errors::InvalidArgument(
+            "Sequence_pool should run on CPU Device when pooltype is %s",
+            pooltype));
+    const T* src = input.data<T>();
+    T* dst = output->mutable_data<T>(place);
+    jit::seq_pool_attr_t attr(
+        static_cast<int>(input.numel() / input.dims()[0]), seqpool_type);
+    auto seqpool =
+        jit::KernelFuncs<jit::SeqPoolTuple<T>, platform::CPUPlace>::Cache().At(
+            attr);
+    const size_t* offset = lod.data();
+    int num_seq = static_cast<int>(lod.size()) - 1;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for firstprivate(attr) \
+    if (input.numel() > kSeqPoolParallelThreshold)
+#endif
+    for (int i = 0; i < num_seq; ++i) {
+      attr.h = static_cast<int>(offset[i + 1] - offset[i]);
+      T* out = dst + i * attr.w;
+      if (attr.h == 0) {
+        for (int j = 0; j < attr.w; ++j) {
+          out[j] = pad_value;
         }
-        continue;
-      }
-      Tensor in_t =
-          input.Slice(static_cast<int>(lod[i]), static_cast<int>(lod[i + 1]));
-      int64_t h = static_cast<int64_t>(lod[i + 1] - lod[i]);
-      auto in_e = EigenMatrix<T>::From(in_t, framework::make_ddim({h, w}));
-      auto out_e = EigenVector<T>::Flatten(out_t);
-      if (pooltype == "AVERAGE") {
-        out_e.device(place) = in_e.mean(Eigen::array<int, 1>({{0}}));
-      } else if (pooltype == "SQRT") {
-        out_e.device(place) = in_e.sum(Eigen::array<int, 1>({{0}})) /
-                              std::sqrt(static_cast<T>(h));
       } else {
-        PADDLE_THROW(platform::errors::InvalidArgument(
-            "unsupported pooling pooltype: %s. Only support \"AVERAGE\" and "
-            "\"SQRT\"",
-            pooltype));
+        seqpool(src + offset[i] * attr.w, out, &attr);
       }
     }
   }
@@ -181,24 +181,28 @@ class SoftmaxFunctor<DeviceContext, T, is_test, enable_if_CPU<DeviceContext>> {
     const int num_remain = num_classes / axis_dim;
 
     if (num_remain == 1 && platform::MayIUse(platform::avx)) {
-      const T* in_data = X->data<T>();
-      T* out_data = Y->data<T>();
-      for (int bs = 0; bs < batch_size; ++bs) {
-        T max_val = *std::max_element(in_data, in_data + num_classes);
-        max_val *= static_cast<T>(-1);
-        vec_add_bias<T, platform::avx>(num_classes, max_val, in_data, out_data);
-        vec_clip<T, platform::avx>(num_classes, static_cast<T>(-64), out_data,
-                                   out_data);
-        vec_exp<T>(num_classes, out_data, out_data);
-
-        T sum = 0;
-        vec_sum<T, platform::avx>(num_classes, out_data, &sum);
-        sum = static_cast<T>(1) / sum;
-        vec_scal<T, platform::avx>(num_classes, sum, out_data, out_data);
-
-        in_data += num_classes;
-        out_data += num_classes;
-      }
+      const T* in_base = X->data<T>();
+      T* out_base = Y->data<T>();
+      context.ParallelFor(
+          0, batch_size, platform::CPUDeviceContext::GrainSize(num_classes),
+          [&](int64_t begin, int64_t end) {
+            for (int64_t bs = begin; bs < end; ++bs) {
+              const T* in_data = in_base + bs * num_classes;
+              T* out_data = out_base + bs * num_classes;
+              T max_val = *std::max_element(in_data, in_data + num_classes);
+              max_val *= static_cast<T>(-1);
+              vec_add_bias<T, platform::avx>(num_classes, max_val, in_data,
+                                             out_data);
+              vec_clip<T, platform::avx>(num_classes, static_cast<T>(-64),
+                                         out_data, out_data);
+              vec_exp<T>(num_classes, out_data, out_data);
+
+              T sum = 0;
+              vec_sum<T, platform::avx>(num_classes, out_data, &sum);
+              sum = static_cast<T>(1) / sum;
+              vec_scal<T, platform::avx>(num_classes, sum, out_data, out_data);
+            }
+          });
     } else {
       SoftmaxEigen<DeviceContext, T, is_test>()(context, axis_dim, X, Y);
     }
@@ -219,8 +223,14 @@ class SoftmaxFunctor<DeviceContext, float, true, enable_if_CPU<DeviceContext>> {
     auto compute_softmax =
         jit::KernelFuncs<jit::SoftmaxTuple<float>, platform::CPUPlace>::Cache()
             .At(in_dims[kClassDim]);
-    compute_softmax(in_data, out_data, in_dims[kClassDim], in_dims[kBatchDim],
-                    in_dims[kClassDim] / axis_dim);
+    const int n = in_dims[kClassDim];
+    context.ParallelFor(0, in_dims[kBatchDim],
+                        platform::CPUDeviceContext::GrainSize(n),
+                        [&](int64_t begin, int64_t end) {
+                          compute_softmax(in_data + begin * n,
+                                          out_data + begin * n, n, end - begin,
+                                          n / axis_dim);
+                        });
   }
 };
 
@@ -311,20 +321,26 @@ class SoftmaxGradFunctor<DeviceContext, T, enable_if_CPU<DeviceContext>> {
     const int num_remain = num_classes / axis_dim;
 
     if (num_remain == 1 && platform::MayIUse(platform::avx)) {
-      const T* out_data = y->data<T>();
-      const T* out_grad = y_grad->data<T>();
-      T* in_grad = x_grad->data<T>();
-      for (int bs = 0; bs < batch_size; ++bs) {
-        T scalar;
-        vec_mul_reduce<T, platform::avx>(num_classes, out_grad, out_data,
-                                         &scalar);
-        scalar *= static_cast<T>(-1);
-        vec_add_bias<T, platform::avx>(num_classes, scalar, out_grad, in_grad);
-        vec_mul<T, platform::avx>(num_classes, out_data, in_grad, in_grad);
-        out_data += num_classes;
-        out_grad += num_classes;
-        in_grad += num_classes;
-      }
+      const T* out_base = y->data<T>();
+      const T* out_grad_base = y_grad->data<T>();
+      T* in_grad_base = x_grad->data<T>();
+      context.ParallelFor(
+          0, batch_size, platform::CPUDeviceContext::GrainSize(num_classes),
+          [&](int64_t begin, int64_t end) {
+            for (int64_t bs = begin; bs < end; ++bs) {
+              const T* out_data = out_base + bs * num_classes;
+              const T* out_grad = out_grad_base + bs * num_classes;
+              T* in_grad = in_grad_base + bs * num_classes;
+              T scalar;
+              vec_mul_reduce<T, platform::avx>(num_classes, out_grad, out_data,
+                                               &scalar);
+              scalar *= static_cast<T>(-1);
+              vec_add_bias<T, platform::avx>(num_classes, scalar, out_grad,
+                                             in_grad);
+              vec_mul<T, platform::avx>(num_classes, out_data, in_grad,
+                                        in_grad);
+            }
+          });
     } else {
       SoftmaxGradEigen<DeviceContext, T>()(context, axis_dim, y, y_grad,
                                            x_grad);
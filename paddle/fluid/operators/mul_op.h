@@ -14,10 +14,15 @@ limitations under the License. */
 
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/operators/math/blas.h"
+#include "paddle/fluid/operators/math/cpu_lowp_gemm.h"
 #include "paddle/fluid/operators/math/math_function.h"
+#include "paddle/fluid/operators/math/packed_weights_cache.h"
 
 namespace paddle {
 namespace operators {
@@ -26,6 +31,46 @@ using Tensor = framework::Tensor;
 
 constexpr int kMULMKLDNNINT8 = 1;
 
+// Compute mul with the weights packed ahead or in int8 on CPU in float, which
+// are set by the inference passes. Return false if it is not computed.
+template <typename DeviceContext, typename T>
+inline bool ComputeMulOnCPU(const framework::ExecutionContext& ctx,
+                            const DeviceContext& dev_ctx, const Tensor& x,
+                            const Tensor& y, Tensor* z) {
+  return false;
+}
+
+template <>
+inline bool ComputeMulOnCPU<platform::CPUDeviceContext, float>(
+    const framework::ExecutionContext& ctx,
+    const platform::CPUDeviceContext& dev_ctx, const Tensor& x,
+    const Tensor& y, Tensor* z) {
+  const int M = x.dims()[0];
+  const int K = x.dims()[1];
+  const int N = y.dims()[1];
+  // The weights marked by gemm_weight_prepack_pass are packed once.
+  bool prepacked = ctx.HasAttr("use_prepacked_weight") &&
+                   ctx.Attr<bool>("use_prepacked_weight");
+  // Only run in int8 if AnalysisConfig::EnableCpuInt8Gemm is set, where
+  // gemm_weight_prepack_pass has packed the weights in int8 with the scales
+  // set by quant_conv2d_dequant_fuse_pass.
+  bool int8 = prepacked && ctx.HasAttr("use_int8_gemm") &&
+              ctx.Attr<bool>("use_int8_gemm");
+  if (int8) {
+    auto packed_y = math::PackedWeightsCache::Instance().GetInt8(
+        y, ctx.Attr<std::vector<float>>("weight_scale"));
+    math::MatMulInt8(M, x.data<float>(), ctx.Attr<float>("X_scale"),
+                     *packed_y, z->data<float>());
+    return true;
+  }
+  if (prepacked) {
+    auto packed_y = math::PackedWeightsCache::Instance().GetFloat(y);
+    packed_y->Compute(M, x.data<float>(), K, z->data<float>(), N);
+    return true;
+  }
+  return false;
+}
+
 template <typename DeviceContext, typename T>
 class MulKernel : public framework::OpKernel<T> {
  public:
@@ -50,9 +95,12 @@ class MulKernel : public framework::OpKernel<T> {
       z->Resize({x_matrix.dims()[0], y_matrix.dims()[1]});
     }
 
-    auto blas = math::GetBlas<DeviceContext, T>(context);
-
-    blas.MatMul(x_matrix, y_matrix, z);
+    auto& dev_ctx = context.template device_context<DeviceContext>();
+    if (!ComputeMulOnCPU<DeviceContext, T>(context, dev_ctx, x_matrix,
+                                           y_matrix, z)) {
+      auto blas = math::GetBlas<DeviceContext, T>(dev_ctx);
+      blas.MatMul(x_matrix, y_matrix, z);
+    }
     if (z_dim.size() != 2) {
       z->Resize(z_dim);
     }
@@ -0,0 +1,181 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <numeric>
+
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/math/math_function.h"
+#include "paddle/fluid/operators/pscore/distributed_lookup_multi_table_op.h"
+
+namespace paddle {
+namespace operators {
+
+class DistributedLookupMultiTableOp : public framework::OperatorWithKernel {
+ public:
+  using framework::OperatorWithKernel::OperatorWithKernel;
+
+  void InferShape(framework::InferShapeContext *ctx) const override {
+    PADDLE_ENFORCE_EQ(
+        ctx->HasInputs("Ids"), true,
+        platform::errors::InvalidArgument(
+            "Input(Ids) of DistributedLookupMultiTableOp should not be null."));
+    PADDLE_ENFORCE_EQ(
+        ctx->HasInputs("W"), true,
+        platform::errors::InvalidArgument(
+            "Input(W) of DistributedLookupMultiTableOp should not be null."));
+    PADDLE_ENFORCE_EQ(ctx->HasOutputs("Outputs"), true,
+                      platform::errors::InvalidArgument(
+                          "Output(Outputs) of DistributedLookupMultiTableOp "
+                          "should not be null."));
+
+    auto ids_dims = ctx->GetInputsDim("Ids");
+    auto tables_dims = ctx->GetInputsDim("W");
+    auto attrs = ctx->Attrs();
+    auto table_ids = attrs.Get<std::vector<int>>("table_ids");
+    auto padding_idxs = attrs.Get<std::vector<int64_t>>("padding_idxs");
+    auto ids_nums = attrs.Get<std::vector<int>>("ids_nums");
+
+    PADDLE_ENFORCE_EQ(
+        tables_dims.size(), table_ids.size(),
+        platform::errors::InvalidArgument(
+            "The number of W (%d) should be the number of table_ids (%d).",
+            tables_dims.size(), table_ids.size()));
+    PADDLE_ENFORCE_EQ(
+        padding_idxs.size(), table_ids.size(),
+        platform::errors::InvalidArgument(
+            "The number of padding_idxs (%d) should be the number of "
+            "table_ids (%d).",
+            padding_idxs.size(), table_ids.size()));
+    PADDLE_ENFORCE_EQ(
+        ids_nums.size(), table_ids.size(),
+        platform::errors::InvalidArgument(
+            "The number of ids_nums (%d) should be the number of "
+            "table_ids (%d).",
+            ids_nums.size(), table_ids.size()));
+    PADDLE_ENFORCE_EQ(
+        static_cast<size_t>(
+            std::accumulate(ids_nums.begin(), ids_nums.end(), 0)),
+        ids_dims.size(),
+        platform::errors::InvalidArgument(
+            "The sum of ids_nums should be the number of Ids (%d).",
+            ids_dims.size()));
+
+    for (auto &table_dims : tables_dims) {
+      PADDLE_ENFORCE_EQ(
+          table_dims.size(), 2,
+          platform::errors::InvalidArgument(
+              "Only 2 dimensions of the 'Embedding' is supported."));
+    }
+
+    for (auto &ids_dim : ids_dims) {
+      PADDLE_ENFORCE_EQ(ids_dim.size(), 2,
+                        platform::errors::InvalidArgument(
+                            "The dimension of the 'Ids' tensor must be 2."));
+    }
+
+    // for fluid.embedding
+    auto lookup_table_version = attrs.Get<std::string>("lookup_table_version");
+
+    auto outputs_dims = std::vector<framework::DDim>();
+
+    for (size_t t = 0, idx = 0; t < tables_dims.size(); ++t) {
+      auto &table_dims = tables_dims[t];
+      for (int i = 0; i < ids_nums[t]; ++i, ++idx) {
+        auto &ids_dim = ids_dims[idx];
+        if (lookup_table_version == "lookup_table") {
+          outputs_dims.push_back(
+              framework::make_ddim({ids_dim[0], table_dims[1]}));
+        } else if (lookup_table_version == "lookup_table_v2") {
+          outputs_dims.push_back(framework::make_ddim(
+              {static_cast<int64_t>(ids_dim[0]),
+               static_cast<int64_t>(ids_dim[1]),
+               static_cast<int64_t>(table_dims[1])}));
+        }
+      }
+    }
+
+    ctx->SetOutputsDim("Outputs", outputs_dims);
+    ctx->ShareLoD("Ids", /*->*/ "Outputs");
+  }
+
+ protected:
+  framework::OpKernelType GetExpectedKernelType(
+      const framework::ExecutionContext &ctx) const override {
+    return framework::OpKernelType(
+        framework::proto::VarType::Type(ctx.Attr<int>("dtype")),
+        ctx.GetPlace());
+  }
+};
+
+class DistributedLookupMultiTableOpMaker
+    : public framework::OpProtoAndCheckerMaker {
+ public:
+  void Make() override {
+    AddInput("Ids",
+             "(LoDTensor) The ids to be looked up in W, the ids of the "
+             "tables follow each other.")
+        .AsDuplicable();
+
+    AddInput("W",
+             "(Tensor) The embedding tensors of the tables, "
+             "which are learnable parameters.")
+        .AsDuplicable();
+
+    AddOutput("Outputs",
+              "(LoDTensor) The lookup results, one for each of Ids.")
+        .AsDuplicable();
+
+    AddAttr<std::vector<int>>("table_ids", "The sparse table id of each W.")
+        .SetDefault({});
+
+    AddAttr<std::vector<int>>("ids_nums",
+                              "The number of the Ids of each table.")
+        .SetDefault({});
+
+    AddAttr<std::vector<int64_t>>(
+        "padding_idxs",
+        "The padding_idx of each table. If it is -1, it makes no effect "
+        "to lookup. Otherwise the given value indicates padding the output "
+        "with zeros whenever lookup encounters it in Ids.")
+        .SetDefault({});
+
+    AddAttr<std::string>(
+        "lookup_table_version",
+        "(string, default lookup_table) "
+        "To distinguish between different versions of embedding OP")
+        .SetDefault(std::string("lookup_table"));
+
+    AddAttr<int>("dtype",
+                 "(int, default 5 (FP32)) "
+                 "Output data type")
+        .SetDefault(framework::proto::VarType::FP32);
+
+    AddComment(R"DOC(
+Distributed Lookup Multi Table Operator.
+This operator looks up the ids of several sparse tables, like a
+distributed_lookup_table op for each table, but pulls all the tables
+with a single request to each parameter server.
+)DOC");
+  }
+};
+}  // namespace operators
+}  // namespace paddle
+
+namespace ops = paddle::operators;
+
+REGISTER_OPERATOR(distributed_lookup_multi_table,
+                  ops::DistributedLookupMultiTableOp,
+                  ops::DistributedLookupMultiTableOpMaker);
+
+REGISTER_OP_CPU_KERNEL(distributed_lookup_multi_table,
+                       ops::DistributedLookupMultiTableKernel<
+                           paddle::platform::CPUDeviceContext, float>);
@@ -0,0 +1,166 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+     http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License. */
+
+#pragma once
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "paddle/fluid/distributed/fleet.h"
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/tensor_util.h"
+#include "paddle/fluid/operators/math/math_function.h"
+
+namespace paddle {
+namespace operators {
+
+// The lookup of several sparse tables, like a distributed_lookup_table op per
+// table, but with a single pull request per server for all the tables.
+// The Ids and the Outputs of the tables follow each other, ids_nums[i] of
+// them for the i-th table.
+template <typename DeviceContext, typename T>
+class DistributedLookupMultiTableKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext &context) const override {
+    auto &scope = context.scope();
+
+    auto table_ids = context.Attr<std::vector<int>>("table_ids");
+    auto padding_idxs = context.Attr<std::vector<int64_t>>("padding_idxs");
+    auto ids_nums = context.Attr<std::vector<int>>("ids_nums");
+    auto embedding_names = context.InputNames("W");
+    size_t table_num = table_ids.size();
+
+    PADDLE_ENFORCE_EQ(
+        embedding_names.size(), table_num,
+        platform::errors::InvalidArgument(
+            "The number of W (%d) should be the number of table_ids (%d).",
+            embedding_names.size(), table_num));
+
+    std::vector<uint64_t> tables(table_num);
+    std::vector<uint64_t> paddings(table_num);
+    std::vector<int> emb_dims(table_num);
+    for (size_t t = 0; t < table_num; ++t) {
+      auto *var = scope.FindVar(embedding_names[t]);
+      if (var->IsType<framework::LoDTensor>()) {
+        emb_dims[t] = var->Get<framework::LoDTensor>().dims()[1];
+      } else if (var->IsType<framework::SelectedRows>()) {
+        emb_dims[t] = var->Get<framework::SelectedRows>().value().dims()[1];
+      } else {
+        PADDLE_THROW(platform::errors::InvalidArgument(
+            "Expected type of `W` must be Tensor, SelectedRows.But got "
+            "unsupport type: %s.",
+            framework::ToTypeName(var->Type())));
+      }
+      tables[t] = static_cast<uint64_t>(table_ids[t]);
+      paddings[t] = static_cast<uint64_t>(padding_idxs[t]);
+    }
+
+    auto inputs = context.MultiInput<framework::LoDTensor>("Ids");
+    auto outputs = context.MultiOutput<framework::LoDTensor>("Outputs");
+
+    auto fleet = distributed::FleetWrapper::GetInstance();
+
+    if (platform::is_cpu_place(context.GetPlace())) {
+      std::vector<std::vector<const framework::LoDTensor *>> table_inputs;
+      std::vector<std::vector<framework::LoDTensor *>> table_outputs;
+      SplitByTable(ids_nums, inputs, &table_inputs);
+      SplitByTable(ids_nums, outputs, &table_outputs);
+      fleet->PullSparseMultiTableToTensorSync(tables, emb_dims, paddings,
+                                              context.GetPlace(),
+                                              &table_inputs, &table_outputs);
+    } else {
+      auto inputs_variable = context.MultiInputVar("Ids");
+      auto outputs_variable = context.MultiOutputVar("Outputs");
+      auto inputs_name = context.InputNames("Ids");
+      auto outputs_name = context.OutputNames("Outputs");
+
+      auto cpu_place = platform::CPUPlace();
+      framework::Scope *tmp_scope = scope.NewTmpScope().release();
+
+      std::vector<const framework::LoDTensor *> tmp_input_vec;
+      auto input_var_size = inputs_variable.size();
+      std::vector<framework::LoDTensor *> tmp_output_vec;
+      auto output_var_size = outputs_variable.size();
+
+      // create temp input
+      for (size_t idx = 0; idx < input_var_size; ++idx) {
+        framework::Variable *tmp_input_var = tmp_scope->Var(inputs_name[idx]);
+        framework::LoDTensor *tmp_input_tensor =
+            tmp_input_var->GetMutable<framework::LoDTensor>();
+        framework::TensorCopy(inputs_variable[idx]->Get<framework::LoDTensor>(),
+                              cpu_place, context.device_context(),
+                              tmp_input_tensor);
+        tmp_input_vec.push_back(tmp_input_tensor);
+      }
+
+      // create temp output
+      for (size_t idx = 0; idx < output_var_size; ++idx) {
+        framework::Variable *tmp_output_var = tmp_scope->Var(outputs_name[idx]);
+        framework::LoDTensor *tmp_output_tensor =
+            tmp_output_var->GetMutable<framework::LoDTensor>();
+        tmp_output_tensor->Resize(outputs[idx]->dims());
+        tmp_output_vec.push_back(tmp_output_tensor);
+      }
+
+      std::vector<std::vector<const framework::LoDTensor *>> table_inputs;
+      std::vector<std::vector<framework::LoDTensor *>> table_outputs;
+      SplitByTable(ids_nums, tmp_input_vec, &table_inputs);
+      SplitByTable(ids_nums, tmp_output_vec, &table_outputs);
+      fleet->PullSparseMultiTableToTensorSync(tables, emb_dims, paddings,
+                                              cpu_place, &table_inputs,
+                                              &table_outputs);
+
+      // cp temp to origin
+      for (size_t idx = 0; idx < output_var_size; ++idx) {
+        framework::Variable *tmp_output_var = tmp_scope->Var(outputs_name[idx]);
+        framework::LoDTensor *tmp_output_tensor =
+            tmp_output_var->GetMutable<framework::LoDTensor>();
+        framework::TensorCopy(
+            *tmp_output_tensor, context.GetPlace(), context.device_context(),
+            outputs_variable[idx]->GetMutable<framework::LoDTensor>());
+      }
+      delete tmp_scope;
+    }
+
+    auto lookup_table_version =
+        context.Attr<std::string>("lookup_table_version");
+
+    if (lookup_table_version == "lookup_table_v2") {
+      size_t idx = 0;
+      for (size_t t = 0; t < table_num; ++t) {
+        for (int i = 0; i < ids_nums[t]; ++i, ++idx) {
+          auto id_dims = inputs[idx]->dims();
+          outputs[idx]->Resize(framework::make_ddim(
+              {static_cast<int64_t>(id_dims[0]),
+               static_cast<int64_t>(id_dims[1]),
+               static_cast<int64_t>(emb_dims[t])}));
+        }
+      }
+    }
+  }
+
+ private:
+  // Split the tensors of all the tables into the tensors of each table.
+  template <typename TensorPtr>
+  static void SplitByTable(const std::vector<int> &ids_nums,
+                           const std::vector<TensorPtr> &tensors,
+                           std::vector<std::vector<TensorPtr>> *table_tensors) {
+    table_tensors->resize(ids_nums.size());
+    auto begin = tensors.begin();
+    for (size_t t = 0; t < ids_nums.size(); ++t) {
+      (*table_tensors)[t].assign(begin, begin + ids_nums[t]);
+      begin += ids_nums[t];
+    }
+  }
+};
+
+}  // namespace operators
+}  // namespace paddle
@@ -158,6 +158,7 @@ TEST(HETER_LISTEN_AND_SERV, CPU) {
   LOG(INFO) << "before SendAndRecvAsync";
   rpc_client->SendAndRecvAsync({endpoint}, ctx, scope, in_var_name, send_var,
                                recv_var);
+  rpc_client->WaitSendAndRecv(scope, in_var_name);
   auto var = scope.Var(out_var_name);
   auto value = var->GetMutable<framework::LoDTensor>();
   auto ptr = value->mutable_data<float>(place);
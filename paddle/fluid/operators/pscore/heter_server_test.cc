@@ -14,11 +14,15 @@ limitations under the License. */
 
 #include <stdlib.h>
 #include <unistd.h>
+#include <algorithm>
+#include <atomic>
 #include <chrono>  // NOLINT
+#include <future>  // NOLINT
 #include <memory>
 #include <string>
 #include <thread>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/block_desc.h"
@@ -37,8 +41,15 @@ using VarMsg = ::paddle::VariableMessage;
 
 USE_OP(scale);
 
+DECLARE_int32(heter_client_max_inflight_micro_batches);
+
 std::shared_ptr<distributed::HeterServer> b_rpc_service;
 
+// The micro-batches being handled by the server, and the max of them.
+std::atomic<int> inflight_num{0};
+std::atomic<int> max_inflight_num{0};
+std::atomic<int> handled_num{0};
+
 framework::BlockDesc* AppendSendAndRecvBlock(framework::ProgramDesc* program) {
   auto root_block = program->MutableBlock(0);
   auto* block = program->AppendBlock(*root_block);
@@ -130,6 +141,7 @@ void StartSendAndRecvServer(std::string endpoint) {
                      std::shared_ptr<framework::ExecutorPrepareContext>>
       message_to_prepared_ctx;
   message_to_prepared_ctx[in_var_name] = prepared[0];
+  message_to_prepared_ctx["x_delay"] = prepared[0];
 
   std::shared_ptr<distributed::RequestSendAndRecvHandler> b_req_handler;
   b_req_handler.reset(new distributed::RequestSendAndRecvHandler());
@@ -152,6 +164,33 @@ void StartSendAndRecvServer(std::string endpoint) {
                        brpc::Controller* cntl) -> int {
         return b_req_handler->Handle(request, response, cntl);
       });
+  // The same stage on 4 threads of its own, where the earlier micro-batches
+  // take longer, so that they complete out of order.
+  b_rpc_service->RegisterServiceHandler(
+      "x_delay", [&](const MultiVarMsg* request, MultiVarMsg* response,
+                     brpc::Controller* cntl) -> int {
+        int inflight = ++inflight_num;
+        int max_inflight = max_inflight_num;
+        while (inflight > max_inflight &&
+               !max_inflight_num.compare_exchange_weak(max_inflight,
+                                                       inflight)) {
+        }
+        int order = handled_num++;
+        std::this_thread::sleep_for(
+            std::chrono::milliseconds(5 * (4 - order % 4)));
+        int ret = b_req_handler->Handle(request, response, cntl);
+        --inflight_num;
+        return ret;
+      });
+  b_rpc_service->SetStageThreadNum("x_delay", 4);
+  // A stage failing on its own thread.
+  b_rpc_service->RegisterServiceHandler(
+      "x_throw", [&](const MultiVarMsg* request, MultiVarMsg* response,
+                     brpc::Controller* cntl) -> int {
+        PADDLE_THROW(platform::errors::Unavailable("x_throw always fails."));
+        return 0;
+      });
+  b_rpc_service->SetStageThreadNum("x_throw", 1);
 
   LOG(INFO) << "before HeterServer::RunServer";
   std::thread server_thread(std::bind(RunServer, b_rpc_service));
@@ -192,6 +231,7 @@ TEST(SENDANDRECV, CPU) {
   LOG(INFO) << "before SendAndRecvAsync";
   rpc_client->SendAndRecvAsync({endpoint}, ctx, scope, in_var_name, send_var,
                                recv_var);
+  rpc_client->WaitSendAndRecv(scope, in_var_name);
   auto var = scope.Var(out_var_name);
   auto value = var->GetMutable<framework::LoDTensor>();
   auto ptr = value->mutable_data<float>(place);
@@ -202,6 +242,91 @@ TEST(SENDANDRECV, CPU) {
     EXPECT_EQ(ptr[i], 0.5);
   }
   LOG(INFO) << "end CHECK";
+
+  LOG(INFO) << "before SendAndRecvMicroBatch";
+  FLAGS_heter_client_max_inflight_micro_batches = 4;
+  const int micro_batch_num = 16;
+  std::vector<framework::Scope*> micro_scopes;
+  std::vector<std::future<int32_t>> futures;
+  for (int i = 0; i < micro_batch_num; ++i) {
+    auto* micro_scope = &scope.NewScope();
+    InitTensorsOnClient(micro_scope, &place, rows_numel);
+    auto* x_var = micro_scope->Var("x")->GetMutable<framework::LoDTensor>();
+    auto* x_ptr = x_var->data<float>();
+    std::fill(x_ptr, x_ptr + rows_numel, static_cast<float>(i + 1));
+    micro_scopes.push_back(micro_scope);
+    futures.push_back(rpc_client->SendAndRecvMicroBatch(
+        ctx, micro_scope, "x_delay", send_var, recv_var));
+  }
+  for (int i = 0; i < micro_batch_num; ++i) {
+    EXPECT_EQ(futures[i].get(), 0);
+    auto* res_ptr = micro_scopes[i]
+                        ->Var(out_var_name)
+                        ->GetMutable<framework::LoDTensor>()
+                        ->data<float>();
+    for (int64_t j = 0; j < rows_numel; ++j) {
+      EXPECT_EQ(res_ptr[j], 0.5 * (i + 1));
+    }
+  }
+  EXPECT_GT(max_inflight_num.load(), 1);
+  EXPECT_LE(max_inflight_num.load(),
+            FLAGS_heter_client_max_inflight_micro_batches);
+  auto client_stats = rpc_client->GetLatencyStats().Get();
+  EXPECT_EQ(client_stats["x_delay/rpc"].count, micro_batch_num);
+  auto server_stats = b_rpc_service->GetLatencyStats().Get();
+  EXPECT_EQ(server_stats["x_delay/compute"].count, micro_batch_num);
+  LOG(INFO) << "client latencies:\n"
+            << rpc_client->GetLatencyStats().ToString();
+  LOG(INFO) << "server latencies:\n"
+            << b_rpc_service->GetLatencyStats().ToString();
+  LOG(INFO) << "end SendAndRecvMicroBatch";
+
+  // The send_and_recv ops of the micro-batches return without waiting, and
+  // their send_and_recv_wait ops join them, so one thread fills the window.
+  LOG(INFO) << "before SendAndRecvAsync of micro-batches";
+  max_inflight_num = 0;
+  for (int i = 0; i < micro_batch_num; ++i) {
+    auto* x_ptr = micro_scopes[i]
+                      ->Var("x")
+                      ->GetMutable<framework::LoDTensor>()
+                      ->data<float>();
+    std::fill(x_ptr, x_ptr + rows_numel, static_cast<float>(2 * (i + 1)));
+    rpc_client->SendAndRecvAsync({endpoint}, ctx, *micro_scopes[i], "x_delay",
+                                 send_var, recv_var);
+  }
+  for (int i = 0; i < micro_batch_num; ++i) {
+    rpc_client->WaitSendAndRecv(*micro_scopes[i], "x_delay");
+    auto* res_ptr = micro_scopes[i]
+                        ->Var(out_var_name)
+                        ->GetMutable<framework::LoDTensor>()
+                        ->data<float>();
+    for (int64_t j = 0; j < rows_numel; ++j) {
+      EXPECT_EQ(res_ptr[j], 0.5 * 2 * (i + 1));
+    }
+  }
+  EXPECT_GT(max_inflight_num.load(), 1);
+  EXPECT_LE(max_inflight_num.load(),
+            FLAGS_heter_client_max_inflight_micro_batches);
+  // Waiting again does nothing.
+  rpc_client->WaitSendAndRecv(*micro_scopes[0], "x_delay");
+  LOG(INFO) << "end SendAndRecvAsync of micro-batches";
+
+  // The exception of the handler fails the RPC instead of the server.
+  EXPECT_EQ(
+      rpc_client->SendAndRecvMicroBatch(ctx, &scope, "x_throw", send_var,
+                                        recv_var)
+          .get(),
+      -1);
+  EXPECT_EQ(b_rpc_service->GetLatencyStats().Get()["x_throw/compute"].count,
+            1);
+  rpc_client->SendAndRecvAsync({endpoint}, ctx, scope, "x_throw", send_var,
+                               recv_var);
+  EXPECT_THROW(rpc_client->WaitSendAndRecv(scope, "x_throw"),
+               platform::EnforceNotMet);
+  // The stages are set before the server starts.
+  EXPECT_THROW(b_rpc_service->SetStageThreadNum("x_delay", 2),
+               platform::EnforceNotMet);
+
   rpc_client->FinalizeWorker();
   // b_rpc_service->Stop();
   b_rpc_service->Stop();
@@ -76,6 +76,8 @@ class SendAndRecvOpMaker : public framework::OpProtoAndCheckerMaker {
     SendAndRecv operator
     This operator will send variables to listen_and_serve op at the parameter server.
     And recv variable from parameter server of send variable's scope.
+    It returns without waiting for the response, and send_and_recv_wait of the
+    same message_name waits for it.
     )DOC");
   }
 };
@@ -0,0 +1,91 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/service/heter_client.h"
+#include "paddle/fluid/framework/op_registry.h"
+
+namespace paddle {
+namespace framework {
+class InferShapeContext;
+class OpDesc;
+class Scope;
+template <typename T>
+class EmptyGradOpMaker;
+}  // namespace framework
+namespace imperative {
+class OpBase;
+}  // namespace imperative
+}  // namespace paddle
+
+namespace paddle {
+namespace operators {
+
+class SendAndRecvWaitOp : public framework::OperatorBase {
+ public:
+  SendAndRecvWaitOp(const std::string& type,
+                    const framework::VariableNameMap& inputs,
+                    const framework::VariableNameMap& outputs,
+                    const framework::AttributeMap& attrs)
+      : OperatorBase(type, inputs, outputs, attrs) {}
+
+  void RunImpl(const framework::Scope& scope,
+               const platform::Place& place) const override {
+    auto message_name = Attr<std::string>("message_name");
+    auto epmap = Attr<std::vector<std::string>>("endpoints");
+    auto trainer_id = Attr<int>("trainer_id");
+
+    distributed::HeterClient* rpc_client =
+        distributed::HeterClient::GetInstance(epmap, trainer_id).get();
+    VLOG(3) << "SendAndRecvWaitOp message_name: " << message_name;
+    rpc_client->WaitSendAndRecv(scope, message_name);
+  }
+};
+
+class SendAndRecvWaitOpMaker : public framework::OpProtoAndCheckerMaker {
+ public:
+  void Make() {
+    AddInput("X", "(Any) Dummy inputs, used for control dependency")
+        .AsDispensable()
+        .AsDuplicable();
+    AddOutput("Out", "(Any) The variables received by send_and_recv")
+        .AsDuplicable();
+    AddAttr<std::string>("message_name", "");
+    AddAttr<int>("trainer_id", "trainer id from 0 ~ worker_num.").SetDefault(0);
+    AddAttr<std::vector<std::string>>("endpoints", "Server endpoint")
+        .SetDefault({"127.0.0.1:6164"});
+    AddComment(R"DOC(
+SendAndRecvWait operator
+
+This operator waits for the send_and_recv op of the same message_name in the
+same scope to receive its variables, so that the operators between them run
+while the heter worker computes.
+)DOC");
+  }
+};
+
+class SendAndRecvWaitOpShapeInference : public framework::InferShapeBase {
+ public:
+  void operator()(framework::InferShapeContext* ctx) const override {}
+};
+
+}  // namespace operators
+}  // namespace paddle
+
+namespace ops = paddle::operators;
+
+REGISTER_OPERATOR(
+    send_and_recv_wait, ops::SendAndRecvWaitOp,
+    paddle::framework::EmptyGradOpMaker<paddle::framework::OpDesc>,
+    paddle::framework::EmptyGradOpMaker<paddle::imperative::OpBase>,
+    ops::SendAndRecvWaitOpMaker, ops::SendAndRecvWaitOpShapeInference);
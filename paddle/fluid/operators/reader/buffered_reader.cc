@@ -13,15 +13,104 @@
 // limitations under the License.
 
 #include "paddle/fluid/operators/reader/buffered_reader.h"
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
+#include "gflags/gflags.h"
 #include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/platform/profiler.h"
 
+DEFINE_bool(reader_cpu_bind_numa, false,
+            "Whether to bind the reading thread of BufferedReader on "
+            "CPUPlace to the NUMA node of the thread consuming the batches.");
+
 namespace paddle {
 namespace operators {
 namespace reader {
+
+#ifdef __linux__
+// Parse an id of sysfs, which is the whole of str and fits in a cpu_set_t
+static bool ParseSysfsId(const std::string &str, int *id) {
+  if (str.empty() || str.size() > 9 ||
+      !std::all_of(str.begin(), str.end(),
+                   [](char c) { return c >= '0' && c <= '9'; })) {
+    return false;
+  }
+  *id = std::atoi(str.c_str());
+  return *id < CPU_SETSIZE;
+}
+
+// Parse a list like "0-3,8-11" of sysfs into the ids in it, and return false
+// if the list is malformed
+static bool ParseSysfsList(const std::string &list, std::vector<int> *ids) {
+  ids->clear();
+  size_t pos = 0;
+  while (pos < list.size()) {
+    size_t end = list.find(',', pos);
+    if (end == std::string::npos) end = list.size();
+    auto range = list.substr(pos, end - pos);
+    pos = end + 1;
+    if (range.empty()) continue;
+    auto dash = range.find('-');
+    int first = 0, last = 0;
+    if (!ParseSysfsId(range.substr(0, dash), &first)) return false;
+    if (dash == std::string::npos) {
+      last = first;
+    } else if (!ParseSysfsId(range.substr(dash + 1), &last) || last < first) {
+      return false;
+    }
+    for (int id = first; id <= last; ++id) {
+      ids->push_back(id);
+    }
+  }
+  return true;
+}
+
+static std::string ReadSysfsLine(const std::string &path) {
+  std::ifstream fin(path);
+  std::string line;
+  std::getline(fin, line);
+  return line;
+}
+
+// Get the cpus of the NUMA node containing the cpu. The online nodes are not
+// always numbered contiguously, so they are listed from sysfs.
+static bool GetNumaNodeCPUs(int cpu, cpu_set_t *cpus) {
+  std::vector<int> nodes;
+  if (!ParseSysfsList(ReadSysfsLine("/sys/devices/system/node/online"),
+                      &nodes)) {
+    return false;
+  }
+  for (int node : nodes) {
+    auto cpulist = ReadSysfsLine("/sys/devices/system/node/node" +
+                                 std::to_string(node) + "/cpulist");
+    std::vector<int> node_cpus;
+    if (!ParseSysfsList(cpulist, &node_cpus)) {
+      return false;
+    }
+    if (std::find(node_cpus.begin(), node_cpus.end(), cpu) ==
+        node_cpus.end()) {
+      continue;
+    }
+    CPU_ZERO(cpus);
+    for (int c : node_cpus) {
+      CPU_SET(c, cpus);
+    }
+    VLOG(1) << "CPU " << cpu << " is on NUMA node " << node
+            << ", cpulist: " << cpulist;
+    return true;
+  }
+  return false;
+}
+#endif
 BufferedReader::~BufferedReader() {
   VLOG(1) << "~BufferedReader";
   reader_->Shutdown();
@@ -58,8 +147,8 @@ BufferedReader::BufferedReader(
   }
 #endif
   is_same_place_ = false;
-  cpu_buffer_.resize(buffer_size);
-  cuda_buffer_.resize(buffer_size);
+  cpu_buffer_.resize(buffer_size_);
+  cuda_buffer_.resize(buffer_size_);
   ReadTillBufferFullAsync();
 }
 
@@ -190,6 +279,27 @@ void BufferedReader::ReadAsync(size_t i) {
   }));
 }
 
+void BufferedReader::BindReadingThreadToCurrentNode() {
+  numa_bound_ = true;
+#ifdef __linux__
+  int cpu = sched_getcpu();
+  cpu_set_t cpus;
+  if (cpu < 0 || !GetNumaNodeCPUs(cpu, &cpus)) {
+    VLOG(1) << "Cannot get the NUMA node of CPU " << cpu
+            << ", BufferedReader will not bind the reading thread";
+    return;
+  }
+  // The pool has only one thread, so the task runs on the reading thread
+  thread_pool_.enqueue([cpus]() {
+    int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpus);
+    if (ret != 0) {
+      LOG(WARNING) << "Failed to bind the reading thread of BufferedReader, "
+                   << "error code: " << ret;
+    }
+  });
+#endif
+}
+
 void BufferedReader::ShutdownImpl() {
   VLOG(1) << "ShutdownImpl";
   reader_->Shutdown();
@@ -209,7 +319,17 @@ void BufferedReader::ReadNextImpl(std::vector<framework::LoDTensor> *out) {
     out->clear();
     return;
   }
-  size_t i = position_.front().get();
+  if (FLAGS_reader_cpu_bind_numa && platform::is_cpu_place(place_) &&
+      !numa_bound_) {
+    BindReadingThreadToCurrentNode();
+  }
+
+  size_t i;
+  {
+    // The time the consumer waits for the next batch
+    platform::RecordEvent record_event("BufferedReader:WaitNextBatch");
+    i = position_.front().get();
+  }
   position_.pop();
 
   if (i == -1UL) {
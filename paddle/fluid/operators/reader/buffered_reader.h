@@ -46,6 +46,9 @@ class BufferedReader : public framework::DecoratedReader {
 
   void ReadAsync(size_t i);
 
+  // Bind the reading thread to the NUMA node of the current thread
+  void BindReadingThreadToCurrentNode();
+
  protected:
   void ShutdownImpl() override;
   void StartImpl() override;
@@ -68,6 +71,10 @@ class BufferedReader : public framework::DecoratedReader {
   std::vector<TensorVec> cpu_buffer_;
   std::vector<TensorVec> cuda_buffer_;
   size_t prev_pos_{-1UL};
+
+  // On CPUPlace, the reading thread is bound to the NUMA node of the consumer
+  // with FLAGS_reader_cpu_bind_numa.
+  bool numa_bound_{false};
 #ifdef PADDLE_WITH_CUDA
   cudaStream_t compute_stream_;
   std::shared_ptr<platform::CudaStreamObject> stream_;
@@ -0,0 +1,134 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/reader/buffered_reader.h"
+
+#include <chrono>  // NOLINT
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace operators {
+namespace reader {
+
+// Produce batch_num batches, the elements of the i-th batch are all i.
+class CountingReader : public framework::ReaderBase {
+ public:
+  CountingReader(int batch_num, int64_t batch_size, int decode_us)
+      : framework::ReaderBase({framework::make_ddim({batch_size})},
+                              {framework::proto::VarType::FP32}, {false}),
+        batch_num_(batch_num),
+        batch_size_(batch_size),
+        decode_us_(decode_us) {}
+
+ protected:
+  void ReadNextImpl(std::vector<framework::LoDTensor>* out) override {
+    out->clear();
+    if (cur_ >= batch_num_) return;
+    std::this_thread::sleep_for(std::chrono::microseconds(decode_us_));
+    framework::LoDTensor tensor;
+    tensor.Resize(framework::make_ddim({batch_size_}));
+    auto* data = tensor.mutable_data<float>(platform::CPUPlace());
+    for (int64_t i = 0; i < batch_size_; ++i) {
+      data[i] = cur_;
+    }
+    out->emplace_back(std::move(tensor));
+    ++cur_;
+  }
+
+  void StartImpl() override { cur_ = 0; }
+
+ private:
+  int batch_num_;
+  int64_t batch_size_;
+  int decode_us_;
+  int cur_{0};
+};
+
+// Read all the batches of reader, computing compute_us after each, and return
+// the average time to get the next batch in microseconds
+static double ReadAll(framework::ReaderBase* reader, int batch_num,
+                      int compute_us) {
+  double wait_us = 0;
+  for (int i = 0; i < batch_num; ++i) {
+    std::vector<framework::LoDTensor> batch;
+    auto start = std::chrono::steady_clock::now();
+    reader->ReadNext(&batch);
+    wait_us += std::chrono::duration<double, std::micro>(
+                   std::chrono::steady_clock::now() - start)
+                   .count();
+    EXPECT_EQ(batch.size(), 1UL);
+    EXPECT_EQ(batch[0].numel(), 1024);
+    EXPECT_EQ(batch[0].data<float>()[0], i);
+    EXPECT_EQ(batch[0].data<float>()[1023], i);
+    std::this_thread::sleep_for(std::chrono::microseconds(compute_us));
+  }
+  std::vector<framework::LoDTensor> eof;
+  reader->ReadNext(&eof);
+  EXPECT_TRUE(eof.empty());
+  return wait_us / batch_num;
+}
+
+static std::shared_ptr<framework::ReaderBase> MakeBufferedReader(
+    int batch_num, int decode_us, size_t buffer_size) {
+  return framework::MakeDecoratedReader<BufferedReader>(
+      std::make_shared<CountingReader>(batch_num, 1024, decode_us),
+      platform::CPUPlace(), buffer_size);
+}
+
+TEST(BufferedReader, CPURead) {
+  ReadAll(MakeBufferedReader(10, 0, 2).get(), 10, 0);
+  ReadAll(MakeBufferedReader(10, 0, 4).get(), 10, 0);
+}
+
+TEST(BufferedReader, CPUHoldBatches) {
+  auto reader = framework::MakeDecoratedReader<BufferedReader>(
+      std::make_shared<CountingReader>(6, 16, 0), platform::CPUPlace(), 2);
+
+  // The batches held by the consumer are never overwritten by the following
+  // reads.
+  std::vector<std::vector<framework::LoDTensor>> batches(6);
+  for (int i = 0; i < 6; ++i) {
+    reader->ReadNext(&batches[i]);
+    ASSERT_EQ(batches[i].size(), 1UL);
+  }
+  for (int i = 0; i < 6; ++i) {
+    for (int64_t j = 0; j < 16; ++j) {
+      EXPECT_EQ(batches[i][0].data<float>()[j], i);
+    }
+  }
+}
+
+// When the compute of a batch is longer than the decode, the batches read
+// ahead are ready before the consumer asks for them.
+TEST(BufferedReader, TimeToNextBatch) {
+  const int kBatchNum = 20;
+  const int kDecodeUs = 2000;
+  const int kComputeUs = 3000;
+  CountingReader unbuffered(kBatchNum, 1024, kDecodeUs);
+  double unbuffered_us = ReadAll(&unbuffered, kBatchNum, kComputeUs);
+  auto buffered = MakeBufferedReader(kBatchNum, kDecodeUs, 2);
+  double buffered_us = ReadAll(buffered.get(), kBatchNum, kComputeUs);
+  LOG(INFO) << "Average time to next batch, unbuffered: " << unbuffered_us
+            << " us, buffer_size 2: " << buffered_us << " us";
+  EXPECT_GE(unbuffered_us, kDecodeUs);
+  EXPECT_LT(buffered_us, kDecodeUs / 2);
+}
+
+}  // namespace reader
+}  // namespace operators
+}  // namespace paddle
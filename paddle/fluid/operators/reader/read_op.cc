@@ -108,7 +108,11 @@ class ReadOp : public framework::OperatorBase {
     // For profiling
     platform::RecordEvent record_event(Type());
 
-    reader->ReadNext(&ins);
+    {
+      platform::RecordTraceEvent trace_event("ReadNext",
+                                             platform::kTraceCategoryReader);
+      reader->ReadNext(&ins);
+    }
     if (ins.empty()) {
       VLOG(3) << "throw_eof_exp";
       PADDLE_THROW_EOF();
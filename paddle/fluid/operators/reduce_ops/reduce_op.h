@@ -140,6 +140,56 @@ void HandleLargeDimGrad(const framework::ExecutionContext& context,
         origin_axis);
 }
 
+// Reduce the trailing dims of input in parallel by the rows of the kept dims
+// on CPU. Return false if it is not applicable, e.g. the reduced dims are not
+// the trailing ones, or the input is too small to be worth the threads.
+template <typename DeviceContext, typename OutT, typename Functor>
+struct ParallelReduceFunctor {
+  bool operator()(const DeviceContext& dev_ctx, const Tensor& input,
+                  Tensor* output, const std::vector<int>& dims) const {
+    return false;
+  }
+};
+
+template <typename OutT, typename Functor>
+struct ParallelReduceFunctor<platform::CPUDeviceContext, OutT, Functor> {
+  bool operator()(const platform::CPUDeviceContext& dev_ctx,
+                  const Tensor& input, Tensor* output,
+                  const std::vector<int>& dims) const {
+    const int ndim = input.dims().size();
+    std::vector<int> sorted_dims(dims);
+    for (auto& dim : sorted_dims) {
+      if (dim < 0) dim += ndim;
+    }
+    std::sort(sorted_dims.begin(), sorted_dims.end());
+    const int rdim = static_cast<int>(sorted_dims.size());
+    if (rdim == 0 || rdim >= ndim) return false;
+    for (int i = 0; i < rdim; ++i) {
+      if (sorted_dims[i] != ndim - rdim + i) return false;
+    }
+
+    const int64_t rows = framework::product(
+        framework::slice_ddim(input.dims(), 0, ndim - rdim));
+    if (rows == 0) return false;
+    const int64_t reduced = input.numel() / rows;
+    const int64_t grain_size = platform::CPUDeviceContext::GrainSize(reduced);
+    if (dev_ctx.ParallelForNumThreads(rows, grain_size) <= 1) return false;
+
+    Tensor input_2d;
+    input_2d.ShareDataWith(input);
+    input_2d.Resize({rows, reduced});
+    Tensor output_1d;
+    output_1d.ShareDataWith(*output);
+    output_1d.Resize({rows});
+    dev_ctx.ParallelFor(0, rows, grain_size, [&](int64_t begin, int64_t end) {
+      Tensor out_chunk = output_1d.Slice(begin, end);
+      ReduceFunctor<platform::CPUDeviceContext, OutT, 2, 1, Functor>(
+          dev_ctx, input_2d.Slice(begin, end), &out_chunk, {1}, false);
+    });
+    return true;
+  }
+};
+
 template <typename DeviceContext, typename T, typename Functor>
 struct ReduceKernelFunctor {
   const Tensor* input;
@@ -174,6 +224,11 @@ struct ReduceKernelFunctor {
     } else {
       int ndim = input->dims().size();
       int rdim = dims.size();
+      if (ParallelReduceFunctor<DeviceContext, OutT, Functor>()(
+              context.template device_context<DeviceContext>(), *input,
+              output, dims)) {
+        return;
+      }
       if (ndim > 6) {
         HandleLargeDim<DeviceContext, OutT, Functor>(context, input, output,
                                                      dims, keep_dim);
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #pragma once
+#include <algorithm>
 #include <cstring>
 #include <string>
 
@@ -71,7 +72,7 @@ elementwise_inner_add(const framework::ExecutionContext& ctx,
  * return: output tensor
  */
 template <typename T, typename IndexT = int>
-void ScatterAssign(const platform::DeviceContext& ctx, const Tensor& src,
+void ScatterAssign(const platform::CPUDeviceContext& ctx, const Tensor& src,
                    const Tensor& index, Tensor* output) {
   PADDLE_ENFORCE_EQ(
       platform::is_cpu_place(ctx.GetPlace()), true,
@@ -112,10 +113,21 @@ void ScatterAssign(const platform::DeviceContext& ctx, const Tensor& src,
 
   const size_t slice_bytes = slice_size * sizeof(T);
 
-  for (int i = 0; i < index_size; ++i) {
-    IndexT index_ = p_index[i];
-    memcpy(p_output + index_ * slice_size, p_src + i * slice_size, slice_bytes);
-  }
+  // Split by the rows of output across threads, where each thread scans all
+  // the indices and writes its own rows, so that the last of the duplicate
+  // indices wins as in the serial loop.
+  const int64_t dst_rows = std::max<int64_t>(1, dst_dims[0]);
+  ctx.ParallelFor(
+      0, dst_rows,
+      platform::CPUDeviceContext::GrainSize(index_size * slice_size / dst_rows),
+      [&](int64_t row_begin, int64_t row_end) {
+        for (int i = 0; i < index_size; ++i) {
+          IndexT index_ = p_index[i];
+          if (index_ < row_begin || index_ >= row_end) continue;
+          memcpy(p_output + index_ * slice_size, p_src + i * slice_size,
+                 slice_bytes);
+        }
+      });
 }
 
 template <typename T, typename IndexT = int>
@@ -152,19 +164,29 @@ void ScatterAssignAdd(const framework::ExecutionContext& ctx, const Tensor& src,
 
   const size_t& slice_bytes = slice_size * sizeof(T);
 
-  // if not in overwrite mode, need to init output data
-  for (int i = 0; i < index_size; ++i) {
-    const IndexT& index_ = p_index[i];
-    memset(result_p_output + slice_size * index_, 0, slice_bytes);
-  }
-
-  // if not in overwrite mode, need to init output data
-  for (int i = 0; i < index_size; ++i) {
-    const IndexT& index_ = p_index[i];
-    elementwise_inner_add<T, IndexT>(ctx, p_src, p_output, result_p_output, src,
-                                     output, i, index_, slice_size,
-                                     slice_bytes);
-  }
+  // Split by the rows of output across threads as ScatterAssign, so that the
+  // updates of the duplicate indices are added in the order of the indices.
+  auto& dev_ctx = ctx.template device_context<platform::CPUDeviceContext>();
+  const int64_t dst_rows = std::max<int64_t>(1, dst_dims[0]);
+  dev_ctx.ParallelFor(
+      0, dst_rows,
+      platform::CPUDeviceContext::GrainSize(index_size * slice_size / dst_rows),
+      [&](int64_t row_begin, int64_t row_end) {
+        // if not in overwrite mode, need to init output data
+        for (int i = 0; i < index_size; ++i) {
+          const IndexT& index_ = p_index[i];
+          if (index_ < row_begin || index_ >= row_end) continue;
+          memset(result_p_output + slice_size * index_, 0, slice_bytes);
+        }
+
+        for (int i = 0; i < index_size; ++i) {
+          const IndexT& index_ = p_index[i];
+          if (index_ < row_begin || index_ >= row_end) continue;
+          elementwise_inner_add<T, IndexT>(ctx, p_src, p_output,
+                                           result_p_output, src, output, i,
+                                           index_, slice_size, slice_bytes);
+        }
+      });
 }
 
 template <typename T, typename IndexT = int>
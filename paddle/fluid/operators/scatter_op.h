@@ -39,6 +39,7 @@ class ScatterOpKernel : public framework::OpKernel<T> {
     // In place output: Out = X, Out[Ids] = Updates
     framework::TensorCopy(*X, ctx.GetPlace(), Out);
     // Apply ScatterUpdate: Out[index] = Updates[:]
+    auto &dev_ctx = ctx.template device_context<platform::CPUDeviceContext>();
     const auto &index_type = Ids->type();
     bool index_type_match = index_type == framework::proto::VarType::INT32 ||
                             index_type == framework::proto::VarType::INT64;
@@ -53,9 +54,9 @@ class ScatterOpKernel : public framework::OpKernel<T> {
                               framework::proto::VarType::INT64)));
     if (overwrite) {
       if (index_type == framework::proto::VarType::INT32) {
-        ScatterAssign<T, int32_t>(ctx.device_context(), *Updates, *Ids, Out);
+        ScatterAssign<T, int32_t>(dev_ctx, *Updates, *Ids, Out);
       } else {
-        ScatterAssign<T, int64_t>(ctx.device_context(), *Updates, *Ids, Out);
+        ScatterAssign<T, int64_t>(dev_ctx, *Updates, *Ids, Out);
       }
     } else {
       if (index_type == framework::proto::VarType::INT32) {
@@ -99,10 +100,11 @@ class ScatterGradientOpKernel : public framework::OpKernel<T> {
                   framework::proto::VarType::INT32),
               paddle::framework::DataTypeToString(
                   framework::proto::VarType::INT64)));
+      auto &dev_ctx = ctx.template device_context<platform::CPUDeviceContext>();
       if (index_type == framework::proto::VarType::INT32) {
-        CPUGather<T, int32_t>(ctx.device_context(), *dOut, *Ids, dUpdates);
+        CPUGather<T, int32_t>(dev_ctx, *dOut, *Ids, dUpdates);
       } else {
-        CPUGather<T, int64_t>(ctx.device_context(), *dOut, *Ids, dUpdates);
+        CPUGather<T, int64_t>(dev_ctx, *dOut, *Ids, dUpdates);
       }
     }
   }
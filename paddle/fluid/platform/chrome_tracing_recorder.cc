@@ -0,0 +1,444 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/platform/chrome_tracing_recorder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <utility>
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace platform {
+
+class ChromeTracingRecorder::ThreadBuffer {
+ public:
+  // The bytes allocated minus the bytes freed by the thread at a place
+  struct MemoryCounter {
+    Place place;
+    std::string name;
+    int64_t bytes;
+  };
+
+  ThreadBuffer(size_t capacity, uint64_t thread_id)
+      : capacity_(capacity), thread_id_(thread_id) {}
+
+  void Add(const TraceEvent& event) {
+    std::lock_guard<std::mutex> guard(mtx_);
+    if (events_.size() < capacity_) {
+      events_.emplace_back(event);
+    } else {
+      events_[next_ % capacity_] = event;
+    }
+    ++next_;
+  }
+
+  // Return the events in the order of recording
+  std::vector<TraceEvent> Snapshot() {
+    std::lock_guard<std::mutex> guard(mtx_);
+    std::vector<TraceEvent> result;
+    result.reserve(events_.size());
+    for (size_t i = next_ - events_.size(); i < next_; ++i) {
+      result.emplace_back(events_[i % capacity_]);
+    }
+    return result;
+  }
+
+  size_t Size() {
+    std::lock_guard<std::mutex> guard(mtx_);
+    return events_.size();
+  }
+
+  uint64_t ThreadId() const { return thread_id_; }
+
+  void MarkExited() { exited_.store(true, std::memory_order_release); }
+  bool Exited() const { return exited_.load(std::memory_order_acquire); }
+
+  // The following members are only accessed by the owner thread, or by
+  // others after it exited
+  size_t depth_{0};
+  size_t top_level_cnt_{0};
+  bool sampled_{false};
+  std::vector<MemoryCounter> mem_counters_;
+
+ private:
+  std::mutex mtx_;
+  std::vector<TraceEvent> events_;
+  size_t capacity_;
+  size_t next_{0};
+  uint64_t thread_id_;
+  std::atomic<bool> exited_{false};
+};
+
+namespace {
+
+// Mark the buffer of a thread exited when the thread exits
+struct ThreadBufferHolder {
+  ~ThreadBufferHolder() {
+    if (buffer != nullptr) {
+      buffer->MarkExited();
+    }
+  }
+
+  std::shared_ptr<ChromeTracingRecorder::ThreadBuffer> buffer;
+  uint64_t generation{0};
+};
+
+}  // namespace
+
+constexpr size_t ChromeTracingRecorder::TraceEvent::kMaxNameLength;
+constexpr size_t ChromeTracingRecorder::kMaxExitedThreadBuffers;
+std::atomic<bool> ChromeTracingRecorder::enabled_{false};
+
+ChromeTracingRecorder& ChromeTracingRecorder::Instance() {
+  static ChromeTracingRecorder recorder;
+  return recorder;
+}
+
+void ChromeTracingRecorder::Enable(size_t buffer_size_per_thread,
+                                   size_t sample_interval) {
+  PADDLE_ENFORCE_GT(buffer_size_per_thread, 0,
+                    platform::errors::InvalidArgument(
+                        "The buffer size of Chrome tracing should be larger "
+                        "than 0, but received %d.",
+                        buffer_size_per_thread));
+  PADDLE_ENFORCE_GT(sample_interval, 0,
+                    platform::errors::InvalidArgument(
+                        "The sample interval of Chrome tracing should be "
+                        "larger than 0, but received %d.",
+                        sample_interval));
+  {
+    std::lock_guard<std::mutex> guard(mtx_);
+    if (buffer_size_ != buffer_size_per_thread) {
+      buffers_.clear();
+      mem_base_bytes_.clear();
+      ++generation_;
+    }
+    buffer_size_ = buffer_size_per_thread;
+  }
+  sample_interval_ = sample_interval;
+  enabled_ = true;
+  VLOG(1) << "Enable Chrome tracing with buffer size "
+          << buffer_size_per_thread << " per thread, sample interval "
+          << sample_interval;
+}
+
+void ChromeTracingRecorder::Disable() { enabled_ = false; }
+
+void ChromeTracingRecorder::Reset() {
+  std::lock_guard<std::mutex> guard(mtx_);
+  buffers_.clear();
+  mem_base_bytes_.clear();
+  ++generation_;
+}
+
+void ChromeTracingRecorder::SetMemoryUsageFunc(MemoryUsageFunc func) {
+  std::lock_guard<std::mutex> guard(mtx_);
+  mem_usage_func_ = std::move(func);
+}
+
+ChromeTracingRecorder::ThreadBuffer* ChromeTracingRecorder::GetThreadBuffer() {
+  static std::atomic<uint64_t> next_thread_id{0};
+  thread_local ThreadBufferHolder holder;
+  thread_local uint64_t thread_id = next_thread_id++;
+
+  if (holder.buffer == nullptr || holder.generation != generation_) {
+    std::lock_guard<std::mutex> guard(mtx_);
+    ReclaimExitedBuffers();
+    holder.buffer = std::make_shared<ThreadBuffer>(buffer_size_, thread_id);
+    holder.generation = generation_;
+    buffers_.emplace_back(holder.buffer);
+  }
+  return holder.buffer.get();
+}
+
+void ChromeTracingRecorder::ReclaimExitedBuffers() {
+  size_t exited_num =
+      std::count_if(buffers_.begin(), buffers_.end(),
+                    [](const std::shared_ptr<ThreadBuffer>& buffer) {
+                      return buffer->Exited();
+                    });
+  if (exited_num <= kMaxExitedThreadBuffers) return;
+
+  // Drop the buffers registered first
+  size_t drop_num = exited_num - kMaxExitedThreadBuffers;
+  auto iter = std::remove_if(
+      buffers_.begin(), buffers_.end(),
+      [&](const std::shared_ptr<ThreadBuffer>& buffer) {
+        if (drop_num == 0 || !buffer->Exited()) return false;
+        for (auto& counter : buffer->mem_counters_) {
+          mem_base_bytes_[counter.name] += counter.bytes;
+        }
+        --drop_num;
+        return true;
+      });
+  buffers_.erase(iter, buffers_.end());
+}
+
+void ChromeTracingRecorder::InitMemoryBaseBytes(const Place& place,
+                                                const std::string& name,
+                                                int64_t delta_bytes) {
+  MemoryUsageFunc usage_func;
+  {
+    std::lock_guard<std::mutex> guard(mtx_);
+    if (mem_base_bytes_.count(name) > 0) return;
+    usage_func = mem_usage_func_;
+  }
+  // The allocator has already applied the first event
+  int64_t base_bytes = 0;
+  if (usage_func) {
+    int64_t used_bytes = usage_func(place);
+    if (used_bytes >= 0) {
+      base_bytes = used_bytes - delta_bytes;
+    }
+  }
+  std::lock_guard<std::mutex> guard(mtx_);
+  mem_base_bytes_.emplace(name, base_bytes);
+}
+
+bool ChromeTracingRecorder::BeginScope() {
+  auto* buffer = GetThreadBuffer();
+  if (buffer->depth_++ == 0) {
+    size_t interval = sample_interval_.load(std::memory_order_relaxed);
+    buffer->sampled_ = (buffer->top_level_cnt_++ % interval == 0);
+  }
+  return buffer->sampled_;
+}
+
+void ChromeTracingRecorder::EndScope() {
+  auto* buffer = GetThreadBuffer();
+  if (buffer->depth_ > 0) {
+    --buffer->depth_;
+  }
+}
+
+static void FillName(const std::string& name,
+                     ChromeTracingRecorder::TraceEvent* event) {
+  size_t len = std::min(name.size(),
+                        ChromeTracingRecorder::TraceEvent::kMaxNameLength);
+  std::memcpy(event->name, name.data(), len);
+  event->name[len] = '\0';
+}
+
+void ChromeTracingRecorder::AddCompleteEvent(const std::string& name,
+                                             const char* category,
+                                             uint64_t start_ns,
+                                             uint64_t end_ns) {
+  TraceEvent event;
+  FillName(name, &event);
+  event.category = category;
+  event.phase = 'X';
+  event.start_ns = start_ns;
+  event.end_ns = end_ns;
+  event.value = 0;
+  event.delta = 0;
+  GetThreadBuffer()->Add(event);
+}
+
+void ChromeTracingRecorder::AddMemoryEvent(const Place& place,
+                                           int64_t delta_bytes) {
+  auto* buffer = GetThreadBuffer();
+  auto& counters = buffer->mem_counters_;
+  auto iter = std::find_if(
+      counters.begin(), counters.end(),
+      [&](const ThreadBuffer::MemoryCounter& counter) {
+        return counter.place == place;
+      });
+  if (iter == counters.end()) {
+    std::ostringstream os;
+    os << place;
+    InitMemoryBaseBytes(place, os.str(), delta_bytes);
+    counters.push_back({place, os.str(), 0});
+    iter = counters.end() - 1;
+  }
+  iter->bytes += delta_bytes;
+  // Skip the memory events inside a scope which is not sampled, but still
+  // count the bytes
+  if (buffer->depth_ > 0 && !buffer->sampled_) return;
+
+  TraceEvent event;
+  FillName(iter->name, &event);
+  event.category = kTraceCategoryMemory;
+  event.phase = 'C';
+  event.start_ns = NowInNsec();
+  event.end_ns = event.start_ns;
+  event.value = iter->bytes;
+  event.delta = delta_bytes;
+  buffer->Add(event);
+}
+
+size_t ChromeTracingRecorder::RecordedEventNum() {
+  std::lock_guard<std::mutex> guard(mtx_);
+  size_t num = 0;
+  for (auto& buffer : buffers_) {
+    num += buffer->Size();
+  }
+  return num;
+}
+
+static void WriteJsonString(const char* str, std::ostream* os) {
+  *os << '"';
+  for (const char* c = str; *c != '\0'; ++c) {
+    switch (*c) {
+      case '"':
+        *os << "\\\"";
+        break;
+      case '\\':
+        *os << "\\\\";
+        break;
+      default:
+        if (static_cast<unsigned char>(*c) < 0x20) {
+          *os << ' ';
+        } else {
+          *os << *c;
+        }
+    }
+  }
+  *os << '"';
+}
+
+// Replace the bytes of each thread in the memory events with the bytes of
+// all threads, in the order of time.
+static void SumUpMemoryEvents(
+    const std::unordered_map<std::string, int64_t>& base_bytes,
+    std::vector<std::vector<ChromeTracingRecorder::TraceEvent>>* events) {
+  std::vector<ChromeTracingRecorder::TraceEvent*> mem_events;
+  std::vector<size_t> threads;
+  for (size_t i = 0; i < events->size(); ++i) {
+    for (auto& event : (*events)[i]) {
+      if (event.phase == 'C') {
+        mem_events.push_back(&event);
+        threads.push_back(i);
+      }
+    }
+  }
+  std::vector<size_t> order(mem_events.size());
+  for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return mem_events[a]->start_ns < mem_events[b]->start_ns;
+  });
+
+  // The older events of a thread may have been dropped, so its bytes start
+  // from those before its first event kept.
+  auto totals = base_bytes;
+  std::map<std::pair<std::string, size_t>, int64_t> thread_bytes;
+  for (size_t i : order) {
+    auto* event = mem_events[i];
+    int64_t bytes = event->value - event->delta;
+    if (thread_bytes.emplace(std::make_pair(event->name, threads[i]), bytes)
+            .second) {
+      totals[event->name] += bytes;
+    }
+  }
+  for (size_t i : order) {
+    auto* event = mem_events[i];
+    auto& bytes = thread_bytes[std::make_pair(event->name, threads[i])];
+    auto& total = totals[event->name];
+    total += event->value - bytes;
+    bytes = event->value;
+    event->value = total;
+  }
+}
+
+std::string ChromeTracingRecorder::ExportToString() {
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+  std::unordered_map<std::string, int64_t> base_bytes;
+  {
+    std::lock_guard<std::mutex> guard(mtx_);
+    buffers = buffers_;
+    base_bytes = mem_base_bytes_;
+  }
+  std::vector<std::vector<TraceEvent>> events;
+  for (auto& buffer : buffers) {
+    events.emplace_back(buffer->Snapshot());
+  }
+  SumUpMemoryEvents(base_bytes, &events);
+
+  std::ostringstream os;
+  os.precision(3);
+  os << std::fixed;
+  os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool first = true;
+  for (size_t i = 0; i < buffers.size(); ++i) {
+    for (auto& event : events[i]) {
+      if (!first) os << ",\n";
+      first = false;
+      // The unit of timestamps in Chrome trace-event format is microsecond
+      os << "{\"name\":";
+      WriteJsonString(event.name, &os);
+      os << ",\"cat\":\"" << event.category << "\",\"ph\":\"" << event.phase
+         << "\",\"pid\":0,\"tid\":" << buffers[i]->ThreadId()
+         << ",\"ts\":" << event.start_ns / 1000.0;
+      if (event.phase == 'X') {
+        os << ",\"dur\":" << (event.end_ns - event.start_ns) / 1000.0 << "}";
+      } else {
+        os << ",\"args\":{\"bytes\":" << event.value << "}}";
+      }
+    }
+  }
+  os << "]}\n";
+  return os.str();
+}
+
+void ChromeTracingRecorder::Export(const std::string& path) {
+  auto content = ExportToString();
+  std::ofstream fout(path, std::ios::out | std::ios::trunc);
+  PADDLE_ENFORCE_EQ(
+      fout.is_open(), true,
+      platform::errors::Unavailable("Cannot open file %s to export Chrome "
+                                    "tracing events.",
+                                    path));
+  fout << content;
+  fout.close();
+  VLOG(1) << "Export Chrome tracing events to " << path;
+}
+
+void RecordTraceEvent::Begin(const std::string& name, const char* category) {
+  if (name.empty()) return;
+  in_scope_ = true;
+  sampled_ = ChromeTracingRecorder::Instance().BeginScope();
+  if (sampled_) {
+    name_ = name;
+    category_ = category;
+    start_ns_ = ChromeTracingRecorder::NowInNsec();
+  }
+}
+
+void RecordTraceEvent::End() {
+  auto& recorder = ChromeTracingRecorder::Instance();
+  if (sampled_) {
+    recorder.AddCompleteEvent(name_, category_, start_ns_,
+                              ChromeTracingRecorder::NowInNsec());
+  }
+  recorder.EndScope();
+}
+
+void EnableChromeTracing(size_t buffer_size_per_thread,
+                         size_t sample_interval) {
+  ChromeTracingRecorder::Instance().Enable(buffer_size_per_thread,
+                                           sample_interval);
+}
+
+void DisableChromeTracing() { ChromeTracingRecorder::Instance().Disable(); }
+
+void ExportChromeTracing(const std::string& path) {
+  ChromeTracingRecorder::Instance().Export(path);
+}
+
+}  // namespace platform
+}  // namespace paddle
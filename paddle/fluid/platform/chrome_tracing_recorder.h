@@ -0,0 +1,186 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/fluid/platform/macros.h"
+#include "paddle/fluid/platform/place.h"
+
+namespace paddle {
+namespace platform {
+
+// The categories of the events in the exported timeline
+constexpr char kTraceCategoryOp[] = "op";
+constexpr char kTraceCategoryMemory[] = "memory";
+constexpr char kTraceCategoryRPC[] = "rpc";
+constexpr char kTraceCategoryReader[] = "reader";
+constexpr char kTraceCategoryThreadPool[] = "threadpool";
+
+/*
+ * ChromeTracingRecorder keeps the latest events of each thread in a bounded
+ * ring buffer, and exports them as Chrome trace-event JSON, which can be
+ * opened by chrome://tracing or Perfetto directly. Unlike the profiler, it
+ * does not summarize anything and never grows beyond the buffer size, so
+ * that it can be enabled in long-running training and serving processes.
+ * The buffers grow as the events are recorded, and at most
+ * kMaxExitedThreadBuffers buffers of the exited threads are kept, so the
+ * threads recording few events or created on the fly do not cost a full
+ * buffer each.
+ *
+ * To reduce the overhead, only one of every `sample_interval` top-level
+ * events of each thread is recorded, together with all events nested in it.
+ */
+class ChromeTracingRecorder {
+ public:
+  struct TraceEvent {
+    static constexpr size_t kMaxNameLength = 63;
+
+    char name[kMaxNameLength + 1];
+    const char* category;
+    // 'X' for complete event, 'C' for counter event
+    char phase;
+    uint64_t start_ns;
+    uint64_t end_ns;
+    // The bytes allocated by the thread at the place for a counter event,
+    // and the change of them by this event.
+    int64_t value;
+    int64_t delta;
+  };
+
+  class ThreadBuffer;
+
+  static constexpr size_t kMaxExitedThreadBuffers = 16;
+
+  // Return the bytes in use at the place, or a negative number if unknown.
+  using MemoryUsageFunc = std::function<int64_t(const Place&)>;
+
+  static ChromeTracingRecorder& Instance();
+
+  static bool IsEnabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  static uint64_t NowInNsec() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  void Enable(size_t buffer_size_per_thread, size_t sample_interval);
+
+  void Disable();
+
+  // Drop all recorded events
+  void Reset();
+
+  // Write all recorded events to path as Chrome trace-event JSON. It can be
+  // called while recording.
+  void Export(const std::string& path);
+
+  std::string ExportToString();
+
+  // Return whether the events of current scope should be recorded. A
+  // top-level scope is sampled, and the nested scopes follow it.
+  bool BeginScope();
+  void EndScope();
+
+  void AddCompleteEvent(const std::string& name, const char* category,
+                        uint64_t start_ns, uint64_t end_ns);
+
+  // Record the allocated bytes of place after allocating (positive
+  // delta_bytes) or freeing (negative delta_bytes) memory. Each thread counts
+  // the bytes itself, and the counters of all threads are summed up by the
+  // export, on top of the bytes in use when the place is first recorded.
+  void AddMemoryEvent(const Place& place, int64_t delta_bytes);
+
+  // Set the function to get the bytes in use at a place, from the stats of
+  // the allocator.
+  void SetMemoryUsageFunc(MemoryUsageFunc func);
+
+  size_t RecordedEventNum();
+
+ private:
+  ChromeTracingRecorder() = default;
+
+  ThreadBuffer* GetThreadBuffer();
+
+  // Drop the buffers of the exited threads except the latest ones, and keep
+  // their memory counters in the base bytes. Called with mtx_ held.
+  void ReclaimExitedBuffers();
+
+  // Take the bytes in use at place before its first memory event, which
+  // changes the bytes by delta_bytes, as the base bytes of it.
+  void InitMemoryBaseBytes(const Place& place, const std::string& name,
+                           int64_t delta_bytes);
+
+  static std::atomic<bool> enabled_;
+
+  std::mutex mtx_;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+  // Increased when the buffers are dropped, so that each thread knows that
+  // its cached buffer is out of date.
+  std::atomic<uint64_t> generation_{0};
+  // Guarded by mtx_
+  size_t buffer_size_{0};
+  std::atomic<size_t> sample_interval_{1};
+
+  // The bytes of each place not counted by the buffers, guarded by mtx_
+  std::unordered_map<std::string, int64_t> mem_base_bytes_;
+  MemoryUsageFunc mem_usage_func_;
+
+  DISABLE_COPY_AND_ASSIGN(ChromeTracingRecorder);
+};
+
+// Record the scope as a complete event if Chrome tracing is enabled
+class RecordTraceEvent {
+ public:
+  RecordTraceEvent(const std::string& name, const char* category) {
+    if (!ChromeTracingRecorder::IsEnabled()) return;
+    Begin(name, category);
+  }
+
+  ~RecordTraceEvent() {
+    if (in_scope_) End();
+  }
+
+ private:
+  void Begin(const std::string& name, const char* category);
+  void End();
+
+  bool in_scope_{false};
+  bool sampled_{false};
+  uint64_t start_ns_{0};
+  std::string name_;
+  const char* category_{nullptr};
+
+  DISABLE_COPY_AND_ASSIGN(RecordTraceEvent);
+};
+
+void EnableChromeTracing(size_t buffer_size_per_thread,
+                         size_t sample_interval);
+void DisableChromeTracing();
+void ExportChromeTracing(const std::string& path);
+
+}  // namespace platform
+}  // namespace paddle
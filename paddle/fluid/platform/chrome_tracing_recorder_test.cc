@@ -0,0 +1,155 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/platform/chrome_tracing_recorder.h"
+
+#include <string>
+#include <thread>  // NOLINT
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/platform/profiler.h"
+
+namespace paddle {
+namespace platform {
+
+TEST(ChromeTracingRecorder, ExportJson) {
+  auto& recorder = ChromeTracingRecorder::Instance();
+  recorder.Reset();
+  recorder.SetMemoryUsageFunc(nullptr);
+  EnableChromeTracing(/*buffer_size_per_thread=*/100, /*sample_interval=*/1);
+  {
+    RecordEvent outer("outer_op");
+    RecordTraceEvent inner("read \"batch\"", kTraceCategoryReader);
+  }
+  std::thread worker([] { RecordEvent event("worker_op"); });
+  worker.join();
+  MemEvenRecorder::Instance().PushMemRecord(&recorder, CPUPlace(), 1024);
+  MemEvenRecorder::Instance().PopMemRecord(&recorder, CPUPlace(), 1024);
+  DisableChromeTracing();
+
+  // Nothing is recorded after disabled
+  { RecordEvent ignored("ignored_op"); }
+  EXPECT_EQ(recorder.RecordedEventNum(), 5UL);
+
+  auto json = recorder.ExportToString();
+  EXPECT_EQ(json.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["), 0UL);
+  EXPECT_NE(json.find("\"name\":\"outer_op\",\"cat\":\"op\",\"ph\":\"X\""),
+            std::string::npos);
+  EXPECT_NE(json.find("\"name\":\"read \\\"batch\\\"\",\"cat\":\"reader\""),
+            std::string::npos);
+  EXPECT_NE(json.find("\"name\":\"worker_op\""), std::string::npos);
+  EXPECT_NE(json.find("\"ph\":\"C\""), std::string::npos);
+  EXPECT_NE(json.find("\"args\":{\"bytes\":1024}"), std::string::npos);
+  EXPECT_NE(json.find("\"args\":{\"bytes\":0}"), std::string::npos);
+  EXPECT_EQ(json.find("ignored_op"), std::string::npos);
+  recorder.Reset();
+}
+
+TEST(ChromeTracingRecorder, BoundedBufferAndSampling) {
+  auto& recorder = ChromeTracingRecorder::Instance();
+  recorder.Reset();
+  EnableChromeTracing(/*buffer_size_per_thread=*/16, /*sample_interval=*/4);
+  for (int i = 0; i < 32; ++i) {
+    RecordEvent event("op_" + std::to_string(i));
+  }
+  DisableChromeTracing();
+  // 8 of 32 events are sampled
+  EXPECT_EQ(recorder.RecordedEventNum(), 8UL);
+
+  EnableChromeTracing(/*buffer_size_per_thread=*/16, /*sample_interval=*/1);
+  for (int i = 0; i < 1000; ++i) {
+    RecordEvent event("op_" + std::to_string(i));
+  }
+  DisableChromeTracing();
+  // Only the latest events are kept
+  EXPECT_EQ(recorder.RecordedEventNum(), 16UL);
+  auto json = recorder.ExportToString();
+  EXPECT_NE(json.find("\"op_999\""), std::string::npos);
+  EXPECT_EQ(json.find("\"op_0\""), std::string::npos);
+  recorder.Reset();
+}
+
+TEST(ChromeTracingRecorder, MemoryCounters) {
+  auto& recorder = ChromeTracingRecorder::Instance();
+  recorder.Reset();
+  // 4096 bytes are in use after the first allocation
+  recorder.SetMemoryUsageFunc([](const Place& place) { return 4096; });
+  EnableChromeTracing(/*buffer_size_per_thread=*/100, /*sample_interval=*/1);
+  MemEvenRecorder::Instance().PushMemRecord(&recorder, CPUPlace(), 1024);
+  // Freed by another thread
+  std::thread worker([&recorder] {
+    MemEvenRecorder::Instance().PopMemRecord(&recorder, CPUPlace(), 1024);
+  });
+  worker.join();
+  DisableChromeTracing();
+  recorder.SetMemoryUsageFunc(nullptr);
+
+  auto json = recorder.ExportToString();
+  EXPECT_NE(json.find("\"args\":{\"bytes\":4096}"), std::string::npos);
+  EXPECT_NE(json.find("\"args\":{\"bytes\":3072}"), std::string::npos);
+  EXPECT_EQ(json.find("\"args\":{\"bytes\":-1024}"), std::string::npos);
+  recorder.Reset();
+}
+
+TEST(ChromeTracingRecorder, ExitedThreadBuffers) {
+  auto& recorder = ChromeTracingRecorder::Instance();
+  recorder.Reset();
+  recorder.SetMemoryUsageFunc(nullptr);
+  EnableChromeTracing(/*buffer_size_per_thread=*/100, /*sample_interval=*/1);
+  const size_t kThreadNum = 40;
+  for (size_t i = 0; i < kThreadNum; ++i) {
+    std::thread worker([&recorder] {
+      MemEvenRecorder::Instance().PushMemRecord(&recorder, CPUPlace(), 100);
+    });
+    worker.join();
+  }
+  MemEvenRecorder::Instance().PushMemRecord(&recorder, CPUPlace(), 1);
+  DisableChromeTracing();
+
+  // Only the buffers of the latest exited threads are kept, but the bytes
+  // allocated by the others are still counted.
+  EXPECT_EQ(recorder.RecordedEventNum(),
+            ChromeTracingRecorder::kMaxExitedThreadBuffers + 1);
+  auto json = recorder.ExportToString();
+  EXPECT_NE(json.find("\"args\":{\"bytes\":4001}"), std::string::npos);
+  recorder.Reset();
+}
+
+TEST(ChromeTracingRecorder, Overhead) {
+  auto& recorder = ChromeTracingRecorder::Instance();
+  recorder.Reset();
+  const std::string name = "overhead_op";
+  const int kRepeat = 100000;
+
+  auto bench = [&]() {
+    uint64_t start = ChromeTracingRecorder::NowInNsec();
+    for (int i = 0; i < kRepeat; ++i) {
+      RecordEvent event(name);
+    }
+    return static_cast<double>(ChromeTracingRecorder::NowInNsec() - start) /
+           kRepeat;
+  };
+
+  double disabled_ns = bench();
+  EnableChromeTracing(/*buffer_size_per_thread=*/1024, /*sample_interval=*/1);
+  double enabled_ns = bench();
+  DisableChromeTracing();
+  LOG(INFO) << "RecordEvent costs " << disabled_ns
+            << " ns when Chrome tracing is disabled, " << enabled_ns
+            << " ns when enabled";
+  recorder.Reset();
+}
+
+}  // namespace platform
+}  // namespace paddle
@@ -13,6 +13,10 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/platform/cpu_helper.h"
+
+#include <algorithm>
+
+#include "gflags/gflags.h"
 #include "paddle/fluid/platform/enforce.h"
 
 #ifdef PADDLE_WITH_MKLML
@@ -24,9 +28,14 @@ limitations under the License. */
 #include <cblas.h>
 #endif
 
+DECLARE_int32(intra_op_num_threads);
+
 namespace paddle {
 namespace platform {
 
+// Each thread running the kernels, e.g. a predictor, has its own number.
+static thread_local int intra_op_num_threads = 0;
+
 void SetNumThreads(int num_threads) {
 #ifdef PADDLE_USE_OPENBLAS
 // windows has no support for openblas multi-thread
@@ -52,5 +61,20 @@ void SetNumThreads(int num_threads) {
 #endif
 }
 
+void SetIntraOpNumThreads(int num_threads) {
+  intra_op_num_threads = num_threads > 0 ? num_threads : 0;
+}
+
+int GetIntraOpNumThreads() {
+#ifdef PADDLE_WITH_MKLML
+  // Not omp_get_max_threads, which the trainers set to 1 by SetNumThreads for
+  // their MKL calls.
+  if (intra_op_num_threads > 0) return intra_op_num_threads;
+  return std::max(FLAGS_intra_op_num_threads, 1);
+#else
+  return 1;
+#endif
+}
+
 }  // namespace platform
 }  // namespace paddle
@@ -22,5 +22,14 @@ namespace platform {
 //! Set the number of threads in use.
 void SetNumThreads(int num_threads);
 
+//! Set the number of threads of the intra-op parallelism of the CPU kernels
+//! run by the calling thread, see CPUDeviceContext::ParallelFor. 0, the
+//! default, uses FLAGS_intra_op_num_threads.
+void SetIntraOpNumThreads(int num_threads);
+
+//! Get the number of threads of the intra-op parallelism of the calling
+//! thread, which is 1 without OpenMP.
+int GetIntraOpNumThreads();
+
 }  // namespace platform
 }  // namespace paddle
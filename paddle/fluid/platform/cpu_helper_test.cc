@@ -14,9 +14,40 @@ limitations under the License. */
 
 #include "paddle/fluid/platform/cpu_helper.h"
 
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
 
+DECLARE_int32(intra_op_num_threads);
+
 TEST(CpuHelper, SetNumThread) {
   paddle::platform::SetNumThreads(1);
   paddle::platform::SetNumThreads(4);
 }
+
+TEST(CpuHelper, SetIntraOpNumThreads) {
+  EXPECT_EQ(paddle::platform::GetIntraOpNumThreads(), 1);
+  paddle::platform::SetIntraOpNumThreads(3);
+#ifdef PADDLE_WITH_MKLML
+  EXPECT_EQ(paddle::platform::GetIntraOpNumThreads(), 3);
+#else
+  EXPECT_EQ(paddle::platform::GetIntraOpNumThreads(), 1);
+#endif
+  paddle::platform::SetIntraOpNumThreads(0);
+  EXPECT_EQ(paddle::platform::GetIntraOpNumThreads(), 1);
+}
+
+TEST(CpuHelper, IntraOpNumThreadsFlag) {
+  // The trainers set the number of MKL threads to 1.
+  paddle::platform::SetNumThreads(1);
+  FLAGS_intra_op_num_threads = 2;
+#ifdef PADDLE_WITH_MKLML
+  EXPECT_EQ(paddle::platform::GetIntraOpNumThreads(), 2);
+  paddle::platform::SetIntraOpNumThreads(3);
+  EXPECT_EQ(paddle::platform::GetIntraOpNumThreads(), 3);
+#else
+  EXPECT_EQ(paddle::platform::GetIntraOpNumThreads(), 1);
+#endif
+  paddle::platform::SetIntraOpNumThreads(0);
+  FLAGS_intra_op_num_threads = 1;
+  EXPECT_EQ(paddle::platform::GetIntraOpNumThreads(), 1);
+}
@@ -32,3 +32,17 @@ TEST(CpuMemoryUsage, Print) {
                                        use_percent, memory_size)
             << std::endl;
 }
+
+TEST(CpuInfo, MayIUseVnni) {
+  using paddle::platform::MayIUse;
+  // VNNI is an extension of the AVX512 core instructions.
+  if (MayIUse(paddle::platform::avx512_core_vnni)) {
+    EXPECT_TRUE(MayIUse(paddle::platform::avx512_core));
+  }
+  if (MayIUse(paddle::platform::avx512_core)) {
+    EXPECT_TRUE(MayIUse(paddle::platform::avx2));
+  }
+  LOG(INFO) << "avx512_core: " << MayIUse(paddle::platform::avx512_core)
+            << ", avx512_core_vnni: "
+            << MayIUse(paddle::platform::avx512_core_vnni);
+}
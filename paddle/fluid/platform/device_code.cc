@@ -14,15 +14,33 @@ limitations under the License. */
 
 #include "paddle/fluid/platform/device_code.h"
 
+#include <dlfcn.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
 #include <set>
+#include <sstream>
 #include <utility>
 
 #include "paddle/fluid/platform/enforce.h"
 
 DECLARE_string(cuda_dir);
 
+DEFINE_string(fusion_group_cpu_compiler, "c++",
+              "The host compiler used to compile the code generated by "
+              "fusion_group for CPU.");
+DEFINE_string(fusion_group_cpu_cache_dir, "",
+              "The directory to cache the libraries compiled from the code "
+              "generated by fusion_group for CPU. It should be owned by the "
+              "current user and not writable by the others. Default to "
+              "/tmp/paddle_fusion_group_<uid>.");
+
 namespace paddle {
 namespace platform {
 
@@ -71,6 +89,9 @@ DeviceCodePool::DeviceCodePool(const std::vector<platform::Place>& places) {
   for (auto& p : places) {
     set.insert(p);
   }
+  // CPUPlace is always supported, because the pool may be initialized by a
+  // program running on GPU before the one running on CPU.
+  device_codes_.emplace(CPUPlace(), DeviceCodeMap());
   for (auto& p : set) {
     if (is_gpu_place(p)) {
 #ifdef PADDLE_WITH_CUDA
@@ -87,6 +108,218 @@ DeviceCodePool::DeviceCodePool(const std::vector<platform::Place>& places) {
 #endif
 }
 
+// The flags to compile the generated code for CPU.
+static constexpr char kCPUCompileFlags[] =
+    "-std=c++11 -O3 -march=native -fPIC -shared";
+
+static std::string RunCommand(const std::string& cmd) {
+  std::string output;
+  FILE* pipe = popen(cmd.c_str(), "r");
+  if (pipe == nullptr) {
+    return output;
+  }
+  char buffer[256];
+  while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
+    output += buffer;
+  }
+  pclose(pipe);
+  return output;
+}
+
+// The lines of /proc/cpuinfo that decide the code generated by -march=native,
+// so that a cache shared across machines never loads a library built for
+// another CPU.
+static const std::string& HostCPUSignature() {
+  static std::string signature = [] {
+    std::ifstream fin("/proc/cpuinfo");
+    std::string line;
+    std::string model_name;
+    std::string flags;
+    while (std::getline(fin, line)) {
+      if (model_name.empty() && line.compare(0, 10, "model name") == 0) {
+        model_name = line;
+      } else if (flags.empty() && line.compare(0, 5, "flags") == 0) {
+        flags = line;
+      }
+    }
+    return model_name + "\n" + flags;
+  }();
+  return signature;
+}
+
+// The 64-bit FNV-1a hash of str. Unlike std::hash, it is the same in every
+// process and build, so it is able to name the libraries in the cache.
+static std::string FNV1aHash(const std::string& str) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : str) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  char buffer[17];
+  snprintf(buffer, sizeof(buffer), "%016" PRIx64, hash);
+  return buffer;
+}
+
+// A suffix unique among the threads of all processes, for the temporary files
+// which are renamed into the cache once complete.
+static std::string UniqueSuffix() {
+  static std::atomic<int> count{0};
+  return std::to_string(getpid()) + "_" + std::to_string(count++);
+}
+
+static std::string CPUCacheDir() {
+  if (!FLAGS_fusion_group_cpu_cache_dir.empty()) {
+    return FLAGS_fusion_group_cpu_cache_dir;
+  }
+  return "/tmp/paddle_fusion_group_" + std::to_string(geteuid());
+}
+
+// Whether path is a directory or a regular file (not a symbolic link) owned by
+// the current user and not writable by the group or the others, so that no
+// other user is able to plant a library to be loaded into this process.
+static bool IsOwnedAndPrivate(const std::string& path, bool is_dir) {
+  struct stat st;
+  if (lstat(path.c_str(), &st) != 0) {
+    return false;
+  }
+  if (is_dir ? !S_ISDIR(st.st_mode) : !S_ISREG(st.st_mode)) {
+    return false;
+  }
+  return st.st_uid == geteuid() && (st.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+}
+
+bool CPUDeviceCode::IsAvailable() {
+  static bool available = [] {
+    std::string cmd =
+        FLAGS_fusion_group_cpu_compiler + " --version > /dev/null 2>&1";
+    bool ret = std::system(cmd.c_str()) == 0;
+    if (!ret) {
+      LOG(WARNING) << "Cannot find the host compiler "
+                   << FLAGS_fusion_group_cpu_compiler
+                   << " for JIT compiling of CPU code. Please specify it by "
+                      "export FLAGS_fusion_group_cpu_compiler=xxx.";
+    }
+    return ret;
+  }();
+  return available;
+}
+
+CPUDeviceCode::CPUDeviceCode(const Place& place, const std::string& name,
+                             const std::string& kernel) {
+  if (!is_cpu_place(place)) {
+    PADDLE_THROW(platform::errors::PermissionDenied(
+        "CPUDeviceCode can only launch on CPU place."));
+  }
+
+  place_ = place;
+  name_ = name;
+  kernel_ = kernel;
+}
+
+CPUDeviceCode::~CPUDeviceCode() {
+  if (handle_ != nullptr) {
+    dlclose(handle_);
+  }
+}
+
+static std::string ReadFile(const std::string& path) {
+  std::ifstream fin(path);
+  std::stringstream ss;
+  ss << fin.rdbuf();
+  return ss.str();
+}
+
+bool CPUDeviceCode::Compile(bool include_path) {
+  is_compiled_ = false;
+  if (!IsAvailable()) {
+    return false;
+  }
+
+  std::string cache_dir = CPUCacheDir();
+  mkdir(cache_dir.c_str(), 0700);
+  if (!IsOwnedAndPrivate(cache_dir, true)) {
+    LOG(WARNING) << "Refuse to use " << cache_dir
+                 << " as the cache of the JIT compiled CPU code, it should be "
+                    "a directory owned by the current user and not writable "
+                    "by the others.";
+    return false;
+  }
+
+  // The library depends on the compiler and the host CPU besides the code.
+  static std::string compiler_version =
+      RunCommand(FLAGS_fusion_group_cpu_compiler + " --version 2>&1");
+  std::string key = kernel_ + "\n" + FLAGS_fusion_group_cpu_compiler + "\n" +
+                    compiler_version + "\n" + kCPUCompileFlags + "\n" +
+                    HostCPUSignature();
+  std::string prefix = cache_dir + "/" + name_ + "_" + FNV1aHash(key);
+  std::string lib_path = prefix + ".so";
+
+  struct stat st;
+  if (lstat(lib_path.c_str(), &st) != 0) {
+    // Write and compile temporary files first, so that concurrent compilings
+    // never truncate the files of each other, and other processes never load
+    // an incomplete library.
+    std::string tmp_prefix = prefix + "." + UniqueSuffix();
+    std::string src_path = tmp_prefix + ".cc";
+    std::string log_path = tmp_prefix + ".log";
+    std::string tmp_path = tmp_prefix + ".so";
+    {
+      std::ofstream fout(src_path);
+      fout << kernel_;
+    }
+    std::string cmd = FLAGS_fusion_group_cpu_compiler + " " +
+                      kCPUCompileFlags + " -o " + tmp_path + " " + src_path +
+                      " > " + log_path + " 2>&1";
+    VLOG(3) << "Compile CPU code: " << cmd;
+    bool success = std::system(cmd.c_str()) == 0;
+    if (!success) {
+      LOG(WARNING) << "JIT compiling of CPU code failed:"
+                   << "\n  Kernel name: " << name_ << "\n  Kernel body:\n"
+                   << kernel_ << "\n  Compiling log: " << ReadFile(log_path);
+    }
+    std::remove(log_path.c_str());
+    // Keep the source beside the library for debugging.
+    std::rename(src_path.c_str(), (prefix + ".cc").c_str());
+    if (!success) {
+      std::remove(tmp_path.c_str());
+      return false;
+    }
+    chmod(tmp_path.c_str(), 0700);
+    if (std::rename(tmp_path.c_str(), lib_path.c_str()) != 0) {
+      LOG(WARNING) << "Fail to move " << tmp_path << " to " << lib_path;
+      std::remove(tmp_path.c_str());
+      return false;
+    }
+  }
+
+  if (!IsOwnedAndPrivate(lib_path, false)) {
+    LOG(WARNING) << "Refuse to load " << lib_path
+                 << ", it should be a regular file owned by the current user "
+                    "and not writable by the others.";
+    return false;
+  }
+  handle_ = dlopen(lib_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (handle_ == nullptr) {
+    LOG(WARNING) << "Fail to load " << lib_path << ": " << dlerror();
+    return false;
+  }
+  function_ = reinterpret_cast<KernelFunc>(dlsym(handle_, name_.c_str()));
+  if (function_ == nullptr) {
+    LOG(WARNING) << "Cannot find function " << name_ << " in " << lib_path;
+    return false;
+  }
+  is_compiled_ = true;
+  return true;
+}
+
+void CPUDeviceCode::Launch(const size_t n, std::vector<void*>* args) const {
+  PADDLE_ENFORCE_EQ(
+      is_compiled_, true,
+      errors::PreconditionNotMet(
+          "Please compile the code before launching the kernel."));
+  function_(static_cast<int64_t>(n), args->data() + 1);
+}
+
 #ifdef PADDLE_WITH_CUDA
 static bool CheckCUDADriverResult(CUresult result, std::string caller,
                                   std::string kernel_name = "") {
@@ -75,6 +75,33 @@ class CUDADeviceCode : public DeviceCode {
 };
 #endif
 
+// CPUDeviceCode compiles the generated C++ code into a shared library by the
+// host compiler, and loads it by dlopen. The library is cached in
+// FLAGS_fusion_group_cpu_cache_dir and keyed by the hash of the code, the
+// compiler, the flags and the host CPU, so that the same code is only compiled
+// once, even across processes. The cache directory and the library are only
+// used if they are owned by the current user and not writable by the others.
+class CPUDeviceCode : public DeviceCode {
+ public:
+  using KernelFunc = void (*)(int64_t n, void** args);
+
+  explicit CPUDeviceCode(const Place& place, const std::string& name,
+                         const std::string& kernel);
+  ~CPUDeviceCode();
+
+  bool Compile(bool include_path = false) override;
+  // args[0] points to n, and the others point to the pointers of inputs and
+  // outputs, which is the same as the arguments of CUDADeviceCode.
+  void Launch(const size_t n, std::vector<void*>* args) const override;
+
+  static bool IsAvailable();
+
+ private:
+  bool is_compiled_{false};
+  void* handle_{nullptr};
+  KernelFunc function_{nullptr};
+};
+
 class DeviceCodePool {
  public:
   using DeviceCodeMap =
@@ -13,7 +13,16 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/platform/device_code.h"
+#include <dirent.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <string>
+#include <thread>  // NOLINT
 #include <utility>
+#include <vector>
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/platform/init.h"
@@ -28,6 +37,131 @@ void saxpy_kernel(float a, float *x, float* y, float* z, size_t n) {
 }
 )";
 
+DECLARE_string(fusion_group_cpu_cache_dir);
+
+constexpr auto saxpy_cpu_code = R"(
+#include <cstdint>
+
+extern "C" void saxpy_cpu_kernel(int64_t n, void** args) {
+  float a = 2;
+  float* __restrict__ x = *reinterpret_cast<float**>(args[0]);
+  float* __restrict__ y = *reinterpret_cast<float**>(args[1]);
+  float* __restrict__ z = *reinterpret_cast<float**>(args[2]);
+  for (int64_t i = 0; i < n; ++i) {
+    z[i] = a * x[i] + y[i];
+  }
+}
+)";
+
+// The files in dir whose names end with suffix.
+static std::vector<std::string> ListFiles(const std::string& dir,
+                                          const std::string& suffix) {
+  std::vector<std::string> files;
+  DIR* d = opendir(dir.c_str());
+  if (d == nullptr) {
+    return files;
+  }
+  while (struct dirent* entry = readdir(d)) {
+    std::string name = entry->d_name;
+    if (name != "." && name != ".." && name.size() > suffix.size() &&
+        name.substr(name.size() - suffix.size()) == suffix) {
+      files.push_back(dir + "/" + name);
+    }
+  }
+  closedir(d);
+  return files;
+}
+
+// The libraries compiled into dir.
+static std::vector<std::string> ListLibraries(const std::string& dir) {
+  return ListFiles(dir, ".so");
+}
+
+static bool RunSaxpyOnCPU() {
+  paddle::platform::CPUDeviceCode code(paddle::platform::CPUPlace(),
+                                       "saxpy_cpu_kernel", saxpy_cpu_code);
+  if (!code.Compile()) {
+    return false;
+  }
+  size_t n = 1000;
+  std::vector<float> x(n), y(n, 0.5), z(n);
+  for (size_t i = 0; i < n; ++i) {
+    x[i] = static_cast<float>(i);
+  }
+  float* x_data = x.data();
+  float* y_data = y.data();
+  float* z_data = z.data();
+  std::vector<void*> args = {&n, &x_data, &y_data, &z_data};
+  code.Launch(n, &args);
+  for (size_t i = 0; i < n; i++) {
+    EXPECT_EQ(z[i], static_cast<float>(i) * 2 + 0.5);
+  }
+  return true;
+}
+
+TEST(DeviceCode, cpu) {
+  if (!paddle::platform::CPUDeviceCode::IsAvailable()) {
+    return;
+  }
+  char dir_template[] = "/tmp/device_code_test_XXXXXX";
+  std::string cache_dir = mkdtemp(dir_template);
+  FLAGS_fusion_group_cpu_cache_dir = cache_dir;
+
+  // Compile, and then load from the cache.
+  EXPECT_TRUE(RunSaxpyOnCPU());
+  auto libs = ListLibraries(cache_dir);
+  ASSERT_EQ(libs.size(), 1UL);
+  EXPECT_TRUE(RunSaxpyOnCPU());
+
+  // A library which the others are able to write is never loaded.
+  chmod(libs[0].c_str(), 0777);
+  EXPECT_FALSE(RunSaxpyOnCPU());
+  std::remove(libs[0].c_str());
+
+  // Neither is a cache directory which the others are able to write.
+  chmod(cache_dir.c_str(), 0777);
+  EXPECT_FALSE(RunSaxpyOnCPU());
+  EXPECT_TRUE(ListLibraries(cache_dir).empty());
+  chmod(cache_dir.c_str(), 0700);
+  EXPECT_TRUE(RunSaxpyOnCPU());
+
+  for (auto& lib : ListLibraries(cache_dir)) {
+    std::remove(lib.c_str());
+  }
+}
+
+TEST(DeviceCode, cpu_concurrent_compiling) {
+  if (!paddle::platform::CPUDeviceCode::IsAvailable()) {
+    return;
+  }
+  char dir_template[] = "/tmp/device_code_test_XXXXXX";
+  std::string cache_dir = mkdtemp(dir_template);
+  FLAGS_fusion_group_cpu_cache_dir = cache_dir;
+
+  // The threads compiling the same code at the same time share one library,
+  // and leave no temporary files behind.
+  std::vector<int> results(4, 0);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < results.size(); ++i) {
+    threads.emplace_back([&results, i] { results[i] = RunSaxpyOnCPU(); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int result : results) {
+    EXPECT_TRUE(result);
+  }
+  auto files = ListFiles(cache_dir, "");
+  EXPECT_EQ(ListLibraries(cache_dir).size(), 1UL);
+  EXPECT_EQ(ListFiles(cache_dir, ".cc").size(), 1UL);
+  EXPECT_EQ(files.size(), 2UL);
+
+  for (auto& file : files) {
+    std::remove(file.c_str());
+  }
+  rmdir(cache_dir.c_str());
+}
+
 #ifdef PADDLE_WITH_CUDA
 TEST(DeviceCode, cuda) {
   if (!paddle::platform::dynload::HasNVRTC() ||
@@ -165,6 +165,21 @@ Eigen::DefaultDevice* CPUDeviceContext::eigen_device() const {
 
 Place CPUDeviceContext::GetPlace() const { return place_; }
 
+constexpr int64_t CPUDeviceContext::kDefaultGrainSize;
+
+int CPUDeviceContext::ParallelForNumThreads(int64_t size,
+                                            int64_t grain_size) const {
+#ifdef PADDLE_WITH_MKLML
+  // The nested parallel regions oversubscribe the cores.
+  if (omp_in_parallel()) return 1;
+  int64_t max_chunks = size / std::max<int64_t>(1, grain_size);
+  return static_cast<int>(std::max<int64_t>(
+      1, std::min<int64_t>(GetIntraOpNumThreads(), max_chunks)));
+#else
+  return 1;
+#endif
+}
+
 #ifdef PADDLE_WITH_XPU
 XPUDeviceContext::XPUDeviceContext() { context_ = xpu::create_context(); }
 
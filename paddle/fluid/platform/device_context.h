@@ -10,6 +10,8 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 #pragma once
 
+#include <algorithm>
+#include <exception>
 #include <future>  // NOLINT
 #include <memory>
 #include <mutex>  // NOLINT
@@ -42,6 +44,7 @@ limitations under the License. */
 #include <map>
 
 #include "glog/logging.h"
+#include "paddle/fluid/platform/cpu_helper.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/place.h"
 #ifdef PADDLE_WITH_CUDA
@@ -49,6 +52,10 @@ limitations under the License. */
 #endif
 #include "unsupported/Eigen/CXX11/Tensor"
 
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
 namespace Eigen {
 struct DefaultDevice;
 struct GpuDevice;
@@ -96,6 +103,62 @@ class CPUDeviceContext : public DeviceContext {
 
   Place GetPlace() const override;
 
+  // The number of the elements of a simple element-wise loop, e.g. an add,
+  // worth the overhead of a thread.
+  static constexpr int64_t kDefaultGrainSize = 32768;
+
+  // The grain size of the loops whose iteration costs about cost elements of
+  // a simple element-wise loop, e.g. the rows of a matrix.
+  static int64_t GrainSize(int64_t cost) {
+    return std::max<int64_t>(1, kDefaultGrainSize / std::max<int64_t>(1, cost));
+  }
+
+  // The number of threads ParallelFor runs a range of size with.
+  int ParallelForNumThreads(int64_t size, int64_t grain_size) const;
+
+  // Split [begin, end) into contiguous chunks of at least grain_size
+  // iterations, and run func(chunk_begin, chunk_end) on them by at most
+  // GetIntraOpNumThreads() threads. All the chunks are run even if OpenMP
+  // gives the region fewer threads, e.g. with OMP_DYNAMIC or a thread limit.
+  // It runs in the calling thread if the range is small, inside another
+  // parallel region, or without OpenMP. The first exception thrown by func
+  // is rethrown.
+  template <typename Func>
+  void ParallelFor(int64_t begin, int64_t end, int64_t grain_size,
+                   const Func& func) const {
+    if (begin >= end) return;
+    const int num_threads = ParallelForNumThreads(end - begin, grain_size);
+    if (num_threads <= 1) {
+      func(begin, end);
+      return;
+    }
+#ifdef PADDLE_WITH_MKLML
+    const int64_t chunk = (end - begin + num_threads - 1) / num_threads;
+    const int64_t num_chunks = (end - begin + chunk - 1) / chunk;
+    std::exception_ptr exception;
+    std::once_flag exception_flag;
+#pragma omp parallel num_threads(num_threads)
+    {
+      // The team may be smaller than num_threads, so each thread takes every
+      // omp_get_num_threads()-th chunk.
+      for (int64_t i = omp_get_thread_num(); i < num_chunks;
+           i += omp_get_num_threads()) {
+        int64_t chunk_begin = begin + i * chunk;
+        int64_t chunk_end = std::min(end, chunk_begin + chunk);
+        try {
+          func(chunk_begin, chunk_end);
+        } catch (...) {
+          std::call_once(exception_flag,
+                         [&] { exception = std::current_exception(); });
+        }
+      }
+    }
+    if (exception) {
+      std::rethrow_exception(exception);
+    }
+#endif
+  }
+
  private:
   CPUPlace place_;
   std::unique_ptr<Eigen::DefaultDevice> eigen_device_;
@@ -33,6 +33,22 @@
 DEFINE_int32(paddle_num_threads, 1,
              "Number of threads for each paddle instance.");
 
+/**
+ * Performance related FLAG
+ * Name: FLAGS_intra_op_num_threads
+ * Since Version: 2.0.0
+ * Value Range: int32, default=1
+ * Example: FLAGS_intra_op_num_threads=4 would run the ported CPU kernels,
+ * e.g. the elementwise broadcast, by up to 4 threads in training.
+ * Note: The number of threads of the intra-op parallelism of the CPU kernels
+ * run by the threads which do not set their own, i.e. the executors and the
+ * trainers. A predictor uses AnalysisConfig::SetCpuIntraOpNumThreads
+ * instead. It needs OpenMP, i.e. a build with MKLML.
+ */
+DEFINE_int32(intra_op_num_threads, 1,
+             "The number of threads of the intra-op parallelism of the CPU "
+             "kernels in training, 1 to run them serially.");
+
 /**
  * Operator related FLAG
  * Name: FLAGS_check_nan_inf
@@ -564,3 +580,50 @@ DEFINE_string(tracer_mkldnn_ops_on, "",
  */
 DEFINE_string(tracer_mkldnn_ops_off, "",
               "List of OneDNN operation types to be turned off");
+
+/**
+ * Performance related FLAG
+ * Name: op_stat_sample_interval
+ * Since Version: 2.0.0
+ * Value Range: int32, default=16
+ * Example: FLAGS_op_stat_sample_interval=1 would measure the wall time and
+ * allocated memory of every operator call.
+ * Note: The call count of each operator type is always collected. Only one of
+ * every FLAGS_op_stat_sample_interval calls is timed, and the result is scaled
+ * up accordingly. Set to 0 to disable timing.
+ */
+DEFINE_int32(op_stat_sample_interval, 16,
+             "Measure the wall time and allocated memory of one of every "
+             "FLAGS_op_stat_sample_interval operator calls. 0 to disable.");
+
+/**
+ * Executor related FLAG
+ * Name: fast_executor_priority_scheduling
+ * Since Version: 2.0.0
+ * Value Range: bool, default=false
+ * Example: FLAGS_fast_executor_priority_scheduling=true would schedule the
+ * ready ops of FastThreadedSSAGraphExecutor by priority.
+ * Note: The priority of an op is the length of the longest path from it to the
+ * end of the graph, and the ops transferring data between devices come first.
+ * The ready ops are kept in per-thread priority queues, and the idle threads
+ * steal from the others.
+ */
+DEFINE_bool(fast_executor_priority_scheduling, false,
+            "Schedule the ready ops of FastThreadedSSAGraphExecutor by the "
+            "critical path of the graph.");
+
+/**
+ * Executor related FLAG
+ * Name: fast_executor_inline_op_us
+ * Since Version: 2.0.0
+ * Value Range: int32, default=20
+ * Example: FLAGS_fast_executor_inline_op_us=0 would never run the ready ops
+ * on the thread which makes them ready, except the one of highest priority.
+ * Note: Only used with FLAGS_fast_executor_priority_scheduling. The ops whose
+ * last run takes less than FLAGS_fast_executor_inline_op_us microseconds are
+ * run on the thread which makes them ready, since waking up another thread
+ * costs more than running them.
+ */
+DEFINE_int32(fast_executor_inline_op_us, 20,
+             "Run the ready ops taking less than this many microseconds on "
+             "the current thread when scheduling by priority.");
@@ -67,6 +67,27 @@ class StatValue : public MonitorRegistrar {
   }
 };
 
+// Integer stats are updated in hot paths such as running operators, so use
+// atomic instead of lock for them.
+template <>
+class StatValue<int64_t> : public MonitorRegistrar {
+  std::atomic<int64_t> v_{0};
+
+ public:
+  explicit StatValue(const std::string& n);
+  int64_t increase(int64_t inc) {
+    return v_.fetch_add(inc, std::memory_order_relaxed) + inc;
+  }
+  int64_t decrease(int64_t inc) {
+    return v_.fetch_sub(inc, std::memory_order_relaxed) - inc;
+  }
+  int64_t reset(int64_t value = 0) {
+    v_.store(value, std::memory_order_relaxed);
+    return value;
+  }
+  int64_t get() { return v_.load(std::memory_order_relaxed); }
+};
+
 template <typename T>
 struct ExportedStatValue {
   std::string key;
@@ -124,6 +145,10 @@ class StatRegistry {
   std::unordered_map<std::string, StatValue<T>*> stats_;
 };
 
+inline StatValue<int64_t>::StatValue(const std::string& n) {
+  StatRegistry<int64_t>::Instance().add(n, this);
+}
+
 }  // namespace platform
 }  // namespace paddle
 
@@ -0,0 +1,113 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/platform/op_stat.h"
+
+#include <thread>  // NOLINT
+
+#include "gflags/gflags.h"
+
+DECLARE_int32(op_stat_sample_interval);
+
+namespace paddle {
+namespace platform {
+
+static double CalibrateNsPerCpuCycle() {
+#ifdef PADDLE_WITH_RDTSC
+  auto start_time = std::chrono::steady_clock::now();
+  uint64_t start_cycles = CpuCycles();
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  uint64_t end_cycles = CpuCycles();
+  double ns = std::chrono::duration<double, std::nano>(
+                  std::chrono::steady_clock::now() - start_time)
+                  .count();
+  double ratio =
+      end_cycles > start_cycles ? ns / (end_cycles - start_cycles) : 1.0;
+  VLOG(3) << "Calibrated TSC: " << ratio << " ns per cycle";
+  return ratio;
+#else
+  return 1.0;
+#endif
+}
+
+double NsPerCpuCycle() {
+  static double ratio = CalibrateNsPerCpuCycle();
+  return ratio;
+}
+
+OpStat::OpStat(const std::string& op_type)
+    : calls("STAT_op_" + op_type + "_calls"),
+      time_ns("STAT_op_" + op_type + "_time_ns"),
+      alloc_bytes("STAT_op_" + op_type + "_alloc_bytes") {}
+
+OpStatRegistry& OpStatRegistry::Instance() {
+  // Calibrate before running any operator, so that the calibration is not
+  // counted in the time of the first sampled call.
+  static double unused = NsPerCpuCycle();
+  (void)unused;
+  static OpStatRegistry registry;
+  return registry;
+}
+
+OpStat* OpStatRegistry::Get(const std::string& op_type) {
+  std::lock_guard<std::mutex> guard(mtx_);
+  auto& stat = stats_[op_type];
+  if (stat == nullptr) {
+    stat.reset(new OpStat(op_type));
+  }
+  return stat.get();
+}
+
+std::vector<std::string> OpStatRegistry::OpTypes() {
+  std::lock_guard<std::mutex> guard(mtx_);
+  std::vector<std::string> op_types;
+  op_types.reserve(stats_.size());
+  for (auto& pair : stats_) {
+    op_types.emplace_back(pair.first);
+  }
+  return op_types;
+}
+
+void OpStatRegistry::Reset() {
+  std::lock_guard<std::mutex> guard(mtx_);
+  for (auto& pair : stats_) {
+    pair.second->calls.reset();
+    pair.second->time_ns.reset();
+    pair.second->alloc_bytes.reset();
+  }
+}
+
+int64_t& ThreadAllocatedBytes() {
+  thread_local int64_t allocated_bytes = 0;
+  return allocated_bytes;
+}
+
+bool ShouldSampleOpStat(int64_t call_index) {
+  int interval = FLAGS_op_stat_sample_interval;
+  if (interval <= 0) return false;
+  return (call_index - 1) % interval == 0;
+}
+
+void RecordOpStat::End() {
+  uint64_t cycles = CpuCycles() - start_cycles_;
+  int64_t bytes = ThreadAllocatedBytes() - start_bytes_;
+  int64_t interval = FLAGS_op_stat_sample_interval;
+  if (interval <= 0) return;
+  stat_->time_ns.increase(
+      static_cast<int64_t>(cycles * NsPerCpuCycle() * interval));
+  stat_->alloc_bytes.increase(bytes * interval);
+}
+
+}  // namespace platform
+}  // namespace paddle
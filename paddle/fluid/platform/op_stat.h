@@ -0,0 +1,131 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#ifdef _WIN32
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define PADDLE_WITH_RDTSC
+#endif
+
+#include "paddle/fluid/platform/macros.h"
+#include "paddle/fluid/platform/monitor.h"
+
+namespace paddle {
+namespace platform {
+
+// Return a cheap monotonic timestamp. It is the TSC on x86-64, and
+// nanoseconds on the other platforms. Use NsPerCpuCycle to convert it.
+inline uint64_t CpuCycles() {
+#ifdef PADDLE_WITH_RDTSC
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+// The result is calibrated once against steady_clock
+double NsPerCpuCycle();
+
+// The counters of one operator type. They are registered to the int64
+// StatRegistry as STAT_op_<type>_calls, STAT_op_<type>_time_ns and
+// STAT_op_<type>_alloc_bytes, so they are published together with the other
+// stats.
+struct OpStat {
+  explicit OpStat(const std::string& op_type);
+
+  StatValue<int64_t> calls;
+  // Wall time and allocated bytes are only measured for the sampled calls,
+  // and scaled by the sample interval.
+  StatValue<int64_t> time_ns;
+  StatValue<int64_t> alloc_bytes;
+};
+
+class OpStatRegistry {
+ public:
+  static OpStatRegistry& Instance();
+
+  // The returned pointer is valid during the whole process
+  OpStat* Get(const std::string& op_type);
+
+  std::vector<std::string> OpTypes();
+
+  void Reset();
+
+ private:
+  OpStatRegistry() = default;
+
+  std::mutex mtx_;
+  std::unordered_map<std::string, std::unique_ptr<OpStat>> stats_;
+
+  DISABLE_COPY_AND_ASSIGN(OpStatRegistry);
+};
+
+// The bytes allocated by the current thread, used to count the memory
+// allocated by each operator.
+int64_t& ThreadAllocatedBytes();
+
+inline void AddThreadAllocatedBytes(size_t size) {
+  ThreadAllocatedBytes() += static_cast<int64_t>(size);
+}
+
+// Return whether the call_index-th (from 1) call of an operator type should
+// be measured, according to FLAGS_op_stat_sample_interval. The calls are
+// counted by each type, so every type is sampled evenly no matter how the
+// calls of the types interleave on a thread.
+bool ShouldSampleOpStat(int64_t call_index);
+
+// Update the counters of an operator in the scope
+class RecordOpStat {
+ public:
+  explicit RecordOpStat(OpStat* stat) : stat_(stat) {
+    if (stat_ == nullptr) return;
+    sampled_ = ShouldSampleOpStat(stat_->calls.increase(1));
+    if (sampled_) {
+      start_bytes_ = ThreadAllocatedBytes();
+      start_cycles_ = CpuCycles();
+    }
+  }
+
+  ~RecordOpStat() {
+    if (sampled_) End();
+  }
+
+ private:
+  void End();
+
+  OpStat* stat_;
+  bool sampled_{false};
+  uint64_t start_cycles_{0};
+  int64_t start_bytes_{0};
+
+  DISABLE_COPY_AND_ASSIGN(RecordOpStat);
+};
+
+}  // namespace platform
+}  // namespace paddle
@@ -0,0 +1,107 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/platform/op_stat.h"
+
+#include <thread>  // NOLINT
+
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+
+DECLARE_int32(op_stat_sample_interval);
+
+namespace paddle {
+namespace platform {
+
+TEST(OpStat, CountAndPublish) {
+  FLAGS_op_stat_sample_interval = 1;
+  auto* stat = OpStatRegistry::Instance().Get("test_op");
+  EXPECT_EQ(stat, OpStatRegistry::Instance().Get("test_op"));
+  OpStatRegistry::Instance().Reset();
+
+  for (int i = 0; i < 3; ++i) {
+    RecordOpStat record(stat);
+    AddThreadAllocatedBytes(256);
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  EXPECT_EQ(stat->calls.get(), 3);
+  EXPECT_EQ(stat->alloc_bytes.get(), 768);
+  EXPECT_GE(stat->time_ns.get(), 300000);
+
+  bool found = false;
+  for (auto& item : StatRegistry<int64_t>::Instance().publish()) {
+    if (item.key == "STAT_op_test_op_calls") {
+      EXPECT_EQ(item.value, 3);
+      found = true;
+    }
+  }
+  EXPECT_TRUE(found);
+}
+
+TEST(OpStat, Sampling) {
+  FLAGS_op_stat_sample_interval = 4;
+  auto* stat = OpStatRegistry::Instance().Get("sampled_op");
+  OpStatRegistry::Instance().Reset();
+  for (int i = 0; i < 8; ++i) {
+    RecordOpStat record(stat);
+    AddThreadAllocatedBytes(16);
+  }
+  EXPECT_EQ(stat->calls.get(), 8);
+  // 2 of 8 calls are sampled, and scaled by 4
+  EXPECT_EQ(stat->alloc_bytes.get(), 128);
+
+  FLAGS_op_stat_sample_interval = 0;
+  { RecordOpStat record(stat); }
+  EXPECT_EQ(stat->calls.get(), 9);
+  FLAGS_op_stat_sample_interval = 16;
+}
+
+TEST(OpStat, InterleavedTypes) {
+  FLAGS_op_stat_sample_interval = 2;
+  auto* first = OpStatRegistry::Instance().Get("first_op");
+  auto* second = OpStatRegistry::Instance().Get("second_op");
+  OpStatRegistry::Instance().Reset();
+  // The two types alternate on a thread, and each is still sampled every
+  // other call.
+  for (int i = 0; i < 8; ++i) {
+    {
+      RecordOpStat record(first);
+      AddThreadAllocatedBytes(16);
+    }
+    {
+      RecordOpStat record(second);
+      AddThreadAllocatedBytes(16);
+    }
+  }
+  EXPECT_EQ(first->alloc_bytes.get(), 128);
+  EXPECT_EQ(second->alloc_bytes.get(), 128);
+  FLAGS_op_stat_sample_interval = 16;
+}
+
+TEST(OpStat, Overhead) {
+  auto* stat = OpStatRegistry::Instance().Get("overhead_op");
+  const int kRepeat = 1000000;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kRepeat; ++i) {
+    RecordOpStat record(stat);
+  }
+  double ns = std::chrono::duration<double, std::nano>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+  LOG(INFO) << "RecordOpStat costs " << ns / kRepeat << " ns per call";
+  EXPECT_EQ(stat->calls.get(), kRepeat);
+}
+
+}  // namespace platform
+}  // namespace paddle
@@ -0,0 +1,76 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/platform/cpu_helper.h"
+#include "paddle/fluid/platform/device_context.h"
+
+namespace paddle {
+namespace platform {
+
+// Run ParallelFor over [0, size) and check that each iteration runs once.
+static void CheckParallelFor(const CPUDeviceContext& ctx, int64_t size,
+                             int64_t grain_size) {
+  std::vector<int> counts(size, 0);
+  ctx.ParallelFor(0, size, grain_size, [&counts](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      ++counts[i];
+    }
+  });
+  for (int64_t i = 0; i < size; ++i) {
+    ASSERT_EQ(counts[i], 1) << "iteration " << i << " of " << size;
+  }
+}
+
+TEST(CPUDeviceContext, ParallelFor) {
+  CPUDeviceContext ctx;
+  SetIntraOpNumThreads(4);
+  for (int64_t size : {0, 1, 3, 4, 5, 1000, 1001}) {
+    CheckParallelFor(ctx, size, 1);
+  }
+  CheckParallelFor(ctx, 1000, 300);
+
+  EXPECT_THROW(ctx.ParallelFor(0, 100, 1,
+                               [](int64_t begin, int64_t end) {
+                                 if (begin == 0) {
+                                   throw std::runtime_error("error");
+                                 }
+                               }),
+               std::runtime_error);
+  SetIntraOpNumThreads(0);
+}
+
+#ifdef PADDLE_WITH_MKLML
+// OpenMP may give the region fewer threads than requested, all the chunks
+// should run anyway.
+TEST(CPUDeviceContext, ParallelForWithFewerThreads) {
+  CPUDeviceContext ctx;
+  SetIntraOpNumThreads(4);
+  ASSERT_EQ(ctx.ParallelForNumThreads(1000, 1), 4);
+  // No parallel region is active, so each one runs with a single thread.
+  int max_active_levels = omp_get_max_active_levels();
+  omp_set_max_active_levels(0);
+  for (int64_t size : {4, 5, 1000, 1001}) {
+    CheckParallelFor(ctx, size, 1);
+  }
+  omp_set_max_active_levels(max_active_levels);
+  SetIntraOpNumThreads(0);
+}
+#endif
+
+}  // namespace platform
+}  // namespace paddle
@@ -50,7 +50,9 @@ double Event::CudaElapsedMs(const Event &e) const {
 #endif
 }
 
-RecordEvent::RecordEvent(const std::string &name, const EventRole role) {
+RecordEvent::RecordEvent(const std::string &name, const EventRole role,
+                         const char *trace_category)
+    : trace_event_(name, trace_category) {
   if (g_state == ProfilerState::kDisabled || name.empty()) return;
 
   // do some initialization
@@ -78,6 +80,10 @@ RecordEvent::~RecordEvent() {
 
 void MemEvenRecorder::PushMemRecord(const void *ptr, const Place &place,
                                     size_t size) {
+  if (ChromeTracingRecorder::IsEnabled()) {
+    ChromeTracingRecorder::Instance().AddMemoryEvent(
+        place, static_cast<int64_t>(size));
+  }
   if (g_state == ProfilerState::kDisabled) return;
   std::lock_guard<std::mutex> guard(mtx_);
   auto &events = address_memevent_[place];
@@ -88,7 +94,12 @@ void MemEvenRecorder::PushMemRecord(const void *ptr, const Place &place,
                           new MemEvenRecorder::RecordMemEvent(place, size)));
 }
 
-void MemEvenRecorder::PopMemRecord(const void *ptr, const Place &place) {
+void MemEvenRecorder::PopMemRecord(const void *ptr, const Place &place,
+                                   size_t size) {
+  if (ChromeTracingRecorder::IsEnabled()) {
+    ChromeTracingRecorder::Instance().AddMemoryEvent(
+        place, -static_cast<int64_t>(size));
+  }
   if (g_state == ProfilerState::kDisabled) return;
   std::lock_guard<std::mutex> guard(mtx_);
   auto &events = address_memevent_[place];
@@ -127,7 +138,10 @@ MemEvenRecorder::RecordMemEvent::~RecordMemEvent() {
 
 RecordRPCEvent::RecordRPCEvent(const std::string &name) {
   if (FLAGS_enable_rpc_profiler) {
-    event_.reset(new platform::RecordEvent(name));
+    event_.reset(new platform::RecordEvent(name, EventRole::kOrdinary,
+                                           kTraceCategoryRPC));
+  } else {
+    trace_event_.reset(new RecordTraceEvent(name, kTraceCategoryRPC));
   }
 }
 
@@ -25,6 +25,7 @@ limitations under the License. */
 #include <vector>
 
 #include "paddle/fluid/framework/type_defs.h"
+#include "paddle/fluid/platform/chrome_tracing_recorder.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/event.h"
 #include "paddle/fluid/platform/place.h"
@@ -98,7 +99,7 @@ struct OverHead {
 struct MemEvenRecorder {
  public:
   void PushMemRecord(const void* ptr, const Place& place, size_t size);
-  void PopMemRecord(const void* ptr, const Place& place);
+  void PopMemRecord(const void* ptr, const Place& place, size_t size);
   void Flush();
   static MemEvenRecorder& Instance() { return recorder; }
 
@@ -126,7 +127,8 @@ struct MemEvenRecorder {
 
 struct RecordEvent {
   RecordEvent(const std::string& name,
-              const EventRole role = EventRole::kOrdinary);
+              const EventRole role = EventRole::kOrdinary,
+              const char* trace_category = kTraceCategoryOp);
 
   ~RecordEvent();
 
@@ -138,6 +140,9 @@ struct RecordEvent {
   // different kernel invocations within an op.
   std::string full_name_;
   EventRole role_{EventRole::kOrdinary};
+  // Also record the event in the Chrome trace timeline if it is enabled,
+  // no matter whether the profiler is enabled.
+  RecordTraceEvent trace_event_;
 };
 
 class RecordRPCEvent {
@@ -146,7 +151,9 @@ class RecordRPCEvent {
   ~RecordRPCEvent() {}
 
  private:
+  // Only one of them is set, so that the RPC is traced once
   std::unique_ptr<RecordEvent> event_;
+  std::unique_ptr<RecordTraceEvent> trace_event_;
 };
 
 struct RecordBlock {
@@ -104,6 +104,7 @@ using paddle::distributed::AsyncCommunicator;
 using paddle::distributed::GeoCommunicator;
 using paddle::distributed::RecvCtxMap;
 using paddle::distributed::RpcCtxMap;
+using paddle::distributed::SspCommunicator;
 using paddle::distributed::SyncCommunicator;
 using paddle::framework::Scope;
 
@@ -122,6 +123,9 @@ void BindDistCommunicator(py::module* m) {
         } else if (mode == "SYNC") {
           Communicator::InitInstance<SyncCommunicator>(
               send_ctx, recv_ctx, dist_desc, host_sign_list, param_scope, envs);
+        } else if (mode == "SSP") {
+          Communicator::InitInstance<SspCommunicator>(
+              send_ctx, recv_ctx, dist_desc, host_sign_list, param_scope, envs);
         } else if (mode == "GEO") {
           Communicator::InitInstance<GeoCommunicator>(
               send_ctx, recv_ctx, dist_desc, host_sign_list, param_scope, envs);
@@ -39,12 +39,16 @@ DECLARE_bool(cpu_deterministic);
 DECLARE_bool(enable_rpc_profiler);
 DECLARE_int32(multiple_of_cupti_buffer_size);
 DECLARE_bool(reader_queue_speed_test_mode);
+DECLARE_bool(reader_cpu_bind_numa);
 DECLARE_int32(call_stack_level);
 DECLARE_bool(sort_sum_gradient);
 // device management
 DECLARE_int32(paddle_num_threads);
+DECLARE_int32(intra_op_num_threads);
 // executor
 DECLARE_bool(enable_parallel_graph);
+DECLARE_bool(fast_executor_priority_scheduling);
+DECLARE_int32(fast_executor_inline_op_us);
 DECLARE_string(pe_profile_fname);
 DECLARE_string(print_sub_graph_dir);
 DECLARE_bool(use_ngraph);
@@ -65,6 +69,7 @@ DECLARE_bool(use_system_allocator);
 DECLARE_bool(benchmark);
 DECLARE_int32(inner_op_parallelism);
 DECLARE_int32(max_inplace_grad_add);
+DECLARE_int32(op_stat_sample_interval);
 DECLARE_string(tracer_profile_fname);
 #ifdef PADDLE_WITH_CUDA
 // cudnn
@@ -345,14 +350,17 @@ static void RegisterGlobalVarGetterSetter() {
       FLAGS_allocator_strategy, FLAGS_use_system_allocator, FLAGS_check_nan_inf,
       FLAGS_call_stack_level, FLAGS_sort_sum_gradient, FLAGS_cpu_deterministic,
       FLAGS_enable_rpc_profiler, FLAGS_multiple_of_cupti_buffer_size,
-      FLAGS_reader_queue_speed_test_mode, FLAGS_pe_profile_fname,
-      FLAGS_print_sub_graph_dir, FLAGS_fraction_of_cpu_memory_to_use,
-      FLAGS_fuse_parameter_groups_size, FLAGS_fuse_parameter_memory_size,
-      FLAGS_init_allocated_mem, FLAGS_initial_cpu_memory_in_mb,
-      FLAGS_memory_fraction_of_eager_deletion, FLAGS_use_pinned_memory,
-      FLAGS_benchmark, FLAGS_inner_op_parallelism, FLAGS_tracer_profile_fname,
-      FLAGS_paddle_num_threads, FLAGS_use_mkldnn, FLAGS_max_inplace_grad_add,
-      FLAGS_tracer_mkldnn_ops_on, FLAGS_tracer_mkldnn_ops_off);
+      FLAGS_reader_queue_speed_test_mode, FLAGS_reader_cpu_bind_numa,
+      FLAGS_pe_profile_fname, FLAGS_print_sub_graph_dir,
+      FLAGS_fraction_of_cpu_memory_to_use, FLAGS_fuse_parameter_groups_size,
+      FLAGS_fuse_parameter_memory_size, FLAGS_init_allocated_mem,
+      FLAGS_initial_cpu_memory_in_mb, FLAGS_memory_fraction_of_eager_deletion,
+      FLAGS_use_pinned_memory, FLAGS_benchmark, FLAGS_inner_op_parallelism,
+      FLAGS_tracer_profile_fname, FLAGS_paddle_num_threads, FLAGS_use_mkldnn,
+      FLAGS_max_inplace_grad_add, FLAGS_tracer_mkldnn_ops_on,
+      FLAGS_tracer_mkldnn_ops_off, FLAGS_op_stat_sample_interval,
+      FLAGS_fast_executor_priority_scheduling, FLAGS_fast_executor_inline_op_us,
+      FLAGS_intra_op_num_threads);
 
 #ifdef PADDLE_WITH_CUDA
   REGISTER_PUBLIC_GLOBAL_VAR(
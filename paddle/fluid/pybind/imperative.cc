@@ -32,6 +32,7 @@ limitations under the License. */
 #include "paddle/fluid/imperative/amp_auto_cast.h"
 #include "paddle/fluid/imperative/basic_engine.h"
 #include "paddle/fluid/imperative/data_loader.h"
+#include "paddle/fluid/imperative/jit/program_desc_replayer.h"
 #include "paddle/fluid/imperative/layer.h"
 #include "paddle/fluid/imperative/nccl_context.h"
 #include "paddle/fluid/imperative/partial_grad_engine.h"
@@ -1152,6 +1153,41 @@ void BindImperative(py::module *m_ptr) {
            &imperative::jit::ProgramDescTracer::CreateProgramDesc)
       .def("reset", &imperative::jit::ProgramDescTracer::Reset);
 
+  py::class_<imperative::jit::ProgramDescReplayer>(m, "ProgramDescReplayer",
+                                                   "")
+      .def(py::init<const framework::ProgramDesc &,
+                    const std::vector<std::string> &,
+                    const std::vector<std::string> &,
+                    const std::vector<std::shared_ptr<imperative::VarBase>> &,
+                    const platform::Place &,
+                    const std::vector<std::string> &, bool>(),
+           py::arg("program"), py::arg("feed_names"), py::arg("fetch_names"),
+           py::arg("parameters"), py::arg("place"),
+           py::arg("passes") = std::vector<std::string>(),
+           py::arg("enable_memory_reuse") = true)
+      .def("run",
+           [](imperative::jit::ProgramDescReplayer &self,
+              const std::vector<std::shared_ptr<imperative::VarBase>> &inputs)
+               -> py::object {
+             std::vector<std::shared_ptr<imperative::VarBase>> outputs;
+             bool replayed = false;
+             {
+               py::gil_scoped_release release;
+               replayed = self.Run(inputs, &outputs);
+             }
+             // Return None to notify the caller to fall back to eager mode
+             if (!replayed) return py::none();
+             return py::cast(outputs);
+           })
+      .def_property_readonly("replay_count",
+                             &imperative::jit::ProgramDescReplayer::ReplayCount)
+      .def_property_readonly(
+          "fallback_count",
+          &imperative::jit::ProgramDescReplayer::FallbackCount)
+      .def_property_readonly(
+          "reused_var_count",
+          &imperative::jit::ProgramDescReplayer::ReusedVarCount);
+
   py::class_<imperative::Tracer, std::shared_ptr<imperative::Tracer>>(
       m, "Tracer", R"DOC()DOC")
       .def("__init__",
@@ -468,6 +468,15 @@ void BindAnalysisConfig(py::module *m) {
            py::arg("x") = true)
       .def("ir_optim", &AnalysisConfig::ir_optim)
       .def("enable_memory_optim", &AnalysisConfig::EnableMemoryOptim)
+      .def("enable_embedding_quantization",
+           &AnalysisConfig::EnableEmbeddingQuantization)
+      .def("embedding_quantization_enabled",
+           &AnalysisConfig::embedding_quantization_enabled)
+      .def("enable_weight_prepacking", &AnalysisConfig::EnableWeightPrepacking)
+      .def("weight_prepacking_enabled",
+           &AnalysisConfig::weight_prepacking_enabled)
+      .def("enable_cpu_int8_gemm", &AnalysisConfig::EnableCpuInt8Gemm)
+      .def("cpu_int8_gemm_enabled", &AnalysisConfig::cpu_int8_gemm_enabled)
       .def("enable_profile", &AnalysisConfig::EnableProfile)
       .def("disable_glog_info", &AnalysisConfig::DisableGlogInfo)
       .def("glog_info_disabled", &AnalysisConfig::glog_info_disabled)
@@ -510,6 +519,10 @@ void BindAnalysisConfig(py::module *m) {
            &AnalysisConfig::SetCpuMathLibraryNumThreads)
       .def("cpu_math_library_num_threads",
            &AnalysisConfig::cpu_math_library_num_threads)
+      .def("set_cpu_intra_op_num_threads",
+           &AnalysisConfig::SetCpuIntraOpNumThreads)
+      .def("cpu_intra_op_num_threads",
+           &AnalysisConfig::cpu_intra_op_num_threads)
       .def("to_native_config", &AnalysisConfig::ToNativeConfig)
       .def("enable_quantizer", &AnalysisConfig::EnableMkldnnQuantizer)
       .def("enable_mkldnn_bfloat16", &AnalysisConfig::EnableMkldnnBfloat16)
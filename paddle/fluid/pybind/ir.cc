@@ -118,6 +118,8 @@ void BindGraph(py::module *m) {
       .def("release_nodes", &Graph::ReleaseNodes)
       .def("remove_node",
            [](Graph &self, Node &node) { return self.RemoveNode(&node); })
+      .def("update_op_node_index",
+           [](Graph &self, Node &node) { self.UpdateOpNodeIndex(&node); })
       .def("retrieve_node", &Graph::RetrieveNode,
            return_value_policy::reference)
       .def("resolve_hazard", &Graph::ResolveHazard)
@@ -63,6 +63,7 @@ limitations under the License. */
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/init.h"
 #include "paddle/fluid/platform/monitor.h"
+#include "paddle/fluid/platform/op_stat.h"
 #include "paddle/fluid/platform/place.h"
 #include "paddle/fluid/platform/profiler.h"
 #include "paddle/fluid/pybind/box_helper_py.h"
@@ -1751,6 +1752,21 @@ All parameter, weight, gradient are variables in Paddle.
     }
     return stats_map;
   });
+  m.def("get_op_stats", []() {
+    std::unordered_map<std::string, std::unordered_map<std::string, int64_t>>
+        stats_map;
+    auto &registry = paddle::platform::OpStatRegistry::Instance();
+    for (const auto &op_type : registry.OpTypes()) {
+      auto *stat = registry.Get(op_type);
+      auto &op_stats = stats_map[op_type];
+      op_stats["calls"] = stat->calls.get();
+      op_stats["time_ns"] = stat->time_ns.get();
+      op_stats["alloc_bytes"] = stat->alloc_bytes.get();
+    }
+    return stats_map;
+  });
+  m.def("reset_op_stats",
+        []() { paddle::platform::OpStatRegistry::Instance().Reset(); });
   m.def("run_cmd",
         [](const std::string &cmd, int time_out = -1,
            int sleep_inter = -1) -> const std::string {
@@ -1978,6 +1994,11 @@ All parameter, weight, gradient are variables in Paddle.
   m.def("disable_profiler", platform::DisableProfiler);
   m.def("is_profiler_enabled", platform::IsProfileEnabled);
   m.def("reset_profiler", platform::ResetProfiler);
+  m.def("enable_chrome_tracing", platform::EnableChromeTracing,
+        py::arg("buffer_size_per_thread") = 100000,
+        py::arg("sample_interval") = 1);
+  m.def("disable_chrome_tracing", platform::DisableChromeTracing);
+  m.def("export_chrome_tracing", platform::ExportChromeTracing);
   m.def("get_pass", [](const std::string &pass_type) {
     auto pass = framework::ir::PassRegistry::Instance().Get(pass_type);
     return std::shared_ptr<framework::ir::Pass>(std::move(pass));
@@ -292,6 +292,14 @@ class DistributedStrategy(object):
 
             runtime_split_send_recv(bool): if we are using Tensor split for send and recv during runtime
 
+            sparse_table_entry(str): admission of the new keys of the sparse tables on the parameter servers, "none", "count_filter&<threshold>" or "probability&<p>"
+
+            sparse_table_eviction(str): eviction of the rows of the sparse tables on the parameter servers, "none" or "<lfu|lru>&<memory_mb>&<ttl_days>"
+
+            sparse_table_ssd_path(str): directory on the local disk of the parameter servers for the rows evicted from the memory, which requires the memory_mb of sparse_table_eviction
+
+            ssp_staleness(int): steps a trainer can run ahead of the slowest trainer in the stale synchronous parallel mode, which requires a_sync and k_steps of 0, or -1 for the async mode
+
         Examples:
 
           .. code-block:: python
@@ -47,8 +47,18 @@ class ParameterServerOptimizer(MetaOptimizerBase):
         if not self.user_defined_strategy.a_sync and k_steps == 0:
             strategy = StrategyFactory.create_sync_strategy()
 
+        ssp_staleness = self.user_defined_strategy.a_sync_configs[
+            "ssp_staleness"]
+        if ssp_staleness >= 0 and not (self.user_defined_strategy.a_sync and
+                                       k_steps == 0):
+            raise ValueError(
+                "ssp_staleness requires a_sync and k_steps of 0, please check")
+
         if self.user_defined_strategy.a_sync and k_steps == 0:
-            strategy = StrategyFactory.create_async_strategy()
+            if ssp_staleness >= 0:
+                strategy = StrategyFactory.create_ssp_strategy()
+            else:
+                strategy = StrategyFactory.create_async_strategy()
 
         if self.user_defined_strategy.a_sync and k_steps > 0:
             strategy = StrategyFactory.create_geo_strategy(k_steps)
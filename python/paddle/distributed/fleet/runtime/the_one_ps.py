@@ -60,6 +60,10 @@ class CommonAccessor:
         self.dims = []
         self.trainer_num = 0
         self.sync = "false"
+        self.entry = "none"
+        self.eviction = "none"
+        self.ssd_path = ""
+        self.ssp_staleness = -1
         self.initializers = []
         self.opt_input_map = {}
         self.opt_attr_map = {}
@@ -73,12 +77,19 @@ class CommonAccessor:
                                  ("Moment2", None), ("Beta1Pow", 1),
                                  ("Beta2Pow", 1), ("LearningRate", 1)]
         opt_input_map["sum"] = [("Param", None)]
+        opt_input_map["adagrad"] = [("Param", None), ("Moment", None),
+                                    ("LearningRate", 1)]
+        opt_input_map["ftrl"] = [("Param", None), ("SquaredAccumulator", None),
+                                 ("LinearAccumulator", None),
+                                 ("LearningRate", 1)]
 
         opt_attr_map = {}
         opt_attr_map["sgd"] = []
         opt_attr_map["sum"] = []
         opt_attr_map["adam"] = [("beta1", "f"), ("beta2", "f"),
                                 ("epsilon", "f")]
+        opt_attr_map["adagrad"] = [("epsilon", "f")]
+        opt_attr_map["ftrl"] = [("l1", "f"), ("l2", "f"), ("lr_power", "f")]
 
         opt_init_map = {}
         opt_init_map["gaussian_random"] = ["seed", "mean", "std"]
@@ -147,6 +158,9 @@ class CommonAccessor:
             attr_varnames = self.opt_attr_map["sum"]
             self.accessor_class = "sum"
         else:
+            if not is_sparse and oop.type in ["adagrad", "ftrl"]:
+                raise ValueError("{} is only supported for the sparse params".
+                                 format(oop.type))
             param_varnames = self.opt_input_map[oop.type]
             attr_varnames = self.opt_attr_map[oop.type]
             self.accessor_class = oop.type
@@ -191,6 +205,10 @@ class CommonAccessor:
 
         attrs += "trainer_num: {} ".format(self.trainer_num)
         attrs += "sync: {} ".format(self.sync)
+        attrs += "entry: \"{}\" ".format(self.entry)
+        attrs += "eviction: \"{}\" ".format(self.eviction)
+        attrs += "ssd_path: \"{}\" ".format(self.ssd_path)
+        attrs += "ssp_staleness: {} ".format(self.ssp_staleness)
 
         for param in self.params:
             attrs += "params: \"{}\" ".format(param)
@@ -201,6 +219,9 @@ class CommonAccessor:
         for initializer in self.initializers:
             attrs += "initializers: \"{}\" ".format(initializer)
 
+        for attr in self.attrs:
+            attrs += "attributes: \"{}\" ".format(attr)
+
         attrs += "\n"
         return accessor_str.format(
             conv_indent(indent), attrs, conv_indent(indent))
@@ -377,8 +398,16 @@ class TheOnePSRuntime(RuntimeBase):
         if not dist_strategy.a_sync and k_steps == 0:
             strategy = StrategyFactory.create_sync_strategy()
 
+        ssp_staleness = dist_strategy.a_sync_configs["ssp_staleness"]
+        if ssp_staleness >= 0 and not (dist_strategy.a_sync and k_steps == 0):
+            raise ValueError(
+                "ssp_staleness requires a_sync and k_steps of 0, please check")
+
         if dist_strategy.a_sync and k_steps == 0:
-            strategy = StrategyFactory.create_async_strategy()
+            if ssp_staleness >= 0:
+                strategy = StrategyFactory.create_ssp_strategy()
+            else:
+                strategy = StrategyFactory.create_async_strategy()
 
         if dist_strategy.a_sync and k_steps > 0:
             strategy = StrategyFactory.create_geo_strategy(k_steps)
@@ -528,6 +557,10 @@ class TheOnePSRuntime(RuntimeBase):
         return executor
 
     def _get_fleet_proto(self, is_server, is_sync):
+        from paddle.fluid.incubate.fleet.parameter_server.mode import DistributedMode
+        is_ssp = self.compiled_strategy.get_distributed_mode(
+        ) == DistributedMode.SSP
+
         def _build_merge_accessor(ctx):
             accessor = Accessor()
             accessor.accessor_class = "CommMergeAccessor"
@@ -615,6 +648,15 @@ class TheOnePSRuntime(RuntimeBase):
                 else:
                     common.sync = "false"
 
+                a_sync_configs = self.context["valid_strategy"].a_sync_configs
+                if is_ssp:
+                    common.ssp_staleness = a_sync_configs["ssp_staleness"]
+
+                if ctx.is_sparse():
+                    common.entry = a_sync_configs["sparse_table_entry"]
+                    common.eviction = a_sync_configs["sparse_table_eviction"]
+                    common.ssd_path = a_sync_configs["sparse_table_ssd_path"]
+
                 table.common = common
 
                 accessor = _build_merge_accessor(ctx)
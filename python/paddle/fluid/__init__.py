@@ -191,6 +191,7 @@ def __bootstrap__():
         'print_sub_graph_dir',
         'pe_profile_fname',
         'inner_op_parallelism',
+        'intra_op_num_threads',
         'enable_parallel_graph',
         'fuse_parameter_groups_size',
         'multiple_of_cupti_buffer_size',
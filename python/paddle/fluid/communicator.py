@@ -80,6 +80,8 @@ class Communicator(object):
             mode_str = "HALF_ASYNC"
         elif mode == DistributedMode.GEO:
             mode_str = "GEO"
+        elif mode == DistributedMode.SSP:
+            mode_str = "SSP"
 
         self.mode = mode_str
         self.envs = envs
@@ -1327,3 +1327,98 @@ class TracedLayer(object):
                 target_vars=target_vars,
                 executor=self._exe,
                 main_program=self._program.clone())
+
+
+class ReplayedStep(object):
+    """
+    :api_attr: imperative
+
+    ReplayedStep captures one call of a dygraph step function, including the
+    backward run by :code:`loss.backward()` inside the function, and replays
+    the captured program in C++ in the following calls without running the
+    Python code of the function again. The grads of the parameters are
+    accumulated into their grad vars like the eager backward does, so the
+    optimizer is called outside the function as usual.
+
+    The captured program is only valid for the shapes and data types of the
+    inputs it is captured with. The function runs eagerly again when they
+    change. The function should not update the parameters, and the outputs
+    returned by a replayed call do not require grad.
+
+    Args:
+        function (callable): the step function, which takes Tensors as inputs
+            and returns a Tensor or a list of Tensors.
+        passes (list(str), optional): the IR passes applied on the captured
+            program. Default None.
+        enable_memory_reuse (bool, optional): whether the vars of the captured
+            program reuse the memory of the vars which are no longer used.
+            Default True.
+
+    Examples:
+        .. code-block:: python:
+
+            import paddle
+            from paddle.fluid.dygraph.jit import ReplayedStep
+
+            linear = paddle.nn.Linear(3, 10)
+            sgd = paddle.optimizer.SGD(parameters=linear.parameters())
+
+            def train_step(x):
+                loss = paddle.mean(linear(x))
+                loss.backward()
+                return loss
+
+            step = ReplayedStep(train_step)
+            for i in range(10):
+                x = paddle.uniform(shape=[2, 3], dtype='float32')
+                loss = step(x)
+                sgd.step()
+                sgd.clear_grad()
+    """
+
+    def __init__(self, function, passes=None, enable_memory_reuse=True):
+        self._function = function
+        self._passes = passes if passes is not None else []
+        self._enable_memory_reuse = enable_memory_reuse
+        self._replayer = None
+        self._is_list_output = False
+
+    @property
+    def replay_count(self):
+        return self._replayer.replay_count if self._replayer else 0
+
+    @property
+    def fallback_count(self):
+        return self._replayer.fallback_count if self._replayer else 0
+
+    @dygraph_only
+    def __call__(self, *inputs):
+        if self._replayer is None:
+            return self._capture(inputs)
+
+        outputs = self._replayer.run(extract_vars(list(inputs)))
+        if outputs is None:
+            return self._function(*inputs)
+        return outputs if self._is_list_output else outputs[0]
+
+    def _capture(self, inputs):
+        tracer = _dygraph_tracer()._get_program_desc_tracer()
+        var_list = extract_vars(list(inputs))
+
+        with program_desc_tracing_guard(True):
+            original_outputs = self._function(*inputs)
+            self._is_list_output = isinstance(original_outputs, (list, tuple))
+            if self._is_list_output:
+                outputs = list(original_outputs)
+            else:
+                outputs = [original_outputs]
+
+            program_desc, feed_names, fetch_names, parameters = tracer.create_program_desc(
+                var_list, 'feed_', outputs, 'fetch_', 't_')
+            tracer.reset()
+
+        self._replayer = core.ProgramDescReplayer(
+            program_desc, feed_names, fetch_names, parameters,
+            _current_expected_place(), self._passes,
+            self._enable_memory_reuse)
+        return original_outputs
@@ -3239,16 +3239,18 @@ class IrNode(object):
     Python IrNode. Beneath it is a core.Node, which is used for Ir Pass.
     """
 
-    def __init__(self, node):
+    def __init__(self, node, graph=None):
         """
         Construct an IrNode using core.Node.
 
         Args:
             node(core.Node): C++ Node.
+            graph(core.Graph): the C++ Graph of the node, or None if unknown.
         """
         assert isinstance(node,
                           core.Node), 'node must be the instance of core.Node.'
         self.node = node
+        self._graph = graph
 
     def name(self):
         """
@@ -3398,7 +3400,7 @@ class IrNode(object):
         Returns:
             list(IrNode): node inputs wrapped by IrNode.
         """
-        return [IrNode(n) for n in self.node.inputs]
+        return [IrNode(n, self._graph) for n in self.node.inputs]
 
     @property
     def outputs(self):
@@ -3408,7 +3410,7 @@ class IrNode(object):
         Returns:
             list(IrNode): node outputs wrapped by IrNode.
         """
-        return [IrNode(n) for n in self.node.outputs]
+        return [IrNode(n, self._graph) for n in self.node.outputs]
 
 
 class IrVarNode(IrNode):
@@ -3416,16 +3418,17 @@ class IrVarNode(IrNode):
     Python IrVarNode. Beneath it is a core.Node, it inherits from IrNode.
     """
 
-    def __init__(self, node):
+    def __init__(self, node, graph=None):
         """
         Construct an IrVarNode using core.Node.
 
         Args:
             node(core.Node): C++ Node.
+            graph(core.Graph): the C++ Graph of the node, or None if unknown.
         """
         assert isinstance(node, core.Node) and node.is_var(), \
             'node must be the instance of core.Node and it must be a variable node.'
-        super(IrVarNode, self).__init__(node)
+        super(IrVarNode, self).__init__(node, graph)
         self.node = node
 
     def set_shape(self, shape):
@@ -3491,7 +3494,7 @@ class IrVarNode(IrNode):
         Returns:
             list(IrOpNode): node inputs wrapped by IrOpNode.
         """
-        return [IrOpNode(n) for n in self.node.inputs]
+        return [IrOpNode(n, self._graph) for n in self.node.inputs]
 
     @property
     def outputs(self):
@@ -3501,7 +3504,7 @@ class IrVarNode(IrNode):
         Returns:
             list(IrOpNode): node outputs wrapped by IrOpNode.
         """
-        return [IrOpNode(n) for n in self.node.outputs]
+        return [IrOpNode(n, self._graph) for n in self.node.outputs]
 
 
 class IrOpNode(IrNode):
@@ -3509,16 +3512,17 @@ class IrOpNode(IrNode):
     Python IrOpNode. Beneath it is a core.Node, it inherits from IrNode.
     """
 
-    def __init__(self, node):
+    def __init__(self, node, graph=None):
         """
         Construct an IrOpNode using core.Node.
 
         Args:
             node(core.Node): C++ Node.
+            graph(core.Graph): the C++ Graph of the node, or None if unknown.
         """
         assert isinstance(node, core.Node) and node.is_op(), \
             'node must be the instance of core.Node and it must be a operator node.'
-        super(IrOpNode, self).__init__(node)
+        super(IrOpNode, self).__init__(node, graph)
         self.node = node
 
     def rename_input(self, old_input_name, new_input_name):
@@ -3582,7 +3586,10 @@ class IrOpNode(IrNode):
         """
         assert self.node.op() is not None, \
             "The node operator description can not be None."
-        return self.node.op().set_type(new_type)
+        self.node.op().set_type(new_type)
+        # The graph indexes its op nodes by type for the pattern detection.
+        if self._graph is not None:
+            self._graph.update_op_node_index(self.node)
 
     def set_attr(self, name, val):
         """
@@ -3642,7 +3649,7 @@ class IrOpNode(IrNode):
         Returns:
             list(IrVarNode): node inputs wrapped by IrVarNode.
         """
-        return [IrVarNode(n) for n in self.node.inputs]
+        return [IrVarNode(n, self._graph) for n in self.node.inputs]
 
     @property
     def outputs(self):
@@ -3652,7 +3659,7 @@ class IrOpNode(IrNode):
         Returns:
             list(IrVarNode): node outputs wrapped by IrVarNode.
         """
-        return [IrVarNode(n) for n in self.node.outputs]
+        return [IrVarNode(n, self._graph) for n in self.node.outputs]
 
 
 class IrGraph(object):
@@ -3699,13 +3706,16 @@ class IrGraph(object):
         """
         Return all nodes included in the graph as a set.
         """
-        return {IrNode(node) for node in self.graph.nodes()}
+        return {IrNode(node, self.graph) for node in self.graph.nodes()}
 
     def all_var_nodes(self):
         """
         Return all variable nodes included in the graph as a set.
         """
-        return {IrVarNode(node) for node in self.graph.nodes() if node.is_var()}
+        return {
+            IrVarNode(node, self.graph)
+            for node in self.graph.nodes() if node.is_var()
+        }
 
     def all_persistable_nodes(self):
         """
@@ -3716,13 +3726,16 @@ class IrGraph(object):
             if node.is_var() and node.var() is not None and node.var(
             ).persistable():
                 persistable_nodes.add(node)
-        return {IrVarNode(p) for p in persistable_nodes}
+        return {IrVarNode(p, self.graph) for p in persistable_nodes}
 
     def all_op_nodes(self):
         """
         Return all operator nodes included in the graph as a set.
         """
-        return {IrOpNode(node) for node in self.graph.nodes() if node.is_op()}
+        return {
+            IrOpNode(node, self.graph)
+            for node in self.graph.nodes() if node.is_op()
+        }
 
     def create_persistable_node(self, name, var_type, shape, var_dtype):
         """
@@ -3743,7 +3756,7 @@ class IrGraph(object):
         var_desc.set_shape(shape)
         var_desc.set_dtype(var_dtype)
         var_desc.set_persistable(True)
-        return IrVarNode(self.graph.create_var_node(var_desc))
+        return IrVarNode(self.graph.create_var_node(var_desc), self.graph)
 
     def create_var_node(self, name, var_type, shape, var_dtype):
         """
@@ -3764,13 +3777,13 @@ class IrGraph(object):
         var_desc.set_type(var_type)
         var_desc.set_shape(shape)
         var_desc.set_dtype(var_dtype)
-        return IrVarNode(self.graph.create_var_node(var_desc))
+        return IrVarNode(self.graph.create_var_node(var_desc), self.graph)
 
     def create_control_dep_var(self):
         """
         create a control var
         """
-        return IrVarNode(self.graph.create_control_dep_var())
+        return IrVarNode(self.graph.create_control_dep_var(), self.graph)
 
     def create_var_node_from_desc(self, var_desc):
         """
@@ -3783,7 +3796,7 @@ class IrGraph(object):
         Returns:
             IrVarNode: the created variable node.
         """
-        return IrVarNode(self.graph.create_var_node(var_desc))
+        return IrVarNode(self.graph.create_var_node(var_desc), self.graph)
 
     def create_op_node(self, op_type, attrs, inputs, outputs):
         """
@@ -3812,7 +3825,7 @@ class IrGraph(object):
                 var_nodes = [var_nodes]
             op_desc.set_output(output_name,
                                [var_node.name() for var_node in var_nodes])
-        return IrOpNode(self.graph.create_op_node(op_desc))
+        return IrOpNode(self.graph.create_op_node(op_desc), self.graph)
 
     def create_op_node_from_desc(self, op_desc):
         """
@@ -3824,7 +3837,7 @@ class IrGraph(object):
         Returns:
             IrOpNode: the created operator node.
         """
-        return IrOpNode(self.graph.create_op_node(op_desc))
+        return IrOpNode(self.graph.create_op_node(op_desc), self.graph)
 
     def update_input_link(self, old_input_node, new_input_node, op_node):
         """
@@ -3940,7 +3953,7 @@ class IrGraph(object):
             list(IrNode): nodes in topology order.
         """
         ordered_nodes = core.topology_sort(self.graph)
-        return [IrNode(n) for n in ordered_nodes]
+        return [IrNode(n, self.graph) for n in ordered_nodes]
 
     def build_adjacency_list(self):
         """
@@ -3952,7 +3965,10 @@ class IrGraph(object):
         adj_list = core.build_adjacency_list(self.graph)
         wrapped_adj_list = dict()
         for k, v in six.iteritems(adj_list):
-            wrapped_adj_list[IrNode(k)] = {IrNode(n) for n in v}
+            wrapped_adj_list[IrNode(k, self.graph)] = {
+                IrNode(n, self.graph)
+                for n in v
+            }
         return wrapped_adj_list
 
     def draw(self, save_path, name, marked_nodes=None, remove_ctr_var=True):
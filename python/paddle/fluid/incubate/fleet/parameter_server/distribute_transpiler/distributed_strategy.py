@@ -59,8 +59,11 @@ class TrainerRuntimeConfig(object):
         if self.mode is None or self.mode == DistributedMode.ASYNC:
             need_keys = self.runtime_configs.keys()
             mode_str = "async"
-        elif self.mode == DistributedMode.SYNC or self.mode == DistributedMode.HALF_ASYNC:
-            mode_str = "sync or half_async"
+        elif self.mode in [
+                DistributedMode.SYNC, DistributedMode.HALF_ASYNC,
+                DistributedMode.SSP
+        ]:
+            mode_str = "sync, half_async or ssp"
             need_keys = [
                 'communicator_max_merge_var_num',
                 'communicator_send_wait_times', 'communicator_thread_pool_size',
@@ -75,7 +78,10 @@ class TrainerRuntimeConfig(object):
         else:
             raise ValueError("Unsupported Mode")
 
-        if self.mode == DistributedMode.SYNC or self.mode == DistributedMode.HALF_ASYNC:
+        if self.mode in [
+                DistributedMode.SYNC, DistributedMode.HALF_ASYNC,
+                DistributedMode.SSP
+        ]:
             max_merge_var_num = self.runtime_configs[
                 'communicator_max_merge_var_num']
             send_queue_size = self.runtime_configs[
@@ -374,6 +380,18 @@ class HalfAsyncStrategy(DistributedStrategy):
         self._build_strategy.async_mode = True
 
 
+class SspStrategy(HalfAsyncStrategy):
+    """
+    The stale synchronous parallel mode, which runs the trainer program of
+    the half async mode, but the pulls of a trainer only wait while it is more
+    than ssp_staleness steps ahead of the slowest trainer, instead of a global
+    barrier every step.
+    """
+
+    def check_trainer_runtime_config(self):
+        self._trainer_runtime_config.mode = DistributedMode.SSP
+
+
 class GeoStrategy(DistributedStrategy):
     def __init__(self, update_frequency=100):
         super(GeoStrategy, self).__init__()
@@ -424,6 +442,10 @@ class StrategyFactory(object):
     def create_async_strategy():
         return AsyncStrategy()
 
+    @staticmethod
+    def create_ssp_strategy():
+        return SspStrategy()
+
     @staticmethod
     def create_geo_strategy(update_frequency=100):
         return GeoStrategy(update_frequency)
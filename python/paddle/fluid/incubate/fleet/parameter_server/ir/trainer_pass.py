@@ -96,7 +96,30 @@ def distributed_ops_pass(program, config):
                 pull_sparse_ops[param_name] = ops
         return pull_sparse_ops
 
+    def _get_insert_idx(_program, inputs, outputs):
+        # The index after the last op writing the inputs, if it is before the
+        # first op reading the outputs, or -1.
+        inputs_idxs = [-1] * len(inputs)
+        outputs_idxs = [-1] * len(outputs)
+
+        for idx, op in enumerate(_program.global_block().ops):
+            for i in range(0, len(op.output_names)):
+                outs = op.output(op.output_names[i])
+                for in_id, in_var in enumerate(inputs):
+                    if in_var.name in outs:
+                        inputs_idxs[in_id] = idx
+            for i in range(0, len(op.input_names)):
+                ins = op.input(op.input_names[i])
+                for out_id, out_var in enumerate(outputs):
+                    if out_var.name in ins:
+                        outputs_idxs[out_id] = idx
+
+        if min(outputs_idxs) - max(inputs_idxs) >= 1:
+            return max(inputs_idxs) + 1
+        return -1
+
     def _pull_sparse_fuse(_program, pull_sparse_ops):
+        lookups = []
         for param, ops in pull_sparse_ops.items():
             all_ops = program.global_block().ops
             op_idxs = [all_ops.index(op) for op in ops]
@@ -117,10 +140,6 @@ def distributed_ops_pass(program, config):
                 raise ValueError(
                     "can not find suitable sparse table, please check")
 
-            padding_idx = ops[0].attr("padding_idx")
-            is_distributed = ops[0].attr("is_distributed")
-            op_type = ops[0].type
-
             outputs = [
                 program.global_block().vars[op.output("Out")[0]] for op in ops
             ]
@@ -128,39 +147,73 @@ def distributed_ops_pass(program, config):
             for idx in op_idxs[::-1]:
                 program.global_block()._remove_op(idx)
 
-            inputs_idxs = [-1] * len(inputs)
-            outputs_idxs = [-1] * len(outputs)
-
-            for idx, op in enumerate(program.global_block().ops):
-                for i in range(0, len(op.output_names)):
-                    outs = op.output(op.output_names[i])
-                    for in_id, in_var in enumerate(inputs):
-                        if in_var.name in outs:
-                            inputs_idxs[in_id] = idx
-                for i in range(0, len(op.input_names)):
-                    ins = op.input(op.input_names[i])
-                    for out_id, out_var in enumerate(outputs):
-                        if out_var.name in ins:
-                            outputs_idxs[out_id] = idx
+            lookups.append({
+                "inputs": inputs,
+                "w": w,
+                "outputs": outputs,
+                "table_id": table_id,
+                "padding_idx": ops[0].attr("padding_idx"),
+                "is_distributed": ops[0].attr("is_distributed"),
+                "op_type": ops[0].type
+            })
 
-            if min(outputs_idxs) - max(inputs_idxs) >= 1:
-                distributed_idx = max(inputs_idxs) + 1
+        # The tables looked up by the same op type are pulled by one
+        # distributed_lookup_multi_table op, with a request per pserver instead
+        # of one per table and pserver, if it can run before all the outputs
+        # are used. Otherwise each table is pulled by its own op.
+        lookups_by_type = collections.OrderedDict()
+        for lookup in lookups:
+            lookups_by_type.setdefault(lookup["op_type"], []).append(lookup)
+
+        for op_type, type_lookups in lookups_by_type.items():
+            if len(type_lookups) > 1:
+                inputs = [
+                    var for lookup in type_lookups for var in lookup["inputs"]
+                ]
+                outputs = [
+                    var for lookup in type_lookups for var in lookup["outputs"]
+                ]
+                distributed_idx = _get_insert_idx(program, inputs, outputs)
+                if distributed_idx >= 0:
+                    program.global_block()._insert_op(
+                        index=distributed_idx,
+                        type="distributed_lookup_multi_table",
+                        inputs={
+                            "Ids": inputs,
+                            "W": [lookup["w"] for lookup in type_lookups]
+                        },
+                        outputs={"Outputs": outputs},
+                        attrs={
+                            "table_ids":
+                            [lookup["table_id"] for lookup in type_lookups],
+                            "ids_nums":
+                            [len(lookup["inputs"]) for lookup in type_lookups],
+                            "padding_idxs":
+                            [lookup["padding_idx"] for lookup in type_lookups],
+                            "lookup_table_version": op_type
+                        })
+                    continue
+
+            for lookup in type_lookups:
+                distributed_idx = _get_insert_idx(program, lookup["inputs"],
+                                                  lookup["outputs"])
+                if distributed_idx < 0:
+                    raise ValueError(
+                        "something wrong with Fleet, submit a issue is recommended"
+                    )
 
                 program.global_block()._insert_op(
                     index=distributed_idx,
                     type="distributed_lookup_table",
-                    inputs={"Ids": inputs,
-                            'W': w},
-                    outputs={"Outputs": outputs},
+                    inputs={"Ids": lookup["inputs"],
+                            'W': lookup["w"]},
+                    outputs={"Outputs": lookup["outputs"]},
                     attrs={
-                        "is_distributed": is_distributed,
-                        "padding_idx": padding_idx,
-                        "table_id": table_id,
+                        "is_distributed": lookup["is_distributed"],
+                        "padding_idx": lookup["padding_idx"],
+                        "table_id": lookup["table_id"],
                         "lookup_table_version": op_type
                     })
-            else:
-                raise ValueError(
-                    "something wrong with Fleet, submit a issue is recommended")
 
     pull_sparse_ops = _get_pull_sparse_ops(program)
     _pull_sparse_fuse(program, pull_sparse_ops)
@@ -182,7 +235,10 @@ def append_send_ops_pass(program, config):
             ]
 
         dummy_output = []
-        if mode in [DistributedMode.SYNC, DistributedMode.HALF_ASYNC]:
+        if mode in [
+                DistributedMode.SYNC, DistributedMode.HALF_ASYNC,
+                DistributedMode.SSP
+        ]:
             dummy_output = program.global_block().create_var(
                 name=framework.generate_control_dev_var_name())
 
@@ -222,7 +278,10 @@ def append_send_ops_pass(program, config):
             _append_send_op(send.origin_varnames(), merged_name, is_sparse,
                             send.table_id()))
 
-    if mode in [DistributedMode.SYNC, DistributedMode.HALF_ASYNC]:
+    if mode in [
+            DistributedMode.SYNC, DistributedMode.HALF_ASYNC,
+            DistributedMode.SSP
+    ]:
         _append_barrier_op(dummys)
 
     return program
@@ -583,6 +642,28 @@ def replace_ops_by_communicate_op(program, config, heter_block_index, ops_list,
             RPC_OP_ROLE_ATTR_NAME: RPC_OP_ROLE_ATTR_VALUE
         })
 
+    # send_and_recv returns without waiting for the heter worker, wait for it
+    # before the first op reading the exit vars or writing the entrance vars
+    all_op = program.global_block().ops
+    wait_op_idx = len(all_op)
+    for idx in range(first_op_idx + 1, len(all_op)):
+        op = all_op[idx]
+        if set(op.input_arg_names) & set(exit_var) or \
+                set(op.output_arg_names) & set(entrance_var):
+            wait_op_idx = idx
+            break
+    program.global_block()._insert_op(
+        index=wait_op_idx,
+        type="send_and_recv_wait",
+        inputs={},
+        outputs={"Out": [program.global_block().vars[x] for x in exit_var]},
+        attrs={
+            "message_name": comm_info["block_input_var_name"],
+            "endpoints": heter_worker_endpoint,
+            "trainer_id": config.get_role_id(),
+            RPC_OP_ROLE_ATTR_NAME: RPC_OP_ROLE_ATTR_VALUE
+        })
+
     return entrance_var + exit_var
 
 
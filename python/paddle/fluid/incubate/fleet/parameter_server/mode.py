@@ -26,3 +26,4 @@ class DistributedMode:
     ASYNC = 1
     HALF_ASYNC = 2
     GEO = 3
+    SSP = 4
@@ -17,6 +17,7 @@ import paddle.fluid as fluid
 from paddle.fluid.transpiler.distribute_transpiler import DistributeTranspilerConfig, ServerRuntimeConfig
 from paddle.fluid.incubate.fleet.parameter_server.distribute_transpiler.distributed_strategy import StrategyFactory
 from paddle.fluid.incubate.fleet.parameter_server.distribute_transpiler import fleet
+from paddle.fluid.incubate.fleet.parameter_server.mode import DistributedMode
 import paddle.fluid.incubate.fleet.base.role_maker as role_maker
 import os
 
@@ -191,6 +192,20 @@ class TestStrategyFactor(unittest.TestCase):
                          runtime_configs)
         self.assertEqual(runtime_configs['communicator_send_queue_size'], '100')
 
+    def test_ssp_strategy(self):
+        strategy = StrategyFactory.create_ssp_strategy()
+        self.assertEqual(strategy._program_config.sync_mode, False)
+        self.assertEqual(strategy._program_config.half_async, True)
+        self.assertEqual(strategy._execute_strategy.use_thread_barrier, True)
+
+        os.environ["CPU_NUM"] = '100'
+        trainer_runtime_config = strategy.get_trainer_runtime_config()
+        self.assertEqual(trainer_runtime_config.mode, DistributedMode.SSP)
+        runtime_configs = trainer_runtime_config.get_communicator_flags()
+        self.assertIn('communicator_send_queue_size', runtime_configs)
+        self.assertNotIn('communicator_independent_recv_thread',
+                         runtime_configs)
+
 
 class TestCreateDefaultStrategy(unittest.TestCase):
     def test_default_strategy(self):